@@ -605,6 +605,14 @@ private:
     // Wrappers for parts of AppMain() called with or without try/catch
     // depending on settings.
     void x_TryInit(EAppDiagStream diag, const char* conf);
+
+    // Load configuration from the compiled registry snapshot named by
+    // NCBI_CONFIG_SNAPSHOT; (re)compile the snapshot if it's stale.
+    // Used by LoadConfig() for the application registry.
+    bool x_LoadConfigSnapshot(const string&         conf,
+                              CNcbiRegistry::TFlags reg_flags);
+    void x_WriteConfigSnapshot(const string&         conf,
+                               CNcbiRegistry::TFlags reg_flags);
     void x_TryMain(EAppDiagStream diag,
                    const char*    conf,
                    int*           exit_code,
@@ -1606,6 +1606,24 @@ struct NCBI_XNCBI_EXPORT SDiagMessage {
     static void ParseDiagStream(CNcbiIstream& in,
                                 INextDiagMessage& func);
 
+    /// Append the message to the buffer in the binary applog format.
+    /// Each record is prefixed with its length and stores all fields
+    /// (time, PID/TID, request id, extra arguments etc.) in binary form,
+    /// so no text formatting is done.
+    /// @sa CBinaryDiagHandler, ParseBinary, ParseBinaryStream
+    void WriteBinary(string& buf) const;
+
+    /// Parse a single binary record (without the length prefix).
+    /// Return true on success, false if the record is malformed.
+    /// Writing the parsed message produces the standard text format.
+    bool ParseBinary(const char* data, size_t len);
+
+    /// Binary stream parser. Reads records written by WriteBinary() and
+    /// calls the callback for each message. Parsing stops at a truncated
+    /// record or at a record longer than 16MB (corrupt length prefix).
+    static void ParseBinaryStream(CNcbiIstream& in,
+                                  INextDiagMessage& func);
+
     /// Type of event to report
     enum EEventType {
         eEvent_Start,        ///< Application start
@@ -1711,6 +1729,8 @@ private:
         eFormat_Auto  // Get post format from CDiagContext, default
     };
     void x_SetFormat(EFormatFlag fmt) const { m_Format = fmt; }
+    // Reset all fields before parsing.
+    void x_ResetFields(void);
     bool x_IsSetOldFormat(void) const;
     friend class CDiagContext;
 
@@ -1785,6 +1805,7 @@ enum EPostNumberIncrement {
 
 
 struct SRequestCtxWrapper;
+struct SDiagAsyncRing;
 class CRequestContext;
 class CSharedHitId;
 class CRequestRateControl;
@@ -1853,6 +1874,8 @@ private:
     CDiagContextThreadData(const CDiagContextThreadData&);
     CDiagContextThreadData& operator=(const CDiagContextThreadData&);
 
+    friend class CAsyncDiagThread;
+
     // Guards override the global post level and define severity
     // for collecting messages.
     typedef list<CDiagCollectGuard*> TCollectGuards;
@@ -1869,6 +1892,7 @@ private:
     size_t                m_DiagCollectionSize; // cached size of m_DiagCollection
     unique_ptr<SRequestCtxWrapper> m_RequestCtx;        // Request context
     unique_ptr<SRequestCtxWrapper> m_DefaultRequestCtx; // Default request context
+    SDiagAsyncRing*       m_AsyncRing;        // Per-thread async diag buffer
 };
 
 
@@ -1957,6 +1981,7 @@ private:
     CDiagContext_Extra& PrintNcbiAppInfoOnRequest(void);
 
     friend class CDiagContext;
+    friend class CPerfLogger;
     friend NCBI_XNCBI_EXPORT
         CDiagContext_Extra g_PostPerf(int                       status,
                                       double                    timespan,
@@ -1971,6 +1996,8 @@ private:
     double                   m_PerfTime;
     bool                     m_Flushed;
     bool                     m_AllowBadNames;
+    // Do not print anything (e.g. perf record skipped by sampling)
+    bool                     m_Discarded;
 };
 
 
@@ -2615,6 +2642,41 @@ private:
 };
 
 
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CBinaryDiagHandler --
+///
+/// Specialization of "CDiagHandler" writing messages to a stream in the
+/// binary applog format (see SDiagMessage::WriteBinary()). The output
+/// can be converted back to the standard text format using
+/// SDiagMessage::ParseBinaryStream() or the applog_bin2txt utility.
+/// The stream should be opened in binary mode.
+
+class NCBI_XNCBI_EXPORT CBinaryDiagHandler : public CStreamDiagHandler
+{
+public:
+    /// Constructor.
+    ///
+    /// This does *not* own the stream; users will need to clean it up
+    /// themselves if appropriate.
+    CBinaryDiagHandler(CNcbiOstream* os,
+                       bool          quick_flush = true,
+                       const string& stream_name = "");
+
+    /// Implementation of CDiagHandler
+    virtual void Post(const SDiagMessage& mess);
+    virtual bool AllowAsyncWrite(const SDiagMessage& msg) const;
+    virtual string ComposeMessage(const SDiagMessage& msg,
+                                  EDiagFileType*      file_type) const;
+    virtual void WriteMessage(const char*   buf,
+                              size_t        len,
+                              EDiagFileType file_type);
+
+private:
+    bool m_QuickFlush;
+};
+
+
 class CDiagFileHandleHolder;
 
 /////////////////////////////////////////////////////////////////////////////
@@ -2783,6 +2845,16 @@ private:
 /// using standard SetDiagHandler() function, you have to use
 /// InstallToDiag() method of this handler. And don't forget to call
 /// RemoveFromDiag() before your application is finished.
+///
+/// By default all threads share a single mutex-protected queue. If
+/// [Diag]Async_Thread_Buffer_Size (DIAG_ASYNC_THREAD_BUFFER_SIZE) is set
+/// to a non-zero value, each posting thread formats its messages into
+/// its own lock-free ring buffer of that size, and the dedicated thread
+/// drains all rings in batches. Messages from the same thread (and hence
+/// from the same request) are written in the order they were posted.
+/// When a ring is full, the posting thread either waits for the writer
+/// or drops the message, depending on [Diag]Async_Overflow
+/// (DIAG_ASYNC_OVERFLOW, "Block" or "Drop").
 
 class CAsyncDiagThread;
 
@@ -2811,6 +2883,10 @@ public:
     /// of the value after call to InstallToDiag() will be ignored.
     void SetCustomThreadSuffix(const string& suffix);
 
+    /// Get number of messages dropped because a per-thread buffer
+    /// was full (only with [Diag]Async_Overflow=Drop).
+    Uint8 GetDroppedCount(void) const;
+
     /// Implementation of CDiagHandler
     virtual void Post(const SDiagMessage& mess);
     virtual string GetLogName(void);
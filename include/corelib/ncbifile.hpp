@@ -1984,6 +1984,40 @@ public:
     ///   CDirEntry::Remove, EProcessingFlags
     virtual bool Remove(TRemoveFlags flags = eRecursive) const;
 
+    /// Copy directory tree using multiple threads.
+    ///
+    /// Same as Copy() with fCF_Recursive, but subdirectories are read and
+    /// copied in parallel, which is much faster for large trees on network
+    /// file systems.  Falls back to Copy() for non-recursive copying and
+    /// for flags applied to the top directory only (fCF_TopDirOnly).
+    /// @param new_path
+    ///   New path/name for the directory.
+    /// @param flags
+    ///   Flags specified how to copy entries.
+    /// @param max_threads
+    ///   Max number of threads to use, 0 means default.
+    /// @return
+    ///   TRUE if all entries were copied successfully; FALSE, otherwise.
+    /// @sa
+    ///   Copy, CDirTreeWalker
+    bool CopyParallel(const string& new_path, TCopyFlags flags = fCF_Default,
+                      unsigned int max_threads = 0) const;
+
+    /// Delete directory tree using multiple threads.
+    ///
+    /// Same as Remove(eRecursive), but subdirectories are read and removed
+    /// in parallel.  Falls back to Remove() for non-recursive flags.
+    /// @param flags
+    ///   Directory processing flags (eRecursive or eRecursiveIgnoreMissing).
+    /// @param max_threads
+    ///   Max number of threads to use, 0 means default.
+    /// @return
+    ///   TRUE if operation successful; FALSE otherwise.
+    /// @sa
+    ///   Remove, CDirTreeWalker
+    bool RemoveParallel(TRemoveFlags flags = eRecursive,
+                        unsigned int max_threads = 0) const;
+
 
     /// Set permission mode(s) for a directory.
     ///
@@ -2089,6 +2123,109 @@ public:
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CDirTreeWalker --
+///
+/// Walk a directory tree using a bounded number of threads.
+///
+/// Every directory is read by a single thread, but different directories
+/// are read in parallel.  Entries are passed to the visitor as soon as
+/// they are read, so the visitor is called concurrently from several
+/// threads and must be thread-safe.  On UNIX the directory is opened once
+/// and read with getdents64() (Linux) or readdir(), and entries are
+/// stat'ed with fstatat() relative to the directory descriptor, so paths
+/// are not resolved again for each entry.
+///
+/// Any exception thrown by the visitor stops the walk and is rethrown
+/// from Walk() once all threads are finished.
+
+class NCBI_XNCBI_EXPORT CDirTreeWalker
+{
+public:
+    /// Directory entry information passed to the visitor.
+    struct SEntry {
+        string           path;     ///< Full path of the entry
+        CDirEntry::EType type;     ///< Entry type (of the link target if
+                                   ///< fFollowLinks is set)
+        bool             has_stat; ///< TRUE if 'stat' is filled in
+        CDirEntry::SStat stat;     ///< Entry status (with fStat only)
+        int              depth;    ///< 0 for the top directory
+    };
+
+    /// Visitor's decision on how to proceed.
+    enum EAction {
+        eContinue,    ///< Continue walking
+        eSkipDir,     ///< Do not descend into the directory
+        eStop         ///< Stop walking as soon as possible
+    };
+
+    /// Visitor interface.
+    class NCBI_XNCBI_EXPORT IVisitor
+    {
+    public:
+        typedef CDirTreeWalker::SEntry  SEntry;
+        typedef CDirTreeWalker::EAction EAction;
+
+        virtual ~IVisitor(void) {}
+
+        /// Called for each entry, including the top directory.
+        /// Directories are reported before any of their entries.
+        virtual EAction OnEntry(const SEntry& entry) = 0;
+
+        /// Called for a directory after all its entries, including ones
+        /// in its subdirectories, have been visited.
+        virtual EAction OnDirEnd(const SEntry& /* dir */)
+            { return eContinue; }
+
+        /// Called if a directory cannot be opened or read.
+        /// @param errcode
+        ///   System error code (errno).
+        virtual EAction OnError(const string& /* path */, int /* errcode */)
+            { return eContinue; }
+    };
+
+    /// Walking flags.
+    enum EFlags {
+        fStat        = (1 << 0),  ///< Get status information for each entry
+        fFollowLinks = (1 << 1),  ///< Follow symbolic links (beware of loops)
+        fDefault     = 0
+    };
+    typedef int TFlags;  ///< Binary OR of "EFlags"
+
+    /// Constructor.
+    /// @param max_threads
+    ///   Max number of threads to use, including the calling one.
+    ///   0 means default (twice the number of CPUs, at least 4 and at
+    ///   most 32); 1 means walking in the calling thread only.
+    CDirTreeWalker(unsigned int max_threads = 0, TFlags flags = fDefault);
+    ~CDirTreeWalker(void);
+
+    /// Walk the tree.
+    /// @param path
+    ///   Top directory (or any other entry, which is just visited).
+    /// @return
+    ///   FALSE if the walk was stopped by the visitor, or 'path' does
+    ///   not exist; TRUE otherwise.
+    bool Walk(const string& path, IVisitor& visitor);
+
+    /// Max number of threads used.
+    unsigned int GetMaxThreads(void) const { return m_MaxThreads; }
+
+private:
+    struct SImpl;
+
+    unsigned int m_MaxThreads;
+    TFlags       m_Flags;
+
+private:
+    // Prevent copying
+    CDirTreeWalker(const CDirTreeWalker&);
+    void operator=(const CDirTreeWalker&);
+};
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 ///
 /// CFileUtil -- Utility functions.
@@ -3491,6 +3628,25 @@ public:
     ///   The number of bytes written; equal to 'count'. 
     size_t Write(const void* buf, size_t count) const;
 
+    /// Read file at the given position.
+    ///
+    /// The current file position is not used.  On UNIX it does not change
+    /// either, so several threads can read the same file concurrently;
+    /// on MS Windows it is moved past the last byte read.
+    /// @return
+    ///   The number of bytes actually read.
+    ///   Can be less than 'count' only if the end of file is reached.
+    /// @sa CFileAsyncIO
+    size_t ReadAt(Uint8 position, void* buf, size_t count) const;
+
+    /// Write file at the given position.
+    ///
+    /// Always write all 'count' bytes of data to the file.
+    /// File position is handled the same way as by ReadAt().
+    /// @return
+    ///   The number of bytes written; equal to 'count'.
+    size_t WriteAt(Uint8 position, const void* buf, size_t count) const;
+
     /// Flush file buffers.
     void Flush(void) const;
 
@@ -3704,6 +3860,172 @@ private:
 };
 
 
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CFileAsyncIO --
+///
+/// Asynchronous batch file I/O.
+///
+/// Positioned reads and writes are queued, started together by Submit()
+/// and their completions are reaped by Wait() in the order they finish,
+/// so a single thread can keep many I/O requests outstanding instead of
+/// blocking on each of them.  On Linux the requests are served by io_uring
+/// if the kernel supports it; otherwise (and on other platforms) they are
+/// served by a pool of threads, each doing one blocking positioned
+/// read/write at a time.
+///
+/// Each request is completed in full: the number of bytes read can be
+/// less than requested only at the end of file, and writes always write
+/// all data.  Errors are reported for each request in SCompletion::error;
+/// exceptions (CFileException/CFileErrnoException) are thrown only if the
+/// I/O engine itself fails.
+///
+/// Buffers must stay valid until the request is reaped by Wait().
+/// The object is not thread-safe, use one object per thread.  The
+/// destructor waits for all started requests to finish.
+///
+/// io_uring usage can be disabled by the configuration parameter:
+/// Registry file:
+///     [NCBI]
+///     FileAPIUseIOUring = false
+/// Environment variable:
+///     NCBI_CONFIG__FILEAPIUSEIOURING
+///
+/// @sa CFileIO::ReadAt, CFileIO::WriteAt
+
+class NCBI_XNCBI_EXPORT CFileAsyncIO
+{
+public:
+    /// I/O engine.
+    enum EBackend {
+        eDefault,       ///< io_uring if available, thread pool otherwise
+        eIOUring,       ///< Linux io_uring, throw if not available
+        eThreadPool     ///< Blocking I/O in a pool of threads
+    };
+
+    /// Request type.
+    enum EOperation {
+        eRead,
+        eWrite
+    };
+
+    /// Completed request.
+    struct SCompletion {
+        void*      cookie;    ///< User data passed with the request
+        EOperation op;        ///< Request type
+        Uint8      position;  ///< File position of the request
+        size_t     bytes;     ///< Number of bytes transferred
+        int        error;     ///< 0 on success, or system error code
+    };
+    typedef vector<SCompletion> TCompletions;
+
+    /// Constructor.
+    /// @param queue_depth
+    ///   Max number of requests started at the same time (0 - default,
+    ///   64).  More requests can be queued, they are started as the
+    ///   previous ones complete.  For the thread pool this is also the
+    ///   max number of threads (limited to 64).
+    /// @param backend
+    ///   I/O engine to use.
+    CFileAsyncIO(unsigned int queue_depth = 0, EBackend backend = eDefault);
+
+    /// Wait for all started requests, discard the ones not started yet.
+    ~CFileAsyncIO(void);
+
+    /// Queue reading of 'count' bytes at 'position' into 'buf'.
+    /// The request is not started until Submit() or Wait() is called.
+    void Read(TFileHandle handle, Uint8 position, void* buf, size_t count,
+              void* cookie = NULL);
+
+    /// Queue writing of 'count' bytes from 'buf' at 'position'.
+    /// The request is not started until Submit() or Wait() is called.
+    void Write(TFileHandle handle, Uint8 position, const void* buf,
+               size_t count, void* cookie = NULL);
+
+    /// Start queued requests, as many as the queue depth allows.
+    /// @return
+    ///   Number of requests started.
+    size_t Submit(void);
+
+    /// Start queued requests and wait for completions.
+    ///
+    /// Return as soon as at least 'min_count' requests are completed,
+    /// or there are no more requests.  All completions available at
+    /// that moment are reaped.
+    /// @param completions
+    ///   Completions are appended to this list.
+    /// @param min_count
+    ///   Min number of completions to wait for, 0 means just collecting
+    ///   already completed requests without blocking.
+    /// @return
+    ///   Number of completions added.
+    size_t Wait(TCompletions& completions, size_t min_count = 1);
+
+    /// Wait until all queued and started requests are completed.
+    /// @sa Wait
+    size_t WaitAll(TCompletions& completions)
+        { return Wait(completions, numeric_limits<size_t>::max()); }
+
+    /// Number of requests queued or started, and not reaped yet.
+    size_t GetPending(void) const { return m_Queued.size() + m_Started; }
+
+    /// I/O engine used (never eDefault).
+    EBackend GetBackend(void) const { return m_BackendType; }
+
+    /// Max number of requests started at the same time.
+    unsigned int GetQueueDepth(void) const { return m_QueueDepth; }
+
+    /// Check if io_uring is supported by the system.
+    static bool IsIOUringAvailable(void);
+
+    /// Request state, for internal use.
+    struct SRequest {
+        TFileHandle handle;
+        EOperation  op;
+        Uint8       position;
+        char*       buf;
+        size_t      count;
+        size_t      done;     ///< Bytes transferred so far
+        int         error;
+        void*       cookie;
+        unsigned    slot;     ///< Index in the list of started requests
+    };
+
+    /// I/O engine interface, for internal use.
+    class IEngine
+    {
+    public:
+        virtual ~IEngine(void) {}
+        /// Start the request (or prepare to start it in Commit()).
+        virtual void Start(SRequest& req) = 0;
+        /// Commit all requests passed to Start().
+        virtual void Commit(void) = 0;
+        /// Get slots of completed requests, block until at least one is
+        /// completed if 'wait' is TRUE.
+        virtual void Reap(vector<unsigned>& slots, bool wait) = 0;
+    };
+
+private:
+    void x_Queue(TFileHandle handle, EOperation op, Uint8 position,
+                 char* buf, size_t count, void* cookie);
+
+    unsigned int        m_QueueDepth;
+    EBackend            m_BackendType;
+    unique_ptr<IEngine> m_Engine;
+    deque<SRequest>     m_Queued;     ///< Not started yet
+    vector<SRequest>    m_Slots;      ///< Started requests
+    vector<unsigned>    m_FreeSlots;
+    size_t              m_Started;    ///< Started and not reaped
+    vector<unsigned>    m_Reaped;
+
+private:
+    // Prevent copying
+    CFileAsyncIO(const CFileAsyncIO&);
+    void operator=(const CFileAsyncIO&);
+};
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 ///
 /// File locking
@@ -89,13 +89,22 @@ public:
     /// Deallocate memory block.
     /// Deallocated momory is not reused, but block counter is decremented,
     /// and if it goes to zero, full memory chunk is freed.
-    void Deallocate(void* ptr);
+    /// The block may belong to any pool, so the method is static.
+    static void Deallocate(void* ptr);
 
     /// Check if object is allocated from some memory pool,
     /// and delete it correspondingly.
     static void Delete(const CObject* object);
 
+    /// Get memory pool used by the current thread for all CObjects
+    /// allocated with plain 'new', or null if there's none.
+    /// @sa CObjectMemoryPoolGuard
+    static CObjectMemoryPool* GetThreadPool(void);
+
 private:
+    friend class CObjectMemoryPoolGuard;
+    friend class CObjectMemoryPoolChunk;
+
     size_t m_ChunkSize;
     size_t m_MallocThreshold;
     CRef<CObjectMemoryPoolChunk> m_CurrentChunk;
@@ -107,6 +116,43 @@ private:
 };
 
 
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CObjectMemoryPoolGuard --
+///
+/// Make the memory pool current for the calling thread.
+/// While the guard exists, all CObjects created with plain 'new' in this
+/// thread (e.g. the whole object graph read by CObjectIStream) are bump
+/// allocated from the pool instead of the global heap. Each object keeps
+/// its own reference counter and is destroyed when its last CRef is gone;
+/// a chunk of the pool is freed in one shot when all objects allocated
+/// in it are destroyed. The objects may be released by any thread.
+/// Objects bigger than the pool's malloc threshold still go to the heap.
+/// Guards can be nested, a guard with null pool does nothing.
+/// @note
+///   CObjectMemoryPool is not MT-safe, so the same pool must not be
+///   current for several threads at once.
+/// @note
+///   Long-living objects created while the guard is active (caches etc.)
+///   keep their whole chunk allocated.
+
+class NCBI_XNCBI_EXPORT CObjectMemoryPoolGuard
+{
+public:
+    CObjectMemoryPoolGuard(CObjectMemoryPool* pool);
+    ~CObjectMemoryPoolGuard(void);
+
+private:
+    CRef<CObjectMemoryPool> m_Pool;
+    CObjectMemoryPool*      m_SavedPool;
+
+private:
+    // prevent copying
+    CObjectMemoryPoolGuard(const CObjectMemoryPoolGuard&);
+    void operator=(const CObjectMemoryPoolGuard&);
+};
+
+
 ////////////////////////////////////////////////////////////////////////////
 // inline functions
 
@@ -65,6 +65,7 @@
 #include <corelib/ncbitime.hpp>
 #include <memory>
 #include <deque>
+#include <atomic>
 #ifdef NCBI_COMPILER_MSVC
 # include <intrin.h>
 # pragma intrinsic(_ReadWriteBarrier)
@@ -1172,6 +1173,78 @@ private:
 
 
 
+class CDistributedRWLock;
+
+typedef CGuard< CDistributedRWLock,
+                SSimpleReadLock  <CDistributedRWLock>,
+                SSimpleReadUnlock<CDistributedRWLock> >  CDistributedReadGuard;
+typedef CGuard< CDistributedRWLock,
+                SSimpleWriteLock  <CDistributedRWLock>,
+                SSimpleWriteUnlock<CDistributedRWLock> > CDistributedWriteGuard;
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CDistributedRWLock --
+///
+/// Read/Write lock for read-mostly data shared by many threads.
+///
+/// Has the same interface, assumptions and limitations as CFastRWLock,
+/// but the read lock count is distributed over kSlots counters, each in
+/// its own cache line ("big-reader" lock). Every thread is assigned one of
+/// the counters, so read locks from different threads do not contend for
+/// the same memory and scale with the number of CPUs. Write lock is more
+/// expensive - it has to wait for all the counters to drop to zero.
+/// - Read lock must be released by the same thread which acquired it.
+/// - The lock object is relatively large (kSlots cache lines), so it is
+///   intended for long-living tables rather than for individual objects.
+
+class NCBI_XNCBI_EXPORT CDistributedRWLock
+{
+public:
+    typedef CDistributedReadGuard  TReadLockGuard;
+    typedef CDistributedWriteGuard TWriteLockGuard;
+
+    CDistributedRWLock(void);
+    ~CDistributedRWLock(void);
+
+    /// Acquire read lock
+    void ReadLock(void);
+    /// Release read lock
+    void ReadUnlock(void);
+
+    /// Acquire write lock
+    void WriteLock(void);
+    /// Release write lock
+    void WriteUnlock(void);
+
+    enum {
+        kSlots     = 64,   ///< Number of read lock counters
+        kCacheLine = 64    ///< Assumed size of CPU cache line
+    };
+
+private:
+    CDistributedRWLock(const CDistributedRWLock&);
+    CDistributedRWLock& operator= (const CDistributedRWLock&);
+
+    struct SSlot {
+        atomic<int> m_Readers;
+        char        m_Padding[kCacheLine - sizeof(atomic<int>)];
+    };
+
+    /// Get the counter assigned to the current thread.
+    static unsigned x_GetSlot(void);
+
+    /// Read lock counters
+    SSlot        m_Slots[kSlots];
+    /// Set while write lock is being acquired or held
+    atomic<bool> m_Writer;
+    /// Mutex implementing write lock
+    CFastMutex   m_WriteLock;
+};
+
+
+
 class CYieldingRWLock;
 class CRWLockHolder;
 
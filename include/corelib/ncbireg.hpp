@@ -898,6 +898,8 @@ private:
 
 
 class CEnvironmentRegistry; // see <corelib/env_reg.hpp>
+class CRegistrySnapshot;
+class CMemoryFile;          // see <corelib/ncbifile.hpp>
 
 
 
@@ -960,6 +962,11 @@ public:
     ///   and parsed; FALSE otherwise.
     bool IncludeNcbircIfAllowed(TFlags flags = fWithNcbirc);
 
+    /// Load all entries of a compiled registry snapshot into the file
+    /// layer, as if they were read from the configuration file(s) the
+    /// snapshot was compiled from.
+    void ReadSnapshot(const CRegistrySnapshot& snapshot);
+
     /// Predefined subregistries' names.
     static const char* sm_EnvRegName;
     static const char* sm_FileRegName;
@@ -971,6 +978,7 @@ protected:
     IRWRegistry* x_Read(CNcbiIstream& is, TFlags flags, const string& path);
     const string& x_GetComment(const string& section, const string& name,
                                TFlags flags) const;
+    void x_SetModifiedFlag(bool modified, TFlags flags);
 
 private:
     void x_Init(void);
@@ -992,6 +1000,123 @@ private:
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CRegistrySnapshot --
+///
+/// Read-only, memory-mapped image of a merged registry.
+///
+/// The snapshot is a flat binary file holding all persistent entries of a
+/// registry sorted by section and name, along with the list of the
+/// configuration files it was compiled from and their sizes and
+/// modification times.  Opening a snapshot maps it into memory and checks
+/// that none of the source files has changed since.  Lookups are binary
+/// searches over the mapped data and take no locks.
+///
+/// CNcbiApplication::LoadConfig() compiles and uses the snapshot for the
+/// application registry when the environment variable NCBI_CONFIG_SNAPSHOT
+/// names the snapshot file.  While the application registry stays
+/// unmodified, g_GetConfigXxx() (and so CParam) read registry values from
+/// the active snapshot without locking.  The snapshot holds persistent
+/// entries only, so it is neither compiled nor activated if the registry
+/// has transient entries (including NCBI_CONFIG__* environment overrides).
+/// @note
+///   Configuration files which did not exist when the snapshot was
+///   compiled (e.g. a newly created .ncbirc) are not detected; remove the
+///   snapshot file to force recompilation.
+
+class NCBI_XNCBI_EXPORT CRegistrySnapshot : public CObject
+{
+public:
+    typedef vector<string> TSources;
+
+    /// Compile persistent entries of the registry into a snapshot file.
+    /// The file is written under a temporary name and then renamed, so
+    /// that concurrently starting processes never see a partial snapshot.
+    /// @param reg
+    ///   Registry to compile.
+    /// @param path
+    ///   Snapshot file name.
+    /// @param sources
+    ///   Configuration files the registry was loaded from.
+    /// @param key
+    ///   Arbitrary string identifying the configuration (e.g. the name of
+    ///   the requested configuration file), must match the one passed to
+    ///   Open().
+    static void Write(const IRegistry& reg,
+                      const string&    path,
+                      const TSources&  sources,
+                      const string&    key = kEmptyStr);
+
+    /// Map snapshot file into memory.
+    /// @return
+    ///   NULL if the file does not exist, is not a valid snapshot, was
+    ///   compiled with a different key, or if any of its source files has
+    ///   changed since the snapshot was written.
+    static CRef<CRegistrySnapshot> Open(const string& path,
+                                        const string& key = kEmptyStr);
+
+    ~CRegistrySnapshot(void);
+
+    /// Find value of the entry.  Section and entry names are
+    /// case-insensitive.  The value points into the mapped snapshot.
+    /// @return
+    ///   TRUE if the entry was found.
+    bool Find(const CTempString& section,
+              const CTempString& name,
+              CTempString*       value) const;
+
+    /// Get value of the entry or empty string if not found.
+    string Get(const CTempString& section, const CTempString& name) const;
+
+    /// Number of entries in the snapshot.
+    size_t GetSize(void) const { return m_EntryCount; }
+
+    /// Configuration files the snapshot was compiled from.
+    const TSources& GetSources(void) const { return m_Sources; }
+
+    /// Check if any of the source files has changed.
+    bool IsStale(void) const;
+
+    /// Copy all entries into the registry as persistent values.
+    void Load(IRWRegistry& reg) const;
+
+    /// Make the snapshot consulted by g_GetConfigXxx() until the registry
+    /// it was loaded into is modified.  Once activated, the snapshot is
+    /// referenced and stays mapped until the program exits, even after
+    /// deactivation, because lock-free readers may still use it.
+    static void Activate(CRegistrySnapshot& snapshot, const IRegistry& reg);
+
+    /// Stop using the active snapshot if it was activated for the registry
+    /// (any registry if NULL).
+    static void Deactivate(const IRegistry* reg = NULL);
+
+    /// Get the active snapshot, if any.  Does not lock.
+    static const CRegistrySnapshot* GetActive(void);
+
+private:
+    struct SHeader;
+    struct SSource;
+    struct SEntry;
+
+    CRegistrySnapshot(void);
+
+    bool x_Init(const string& key);
+    CTempString x_GetString(Uint4 offset, Uint4 length) const;
+
+    unique_ptr<CMemoryFile> m_File;
+    const char*             m_Data;
+    size_t                  m_Size;
+    const SSource*          m_SourceInfo;
+    const SEntry*           m_Entries;
+    size_t                  m_EntryCount;
+    const char*             m_Strings;
+    size_t                  m_StringsSize;
+    TSources                m_Sources;
+};
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 ///
 /// CRegistryException --
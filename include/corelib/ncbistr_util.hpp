@@ -99,6 +99,8 @@ public:
     void   Join(string* s) const;
     void   Join(CTempString* s) const;
     void   Join(CTempStringEx* s) const;
+    /// Reference a single part directly, join several parts in 'buffer'.
+    void   Join(CTempString* s, string* buffer) const;
     size_t GetSize(void) const;
 
 private:
@@ -111,6 +113,11 @@ private:
         unique_ptr<SNode> next;
     };
 
+    // The nodes are kept after Clear() and reused by the next Add() calls,
+    // only the nodes up to m_LastNode are in use.
+    bool x_IsLast(const SNode* node) const
+        { return m_LastNode == NULL  ||  node == m_LastNode; }
+
     SNode  m_FirstNode;
     SNode *m_LastNode;
     CTempString_Storage* m_Storage;
@@ -122,6 +129,9 @@ void CTempStringList::Add(const CTempString& s)
     if (m_LastNode == NULL) {
         m_FirstNode.str = s;
         m_LastNode = &m_FirstNode;
+    } else if ( m_LastNode->next.get() ) {
+        m_LastNode = m_LastNode->next.get();
+        m_LastNode->str = s;
     } else {
         m_LastNode->next.reset(new SNode(s));
         m_LastNode = m_LastNode->next.get();
@@ -132,7 +142,6 @@ inline
 void CTempStringList::Clear(void)
 {
     m_FirstNode.str.clear();
-    m_FirstNode.next.reset();
     m_LastNode = NULL;
 }
 
@@ -170,6 +179,10 @@ public:
     // Set new delimiters.
     void SetDelim(const CTempString& delim);
 
+    /// Restart tokenization from the given position, which must be
+    /// a value previously returned by GetPos() or 0.
+    void SetPos(SIZE_TYPE pos) { m_Pos = pos; }
+
 protected:
     const CTempString&   m_Str;
     CTempString          m_Delim;
@@ -399,6 +412,104 @@ private:
 
 
 
+/// Lazy tokenizer view of a string.
+///
+/// Iterate over the same tokens as NStr::Split() would produce for the same
+/// delimiters and flags, without storing them in a container and without
+/// allocating memory. Tokens which are substrings of the source reference
+/// it directly; tokens assembled from several parts (escaped or partially
+/// quoted text) are joined in a buffer owned by the view and stay valid
+/// until the next increment. The source string must outlive the view.
+///
+/// The view is single-pass: all iterators share the state of the view,
+/// begin() restarts tokenization from the beginning of the string.
+///
+/// @example
+///   for (CTempString column : CStrTokenView(line, "\t")) { ... }
+/// @sa NStr::Split, CStrTokenize
+///
+class NCBI_XNCBI_EXPORT CStrTokenView
+{
+public:
+    typedef NStr::TSplitFlags TFlags;
+
+    CStrTokenView(const CTempString& str, const CTempString& delim,
+                  TFlags flags = 0);
+
+    class const_iterator
+    {
+    public:
+        typedef input_iterator_tag iterator_category;
+        typedef CTempString        value_type;
+        typedef ptrdiff_t          difference_type;
+        typedef const CTempString* pointer;
+        typedef const CTempString& reference;
+
+        const_iterator(void) : m_View(NULL) {}
+
+        reference operator* (void) const { return m_View->m_Token; }
+        pointer   operator->(void) const { return &m_View->m_Token; }
+
+        const_iterator& operator++(void)
+        {
+            if ( !m_View->x_Next() ) {
+                m_View = NULL;
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator& it) const
+            { return m_View == it.m_View; }
+        bool operator!=(const const_iterator& it) const
+            { return m_View != it.m_View; }
+
+    private:
+        friend class CStrTokenView;
+        const_iterator(CStrTokenView* view) : m_View(view) {}
+
+        CStrTokenView* m_View;
+    };
+    typedef const_iterator iterator;
+
+    /// Restart tokenization and return iterator to the first token.
+    const_iterator begin(void);
+    const_iterator end  (void) const { return const_iterator(); }
+
+    /// Position of the current token in the source string.
+    SIZE_TYPE GetTokenPos(void) const { return m_TokenPos; }
+
+private:
+    CStrTokenView(const CStrTokenView&);
+    CStrTokenView& operator=(const CStrTokenView&);
+
+    enum EState {
+        eStart,    ///< before the first token
+        eSingle,   ///< the whole string is the only token
+        eTokens,   ///< tokenizing
+        eEnd       ///< no more tokens
+    };
+
+    // Get the next token as NStr::Split() would, honoring
+    // fSplit_Truncate_End. Return false if there are no more tokens.
+    bool x_Next(void);
+    // Get the next token ignoring fSplit_Truncate_End.
+    bool x_NextRaw(void);
+
+    CTempString      m_Str;
+    CTempString      m_Delim;
+    TFlags           m_Flags;
+    CStrTokenizeBase m_Tokenizer;
+    CTempStringList  m_Parts;
+    string           m_Buffer;
+    EState           m_State;
+    SIZE_TYPE        m_DelimPos;
+    size_t           m_EmptyAhead;  ///< empty tokens known to be kept
+    CTempString      m_Token;
+    SIZE_TYPE        m_TokenPos;
+};
+
+
+
  /*
  * @}
  */
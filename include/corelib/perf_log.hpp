@@ -73,6 +73,21 @@ class CPerfLogGuard;
 ///     perf_logger.Post(...).Print(...)
 ///   that extra record will be put into the log if the logging is off.
 ///   Please use PERF_POST macro or PerfLogGuard class to avoid this.
+///
+/// Aggregation mode. Printing a record for every operation may be too
+/// expensive for busy applications. If [Log]PerfLogging_Aggregate is set,
+/// each timing is also added to a per-resource, per-status latency
+/// histogram (log-linear buckets, ~6% precision, lock-free update).
+/// Every [Log]PerfLogging_Interval seconds (60 by default, 0 to disable)
+/// a background thread reports the histograms as one perf record per
+/// resource/status with count, min, max, p50, p99 and p999 values, then
+/// resets them. The remaining timings are reported when CNcbiApplication
+/// exits (or when CPerfLogger::FlushAggregated() is called).
+/// Aggregation works only if performance logging itself is on
+/// ([Log]PerfLogging), otherwise Post() ignores the timings.
+/// [Log]PerfLogging_Sample controls how many of the regular (raw) records
+/// are printed: 1 - all of them (default), N - one of every N records,
+/// 0 - none.
 /// @sa
 ///   PERF_POST, PERF_POST_DB, PerfLogGuard
 
@@ -143,6 +158,25 @@ public:
     /// Turn performance logging on/off globally.
     static void SetON(bool enable = true);
 
+    /// Is aggregation of the timings into histograms on?
+    /// Controlled by CParam(section="Log", entry="PerfLogging_Aggregate",
+    /// default=false)
+    static bool IsAggregating(void);
+
+    /// Turn aggregation on/off globally.
+    /// @note Has no effect unless performance logging is on, see SetON().
+    static void SetAggregating(bool enable = true);
+
+    /// Report the aggregated timings collected since the last report
+    /// and reset the histograms. Normally this is done automatically every
+    /// [Log]PerfLogging_Interval seconds, but the method may be called
+    /// explicitly, e.g. before the application exits.
+    static void ReportAggregated(void);
+
+    /// Stop the periodic reports and report the remaining aggregated
+    /// timings. Called by CNcbiApplication before the application exits.
+    static void FlushAggregated(void);
+
     /// Adjust the printed elapsed time.
     /// @param timespan
     ///   Adjustment value, can be positive or negative. The value is
@@ -156,7 +190,11 @@ public:
 
 private:
     bool x_CheckValidity(const CTempString& err_msg) const;
+    static void x_PostAggregated(int                       status,
+                                 double                    timespan,
+                                 SDiagMessage::TExtraArgs& args);
     friend class CPerfLogGuard;
+    friend class CPerfLogAggregator;
 
 private:
     unique_ptr<CStopWatch> m_StopWatchGuard; // Internal timer if auto-created.
@@ -621,12 +621,8 @@ CTempString::size_type CTempString::find(char match, size_type pos) const
     if (pos + 1 > length()) {
         return npos;
     }
-    for (size_type i = pos;  i < length();  ++i) {
-        if (m_String[i] == match) {
-            return i;
-        }
-    }
-    return npos;
+    const void* found = memchr(m_String + pos, match, length() - pos);
+    return found ? size_type(static_cast<const char*>(found) - m_String) : npos;
 }
 
 
@@ -641,8 +637,7 @@ CTempString::size_type CTempString::find(const CTempString match,
         return pos;
     }
     size_type length_limit = length() - match.length();
-    while ( (pos = find_first_of(CTempString(match, 0, 1), pos)) !=
-            string::npos) {
+    while ( (pos = find(match[0], pos)) != string::npos ) {
         if (pos > length_limit) {
             return npos;
         }
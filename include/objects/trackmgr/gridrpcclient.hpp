@@ -244,6 +244,12 @@ protected:
             return "GZipFile";
         case CCompressStream::eConcatenatedGZipFile:
             return "GZipFile";
+        case CCompressStream::eZstd:
+            return "Zstd";
+        case CCompressStream::eGZipFileMT:
+            return "GZipFileMT";
+        case CCompressStream::eBGZF:
+            return "BGZF";
         };
         NCBI_THROW(CException, eUnknown, "unexpected compression method");
     }
@@ -34,8 +34,10 @@
 
 #include <corelib/ncbistd.hpp>
 #include <corelib/ncbiobj.hpp>
+#include <corelib/ncbimtx.hpp>
 #include <serial/serialdef.hpp>
 #include <memory>
+#include <atomic>
 
 
 /** @addtogroup ObjStreamSupport
@@ -58,6 +60,7 @@ class NCBI_XSERIAL_EXPORT CDelayBuffer
 {
 public:
     CDelayBuffer(void)
+        : m_Delayed(false)
         {
         }
     ~CDelayBuffer(void);
@@ -68,15 +71,17 @@ public:
     ///   TRUE is the buffer is not empty
     bool Delayed(void) const
         {
-            return m_Info.get() != 0;
+            return m_Delayed.load(memory_order_acquire);
         }
 
-    DECLARE_OPERATOR_BOOL_PTR(m_Info.get());
+    DECLARE_OPERATOR_BOOL(Delayed());
 
     /// Forget the stored data
     void Forget(void);
     
-    /// Parse stored data
+    /// Parse stored data.
+    /// Can be called from several threads at once: the data is parsed
+    /// only once, and the other threads wait for it.
     void Update(void)
         {
             if ( Delayed() )
@@ -140,6 +145,8 @@ private:
     void DoUpdate(void);
 
     unique_ptr<SInfo> m_Info;
+    atomic<bool>      m_Delayed;
+    CFastMutex        m_Mutex;
 };
 
 /* @} */
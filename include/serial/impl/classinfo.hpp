@@ -48,6 +48,8 @@ BEGIN_NCBI_SCOPE
 
 class CObjectIStream;
 class CObjectOStream;
+class CObjectIStreamAsnBinary;
+class CObjectOStreamAsnBinary;
 class COObjectList;
 class CMemberId;
 class CMemberInfo;
@@ -116,6 +118,21 @@ public:
     void SetGlobalHook(const CTempString& member_names,
                        CReadClassMemberHook* hook);
 
+    /// Type-specialized binary ASN.1 member readers and writers.
+    /// Generated by datatool when "asnb_codecs" code generation style
+    /// is requested; used for sequential classes instead of the loop
+    /// over member information when the stream state allows it.
+    typedef void (*TAsnBinaryReadFunction)(CObjectIStreamAsnBinary& in,
+                                           const CClassTypeInfo* classType,
+                                           TObjectPtr classPtr);
+    typedef void (*TAsnBinaryWriteFunction)(CObjectOStreamAsnBinary& out,
+                                            const CClassTypeInfo* classType,
+                                            TConstObjectPtr classPtr);
+    CClassTypeInfo* SetAsnBinaryFunctions(TAsnBinaryReadFunction readFunc,
+                                          TAsnBinaryWriteFunction writeFunc);
+    TAsnBinaryReadFunction GetAsnBinaryReadFunction(void) const;
+    TAsnBinaryWriteFunction GetAsnBinaryWriteFunction(void) const;
+
 public:
 
     // iterators interface
@@ -142,6 +159,9 @@ private:
 
     TGetTypeIdFunction m_GetTypeIdFunction;
 
+    TAsnBinaryReadFunction m_AsnBinaryReadFunction;
+    TAsnBinaryWriteFunction m_AsnBinaryWriteFunction;
+
     const CMemberInfo* GetImplicitMember(void) const;
 
 private:
@@ -150,6 +170,9 @@ private:
     static void ReadClassSequential(CObjectIStream& in,
                                     TTypeInfo objectType,
                                     TObjectPtr objectPtr);
+    static void ReadClassSequentialGenerated(CObjectIStream& in,
+                                             TTypeInfo objectType,
+                                             TObjectPtr objectPtr);
     static void ReadClassRandom(CObjectIStream& in,
                                 TTypeInfo objectType,
                                 TObjectPtr objectPtr);
@@ -162,6 +185,9 @@ private:
     static void WriteClassSequential(CObjectOStream& out,
                                      TTypeInfo objectType,
                                      TConstObjectPtr objectPtr);
+    static void WriteClassSequentialGenerated(CObjectOStream& out,
+                                              TTypeInfo objectType,
+                                              TConstObjectPtr objectPtr);
     static void WriteImplicitMember(CObjectOStream& out,
                                     TTypeInfo objectType,
                                     TConstObjectPtr objectPtr);
@@ -74,6 +74,20 @@ const CClassTypeInfo::TSubClasses* CClassTypeInfo::SubClasses(void) const
     return m_SubClasses.get();
 }
 
+inline
+CClassTypeInfo::TAsnBinaryReadFunction
+CClassTypeInfo::GetAsnBinaryReadFunction(void) const
+{
+    return m_AsnBinaryReadFunction;
+}
+
+inline
+CClassTypeInfo::TAsnBinaryWriteFunction
+CClassTypeInfo::GetAsnBinaryWriteFunction(void) const
+{
+    return m_AsnBinaryWriteFunction;
+}
+
 inline
 const type_info*
 CClassTypeInfo::GetCPlusPlusTypeInfo(TConstObjectPtr object) const
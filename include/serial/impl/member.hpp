@@ -177,6 +177,11 @@ public:
     void SetPathCopyHook(CObjectStreamCopier* copier, const string& path,
                          CCopyClassMemberHook* hook);
 
+    /// Check if any read hook is set for the member or its type
+    bool HaveReadHooks(void) const;
+    /// Check if any write hook is set for the member or its type
+    bool HaveWriteHooks(void) const;
+
     // default I/O (without hooks)
     void DefaultReadMember(CObjectIStream& in,
                            TObjectPtr classPtr) const;
@@ -308,6 +308,14 @@ void CObjectOStream::ByteBlock::Write(const void* bytes, size_t length)
     m_Length -= length;
 }
 
+inline
+void CObjectOStream::ByteBlock::WriteExternal(const void* bytes, size_t length)
+{
+    _ASSERT( length <= m_Length );
+    GetStream().WriteExternalBytes(*this, static_cast<const char*>(bytes), length);
+    m_Length -= length;
+}
+
 inline
 CObjectOStream::CharBlock::CharBlock(CObjectOStream& out, size_t length)
     : m_Stream(out), m_Length(length), m_Ended(false)
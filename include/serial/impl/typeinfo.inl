@@ -87,6 +87,18 @@ void CTypeInfo::SkipData(CObjectIStream& in) const
     m_SkipHookData.GetCurrentFunction()(in, this);
 }
 
+inline
+bool CTypeInfo::HaveReadHooks(void) const
+{
+    return m_ReadHookData.HaveHooks();
+}
+
+inline
+bool CTypeInfo::HaveWriteHooks(void) const
+{
+    return m_WriteHookData.HaveHooks();
+}
+
 inline
 void CTypeInfo::DefaultReadData(CObjectIStream& in,
                                 TObjectPtr objectPtr) const
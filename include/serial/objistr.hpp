@@ -784,7 +784,10 @@ public:
 //---------------------------------------------------------------------------
 // Internals
 
-    // memory pool to use to create new objects when reading data
+    // memory pool to use to create new objects when reading data;
+    // while reading, the pool is also current for the thread, so all
+    // CObjects of the read object graph are allocated in it
+    // (see CObjectMemoryPoolGuard)
     void SetMemoryPool(CObjectMemoryPool* memory_pool)
         {
             m_MemoryPool = memory_pool;
@@ -832,7 +835,9 @@ public:
         fFlagAllowNonAsciiChars  = 1 << 0,
         eFlagAllowNonAsciiChars  = fFlagAllowNonAsciiChars,
         fFlagEnforcedStdXml      = 1 << 1,
-        eFlagEnforcedStdXml      = fFlagEnforcedStdXml
+        eFlagEnforcedStdXml      = fFlagEnforcedStdXml,
+        /// ASN.1 binary: do not use datatool-generated class readers
+        fFlagNoGeneratedCode     = 1 << 2
     };
     typedef int TFlags;
     TFlags GetFlags(void) const;
@@ -997,6 +1002,10 @@ public:
     virtual CRef<CByteSource> EndDelayBuffer(void);
     void EndDelayBuffer(CDelayBuffer& buffer,
                         const CItemInfo* itemInfo, TObjectPtr objectPtr);
+    /// Skip data which goes into a delay buffer.
+    /// The data is checked only when it is parsed, so streams may skip it
+    /// without looking into its structure.
+    virtual void SkipDelayedObject(TTypeInfo type);
 
     TObjectPtr GetParentObjectPtr(TTypeInfo type,
                                   size_t max_depth = 1,
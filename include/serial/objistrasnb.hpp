@@ -134,11 +134,72 @@ public:
     virtual void ReadAnyContentObject(CAnyContentObject& obj) override;
     void SkipAnyContent(void);
     virtual void SkipAnyContentObject(void) override;
+    virtual void SkipDelayedObject(TTypeInfo type) override;
     virtual void SkipAnyContentVariant(void) override;
 
     virtual void ReadBitString(CBitString& obj) override;
     virtual void SkipBitString(void) override;
 
+    /// Enable or disable the type-specialized class readers generated
+    /// by datatool (see CClassTypeInfo::SetAsnBinaryFunctions).
+    /// The default is taken from SERIAL_USE_GENERATED_ASNB parameter.
+    /// The setting is kept in fFlagNoGeneratedCode, so that it is passed
+    /// to the streams which parse delay buffers.
+    void SetUseGeneratedCode(bool set = true)
+    {
+        if ( set ) {
+            ClearFlags(fFlagNoGeneratedCode);
+        }
+        else {
+            SetFlags(fFlagNoGeneratedCode);
+        }
+    }
+    bool GetUseGeneratedCode(void) const
+    {
+        return (GetFlags() & fFlagNoGeneratedCode) == 0;
+    }
+
+    // Interface used by the generated class readers.
+    /// Read sequential class using its generated reader if the stream
+    /// state allows it, or using its type information otherwise
+    void ReadGeneratedClass(const CClassTypeInfo* classType,
+                            TObjectPtr classPtr);
+    /// Start reading class member.
+    /// @return
+    ///   member information, or NULL if the member is absent
+    const CMemberInfo* BeginGeneratedMember(const CClassTypeInfo* classType,
+                                            TMemberIndex index);
+    void EndGeneratedMember(void);
+    /// Check that there are no more members in the class
+    void EndGeneratedMembers(const CClassTypeInfo* classType);
+
+    /// Read member of a standard type directly. Members with hooks,
+    /// default values and other special cases are read through
+    /// the member information.
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr, bool& data);
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr, Int4& data);
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr, Uint4& data);
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr, Int8& data);
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr, Uint8& data);
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr, double& data);
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr, string& data);
+    template<class T>
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr, T& /*data*/)
+    {
+        ReadGeneratedMember(memberInfo, classPtr);
+    }
+    /// Read member of any type through the member information
+    void ReadGeneratedMember(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr);
+
 protected:
     virtual bool ReadBool(void) override;
     virtual char ReadChar(void) override;
@@ -337,6 +398,10 @@ private:
     bool HaveMoreElements(void);
     void UnexpectedMember(TLongTag tag, const CItemsInfo& items);
     void UnexpectedByte(TByte byte);
+    bool x_BeginGeneratedValue(const CMemberInfo* memberInfo,
+                               TObjectPtr classPtr);
+    void x_EndGeneratedValue(const CMemberInfo* memberInfo,
+                             TObjectPtr classPtr);
     void GetTagPattern(vector<int>& pattern, size_t max_length);
 
     friend class CObjectOStreamAsnBinary;
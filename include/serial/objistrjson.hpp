@@ -116,6 +116,20 @@ public:
     ///   Formatting type
     void SetBinaryDataFormat(EBinaryDataFormat fmt);
 
+    /// Enable or disable block scanning of the input.
+    /// When enabled, runs of unescaped string characters and numbers
+    /// are located in the input buffer 16 bytes at a time and consumed
+    /// at once, instead of one character at a time.
+    /// The default is taken from SERIAL_JSON_FAST_SCAN parameter.
+    void SetFastScan(bool set = true)
+    {
+        m_FastScan = set;
+    }
+    bool GetFastScan(void) const
+    {
+        return m_FastScan;
+    }
+
     virtual string ReadFileHeader(void) override;
 
 protected:
@@ -226,6 +240,9 @@ private:
     void x_ReadData(string& data, EStringType type = eStringTypeUTF8);
     bool x_ReadDataAndCheck(string& data, EStringType type = eStringTypeUTF8);
     void   x_SkipData(void);
+    bool x_CanScanPlain(EStringType type) const;
+    size_t x_ScanPlainChars(bool quoted);
+    bool x_ReadPlainInteger(Uint8& value, bool is_signed, bool& negative);
     string ReadKey(void);
     string ReadValue(EStringType type = eStringTypeVisible);
 
@@ -247,6 +264,7 @@ private:
     string m_LastTag;
     string m_RejectedTag;
     EBinaryDataFormat m_BinaryFormat;
+    bool m_FastScan;
     CStringUTF8 m_Utf8Buf;
     CStringUTF8::const_iterator m_Utf8Pos;
 };
@@ -605,6 +605,10 @@ public:
         size_t GetLength(void) const;
 
         void Write(const void* bytes, size_t length);
+        /// Write bytes which stay valid and unchanged until the output
+        /// is written out; the stream may refer to them instead of
+        /// copying (see CScatterGatherBuffer)
+        void WriteExternal(const void* bytes, size_t length);
 
         void End(void);
 
@@ -741,6 +745,8 @@ public:
     virtual void BeginBytes(const ByteBlock& block);
     virtual void WriteBytes(const ByteBlock& block,
                             const char* bytes, size_t length) = 0;
+    virtual void WriteExternalBytes(const ByteBlock& block,
+                                    const char* bytes, size_t length);
     virtual void EndBytes(const ByteBlock& block);
 
     // write char blocks
@@ -767,6 +773,7 @@ public:
 protected:
     CObjectOStream(ESerialDataFormat format,
                    CNcbiOstream& out, EOwnership deleteOut = eNoOwnership);
+    CObjectOStream(ESerialDataFormat format, CScatterGatherBuffer& out);
 
     // low level writers
     typedef size_t TObjectIndex;
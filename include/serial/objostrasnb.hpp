@@ -95,6 +95,21 @@ public:
                             EOwnership deleteOut,
                             EFixNonPrint how = eFNP_Default);
 
+    /// Constructor.
+    ///
+    /// Collect the encoded data in scatter/gather buffer. Large OCTET
+    /// STRING values are not copied, the buffer refers to the data of
+    /// the serialized objects, so the objects must stay unchanged until
+    /// the buffer is written out.
+    ///
+    /// @param out
+    ///   Output buffer
+    /// @param how
+    ///   Defines how to fix unprintable characters in ASN VisiableString
+    /// @sa CScatterGatherBuffer
+    CObjectOStreamAsnBinary(CScatterGatherBuffer& out,
+                            EFixNonPrint how = eFNP_Default);
+
 
     /// Destructor.
     virtual ~CObjectOStreamAsnBinary(void);
@@ -129,10 +144,55 @@ public:
         return m_CStyleBigInt;
     }
 
+    /// Enable or disable the type-specialized class writers generated
+    /// by datatool (see CClassTypeInfo::SetAsnBinaryFunctions).
+    /// The default is taken from SERIAL_USE_GENERATED_ASNB parameter.
+    void SetUseGeneratedCode(bool set = true)
+    {
+        m_UseGeneratedCode = set;
+    }
+    bool GetUseGeneratedCode(void) const
+    {
+        return m_UseGeneratedCode;
+    }
+
+    // Interface used by the generated class writers.
+    /// Write sequential class using its generated writer if the stream
+    /// state allows it, or using its type information otherwise
+    void WriteGeneratedClass(const CClassTypeInfo* classType,
+                             TConstObjectPtr classPtr);
+
+    /// Write member of a standard type directly. Unset members, members
+    /// with hooks and other special cases are written through
+    /// the member information.
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr, bool data);
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr, Int4 data);
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr, Uint4 data);
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr, Int8 data);
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr, Uint8 data);
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr, double data);
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr, const string& data);
+    template<class T>
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr, const T& /*data*/)
+    {
+        WriteGeneratedMember(memberInfo, classPtr);
+    }
+    /// Write member of any type through the member information
+    void WriteGeneratedMember(const CMemberInfo* memberInfo,
+                              TConstObjectPtr classPtr);
+
 private:
     void WriteByte(Uint1 byte);
     template<typename T> void WriteBytesOf(const T& value, size_t count);
-    void WriteBytes(const char* bytes, size_t size);
+    void WriteBytes(const char* bytes, size_t size, bool external = false);
     void WriteShortTag(ETagClass tag_class, 
                        ETagConstructed tag_constructed,
                        ETagValue tag_value);
@@ -220,6 +280,8 @@ protected:
     virtual void BeginBytes(const ByteBlock& block) override;
     virtual void WriteBytes(const ByteBlock& block,
                             const char* bytes, size_t length) override;
+    virtual void WriteExternalBytes(const ByteBlock& block,
+                                    const char* bytes, size_t length) override;
 
     virtual void BeginChars(const CharBlock& block) override;
     virtual void WriteChars(const CharBlock& block,
@@ -234,6 +296,8 @@ private:
     void WriteNumberValue(Int8 data);
     void WriteNumberValue(Uint4 data);
     void WriteNumberValue(Uint8 data);
+    bool x_BeginGeneratedValue(const CMemberInfo* memberInfo,
+                               TConstObjectPtr classPtr);
 
 #if CHECK_OUTSTREAM_INTEGRITY
     Int8 m_CurrentPosition;
@@ -260,6 +324,7 @@ private:
     bool m_CStyleBigInt;
     bool m_SkipNextTag;
     bool m_AutomaticTagging;
+    bool m_UseGeneratedCode;
 };
 
 
@@ -71,6 +71,8 @@ class CObjectInfoCV;
 class CObjectInfoMI;
 class CReadClassMemberHook;
 class CReadChoiceVariantHook;
+class CObjectIStreamAsnBinary;
+class CObjectOStreamAsnBinary;
 
 // enum for choice classes generated by datatool
 enum EResetVariant {
@@ -351,7 +351,8 @@ public:
             , m_MaxParserThreads (16)
             , m_MaxTotalRawSize  (16 * 1024 * 1024)
             , m_MinRawBufferSize (128 * 1024)
-            , m_SameThread(false) {
+            , m_SameThread(false)
+            , m_Pipeline(false) {
         }
 
         /// Filter by member index
@@ -395,12 +396,27 @@ public:
             m_SameThread = same_thread;  return *this;
         }
 
+        /// Pipeline mode: the reader thread splits the input into raw data
+        /// buffers and immediately hands each of them to a parsing thread,
+        /// so that reading, parsing and consuming the objects all overlap.
+        /// Parsed objects are still delivered in the input order.
+        /// MaxTotalRawSize then limits the total size of raw data buffers
+        /// which are read but not yet consumed by the caller, including
+        /// those being parsed or waiting for the caller (zero means no
+        /// limit), and MaxParserThreads limits the number of such buffers.
+        /// @note
+        ///  ReadAndSkipInTheSameThread is ignored in this mode.
+        CParams& Pipeline(bool pipeline) {
+            m_Pipeline = pipeline;  return *this;
+        }
+
     private:
         launch    m_ThreadPolicy;
         unsigned  m_MaxParserThreads;
         size_t    m_MaxTotalRawSize;
         size_t    m_MinRawBufferSize;
         bool      m_SameThread;
+        bool      m_Pipeline;
 
         template<typename...> friend class CObjectIStreamAsyncIterator;
     };
@@ -1208,8 +1224,11 @@ private:
 
         void x_UpdateObjectsQueue();
         void x_UpdateFuturesQueue();
+        void x_GetNextObjects(void);
         CRef< CByteSource > x_GetNextData(void);
+        CRef< CByteSource > x_SplitNextData(size_t& size);
         void x_ReaderThread(void);
+        void x_PipelineThread(void);
 
         TObjectsQueue m_ObjectsQueue; // current queue of objects
         TObjectsQueue m_GarbageQueue; // popped so-far from objects-queue
@@ -1222,8 +1241,10 @@ private:
         size_t          m_RawBufferSize;
         size_t          m_MaxRawSize;
         size_t          m_CurrentRawSize;
+        size_t          m_DeliveredRawSize; // raw size of m_ObjectsQueue
         launch          m_Policy;
         bool            m_EndOfData;
+        bool            m_Pipeline;
         CParams         m_Params;
 
         mutex                        m_ReaderMutex;
@@ -1231,6 +1252,8 @@ private:
         thread                       m_Reader;
         queue< CRef< CByteSource > > m_ReaderData;
         queue< size_t >              m_ReaderDataSize;
+        queue< size_t >              m_FuturesSize;   // pipeline mode
+        TObjectsQueue                m_ReaderGarbage; // pipeline mode
     };
     shared_ptr<CData> m_Data;
 };
@@ -1425,13 +1448,20 @@ CObjectIStreamAsyncIterator<TRoot>::CData::CData(
     , m_Parser(parser) 
     , m_ParserCount(   params.m_MaxParserThreads != 0 ? params.m_MaxParserThreads : 16)
     , m_RawBufferSize( params.m_MinRawBufferSize)
-    , m_MaxRawSize(    params.m_SameThread ? 0 : params.m_MaxTotalRawSize)
+    , m_MaxRawSize(    params.m_SameThread && !params.m_Pipeline ? 0 : params.m_MaxTotalRawSize)
     , m_CurrentRawSize(0)
+    , m_DeliveredRawSize(0)
     , m_Policy(params.m_ThreadPolicy)
     , m_EndOfData(m_Istr->EndOfData())
+    , m_Pipeline(params.m_Pipeline)
     , m_Params(params)
 {
-    if (m_MaxRawSize != 0 && !m_EndOfData) {
+    if (m_Pipeline && !m_EndOfData) {
+        m_Reader = thread(
+            mem_fun<void, CObjectIStreamAsyncIterator<TRoot>::CData >(
+                &CObjectIStreamAsyncIterator<TRoot>::CData::x_PipelineThread), this);
+    }
+    else if (m_MaxRawSize != 0 && !m_EndOfData) {
         m_Reader = thread(
             mem_fun<void, CObjectIStreamAsyncIterator<TRoot>::CData >(
                 &CObjectIStreamAsyncIterator<TRoot>::CData::x_ReaderThread), this);
@@ -1441,7 +1471,10 @@ CObjectIStreamAsyncIterator<TRoot>::CData::CData(
 template<typename TRoot>
 CObjectIStreamAsyncIterator<TRoot>::CData::~CData() {
     if (m_Reader.joinable()) {
-        m_EndOfData = true;
+        {
+            unique_lock<mutex> lck(m_ReaderMutex);
+            m_EndOfData = true;
+        }
         m_ReaderCv.notify_all();
         m_Reader.join();
     }
@@ -1476,6 +1509,13 @@ CObjectIStreamAsyncIterator<TRoot>::CData::x_UpdateObjectsQueue()
         m_ObjectsQueue.pop();
     }
 
+    if (m_Pipeline) {
+        if (m_ObjectsQueue.empty() && !m_EndOfData) {
+            x_GetNextObjects();
+        }
+        return;
+    }
+
     // unpack the next objects-queue from futures-queue if empty
     if(    m_ObjectsQueue.empty() 
         && !m_FuturesQueue.empty()) 
@@ -1489,6 +1529,10 @@ template<typename TRoot>
 void
 CObjectIStreamAsyncIterator<TRoot>::CData::x_UpdateFuturesQueue()
 {
+    // in pipeline mode parsing is started by the reader thread
+    if (m_Pipeline) {
+        return;
+    }
     // nothing to deserialize, or already full
     if( m_FuturesQueue.size() >= m_ParserCount) {
         return;
@@ -1529,6 +1573,44 @@ CObjectIStreamAsyncIterator<TRoot>::CData::x_UpdateFuturesQueue()
         data,  m_Istr->GetDataFormat(), m_Params, move(tmp_garbage_queue)));
 }
 
+// Pipeline mode: take the objects parsed from the next raw data buffer.
+// The previous buffer has been consumed completely by now, so its raw size
+// is returned to the reader, and the consumed objects are handed over
+// to the next parsing task for destruction.
+template<typename TRoot>
+void
+CObjectIStreamAsyncIterator<TRoot>::CData::x_GetNextObjects(void)
+{
+    future_queue_t next;
+    {
+        unique_lock<mutex> lck(m_ReaderMutex);
+        m_CurrentRawSize -= m_DeliveredRawSize;
+        m_DeliveredRawSize = 0;
+        if (m_ReaderGarbage.empty()) {
+            swap(m_ReaderGarbage, m_GarbageQueue);
+        } else {
+            for ( ; !m_GarbageQueue.empty(); m_GarbageQueue.pop()) {
+                m_ReaderGarbage.push(m_GarbageQueue.front());
+            }
+        }
+        m_ReaderCv.notify_all();
+        while (m_FuturesQueue.empty()) {
+            m_ReaderCv.wait(lck);
+        }
+        next = move(m_FuturesQueue.front());
+        m_FuturesQueue.pop();
+        m_DeliveredRawSize = m_FuturesSize.front();
+        m_FuturesSize.pop();
+        m_ReaderCv.notify_all();
+    }
+    if (!next.valid()) {
+        // end of data
+        m_EndOfData = true;
+        return;
+    }
+    m_ObjectsQueue = next.get();
+}
+
 template<typename TRoot>
 CRef< CByteSource >
 CObjectIStreamAsyncIterator<TRoot>::CData::x_GetNextData(void)
@@ -1560,26 +1642,36 @@ CObjectIStreamAsyncIterator<TRoot>::CData::x_GetNextData(void)
     return data;
 }
 
+// Reader thread: skip over some objects in stream without parsing,
+// up to buffer_size. Format errors are left to the parser,
+// which gets the data up to the error.
+template<typename TRoot>
+CRef< CByteSource >
+CObjectIStreamAsyncIterator<TRoot>::CData::x_SplitNextData(size_t& size)
+{
+    const CNcbiStreampos startpos = m_Istr->GetStreamPos();
+    const CNcbiStreampos endpos = 
+        startpos  + (CNcbiStreampos)(m_RawBufferSize);
+
+    CStreamDelayBufferGuard guard(*(m_Istr));
+    try {
+        do {
+            m_Istr->SkipAnyContentObject();
+        } while( !m_Istr->EndOfData() && m_Istr->GetStreamPos() < endpos);
+    } catch (...) {
+    }
+
+    size = m_Istr->GetStreamPos() - startpos;
+    return guard.EndDelayBuffer();
+}
+
 template<typename TRoot>
 void
 CObjectIStreamAsyncIterator<TRoot>::CData::x_ReaderThread(void)
 {
-    // Skip over some objects in stream without parsing, up to buffer_size.
     while (!m_Istr->EndOfData()) {
-        const CNcbiStreampos startpos = m_Istr->GetStreamPos();
-        const CNcbiStreampos endpos = 
-            startpos  + (CNcbiStreampos)(m_RawBufferSize);
-
-        CStreamDelayBufferGuard guard(*(m_Istr));
-        try {
-            do {
-                m_Istr->SkipAnyContentObject();
-            } while( !m_Istr->EndOfData() && m_Istr->GetStreamPos() < endpos);
-        } catch (...) {
-        }
-
-        size_t this_buffer_size = m_Istr->GetStreamPos() - startpos;
-        CRef< CByteSource > data = guard.EndDelayBuffer();
+        size_t this_buffer_size = 0;
+        CRef< CByteSource > data = x_SplitNextData(this_buffer_size);
         {
             unique_lock<mutex> lck(m_ReaderMutex);
             // make sure we do not consume too much memory
@@ -1603,6 +1695,41 @@ CObjectIStreamAsyncIterator<TRoot>::CData::x_ReaderThread(void)
     m_ReaderCv.notify_one();
 }
 
+template<typename TRoot>
+void
+CObjectIStreamAsyncIterator<TRoot>::CData::x_PipelineThread(void)
+{
+    const ESerialDataFormat format = m_Istr->GetDataFormat();
+    while (!m_Istr->EndOfData()) {
+        size_t this_buffer_size = 0;
+        CRef< CByteSource > data = x_SplitNextData(this_buffer_size);
+
+        unique_lock<mutex> lck(m_ReaderMutex);
+        // wait until there is room in the window
+        while (!m_EndOfData &&
+               (m_FuturesQueue.size() >= m_ParserCount ||
+                (m_MaxRawSize != 0 && m_CurrentRawSize >= m_MaxRawSize))) {
+            m_ReaderCv.wait(lck);
+        }
+        if (m_EndOfData) {
+            return;
+        }
+        // start parsing; the futures queue keeps the input order
+        TObjectsQueue tmp_garbage_queue;
+        swap(m_ReaderGarbage, tmp_garbage_queue);
+        m_FuturesQueue.push( async( m_Policy, m_Parser,
+            data,  format, m_Params, move(tmp_garbage_queue)));
+        m_FuturesSize.push( this_buffer_size);
+        m_CurrentRawSize += this_buffer_size;
+        m_ReaderCv.notify_all();
+    }
+    m_ReaderMutex.lock();
+    m_FuturesQueue.push( future_queue_t());
+    m_FuturesSize.push(0);
+    m_ReaderMutex.unlock();
+    m_ReaderCv.notify_all();
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 ///  CObjectIStreamAsyncIterator<TRoot,TChild> implementation
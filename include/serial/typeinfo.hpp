@@ -229,6 +229,11 @@ public:
     void SetPathCopyHook(CObjectStreamCopier* copier, const string& path,
                          CCopyObjectHook* hook);
 
+    /// Check if any (global, local or context-specific) read hook is set
+    bool HaveReadHooks(void) const;
+    /// Check if any (global, local or context-specific) write hook is set
+    bool HaveWriteHooks(void) const;
+
     // default methods without checking hook
     void DefaultReadData(CObjectIStream& in, TObjectPtr object) const;
     void DefaultWriteData(CObjectOStream& out, TConstObjectPtr object) const;
@@ -94,7 +94,12 @@ protected:
         /// options related to alignment.
         eMurmurHash2_32,  ///< MurmurHash2 for x86, 32-bit result.
         eMurmurHash2_64,  ///< MurmurHash2 for x64, 64-bit result.
-        eMurmurHash3_32   ///< MurmurHash3 for x86, 32-bit result.
+        eMurmurHash3_32,  ///< MurmurHash3 for x86, 32-bit result.
+
+        /// xxHash3 results are stable since xxHash 0.8.0, do not depend
+        /// on the platform, and can be used for persistent storage.
+        eXXH3_64,     ///< xxHash3 (XXH3_64bits), 64-bit result.
+        eXXH3_128     ///< xxHash3 (XXH3_128bits), 128-bit result.
     };
 
 public:
@@ -111,7 +116,7 @@ public:
     /// @sa GetMethod, GetBits 
     size_t GetSize(void) const;
 
-    /// Return size of checksum/hash in bits (32, 64).
+    /// Return size of checksum/hash in bits (32, 64, 128).
     /// @sa GetSize
     size_t GetBits(void) const;
 
@@ -120,9 +125,13 @@ public:
     Uint4 GetResult32(void) const;
     
     /// Return calculated result.
-    /// @attention Only valid in 64-bit modes, like: CityHash64, FarmHash64.
+    /// @attention Only valid in 64-bit modes, like: CityHash64, FarmHash64, XXH3_64.
     Uint8 GetResult64(void) const;
 
+    /// Return calculated result.
+    /// @attention Only valid in 128-bit mode: XXH3_128.
+    void GetResult128(Uint8& high, Uint8& low) const;
+
     /// Return string with checksum/hash in hexadecimal form.
     string GetResultHex(void) const;
 
@@ -154,6 +163,7 @@ protected:
         Uint4 v32;   ///< Used to store 32-bit results
         Uint8 v64;   ///< Used to store 64-bit results
         CMD5* md5;   ///< Used for MD5 calculation
+        void* xxh3;  ///< Used for xxHash3 calculation (XXH3_state_t)
     } m_Value;
 
     /// Update current control sum with data provided.
@@ -162,6 +172,10 @@ protected:
     void x_Reset(EMethodDef method);
     /// Cleanup (used in destructor and assignment operator).
     void x_Free(void);
+    /// Copy the state of MD5 and xxHash3 methods.
+    void x_Copy(const CChecksumBase& other);
+    /// Get 64-bit xxHash3 result.
+    Uint8 x_GetResultXXH3_64(void) const;
 };
 
 
@@ -210,6 +224,8 @@ public:
         eMurmurHash2_32 = CChecksumBase::eMurmurHash2_32,
         eMurmurHash2_64 = CChecksumBase::eMurmurHash2_64,
         eMurmurHash3_32 = CChecksumBase::eMurmurHash3_32,
+        eXXH3_64        = CChecksumBase::eXXH3_64,
+        eXXH3_128       = CChecksumBase::eXXH3_128,
         eDefault        = eCityHash64
     };
 
@@ -283,6 +299,10 @@ public:
     /// MurmurHash2 for x64, 64-bit result.
     static Uint4 MurmurHash3_x86_32(const CTempString str, Uint4 seed = 0);
     static Uint4 MurmurHash3_x86_32(const char* str, size_t len, Uint4 seed = 0);
+
+    /// xxHash3 (XXH3_64bits)
+    static Uint8 XXHash3_64(const CTempString str, Uint8 seed = 0);
+    static Uint8 XXHash3_64(const char* str, size_t len, Uint8 seed = 0);
 };
 
 
@@ -311,6 +331,8 @@ public:
         eCRC32C      = CChecksumBase::eCRC32C,
         eAdler32     = CChecksumBase::eAdler32,
         eMD5         = CChecksumBase::eMD5,
+        eXXH3_64     = CChecksumBase::eXXH3_64,
+        eXXH3_128    = CChecksumBase::eXXH3_128,
         eDefault     = eCRC32
     };
     enum {
@@ -336,7 +358,8 @@ public:
 
     /// Return calculated checksum.
     /// @attention
-    ///   Valid for all methods except MD5, please use GetMD5Digest() instead.
+    ///   Valid for 32-bit methods only. Please use GetMD5Digest() for MD5,
+    ///   GetResult64() and GetResult128() for xxHash3.
     /// @sa GetMD5Digest
     Uint4 GetChecksum(void) const {
         return GetResult32();
@@ -360,6 +383,22 @@ public:
     void AddLine(const string& line);
     void NextLine(void);
 
+    /// Update many independent checksums at once.
+    ///
+    /// The result is the same as calling checksums[i]->AddChars() with
+    /// data[i] for each i, but the buffers are processed in parallel
+    /// where possible: MD5 uses SIMD to hash 4 buffers at a time,
+    /// CRC32C interleaves hardware CRC instructions for 3 buffers.
+    /// Other methods are updated one by one. Each checksum object
+    /// may be listed only once.
+    /// @param checksums
+    ///   Checksums to update, methods may differ.
+    /// @param data
+    ///   Data to add, one buffer per checksum.
+    /// @param count
+    ///   Number of checksums.
+    static void AddCharsBatch(CChecksum* const checksums[], const CTempString data[], size_t count);
+
     /// Update checksum with the file data.
     /// On error an exception will be thrown, and the checksum not change.
     void AddFile(const string& file_path);
@@ -482,10 +521,12 @@ size_t CChecksumBase::GetSize(void) const
 {
     switch ( m_Method ) {
     case eMD5:  
+    case eXXH3_128:
         return 16;
     case eFarmHash64:
     case eCityHash64:
     case eMurmurHash2_64:
+    case eXXH3_64:
         return 8;
     default:
         return 4;
@@ -551,21 +592,14 @@ Uint8 CChecksumBase::GetResult64(void) const
     case eFarmHash64:
     case eMurmurHash2_64:
         return m_Value.v64;
+    case eXXH3_64:
+        return x_GetResultXXH3_64();
     default:
         _ASSERT(0);
         return 0;
     }
 }
 
-inline
-void CChecksumBase::x_Free(void)
-{
-    if ( m_Method == eMD5 ) {
-        delete m_Value.md5;
-        m_Value.md5 = NULL;
-    }
-}
-
 inline
 void CHash::Calculate(const CTempString str)
 {
@@ -44,12 +44,15 @@
 ///     MCompress_Zip,      MDecompress_Zip
 ///     MCompress_GZipFile, MDecompress_GZipFile,
 ///                         MDecompress_ConcatenatedGZipFile
+///     MCompress_Zstd,     MDecompress_Zstd
 
 
 #include <util/compress/stream.hpp>
 #include <util/compress/bzip2.hpp>
 #include <util/compress/zlib.hpp>
+#include <util/compress/zlib_mt.hpp>
 #include <util/compress/lzo.hpp>
+#include <util/compress/zstd.hpp>
 
 
 /** @addtogroup CompressionStreams
@@ -83,12 +86,18 @@ public:
     ///   to the original input/output stream if you know in advance that
     ///   data is uncompressed. 
     enum EMethod {
-        eNone,                ///< no compression method (copy "as is")
-        eBZip2,               ///< BZIP2
-        eLZO,                 ///< LZO (LZO1X)
-        eZip,                 ///< ZLIB (raw zip data / DEFLATE method)
-        eGZipFile,            ///< .gz file (including concatenated files)
-        eConcatenatedGZipFile ///< Synonym for eGZipFile (for backward compatibility)
+        eNone,                 ///< no compression method (copy "as is")
+        eBZip2,                ///< BZIP2
+        eLZO,                  ///< LZO (LZO1X)
+        eZip,                  ///< ZLIB (raw zip data / DEFLATE method)
+        eGZipFile,             ///< .gz file (including concatenated files)
+        eConcatenatedGZipFile, ///< Synonym for eGZipFile (for backward compatibility)
+        eZstd,                 ///< Zstandard (including concatenated frames)
+        eGZipFileMT,           ///< .gz file, compressed by several threads
+                               ///< (decompression is single-threaded)
+        eBGZF                  ///< BGZF (blocked gzip) file, compressed by
+                               ///< several threads, see CBGZFReader to read
+                               ///< it in parallel
     };
 
     /// Default algorithm-specific compression/decompression flags.
@@ -439,11 +448,13 @@ class MCompress_Proxy_BZip2      {};
 class MCompress_Proxy_LZO        {};
 class MCompress_Proxy_Zip        {};
 class MCompress_Proxy_GZipFile   {};
+class MCompress_Proxy_Zstd       {};
 class MDecompress_Proxy_BZip2    {};
 class MDecompress_Proxy_LZO      {};
 class MDecompress_Proxy_Zip      {};
 class MDecompress_Proxy_GZipFile {};
 class MDecompress_Proxy_ConcatenatedGZipFile {};
+class MDecompress_Proxy_Zstd     {};
 
 
 /// Manipulator definitions.
@@ -452,11 +463,13 @@ class MDecompress_Proxy_ConcatenatedGZipFile {};
 #define  MCompress_LZO                     MCompress_Proxy_LZO()
 #define  MCompress_Zip                     MCompress_Proxy_Zip()
 #define  MCompress_GZipFile                MCompress_Proxy_GZipFile()
+#define  MCompress_Zstd                    MCompress_Proxy_Zstd()
 #define  MDecompress_BZip2                 MDecompress_Proxy_BZip2()
 #define  MDecompress_LZO                   MDecompress_Proxy_LZO()
 #define  MDecompress_Zip                   MDecompress_Proxy_Zip()
 #define  MDecompress_GZipFile              MDecompress_Proxy_GZipFile()
 #define  MDecompress_ConcatenatedGZipFile  MDecompress_Proxy_ConcatenatedGZipFile()
+#define  MDecompress_Zstd                  MDecompress_Proxy_Zstd()
 
 
 // When you pass an object of type M[Dec|C]ompress_Proxy_* to an
@@ -513,6 +526,18 @@ TCompressIProxy operator>>(istream& is, MCompress_Proxy_GZipFile const& /*obj*/)
     return TCompressIProxy(is, CCompressStream::eGZipFile);
 }
 
+inline
+TCompressOProxy operator<<(ostream& os, MCompress_Proxy_Zstd const& /*obj*/)
+{
+    return TCompressOProxy(os, CCompressStream::eZstd);
+}
+
+inline
+TCompressIProxy operator>>(istream& is, MCompress_Proxy_Zstd const& /*obj*/)
+{
+    return TCompressIProxy(is, CCompressStream::eZstd);
+}
+
 inline
 TDecompressOProxy operator<<(ostream& os, MDecompress_Proxy_BZip2 const& /*obj*/)
 {
@@ -573,6 +598,18 @@ TDecompressIProxy operator>>(istream& is, MDecompress_Proxy_ConcatenatedGZipFile
     return TDecompressIProxy(is, CCompressStream::eConcatenatedGZipFile);
 }
 
+inline
+TDecompressOProxy operator<<(ostream& os, MDecompress_Proxy_Zstd const& /*obj*/)
+{
+    return TDecompressOProxy(os, CCompressStream::eZstd);
+}
+
+inline
+TDecompressIProxy operator>>(istream& is, MDecompress_Proxy_Zstd const& /*obj*/)
+{
+    return TDecompressIProxy(is, CCompressStream::eZstd);
+}
+
 
 /* @} */
 
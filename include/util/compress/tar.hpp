@@ -51,6 +51,7 @@
 ///
 
 #include <corelib/ncbifile.hpp>
+#include <map>
 #include <utility>
 
 
@@ -278,6 +279,9 @@ NCBI_XUTIL_EXPORT ostream& operator << (ostream&, const CTarEntryInfo&);
 /// Forward declaration of a tar header used internally.
 struct STarHeader;
 
+/// Forward declaration of a file output queue used internally.
+class CTarWriteQueue;
+
 
 //////////////////////////////////////////////////////////////////////////////
 ///
@@ -385,6 +389,12 @@ public:
     /// Define a list of entries.
     typedef list<CTarEntryInfo> TEntries;
 
+    /// Define a member index:  entry name -> position of its header in the
+    /// archive (the last occurrence of the name, if updated).
+    /// @sa
+    ///   BuildIndex, ReadIndex, WriteIndex
+    typedef map<string, Uint8>  TIndex;
+
     /// Define a list of files with sizes (directories and specials, such as
     /// devices, must be given with sizes of 0;  symlinks -- with the sizes
     /// of the names they are linking to).
@@ -484,6 +494,21 @@ public:
     ///   SetMask, SetBaseDir
     unique_ptr<TEntries> Extract(void);
 
+    /// Extract a single entry found in the member index (into either current
+    /// directory or a directory otherwise specified by SetBaseDir()).
+    ///
+    /// The archive is positioned directly at the entry header, so no archive
+    /// scan is done.  That requires a positionable archive, that is either a
+    /// file archive, or an uncompressed seekable stream.  Extraction rules
+    /// are the same as for Extract(), yet the masks are not consulted.
+    /// @note PAX GNU/1.0 sparse files cannot be extracted this way.
+    /// @return
+    ///   A list (containing either this one entry or nothing) of entries that
+    ///   have been actually extracted.
+    /// @sa
+    ///   BuildIndex, ReadIndex, GetEntryData
+    unique_ptr<TEntries> Extract(const TIndex& index, const string& name);
+
     /// Get information about all matching archive entries.
     ///
     /// @return
@@ -503,6 +528,35 @@ public:
     void Test(void);
 
 
+    //------------------------------------------------------------------------
+    // Member index (random access)
+    //------------------------------------------------------------------------
+
+    /// Scan the archive once and build the index of all matching entries.
+    /// @sa
+    ///   SetMask, WriteIndex, Extract, GetEntryData
+    unique_ptr<TIndex> BuildIndex(void);
+
+    /// Save the index into a stream (one entry per line).
+    static void WriteIndex(const TIndex& index, CNcbiOstream& os);
+
+    /// Load an index previously saved with WriteIndex().
+    /// @return
+    ///   The index read in;  throw CTarException if the data are malformed.
+    static unique_ptr<TIndex> ReadIndex(CNcbiIstream& is);
+
+    /// Create and return an IReader for a single file entry found in the
+    /// member index.  The archive must be positionable (see Extract() above).
+    ///
+    /// The returned IReader is valid until the next archive operation, and
+    /// its ownership is passed to the caller, same as for GetNextEntryData().
+    /// @return
+    ///   Pointer to IReader, or 0 if no such entry, or it is not a file.
+    /// @sa
+    ///   BuildIndex, ReadIndex, GetNextEntryData
+    IReader* GetEntryData(const TIndex& index, const string& name);
+
+
     //------------------------------------------------------------------------
     // Utility functions
     //------------------------------------------------------------------------
@@ -516,6 +570,25 @@ public:
     /// Get current stream position.
     Uint8  GetCurrentPosition(void) const;
 
+    /// Get the number of threads used to write out files in Extract().
+    unsigned int GetThreads(void) const;
+
+    /// Set the number of threads used to write out files in Extract().
+    ///
+    /// With more than one thread, the archive gets read (and decompressed,
+    /// if it is a compression stream) in the calling thread, while the data
+    /// of regular files get written to disk by a pool of worker threads, and
+    /// the files get preallocated to their full sizes where supported.  The
+    /// amount of file data pending output is limited, so the memory usage
+    /// stays bounded regardless of the archive size.  File attributes are
+    /// restored after all their data have been written.
+    /// @param threads
+    ///   Number of threads (0 means the number of CPUs;  1, the default,
+    ///   means to extract sequentially in the calling thread).
+    /// @sa
+    ///   Extract
+    void SetThreads(unsigned int threads);
+
     /// Set name mask.
     ///
     /// The set of masks is used to process existing entries in the archive,
@@ -713,6 +786,7 @@ private:
 
     // Extract file data from the archive.
     void x_ExtractPlainFile (Uint8& size, const CDirEntry* dst);
+    void x_ExtractPlainFileMT(Uint8& size, const CDirEntry* dst);
     bool x_ExtractSparseFile(Uint8& size, const CDirEntry* dst,
                              bool dump = false);
 
@@ -725,6 +799,14 @@ private:
                         const CDirEntry*     path = 0,
                         TTarMode             perm = 0/*override*/) const;
 
+    // Restore attributes of the files, which have been completely written
+    // by worker threads (optionally waiting for all pending output first).
+    void x_FlushWrites(bool wait);
+
+    // Position the archive at the specified entry, and read its header in.
+    // Return false if there is no such entry in the index.
+    bool x_SeekEntry(const TIndex& index, const string& name);
+
     string x_ReadLine(Uint8& size, const char*& data, size_t& nread);
 
     // Read/write specified number of bytes from/to the archive.
@@ -761,6 +843,8 @@ private:
     TFlags        m_Flags;          ///< Bitwise OR of flags
     string        m_BaseDir;        ///< Base directory for relative paths
     CTarEntryInfo m_Current;        ///< Current entry being processed
+    unsigned int  m_Threads;        ///< Threads to write out extracted files
+    CTarWriteQueue* m_WriteQueue;   ///< File output queue (while extracting)
 
 private:
     // Prohibit assignment and copy
@@ -841,6 +925,12 @@ inline Uint8 CTar::GetCurrentPosition(void) const
     return m_StreamPos;
 }
 
+inline
+unsigned int CTar::GetThreads(void) const
+{
+    return m_Threads;
+}
+
 inline
 const string& CTar::GetBaseDir(void) const
 {
@@ -0,0 +1,401 @@
+#ifndef UTIL_COMPRESS__ZLIB_MT__HPP
+#define UTIL_COMPRESS__ZLIB_MT__HPP
+
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ */
+
+/// @file zlib_mt.hpp
+/// Multi-threaded zlib based compression: gzip and BGZF (blocked gzip).
+///
+/// CZipMTCompressor       - compressor that deflates blocks of data in
+///                          parallel and writes a single standard gzip
+///                          file (pigz-style), readable by any gzip tool.
+/// CZipMTStreamCompressor - stream processor for CZipMTCompressor.
+/// CBGZFCompressor        - compressor that writes BGZF files: a series of
+///                          independent gzip members of up to 64KB each,
+///                          compressed in parallel.
+/// CBGZFStreamCompressor  - stream processor for CBGZFCompressor.
+/// CBGZFIndex             - virtual offsets index of a BGZF file,
+///                          compatible with .gzi files written by bgzip.
+/// CBGZFReader            - IReader that decompresses BGZF blocks in parallel
+///                          and can seek to any (virtual) offset.
+///
+/// Both formats can be decompressed with CZipStreamDecompressor and
+/// CZipCompression::fGZip flags, or with any gzip utility.
+/// The BGZF format is described in the SAM/BAM specification:
+///     https://samtools.github.io/hts-specs/SAMv1.pdf
+
+#include <util/compress/zlib.hpp>
+#include <corelib/reader_writer.hpp>
+
+/** @addtogroup Compression
+ *
+ * @{
+ */
+
+BEGIN_NCBI_SCOPE
+
+
+class CZipMTEngine;
+class CBGZFReaderImpl;
+
+/// Default size of the data block compressed by one thread.
+const size_t kZipMTDefaultBlockSize = 128*1024;
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CZipMTCompressor -- multi-threaded gzip compressor
+///
+/// Input data is split into blocks of the specified size, and blocks are
+/// compressed by several threads at once. Each block uses the last 32KB
+/// of the previous data as a preset dictionary, so compression ratio is
+/// close to the single-threaded one. The output is a single gzip member
+/// with a standard header and footer, fWriteGZipFormat is always assumed.
+/// Decompression is single-threaded, use CZipDecompressor with fGZip flags.
+///
+/// Used in CZipMTStreamCompressor.
+/// @sa CZipMTStreamCompressor, CZipCompressor, CBGZFCompressor
+
+class NCBI_XUTIL_EXPORT CZipMTCompressor : public CZipCompression,
+                                           public CCompressionProcessor
+{
+public:
+    /// Constructor.
+    /// @param level
+    ///   Compression level.
+    /// @param threads
+    ///   Number of compression threads, 0 means the number of CPUs.
+    ///   With 1 thread all data is compressed in the calling thread.
+    /// @param block_size
+    ///   Size of the data block compressed by one thread.
+    /// @param flags
+    ///   Compression flags, only fAllowEmptyData is used.
+    CZipMTCompressor(
+        ELevel       level      = eLevel_Default,
+        unsigned int threads    = 0,
+        size_t       block_size = kZipMTDefaultBlockSize,
+        TZipFlags    flags      = 0
+    );
+    /// Destructor.
+    virtual ~CZipMTCompressor(void);
+
+    /// Set information about compressed file, stored in the gzip header.
+    void SetFileInfo(const SFileInfo& info);
+
+    /// Get number of compression threads.
+    unsigned int GetThreads(void) const { return m_Threads; }
+
+protected:
+    virtual EStatus Init   (void);
+    virtual EStatus Process(const char* in_buf,  size_t  in_len,
+                            char*       out_buf, size_t  out_size,
+                            /* out */            size_t* in_avail,
+                            /* out */            size_t* out_avail);
+    virtual EStatus Flush  (char*       out_buf, size_t  out_size,
+                            /* out */            size_t* out_avail);
+    virtual EStatus Finish (char*       out_buf, size_t  out_size,
+                            /* out */            size_t* out_avail);
+    virtual EStatus End    (int abandon = 0);
+
+private:
+    unsigned int          m_Threads;    ///< Number of compression threads.
+    size_t                m_BlockSize;  ///< Size of the block for one thread.
+    SFileInfo             m_FileInfo;   ///< Compressed file info.
+    bool                  m_NeedWriteHeader;
+                                        ///< Is true if needed to write a file header.
+    unique_ptr<CZipMTEngine> m_Engine;  ///< Parallel compression engine.
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CBGZFIndex -- index of blocks in BGZF file
+///
+/// Keeps compressed and uncompressed offsets of each data block, so any
+/// uncompressed offset can be converted to a BGZF virtual offset, and data
+/// can be read starting from it. BGZF virtual offset is a 64-bit value,
+/// that keeps the file offset of the block start in upper 48 bits, and
+/// the offset of data in the uncompressed block in lower 16 bits.
+/// Index can be collected by CBGZFCompressor while compressing, built by
+/// scanning an existing BGZF file, or read from/written to .gzi file in
+/// the bgzip (htslib) format.
+///
+/// Throw CCompressionException on errors.
+/// @sa CBGZFCompressor, CBGZFReader
+
+class NCBI_XUTIL_EXPORT CBGZFIndex : public CObject
+{
+public:
+    /// BGZF virtual offset.
+    typedef Uint8 TVirtualOffset;
+
+    /// Block entry.
+    struct SBlock {
+        Uint8 compressed;    ///< Offset of the block in the BGZF file.
+        Uint8 uncompressed;  ///< Offset of the block data in uncompressed data.
+    };
+    typedef vector<SBlock> TBlocks;
+
+    /// Make virtual offset.
+    static TVirtualOffset MakeVirtualOffset(Uint8 block_offset,
+                                            size_t data_offset)
+        { return (block_offset << 16) | (data_offset & 0xFFFF); }
+    /// Get block offset from the virtual one.
+    static Uint8 GetBlockOffset(TVirtualOffset offset)
+        { return offset >> 16; }
+    /// Get data offset in the uncompressed block from the virtual one.
+    static size_t GetDataOffset(TVirtualOffset offset)
+        { return (size_t)(offset & 0xFFFF); }
+
+    /// Remove all entries.
+    void Clear(void) { m_Blocks.clear(); }
+    /// Add next block.
+    /// Blocks should be added in order of both offsets.
+    void AddBlock(Uint8 compressed, Uint8 uncompressed);
+    /// Get all blocks.
+    const TBlocks& GetBlocks(void) const { return m_Blocks; }
+
+    /// Convert uncompressed offset to the virtual offset.
+    /// Offsets past the end of data return offset in the last block.
+    TVirtualOffset GetVirtualOffset(Uint8 uncompressed) const;
+
+    /// Build index by scanning headers of all blocks in the BGZF file.
+    void Build(const string& bgzf_file);
+    /// Read .gzi index file (bgzip format).
+    void Read(const string& gzi_file);
+    /// Write .gzi index file (bgzip format).
+    void Write(const string& gzi_file) const;
+
+private:
+    TBlocks m_Blocks;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CBGZFCompressor -- multi-threaded BGZF compressor
+///
+/// Write BGZF file: input data split into blocks of 0xFF00 bytes, each
+/// block is compressed by a separate thread into an independent gzip member
+/// with the "BC" extra field that keeps size of the compressed block.
+/// Flush() closes current block. Finish() writes the standard empty EOF block.
+///
+/// Used in CBGZFStreamCompressor.
+/// @sa CBGZFStreamCompressor, CBGZFIndex, CBGZFReader
+
+class NCBI_XUTIL_EXPORT CBGZFCompressor : public CZipCompression,
+                                          public CCompressionProcessor
+{
+public:
+    /// Constructor.
+    /// @param level
+    ///   Compression level.
+    /// @param threads
+    ///   Number of compression threads, 0 means the number of CPUs.
+    ///   With 1 thread all data is compressed in the calling thread.
+    /// @param flags
+    ///   Compression flags, only fAllowEmptyData is used.
+    /// @param index
+    ///   If not NULL, collect offsets of all written blocks into it.
+    ///   The index is cleared on Init(), and should not be destroyed
+    ///   before the end of compression.
+    CBGZFCompressor(
+        ELevel       level   = eLevel_Default,
+        unsigned int threads = 0,
+        TZipFlags    flags   = 0,
+        CBGZFIndex*  index   = 0
+    );
+    /// Destructor.
+    virtual ~CBGZFCompressor(void);
+
+    /// Get number of compression threads.
+    unsigned int GetThreads(void) const { return m_Threads; }
+
+protected:
+    virtual EStatus Init   (void);
+    virtual EStatus Process(const char* in_buf,  size_t  in_len,
+                            char*       out_buf, size_t  out_size,
+                            /* out */            size_t* in_avail,
+                            /* out */            size_t* out_avail);
+    virtual EStatus Flush  (char*       out_buf, size_t  out_size,
+                            /* out */            size_t* out_avail);
+    virtual EStatus Finish (char*       out_buf, size_t  out_size,
+                            /* out */            size_t* out_avail);
+    virtual EStatus End    (int abandon = 0);
+
+private:
+    unsigned int          m_Threads;    ///< Number of compression threads.
+    CBGZFIndex*           m_Index;      ///< Index to collect block offsets.
+    unique_ptr<CZipMTEngine> m_Engine;  ///< Parallel compression engine.
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CBGZFReader -- multi-threaded BGZF file reader
+///
+/// Read compressed blocks from the BGZF file ahead and decompress them
+/// in parallel, return uncompressed data in order. Reading can be started
+/// at any virtual offset, or uncompressed offset if the index is set.
+/// Use CRStream to get an input stream.
+///
+/// Throw CCompressionException on open/seek errors, Read() returns
+/// eRW_Error on the broken data.
+/// @sa CBGZFIndex, CBGZFCompressor, CRStream
+
+class NCBI_XUTIL_EXPORT CBGZFReader : public IReader
+{
+public:
+    typedef CBGZFIndex::TVirtualOffset TVirtualOffset;
+
+    /// Constructor.
+    /// @param file_name
+    ///   BGZF file name.
+    /// @param threads
+    ///   Number of decompression threads, 0 means the number of CPUs.
+    ///   With 1 thread all data is decompressed in the calling thread.
+    CBGZFReader(const string& file_name, unsigned int threads = 0);
+    /// Destructor.
+    virtual ~CBGZFReader(void);
+
+    /// Set index, used to seek to uncompressed offsets.
+    void SetIndex(const CBGZFIndex& index);
+
+    /// Start reading from the specified virtual offset.
+    void Seek(TVirtualOffset offset);
+    /// Start reading from the specified offset in uncompressed data.
+    /// Build an index by scanning the file if it has not been set.
+    void SeekUncompressed(Uint8 offset);
+    /// Get virtual offset of the next byte to read.
+    TVirtualOffset Tell(void) const;
+
+    /// Get number of decompression threads.
+    unsigned int GetThreads(void) const;
+
+    // IReader interface
+    virtual ERW_Result Read(void* buf, size_t count, size_t* bytes_read = 0);
+    virtual ERW_Result PendingCount(size_t* count);
+
+private:
+    unique_ptr<CBGZFReaderImpl> m_Impl;
+
+private:
+    /// Private copy constructor to prohibit copy.
+    CBGZFReader(const CBGZFReader&);
+    /// Private assignment operator to prohibit assignment.
+    CBGZFReader& operator= (const CBGZFReader&);
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CZipMTStreamCompressor -- multi-threaded gzip compression stream processor
+///
+/// See util/compress/stream.hpp for details of stream processing.
+/// @sa CZipMTCompressor, CCompressionStreamProcessor
+
+class NCBI_XUTIL_EXPORT CZipMTStreamCompressor
+    : public CCompressionStreamProcessor
+{
+public:
+    /// Full constructor
+    CZipMTStreamCompressor(
+        CZipCompression::ELevel    level,
+        unsigned int               threads,
+        size_t                     block_size,
+        streamsize                 in_bufsize,
+        streamsize                 out_bufsize,
+        CZipCompression::TZipFlags flags = 0
+        )
+        : CCompressionStreamProcessor(
+              new CZipMTCompressor(level, threads, block_size, flags),
+              eDelete, in_bufsize, out_bufsize)
+    {}
+
+    /// Conventional constructor
+    CZipMTStreamCompressor(
+        CZipCompression::ELevel    level,
+        unsigned int               threads = 0,
+        CZipCompression::TZipFlags flags   = 0
+        )
+        : CCompressionStreamProcessor(
+              new CZipMTCompressor(level, threads, kZipMTDefaultBlockSize,
+                                   flags),
+              eDelete, kCompressionDefaultBufSize, kCompressionDefaultBufSize)
+    {}
+
+    /// Conventional constructor
+    CZipMTStreamCompressor(CZipCompression::TZipFlags flags = 0)
+        : CCompressionStreamProcessor(
+              new CZipMTCompressor(CZipCompression::eLevel_Default, 0,
+                                   kZipMTDefaultBlockSize, flags),
+              eDelete, kCompressionDefaultBufSize, kCompressionDefaultBufSize)
+    {}
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CBGZFStreamCompressor -- multi-threaded BGZF compression stream processor
+///
+/// See util/compress/stream.hpp for details of stream processing.
+/// @sa CBGZFCompressor, CCompressionStreamProcessor
+
+class NCBI_XUTIL_EXPORT CBGZFStreamCompressor
+    : public CCompressionStreamProcessor
+{
+public:
+    /// Conventional constructor
+    CBGZFStreamCompressor(
+        CZipCompression::ELevel    level,
+        unsigned int               threads = 0,
+        CZipCompression::TZipFlags flags   = 0,
+        CBGZFIndex*                index   = 0
+        )
+        : CCompressionStreamProcessor(
+              new CBGZFCompressor(level, threads, flags, index),
+              eDelete, kCompressionDefaultBufSize, kCompressionDefaultBufSize)
+    {}
+
+    /// Conventional constructor
+    CBGZFStreamCompressor(CZipCompression::TZipFlags flags = 0)
+        : CCompressionStreamProcessor(
+              new CBGZFCompressor(CZipCompression::eLevel_Default, 0, flags),
+              eDelete, kCompressionDefaultBufSize, kCompressionDefaultBufSize)
+    {}
+};
+
+
+END_NCBI_SCOPE
+
+
+/* @} */
+
+#endif  /* UTIL_COMPRESS__ZLIB_MT__HPP */
@@ -0,0 +1,661 @@
+#ifndef UTIL_COMPRESS__ZSTD__HPP
+#define UTIL_COMPRESS__ZSTD__HPP
+
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ */
+
+/// @file zstd.hpp
+/// Zstandard Compression API.
+///
+/// Zstandard (zstd) is a fast lossless compression algorithm, targeting
+/// real-time compression scenarios at zlib-level and better compression
+/// ratios. It is backed by a very fast entropy stage and decompresses
+/// much faster than zlib at any compression level.
+///
+/// Zstandard also offers a special mode for small data, called dictionary
+/// compression. A dictionary can be trained on a set of samples of data
+/// of the same kind (many small ASN.1 blobs, for example), and used later
+/// to compress each of them separately with a much better ratio than
+/// without a dictionary. The same dictionary must be used to decompress
+/// the data.
+///
+/// CZstdDictionary         - trained or prebuilt compression dictionary.
+/// CZstdCompression        - base methods for compression/decompression
+///                           memory buffers and files.
+/// CZstdCompressionFile    - allow read/write operations on files
+///                           in zstd format (.zst).
+/// CZstdCompressor         - zstd based compressor
+///                           (used in CZstdStreamCompressor).
+/// CZstdDecompressor       - zstd based decompressor
+///                           (used in CZstdStreamDecompressor).
+/// CZstdStreamCompressor   - zstd based compression stream processor
+///                           (see util/compress/stream.hpp for details).
+/// CZstdStreamDecompressor - zstd based decompression stream processor
+///                           (see util/compress/stream.hpp for details).
+///
+/// For more details see Zstandard documentation:
+///    https://facebook.github.io/zstd/
+
+
+#include <corelib/ncbimtx.hpp>
+#include <util/compress/stream.hpp>
+
+#if defined(HAVE_LIBZSTD)
+
+/** @addtogroup Compression
+ *
+ * @{
+ */
+
+BEGIN_NCBI_SCOPE
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Special compression parameters:
+//
+// <workers>
+//    Number of threads used to compress data. Zero value means that
+//    compression runs in the calling thread. Any other value spawns the
+//    specified number of background threads, and data is compressed in
+//    parallel; this is useful for big data only, and does not change
+//    the compressed data format. Decompression is always single-threaded.
+//    If the zstd library was built without multi-threading support,
+//    this parameter is ignored.
+//
+// <dictionary>
+//    See CZstdDictionary.
+//
+
+/// Default maximum size of the trained dictionary (~110Kb).
+/// The same value is used by the zstd command line tool.
+const size_t kZstdDefaultDictSize = 112640;
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CZstdDictionary --
+///
+/// Compression dictionary. It can be trained on a set of samples
+/// (see Train()), or loaded from memory, for example if it was trained
+/// earlier with the zstd command line tool and stored in a file.
+///
+/// The dictionary is immutable and can be shared between any number of
+/// compressors/decompressors in different threads. Internal digested
+/// representations of the dictionary are created on first use and cached.
+///
+/// @sa CZstdCompression::SetDictionary
+
+class NCBI_XUTIL_EXPORT CZstdDictionary : public CObject
+{
+public:
+    /// Create dictionary from memory.
+    /// @param data
+    ///   Dictionary content. It can be a dictionary trained by Train()
+    ///   or "zstd --train", or any raw content, that is used as a prefix
+    ///   for compressed data.
+    /// @param size
+    ///   Size of the dictionary content.
+    CZstdDictionary(const void* data, size_t size);
+
+    /// Create dictionary from a string.
+    CZstdDictionary(const string& data);
+
+    /// Destructor.
+    virtual ~CZstdDictionary(void);
+
+    /// Train a dictionary from a set of samples.
+    ///
+    /// Samples should be a typical data to compress later, the best results
+    /// have a few thousands of samples, with a total size about 100 times
+    /// greater than the target dictionary size.
+    /// @param samples
+    ///   List of samples.
+    /// @param dict_size
+    ///   Maximum size of the dictionary.
+    /// @return
+    ///   New dictionary.
+    ///   Throw CCompressionException if dictionary cannot be trained,
+    ///   usually this mean that there are not enough samples.
+    static CRef<CZstdDictionary> Train(const vector<string>& samples,
+                                       size_t dict_size = kZstdDefaultDictSize);
+
+    /// Train a dictionary from a set of samples stored one by one
+    /// in a continuous memory buffer.
+    /// @param samples
+    ///   Pointer to the memory buffer with all samples.
+    /// @param sample_sizes
+    ///   Size of each sample in the buffer, in order.
+    /// @param dict_size
+    ///   Maximum size of the dictionary.
+    /// @sa Train
+    static CRef<CZstdDictionary> Train(const void* samples,
+                                       const vector<size_t>& sample_sizes,
+                                       size_t dict_size = kZstdDefaultDictSize);
+
+    /// Get dictionary content, to store it somewhere for later reuse.
+    const string& GetData(void) const { return m_Data; }
+
+    /// Get dictionary ID, stored in each frame compressed with it.
+    /// Return 0 for raw content dictionaries.
+    unsigned int GetID(void) const;
+
+private:
+    /// Get digested dictionary for compression with specified level.
+    void* x_GetCDict(int level) const;
+    /// Get digested dictionary for decompression.
+    void* x_GetDDict(void) const;
+
+private:
+    typedef map<int, void*> TCDicts;
+
+    string              m_Data;     ///< Dictionary content
+    mutable CFastMutex  m_Mutex;    ///< Guard for m_CDicts and m_DDict
+    mutable TCDicts     m_CDicts;   ///< Compression dictionaries (per level)
+    mutable void*       m_DDict;    ///< Decompression dictionary
+
+    friend class CZstdCompression;
+
+private:
+    /// Private copy constructor to prohibit copy.
+    CZstdDictionary(const CZstdDictionary&);
+    /// Private assignment operator to prohibit assignment.
+    CZstdDictionary& operator= (const CZstdDictionary&);
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CZstdCompression --
+///
+/// Define a base methods for compression/decompression memory buffers
+/// and files.
+
+class NCBI_XUTIL_EXPORT CZstdCompression : public CCompression
+{
+public:
+    /// Compression/decompression flags.
+    enum EFlags {
+        ///< Allow transparent reading data from buffer/file/stream
+        ///< regardless is it compressed or not. But be aware,
+        ///< if data source contains broken data and API cannot detect that
+        ///< it is compressed data, that you can get binary instead of
+        ///< decompressed data. By default this flag is OFF.
+        fAllowTransparentRead = (1<<0),
+        ///< Allow to "compress/decompress" empty data. Buffer compression
+        ///< functions starts to return TRUE instead of FALSE for zero-length
+        ///< input. And the output will have an empty zstd frame.
+        fAllowEmptyData       = (1<<1),
+        ///< Add/check (accordingly to compression or decompression)
+        ///< the checksum of the uncompressed data. Decompression always
+        ///< checks checksum if it is present in the compressed data.
+        fChecksum             = (1<<2)
+    };
+    typedef CZstdCompression::TFlags TZstdFlags; ///< Bitwise OR of EFlags
+
+    /// Constructor.
+    CZstdCompression(
+        ELevel       level   = eLevel_Default,
+        unsigned int workers = 0
+    );
+
+    /// Destructor.
+    virtual ~CZstdCompression(void);
+
+    /// Return name and version of the compression library.
+    virtual CVersionInfo GetVersion(void) const;
+
+    /// Get compression level.
+    ///
+    /// NOTE: zstd algorithm do not support zero level compression.
+    ///       So the "eLevel_NoCompression" will be translated to
+    ///       "eLevel_Lowest". Levels [1..9] are mapped to the zstd
+    ///       compression levels [1..19].
+    virtual ELevel GetLevel(void) const;
+
+    /// Returns default compression level for a compression algorithm.
+    virtual ELevel GetDefaultLevel(void) const
+        { return eLevel_Low; };
+
+    /// Set dictionary for compression/decompression.
+    ///
+    /// Data compressed with a dictionary can be decompressed with
+    /// the same dictionary only. NULL value resets dictionary usage.
+    /// Should be set before starting a compression session.
+    void SetDictionary(CZstdDictionary* dict) { m_Dict.Reset(dict); }
+    /// Get dictionary used for compression/decompression, if any.
+    CZstdDictionary* GetDictionary(void) const
+        { return const_cast<CZstdDictionary*>(m_Dict.GetPointerOrNull()); }
+
+    /// Set number of threads used for compression.
+    /// @sa "workers" parameter description above.
+    void SetWorkers(unsigned int workers) { m_Workers = workers; }
+    /// Get number of threads used for compression.
+    unsigned int GetWorkers(void) const { return m_Workers; }
+
+    //
+    // Utility functions
+    //
+
+    /// Compress data in the buffer.
+    ///
+    /// @param src_buf
+    ///   [in] Source buffer.
+    /// @param src_len
+    ///   [in] Size of data in source  buffer.
+    /// @param dst_buf
+    ///   [in] Destination buffer.
+    /// @param dst_size
+    ///   [in] Size of destination buffer.
+    ///   In some cases, small source data or bad compressed data for example,
+    ///   the compressed data can be greater than the source data.
+    /// @param dst_len
+    ///   [out] Size of compressed data in destination buffer.
+    /// @return
+    ///   Return TRUE if operation was successfully or FALSE otherwise.
+    ///   On success, 'dst_buf' contains compressed data of 'dst_len' size.
+    /// @sa
+    ///   EstimateCompressionBufferSize, DecompressBuffer
+    virtual bool CompressBuffer(
+        const void* src_buf, size_t  src_len,
+        void*       dst_buf, size_t  dst_size,
+        /* out */            size_t* dst_len
+    );
+
+    /// Decompress data in the buffer.
+    ///
+    /// The source buffer can have several concatenated zstd frames,
+    /// all of them will be decompressed.
+    /// @param src_buf
+    ///   Source buffer.
+    /// @param src_len
+    ///   Size of data in source buffer.
+    /// @param dst_buf
+    ///   Destination buffer.
+    /// @param dst_size
+    ///   Size of destination buffer.
+    ///   It must be large enough to hold all of the uncompressed data for the operation to complete.
+    /// @param dst_len
+    ///   Size of decompressed data in destination buffer.
+    /// @return
+    ///   Return TRUE if operation was successfully or FALSE otherwise.
+    ///   On success, 'dst_buf' contains decompressed data of 'dst_len' size.
+    /// @sa
+    ///   CompressBuffer
+    virtual bool DecompressBuffer(
+        const void* src_buf, size_t  src_len,
+        void*       dst_buf, size_t  dst_size,
+        /* out */            size_t* dst_len
+    );
+
+    /// Estimate buffer size for data compression.
+    ///
+    /// The function shall estimate the size of buffer required to compress
+    /// specified number of bytes of data using the CompressBuffer() function.
+    /// This function return a conservative value that larger than 'src_len'.
+    /// @param src_len
+    ///   Size of data in source buffer.
+    /// @return
+    ///   Estimated buffer size.
+    /// @sa
+    ///   CompressBuffer
+    size_t EstimateCompressionBufferSize(size_t src_len);
+
+    /// Compress file.
+    ///
+    /// @param src_file
+    ///   File name of source file.
+    /// @param dst_file
+    ///   File name of result file.
+    /// @param buf_size
+    ///   Buffer size used to read/write files.
+    /// @return
+    ///   Return TRUE on success, FALSE on error.
+    /// @sa
+    ///   DecompressFile
+    virtual bool CompressFile(
+        const string& src_file,
+        const string& dst_file,
+        size_t        buf_size = kCompressionDefaultBufSize
+    );
+
+    /// Decompress file.
+    ///
+    /// @param src_file
+    ///   File name of source file.
+    /// @param dst_file
+    ///   File name of result file.
+    /// @param buf_size
+    ///   Buffer size used to read/write files.
+    /// @return
+    ///   Return TRUE on success, FALSE on error.
+    /// @sa
+    ///   CompressFile
+    virtual bool DecompressFile(
+        const string& src_file,
+        const string& dst_file,
+        size_t        buf_size = kCompressionDefaultBufSize
+    );
+
+protected:
+    /// Prepare compression context for a new compression session.
+    /// Apply current level, flags, number of workers and dictionary.
+    bool InitCompression(const char* where);
+
+    /// Prepare decompression context for a new decompression session.
+    bool InitDecompression(const char* where);
+
+    /// Set last error code/description from zstd function result.
+    void SetZstdError(size_t result);
+
+    /// Format string with last error description.
+    string FormatErrorMessage(string where, size_t pos = 0) const;
+
+protected:
+    void*                  m_CCtx;     ///< Compression context
+    void*                  m_DCtx;     ///< Decompression context
+    unsigned int           m_Workers;  ///< Number of compression threads
+    CRef<CZstdDictionary>  m_Dict;     ///< Dictionary (optional)
+
+private:
+    /// Private copy constructor to prohibit copy.
+    CZstdCompression(const CZstdCompression&);
+    /// Private assignment operator to prohibit assignment.
+    CZstdCompression& operator= (const CZstdCompression&);
+};
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+///
+/// CZstdCompressionFile class --
+///
+/// Throw exceptions on critical errors.
+
+class NCBI_XUTIL_EXPORT CZstdCompressionFile : public CZstdCompression,
+                                               public CCompressionFile
+{
+public:
+    /// Constructor.
+    /// For a special parameters description see CZstdCompression.
+    CZstdCompressionFile(
+        const string& file_name,
+        EMode         mode,
+        ELevel        level   = eLevel_Default,
+        unsigned int  workers = 0
+    );
+
+    /// Conventional constructor.
+    /// For a special parameters description see CZstdCompression.
+    CZstdCompressionFile(
+        ELevel        level   = eLevel_Default,
+        unsigned int  workers = 0
+    );
+
+    /// Destructor.
+    ~CZstdCompressionFile(void);
+
+    /// Opens a compressed file for reading or writing.
+    ///
+    /// @param file_name
+    ///   File name of the file to open.
+    /// @param mode
+    ///   File open mode.
+    /// @return
+    ///   TRUE if file was opened successfully or FALSE otherwise.
+    /// @sa
+    ///   CZstdCompression, Read, Write, Close
+    virtual bool Open(const string& file_name, EMode mode);
+
+    /// Read data from compressed file.
+    ///
+    /// Read up to "len" uncompressed bytes from the compressed file "file"
+    /// into the buffer "buf".
+    /// @param buf
+    ///    Buffer for requested data.
+    /// @param len
+    ///    Number of bytes to read.
+    /// @return
+    ///   Number of bytes actually read (0 for end of file, -1 for error).
+    ///   The number of really read bytes can be less than requested.
+    /// @sa
+    ///   Open, Write, Close
+    virtual long Read(void* buf, size_t len);
+
+    /// Write data to compressed file.
+    ///
+    /// Writes the given number of uncompressed bytes from the buffer
+    /// into the compressed file.
+    /// @param buf
+    ///    Buffer with written data.
+    /// @param len
+    ///    Number of bytes to write.
+    /// @return
+    ///   Number of bytes actually written or -1 for error.
+    ///   Returned value can be less than "len".
+    /// @sa
+    ///   Open, Read, Close
+    virtual long Write(const void* buf, size_t len);
+
+    /// Close compressed file.
+    ///
+    /// Flushes all pending output if necessary, closes the compressed file.
+    /// @return
+    ///   TRUE on success, FALSE on error.
+    /// @sa
+    ///   Open, Read, Write
+    virtual bool Close(void);
+
+protected:
+    /// Get error code/description of last stream operation (m_Stream).
+    /// It can be received using GetErrorCode()/GetErrorDescription() methods.
+    void GetStreamError(void);
+
+protected:
+    EMode                  m_Mode;     ///< I/O mode (read/write).
+    CNcbiFstream*          m_File;     ///< File stream.
+    CCompressionIOStream*  m_Stream;   ///< [De]comression stream.
+
+private:
+    /// Private copy constructor to prohibit copy.
+    CZstdCompressionFile(const CZstdCompressionFile&);
+    /// Private assignment operator to prohibit assignment.
+    CZstdCompressionFile& operator= (const CZstdCompressionFile&);
+};
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CZstdCompressor -- zstd based compressor
+///
+/// Used in CZstdStreamCompressor.
+/// @sa CZstdStreamCompressor, CZstdCompression, CCompressionProcessor
+
+class NCBI_XUTIL_EXPORT CZstdCompressor : public CZstdCompression,
+                                          public CCompressionProcessor
+{
+public:
+    /// Constructor.
+    CZstdCompressor(
+        ELevel           level   = eLevel_Default,
+        TZstdFlags       flags   = 0,
+        CZstdDictionary* dict    = NULL,
+        unsigned int     workers = 0
+    );
+
+    /// Destructor.
+    virtual ~CZstdCompressor(void);
+
+protected:
+    virtual EStatus Init   (void);
+    virtual EStatus Process(const char* in_buf,  size_t  in_len,
+                            char*       out_buf, size_t  out_size,
+                            /* out */            size_t* in_avail,
+                            /* out */            size_t* out_avail);
+    virtual EStatus Flush  (char*       out_buf, size_t  out_size,
+                            /* out */            size_t* out_avail);
+    virtual EStatus Finish (char*       out_buf, size_t  out_size,
+                            /* out */            size_t* out_avail);
+    virtual EStatus End    (int abandon = 0);
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CZstdDecompressor -- zstd based decompressor
+///
+/// Used in CZstdStreamDecompressor.
+/// Decompress all concatenated zstd frames until the end of input,
+/// or until the first data that is not a zstd frame.
+/// @sa CZstdStreamDecompressor, CZstdCompression, CCompressionProcessor
+
+class NCBI_XUTIL_EXPORT CZstdDecompressor : public CZstdCompression,
+                                            public CCompressionProcessor
+{
+public:
+    /// Constructor.
+    CZstdDecompressor(
+        TZstdFlags       flags = 0,
+        CZstdDictionary* dict  = NULL
+    );
+
+    /// Destructor.
+    virtual ~CZstdDecompressor(void);
+
+protected:
+    virtual EStatus Init   (void);
+    virtual EStatus Process(const char* in_buf,  size_t  in_len,
+                            char*       out_buf, size_t  out_size,
+                            /* out */            size_t* in_avail,
+                            /* out */            size_t* out_avail);
+    virtual EStatus Flush  (char*       out_buf, size_t  out_size,
+                            /* out */            size_t* out_avail);
+    virtual EStatus Finish (char*       out_buf, size_t  out_size,
+                            /* out */            size_t* out_avail);
+    virtual EStatus End    (int abandon = 0);
+
+private:
+    /// Decompress cached magic number (if any) and then data from
+    /// the input buffer. Return zstd result code.
+    size_t x_Decompress(const char* in_buf,  size_t in_len,  size_t* in_pos,
+                        char*       out_buf, size_t out_size, size_t* out_pos);
+
+private:
+    bool    m_NeedCheckMagic;  ///< TRUE at the start of each frame
+    bool    m_HaveFrame;       ///< TRUE if at least one frame is found
+    string  m_Cache;           ///< Buffer to cache frame magic number
+};
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+///
+/// CZstdStreamCompressor -- zstd based compression stream processor
+///
+/// See util/compress/stream.hpp for details of stream processing.
+/// @sa CCompressionStreamProcessor
+
+class NCBI_XUTIL_EXPORT CZstdStreamCompressor
+    : public CCompressionStreamProcessor
+{
+public:
+    /// Full constructor
+    CZstdStreamCompressor(
+        CZstdCompression::ELevel     level,
+        streamsize                   in_bufsize,
+        streamsize                   out_bufsize,
+        CZstdCompression::TZstdFlags flags   = 0,
+        CZstdDictionary*             dict    = NULL,
+        unsigned int                 workers = 0
+        )
+        : CCompressionStreamProcessor(
+              new CZstdCompressor(level, flags, dict, workers),
+              eDelete, in_bufsize, out_bufsize)
+    {}
+
+    /// Conventional constructor
+    CZstdStreamCompressor(
+        CZstdCompression::ELevel     level,
+        CZstdCompression::TZstdFlags flags = 0
+        )
+        : CCompressionStreamProcessor(
+              new CZstdCompressor(level, flags),
+              eDelete, kCompressionDefaultBufSize, kCompressionDefaultBufSize)
+    {}
+
+    /// Conventional constructor
+    CZstdStreamCompressor(CZstdCompression::TZstdFlags flags = 0)
+        : CCompressionStreamProcessor(
+              new CZstdCompressor(CZstdCompression::eLevel_Default, flags),
+              eDelete, kCompressionDefaultBufSize, kCompressionDefaultBufSize)
+    {}
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CZstdStreamDecompressor -- zstd based decompression stream processor
+///
+/// See util/compress/stream.hpp for details of stream processing.
+/// @sa CCompressionStreamProcessor
+
+class NCBI_XUTIL_EXPORT CZstdStreamDecompressor
+    : public CCompressionStreamProcessor
+{
+public:
+    /// Full constructor
+    CZstdStreamDecompressor(
+        streamsize                   in_bufsize,
+        streamsize                   out_bufsize,
+        CZstdCompression::TZstdFlags flags = 0,
+        CZstdDictionary*             dict  = NULL
+        )
+        : CCompressionStreamProcessor(
+             new CZstdDecompressor(flags, dict),
+             eDelete, in_bufsize, out_bufsize)
+    {}
+
+    /// Conventional constructor
+    CZstdStreamDecompressor(CZstdCompression::TZstdFlags flags = 0)
+        : CCompressionStreamProcessor(
+              new CZstdDecompressor(flags),
+              eDelete, kCompressionDefaultBufSize, kCompressionDefaultBufSize)
+    {}
+};
+
+
+END_NCBI_SCOPE
+
+
+/* @} */
+
+#endif  /* HAVE_LIBZSTD */
+
+#endif  /* UTIL_COMPRESS__ZSTD__HPP */
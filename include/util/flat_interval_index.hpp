@@ -0,0 +1,474 @@
+#ifndef UTIL___FLAT_INTERVAL_INDEX__HPP
+#define UTIL___FLAT_INTERVAL_INDEX__HPP
+
+/*  $Id$
+* ===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+* Author: agent
+*
+* File Description:
+*   Immutable interval index stored in flat arrays (implicit augmented
+*   interval tree), with memory-mappable binary form.
+*
+* ===========================================================================
+*/
+
+#include <corelib/ncbistd.hpp>
+#include <corelib/ncbifile.hpp>
+#include <util/range.hpp>
+#include <util/util_exception.hpp>
+#include <algorithm>
+#include <type_traits>
+
+
+/** @addtogroup IntervalTree
+ *
+ * @{
+ */
+
+
+BEGIN_NCBI_SCOPE
+
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CFlatIntervalIndex --
+///
+/// Immutable index of intervals for overlap queries.
+///
+/// Unlike CIntervalTree and CRangeMultimap, which allocate a node per
+/// interval, the index keeps intervals in three flat arrays (starts, ends
+/// and subtree maximum ends) sorted by start, and values in a fourth one.
+/// The tree is implicit in the array positions: the element at index i is
+/// a node of level equal to the number of trailing 1-bits of i, so there
+/// are no pointers at all, and the small subtrees near the leaves are
+/// scanned linearly over contiguous memory.
+///
+/// The index is built in bulk: Add() all intervals, then call Build().
+/// After that it can be queried from any number of threads.
+///
+/// If TValue is trivially copyable the index can be saved with Write()
+/// and later used directly from memory, e.g. a memory-mapped file
+/// (see Map() and Attach()), without parsing or copying.
+///
+/// Intervals are closed, as CRange<>: [GetFrom(), GetTo()].
+///
+
+template<class TValue, class TPosition = TSeqPos>
+class CFlatIntervalIndex
+{
+public:
+    typedef TPosition              position_type;
+    typedef CRange<position_type>  range_type;
+    typedef TValue                 value_type;
+    typedef size_t                 size_type;
+
+    CFlatIntervalIndex(void);
+
+    /// Add interval to the index being built.
+    void Add(const range_type& range, const value_type& value);
+
+    /// Sort the added intervals and build the index.
+    void Build(void);
+
+    /// Number of indexed intervals.
+    size_type size(void) const { return m_Size; }
+    bool empty(void) const { return m_Size == 0; }
+
+    /// Interval and value by their position in the index (0 .. size()-1).
+    /// Positions are assigned by Build(), in the order of interval starts.
+    range_type GetRange(size_type index) const
+        { return range_type(m_Start[index], m_End[index]); }
+    const value_type& GetValue(size_type index) const
+        { return m_Value[index]; }
+
+    /// Call func(index) for each interval overlapping the query.
+    /// The indexes come in no particular order.
+    template<class TFunc>
+    void ForEachOverlap(const range_type& query, TFunc func) const;
+
+    /// Append indexes of intervals overlapping the query.
+    void FindOverlaps(const range_type& query, vector<size_type>& hits) const
+        {
+            ForEachOverlap(query,
+                           [&hits](size_type index) { hits.push_back(index); });
+        }
+
+    /// Batched query.
+    /// Overlaps of queries[i] are stored in hits[offsets[i]] ..
+    /// hits[offsets[i+1]-1]; offsets gets queries.size()+1 elements.
+    void FindOverlaps(const vector<range_type>& queries,
+                      vector<size_type>&        offsets,
+                      vector<size_type>&        hits) const;
+
+    /// Count intervals overlapping the query.
+    size_type CountOverlaps(const range_type& query) const
+        {
+            size_type count = 0;
+            ForEachOverlap(query, [&count](size_type) { ++count; });
+            return count;
+        }
+
+    /// Save the index in binary form, which can be used by Attach()/Map()
+    /// on a host with the same byte order.
+    void Write(CNcbiOstream& out) const;
+
+    /// Use the index saved by Write() and loaded into memory.  The data is
+    /// not copied, it must stay valid and unchanged while the index is used.
+    void Attach(const void* data, size_t size);
+
+    /// Memory-map the index file saved by Write().
+    void Map(const string& filename);
+
+private:
+    struct SHeader {
+        char  m_Magic[8];
+        Uint4 m_ByteOrder;
+        Uint4 m_PositionSize;
+        Uint4 m_ValueSize;
+        Int4  m_MaxLevel;
+        Uint8 m_Size;
+    };
+
+    // Subtrees of this level or below are scanned linearly
+    static const int kScanLevel = 3;
+
+    static size_t x_Align(size_t size) { return (size + 7) & ~size_t(7); }
+    static int x_GetMaxLevel(size_t size);
+    void x_SetArrays(void);
+
+    vector<position_type> m_StartData;
+    vector<position_type> m_EndData;
+    vector<position_type> m_MaxEndData;
+    vector<value_type>    m_ValueData;
+
+    const position_type*  m_Start;
+    const position_type*  m_End;
+    const position_type*  m_MaxEnd;
+    const value_type*     m_Value;
+    size_type             m_Size;
+    int                   m_MaxLevel;  // level of the root, -1 if empty
+    bool                  m_Built;
+    shared_ptr<CMemoryFile> m_File;
+
+    /// Private -- the arrays may point into the own vectors
+    CFlatIntervalIndex(const CFlatIntervalIndex&);
+    CFlatIntervalIndex& operator= (const CFlatIntervalIndex&);
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CFlatIntervalIndex<> implementation
+//
+
+template<class TValue, class TPosition>
+inline
+CFlatIntervalIndex<TValue, TPosition>::CFlatIntervalIndex(void)
+    : m_Start(0), m_End(0), m_MaxEnd(0), m_Value(0),
+      m_Size(0), m_MaxLevel(-1), m_Built(false)
+{
+}
+
+
+template<class TValue, class TPosition>
+inline
+void CFlatIntervalIndex<TValue, TPosition>::Add(const range_type& range,
+                                                const value_type& value)
+{
+    _ASSERT(!m_Built);
+    m_StartData.push_back(range.GetFrom());
+    m_EndData.push_back(range.GetTo());
+    m_ValueData.push_back(value);
+}
+
+
+template<class TValue, class TPosition>
+inline
+void CFlatIntervalIndex<TValue, TPosition>::x_SetArrays(void)
+{
+    m_Size   = m_StartData.size();
+    m_Start  = m_StartData.empty()  ? 0 : &m_StartData[0];
+    m_End    = m_EndData.empty()    ? 0 : &m_EndData[0];
+    m_MaxEnd = m_MaxEndData.empty() ? 0 : &m_MaxEndData[0];
+    m_Value  = m_ValueData.empty()  ? 0 : &m_ValueData[0];
+}
+
+
+template<class TValue, class TPosition>
+inline
+int CFlatIntervalIndex<TValue, TPosition>::x_GetMaxLevel(size_t size)
+{
+    // The root is at index 2^level-1, the highest one below size
+    int level = -1;
+    for ( ;  size;  size >>= 1) {
+        ++level;
+    }
+    return level;
+}
+
+
+template<class TValue, class TPosition>
+void CFlatIntervalIndex<TValue, TPosition>::Build(void)
+{
+    _ASSERT(!m_Built);
+    size_t n = m_StartData.size();
+
+    // Sort by start, keeping the three arrays in sync
+    vector<size_t> order(n);
+    for (size_t i = 0;  i < n;  ++i) {
+        order[i] = i;
+    }
+    const vector<position_type>& start = m_StartData;
+    stable_sort(order.begin(), order.end(),
+                [&start](size_t a, size_t b) { return start[a] < start[b]; });
+    {{
+        vector<position_type> s(n), e(n);
+        vector<value_type> v;
+        v.reserve(n);
+        for (size_t i = 0;  i < n;  ++i) {
+            s[i] = m_StartData[order[i]];
+            e[i] = m_EndData[order[i]];
+            v.push_back(m_ValueData[order[i]]);
+        }
+        m_StartData.swap(s);
+        m_EndData.swap(e);
+        m_ValueData.swap(v);
+    }}
+
+    // Compute maximum end of each implicit subtree, bottom-up.
+    // Leaves (level 0) are at even indexes; a node of level k is at index
+    // i with k trailing 1-bits, its children are at i -/+ 2^(k-1).
+    // The rightmost subtrees may be incomplete; 'last' tracks maximum end
+    // of the rightmost node of the previous level.
+    m_MaxEndData = m_EndData;
+    m_MaxLevel = -1;
+    if ( n ) {
+        size_t last_i = 0;
+        position_type last = position_type();
+        for (size_t i = 0;  i < n;  i += 2) {
+            last_i = i;
+            last = m_EndData[i];
+        }
+        int k = 1;
+        for ( ;  (size_t(1) << k) <= n;  ++k) {
+            size_t x = size_t(1) << (k - 1);
+            size_t step = x << 2;
+            for (size_t i = (x << 1) - 1;  i < n;  i += step) {
+                position_type e = m_EndData[i];
+                e = max(e, m_MaxEndData[i - x]);
+                e = max(e, i + x < n ? m_MaxEndData[i + x] : last);
+                m_MaxEndData[i] = e;
+            }
+            last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+            if (last_i < n  &&  m_MaxEndData[last_i] > last) {
+                last = m_MaxEndData[last_i];
+            }
+        }
+        m_MaxLevel = k - 1;
+    }
+    _ASSERT(m_MaxLevel == x_GetMaxLevel(n));
+    x_SetArrays();
+    m_Built = true;
+}
+
+
+template<class TValue, class TPosition>
+template<class TFunc>
+void CFlatIntervalIndex<TValue, TPosition>::ForEachOverlap(
+    const range_type& query,
+    TFunc             func) const
+{
+    if (m_MaxLevel < 0  ||  query.Empty()) {
+        return;
+    }
+    const position_type from = query.GetFrom();
+    const position_type to   = query.GetTo();
+    const size_t n = m_Size;
+
+    struct SStackItem {
+        int    m_Level;
+        bool   m_LeftDone;
+        size_t m_Node;
+    };
+    // Each level adds at most two items
+    SStackItem stack[2 * (sizeof(size_t) * 8 + 1)];
+    size_t depth = 0;
+    stack[depth].m_Level = m_MaxLevel;
+    stack[depth].m_LeftDone = false;
+    stack[depth++].m_Node = (size_t(1) << m_MaxLevel) - 1;
+    while ( depth ) {
+        SStackItem item = stack[--depth];
+        if (item.m_Level <= kScanLevel) {
+            // Small subtree: scan its contiguous range of elements
+            size_t i = item.m_Node >> item.m_Level << item.m_Level;
+            size_t end = min(n, i + (size_t(1) << (item.m_Level + 1)) - 1);
+            for ( ;  i < end  &&  m_Start[i] <= to;  ++i) {
+                if (m_End[i] >= from) {
+                    func(i);
+                }
+            }
+        }
+        else if ( !item.m_LeftDone ) {
+            // Come back to the node after its left subtree
+            size_t left = item.m_Node - (size_t(1) << (item.m_Level - 1));
+            stack[depth] = item;
+            stack[depth++].m_LeftDone = true;
+            // The left child may be beyond the array end if the tree is
+            // incomplete; then it still may have elements to check
+            if (left >= n  ||  m_MaxEnd[left] >= from) {
+                stack[depth].m_Level = item.m_Level - 1;
+                stack[depth].m_LeftDone = false;
+                stack[depth++].m_Node = left;
+            }
+        }
+        else if (item.m_Node < n  &&  m_Start[item.m_Node] <= to) {
+            // Everything to the right starts after the node's start
+            if (m_End[item.m_Node] >= from) {
+                func(item.m_Node);
+            }
+            stack[depth].m_Level = item.m_Level - 1;
+            stack[depth].m_LeftDone = false;
+            stack[depth++].m_Node =
+                item.m_Node + (size_t(1) << (item.m_Level - 1));
+        }
+    }
+}
+
+
+template<class TValue, class TPosition>
+void CFlatIntervalIndex<TValue, TPosition>::FindOverlaps(
+    const vector<range_type>& queries,
+    vector<size_type>&        offsets,
+    vector<size_type>&        hits) const
+{
+    offsets.clear();
+    offsets.reserve(queries.size() + 1);
+    hits.clear();
+    ITERATE(typename vector<range_type>, it, queries) {
+        offsets.push_back(hits.size());
+        FindOverlaps(*it, hits);
+    }
+    offsets.push_back(hits.size());
+}
+
+
+template<class TValue, class TPosition>
+void CFlatIntervalIndex<TValue, TPosition>::Write(CNcbiOstream& out) const
+{
+    static_assert(std::is_trivially_copyable<value_type>::value,
+                  "CFlatIntervalIndex::Write() requires "
+                  "trivially copyable values");
+    _ASSERT(m_Built);
+    SHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_Magic, "NCBIFII1", sizeof(header.m_Magic));
+    header.m_ByteOrder    = 0x01020304;
+    header.m_PositionSize = Uint4(sizeof(position_type));
+    header.m_ValueSize    = Uint4(sizeof(value_type));
+    header.m_MaxLevel     = m_MaxLevel;
+    header.m_Size         = m_Size;
+    out.write((const char*) &header, sizeof(header));
+
+    static const char kPadding[8] = { 0 };
+    const void* arrays[] = { m_Start, m_End, m_MaxEnd, m_Value };
+    size_t sizes[] = {
+        m_Size * sizeof(position_type),
+        m_Size * sizeof(position_type),
+        m_Size * sizeof(position_type),
+        m_Size * sizeof(value_type)
+    };
+    for (size_t i = 0;  i < 4;  ++i) {
+        out.write((const char*) arrays[i], sizes[i]);
+        out.write(kPadding, x_Align(sizes[i]) - sizes[i]);
+    }
+    if ( !out ) {
+        NCBI_THROW(CIOException, eWrite,
+                   "CFlatIntervalIndex: cannot write index");
+    }
+}
+
+
+template<class TValue, class TPosition>
+void CFlatIntervalIndex<TValue, TPosition>::Attach(const void* data,
+                                                   size_t      size)
+{
+    static_assert(std::is_trivially_copyable<value_type>::value,
+                  "CFlatIntervalIndex::Attach() requires "
+                  "trivially copyable values");
+    const SHeader* header = static_cast<const SHeader*>(data);
+    if (size < sizeof(SHeader)  ||
+        memcmp(header->m_Magic, "NCBIFII1", sizeof(header->m_Magic)) != 0) {
+        NCBI_THROW(CUtilException, eWrongData,
+                   "CFlatIntervalIndex: not an interval index");
+    }
+    if (header->m_ByteOrder    != 0x01020304             ||
+        header->m_PositionSize != sizeof(position_type)  ||
+        header->m_ValueSize    != sizeof(value_type)) {
+        NCBI_THROW(CUtilException, eWrongData,
+                   "CFlatIntervalIndex: incompatible index format");
+    }
+    size_t n = size_t(header->m_Size);
+    if (header->m_Size != n  ||
+        n > size / (3 * sizeof(position_type) + sizeof(value_type))  ||
+        size < sizeof(SHeader) + 3 * x_Align(n * sizeof(position_type)) +
+               x_Align(n * sizeof(value_type))) {
+        NCBI_THROW(CUtilException, eWrongData,
+                   "CFlatIntervalIndex: truncated index data");
+    }
+    if (header->m_MaxLevel != x_GetMaxLevel(n)) {
+        NCBI_THROW(CUtilException, eWrongData,
+                   "CFlatIntervalIndex: invalid index tree level");
+    }
+    size_t pos_size = x_Align(n * sizeof(position_type));
+    const char* ptr = static_cast<const char*>(data) + sizeof(SHeader);
+    m_StartData.clear();
+    m_EndData.clear();
+    m_MaxEndData.clear();
+    m_ValueData.clear();
+    m_Start    = reinterpret_cast<const position_type*>(ptr);
+    m_End      = reinterpret_cast<const position_type*>(ptr + pos_size);
+    m_MaxEnd   = reinterpret_cast<const position_type*>(ptr + 2 * pos_size);
+    m_Value    = reinterpret_cast<const value_type*>(ptr + 3 * pos_size);
+    m_Size     = n;
+    m_MaxLevel = header->m_MaxLevel;
+    m_Built    = true;
+}
+
+
+template<class TValue, class TPosition>
+void CFlatIntervalIndex<TValue, TPosition>::Map(const string& filename)
+{
+    shared_ptr<CMemoryFile> file(new CMemoryFile(filename));
+    Attach(file->GetPtr(), file->GetSize());
+    m_File = file;
+}
+
+
+END_NCBI_SCOPE
+
+
+/* @} */
+
+#endif  /* UTIL___FLAT_INTERVAL_INDEX__HPP */
@@ -91,6 +91,7 @@ public:
         eUCSCRegion          = 33, ///< USCS Region file format
         eGffAugustus         = 34, ///< GFFish output of Augustus Gene Prediction
         eJSON                = 35, ///< JSON 
+        eZstd                = 36, ///< Zstandard compressed file
         /// Max value of EFormat
         eFormat_max
     };
@@ -251,6 +252,7 @@ protected:
     bool TestFormatGZip(EMode);
     bool TestFormatBZip2(EMode);
     bool TestFormatLzo(EMode);
+    bool TestFormatZstd(EMode);
     bool TestFormatSra(EMode);
     bool TestFormatBam(EMode);
     bool TestFormatVcf(EMode);
@@ -49,6 +49,8 @@
 
 BEGIN_NCBI_SCOPE
 
+class CLineReadAhead;
+
 /// Abstract base class for lightweight line-by-line reading.
 class NCBI_XUTIL_EXPORT ILineReader : public CObject
 {
@@ -278,6 +280,76 @@ private:
 };
 
 
+/// Implementation of ILineReader for large files and streams (IReader),
+/// which reads the data ahead into a set of large page-aligned buffers
+/// in a background thread (if threads are available), so the input
+/// overlaps with the processing of the lines.
+///
+/// Lines are handed out as CTempString views into the buffers, and only
+/// the lines spanning buffer boundaries get copied.  Same as with the
+/// other implementations, the current line stays valid until the next
+/// call to operator++().
+class NCBI_XUTIL_EXPORT CReadAheadLineReader : public ILineReader
+{
+public:
+    /// Default size of each read-ahead buffer
+    static const size_t kDefaultBufferSize = 4 * 1024 * 1024;
+
+    /// read from the IReader
+    ///
+    /// As always with ILineReader, an explicit call to operator++ or
+    /// ReadLine() will be necessary to fetch the first line.
+    CReadAheadLineReader(IReader* reader,
+                         EOwnership ownership = eNoOwnership,
+                         size_t buffer_size = kDefaultBufferSize);
+
+    /// read from the istream
+    ///
+    /// As always with ILineReader, an explicit call to operator++ or
+    /// ReadLine() will be necessary to fetch the first line.
+    CReadAheadLineReader(CNcbiIstream& is,
+                         EOwnership ownership = eNoOwnership,
+                         size_t buffer_size = kDefaultBufferSize);
+
+    /// read from the file, "-" (but not "./-") means standard input
+    ///
+    /// As always with ILineReader, an explicit call to operator++ or
+    /// ReadLine() will be necessary to fetch the first line.
+    CReadAheadLineReader(const string& filename,
+                         size_t buffer_size = kDefaultBufferSize);
+
+    virtual ~CReadAheadLineReader();
+
+    bool                  AtEOF(void) const;
+    char                  PeekChar(void) const;
+    CReadAheadLineReader& operator++(void);
+    void                  UngetLine(void);
+    CTempString           operator*(void) const;
+    CT_POS_TYPE           GetPosition(void) const;
+    unsigned int          GetLineNumber(void) const;
+
+private:
+    CReadAheadLineReader(const CReadAheadLineReader&);
+    CReadAheadLineReader& operator=(const CReadAheadLineReader&);
+private:
+    void x_Init(size_t buffer_size);
+    bool x_ReadBuffer(void);
+private:
+    AutoPtr<IReader>           m_Reader;
+    unique_ptr<CLineReadAhead> m_ReadAhead;
+    bool          m_Eof;
+    bool          m_UngetLine;
+    SIZE_TYPE     m_LastReadSize;
+    const char*   m_Buffer;
+    const char*   m_Pos;
+    const char*   m_End;
+    CTempString   m_Line;
+    string        m_String;
+    CT_POS_TYPE   m_InputPos;
+    unsigned int  m_LineNumber;
+};
+
+
 
 END_NCBI_SCOPE
 
@@ -53,6 +53,12 @@ public:
     // for convenience
     static string GetHexSum(unsigned char digest[16]);
 
+    /// Update many independent MD5 states at once, the same as calling
+    /// md5[i]->Update(data[i].data(), data[i].size()) for each i.
+    /// Whole blocks are hashed in SIMD lanes, 4 buffers at a time,
+    /// where supported. Each object may be listed only once.
+    static void UpdateBatch(CMD5* const md5[], const CTempString data[], size_t count);
+
 protected:
     enum {
         // Block size defined by algorithm; DO NOT CHANGE.
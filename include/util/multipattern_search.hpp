@@ -34,11 +34,13 @@
 /// Simultaneous search of multiple RegEx patterns in the input string
 
 #include <corelib/ncbistd.hpp>
+#include <atomic>
 #include <functional>
 
 BEGIN_NCBI_SCOPE
 
 class CRegExFSA;
+class CCompiledRegExFSA;
 
 
 ///////////////////////////////////////////////////////////////////////
@@ -54,7 +56,11 @@ class CRegExFSA;
 /// Use this class to increase the search performance
 /// when the number of search patterns is large (10 and more)
 /// If the patterns are known in advance, FSM can be exported as C code
-/// and compiled for the further performance improvement.
+/// and compiled for the further performance improvement,
+/// or saved in binary form and loaded (memory-mapped) at startup.
+/// If all patterns are plain strings (no RegEx and no flags other than fNoCase),
+/// the search uses a SIMD prefilter to skip the parts of the input
+/// where none of the patterns can start.
 
 class NCBI_XUTIL_EXPORT CMultipatternSearch
 {
@@ -77,6 +83,7 @@ public:
     
     ///@{
     /// Add search pattern to the FSM
+    /// Patterns cannot be added after Load().
     ///
     /// @param pattern
     ///   A search pattern to add to the FSM.
@@ -90,6 +97,40 @@ public:
     void AddPatterns(const vector<pair<string, TFlags>>& patterns);
     ///@}
 
+    /// Save the FSM in binary form, to be used later by Load().
+    /// The data is platform-dependent (byte order).
+    ///
+    /// @param out
+    ///   A stream to receive the output.
+    void Save(ostream& out) const;
+
+    ///@{
+    /// Replace all patterns with the FSM saved by Save().
+    /// The loaded FSM can be used for the search and saved again;
+    /// AddPattern(), AddPatterns() and Generate...() throw after Load(),
+    /// because the original patterns are not stored.
+    /// Throws if the data is not a valid FSM.
+    ///
+    /// @param data
+    ///   FSM data in memory; it is not copied and must stay valid
+    ///   while this object is in use.
+    /// @param filename
+    ///   File written by Save(); it will be memory-mapped.
+    void Load(const void* data, size_t size);
+    void Load(const string& filename);
+    ///@}
+
+    /// Prefilter mode
+    enum EPrefilter {
+        ePrefilter_Off,     ///< Plain DFA scan
+        ePrefilter_Scalar,  ///< Table-driven prefilter, no SIMD
+        ePrefilter_Auto     ///< SIMD prefilter if available (default)
+    };
+
+    /// Set the prefilter mode.
+    /// The results are the same; this is mostly useful for benchmarking and testing.
+    void SetPrefilter(EPrefilter mode) { m_Prefilter = mode; }
+
     /// Quote special characters to insert string into regular expression
     static string QuoteString(const string& str);
 
@@ -152,6 +193,24 @@ public:
     void Search(const string& input, BoolCall2 found_callback) const { Search(input.c_str(), found_callback); }
     ///@}
 
+    /// Run the FSM search on a memory buffer, e.g. a large sequence.
+    /// The end of the buffer is treated as the end of the string;
+    /// the buffer must not contain zero characters.
+    /// The found positions are the same as for Search(string(data, size), ...).
+    ///
+    /// @param data
+    ///   Input buffer.
+    /// @param size
+    ///   Input buffer size.
+    /// @param found_callback
+    ///   Function to call when the pattern is found; it is called in the current thread
+    ///   in the order of positions, as in a single-threaded search.
+    /// @param threads
+    ///   Number of threads to split the buffer between; 0 - use the number of CPUs.
+    ///   Only single thread is used for the patterns that can match unlimited number
+    ///   of characters (e.g. /a+/), and for small buffers.
+    void SearchBuffer(const char* data, size_t size, VoidCall2 found_callback, unsigned int threads = 1) const;
+
     ///@{
     /// Run the FSM search on the input string using the strucutre prebuilt by multipattern -A
     ///
@@ -202,8 +261,19 @@ public:
     /// @endcode
 
 private:
-    /// Finit State Machine that does all work
+    const CCompiledRegExFSA& x_GetCompiled() const;
+    void x_ResetCompiled();
+    CRegExFSA& x_GetFSM() const;
+
+    /// Finit State Machine that does all work; NULL after Load()
     unique_ptr<CRegExFSA> m_FSM;
+    /// Its flat copy for the search, created on demand and owned by this object
+    mutable atomic<CCompiledRegExFSA*> m_Compiled;
+    EPrefilter m_Prefilter;
+
+    /// Private -- to prohibit copying and assigning
+    CMultipatternSearch(const CMultipatternSearch&);
+    CMultipatternSearch& operator= (const CMultipatternSearch&);
 };
 
 
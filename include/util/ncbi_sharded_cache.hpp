@@ -0,0 +1,698 @@
+#ifndef UTIL___NCBI_SHARDED_CACHE__HPP
+#define UTIL___NCBI_SHARDED_CACHE__HPP
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author: agent
+ *
+ * File Description:
+ *      Sharded concurrent cache.
+ *
+ */
+
+#include <corelib/ncbistd.hpp>
+#include <corelib/ncbimtx.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/ncbi_system.hpp>
+#include <util/ncbi_cache.hpp>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+
+BEGIN_NCBI_SCOPE
+
+/** @addtogroup Cache
+ *
+ * @{
+ */
+
+
+/// @file ncbi_sharded_cache.hpp
+/// Concurrent cache split into independently locked shards.
+///
+/// Unlike CCache<>, which serializes all operations on a single lock,
+/// CShardedCache<> distributes keys between a number of shards by hash,
+/// each shard having its own lock, index and eviction state.  Threads
+/// working with different keys rarely contend for the same lock.
+///
+/// Capacity is expressed in weight units (e.g. bytes) rather than in
+/// number of elements; each element is added with its own weight.
+/// The capacity is split evenly between the shards.
+
+
+/// Eviction policy of CShardedCache<>
+enum ECacheEviction {
+    /// Least recently used element is evicted first
+    eCacheEvict_LRU,
+    /// Adaptive replacement cache: balances recency and frequency,
+    /// tracking recently evicted keys to tune the balance
+    eCacheEvict_ARC,
+    /// LRU with TinyLFU admission: a new element may only push out the
+    /// LRU element if its key has been accessed more often recently
+    eCacheEvict_TinyLFU
+};
+
+
+/// Cache statistics
+struct SCacheStats
+{
+    SCacheStats(void)
+        : m_Hits(0), m_Misses(0), m_Insertions(0), m_Evictions(0),
+          m_Expirations(0), m_Rejections(0), m_Count(0), m_Weight(0)
+        {}
+
+    Uint8 m_Hits;         ///< Get() found a live element
+    Uint8 m_Misses;       ///< Get() found nothing (or an expired element)
+    Uint8 m_Insertions;   ///< Add() stored or replaced an element
+    Uint8 m_Evictions;    ///< Elements removed to free space
+    Uint8 m_Expirations;  ///< Elements removed because their TTL expired
+    Uint8 m_Rejections;   ///< Add() did not store an element (too heavy,
+                          ///< or refused by TinyLFU admission)
+    Uint8 m_Count;        ///< Current number of elements
+    Uint8 m_Weight;       ///< Current total weight of elements
+
+    SCacheStats& operator+=(const SCacheStats& stats)
+        {
+            m_Hits        += stats.m_Hits;
+            m_Misses      += stats.m_Misses;
+            m_Insertions  += stats.m_Insertions;
+            m_Evictions   += stats.m_Evictions;
+            m_Expirations += stats.m_Expirations;
+            m_Rejections  += stats.m_Rejections;
+            m_Count       += stats.m_Count;
+            m_Weight      += stats.m_Weight;
+            return *this;
+        }
+};
+
+
+/// Count-min sketch with small saturating counters, used to estimate
+/// access frequency of keys for TinyLFU admission.  Counters are halved
+/// periodically so that the estimate reflects recent history.
+class CCacheFrequencySketch
+{
+public:
+    CCacheFrequencySketch(void) : m_Mask(0), m_Samples(0) { Reserve(0); }
+
+    /// Make sure the sketch is wide enough for the given number of keys.
+    /// Growing the sketch discards the collected statistics.
+    void Reserve(size_t count)
+        {
+            size_t width = 64;
+            while (width < count  &&  width < (size_t(1) << 24)) {
+                width <<= 1;
+            }
+            if (m_Counters.empty()  ||  width > m_Mask + 1) {
+                m_Counters.assign(kDepth * width, 0);
+                m_Mask = width - 1;
+                m_Samples = 0;
+            }
+        }
+
+    /// Register an access to the key with the given hash
+    void Increment(Uint8 hash)
+        {
+            bool added = false;
+            for (size_t i = 0;  i < kDepth;  ++i) {
+                unsigned char& counter = m_Counters[x_Index(hash, i)];
+                if (counter < kMaxCount) {
+                    ++counter;
+                    added = true;
+                }
+            }
+            if (added  &&  ++m_Samples >= 10 * (m_Mask + 1)) {
+                x_Age();
+            }
+        }
+
+    /// Estimate number of recent accesses to the key
+    unsigned Estimate(Uint8 hash) const
+        {
+            unsigned result = kMaxCount;
+            for (size_t i = 0;  i < kDepth;  ++i) {
+                unsigned counter = m_Counters[x_Index(hash, i)];
+                if (counter < result) {
+                    result = counter;
+                }
+            }
+            return result;
+        }
+
+private:
+    static const size_t   kDepth    = 4;
+    static const unsigned kMaxCount = 15;
+
+    size_t x_Index(Uint8 hash, size_t row) const
+        {
+            // Double hashing: rows use different odd multiples of the
+            // upper half of the hash
+            Uint8 h = hash + row * ((hash >> 32) | 1);
+            return row * (m_Mask + 1) + size_t(h & m_Mask);
+        }
+
+    void x_Age(void)
+        {
+            NON_CONST_ITERATE(vector<unsigned char>, it, m_Counters) {
+                *it >>= 1;
+            }
+            m_Samples /= 2;
+        }
+
+    vector<unsigned char> m_Counters;
+    size_t                m_Mask;
+    size_t                m_Samples;
+};
+
+
+/// Sharded concurrent cache.
+/// TKey and TValue define types stored in the cache; values are returned
+/// by copy, so for large objects TValue should be a smart pointer
+/// (CRef<>, CConstRef<>, shared_ptr<>).
+/// THash is a hash functor for TKey; TLock must define TWriteLockGuard
+/// subtype (see CCache<>).
+template <class TKey,
+          class TValue,
+          class THash = std::hash<TKey>,
+          class TLock = CFastMutex>
+class CShardedCache
+{
+public:
+    typedef TKey   TKeyType;
+    typedef TValue TValueType;
+    typedef Uint8  TWeight;
+
+    /// Create cache.
+    /// @param capacity
+    ///   Total weight of elements the cache may hold.
+    /// @param eviction
+    ///   Eviction policy.
+    /// @param shards
+    ///   Number of shards, rounded up to a power of 2.  Zero selects
+    ///   a number based on the count of CPUs.
+    /// @param ttl
+    ///   Default time to live of elements.  Zero means no expiration.
+    CShardedCache(TWeight          capacity,
+                  ECacheEviction   eviction = eCacheEvict_LRU,
+                  unsigned int     shards   = 0,
+                  const CTimeSpan& ttl      = CTimeSpan(0, 0));
+
+    /// Get element by its key.
+    /// @return
+    ///   true and the element's value if the key is cached and not expired
+    bool Get(const TKeyType& key, TValueType& value);
+
+    /// Add new element or replace the existing value, using default TTL.
+    /// @param weight
+    ///   Weight of the element, must not exceed capacity of a shard.
+    /// @return
+    ///   false if the element was not cached (too heavy, or not admitted
+    ///   by TinyLFU policy)
+    bool Add(const TKeyType& key, const TValueType& value, TWeight weight = 1)
+        { return x_Add(key, value, weight, m_TTL); }
+
+    /// Add new element or replace the existing value, with specific TTL.
+    /// @sa Add()
+    bool Add(const TKeyType&   key,
+             const TValueType& value,
+             TWeight           weight,
+             const CTimeSpan&  ttl)
+        { return x_Add(key, value, weight, ttl.GetAsDouble()); }
+
+    /// Remove element from the cache.  Do nothing if the key is not cached.
+    bool Remove(const TKeyType& key);
+
+    /// Remove all elements
+    void Clear(void);
+
+    /// Remove all expired elements.  Normally they are removed when found
+    /// by Get() or pushed out by new elements.
+    void PurgeExpired(void);
+
+    /// Get total capacity of the cache
+    TWeight GetCapacity(void) const { return m_Capacity; }
+
+    /// Set new capacity, evicting elements if necessary
+    void SetCapacity(TWeight capacity);
+
+    /// Get number of shards
+    size_t GetShardCount(void) const { return m_Shards.size(); }
+
+    /// Get statistics summed over all shards.
+    /// @param reset
+    ///   Reset hit/miss/eviction counters after reading them.
+    SCacheStats GetStats(bool reset = false);
+
+    /// Get current number of elements
+    size_t GetSize(void) { return size_t(GetStats().m_Count); }
+
+    /// Get current total weight of elements
+    TWeight GetWeight(void) { return GetStats().m_Weight; }
+
+private:
+    // Prohibit copy constructor and assignment.
+    CShardedCache(const CShardedCache&);
+    CShardedCache& operator=(const CShardedCache&);
+
+    typedef typename TLock::TWriteLockGuard TGuardType;
+
+    enum EList {
+        eT1,  // recent elements (the only list for LRU and TinyLFU)
+        eT2,  // frequent elements (ARC)
+        eB1,  // keys recently evicted from T1 (ARC)
+        eB2   // keys recently evicted from T2 (ARC)
+    };
+
+    struct SNode {
+        SNode(const TKeyType& key) : m_Key(key), m_Weight(0), m_Expires(0) {}
+        TKeyType   m_Key;
+        TValueType m_Value;
+        TWeight    m_Weight;
+        double     m_Expires;  // 0 - never
+        EList      m_List;
+    };
+    typedef list<SNode>                    TList;
+    typedef typename TList::iterator       TListIter;
+    typedef unordered_map<TKeyType, TListIter, THash> TIndex;
+
+    struct SShard {
+        SShard(void) : m_Capacity(0), m_Target(0) {
+            m_Weight[eT1] = m_Weight[eT2] = m_Weight[eB1] = m_Weight[eB2] = 0;
+        }
+        TLock       m_Lock;
+        TWeight     m_Capacity;
+        TIndex      m_Index;      // live elements and ARC ghosts
+        TList       m_List[4];    // MRU first
+        TWeight     m_Weight[4];
+        TWeight     m_Target;     // ARC: target weight of T1
+        CCacheFrequencySketch m_Sketch;
+        SCacheStats m_Stats;
+    };
+
+    static Uint8 x_Mix(Uint8 h)
+        {
+            h ^= h >> 33;
+            h *= NCBI_CONST_UINT8(0xff51afd7ed558ccd);
+            h ^= h >> 33;
+            return h;
+        }
+    SShard& x_GetShard(Uint8 hash)
+        { return *m_Shards[size_t(hash >> 40) & (m_Shards.size() - 1)]; }
+    double x_Now(void) const { return m_Clock.Elapsed(); }
+
+    bool x_Add(const TKeyType&   key,
+               const TValueType& value,
+               TWeight           weight,
+               double            ttl);
+    void x_Move(SShard& shard, TListIter node, EList to);
+    void x_Erase(SShard& shard, TListIter node);
+    // Evict elements until there is room for the given weight
+    void x_MakeRoom(SShard& shard, TWeight weight, bool in_b2);
+    void x_TrimGhosts(SShard& shard);
+    void x_Expire(SShard& shard, TListIter node);
+
+    TWeight                  m_Capacity;
+    ECacheEviction           m_Eviction;
+    double                   m_TTL;
+    CStopWatch               m_Clock;
+    vector< unique_ptr<SShard> > m_Shards;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  CShardedCache<> implementation
+//
+
+template <class TKey, class TValue, class THash, class TLock>
+CShardedCache<TKey, TValue, THash, TLock>::CShardedCache(
+    TWeight          capacity,
+    ECacheEviction   eviction,
+    unsigned int     shards,
+    const CTimeSpan& ttl)
+    : m_Capacity(0),
+      m_Eviction(eviction),
+      m_TTL(ttl.GetAsDouble()),
+      m_Clock(CStopWatch::eStart)
+{
+    if ( !shards ) {
+        shards = 4 * GetCpuCount();
+    }
+    size_t count = 1;
+    while (count < shards  &&  count < 1024) {
+        count <<= 1;
+    }
+    m_Shards.reserve(count);
+    for (size_t i = 0;  i < count;  ++i) {
+        m_Shards.push_back(unique_ptr<SShard>(new SShard));
+    }
+    SetCapacity(capacity);
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+void CShardedCache<TKey, TValue, THash, TLock>::x_Move(SShard&   shard,
+                                                       TListIter node,
+                                                       EList     to)
+{
+    EList from = node->m_List;
+    shard.m_List[to].splice(shard.m_List[to].begin(),
+                            shard.m_List[from], node);
+    shard.m_Weight[from] -= node->m_Weight;
+    shard.m_Weight[to]   += node->m_Weight;
+    node->m_List = to;
+    if (to == eB1  ||  to == eB2) {
+        // Ghosts keep only the key and the weight
+        node->m_Value = TValueType();
+    }
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+void CShardedCache<TKey, TValue, THash, TLock>::x_Erase(SShard&   shard,
+                                                        TListIter node)
+{
+    shard.m_Weight[node->m_List] -= node->m_Weight;
+    shard.m_Index.erase(node->m_Key);
+    shard.m_List[node->m_List].erase(node);
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+void CShardedCache<TKey, TValue, THash, TLock>::x_Expire(SShard&   shard,
+                                                         TListIter node)
+{
+    ++shard.m_Stats.m_Expirations;
+    --shard.m_Stats.m_Count;
+    shard.m_Stats.m_Weight -= node->m_Weight;
+    x_Erase(shard, node);
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+void CShardedCache<TKey, TValue, THash, TLock>::x_TrimGhosts(SShard& shard)
+{
+    // ARC directory size: |T1| + |B1| <= c, |T1| + |T2| + |B1| + |B2| <= 2c
+    while ( !shard.m_List[eB1].empty()  &&
+            shard.m_Weight[eT1] + shard.m_Weight[eB1] > shard.m_Capacity ) {
+        x_Erase(shard, prev(shard.m_List[eB1].end()));
+    }
+    while ( !shard.m_List[eB2].empty()  &&
+            shard.m_Weight[eT1] + shard.m_Weight[eT2] +
+            shard.m_Weight[eB1] + shard.m_Weight[eB2] >
+            2 * shard.m_Capacity ) {
+        x_Erase(shard, prev(shard.m_List[eB2].end()));
+    }
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+void CShardedCache<TKey, TValue, THash, TLock>::x_MakeRoom(SShard& shard,
+                                                           TWeight weight,
+                                                           bool    in_b2)
+{
+    while (shard.m_Weight[eT1] + shard.m_Weight[eT2] + weight >
+           shard.m_Capacity) {
+        EList from = eT1;
+        if (m_Eviction == eCacheEvict_ARC) {
+            // Replace from T1 while it exceeds its target size
+            TWeight t1 = shard.m_Weight[eT1];
+            bool from_t1 = !shard.m_List[eT1].empty()  &&
+                (t1 > shard.m_Target  ||
+                 (in_b2  &&  t1 == shard.m_Target)  ||
+                 shard.m_List[eT2].empty());
+            from = from_t1 ? eT1 : eT2;
+        }
+        _ASSERT( !shard.m_List[from].empty() );
+        TListIter victim = prev(shard.m_List[from].end());
+        ++shard.m_Stats.m_Evictions;
+        --shard.m_Stats.m_Count;
+        shard.m_Stats.m_Weight -= victim->m_Weight;
+        if (m_Eviction == eCacheEvict_ARC) {
+            x_Move(shard, victim, from == eT1 ? eB1 : eB2);
+        }
+        else {
+            x_Erase(shard, victim);
+        }
+    }
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+bool CShardedCache<TKey, TValue, THash, TLock>::Get(const TKeyType& key,
+                                                    TValueType&     value)
+{
+    Uint8 hash = x_Mix(THash()(key));
+    SShard& shard = x_GetShard(hash);
+    TGuardType guard(shard.m_Lock);
+    if (m_Eviction == eCacheEvict_TinyLFU) {
+        shard.m_Sketch.Increment(hash);
+    }
+    typename TIndex::iterator it = shard.m_Index.find(key);
+    if (it == shard.m_Index.end()  ||
+        it->second->m_List == eB1  ||  it->second->m_List == eB2) {
+        ++shard.m_Stats.m_Misses;
+        return false;
+    }
+    TListIter node = it->second;
+    if (node->m_Expires  &&  node->m_Expires <= x_Now()) {
+        x_Expire(shard, node);
+        ++shard.m_Stats.m_Misses;
+        return false;
+    }
+    // Second hit promotes ARC element to the frequent list
+    x_Move(shard, node, m_Eviction == eCacheEvict_ARC ? eT2 : eT1);
+    ++shard.m_Stats.m_Hits;
+    value = node->m_Value;
+    return true;
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+bool CShardedCache<TKey, TValue, THash, TLock>::x_Add(const TKeyType&   key,
+                                                      const TValueType& value,
+                                                      TWeight           weight,
+                                                      double            ttl)
+{
+    Uint8 hash = x_Mix(THash()(key));
+    SShard& shard = x_GetShard(hash);
+    TGuardType guard(shard.m_Lock);
+    if (m_Eviction == eCacheEvict_TinyLFU) {
+        shard.m_Sketch.Increment(hash);
+    }
+    typename TIndex::iterator it = shard.m_Index.find(key);
+    TListIter node;
+    bool live = false;
+    if (it != shard.m_Index.end()) {
+        node = it->second;
+        live = node->m_List == eT1  ||  node->m_List == eT2;
+        if ( live ) {
+            // Take the old value out, it will be put back with the new weight
+            --shard.m_Stats.m_Count;
+            shard.m_Stats.m_Weight -= node->m_Weight;
+        }
+    }
+    if (weight > shard.m_Capacity) {
+        if (it != shard.m_Index.end()) {
+            x_Erase(shard, node);
+        }
+        ++shard.m_Stats.m_Rejections;
+        return false;
+    }
+
+    EList to = eT1;
+    bool in_b2 = false;
+    TList detached;
+    if (it != shard.m_Index.end()) {
+        if (m_Eviction == eCacheEvict_ARC) {
+            // Adapt target size of T1: a hit in B1 means T1 was too small,
+            // a hit in B2 means T2 was too small.
+            TWeight b1 = shard.m_Weight[eB1], b2 = shard.m_Weight[eB2];
+            if (node->m_List == eB1) {
+                TWeight delta = b2 > b1  &&  b1 ? weight * (b2 / b1) : weight;
+                shard.m_Target = min(shard.m_Capacity,
+                                     shard.m_Target + delta);
+            }
+            else if (node->m_List == eB2) {
+                TWeight delta = b1 > b2  &&  b2 ? weight * (b1 / b2) : weight;
+                shard.m_Target = shard.m_Target > delta ?
+                    shard.m_Target - delta : 0;
+                in_b2 = true;
+            }
+            to = eT2;
+        }
+        // Detach the node while making room so that it is not evicted
+        shard.m_Weight[node->m_List] -= node->m_Weight;
+        detached.splice(detached.begin(), shard.m_List[node->m_List], node);
+    }
+    else if (m_Eviction == eCacheEvict_TinyLFU) {
+        shard.m_Sketch.Reserve(shard.m_Index.size() + 1);
+    }
+    if (it == shard.m_Index.end()  &&
+        m_Eviction == eCacheEvict_TinyLFU  &&
+        shard.m_Weight[eT1] + weight > shard.m_Capacity) {
+        // Admit the new element only if it is more popular than the
+        // element it is going to replace first
+        const TKeyType& victim = shard.m_List[eT1].back().m_Key;
+        if (shard.m_Sketch.Estimate(hash) <=
+            shard.m_Sketch.Estimate(x_Mix(THash()(victim)))) {
+            ++shard.m_Stats.m_Rejections;
+            return false;
+        }
+    }
+
+    x_MakeRoom(shard, weight, in_b2);
+
+    if (it == shard.m_Index.end()) {
+        shard.m_List[to].push_front(SNode(key));
+        node = shard.m_List[to].begin();
+        node->m_List = to;
+        shard.m_Index[key] = node;
+    }
+    else {
+        shard.m_List[to].splice(shard.m_List[to].begin(), detached, node);
+        node->m_List = to;
+    }
+    node->m_Value = value;
+    node->m_Weight = weight;
+    node->m_Expires = ttl > 0 ? x_Now() + ttl : 0;
+    shard.m_Weight[to] += weight;
+    ++shard.m_Stats.m_Insertions;
+    ++shard.m_Stats.m_Count;
+    shard.m_Stats.m_Weight += weight;
+    if (m_Eviction == eCacheEvict_ARC) {
+        x_TrimGhosts(shard);
+    }
+    return true;
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+bool CShardedCache<TKey, TValue, THash, TLock>::Remove(const TKeyType& key)
+{
+    SShard& shard = x_GetShard(x_Mix(THash()(key)));
+    TGuardType guard(shard.m_Lock);
+    typename TIndex::iterator it = shard.m_Index.find(key);
+    if (it == shard.m_Index.end()) {
+        return false;
+    }
+    TListIter node = it->second;
+    bool live = node->m_List == eT1  ||  node->m_List == eT2;
+    if ( live ) {
+        --shard.m_Stats.m_Count;
+        shard.m_Stats.m_Weight -= node->m_Weight;
+    }
+    x_Erase(shard, node);
+    return live;
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+void CShardedCache<TKey, TValue, THash, TLock>::Clear(void)
+{
+    NON_CONST_ITERATE(typename vector< unique_ptr<SShard> >, it, m_Shards) {
+        SShard& shard = **it;
+        TGuardType guard(shard.m_Lock);
+        shard.m_Index.clear();
+        for (int i = eT1;  i <= eB2;  ++i) {
+            shard.m_List[i].clear();
+            shard.m_Weight[i] = 0;
+        }
+        shard.m_Target = 0;
+        shard.m_Stats.m_Count = 0;
+        shard.m_Stats.m_Weight = 0;
+    }
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+void CShardedCache<TKey, TValue, THash, TLock>::PurgeExpired(void)
+{
+    double now = x_Now();
+    NON_CONST_ITERATE(typename vector< unique_ptr<SShard> >, it, m_Shards) {
+        SShard& shard = **it;
+        TGuardType guard(shard.m_Lock);
+        for (int i = eT1;  i <= eT2;  ++i) {
+            TList& lst = shard.m_List[i];
+            for (TListIter node = lst.begin();  node != lst.end(); ) {
+                TListIter cur = node++;
+                if (cur->m_Expires  &&  cur->m_Expires <= now) {
+                    x_Expire(shard, cur);
+                }
+            }
+        }
+    }
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+void CShardedCache<TKey, TValue, THash, TLock>::SetCapacity(TWeight capacity)
+{
+    if (capacity == 0) {
+        NCBI_THROW(CCacheException, eOtherError,
+                   "Cache capacity must be positive");
+    }
+    m_Capacity = capacity;
+    TWeight per_shard = capacity / m_Shards.size();
+    if (per_shard == 0) {
+        per_shard = 1;
+    }
+    NON_CONST_ITERATE(typename vector< unique_ptr<SShard> >, it, m_Shards) {
+        SShard& shard = **it;
+        TGuardType guard(shard.m_Lock);
+        shard.m_Capacity = per_shard;
+        shard.m_Target = min(shard.m_Target, per_shard);
+        x_MakeRoom(shard, 0, false);
+        if (m_Eviction == eCacheEvict_ARC) {
+            x_TrimGhosts(shard);
+        }
+    }
+}
+
+
+template <class TKey, class TValue, class THash, class TLock>
+SCacheStats CShardedCache<TKey, TValue, THash, TLock>::GetStats(bool reset)
+{
+    SCacheStats stats;
+    NON_CONST_ITERATE(typename vector< unique_ptr<SShard> >, it, m_Shards) {
+        SShard& shard = **it;
+        TGuardType guard(shard.m_Lock);
+        stats += shard.m_Stats;
+        if ( reset ) {
+            SCacheStats current;
+            current.m_Count  = shard.m_Stats.m_Count;
+            current.m_Weight = shard.m_Stats.m_Weight;
+            shard.m_Stats = current;
+        }
+    }
+    return stats;
+}
+
+
+/* @} */
+
+END_NCBI_SCOPE
+
+#endif  // UTIL___NCBI_SHARDED_CACHE__HPP
@@ -0,0 +1,423 @@
+#ifndef UTIL___ROW_READER_MAPPED__HPP
+#define UTIL___ROW_READER_MAPPED__HPP
+
+/*  $Id$
+* ===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+* Authors: agent
+*
+* File Description:
+*   CMappedRowReader - zero-copy reader of delimited rows from a memory
+*   mapped file, with optional parallel tokenization
+*
+* ===========================================================================
+*/
+
+#include <corelib/ncbithr.hpp>
+#include <util/row_reader.hpp>
+
+
+BEGIN_NCBI_SCOPE
+
+
+/// Description of a delimited source read by CMappedRowReader.
+///
+/// The reader does not use the CRowReader<> traits: the traits callbacks
+/// work on one row at a time and on string copies of the data, which is
+/// exactly what CMappedRowReader avoids. The formats below reproduce the
+/// rules of the corresponding traits (see row_reader_ncbi_tsv.hpp,
+/// row_reader_iana_tsv.hpp and row_reader_iana_csv.hpp) for reading;
+/// validation is not supported.
+struct SRR_MappedFormat
+{
+    enum EFlags {
+        /// The first non empty row holds the field names
+        fHeader   = (1 << 0),
+        /// Fields may be enclosed in double quotes (RFC 4180); quoted
+        /// fields may contain separators, line breaks and doubled quotes
+        fQuotes   = (1 << 1),
+        /// NCBI TSV rules: the first line starting with '#' holds the
+        /// field names, other lines starting with '##' are metadata and
+        /// with '#' are comments; '-' is translated to an empty string and
+        /// 'na' to NULL
+        fNCBI_TSV = (1 << 2)
+    };
+    typedef int TFlags;  ///< Bit-wise OR of EFlags
+
+    SRR_MappedFormat(char separator = '\t', TFlags flags = 0)
+        : m_Separator(separator), m_Flags(flags)
+    {}
+
+    static SRR_MappedFormat NCBI_TSV(void)
+    { return SRR_MappedFormat('\t', fNCBI_TSV); }
+
+    static SRR_MappedFormat IANA_TSV(bool has_header = true)
+    { return SRR_MappedFormat('\t', has_header ? fHeader : 0); }
+
+    static SRR_MappedFormat IANA_CSV(bool has_header = true)
+    { return SRR_MappedFormat(',', fQuotes | (has_header ? fHeader : 0)); }
+
+    char   m_Separator;
+    TFlags m_Flags;
+};
+
+
+class CMappedRowReader;
+template <bool kQuotes> class CRR_Tokenizer;
+
+
+/// A single field of a row read by CMappedRowReader.
+/// The field refers to the source data; the value is converted (and, for
+/// quoted fields, unescaped) only when it is requested.
+class NCBI_XUTIL_EXPORT CRR_MappedField
+{
+public:
+    /// Get the converted field value
+    /// @note
+    ///  Available specializations: string, CTempString, bool, ints, floats,
+    ///  CTime
+    /// @exception
+    ///  Throws CRowReaderException if there is conversion problem or the
+    ///  field value is NULL
+    template <typename TValue>
+    TValue Get(void) const;
+
+    /// Get the converted field value or a default value if the field is NULL
+    template <typename TValue>
+    TValue GetWithDefault(const TValue& default_value) const;
+
+    /// Get the field value converted to CTime using the given format
+    CTime Get(const CTimeFormat& fmt) const;
+
+    /// Check if the field value is NULL
+    bool IsNull(void) const;
+
+    /// Get the field data exactly as they are in the source
+    CTempString GetOriginalData(void) const
+    { return CTempString(m_Data, m_Size); }
+
+    /// Get the field value: the original data without the enclosing
+    /// quotes and translated according to the format rules.
+    /// @note
+    ///  The value refers to the source data unless the field has doubled
+    ///  quotes inside. In that case it refers to a buffer which is valid
+    ///  till the reader advances to the next row.
+    /// @exception
+    ///  Throws CRowReaderException if the field value is NULL
+    CTempString GetValue(void) const;
+
+    CRR_MappedField(void)
+        : m_Data(nullptr), m_Size(0), m_Flags(0), m_Unescaped(false)
+    {}
+
+private:
+    friend class CMappedRowReader;
+
+    const char*     m_Data;
+    size_t          m_Size;
+    int             m_Flags;
+
+    // Unescaped value of a quoted field with doubled quotes inside
+    mutable bool    m_Unescaped;
+    mutable string  m_Value;
+};
+
+
+
+/// A row read by CMappedRowReader.
+/// @attention
+///  The row content is replaced when the reader advances to the next row.
+///  The original data (and the field values which do not need unescaping)
+///  refer to the source and stay valid as long as the reader exists.
+class NCBI_XUTIL_EXPORT CRR_MappedRow
+{
+public:
+    /// Get a row field by its 0-based number
+    /// @exception
+    ///  Throws an exception in case if the field does not exist
+    const CRR_MappedField& operator[](TFieldNo field) const;
+
+    /// Get a row field by its name
+    /// @exception
+    ///  Throws an exception in case if the field name is unknown or
+    ///  if the field does not exist
+    const CRR_MappedField& operator[](CTempString field) const;
+
+    /// Get the row type
+    ERR_RowType GetType(void) const
+    { return m_RowType; }
+
+    /// Get the number of fields in the row
+    TFieldNo GetNumberOfFields(void) const
+    { return static_cast<TFieldNo>(m_FieldsSize); }
+
+    /// Get the row data as they are in the source (without the EOL)
+    CTempString GetOriginalData(void) const
+    { return m_RawData; }
+
+    /// Get the 0-based number of the first source line of the row
+    TLineNo GetLineNo(void) const
+    { return m_LineNo; }
+
+    /// Get the 0-based position of the row in the source
+    TStreamPos GetRowPos(void) const
+    { return m_RowPos; }
+
+    CRR_MappedRow(void)
+        : m_RowType(eRR_Invalid), m_LineNo(0), m_RowPos(0),
+          m_FieldsSize(0), m_Reader(nullptr)
+    {}
+
+private:
+    friend class CMappedRowReader;
+
+    CRR_MappedRow(const CRR_MappedRow&) = delete;
+    CRR_MappedRow& operator=(const CRR_MappedRow&) = delete;
+
+    CTempString             m_RawData;
+    ERR_RowType             m_RowType;
+    TLineNo                 m_LineNo;
+    TStreamPos              m_RowPos;
+
+    // The content of the vector is reused so there is a manual control
+    // over what the current size is
+    vector<CRR_MappedField> m_Fields;
+    size_t                  m_FieldsSize;
+
+    const CMappedRowReader* m_Reader;
+};
+
+
+
+/// Fast reader of delimited rows (TSV, CSV) from a memory mapped file or
+/// a memory buffer.
+///
+/// In contrast to CRowReader<> the data are not copied: rows and fields
+/// refer to the mapped source and the values are converted only when
+/// requested. The source is split into chunks at row boundaries; the rows
+/// and fields in a chunk are located using SIMD instructions where
+/// available. Optionally the chunks are tokenized by a few worker threads
+/// while the rows are still delivered in the source order.
+///
+/// Usage:
+/// @code
+///   CMappedRowReader reader("gene2accession", SRR_MappedFormat::NCBI_TSV());
+///   reader.SetThreads(4);
+///   for (const auto& row : reader) {
+///       if (row.GetType() == eRR_Data)
+///           gene_id = row["GeneID"].Get<int>();
+///   }
+/// @endcode
+class NCBI_XUTIL_EXPORT CMappedRowReader
+{
+public:
+    /// Read rows from a file; the file is mapped into memory immediately
+    /// @exception
+    ///  Throws exceptions if the file does not exist or there are no read
+    ///  permissions
+    CMappedRowReader(const string&           filename,
+                     const SRR_MappedFormat& format = SRR_MappedFormat::NCBI_TSV());
+
+    /// Read rows from a memory buffer.
+    /// The buffer must stay valid as long as the reader and the rows are
+    /// used.
+    CMappedRowReader(const char*             data,
+                     size_t                  size,
+                     const SRR_MappedFormat& format = SRR_MappedFormat::NCBI_TSV());
+
+    ~CMappedRowReader();
+
+    /// Number of threads which tokenize the chunks of the source.
+    /// 0 or 1 means tokenizing in the calling thread (default).
+    /// @note
+    ///  Must be called before the first row is read. The parallel mode is
+    ///  available only in MT builds.
+    void SetThreads(unsigned int threads);
+
+    /// Approximate size of a chunk tokenized at once (default: 4MB).
+    /// A chunk always ends at a row boundary.
+    /// @note
+    ///  Must be called before the first row is read
+    void SetChunkSize(size_t chunk_size);
+
+    /// Advance to the next row
+    /// @return
+    ///  false if there are no more rows
+    /// @exception
+    ///  Throws CRowReaderException if the source is malformed
+    bool Next(void);
+
+    /// Get the current row
+    const CRR_MappedRow& GetRow(void) const
+    { return m_CurrentRow; }
+
+    /// Get the field names read from the source header (if any)
+    const vector<string>& GetFieldNames(void);
+
+    /// Get the 0-based field number by the field name
+    /// @exception
+    ///  Throws CRowReaderException if the name is not known
+    TFieldNo GetFieldNo(CTempString name) const;
+
+    /// Get the source name (file name or "memory buffer")
+    const string& GetSourceName(void) const
+    { return m_SourceName; }
+
+    /// Get basic context of the current row, for diagnostics
+    CRR_Context GetBasicContext(void) const;
+
+public:
+    /// A (forward-only) iterator to iterate over the rows.
+    /// Like in CRowReader<> all iterators of one reader point to the same
+    /// (current) row.
+    class CRowIterator
+    {
+    public:
+        const CRR_MappedRow& operator* (void) const
+        { return m_Reader->m_CurrentRow; }
+        const CRR_MappedRow* operator->(void) const
+        { return &m_Reader->m_CurrentRow; }
+
+        CRowIterator& operator++(void)
+        {
+            if ( !m_Reader->Next() )
+                m_Reader = nullptr;
+            return *this;
+        }
+
+        bool operator==(const CRowIterator& iter) const
+        { return m_Reader == iter.m_Reader; }
+        bool operator!=(const CRowIterator& iter) const
+        { return m_Reader != iter.m_Reader; }
+
+    private:
+        friend class CMappedRowReader;
+        CRowIterator(CMappedRowReader* reader) : m_Reader(reader) {}
+
+        CMappedRowReader* m_Reader;
+    };
+
+    /// Advance to the next row and get an iterator pointing to it
+    CRowIterator begin(void)
+    { return CRowIterator(Next() ? this : nullptr); }
+
+    CRowIterator end(void) const
+    { return CRowIterator(nullptr); }
+
+    typedef CRowIterator iterator;
+    typedef CRowIterator const_iterator;
+
+private:
+    struct SChunk;
+    class  CWorker;
+    friend class CRR_Tokenizer<false>;
+    friend class CRR_Tokenizer<true>;
+
+    void x_Init(void);
+    void x_Start(void);
+    void x_ReadHeader(void);
+    void x_Dispatch(void);
+    bool x_NextChunk(void);
+    void x_SetRow(void);
+    const char* x_FindChunkEnd(const char* begin);
+    bool x_Tokenize(SChunk& chunk, bool ncbi_tsv) const;
+
+    // Called by the worker threads
+    void x_Work(void);
+
+private:
+    string                  m_SourceName;
+    SRR_MappedFormat        m_Format;
+    unique_ptr<CMemoryFile> m_File;
+    const char*             m_Begin;
+    const char*             m_End;
+    // Beginning of the data not yet assigned to a chunk
+    const char*             m_Pos;
+
+    unsigned int            m_Threads;
+    size_t                  m_ChunkSize;
+    bool                    m_Started;
+    bool                    m_AtEnd;
+
+    vector<string>          m_FieldNames;
+    map<string, TFieldNo>   m_FieldNamesIndex;
+
+    // Chunks in the source order: being tokenized or ready to be read
+    deque<SChunk*>          m_Pending;
+    // Chunks to be tokenized by the worker threads
+    deque<SChunk*>          m_Queue;
+    vector<SChunk*>         m_Free;
+    vector<unique_ptr<SChunk>> m_Chunks;
+
+    SChunk*                 m_Current;
+    size_t                  m_CurrentIndex;  // next row in m_Current
+    TLineNo                 m_ChunkLineNo;   // first line of m_Current
+    TLineNo                 m_NextLineNo;    // first line of the next chunk
+    CRR_MappedRow           m_CurrentRow;
+
+    CFastMutex              m_Mutex;
+    CConditionVariable      m_QueueCond;
+    CConditionVariable      m_DoneCond;
+    bool                    m_Stop;
+    vector< CRef<CThread> > m_Workers;
+
+private:
+    CMappedRowReader(const CMappedRowReader&) = delete;
+    CMappedRowReader& operator=(const CMappedRowReader&) = delete;
+};
+
+
+
+template <typename TValue>
+TValue CRR_MappedField::Get(void) const
+{
+    TValue  val;
+    try {
+        CRR_Util::GetFieldValueConverted(GetValue(), val);
+    } catch (const CRowReaderException&) {
+        throw;
+    } catch (const CException& exc) {
+        NCBI_RETHROW2(exc, CRowReaderException, eFieldConvert,
+                      "Cannot convert field value to " +
+                      string(typeid(TValue).name()), nullptr);
+    } catch (const exception& exc) {
+        NCBI_THROW2(CRowReaderException, eFieldConvert, exc.what(), nullptr);
+    }
+    return val;
+}
+
+
+template <typename TValue>
+TValue CRR_MappedField::GetWithDefault(const TValue& default_value) const
+{
+    if (IsNull())
+        return default_value;
+    return Get<TValue>();
+}
+
+
+END_NCBI_SCOPE
+
+#endif  /* UTIL___ROW_READER_MAPPED__HPP */
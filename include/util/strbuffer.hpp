@@ -123,6 +123,9 @@ public:
         THROWS1((CIOException));
 
     const char* GetCurrentPos(void) const THROWS1_NONE;
+    // return: number of chars already read into buffer after current
+    //         position; they can be accessed via GetCurrentPos()
+    size_t GetAvailableChars(void) const THROWS1_NONE;
     // returns true if succeeded
     bool TrySetCurrentPos(const char* pos);
 
@@ -212,11 +215,85 @@ private:
     size_t m_BufferLockSize;
 };
 
+/////////////////////////////////////////////////////////////////////////////
+///
+/// CScatterGatherBuffer --
+///
+/// Output collected as a list of segments, ready to be written out with
+/// a single writev() call or segment by segment via IWriter.
+/// Small pieces of data are copied into pooled chunks; large data blocks
+/// may be added by reference (see AppendExternal), which avoids copying
+/// them altogether. Chunks are kept for reuse after Clear().
+
+class NCBI_XUTIL_EXPORT CScatterGatherBuffer
+{
+public:
+    struct SSegment {
+        const char* data;
+        size_t      size;
+    };
+    typedef vector<SSegment> TSegments;
+
+    CScatterGatherBuffer(size_t chunk_size = 64 * 1024);
+    ~CScatterGatherBuffer(void);
+
+    /// Append a copy of data
+    void Append(const char* data, size_t size);
+    /// Append data by reference; the data must stay valid and unchanged
+    /// until it is written out or the buffer is cleared
+    void AppendExternal(const char* data, size_t size);
+
+    /// Minimal size of data passed by reference by COStreamBuffer,
+    /// smaller blocks are copied
+    void SetExternalThreshold(size_t size);
+    size_t GetExternalThreshold(void) const;
+
+    const TSegments& GetSegments(void) const;
+    /// Total size of data
+    size_t GetSize(void) const;
+    /// Discard data, keep allocated chunks for reuse
+    void Clear(void);
+
+    /// Write all data to the writer, retrying partial writes.
+    /// On error, return the writer's result and remove what was written.
+    ERW_Result WriteTo(IWriter& writer);
+    /// Write all data to the stream
+    void WriteTo(CNcbiOstream& out)
+        THROWS1((CIOException));
+#if defined(NCBI_OS_UNIX)
+    /// Write all data to the file descriptor with writev()
+    void WriteTo(int fd)
+        THROWS1((CIOException));
+#endif
+
+private:
+    CScatterGatherBuffer(const CScatterGatherBuffer&);
+    CScatterGatherBuffer& operator=(const CScatterGatherBuffer&);
+
+    // Remove data written so far: 'segments' whole segments,
+    // 'offset' bytes of the next one, 'count' bytes in total
+    void x_Consume(size_t segments, size_t offset, size_t count);
+
+    TSegments     m_Segments;
+    size_t        m_Size;
+    vector<char*> m_Chunks;
+    size_t        m_ChunkSize;
+    size_t        m_ChunkIndex;   // current chunk
+    char*         m_ChunkPos;     // free space in current chunk
+    char*         m_ChunkEnd;
+    bool          m_LastInChunk;  // last segment ends at m_ChunkPos
+    size_t        m_ExternalThreshold;
+};
+
+
 class NCBI_XUTIL_EXPORT COStreamBuffer
 {
 public:
     COStreamBuffer(CNcbiOstream& out, bool deleteOut = false)
         THROWS1((bad_alloc));
+    // collect output in the segments buffer instead of a stream
+    COStreamBuffer(CScatterGatherBuffer& out)
+        THROWS1((bad_alloc));
     ~COStreamBuffer(void);
 
     bool fail(void) const;
@@ -311,9 +388,15 @@ public:
         THROWS1((CIOException, bad_alloc));
     void Write(CByteSourceReader& reader)
         THROWS1((CIOException, bad_alloc));
+    // write data which stays valid and unchanged until the output is
+    // written out; when collecting output in CScatterGatherBuffer,
+    // large blocks are passed by reference instead of being copied
+    void WriteExternal(const char* data, size_t dataLength)
+        THROWS1((CIOException, bad_alloc));
 
 private:
-    CNcbiOstream& m_Output;
+    CNcbiOstream* m_Output;
+    CScatterGatherBuffer* m_Segments;
     bool m_DeleteOutput;
     bool m_Closed;
 
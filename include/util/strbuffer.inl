@@ -155,6 +155,13 @@ const char* CIStreamBuffer::GetCurrentPos(void) const
     return m_CurrentPos;
 }
 
+inline
+size_t CIStreamBuffer::GetAvailableChars(void) const
+    THROWS1_NONE
+{
+    return m_DataEndPos - m_CurrentPos;
+}
+
 inline
 size_t CIStreamBuffer::GetLine(void) const
     THROWS1_NONE
@@ -182,6 +189,31 @@ Int8 CIStreamBuffer::GetStreamPosAsInt8(void) const
     return m_BufferPos + (m_CurrentPos - m_Buffer);
 }
 
+inline
+void CScatterGatherBuffer::SetExternalThreshold(size_t size)
+{
+    m_ExternalThreshold = size;
+}
+
+inline
+size_t CScatterGatherBuffer::GetExternalThreshold(void) const
+{
+    return m_ExternalThreshold;
+}
+
+inline
+const CScatterGatherBuffer::TSegments&
+CScatterGatherBuffer::GetSegments(void) const
+{
+    return m_Segments;
+}
+
+inline
+size_t CScatterGatherBuffer::GetSize(void) const
+{
+    return m_Size;
+}
+
 inline
 bool COStreamBuffer::fail(void) const
 {
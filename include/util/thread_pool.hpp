@@ -207,6 +207,24 @@ private:
 class NCBI_XUTIL_EXPORT CThreadPool
 {
 public:
+    /// How the tasks waiting for execution are stored and distributed
+    /// between the threads
+    enum EScheduling {
+        /// All tasks are kept in one queue ordered by priority.
+        /// Tasks are executed in the strict order of their priorities.
+        eGlobalQueue,
+        /// Each thread has its own queue ordered by priority, and takes
+        /// tasks from the queues of other threads ("steals" them) when
+        /// its own one is empty. Tasks added from a pooled thread go to
+        /// that thread's queue, tasks added from other threads are
+        /// distributed between the queues in turn. This reduces contention
+        /// between threads when there are many short tasks, but priorities
+        /// are respected only within each queue: a task with lower priority
+        /// may start before a task with higher priority queued for another
+        /// thread.
+        eWorkStealing
+    };
+
     /// Constructor
     /// @param queue_size
     ///   Maximum number of tasks waiting in the queue. If 0 then tasks
@@ -224,12 +242,15 @@ public:
     /// @param threads_mode
     ///   Running mode of all threads in thread pool. Values fRunDetached and
     ///   fRunAllowST are ignored.
+    /// @param scheduling
+    ///   How tasks are distributed between the threads.
     ///
-    /// @sa AddTask()
+    /// @sa AddTask(), EScheduling
     CThreadPool(unsigned int      queue_size,
                 unsigned int      max_threads,
                 unsigned int      min_threads = 2,
-                CThread::TRunMode threads_mode = CThread::fRunDefault);
+                CThread::TRunMode threads_mode = CThread::fRunDefault,
+                EScheduling       scheduling = eGlobalQueue);
 
     /// Add task to the pool for execution.
     /// @note
@@ -303,9 +324,12 @@ public:
     /// @param threads_mode
     ///   Running mode of all threads in thread pool. Values fRunDetached and
     ///   fRunAllowST are ignored.
+    /// @param scheduling
+    ///   How tasks are distributed between the threads.
     CThreadPool(unsigned int            queue_size,
                 CThreadPool_Controller* controller,
-                CThread::TRunMode       threads_mode = CThread::fRunDefault);
+                CThread::TRunMode       threads_mode = CThread::fRunDefault,
+                EScheduling             scheduling = eGlobalQueue);
 
     /// Set timeout to wait for all threads to finish before the pool
     /// should be able to destroy.
@@ -399,6 +423,9 @@ public:
     /// Get the number of currently executing tasks
     unsigned int GetExecutingTasksCount(void) const;
 
+    /// Get the scheduling mode of the pool
+    EScheduling GetScheduling(void) const;
+
     /// Does method Abort() was already called for this ThreadPool
     bool IsAborted(void) const;
 
@@ -0,0 +1,113 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ * File Description:
+ *   Convert binary applog (written by CBinaryDiagHandler) to text format.
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbidiag.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Binary applog converter
+//
+
+
+class CApplogBin2TxtApp : public CNcbiApplication
+{
+public:
+    void Init(void);
+    int  Run(void);
+};
+
+
+class CBin2TxtWriter : public INextDiagMessage
+{
+public:
+    CBin2TxtWriter(CNcbiOstream& out) : m_Out(out), m_Count(0) {}
+
+    virtual void operator()(SDiagMessage& msg)
+    {
+        msg.Write(m_Out);
+        ++m_Count;
+    }
+
+    size_t GetCount(void) const { return m_Count; }
+
+private:
+    CNcbiOstream& m_Out;
+    size_t        m_Count;
+};
+
+
+void CApplogBin2TxtApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> arg_desc(new CArgDescriptions);
+
+    arg_desc->SetUsageContext(GetArguments().GetProgramBasename(),
+        "Convert binary applog to the standard text format", false);
+
+    arg_desc->AddDefaultKey("i", "Input",
+        "binary applog file", CArgDescriptions::eInputFile, "-",
+        CArgDescriptions::fBinary);
+    arg_desc->AddDefaultKey("o", "Output",
+        "text applog file", CArgDescriptions::eOutputFile, "-");
+
+    SetupArgDescriptions(arg_desc.release());
+}
+
+
+int CApplogBin2TxtApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    CNcbiIstream& in = args["i"].AsInputFile();
+    CNcbiOstream& out = args["o"].AsOutputFile();
+
+    CBin2TxtWriter writer(out);
+    SDiagMessage::ParseBinaryStream(in, writer);
+    out.flush();
+    return out.good() ? 0 : 1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+
+int main(int argc, const char* argv[])
+{
+    return CApplogBin2TxtApp().AppMain(argc, argv);
+}
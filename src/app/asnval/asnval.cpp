@@ -1004,6 +1004,7 @@ auto_ptr<CObjectIStream> OpenUncompressedStream(const string& fname)
         case CFormatGuess::eGZip:  method = CCompressStream::eGZipFile;  break;
         case CFormatGuess::eBZip2: method = CCompressStream::eBZip2;     break;
         case CFormatGuess::eLzo:   method = CCompressStream::eLZO;       break;
+        case CFormatGuess::eZstd:  method = CCompressStream::eZstd;      break;
         default:                   method = CCompressStream::eNone;      break;
     }
     if (method != CCompressStream::eNone)
@@ -32,6 +32,8 @@
 
 #include <ncbi_pch.hpp>
 #include <corelib/ncbiapp.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbitime.hpp>
 #include <util/multipattern_search.hpp>
 
 USING_NCBI_SCOPE;
@@ -43,6 +45,8 @@ public:
     CMultipatternApp(void);
     virtual void Init(void);
     virtual int  Run (void);
+private:
+    int Benchmark(CMultipatternSearch& FSM, const string& fname, unsigned int threads);
 };
 
 
@@ -57,6 +61,12 @@ void CMultipatternApp::Init(void)
     arg_desc->AddFlag("A", "Generate an array/map data");
     arg_desc->AddFlag("D", "Generate DOT graph");
     arg_desc->AddOptionalKey("i", "InFile", "Input File", CArgDescriptions::eInputFile);
+    arg_desc->AddOptionalKey("S", "OutFile", "Save the binary FSM to be loaded by -L", CArgDescriptions::eOutputFile, CArgDescriptions::fBinary);
+    arg_desc->AddOptionalKey("L", "FsmFile", "Load the binary FSM saved by -S instead of the patterns", CArgDescriptions::eString);
+    arg_desc->AddOptionalKey("bench", "DataFile", "Search the file and report the search speed", CArgDescriptions::eString);
+    arg_desc->AddDefaultKey("threads", "Threads", "Number of threads for -bench (0 - number of CPUs)", CArgDescriptions::eInteger, "0");
+    arg_desc->SetConstraint("threads", new CArgAllow_Integers(0, 256));
+    arg_desc->SetDependency("L", CArgDescriptions::eExcludes, "i");
     arg_desc->AddExtra(0, kMax_UInt, "Search Patterns as /regex/ or \"plain string\"", CArgDescriptions::eString);
     SetupArgDescriptions(arg_desc.release());  // call CreateArgs
 };
@@ -123,12 +133,26 @@ int CMultipatternApp::Run(void)
 	}
     CMultipatternSearch FSM;
     try {
-        FSM.AddPatterns(input);
+        if (args["L"]) {
+            FSM.Load(args["L"].AsString());
+        }
+        else {
+            FSM.AddPatterns(input);
+        }
     }
     catch (string s) {
         cerr << s << "\n";
         return 1;
     }
+    if (args["S"]) {
+        FSM.Save(args["S"].AsOutputFile());
+    }
+    if (args["bench"]) {
+        return Benchmark(FSM, args["bench"].AsString(), (unsigned int)args["threads"].AsInteger());
+    }
+    if (args["S"]) {
+        return 0;
+    }
     if (args["D"]) {
         FSM.GenerateDotGraph(cout);
     }
@@ -153,6 +177,50 @@ int CMultipatternApp::Run(void)
 }
 
 
+int CMultipatternApp::Benchmark(CMultipatternSearch& FSM, const string& fname, unsigned int threads)
+{
+    Int8 length = CFile(fname).GetLength();
+    if (length < 0) {
+        cerr << "Cannot open file \'" << fname << "\'\n";
+        return 1;
+    }
+    // CMemoryFile cannot map an empty file
+    unique_ptr<CMemoryFile> file;
+    const char* data = "";
+    size_t size = 0;
+    if (length > 0) {
+        file.reset(new CMemoryFile(fname));
+        data = static_cast<const char*>(file->Map());
+        size = file->GetSize();
+    }
+    if (memchr(data, 0, size)) {
+        cerr << "File \'" << fname << "\' contains zero characters\n";
+        return 1;
+    }
+    struct {
+        const char* name;
+        CMultipatternSearch::EPrefilter prefilter;
+        unsigned int threads;
+    } runs[] = {
+        { "DFA", CMultipatternSearch::ePrefilter_Off, 1 },
+        { "DFA + scalar prefilter", CMultipatternSearch::ePrefilter_Scalar, 1 },
+        { "DFA + prefilter", CMultipatternSearch::ePrefilter_Auto, 1 },
+        { "multithreaded", CMultipatternSearch::ePrefilter_Auto, threads }
+    };
+    for (auto& run : runs) {
+        size_t found = 0;
+        FSM.SetPrefilter(run.prefilter);
+        CStopWatch sw(CStopWatch::eStart);
+        FSM.SearchBuffer(data, size, [&found](size_t, size_t) { found++; }, run.threads);
+        double elapsed = sw.Elapsed();
+        cout << run.name << ": " << found << " found, " << elapsed << " sec, "
+             << (elapsed > 0 ? size / elapsed / 1024 / 1024 : 0) << " MB/s\n";
+    }
+    FSM.SetPrefilter(CMultipatternSearch::ePrefilter_Auto);
+    return 0;
+}
+
+
 int main(int argc, const char* argv[])
 {
     return CMultipatternApp().AppMain(argc, argv);
@@ -1013,6 +1013,17 @@ else()
   set(NCBI_COMPONENT_LZO_FOUND YES)
 endif()
 
+#############################################################################
+#ZSTD
+if (ZSTD_FOUND)
+  set(NCBI_COMPONENT_ZSTD_FOUND YES)
+  set(NCBI_COMPONENT_ZSTD_INCLUDE ${ZSTD_INCLUDE_DIR})
+  set(NCBI_COMPONENT_ZSTD_LIBS ${ZSTD_LIBRARIES})
+  set(NCBI_ALL_COMPONENTS "${NCBI_ALL_COMPONENTS} ZSTD")
+else()
+  set(NCBI_COMPONENT_ZSTD_FOUND NO)
+endif()
+
 #############################################################################
 #BerkeleyDB
 if(BERKELEYDB_FOUND)
@@ -10,6 +10,7 @@ endif()
 find_package(ZLIB)
 find_package(BZip2)
 find_package(LZO)
+find_package(ZSTD)
 
 # For backward compatibility
 set(Z_INCLUDE ${ZLIB_INCLUDE_DIR})
@@ -29,6 +30,14 @@ if (LZO_FOUND)
 	set(CMPRS_LIBS ${CMPRS_LIBS} ${LZO_LIBS})
 endif()
 
+if (ZSTD_FOUND)
+	set(ZSTD_INCLUDE ${ZSTD_INCLUDE_DIR})
+	set(ZSTD_LIBS ${ZSTD_LIBRARIES})
+    set(HAVE_LIBZSTD True)
+	set(CMPRS_INCLUDE ${CMPRS_INCLUDE} ${ZSTD_INCLUDE})
+	set(CMPRS_LIBS ${CMPRS_LIBS} ${ZSTD_LIBS})
+endif()
+
 set(COMPRESS_LIBS xcompress ${CMPRS_LIBS})
 
 set(CMAKE_PREFIX_PATH ${_foo_CMAKE_PREFIX_PATH})
@@ -0,0 +1,41 @@
+# Find libzstd
+# ZSTD_FOUND - system has the Zstandard library
+# ZSTD_INCLUDE_DIR - the Zstandard include directory
+# ZSTD_LIBRARIES - The libraries needed to use Zstandard
+
+if (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
+	# in cache already
+	SET(ZSTD_FOUND TRUE)
+else (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
+	FIND_PATH(ZSTD_INCLUDE_DIR zstd.h
+		 ${ZSTD_ROOT}/include/
+		 /usr/include/
+		 /usr/local/include/
+		 /sw/lib/
+		 /sw/local/lib/
+	)
+
+	FIND_LIBRARY(ZSTD_LIBRARIES NAMES zstd libzstd
+		PATHS
+		${CMAKE_PREFIX_PATH}
+		${ZSTD_ROOT}/lib
+	)
+
+	if (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
+		 set(ZSTD_FOUND TRUE)
+	endif (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
+
+	if (ZSTD_FOUND)
+		 if (NOT ZSTD_FIND_QUIETLY)
+				message(STATUS "Found ZSTD: ${ZSTD_LIBRARIES}")
+		 endif (NOT ZSTD_FIND_QUIETLY)
+	else (ZSTD_FOUND)
+		 if (ZSTD_FIND_REQUIRED)
+				message(FATAL_ERROR "Could NOT find ZSTD")
+		else()
+			message(STATUS "Could NOT find ZSTD")
+		 endif (ZSTD_FIND_REQUIRED)
+	endif (ZSTD_FOUND)
+
+	MARK_AS_ADVANCED(ZSTD_INCLUDE_DIR ZSTD_LIBRARIES)
+endif (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
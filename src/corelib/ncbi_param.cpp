@@ -92,6 +92,26 @@ namespace {
             s_GetEnvVarName(section, variable, env_var_name).c_str() ));
     }
 
+    // Get value from the application registry. Use the active registry
+    // snapshot if any, so that no locking is required.
+    bool s_GetRegistryValue(const char* section,
+                            const char* variable,
+                            string*     value)
+    {
+        const CRegistrySnapshot* snapshot = CRegistrySnapshot::GetActive();
+        if ( snapshot ) {
+            *value = snapshot->Get(section, variable);
+            return true;
+        }
+        CMutexGuard guard(CNcbiApplication::GetInstanceMutex());
+        CNcbiApplication* app = CNcbiApplication::Instance();
+        if ( app  &&  app->HasLoadedConfig() ) {
+            *value = app->GetConfig().Get(section, variable);
+            return true;
+        }
+        return false;
+    }
+
 #ifdef _DEBUG
     static const char* const CONFIG_DUMP_SECTION = "NCBI";
     static const char* const CONFIG_DUMP_VARIABLE = "CONFIG_DUMP_VARIABLES";
@@ -161,10 +181,8 @@ bool NCBI_XNCBI_EXPORT g_GetConfigFlag(const char* section,
     }
 
     if ( section  &&  *section ) {
-        CMutexGuard guard(CNcbiApplication::GetInstanceMutex());
-        CNcbiApplication* app = CNcbiApplication::Instance();
-        if ( app  &&  app->HasLoadedConfig() ) {
-            const string& s = app->GetConfig().Get(section, variable);
+        string s;
+        if ( s_GetRegistryValue(section, variable, &s) ) {
             if ( !s.empty() ) {
                 try {
                     bool value = s_StringToBool(s);
@@ -250,10 +268,8 @@ int NCBI_XNCBI_EXPORT g_GetConfigInt(const char* section,
     }
 
     if ( section  &&  *section ) {
-        CMutexGuard guard(CNcbiApplication::GetInstanceMutex());
-        CNcbiApplication* app = CNcbiApplication::Instance();
-        if ( app  &&  app->HasLoadedConfig() ) {
-            const string& s = app->GetConfig().Get(section, variable);
+        string s;
+        if ( s_GetRegistryValue(section, variable, &s) ) {
             if ( !s.empty() ) {
                 try {
                     int value = NStr::StringToInt(s);
@@ -335,10 +351,8 @@ double NCBI_XNCBI_EXPORT g_GetConfigDouble(const char* section,
     }
 
     if ( section  &&  *section ) {
-        CMutexGuard guard(CNcbiApplication::GetInstanceMutex());
-        CNcbiApplication* app = CNcbiApplication::Instance();
-        if ( app  &&  app->HasLoadedConfig() ) {
-            const string& s = app->GetConfig().Get(section, variable);
+        string s;
+        if ( s_GetRegistryValue(section, variable, &s) ) {
             if ( !s.empty() ) {
                 try {
                     double value = NStr::StringToDouble(s,
@@ -414,10 +428,8 @@ string NCBI_XNCBI_EXPORT g_GetConfigString(const char* section,
     }
 
     if ( section  &&  *section ) {
-        CMutexGuard guard(CNcbiApplication::GetInstanceMutex());
-        CNcbiApplication* app = CNcbiApplication::Instance();
-        if ( app  &&  app->HasLoadedConfig() ) {
-            const string& v = app->GetConfig().Get(section, variable);
+        string v;
+        if ( s_GetRegistryValue(section, variable, &v) ) {
             if ( !v.empty() ) {
 #ifdef _DEBUG
                 if ( s_CanDumpConfig() ) {
@@ -41,6 +41,7 @@
 #include <corelib/error_codes.hpp>
 #include <corelib/ncbi_safe_static.hpp>
 #include <corelib/request_ctx.hpp>
+#include <corelib/perf_log.hpp>
 #include "ncbisys.hpp"
 
 #if defined(NCBI_OS_MSWIN)
@@ -158,6 +159,7 @@ CNcbiApplication::~CNcbiApplication(void)
         CMutexGuard guard(GetInstanceMutex());
         m_Instance = 0;
     }
+    CRegistrySnapshot::Deactivate(m_Config.GetPointer());
     FlushDiag(0, true);
     if (m_CinBuffer) {
         delete [] m_CinBuffer;
@@ -868,6 +870,9 @@ int CNcbiApplication::AppMain
         exit_code = m_ExitCode;
     }
 
+    // Report performance timings aggregated since the last report
+    CPerfLogger::FlushAggregated();
+
     // Application stop
     AppStop(exit_code);
 
@@ -1002,6 +1007,13 @@ bool CNcbiApplication::LoadConfig(CNcbiRegistry&        reg,
     string basename2(m_Arguments->GetProgramBasename(eFollowLinks));
     CMetaRegistry::SEntry entry;
 
+    // The compiled snapshot is used for the application registry only
+    bool use_snapshot = conf  &&  &reg == m_Config.GetPointer();
+    if ( use_snapshot  &&  x_LoadConfigSnapshot(*conf, reg_flags) ) {
+        m_ConfigLoaded = true;
+        return true;
+    }
+
     if ( !conf ) {
         if (reg.IncludeNcbircIfAllowed(reg_flags)) {
             m_ConfigPath = CMetaRegistry::FindRegistry
@@ -1055,6 +1067,9 @@ bool CNcbiApplication::LoadConfig(CNcbiRegistry&        reg,
     }
     m_ConfigPath = entry.actual_name;
     m_ConfigLoaded = true;
+    if ( use_snapshot ) {
+        x_WriteConfigSnapshot(*conf, reg_flags);
+    }
     return true;
 }
 
@@ -1066,6 +1081,116 @@ bool CNcbiApplication::LoadConfig(CNcbiRegistry& reg,
 }
 
 
+static string s_GetConfigSnapshotPath(void)
+{
+    const TXChar* path = NcbiSys_getenv(_TX("NCBI_CONFIG_SNAPSHOT"));
+    return path ? _T_STDSTRING(path) : kEmptyStr;
+}
+
+
+// Snapshot is valid only for the same configuration file name and flags.
+static string s_GetConfigSnapshotKey(const string&         conf,
+                                     CNcbiRegistry::TFlags reg_flags)
+{
+    return NStr::NumericToString(reg_flags) + ':' + conf;
+}
+
+
+// Snapshot does not keep transient entries, and the ones set through
+// the environment (NCBI_CONFIG__*) could not be looked up in it.
+static bool s_HasTransientEntries(const IRegistry& reg)
+{
+    const IRegistry::TFlags flags
+        = IRegistry::fTransient | IRegistry::fNotJustCore;
+    list<string> sections;
+    reg.EnumerateSections(&sections, flags);
+    ITERATE(list<string>, it, sections) {
+        list<string> entries;
+        reg.EnumerateEntries(*it, &entries, flags);
+        if ( !entries.empty() ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool CNcbiApplication::x_LoadConfigSnapshot(const string&         conf,
+                                            CNcbiRegistry::TFlags reg_flags)
+{
+    string path = s_GetConfigSnapshotPath();
+    if ( path.empty() ) {
+        return false;
+    }
+    CRef<CRegistrySnapshot> snapshot = CRegistrySnapshot::Open(path,
+        s_GetConfigSnapshotKey(conf, reg_flags));
+    if ( !snapshot  ||  snapshot->GetSources().empty() ) {
+        return false;
+    }
+    m_Config->ReadSnapshot(*snapshot);
+    m_ConfigPath = snapshot->GetSources().front();
+    if ( conf.empty() ) {
+        m_DefaultConfig = CDirEntry(m_ConfigPath).GetName();
+    }
+    if ( !s_HasTransientEntries(*m_Config) ) {
+        CRegistrySnapshot::Activate(*snapshot, *m_Config);
+    }
+    return true;
+}
+
+
+void CNcbiApplication::x_WriteConfigSnapshot(const string&         conf,
+                                             CNcbiRegistry::TFlags reg_flags)
+{
+    string path = s_GetConfigSnapshotPath();
+    if ( path.empty()  ||  m_ConfigPath.empty()
+         ||  s_HasTransientEntries(*m_Config) ) {
+        return;
+    }
+    // Collect all files the registry could have been loaded from, the
+    // main configuration file goes first.
+    CRegistrySnapshot::TSources sources;
+    sources.push_back(m_ConfigPath);
+    if (reg_flags & IRegistry::fWithNcbirc) {
+        string ncbirc = CMetaRegistry::FindRegistry
+            ("ncbi", CMetaRegistry::eName_RcOrIni);
+        if ( !ncbirc.empty() ) {
+            sources.push_back(ncbirc);
+        }
+    }
+    const TXChar* overrides = NcbiSys_getenv(_TX("NCBI_CONFIG_OVERRIDES"));
+    if (overrides  &&  *overrides) {
+        sources.push_back(_T_STDSTRING(overrides));
+    }
+    list<string> inherits;
+    NStr::Split(m_Config->Get("NCBI", ".Inherits"), ", ", inherits,
+                NStr::fSplit_CanSingleQuote | NStr::fSplit_MergeDelimiters |
+                NStr::fSplit_Truncate);
+    ITERATE(list<string>, it, inherits) {
+        string base = CMetaRegistry::FindRegistry(*it,
+                                                  CMetaRegistry::eName_Ini);
+        if ( base.empty() ) {
+            base = CMetaRegistry::FindRegistry(*it);
+        }
+        if ( !base.empty() ) {
+            sources.push_back(base);
+        }
+    }
+    string key = s_GetConfigSnapshotKey(conf, reg_flags);
+    try {
+        CRegistrySnapshot::Write(*m_Config, path, sources, key);
+        CRef<CRegistrySnapshot> snapshot = CRegistrySnapshot::Open(path, key);
+        if ( snapshot ) {
+            CRegistrySnapshot::Activate(*snapshot, *m_Config);
+        }
+    }
+    catch (CException& e) {
+        ERR_POST_X(20, Warning << "Failed to compile registry snapshot "
+                   << path << ": " << e.what());
+    }
+}
+
+
 CNcbiApplication::EPreparseArgs
 CNcbiApplication::PreparseArgs(int                /*argc*/,
                                const char* const* /*argv*/)
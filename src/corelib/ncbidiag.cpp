@@ -852,7 +852,8 @@ CDiagContextThreadData::CDiagContextThreadData(void)
       m_ThreadPostNumber(0),
       m_DiagCollectionSize(0),
       m_RequestCtx(new SRequestCtxWrapper),
-      m_DefaultRequestCtx(new SRequestCtxWrapper)
+      m_DefaultRequestCtx(new SRequestCtxWrapper),
+      m_AsyncRing(0)
 {
     // Default context should auto-reset on request start.
     m_RequestCtx->m_Ctx = m_DefaultRequestCtx->m_Ctx =
@@ -862,8 +863,13 @@ CDiagContextThreadData::CDiagContextThreadData(void)
 }
 
 
+static void s_ReleaseAsyncRing(SDiagAsyncRing* ring);
+
 CDiagContextThreadData::~CDiagContextThreadData(void)
 {
+    if ( m_AsyncRing ) {
+        s_ReleaseAsyncRing(m_AsyncRing);
+    }
 }
 
 
@@ -2070,7 +2076,8 @@ CDiagContext_Extra::CDiagContext_Extra(SDiagMessage::EEventType event_type)
       m_PerfStatus(0),
       m_PerfTime(0),
       m_Flushed(false),
-      m_AllowBadNames(false)
+      m_AllowBadNames(false),
+      m_Discarded(false)
 {
 }
 
@@ -2085,7 +2092,8 @@ CDiagContext_Extra::CDiagContext_Extra(int         status,
       m_PerfStatus(status),
       m_PerfTime(timespan),
       m_Flushed(false),
-      m_AllowBadNames(false)
+      m_AllowBadNames(false),
+      m_Discarded(false)
 {
     if (args.empty()) return;
     m_Args = new TExtraArgs;
@@ -2101,7 +2109,8 @@ CDiagContext_Extra::CDiagContext_Extra(const CDiagContext_Extra& args)
       m_PerfStatus(args.m_PerfStatus),
       m_PerfTime(args.m_PerfTime),
       m_Flushed(args.m_Flushed),
-      m_AllowBadNames(args.m_AllowBadNames)
+      m_AllowBadNames(args.m_AllowBadNames),
+      m_Discarded(args.m_Discarded)
 {
     (*m_Counter)++;
 }
@@ -2219,7 +2228,7 @@ CDiagContext_Extra& CDiagContext_Extra::PrintNcbiAppInfoOnRequest(void)
 
 void CDiagContext_Extra::Flush(void)
 {
-    if (m_Flushed  ||  CDiagContext::IsSetOldPostFormat()) {
+    if (m_Flushed  ||  m_Discarded  ||  CDiagContext::IsSetOldPostFormat()) {
         return;
     }
 
@@ -2318,6 +2327,7 @@ CDiagContext_Extra::operator=(const CDiagContext_Extra& args)
         m_PerfTime = args.m_PerfTime;
         m_Flushed = args.m_Flushed;
         m_AllowBadNames = args.m_AllowBadNames;
+        m_Discarded = args.m_Discarded;
         (*m_Counter)++;
     }
     return *this;
@@ -2334,6 +2344,9 @@ CDiagContext_Extra::~CDiagContext_Extra(void)
 
 bool CDiagContext_Extra::x_CanPrint(void)
 {
+    if ( m_Discarded ) {
+        return false;
+    }
     // Only allow extra events to be printed/flushed multiple times
     if (m_Flushed  &&  m_EventType != SDiagMessage::eEvent_Extra) {
         ERR_POST_ONCE(
@@ -4757,7 +4770,7 @@ bool SDiagMessage::x_ParseExtraArgs(const string& str, size_t pos)
 }
 
 
-bool SDiagMessage::ParseMessage(const string& message)
+void SDiagMessage::x_ResetFields(void)
 {
     m_Severity = eDiagSevMin;
     m_Buffer = 0;
@@ -4785,6 +4798,12 @@ bool SDiagMessage::ParseMessage(const string& message)
         m_Data = 0;
     }
     m_Data = new SDiagMessageData;
+}
+
+
+bool SDiagMessage::ParseMessage(const string& message)
+{
+    x_ResetFields();
 
     size_t pos = 0;
     try {
@@ -5747,6 +5766,336 @@ CNcbiOstream& SDiagMessage::x_NewWrite(CNcbiOstream& out_str,
 }
 
 
+// Binary applog format.
+// Each record starts with 4-byte little-endian length of the rest of the
+// record, followed by the format version and a sequence of fields. Each
+// field is a varint tag (field number and wire type) followed by either
+// a varint value or a varint length and the string data. Unknown fields
+// are skipped by the parser.
+
+enum EDiagBinWireType {
+    eDiagBinWire_Varint = 0,
+    eDiagBinWire_String = 1
+};
+
+enum EDiagBinField {
+    eDiagBinField_Severity   = 1,
+    eDiagBinField_Flags      = 2,
+    eDiagBinField_Date       = 3,  // year*10000 + month*100 + day
+    eDiagBinField_Clock      = 4,  // hour*3600 + minute*60 + second
+    eDiagBinField_NanoSec    = 5,
+    eDiagBinField_PID        = 6,
+    eDiagBinField_TID        = 7,
+    eDiagBinField_RequestId  = 8,
+    eDiagBinField_UID        = 9,
+    eDiagBinField_ProcPost   = 10,
+    eDiagBinField_ThrPost    = 11,
+    eDiagBinField_Event      = 12,
+    eDiagBinField_AppState   = 13,
+    eDiagBinField_Host       = 14,
+    eDiagBinField_Client     = 15,
+    eDiagBinField_Session    = 16,
+    eDiagBinField_AppName    = 17,
+    eDiagBinField_Message    = 18,
+    eDiagBinField_File       = 19,
+    eDiagBinField_Line       = 20,
+    eDiagBinField_Module     = 21,
+    eDiagBinField_Class      = 22,
+    eDiagBinField_Function   = 23,
+    eDiagBinField_Prefix     = 24,
+    eDiagBinField_ErrCode    = 25,
+    eDiagBinField_ErrSubCode = 26,
+    eDiagBinField_ErrText    = 27,
+    eDiagBinField_ExtraName  = 28,
+    eDiagBinField_ExtraValue = 29,
+    eDiagBinField_HitId      = 30, // Extra argument with the hit id
+    eDiagBinField_TypedExtra = 31
+};
+
+static const char   kDiagBinVersion = 1;
+static const size_t kDiagBinLengthSize = 4;
+// Longer records are treated as corrupt data
+static const size_t kDiagBinMaxRecordSize = 16*1024*1024;
+
+
+static inline void s_PutBinVarint(string& buf, Uint8 value)
+{
+    char tmp[10];
+    size_t len = 0;
+    while (value >= 0x80) {
+        tmp[len++] = char((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    tmp[len++] = char(value);
+    buf.append(tmp, len);
+}
+
+
+static inline void s_PutBinInt(string& buf, EDiagBinField field, Uint8 value)
+{
+    s_PutBinVarint(buf, (Uint8(field) << 1) | eDiagBinWire_Varint);
+    s_PutBinVarint(buf, value);
+}
+
+
+static inline void s_PutBinStr(string& buf, EDiagBinField field,
+                               const char* str, size_t len)
+{
+    s_PutBinVarint(buf, (Uint8(field) << 1) | eDiagBinWire_String);
+    s_PutBinVarint(buf, len);
+    buf.append(str, len);
+}
+
+
+static inline void s_PutBinStr(string& buf, EDiagBinField field,
+                               const char* str)
+{
+    if (str  &&  *str) {
+        s_PutBinStr(buf, field, str, strlen(str));
+    }
+}
+
+
+static inline void s_PutBinStr(string& buf, EDiagBinField field,
+                               const string& str)
+{
+    if ( !str.empty() ) {
+        s_PutBinStr(buf, field, str.data(), str.size());
+    }
+}
+
+
+static inline bool s_GetBinVarint(const char*& ptr, const char* end,
+                                  Uint8& value)
+{
+    value = 0;
+    for (int shift = 0;  ptr < end  &&  shift < 64;  shift += 7) {
+        unsigned char c = (unsigned char)*ptr++;
+        value |= Uint8(c & 0x7f) << shift;
+        if ( !(c & 0x80) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void SDiagMessage::WriteBinary(string& buf) const
+{
+    size_t start = buf.size();
+    buf.append(kDiagBinLengthSize, '\0');
+    buf += kDiagBinVersion;
+
+    s_PutBinInt(buf, eDiagBinField_Severity, m_Severity);
+    s_PutBinInt(buf, eDiagBinField_Flags, m_Flags);
+    CTime t = GetTime();
+    s_PutBinInt(buf, eDiagBinField_Date,
+        t.Year()*10000 + t.Month()*100 + t.Day());
+    s_PutBinInt(buf, eDiagBinField_Clock,
+        t.Hour()*3600 + t.Minute()*60 + t.Second());
+    s_PutBinInt(buf, eDiagBinField_NanoSec, t.NanoSecond());
+    s_PutBinInt(buf, eDiagBinField_PID, m_PID);
+    s_PutBinInt(buf, eDiagBinField_TID, m_TID);
+    s_PutBinInt(buf, eDiagBinField_RequestId, m_RequestId);
+    s_PutBinInt(buf, eDiagBinField_UID, Uint8(GetUID()));
+    s_PutBinInt(buf, eDiagBinField_ProcPost, m_ProcPost);
+    s_PutBinInt(buf, eDiagBinField_ThrPost, m_ThrPost);
+    s_PutBinInt(buf, eDiagBinField_Event, m_Event);
+    s_PutBinInt(buf, eDiagBinField_AppState, GetAppState());
+    s_PutBinStr(buf, eDiagBinField_Host, GetHost());
+    s_PutBinStr(buf, eDiagBinField_Client, GetClient());
+    s_PutBinStr(buf, eDiagBinField_Session, GetSession());
+    s_PutBinStr(buf, eDiagBinField_AppName, GetAppName());
+
+    if ( m_PrintStackTrace ) {
+        // The stack is not available when the record is decoded.
+        CNcbiOstrstream os;
+        if ( m_BufferLen ) {
+            os.write(m_Buffer, m_BufferLen);
+        }
+        s_FormatStackTrace(os, CStackTrace());
+        s_PutBinStr(buf, eDiagBinField_Message, CNcbiOstrstreamToString(os));
+    }
+    else if ( m_BufferLen ) {
+        s_PutBinStr(buf, eDiagBinField_Message, m_Buffer, m_BufferLen);
+    }
+    s_PutBinStr(buf, eDiagBinField_File, m_File);
+    if ( m_Line ) {
+        s_PutBinInt(buf, eDiagBinField_Line, m_Line);
+    }
+    s_PutBinStr(buf, eDiagBinField_Module, m_Module);
+    s_PutBinStr(buf, eDiagBinField_Class, m_Class);
+    s_PutBinStr(buf, eDiagBinField_Function, m_Function);
+    s_PutBinStr(buf, eDiagBinField_Prefix, m_Prefix);
+    if (m_ErrCode  ||  m_ErrSubCode) {
+        s_PutBinInt(buf, eDiagBinField_ErrCode, Uint4(m_ErrCode));
+        s_PutBinInt(buf, eDiagBinField_ErrSubCode, Uint4(m_ErrSubCode));
+    }
+    s_PutBinStr(buf, eDiagBinField_ErrText, m_ErrText);
+
+    const char* hit_id_name = g_GetNcbiString(eNcbiStrings_PHID);
+    ITERATE(TExtraArgs, it, m_ExtraArgs) {
+        if (it->first == hit_id_name) {
+            s_PutBinStr(buf, eDiagBinField_HitId, it->second);
+            continue;
+        }
+        s_PutBinStr(buf, eDiagBinField_ExtraName,
+            it->first.data(), it->first.size());
+        s_PutBinStr(buf, eDiagBinField_ExtraValue, it->second);
+    }
+    if ( m_TypedExtra ) {
+        s_PutBinInt(buf, eDiagBinField_TypedExtra, 1);
+    }
+
+    size_t len = buf.size() - start - kDiagBinLengthSize;
+    for (size_t i = 0; i < kDiagBinLengthSize; ++i) {
+        buf[start + i] = char((len >> (i*8)) & 0xff);
+    }
+}
+
+
+bool SDiagMessage::ParseBinary(const char* data, size_t len)
+{
+    x_ResetFields();
+    m_ExtraArgs.clear();
+
+    const char* ptr = data;
+    const char* end = data + len;
+    if (ptr >= end  ||  *ptr++ != kDiagBinVersion) {
+        return false;
+    }
+    Uint8 date = 0, clock = 0, nanosec = 0;
+    while (ptr < end) {
+        Uint8 tag, value = 0;
+        if ( !s_GetBinVarint(ptr, end, tag) ) {
+            return false;
+        }
+        string* str = 0;
+        switch ( tag >> 1 ) {
+        case eDiagBinField_Host:      str = &m_Data->m_Host;     break;
+        case eDiagBinField_Client:    str = &m_Data->m_Client;   break;
+        case eDiagBinField_Session:   str = &m_Data->m_Session;  break;
+        case eDiagBinField_AppName:   str = &m_Data->m_AppName;  break;
+        case eDiagBinField_Message:   str = &m_Data->m_Message;  break;
+        case eDiagBinField_File:      str = &m_Data->m_File;     break;
+        case eDiagBinField_Module:    str = &m_Data->m_Module;   break;
+        case eDiagBinField_Class:     str = &m_Data->m_Class;    break;
+        case eDiagBinField_Function:  str = &m_Data->m_Function; break;
+        case eDiagBinField_Prefix:    str = &m_Data->m_Prefix;   break;
+        case eDiagBinField_ErrText:   str = &m_Data->m_ErrText;  break;
+        case eDiagBinField_ExtraName:
+        case eDiagBinField_HitId:
+            m_ExtraArgs.push_back(TExtraArg((tag >> 1) == eDiagBinField_HitId ?
+                g_GetNcbiString(eNcbiStrings_PHID) : kEmptyStr, kEmptyStr));
+            str = (tag >> 1) == eDiagBinField_HitId ?
+                &m_ExtraArgs.back().second : &m_ExtraArgs.back().first;
+            break;
+        case eDiagBinField_ExtraValue:
+            if ( m_ExtraArgs.empty() ) {
+                return false;
+            }
+            str = &m_ExtraArgs.back().second;
+            break;
+        default:
+            break;
+        }
+        if ( !s_GetBinVarint(ptr, end, value) ) {
+            return false;
+        }
+        if ((tag & 1) == eDiagBinWire_String) {
+            if (value > Uint8(end - ptr)) {
+                return false;
+            }
+            if ( str ) {
+                str->assign(ptr, size_t(value));
+            }
+            ptr += value;
+            continue;
+        }
+        switch ( tag >> 1 ) {
+        case eDiagBinField_Severity:   m_Severity = EDiagSev(value);     break;
+        case eDiagBinField_Flags:      m_Flags = TDiagPostFlags(value);  break;
+        case eDiagBinField_Date:       date = value;                     break;
+        case eDiagBinField_Clock:      clock = value;                    break;
+        case eDiagBinField_NanoSec:    nanosec = value;                  break;
+        case eDiagBinField_PID:        m_PID = value;                    break;
+        case eDiagBinField_TID:        m_TID = value;                    break;
+        case eDiagBinField_RequestId:  m_RequestId = value;              break;
+        case eDiagBinField_UID:        m_Data->m_UID = TUID(value);      break;
+        case eDiagBinField_ProcPost:   m_ProcPost = value;               break;
+        case eDiagBinField_ThrPost:    m_ThrPost = value;                break;
+        case eDiagBinField_Event:      m_Event = EEventType(value);      break;
+        case eDiagBinField_AppState:
+            m_Data->m_AppState = EDiagAppState(value);
+            break;
+        case eDiagBinField_Line:       m_Line = size_t(value);           break;
+        case eDiagBinField_ErrCode:    m_ErrCode = int(Uint4(value));    break;
+        case eDiagBinField_ErrSubCode: m_ErrSubCode = int(Uint4(value)); break;
+        case eDiagBinField_TypedExtra: m_TypedExtra = value != 0;        break;
+        default:
+            break;
+        }
+    }
+    if (m_Severity < eDiagSevMin  ||  m_Severity > eDiagSevMax  ||
+        m_Event > eEvent_PerfLog  ||  !date) {
+        return false;
+    }
+
+    try {
+        m_Data->m_Time = CTime(int(date/10000), int(date/100%100),
+            int(date%100), int(clock/3600), int(clock/60%60), int(clock%60),
+            long(nanosec));
+    }
+    catch (CException&) {
+        return false;
+    }
+
+    if ( !m_Data->m_Message.empty() ) {
+        m_Buffer = m_Data->m_Message.data();
+        m_BufferLen = m_Data->m_Message.size();
+    }
+    m_File = m_Data->m_File.empty() ? 0 : m_Data->m_File.c_str();
+    m_Module = m_Data->m_Module.empty() ? 0 : m_Data->m_Module.c_str();
+    m_Class = m_Data->m_Class.empty() ? 0 : m_Data->m_Class.c_str();
+    m_Function = m_Data->m_Function.empty() ? 0 : m_Data->m_Function.c_str();
+    m_Prefix = m_Data->m_Prefix.empty() ? 0 : m_Data->m_Prefix.c_str();
+    m_ErrText = m_Data->m_ErrText.empty() ? 0 : m_Data->m_ErrText.c_str();
+    m_Format = eFormat_New;
+    return true;
+}
+
+
+void SDiagMessage::ParseBinaryStream(CNcbiIstream& in,
+                                     INextDiagMessage& func)
+{
+    SDiagMessage msg(kEmptyStr);
+    vector<char> buf;
+    unsigned char len_buf[kDiagBinLengthSize];
+    while (in.read((char*)len_buf, kDiagBinLengthSize)) {
+        size_t len = 0;
+        for (size_t i = 0; i < kDiagBinLengthSize; ++i) {
+            len |= size_t(len_buf[i]) << (i*8);
+        }
+        if (len > kDiagBinMaxRecordSize) {
+            ERR_POST_X(33, Error << "Invalid binary log record length: "
+                       << len);
+            break;
+        }
+        buf.resize(len + 1);
+        if ( !in.read(&buf[0], len) ) {
+            ERR_POST_X(33, Error << "Truncated binary log record");
+            break;
+        }
+        if ( msg.ParseBinary(&buf[0], len) ) {
+            func(msg);
+        }
+        else {
+            ERR_POST_X(34, Error << "Failed to parse binary log record");
+        }
+    }
+}
+
+
 void SDiagMessage::x_InitData(void) const
 {
     if ( !m_Data ) {
@@ -6281,6 +6630,60 @@ void CStreamDiagHandler::Post(const SDiagMessage& mess)
 }
 
 
+CBinaryDiagHandler::CBinaryDiagHandler(CNcbiOstream* os,
+                                       bool          quick_flush,
+                                       const string& stream_name)
+    : CStreamDiagHandler(os, quick_flush, stream_name),
+      m_QuickFlush(quick_flush)
+{
+}
+
+
+void CBinaryDiagHandler::Post(const SDiagMessage& mess)
+{
+    if ( !m_Stream ) {
+        return;
+    }
+    string buf;
+    mess.WriteBinary(buf);
+    WriteMessage(buf.data(), buf.size(), eDiagFile_All);
+}
+
+
+bool CBinaryDiagHandler::AllowAsyncWrite(const SDiagMessage& /*msg*/) const
+{
+    return true;
+}
+
+
+string CBinaryDiagHandler::ComposeMessage(const SDiagMessage& msg,
+                                          EDiagFileType*      file_type) const
+{
+    if ( file_type ) {
+        *file_type = eDiagFile_All;
+    }
+    string buf;
+    msg.WriteBinary(buf);
+    return buf;
+}
+
+
+void CBinaryDiagHandler::WriteMessage(const char*   buf,
+                                      size_t        len,
+                                      EDiagFileType /*file_type*/)
+{
+    if ( !m_Stream ) {
+        return;
+    }
+    CDiagLock lock(CDiagLock::ePost);
+    m_Stream->clear();
+    m_Stream->write(buf, len);
+    if (m_QuickFlush) {
+        *m_Stream << NcbiFlush;
+    }
+}
+
+
 CDiagFileHandleHolder::CDiagFileHandleHolder(const string& fname,
                                              CDiagHandler::TReopenFlags flags)
     : m_Handle(-1)
@@ -6991,6 +7394,174 @@ struct SAsyncDiagMessage
 };
 
 
+/// Per-thread ring buffer used by CAsyncDiagHandler when
+/// [Diag]Async_Thread_Buffer_Size is set. The posting thread is the only
+/// writer and CAsyncDiagThread is the only reader, so no locks are needed
+/// to pass messages. Each record is 8-byte aligned and consists of a header
+/// followed by either the composed message or a pointer to a heap-allocated
+/// message which does not fit in the ring.
+struct SDiagAsyncRing : public CObject
+{
+    enum ERecordType {
+        eRecord_Composed, ///< Composed message stored in the ring
+        eRecord_String,   ///< Pointer to a composed message (string*)
+        eRecord_Message,  ///< Pointer to a message to post (SDiagMessage*)
+        eRecord_Wrap      ///< Padding, continue from the start of the ring
+    };
+
+    struct SHeader
+    {
+        Uint4 m_Size;     ///< Payload size, not including the header
+        Uint2 m_Type;     ///< ERecordType
+        Uint2 m_FileType; ///< EDiagFileType
+    };
+
+    SDiagAsyncRing(size_t size);
+    ~SDiagAsyncRing(void);
+
+    /// Append new record. Return false if there's not enough free space.
+    /// Called by the posting thread only.
+    bool Push(ERecordType   type,
+              EDiagFileType file_type,
+              const void*   data,
+              size_t        size);
+
+    bool IsEmpty(void) const
+    {
+        return m_Head.load(memory_order_acquire) ==
+            m_Tail.load(memory_order_acquire);
+    }
+
+    static size_t GetRecordSize(size_t size)
+    {
+        return (sizeof(SHeader) + size + 7) & ~size_t(7);
+    }
+
+    const SHeader* GetHeader(size_t pos) const
+    {
+        return reinterpret_cast<const SHeader*>(m_Data + (pos & (m_Size - 1)));
+    }
+
+    char*          m_Data;
+    size_t         m_Size;       ///< Always a power of 2
+    atomic<size_t> m_Head;       ///< Read position, set by the consumer
+    atomic<size_t> m_Tail;       ///< Write position, set by the producer
+    Uint4          m_Generation; ///< Consumer thread the ring is known to
+};
+
+
+SDiagAsyncRing::SDiagAsyncRing(size_t size)
+    : m_Data(0),
+      m_Size(4096),
+      m_Head(0),
+      m_Tail(0),
+      m_Generation(0)
+{
+    while (m_Size < size) {
+        m_Size <<= 1;
+    }
+    m_Data = new char[m_Size];
+}
+
+
+SDiagAsyncRing::~SDiagAsyncRing(void)
+{
+    // Normally the ring is destroyed when it's empty, but be careful
+    // not to leak messages passed by pointer.
+    size_t tail = m_Tail.load(memory_order_acquire);
+    for (size_t pos = m_Head.load(memory_order_acquire); pos != tail; ) {
+        const SHeader* hdr = GetHeader(pos);
+        if (hdr->m_Type == eRecord_String) {
+            string* str;
+            memcpy(&str, hdr + 1, sizeof(str));
+            delete str;
+        }
+        else if (hdr->m_Type == eRecord_Message) {
+            SDiagMessage* msg;
+            memcpy(&msg, hdr + 1, sizeof(msg));
+            delete msg;
+        }
+        pos += GetRecordSize(hdr->m_Size);
+    }
+    delete[] m_Data;
+}
+
+
+bool SDiagAsyncRing::Push(ERecordType   type,
+                          EDiagFileType file_type,
+                          const void*   data,
+                          size_t        size)
+{
+    size_t rec_size = GetRecordSize(size);
+    size_t tail = m_Tail.load(memory_order_relaxed);
+    size_t offset = tail & (m_Size - 1);
+    // Records are never split - if there's not enough space till the
+    // end of the ring, pad it and start from the beginning.
+    size_t pad = m_Size - offset < rec_size ? m_Size - offset : 0;
+    size_t used = tail - m_Head.load(memory_order_acquire);
+    if (used + pad + rec_size > m_Size) {
+        return false;
+    }
+    if ( pad ) {
+        SHeader* wrap = reinterpret_cast<SHeader*>(m_Data + offset);
+        wrap->m_Size = Uint4(pad - sizeof(SHeader));
+        wrap->m_Type = eRecord_Wrap;
+        wrap->m_FileType = 0;
+        tail += pad;
+        offset = 0;
+    }
+    SHeader* hdr = reinterpret_cast<SHeader*>(m_Data + offset);
+    hdr->m_Size = Uint4(size);
+    hdr->m_Type = Uint2(type);
+    hdr->m_FileType = Uint2(file_type);
+    memcpy(hdr + 1, data, size);
+    m_Tail.store(tail + rec_size, memory_order_release);
+    return true;
+}
+
+
+static void s_ReleaseAsyncRing(SDiagAsyncRing* ring)
+{
+    // The ring may still be referenced by CAsyncDiagThread which will
+    // destroy it after writing all remaining messages.
+    ring->RemoveReference();
+}
+
+
+/// What to do when a per-thread buffer of CAsyncDiagHandler is full.
+enum EAsyncDiagOverflow {
+    eAsyncDiagOverflow_Block, ///< Wait until the writer frees some space
+    eAsyncDiagOverflow_Drop   ///< Drop the message and count it
+};
+
+
+NCBI_PARAM_ENUM_DECL(EAsyncDiagOverflow, Diag, Async_Overflow);
+NCBI_PARAM_ENUM_ARRAY(EAsyncDiagOverflow, Diag, Async_Overflow)
+{
+    {"Block", eAsyncDiagOverflow_Block},
+    {"Drop",  eAsyncDiagOverflow_Drop}
+};
+NCBI_PARAM_ENUM_DEF_EX(EAsyncDiagOverflow, Diag, Async_Overflow,
+                       eAsyncDiagOverflow_Block,
+                       eParam_NoThread, DIAG_ASYNC_OVERFLOW);
+typedef NCBI_PARAM_TYPE(Diag, Async_Overflow) TAsyncOverflowParam;
+
+
+/// Size of per-thread buffers for asynchronous processing, 0 to use
+/// a single queue shared by all threads.
+NCBI_PARAM_DECL(size_t, Diag, Async_Thread_Buffer_Size);
+NCBI_PARAM_DEF_EX(size_t, Diag, Async_Thread_Buffer_Size, 0,
+                  eParam_NoThread, DIAG_ASYNC_THREAD_BUFFER_SIZE);
+typedef NCBI_PARAM_TYPE(Diag, Async_Thread_Buffer_Size) TAsyncThreadBufferSizeParam;
+
+
+// How often (in nanoseconds) the writer checks per-thread buffers and
+// blocked producers re-check for free space in case a wakeup was missed.
+static const unsigned int kAsyncRingPollNSec = 100000000;
+
+
+struct SMessageBuffer;
+
 class CAsyncDiagThread : public CThread
 {
 public:
@@ -7000,6 +7571,9 @@ public:
     virtual void* Main(void);
     void Stop(void);
 
+    /// Pass the message through the current thread's ring buffer.
+    void PostToRing(const SDiagMessage& mess);
+
     bool m_NeedStop;
     Uint2 m_CntWaiters;
     CAtomicCounter m_MsgsInQueue;
@@ -7014,6 +7588,26 @@ public:
 #endif
     deque<SAsyncDiagMessage> m_MsgQueue;
     string m_ThreadSuffix;
+
+    // Per-thread buffers mode
+    typedef vector< CRef<SDiagAsyncRing> > TRings;
+    size_t m_RingSize;
+    EAsyncDiagOverflow m_Overflow;
+    Uint4 m_Generation;
+    TRings m_NewRings;       ///< Rings not yet seen by Main(), guarded by m_QueueLock
+    atomic<bool> m_Sleeping; ///< Main() is waiting for new messages
+    atomic<Uint8> m_Dropped;
+
+private:
+    void x_RingMain(SMessageBuffer** buffers);
+    void x_DrainRing(SDiagAsyncRing& ring, SMessageBuffer** buffers);
+    void x_WaitForRoom(void);
+    void x_WakeUp(void);
+    void x_WriteComposed(SMessageBuffer** buffers,
+                         const char*      data,
+                         size_t           size,
+                         EDiagFileType    file_type);
+    void x_FlushBuffers(SMessageBuffer** buffers);
 };
 
 
@@ -7066,8 +7660,19 @@ CAsyncDiagHandler::RemoveFromDiag(void)
     _ASSERT(GetDiagHandler(false) == this);
     SetDiagHandler(m_AsyncThread->m_SubHandler);
     m_AsyncThread->Stop();
+    Uint8 dropped = m_AsyncThread->m_Dropped.load();
     m_AsyncThread->RemoveReference();
     m_AsyncThread = NULL;
+    if ( dropped ) {
+        ERR_POST_X(32, Warning << "AsyncDiagHandler dropped " << dropped
+                   << " message(s) due to full per-thread buffers");
+    }
+}
+
+Uint8
+CAsyncDiagHandler::GetDroppedCount(void) const
+{
+    return m_AsyncThread ? m_AsyncThread->m_Dropped.load() : 0;
 }
 
 string
@@ -7086,6 +7691,11 @@ void
 CAsyncDiagHandler::Post(const SDiagMessage& mess)
 {
     CAsyncDiagThread* thr = m_AsyncThread;
+    if (thr->m_RingSize  &&  mess.m_Severity < GetDiagDieLevel()) {
+        thr->PostToRing(mess);
+        return;
+    }
+
     SAsyncDiagMessage async;
     if (thr->m_SubHandler->AllowAsyncWrite(mess)) {
         async.m_Composed = new string(thr->m_SubHandler->
@@ -7126,6 +7736,9 @@ CAsyncDiagHandler::Post(const SDiagMessage& mess)
 }
 
 
+static atomic<Uint4> s_AsyncDiagGeneration(0);
+
+
 CAsyncDiagThread::CAsyncDiagThread(const string& thread_suffix)
     : m_NeedStop(false),
       m_CntWaiters(0),
@@ -7134,7 +7747,12 @@ CAsyncDiagThread::CAsyncDiagThread(const string& thread_suffix)
       m_QueueSem(0, 100),
       m_DequeueSem(0, 10000000),
 #endif
-      m_ThreadSuffix(thread_suffix)
+      m_ThreadSuffix(thread_suffix),
+      m_RingSize(TAsyncThreadBufferSizeParam::GetDefault()),
+      m_Overflow(TAsyncOverflowParam::GetDefault()),
+      m_Generation(++s_AsyncDiagGeneration),
+      m_Sleeping(false),
+      m_Dropped(0)
 {
     m_MsgsInQueue.Set(0);
 }
@@ -7143,6 +7761,107 @@ CAsyncDiagThread::~CAsyncDiagThread(void)
 {}
 
 
+void
+CAsyncDiagThread::PostToRing(const SDiagMessage& mess)
+{
+    if (CThread::GetCurrentThread() == this) {
+        // Messages reported while writing can not wait for the writer.
+        m_SubHandler->Post(mess);
+        return;
+    }
+
+    CDiagContextThreadData& thr_data = CDiagContextThreadData::GetThreadData();
+    SDiagAsyncRing* ring = thr_data.m_AsyncRing;
+    if ( !ring ) {
+        ring = new SDiagAsyncRing(m_RingSize);
+        ring->AddReference();
+        thr_data.m_AsyncRing = ring;
+    }
+    if (ring->m_Generation != m_Generation) {
+        // New thread or a new handler - let Main() know about the ring.
+        ring->m_Generation = m_Generation;
+        CFastMutexGuard guard(m_QueueLock);
+        m_NewRings.push_back(CRef<SDiagAsyncRing>(ring));
+    }
+
+    SDiagAsyncRing::ERecordType type;
+    EDiagFileType file_type = eDiagFile_All;
+    string composed;
+    string* long_composed = 0;
+    SDiagMessage* message = 0;
+    const void* data;
+    size_t size;
+    if (m_SubHandler->AllowAsyncWrite(mess)) {
+        composed = m_SubHandler->ComposeMessage(mess, &file_type);
+        if (SDiagAsyncRing::GetRecordSize(composed.size()) <= ring->m_Size/4) {
+            type = SDiagAsyncRing::eRecord_Composed;
+            data = composed.data();
+            size = composed.size();
+        }
+        else {
+            // Too long to be copied to the ring, pass by pointer.
+            long_composed = new string;
+            long_composed->swap(composed);
+            type = SDiagAsyncRing::eRecord_String;
+            data = &long_composed;
+            size = sizeof(long_composed);
+        }
+    }
+    else {
+        message = new SDiagMessage(mess);
+        type = SDiagAsyncRing::eRecord_Message;
+        data = &message;
+        size = sizeof(message);
+    }
+
+    while ( !ring->Push(type, file_type, data, size) ) {
+        if (m_Overflow == eAsyncDiagOverflow_Drop) {
+            ++m_Dropped;
+            delete long_composed;
+            delete message;
+            return;
+        }
+        x_WaitForRoom();
+    }
+    // Make sure the new tail is visible before checking the flag,
+    // Main() does the opposite before going to sleep.
+    atomic_thread_fence(memory_order_seq_cst);
+    if ( m_Sleeping.load(memory_order_relaxed) ) {
+        x_WakeUp();
+    }
+}
+
+
+void
+CAsyncDiagThread::x_WakeUp(void)
+{
+    CFastMutexGuard guard(m_QueueLock);
+#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
+    m_QueueCond.SignalSome();
+#else
+    m_QueueSem.Post();
+#endif
+}
+
+
+void
+CAsyncDiagThread::x_WaitForRoom(void)
+{
+    CFastMutexGuard guard(m_QueueLock);
+    ++m_CntWaiters;
+#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
+    m_QueueCond.SignalSome();
+    m_DequeueCond.WaitForSignal(m_QueueLock, CDeadline(0, kAsyncRingPollNSec));
+#else
+    m_QueueSem.Post();
+    guard.Release();
+    m_DequeueSem.TryWait(0, kAsyncRingPollNSec);
+    guard.Guard(m_QueueLock);
+#endif
+    --m_CntWaiters;
+}
+
+
 NCBI_PARAM_DECL(size_t, Diag, Async_Buffer_Size);
 NCBI_PARAM_DEF_EX(size_t, Diag, Async_Buffer_Size, 32768,
     eParam_NoThread, DIAG_ASYNC_BUFFER_SIZE);
@@ -7190,16 +7909,21 @@ struct SMessageBuffer
         lines = 0;
     }
 
-    bool Append(const string& str)
+    bool Append(const char* str, size_t len)
     {
-        if (!size  ||  pos + str.size() >= size  ||  lines >= max_lines) {
+        if (!size  ||  pos + len >= size  ||  lines >= max_lines) {
             return false;
         }
-        memcpy(&data[pos], str.data(), str.size());
-        pos += str.size();
+        memcpy(&data[pos], str, len);
+        pos += len;
         lines++;
         return true;
     }
+
+    bool Append(const string& str)
+    {
+        return Append(str.data(), str.size());
+    }
 };
 
 
@@ -7211,6 +7935,144 @@ NCBI_PARAM_DEF_EX(int, Diag, Async_Batch_Size, 10, eParam_NoThread,
 typedef NCBI_PARAM_TYPE(Diag, Async_Batch_Size) TAsyncBatchSizeParam;
 
 
+void
+CAsyncDiagThread::x_WriteComposed(SMessageBuffer** buffers,
+                                  const char*      data,
+                                  size_t           size,
+                                  EDiagFileType    file_type)
+{
+    SMessageBuffer* buf = buffers[file_type];
+    if ( !buf ) {
+        buf = new SMessageBuffer;
+        buffers[file_type] = buf;
+    }
+    if ( !buf->size ) {
+        // Do not use buffering.
+        m_SubHandler->WriteMessage(data, size, file_type);
+    }
+    else if ( !buf->Append(data, size) ) {
+        // Not enough space in the buffer or no waiters,
+        // try to flush if not empty.
+        if ( !buf->IsEmpty() ) {
+            m_SubHandler->WriteMessage(buf->data, buf->pos, file_type);
+            buf->Clear();
+        }
+        if ( !buf->Append(data, size) ) {
+            // The message is too long to fit in the buffer.
+            m_SubHandler->WriteMessage(data, size, file_type);
+        }
+    }
+}
+
+
+void
+CAsyncDiagThread::x_FlushBuffers(SMessageBuffer** buffers)
+{
+    for (size_t i = 0; i <= size_t(eDiagFile_All); ++i) {
+        if ( !buffers[i] ) {
+            continue;
+        }
+        if ( !buffers[i]->IsEmpty() ) {
+            m_SubHandler->WriteMessage(buffers[i]->data,
+                buffers[i]->pos, EDiagFileType(i));
+            buffers[i]->Clear();
+        }
+    }
+}
+
+
+void
+CAsyncDiagThread::x_DrainRing(SDiagAsyncRing& ring, SMessageBuffer** buffers)
+{
+    size_t head = ring.m_Head.load(memory_order_relaxed);
+    size_t tail = ring.m_Tail.load(memory_order_acquire);
+    while (head != tail) {
+        const SDiagAsyncRing::SHeader* hdr = ring.GetHeader(head);
+        const char* payload = reinterpret_cast<const char*>(hdr + 1);
+        EDiagFileType file_type = EDiagFileType(hdr->m_FileType);
+        switch ( hdr->m_Type ) {
+        case SDiagAsyncRing::eRecord_Composed:
+            x_WriteComposed(buffers, payload, hdr->m_Size, file_type);
+            break;
+        case SDiagAsyncRing::eRecord_String:
+            {
+                string* str;
+                memcpy(&str, payload, sizeof(str));
+                x_WriteComposed(buffers, str->data(), str->size(), file_type);
+                delete str;
+                break;
+            }
+        case SDiagAsyncRing::eRecord_Message:
+            {
+                SDiagMessage* msg;
+                memcpy(&msg, payload, sizeof(msg));
+                m_SubHandler->Post(*msg);
+                delete msg;
+                break;
+            }
+        default:
+            break;
+        }
+        head += SDiagAsyncRing::GetRecordSize(hdr->m_Size);
+        // Free the space immediately, the producer may be waiting for it.
+        ring.m_Head.store(head, memory_order_release);
+    }
+}
+
+
+void
+CAsyncDiagThread::x_RingMain(SMessageBuffer** buffers)
+{
+    TRings rings;
+    bool need_stop = false;
+    do {
+        {{
+            CFastMutexGuard guard(m_QueueLock);
+            m_Sleeping.store(true);
+            bool have_data = !m_NewRings.empty()  ||  m_NeedStop;
+            for (size_t i = 0; !have_data  &&  i < rings.size(); ++i) {
+                have_data = !rings[i]->IsEmpty();
+            }
+            if ( !have_data ) {
+#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
+                m_QueueCond.WaitForSignal(m_QueueLock,
+                    CDeadline(0, kAsyncRingPollNSec));
+#else
+                guard.Release();
+                m_QueueSem.TryWait(0, kAsyncRingPollNSec);
+                guard.Guard(m_QueueLock);
+#endif
+            }
+            m_Sleeping.store(false);
+            need_stop = m_NeedStop;
+            rings.insert(rings.end(), m_NewRings.begin(), m_NewRings.end());
+            m_NewRings.clear();
+        }}
+
+        for (TRings::iterator it = rings.begin(); it != rings.end(); ) {
+            // If the posting thread has already exited, no new records
+            // can appear after the ring is drained.
+            bool orphaned = (*it)->ReferencedOnlyOnce();
+            x_DrainRing(**it, buffers);
+            if ( orphaned ) {
+                it = rings.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        x_FlushBuffers(buffers);
+        if (m_CntWaiters != 0) {
+#ifdef NCBI_HAVE_CONDITIONAL_VARIABLE
+            m_DequeueCond.SignalAll();
+#else
+            m_DequeueSem.Post();
+#endif
+        }
+    } while ( !need_stop );
+}
+
+
 void*
 CAsyncDiagThread::Main(void)
 {
@@ -7229,6 +8091,14 @@ CAsyncDiagThread::Main(void)
         buffers[i] = 0;
     }
 
+    if ( m_RingSize ) {
+        x_RingMain(buffers);
+        for (size_t i = 0; i < buf_count; ++i) {
+            delete buffers[i];
+        }
+        return NULL;
+    }
+
     deque<SAsyncDiagMessage> save_msgs;
     while (!m_NeedStop) {
         {{
@@ -7253,29 +8123,8 @@ drain_messages:
             SAsyncDiagMessage msg = save_msgs.front();
             save_msgs.pop_front();
             if ( msg.m_Composed ) {
-                SMessageBuffer* buf = buffers[msg.m_FileType];
-                if ( !buf ) {
-                    buf = new SMessageBuffer;
-                    buffers[msg.m_FileType] = buf;
-                }
-                if ( !buf->size ) {
-                    // Do not use buffering.
-                    m_SubHandler->WriteMessage(msg.m_Composed->data(),
-                        msg.m_Composed->size(), msg.m_FileType);
-                }
-                else if ( !buf->Append(*msg.m_Composed) ) {
-                    // Not enough space in the buffer or no waiters,
-                    // try to flush if not empty.
-                    if ( !buf->IsEmpty() ) {
-                        m_SubHandler->WriteMessage(buf->data, buf->pos, msg.m_FileType);
-                        buf->Clear();
-                    }
-                    if ( !buf->Append(*msg.m_Composed) ) {
-                        // The message is too long to fit in the buffer.
-                        m_SubHandler->WriteMessage(msg.m_Composed->data(),
-                            msg.m_Composed->size(), msg.m_FileType);
-                    }
-                }
+                x_WriteComposed(buffers, msg.m_Composed->data(),
+                    msg.m_Composed->size(), msg.m_FileType);
                 delete msg.m_Composed;
             }
             else {
@@ -7297,16 +8146,7 @@ drain_messages:
         }
         // Flush all buffers when the queue is empty and there are no waiters.
         if (m_CntWaiters == 0) {
-            for (size_t i = 0; i < buf_count; ++i) {
-                if ( !buffers[i] ) {
-                    continue;
-                }
-                if ( !buffers[i]->IsEmpty() ) {
-                    m_SubHandler->WriteMessage(buffers[i]->data,
-                        buffers[i]->pos, EDiagFileType(i));
-                    buffers[i]->Clear();
-                }
-            }
+            x_FlushBuffers(buffers);
         }
     }
     if (m_MsgQueue.size() != 0) {
@@ -7314,14 +8154,8 @@ drain_messages:
         goto drain_messages;
     }
 
+    x_FlushBuffers(buffers);
     for (size_t i = 0; i < buf_count; ++i) {
-        if ( !buffers[i] ) {
-            continue;
-        }
-        if ( !buffers[i]->IsEmpty() ) {
-            m_SubHandler->WriteMessage(buffers[i]->data,
-                buffers[i]->pos, EDiagFileType(i));
-        }
         delete buffers[i];
     }
 
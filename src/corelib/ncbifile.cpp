@@ -34,11 +34,14 @@
 #include <corelib/ncbi_limits.h>
 #include <corelib/ncbi_limits.hpp>
 #include <corelib/ncbi_safe_static.hpp>
+#include <corelib/ncbithr.hpp>
 #include <corelib/error_codes.hpp>
 #include <corelib/ncbierror.hpp>
 #include "ncbisys.hpp"
 
 #include <stdio.h>
+#include <atomic>
+#include <exception>
 
 #if defined(NCBI_OS_MSWIN)
 #  include "ncbi_os_mswin_p.hpp"
@@ -70,6 +73,16 @@
 #    define MAP_FAILED ((void *)(-1L))
 #  endif
 #  include <sys/ioctl.h>
+#  if defined(NCBI_OS_LINUX)
+#    include <sys/syscall.h>
+#    include <sys/uio.h>
+#    if defined(__NR_io_uring_setup)  &&  defined(__has_include)
+#      if __has_include(<linux/io_uring.h>)
+#        include <linux/io_uring.h>
+#        define USE_IO_URING
+#      endif
+#    endif
+#  endif
 
 #else
 #  error "File API defined for MS Windows and UNIX platforms only"
@@ -181,6 +194,18 @@ NCBI_PARAM_DEF_EX(bool, NCBI, FileAPILogging, DEFAULT_LOGGING_VALUE,
     eParam_NoThread, NCBI_CONFIG__FILEAPILOGGING);
 
 
+// Allow CFileAsyncIO to use io_uring on Linux.
+// Registry file:
+//     [NCBI]
+//     FileAPIUseIOUring = true/false
+// Environment variable:
+//     NCBI_CONFIG__FILEAPIUSEIOURING
+//
+NCBI_PARAM_DECL(bool, NCBI, FileAPIUseIOUring);
+NCBI_PARAM_DEF_EX(bool, NCBI, FileAPIUseIOUring, true,
+    eParam_NoThread, NCBI_CONFIG__FILEAPIUSEIOURING);
+
+
 #define LOG_ERROR(subcode, log_message) \
     { \
         int saved_error = errno; \
@@ -2103,29 +2128,9 @@ bool CDirEntry::SetTimeT(const time_t* modification,
 }
 
 
-bool CDirEntry::Stat(struct SStat *buffer, EFollowLinks follow_links) const
+// Assign nanosecond fields of SStat from the original stat structure.
+static void s_SetStatNsec(CDirEntry::SStat* buffer)
 {
-    if ( !buffer ) {
-        errno = EFAULT;
-        LOG_ERROR_AND_RETURN_ERRNO(16, "CDirEntry::Stat(): NULL stat buffer passed for " + GetPath());
-    }
-
-    int errcode;
-#ifdef NCBI_OS_MSWIN
-    errcode = NcbiSys_stat(_T_XCSTRING(GetPath()), &buffer->orig);
-#else // NCBI_OS_UNIX
-    if (follow_links == eFollowLinks) {
-        errcode = stat(GetPath().c_str(), &buffer->orig);
-    } else {
-        errcode = lstat(GetPath().c_str(), &buffer->orig);
-    }
-#endif
-    if (errcode != 0) {
-        CNcbiError::SetFromErrno(GetPath());
-        return false;
-    }
-   
-    // Assign additional fields
     buffer->atime_nsec = 0;
     buffer->mtime_nsec = 0;
     buffer->ctime_nsec = 0;
@@ -2193,6 +2198,32 @@ bool CDirEntry::Stat(struct SStat *buffer, EFollowLinks follow_links) const
 #  endif
     
 #endif  // NCBI_OS_UNIX
+}
+
+
+bool CDirEntry::Stat(struct SStat *buffer, EFollowLinks follow_links) const
+{
+    if ( !buffer ) {
+        errno = EFAULT;
+        LOG_ERROR_AND_RETURN_ERRNO(16, "CDirEntry::Stat(): NULL stat buffer passed for " + GetPath());
+    }
+
+    int errcode;
+#ifdef NCBI_OS_MSWIN
+    errcode = NcbiSys_stat(_T_XCSTRING(GetPath()), &buffer->orig);
+#else // NCBI_OS_UNIX
+    if (follow_links == eFollowLinks) {
+        errcode = stat(GetPath().c_str(), &buffer->orig);
+    } else {
+        errcode = lstat(GetPath().c_str(), &buffer->orig);
+    }
+#endif
+    if (errcode != 0) {
+        CNcbiError::SetFromErrno(GetPath());
+        return false;
+    }
+   
+    s_SetStatNsec(buffer);
 
     return true;
 }
@@ -4568,207 +4599,862 @@ bool CSymLink::Copy(const string& new_path, TCopyFlags flags, size_t buf_size) c
 
 //////////////////////////////////////////////////////////////////////////////
 //
-// CFileUtil
+// CDirTreeWalker
 //
 
-/// Flags to get information about file system.
-/// Each flag corresponds to one or some fields in
-/// the CFileUtil::SFileSystemInfo structure.
-enum EFileSystemInfo {
-    fFSI_Type        = (1<<1),    ///< fs_type
-    fFSI_DiskSpace   = (1<<2),    ///< total_space, free_space
-    fFSI_BlockSize   = (1<<3),    ///< block_size
-    fFSI_FileNameMax = (1<<4),    ///< filename_max
-    fFSI_All         = 0xFF       ///< get all possible information
-};
-typedef int TFileSystemInfo;      ///< Binary OR of "EFileSystemInfo"
+namespace {
 
-// File system identification strings
-struct SFileSystem {
-    const char*                name;
-    CFileUtil::EFileSystemType type;
-};
+// Directory scheduled for reading. It is released (and OnDirEnd() called)
+// when it has been read and all its subdirectories are released.
+struct SWalkDir
+{
+    SWalkDir(const CDirTreeWalker::SEntry& e, SWalkDir* p)
+        : entry(e), parent(p), pending(1)
+        {}
 
-// File system identification table
-static const SFileSystem s_FileSystem[] = {
-    { "ADFS",    CFileUtil::eADFS    },
-    { "ADVFS",   CFileUtil::eAdvFS   },
-    { "AFFS",    CFileUtil::eAFFS    },
-    { "AUTOFS",  CFileUtil::eAUTOFS  },
-    { "CACHEFS", CFileUtil::eCacheFS },
-    { "CD9669",  CFileUtil::eCDFS    },
-    { "CDFS",    CFileUtil::eCDFS    },
-    { "DEVFS",   CFileUtil::eDEVFS   },
-    { "DFS",     CFileUtil::eDFS     },
-    { "DOS",     CFileUtil::eFAT     },
-    { "EXT",     CFileUtil::eExt     },
-    { "EXT2",    CFileUtil::eExt2    },
-    { "EXT3",    CFileUtil::eExt3    },
-    { "FAT",     CFileUtil::eFAT     },
-    { "FAT32",   CFileUtil::eFAT32   },
-    { "FDFS",    CFileUtil::eFDFS    },
-    { "FFM",     CFileUtil::eFFM     },
-    { "FFS",     CFileUtil::eFFS     },
-    { "HFS",     CFileUtil::eHFS     },
-    { "HSFS",    CFileUtil::eHSFS    },
-    { "HPFS",    CFileUtil::eHPFS    },
-    { "JFS",     CFileUtil::eJFS     },
-    { "LOFS",    CFileUtil::eLOFS    },
-    { "MFS",     CFileUtil::eMFS     },
-    { "MSFS",    CFileUtil::eMSFS    },
-    { "NFS",     CFileUtil::eNFS     },
-    { "NFS2",    CFileUtil::eNFS     },
-    { "NFSV2",   CFileUtil::eNFS     },
-    { "NFS3",    CFileUtil::eNFS     },
-    { "NFSV3",   CFileUtil::eNFS     },
-    { "NFS4",    CFileUtil::eNFS     },
-    { "NFSV4",   CFileUtil::eNFS     },
-    { "NTFS",    CFileUtil::eNTFS    },
-    { "PCFS",    CFileUtil::eFAT     },
-    { "PROC",    CFileUtil::ePROC    },
-    { "PROCFS",  CFileUtil::ePROC    },
-    { "RFS",     CFileUtil::eRFS     },
-    { "SMBFS",   CFileUtil::eSMBFS   },
-    { "SPECFS",  CFileUtil::eSPECFS  },
-    { "TMP",     CFileUtil::eTMPFS   },
-    { "UFS",     CFileUtil::eUFS     },
-    { "VXFS",    CFileUtil::eVxFS    },
-    { "XFS",     CFileUtil::eXFS     }
+    CDirTreeWalker::SEntry entry;
+    SWalkDir*              parent;
+    atomic<int>            pending;
 };
 
+} // namespace
 
-// Macros to get filesystem status information
 
-#define GET_STATVFS_INFO                                       \
-    struct statvfs st;                                         \
-    memset(&st, 0, sizeof(st));                                \
-    if (statvfs(path.c_str(), &st) != 0) {                     \
-        NCBI_THROW(CFileErrnoException, eFileSystemInfo, msg); \
-    }                                                          \
-    info->total_space  = (Uint8)st.f_bsize * st.f_blocks;      \
-    if (st.f_frsize) {                                         \
-        info->free_space = (Uint8)st.f_frsize * st.f_bavail;   \
-        info->block_size = (unsigned long)st.f_frsize;         \
-    } else {                                                   \
-        info->free_space = (Uint8)st.f_bsize * st.f_bavail;    \
-        info->block_size = (unsigned long)st.f_bsize;          \
-    }                                                          \
-    info->used_space   = info->total_space - info->free_space
+struct CDirTreeWalker::SImpl
+{
+    class CWorker;
 
+    SImpl(TFlags flags, IVisitor& visitor, unsigned int max_threads)
+        : m_Flags(flags), m_Visitor(visitor), m_MaxThreads(max_threads),
+          m_Active(0), m_Waiting(0), m_Stop(false)
+        {}
 
-#define GET_STATFS_INFO                                        \
-    struct statfs st;                                          \
-    memset(&st, 0, sizeof(st));                                \
-    if (statfs(path.c_str(), &st) != 0) {                      \
-        NCBI_THROW(CFileErrnoException, eFileSystemInfo, msg); \
-    }                                                          \
-    info->total_space  = (Uint8)st.f_bsize * st.f_blocks;      \
-    info->free_space   = (Uint8)st.f_bsize * st.f_bavail;      \
-    info->used_space   = info->total_space - info->free_space; \
-    info->block_size   = (unsigned long)st.f_bsize
+    // Worker loop, run by the calling thread and all started threads.
+    void Run(void);
+    void Push(vector<SWalkDir*>& dirs);
+    void JoinThreads(void);
 
+    bool IsStopped(void) const { return m_Stop.load(memory_order_relaxed); }
+    void RethrowError(void);
 
+private:
+    void x_ProcessDir(SWalkDir* dir);
+    void x_ReleaseDir(SWalkDir* dir);
+    bool x_ReadDir(const SEntry& dir, vector<SEntry>& entries, int* errcode);
 
-#if defined(SUPPORT_PANFS)
+    // Call visitor, convert exceptions into stopping the walk.
+    EAction x_OnEntry(const SEntry& entry);
+    EAction x_OnDirEnd(const SEntry& entry);
+    EAction x_OnError(const string& path, int errcode);
+    void    x_SetError(void);
 
-// Auxiliary function to exit from forked process with reporting errno
-// on errors to specified file descriptor 
-static void s_PipeExit(int status, int fd)
-{
-    int errcode = errno;
-    _no_warning(::write(fd, &errcode, sizeof(errcode)));
-    ::close(fd);
-    ::_exit(status);
-}
+    TFlags                  m_Flags;
+    IVisitor&               m_Visitor;
+    unsigned int            m_MaxThreads;
+    CFastMutex              m_Mutex;
+    CConditionVariable      m_Cond;
+    vector<SWalkDir*>       m_Queue;    // LIFO to keep the queue short
+    vector< CRef<CThread> > m_Threads;
+    unsigned int            m_Active;   // threads reading a directory
+    unsigned int            m_Waiting;  // idle threads
+    atomic<bool>            m_Stop;
+    exception_ptr           m_Error;
+};
 
-// Close pipe handle
-#define CLOSE_PIPE_END(fd) \
-    if (fd != -1) {        \
-        ::close(fd);       \
-        fd = -1;           \
-    }
 
-// Standard kernel calls cannot get correct information 
-// about PANFS mounts, so we use workaround for that.
-//
-// Use external method fist, if 'ncbi_panfs.so' exists and can be loaded.
-// Fall back to 'pan_df' utuility (if present).
-// Fall back to use standard OS info if none of above works.
-//
-void s_GetDiskSpace_PANFS(const string&               path,
-                          CFileUtil::SFileSystemInfo* info)
+class CDirTreeWalker::SImpl::CWorker : public CThread
 {
-    DEFINE_STATIC_FAST_MUTEX(s_Mutex);
-    CFastMutexGuard guard_mutex(s_Mutex);
+public:
+    CWorker(SImpl& impl) : m_Impl(impl) {}
 
-    // TRUE if initialization has done for EXE method
-    static bool s_InitEXE  = false;
-    static bool s_ExistEXE = false;
-    
-#if defined(ALLOW_USE_NCBI_PANFS_DLL)
+protected:
+    virtual void* Main(void)
+    {
+        m_Impl.Run();
+        return 0;
+    }
 
-    // TRUE if initialization has done for DLL method
-    static bool s_InitDLL = false;
-    static FGetDiskSpace_PANFS f_GetDiskSpace = NULL;
-   
-    if ( !s_InitDLL ) {
-        s_InitDLL = true;
+private:
+    SImpl& m_Impl;
+};
 
-        #define STRINGIFY(x) #x
-        #define TOSTRING(x) STRINGIFY(x)
-        const char* kNcbiPanfsDLL = 
-            "/opt/ncbi/" TOSTRING(NCBI_PLATFORM_BITS) "/lib/ncbi_panfs.so";
-        
-        // Check if 'ncbi_panfs.so' exists and can be loaded
-        if ( CFile(kNcbiPanfsDLL).Exists() ) {
-            void* handle = dlopen(kNcbiPanfsDLL, RTLD_NOW | RTLD_GLOBAL);
-            const char* err = NULL;
-            if ( handle ) {
-                f_GetDiskSpace = (FGetDiskSpace_PANFS)
-                    dlsym(handle, "ncbi_GetDiskSpace_PANFS");
-                if ( !f_GetDiskSpace ) {
-                    err = "Undefined symbol";
-                }
+
+void CDirTreeWalker::SImpl::Run(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    for (;;) {
+        if ( !m_Queue.empty() ) {
+            SWalkDir* dir = m_Queue.back();
+            m_Queue.pop_back();
+            ++m_Active;
+            guard.Release();
+            if ( IsStopped() ) {
+                x_ReleaseDir(dir);
             } else {
-                err = "Cannot open shared object file";
+                x_ProcessDir(dir);
             }
+            guard.Guard(m_Mutex);
+            --m_Active;
+            continue;
+        }
+        if (m_Active == 0) {
+            // Nothing to do and nobody can add more work.
+            m_Cond.SignalAll();
+            break;
+        }
+        ++m_Waiting;
+        m_Cond.WaitForSignal(m_Mutex);
+        --m_Waiting;
+    }
+}
 
-            if ( err ) {
-                char* dlerr = dlerror();
-                string msg = "Trying to get ncbi_GetDiskSpace_PANFS() function from '" +
-                             string(kNcbiPanfsDLL) + "': " + err;
-                if ( dlerr ) {
-                    msg = msg + " (" + dlerr + ")";
-                }
-                LOG_ERROR(85, msg);
-                CNcbiError::Set(CNcbiError::eUnknown, msg);
-                if ( handle) {
-                    dlclose(handle);
-                }
-            }
+
+void CDirTreeWalker::SImpl::Push(vector<SWalkDir*>& dirs)
+{
+    if ( dirs.empty() ) {
+        return;
+    }
+    CFastMutexGuard guard(m_Mutex);
+    m_Queue.insert(m_Queue.end(), dirs.begin(), dirs.end());
+    dirs.clear();
+#if defined(NCBI_THREADS)
+    // Start more threads only if there is enough work for them.
+    while (m_Queue.size() > m_Waiting  &&
+           m_Threads.size() + 1 < m_MaxThreads) {
+        CRef<CThread> thr(new CWorker(*this));
+        try {
+            thr->Run();
         }
+        catch (CThreadException&) {
+            m_MaxThreads = (unsigned int) m_Threads.size() + 1;
+            break;
+        }
+        m_Threads.push_back(thr);
     }
-   
-    if ( f_GetDiskSpace ) {
-        const char* err_msg = NULL;
-        bool do_throw = false;
-        
-        int res = f_GetDiskSpace(path.c_str(),
-                                 &info->total_space,
-                                 &info->free_space,
-                                 &err_msg);
-        switch ( res ) {
+#endif
+    if (m_Waiting > 0) {
+        m_Cond.SignalAll();
+    }
+}
 
-        case NCBI_PANFS_OK:
-            info->used_space = info->total_space - info->free_space;
-            // All done, return
-            return;
 
-        case NCBI_PANFS_THROW:
-             do_throw = true;
-             /*FALLTHRU*/
-             
-        // Same processing for all errors codes, but could be detailed
+void CDirTreeWalker::SImpl::JoinThreads(void)
+{
+    // All threads have finished Run() or are about to; no locking needed.
+    NON_CONST_ITERATE(vector< CRef<CThread> >, it, m_Threads) {
+        (*it)->Join();
+    }
+    m_Threads.clear();
+}
+
+
+void CDirTreeWalker::SImpl::RethrowError(void)
+{
+    if ( m_Error ) {
+        rethrow_exception(m_Error);
+    }
+}
+
+
+void CDirTreeWalker::SImpl::x_SetError(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    if ( !m_Error ) {
+        m_Error = current_exception();
+    }
+    m_Stop = true;
+}
+
+
+CDirTreeWalker::EAction CDirTreeWalker::SImpl::x_OnEntry(const SEntry& entry)
+{
+    try {
+        return m_Visitor.OnEntry(entry);
+    }
+    catch (...) {
+        x_SetError();
+    }
+    return eStop;
+}
+
+
+CDirTreeWalker::EAction CDirTreeWalker::SImpl::x_OnDirEnd(const SEntry& entry)
+{
+    try {
+        return m_Visitor.OnDirEnd(entry);
+    }
+    catch (...) {
+        x_SetError();
+    }
+    return eStop;
+}
+
+
+CDirTreeWalker::EAction CDirTreeWalker::SImpl::x_OnError(const string& path,
+                                                         int           errcode)
+{
+    try {
+        return m_Visitor.OnError(path, errcode);
+    }
+    catch (...) {
+        x_SetError();
+    }
+    return eStop;
+}
+
+
+void CDirTreeWalker::SImpl::x_ProcessDir(SWalkDir* dir)
+{
+    vector<SEntry> entries;
+    int errcode = 0;
+    if ( !x_ReadDir(dir->entry, entries, &errcode) ) {
+        if (x_OnError(dir->entry.path, errcode) == eStop) {
+            m_Stop = true;
+        }
+    }
+    vector<SWalkDir*> subdirs;
+    ITERATE(vector<SEntry>, it, entries) {
+        if ( IsStopped() ) {
+            break;
+        }
+        EAction action = x_OnEntry(*it);
+        if (action == eStop) {
+            m_Stop = true;
+            break;
+        }
+        if (it->type == CDirEntry::eDir  &&  action != eSkipDir) {
+            ++dir->pending;
+            subdirs.push_back(new SWalkDir(*it, dir));
+        }
+    }
+    Push(subdirs);
+    x_ReleaseDir(dir);
+}
+
+
+void CDirTreeWalker::SImpl::x_ReleaseDir(SWalkDir* dir)
+{
+    while (dir  &&  --dir->pending == 0) {
+        if ( !IsStopped()  &&  x_OnDirEnd(dir->entry) == eStop ) {
+            m_Stop = true;
+        }
+        SWalkDir* parent = dir->parent;
+        delete dir;
+        dir = parent;
+    }
+}
+
+
+#if defined(NCBI_OS_LINUX)  &&  defined(SYS_getdents64)
+// Linux kernel directory entry returned by getdents64()
+struct SLinuxDirent64 {
+    Uint8          d_ino;
+    Int8           d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[1];
+};
+#endif
+
+
+bool CDirTreeWalker::SImpl::x_ReadDir(const SEntry&   dir,
+                                      vector<SEntry>& entries,
+                                      int*            errcode)
+{
+    string base = CDirEntry::AddTrailingPathSeparator(dir.path);
+    SEntry entry;
+    entry.type     = CDirEntry::eUnknown;
+    entry.has_stat = false;
+    entry.depth    = dir.depth + 1;
+
+#if defined(NCBI_OS_UNIX)
+    // Names and d_type values; stat is done afterwards relative to
+    // the directory descriptor.
+    vector< pair<string, unsigned char> > names;
+    int flags = O_RDONLY;
+#  if defined(O_DIRECTORY)
+    flags |= O_DIRECTORY;
+#  endif
+#  if defined(O_CLOEXEC)
+    flags |= O_CLOEXEC;
+#  endif
+    int fd = open(dir.path.c_str(), flags);
+    if (fd < 0) {
+        *errcode = errno;
+        return false;
+    }
+    bool ok = true;
+#  if defined(NCBI_OS_LINUX)  &&  defined(SYS_getdents64)
+    vector<Uint8> buf(8 * 1024);  // 64K, aligned
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, &buf[0], buf.size() * sizeof(Uint8));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *errcode = errno;
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        const char* ptr = reinterpret_cast<const char*>(&buf[0]);
+        for (long pos = 0;  pos < n; ) {
+            const SLinuxDirent64* d =
+                reinterpret_cast<const SLinuxDirent64*>(ptr + pos);
+            pos += d->d_reclen;
+            if (::strcmp(d->d_name, ".") != 0  &&
+                ::strcmp(d->d_name, "..") != 0) {
+                names.push_back(make_pair(string(d->d_name), d->d_type));
+            }
+        }
+    }
+#  else
+    int dup_fd = dup(fd);
+    DIR* dp = dup_fd < 0 ? NULL : fdopendir(dup_fd);
+    if ( !dp ) {
+        *errcode = errno;
+        if (dup_fd >= 0) {
+            close(dup_fd);
+        }
+        close(fd);
+        return false;
+    }
+    errno = 0;
+    while (struct dirent* d = readdir(dp)) {
+        if (::strcmp(d->d_name, ".") != 0  &&
+            ::strcmp(d->d_name, "..") != 0) {
+#    if defined(_DIRENT_HAVE_D_TYPE)
+            names.push_back(make_pair(string(d->d_name), d->d_type));
+#    else
+            names.push_back(make_pair(string(d->d_name), 0));
+#    endif
+        }
+    }
+    if (errno != 0) {
+        *errcode = errno;
+        ok = false;
+    }
+    closedir(dp);
+#  endif
+
+    bool follow = (m_Flags & fFollowLinks) != 0;
+    entries.reserve(names.size());
+    for (size_t i = 0;  i < names.size()  &&  !IsStopped();  ++i) {
+        entry.path     = base + names[i].first;
+        entry.type     = CDirEntry::eUnknown;
+        entry.has_stat = false;
+#  if defined(DTTOIF)
+        if (names[i].second) {
+            struct stat st;
+            st.st_mode = DTTOIF(names[i].second);
+            entry.type = CDirEntry::GetType(st);
+        }
+#  endif
+        if ((m_Flags & fStat)  ||  entry.type == CDirEntry::eUnknown  ||
+            (follow  &&  entry.type == CDirEntry::eLink)) {
+            if (fstatat(fd, names[i].first.c_str(), &entry.stat.orig,
+                        follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+                // Removed after reading the directory, or a dangling link
+                if (errno == ENOENT  &&  follow  &&
+                    entry.type != CDirEntry::eUnknown) {
+                    entries.push_back(entry);
+                }
+                continue;
+            }
+            s_SetStatNsec(&entry.stat);
+            entry.has_stat = true;
+            entry.type = CDirEntry::GetType(entry.stat.orig);
+        }
+        entries.push_back(entry);
+    }
+    close(fd);
+    return ok;
+
+#else
+    unique_ptr<CDir::TEntries> contents
+        (CDir(dir.path).GetEntriesPtr(kEmptyStr, CDir::fIgnoreRecursive |
+                                                 CDir::fIgnorePath));
+    if ( !contents.get() ) {
+        *errcode = errno;
+        return false;
+    }
+    bool follow = (m_Flags & fFollowLinks) != 0;
+    entries.reserve(contents->size());
+    ITERATE(CDir::TEntries, it, *contents) {
+        if ( IsStopped() ) {
+            break;
+        }
+        entry.path = base + (*it)->GetPath();
+        if ( !CDirEntry(entry.path).Stat(&entry.stat,
+                                         follow ? eFollowLinks : eIgnoreLinks) ) {
+            continue;
+        }
+        entry.has_stat = true;
+        entry.type = CDirEntry::GetType(entry.stat.orig);
+        entries.push_back(entry);
+    }
+    return true;
+#endif
+}
+
+
+CDirTreeWalker::CDirTreeWalker(unsigned int max_threads, TFlags flags)
+    : m_MaxThreads(max_threads),
+      m_Flags(flags)
+{
+    if (m_MaxThreads == 0) {
+        m_MaxThreads = min(max(2 * GetCpuCount(), 4u), 32u);
+    }
+#if !defined(NCBI_THREADS)
+    m_MaxThreads = 1;
+#endif
+}
+
+
+CDirTreeWalker::~CDirTreeWalker(void)
+{
+}
+
+
+bool CDirTreeWalker::Walk(const string& path, IVisitor& visitor)
+{
+    SEntry top;
+    top.path     = path;
+    top.depth    = 0;
+    top.has_stat = CDirEntry(path).Stat(&top.stat, (m_Flags & fFollowLinks) ?
+                                        eFollowLinks : eIgnoreLinks);
+    if ( !top.has_stat ) {
+        return false;
+    }
+    top.type = CDirEntry::GetType(top.stat.orig);
+    EAction action = visitor.OnEntry(top);
+    if (action == eStop) {
+        return false;
+    }
+    if (top.type != CDirEntry::eDir  ||  action == eSkipDir) {
+        return true;
+    }
+
+    SImpl impl(m_Flags, visitor, m_MaxThreads);
+    vector<SWalkDir*> dirs(1, new SWalkDir(top, NULL));
+    impl.Push(dirs);
+    impl.Run();
+    impl.JoinThreads();
+    impl.RethrowError();
+    return !impl.IsStopped();
+}
+
+
+namespace {
+
+// Visitor for CDir::RemoveParallel()
+class CRemoveTreeVisitor : public CDirTreeWalker::IVisitor
+{
+public:
+    CRemoveTreeVisitor(bool ignore_missing)
+        : m_IgnoreMissing(ignore_missing), m_Failed(false)
+        {}
+
+    virtual EAction OnEntry(const CDirTreeWalker::SEntry& entry)
+    {
+        if (entry.type == CDirEntry::eDir) {
+#if !defined(NCBI_OS_MSWIN)
+            // Make directory writable for user to remove any entry inside
+            CDir(entry.path).SetMode(CDirEntry::fWrite | CDirEntry::fModeAdd,
+                                     CDirEntry::fModeNoChange,
+                                     CDirEntry::fModeNoChange);
+#endif
+            return CDirTreeWalker::eContinue;
+        }
+        CDirEntry::TRemoveFlags flags = CDirEntry::eEntryOnly;
+        if ( m_IgnoreMissing ) {
+            flags |= CDirEntry::fIgnoreMissing;
+        }
+        if ( !CDirEntry(entry.path).RemoveEntry(flags) ) {
+            return x_Fail();
+        }
+        return CDirTreeWalker::eContinue;
+    }
+
+    virtual EAction OnDirEnd(const CDirTreeWalker::SEntry& dir)
+    {
+        if (NcbiSys_rmdir(_T_XCSTRING(dir.path)) != 0  &&
+            !(m_IgnoreMissing  &&  errno == ENOENT)) {
+            LOG_ERROR(90, "CDir::RemoveParallel(): Cannot remove directory "
+                      + dir.path);
+            CNcbiError::SetFromErrno(dir.path);
+            return x_Fail();
+        }
+        return CDirTreeWalker::eContinue;
+    }
+
+    virtual EAction OnError(const string& path, int errcode)
+    {
+        if (m_IgnoreMissing  &&  errcode == ENOENT) {
+            return CDirTreeWalker::eContinue;
+        }
+        errno = errcode;
+        LOG_ERROR(91, "CDir::RemoveParallel(): Cannot get content of "
+                  + path);
+        CNcbiError::SetErrno(errcode, path);
+        return x_Fail();
+    }
+
+    bool IsFailed(void) const { return m_Failed; }
+
+private:
+    EAction x_Fail(void)
+    {
+        m_Failed = true;
+        return CDirTreeWalker::eStop;
+    }
+
+    bool         m_IgnoreMissing;
+    atomic<bool> m_Failed;
+};
+
+
+// Visitor for CDir::CopyParallel()
+class CCopyTreeVisitor : public CDirTreeWalker::IVisitor
+{
+public:
+    CCopyTreeVisitor(const string&         src,
+                     const string&         dst,
+                     CDirEntry::TCopyFlags flags)
+        : m_Src(src), m_Dst(dst), m_Flags(flags), m_Failed(false)
+        {}
+
+    virtual EAction OnEntry(const CDirTreeWalker::SEntry& entry)
+    {
+        string target = x_GetTarget(entry.path);
+        if (entry.type == CDirEntry::eDir) {
+            CDir dir(target);
+            bool ok = entry.depth ? dir.Create() : dir.CreatePath();
+            if ( !ok ) {
+                LOG_ERROR(92, "CDir::CopyParallel(): Cannot create directory "
+                          + target);
+                return x_Fail();
+            }
+            return CDirTreeWalker::eContinue;
+        }
+        if ( !CDirEntry(entry.path).Copy(target, m_Flags) ) {
+            LOG_ERROR(93, "CDir::CopyParallel(): Cannot copy " + entry.path
+                      + " to " + target);
+            return x_Fail();
+        }
+        return CDirTreeWalker::eContinue;
+    }
+
+    virtual EAction OnDirEnd(const CDirTreeWalker::SEntry& dir)
+    {
+        string target = x_GetTarget(dir.path);
+        // Preserve attributes
+        if ( m_Flags & CDirEntry::fCF_PreserveAll ) {
+            if ( !s_CopyAttrs(dir.path.c_str(), target.c_str(),
+                              CDirEntry::eDir, m_Flags) ) {
+                return x_Fail();
+            }
+        } else {
+            // Set default permissions for directory, if we should not
+            // honor umask settings.
+            if ( !NCBI_PARAM_TYPE(NCBI, FileAPIHonorUmask)::GetDefault()) {
+                if ( !CDir(target).SetMode(CDirEntry::fDefault,
+                                           CDirEntry::fDefault,
+                                           CDirEntry::fDefault) ) {
+                    return x_Fail();
+                }
+            }
+        }
+        return CDirTreeWalker::eContinue;
+    }
+
+    virtual EAction OnError(const string& path, int errcode)
+    {
+        errno = errcode;
+        LOG_ERROR(94, "CDir::CopyParallel(): Cannot get content of " + path);
+        CNcbiError::SetErrno(errcode, path);
+        return x_Fail();
+    }
+
+    bool IsFailed(void) const { return m_Failed; }
+
+private:
+    string x_GetTarget(const string& path) const
+    {
+        return CDirEntry::ConcatPath(m_Dst, path.substr(m_Src.size()));
+    }
+
+    EAction x_Fail(void)
+    {
+        m_Failed = true;
+        return CDirTreeWalker::eStop;
+    }
+
+    string                m_Src;
+    string                m_Dst;
+    CDirEntry::TCopyFlags m_Flags;
+    atomic<bool>          m_Failed;
+};
+
+} // namespace
+
+
+bool CDir::CopyParallel(const string& new_path, TCopyFlags flags,
+                        unsigned int max_threads) const
+{
+    if ( !F_ISSET(flags, fCF_Recursive)  ||  F_ISSET(flags, fCF_TopDirOnly) ) {
+        return Copy(new_path, flags);
+    }
+    CDir src(*this);
+    CDir dst(new_path);
+    bool follow = F_ISSET(flags, fCF_FollowLinks);
+    if ( follow ) {
+        src.DereferenceLink();
+        dst.DereferenceLink();
+    }
+    if (src.GetType() != eDir) {
+        LOG_ERROR_AND_RETURN_NCBI(95, "CDir::CopyParallel(): Source is not a directory: "
+                                  + src.GetPath(),
+                                  CNcbiError::eNoSuchFileOrDirectory);
+    }
+    if (dst.Exists()  &&  src.IsIdentical(dst.GetPath())) {
+        LOG_ERROR_AND_RETURN_NCBI(96, "CDir::CopyParallel(): Source and destination are the same: "
+                                  + src.GetPath(),
+                                  CNcbiError::eOperationNotPermitted);
+    }
+    CCopyTreeVisitor visitor(src.GetPath(), dst.GetPath(), flags);
+    CDirTreeWalker walker(max_threads,
+                          follow ? CDirTreeWalker::fFollowLinks : 0);
+    return walker.Walk(src.GetPath(), visitor)  &&  !visitor.IsFailed();
+}
+
+
+bool CDir::RemoveParallel(TRemoveFlags flags, unsigned int max_threads) const
+{
+    if ((flags & eRecursive) != eRecursive) {
+        return Remove(flags);
+    }
+    bool ignore_missing = (flags & fIgnoreMissing) != 0;
+    if ( !CDirEntry(GetPath()).Exists() ) {
+        if ( ignore_missing ) {
+            return true;
+        }
+        LOG_ERROR_AND_RETURN_NCBI(97, "CDir::RemoveParallel(): Directory does not exist: "
+                                  + GetPath(),
+                                  CNcbiError::eNoSuchFileOrDirectory);
+    }
+    CRemoveTreeVisitor visitor(ignore_missing);
+    CDirTreeWalker walker(max_threads);
+    return walker.Walk(GetPath(), visitor)  &&  !visitor.IsFailed();
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CFileUtil
+//
+
+/// Flags to get information about file system.
+/// Each flag corresponds to one or some fields in
+/// the CFileUtil::SFileSystemInfo structure.
+enum EFileSystemInfo {
+    fFSI_Type        = (1<<1),    ///< fs_type
+    fFSI_DiskSpace   = (1<<2),    ///< total_space, free_space
+    fFSI_BlockSize   = (1<<3),    ///< block_size
+    fFSI_FileNameMax = (1<<4),    ///< filename_max
+    fFSI_All         = 0xFF       ///< get all possible information
+};
+typedef int TFileSystemInfo;      ///< Binary OR of "EFileSystemInfo"
+
+// File system identification strings
+struct SFileSystem {
+    const char*                name;
+    CFileUtil::EFileSystemType type;
+};
+
+// File system identification table
+static const SFileSystem s_FileSystem[] = {
+    { "ADFS",    CFileUtil::eADFS    },
+    { "ADVFS",   CFileUtil::eAdvFS   },
+    { "AFFS",    CFileUtil::eAFFS    },
+    { "AUTOFS",  CFileUtil::eAUTOFS  },
+    { "CACHEFS", CFileUtil::eCacheFS },
+    { "CD9669",  CFileUtil::eCDFS    },
+    { "CDFS",    CFileUtil::eCDFS    },
+    { "DEVFS",   CFileUtil::eDEVFS   },
+    { "DFS",     CFileUtil::eDFS     },
+    { "DOS",     CFileUtil::eFAT     },
+    { "EXT",     CFileUtil::eExt     },
+    { "EXT2",    CFileUtil::eExt2    },
+    { "EXT3",    CFileUtil::eExt3    },
+    { "FAT",     CFileUtil::eFAT     },
+    { "FAT32",   CFileUtil::eFAT32   },
+    { "FDFS",    CFileUtil::eFDFS    },
+    { "FFM",     CFileUtil::eFFM     },
+    { "FFS",     CFileUtil::eFFS     },
+    { "HFS",     CFileUtil::eHFS     },
+    { "HSFS",    CFileUtil::eHSFS    },
+    { "HPFS",    CFileUtil::eHPFS    },
+    { "JFS",     CFileUtil::eJFS     },
+    { "LOFS",    CFileUtil::eLOFS    },
+    { "MFS",     CFileUtil::eMFS     },
+    { "MSFS",    CFileUtil::eMSFS    },
+    { "NFS",     CFileUtil::eNFS     },
+    { "NFS2",    CFileUtil::eNFS     },
+    { "NFSV2",   CFileUtil::eNFS     },
+    { "NFS3",    CFileUtil::eNFS     },
+    { "NFSV3",   CFileUtil::eNFS     },
+    { "NFS4",    CFileUtil::eNFS     },
+    { "NFSV4",   CFileUtil::eNFS     },
+    { "NTFS",    CFileUtil::eNTFS    },
+    { "PCFS",    CFileUtil::eFAT     },
+    { "PROC",    CFileUtil::ePROC    },
+    { "PROCFS",  CFileUtil::ePROC    },
+    { "RFS",     CFileUtil::eRFS     },
+    { "SMBFS",   CFileUtil::eSMBFS   },
+    { "SPECFS",  CFileUtil::eSPECFS  },
+    { "TMP",     CFileUtil::eTMPFS   },
+    { "UFS",     CFileUtil::eUFS     },
+    { "VXFS",    CFileUtil::eVxFS    },
+    { "XFS",     CFileUtil::eXFS     }
+};
+
+
+// Macros to get filesystem status information
+
+#define GET_STATVFS_INFO                                       \
+    struct statvfs st;                                         \
+    memset(&st, 0, sizeof(st));                                \
+    if (statvfs(path.c_str(), &st) != 0) {                     \
+        NCBI_THROW(CFileErrnoException, eFileSystemInfo, msg); \
+    }                                                          \
+    info->total_space  = (Uint8)st.f_bsize * st.f_blocks;      \
+    if (st.f_frsize) {                                         \
+        info->free_space = (Uint8)st.f_frsize * st.f_bavail;   \
+        info->block_size = (unsigned long)st.f_frsize;         \
+    } else {                                                   \
+        info->free_space = (Uint8)st.f_bsize * st.f_bavail;    \
+        info->block_size = (unsigned long)st.f_bsize;          \
+    }                                                          \
+    info->used_space   = info->total_space - info->free_space
+
+
+#define GET_STATFS_INFO                                        \
+    struct statfs st;                                          \
+    memset(&st, 0, sizeof(st));                                \
+    if (statfs(path.c_str(), &st) != 0) {                      \
+        NCBI_THROW(CFileErrnoException, eFileSystemInfo, msg); \
+    }                                                          \
+    info->total_space  = (Uint8)st.f_bsize * st.f_blocks;      \
+    info->free_space   = (Uint8)st.f_bsize * st.f_bavail;      \
+    info->used_space   = info->total_space - info->free_space; \
+    info->block_size   = (unsigned long)st.f_bsize
+
+
+
+#if defined(SUPPORT_PANFS)
+
+// Auxiliary function to exit from forked process with reporting errno
+// on errors to specified file descriptor 
+static void s_PipeExit(int status, int fd)
+{
+    int errcode = errno;
+    _no_warning(::write(fd, &errcode, sizeof(errcode)));
+    ::close(fd);
+    ::_exit(status);
+}
+
+// Close pipe handle
+#define CLOSE_PIPE_END(fd) \
+    if (fd != -1) {        \
+        ::close(fd);       \
+        fd = -1;           \
+    }
+
+// Standard kernel calls cannot get correct information 
+// about PANFS mounts, so we use workaround for that.
+//
+// Use external method fist, if 'ncbi_panfs.so' exists and can be loaded.
+// Fall back to 'pan_df' utuility (if present).
+// Fall back to use standard OS info if none of above works.
+//
+void s_GetDiskSpace_PANFS(const string&               path,
+                          CFileUtil::SFileSystemInfo* info)
+{
+    DEFINE_STATIC_FAST_MUTEX(s_Mutex);
+    CFastMutexGuard guard_mutex(s_Mutex);
+
+    // TRUE if initialization has done for EXE method
+    static bool s_InitEXE  = false;
+    static bool s_ExistEXE = false;
+    
+#if defined(ALLOW_USE_NCBI_PANFS_DLL)
+
+    // TRUE if initialization has done for DLL method
+    static bool s_InitDLL = false;
+    static FGetDiskSpace_PANFS f_GetDiskSpace = NULL;
+   
+    if ( !s_InitDLL ) {
+        s_InitDLL = true;
+
+        #define STRINGIFY(x) #x
+        #define TOSTRING(x) STRINGIFY(x)
+        const char* kNcbiPanfsDLL = 
+            "/opt/ncbi/" TOSTRING(NCBI_PLATFORM_BITS) "/lib/ncbi_panfs.so";
+        
+        // Check if 'ncbi_panfs.so' exists and can be loaded
+        if ( CFile(kNcbiPanfsDLL).Exists() ) {
+            void* handle = dlopen(kNcbiPanfsDLL, RTLD_NOW | RTLD_GLOBAL);
+            const char* err = NULL;
+            if ( handle ) {
+                f_GetDiskSpace = (FGetDiskSpace_PANFS)
+                    dlsym(handle, "ncbi_GetDiskSpace_PANFS");
+                if ( !f_GetDiskSpace ) {
+                    err = "Undefined symbol";
+                }
+            } else {
+                err = "Cannot open shared object file";
+            }
+
+            if ( err ) {
+                char* dlerr = dlerror();
+                string msg = "Trying to get ncbi_GetDiskSpace_PANFS() function from '" +
+                             string(kNcbiPanfsDLL) + "': " + err;
+                if ( dlerr ) {
+                    msg = msg + " (" + dlerr + ")";
+                }
+                LOG_ERROR(85, msg);
+                CNcbiError::Set(CNcbiError::eUnknown, msg);
+                if ( handle) {
+                    dlclose(handle);
+                }
+            }
+        }
+    }
+   
+    if ( f_GetDiskSpace ) {
+        const char* err_msg = NULL;
+        bool do_throw = false;
+        
+        int res = f_GetDiskSpace(path.c_str(),
+                                 &info->total_space,
+                                 &info->free_space,
+                                 &err_msg);
+        switch ( res ) {
+
+        case NCBI_PANFS_OK:
+            info->used_space = info->total_space - info->free_space;
+            // All done, return
+            return;
+
+        case NCBI_PANFS_THROW:
+             do_throw = true;
+             /*FALLTHRU*/
+             
+        // Same processing for all errors codes, but could be detailed
         case NCBI_PANFS_ERR:
         case NCBI_PANFS_ERR_OPEN:
         case NCBI_PANFS_ERR_QUERY:
@@ -6594,6 +7280,105 @@ size_t CFileIO::Write(const void* buf, size_t count) const
 }
 
 
+// Read or write all 'count' bytes at 'position' (reading stops at EOF).
+// Return 0 on success or system error code; 'done' is set to the number
+// of bytes transferred, even on error.
+static int s_FileIOAt(TFileHandle handle, CFileAsyncIO::EOperation op,
+                      Uint8 position, char* buf, size_t count, size_t* done)
+{
+#if defined(NCBI_OS_MSWIN)
+    const DWORD   kMax = numeric_limits<DWORD>::max();
+#elif defined(NCBI_OS_UNIX)
+    const ssize_t kMax = numeric_limits<ssize_t>::max();
+#endif
+    bool write = (op == CFileAsyncIO::eWrite);
+    *done = 0;
+
+    while (*done < count) {
+        size_t left = count - *done;
+        Uint8  pos  = position + *done;
+#if defined(NCBI_OS_MSWIN)
+        DWORD nmax = left > kMax ? kMax : (DWORD) left;
+        DWORD n = 0;
+        OVERLAPPED ov;
+        memset(&ov, 0, sizeof(ov));
+        ov.Offset     = (DWORD)  pos;
+        ov.OffsetHigh = (DWORD) (pos >> 32);
+        BOOL res = write ? ::WriteFile(handle, buf + *done, nmax, &n, &ov)
+                         : ::ReadFile (handle, buf + *done, nmax, &n, &ov);
+        if ( !res ) {
+            DWORD errcode = GetLastError();
+            if ( !write  &&  errcode == ERROR_HANDLE_EOF ) {
+                break;
+            }
+            return (int) errcode;
+        }
+        if ( n == 0 ) {
+            if ( write ) {
+                return ERROR_WRITE_FAULT;
+            }
+            break;
+        }
+#elif defined(NCBI_OS_UNIX)
+        ssize_t nmax = left > (size_t) kMax ? kMax : (ssize_t) left;
+        ssize_t n = write ? ::pwrite(int(handle), buf + *done, nmax, (off_t) pos)
+                          : ::pread (int(handle), buf + *done, nmax, (off_t) pos);
+        if ( n < 0 ) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        if ( n == 0 ) {
+            if ( write ) {
+                return EIO;
+            }
+            break;
+        }
+#endif
+        *done += n;
+    }
+    return 0;
+}
+
+
+static void s_ThrowFileIOAt(int errcode, const char* what, Uint8 position)
+{
+#if defined(NCBI_OS_MSWIN)
+    SetLastError((DWORD) errcode);
+#elif defined(NCBI_OS_UNIX)
+    errno = errcode;
+#endif
+    NCBI_THROW(CFileErrnoException, eFileIO,
+               string(what) + " failed"
+               " (position=" + NStr::NumericToString(position) + ')');
+}
+
+
+size_t CFileIO::ReadAt(Uint8 position, void* buf, size_t count) const
+{
+    size_t n = 0;
+    int errcode = s_FileIOAt(m_Handle, CFileAsyncIO::eRead, position,
+                             (char*) buf, count, &n);
+    if ( errcode ) {
+        s_ThrowFileIOAt(errcode, "Positioned read", position);
+    }
+    return n;
+}
+
+
+size_t CFileIO::WriteAt(Uint8 position, const void* buf, size_t count) const
+{
+    size_t n = 0;
+    int errcode = s_FileIOAt(m_Handle, CFileAsyncIO::eWrite, position,
+                             (char*) buf, count, &n);
+    if ( errcode ) {
+        s_ThrowFileIOAt(errcode, "Positioned write", position);
+    }
+    return n;
+}
+
+
 void CFileIO::Flush(void) const
 {
     bool res;
@@ -7042,6 +7827,545 @@ ERW_Result CFileReaderWriter::Flush(void)
 
 
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// CFileAsyncIO
+//
+
+namespace {
+
+typedef CFileAsyncIO::SRequest SAsyncRequest;
+
+
+#if defined(USE_IO_URING)
+
+// io_uring engine.  liburing is not required, the rings are set up and
+// used directly through the system calls.
+class CIOUringEngine : public CFileAsyncIO::IEngine
+{
+public:
+    CIOUringEngine(unsigned int entries);
+    virtual ~CIOUringEngine(void);
+
+    virtual void Start(SAsyncRequest& req);
+    virtual void Commit(void);
+    virtual void Reap(vector<unsigned>& slots, bool wait);
+
+    static int Setup(unsigned int entries, io_uring_params* params)
+    {
+        return (int) syscall(__NR_io_uring_setup, entries, params);
+    }
+
+private:
+    // Number of prepared entries not consumed by the kernel yet.
+    unsigned x_GetUnsubmitted(void) const
+    {
+        return *m_SqTail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE);
+    }
+    int  x_Enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+    void x_Close(void);
+    // Process completion, return TRUE if the request is finished.
+    bool x_Complete(SAsyncRequest& req, int res);
+
+    int           m_Fd;
+    void*         m_SqRing;
+    size_t        m_SqRingSize;
+    void*         m_CqRing;
+    size_t        m_CqRingSize;
+    io_uring_sqe* m_Sqes;
+    size_t        m_SqesSize;
+    unsigned*     m_SqHead;
+    unsigned*     m_SqTail;
+    unsigned      m_SqMask;
+    unsigned*     m_SqArray;
+    unsigned*     m_CqHead;
+    unsigned*     m_CqTail;
+    unsigned      m_CqMask;
+    io_uring_cqe* m_Cqes;
+    vector<iovec> m_Iov;      // One per request slot
+};
+
+
+CIOUringEngine::CIOUringEngine(unsigned int entries)
+    : m_Fd(-1), m_SqRing(MAP_FAILED), m_CqRing(MAP_FAILED),
+      m_Sqes((io_uring_sqe*) MAP_FAILED), m_Iov(entries)
+{
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    m_Fd = Setup(entries, &p);
+    if (m_Fd < 0) {
+        NCBI_THROW(CFileErrnoException, eFileIO, "io_uring_setup() failed");
+    }
+    m_SqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_CqRingSize = p.cq_off.cqes  + p.cq_entries * sizeof(io_uring_cqe);
+    m_SqesSize   = p.sq_entries * sizeof(io_uring_sqe);
+    bool single_mmap = false;
+#  if defined(IORING_FEAT_SINGLE_MMAP)
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        single_mmap = true;
+        m_SqRingSize = m_CqRingSize = max(m_SqRingSize, m_CqRingSize);
+    }
+#  endif
+    m_SqRing = mmap(0, m_SqRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING);
+    if (m_SqRing != MAP_FAILED) {
+        m_CqRing = single_mmap ? m_SqRing
+            : mmap(0, m_CqRingSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_CQ_RING);
+    }
+    if (m_CqRing != MAP_FAILED) {
+        m_Sqes = (io_uring_sqe*) mmap(0, m_SqesSize, PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_POPULATE, m_Fd,
+                                      IORING_OFF_SQES);
+    }
+    if (m_Sqes == MAP_FAILED) {
+        int saved_error = errno;
+        x_Close();
+        errno = saved_error;
+        NCBI_THROW(CFileErrnoException, eFileIO,
+                   "Cannot map io_uring queues");
+    }
+    char* sq = (char*) m_SqRing;
+    m_SqHead  = (unsigned*) (sq + p.sq_off.head);
+    m_SqTail  = (unsigned*) (sq + p.sq_off.tail);
+    m_SqMask  = *(unsigned*)(sq + p.sq_off.ring_mask);
+    m_SqArray = (unsigned*) (sq + p.sq_off.array);
+    char* cq = (char*) m_CqRing;
+    m_CqHead  = (unsigned*) (cq + p.cq_off.head);
+    m_CqTail  = (unsigned*) (cq + p.cq_off.tail);
+    m_CqMask  = *(unsigned*)(cq + p.cq_off.ring_mask);
+    m_Cqes    = (io_uring_cqe*)(cq + p.cq_off.cqes);
+}
+
+
+CIOUringEngine::~CIOUringEngine(void)
+{
+    x_Close();
+}
+
+
+void CIOUringEngine::x_Close(void)
+{
+    if (m_Sqes != MAP_FAILED) {
+        munmap(m_Sqes, m_SqesSize);
+        m_Sqes = (io_uring_sqe*) MAP_FAILED;
+    }
+    if (m_CqRing != MAP_FAILED  &&  m_CqRing != m_SqRing) {
+        munmap(m_CqRing, m_CqRingSize);
+    }
+    m_CqRing = MAP_FAILED;
+    if (m_SqRing != MAP_FAILED) {
+        munmap(m_SqRing, m_SqRingSize);
+        m_SqRing = MAP_FAILED;
+    }
+    if (m_Fd >= 0) {
+        close(m_Fd);
+        m_Fd = -1;
+    }
+}
+
+
+int CIOUringEngine::x_Enter(unsigned to_submit, unsigned min_complete,
+                            unsigned flags)
+{
+    for (;;) {
+        int n = (int) syscall(__NR_io_uring_enter, m_Fd, to_submit,
+                              min_complete, flags, NULL, 0);
+        if (n >= 0) {
+            return n;
+        }
+        if (errno == EINTR) {
+            if (min_complete) {
+                // Let the caller check for completions
+                return 0;
+            }
+            continue;
+        }
+        if (errno == EAGAIN  ||  errno == EBUSY) {
+            // Not enough resources now, retry after reaping
+            return 0;
+        }
+        NCBI_THROW(CFileErrnoException, eFileIO, "io_uring_enter() failed");
+    }
+}
+
+
+void CIOUringEngine::Start(SAsyncRequest& req)
+{
+    // Each started request uses at most one submission entry,
+    // and there are no more requests than entries.
+    unsigned tail  = *m_SqTail;
+    unsigned index = tail & m_SqMask;
+    io_uring_sqe* sqe = &m_Sqes[index];
+    iovec& iov = m_Iov[req.slot];
+    iov.iov_base = req.buf + req.done;
+    iov.iov_len  = req.count - req.done;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = req.op == CFileAsyncIO::eWrite ? IORING_OP_WRITEV
+                                                    : IORING_OP_READV;
+    sqe->fd        = req.handle;
+    sqe->off       = req.position + req.done;
+    sqe->addr      = (Uint8) (uintptr_t) &iov;
+    sqe->len       = 1;
+    sqe->user_data = (Uint8) (uintptr_t) &req;
+    m_SqArray[index] = index;
+    __atomic_store_n(m_SqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+
+void CIOUringEngine::Commit(void)
+{
+    unsigned n;
+    while ((n = x_GetUnsubmitted()) != 0) {
+        if (x_Enter(n, 0, 0) == 0) {
+            break;
+        }
+    }
+}
+
+
+bool CIOUringEngine::x_Complete(SAsyncRequest& req, int res)
+{
+    if (res < 0) {
+        if (res == -EAGAIN  ||  res == -EINTR) {
+            Start(req);
+            return false;
+        }
+        req.error = -res;
+        return true;
+    }
+    if (res == 0) {
+        if (req.op == CFileAsyncIO::eWrite  &&  req.done < req.count) {
+            req.error = EIO;
+        }
+        return true;
+    }
+    req.done += res;
+    if (req.done < req.count) {
+        // Short read or write, continue with the rest
+        Start(req);
+        return false;
+    }
+    return true;
+}
+
+
+void CIOUringEngine::Reap(vector<unsigned>& slots, bool wait)
+{
+    size_t reaped = slots.size();
+    for (;;) {
+        unsigned head = *m_CqHead;
+        unsigned tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+        for ( ;  head != tail;  ++head) {
+            const io_uring_cqe& cqe = m_Cqes[head & m_CqMask];
+            SAsyncRequest& req = *(SAsyncRequest*) (uintptr_t) cqe.user_data;
+            if ( x_Complete(req, cqe.res) ) {
+                slots.push_back(req.slot);
+            }
+        }
+        __atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+        if ( !wait  ||  slots.size() > reaped ) {
+            Commit();
+            return;
+        }
+        x_Enter(x_GetUnsubmitted(), 1, IORING_ENTER_GETEVENTS);
+    }
+}
+
+#endif // USE_IO_URING
+
+
+// Thread pool engine: each thread does one blocking I/O at a time.
+class CThreadPoolIOEngine : public CFileAsyncIO::IEngine
+{
+public:
+    CThreadPoolIOEngine(unsigned int max_threads)
+        : m_MaxThreads(max_threads), m_Idle(0), m_Stop(false)
+        {}
+    virtual ~CThreadPoolIOEngine(void);
+
+    virtual void Start(SAsyncRequest& req);
+    virtual void Commit(void) {}
+    virtual void Reap(vector<unsigned>& slots, bool wait);
+
+    // Worker thread loop
+    void Run(void);
+
+private:
+    static void x_Execute(SAsyncRequest& req)
+    {
+        req.error = s_FileIOAt(req.handle, req.op, req.position,
+                               req.buf, req.count, &req.done);
+    }
+
+    unsigned int            m_MaxThreads;
+    CFastMutex              m_Mutex;
+    CConditionVariable      m_WorkCond;
+    CConditionVariable      m_DoneCond;
+    deque<SAsyncRequest*>   m_Work;
+    vector<unsigned>        m_Done;
+    vector< CRef<CThread> > m_Threads;
+    unsigned int            m_Idle;
+    bool                    m_Stop;
+};
+
+
+class CAsyncIOWorker : public CThread
+{
+public:
+    CAsyncIOWorker(CThreadPoolIOEngine& engine) : m_Engine(engine) {}
+
+protected:
+    virtual void* Main(void)
+    {
+        m_Engine.Run();
+        return 0;
+    }
+
+private:
+    CThreadPoolIOEngine& m_Engine;
+};
+
+
+CThreadPoolIOEngine::~CThreadPoolIOEngine(void)
+{
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        m_Stop = true;
+        m_WorkCond.SignalAll();
+    }}
+    NON_CONST_ITERATE(vector< CRef<CThread> >, it, m_Threads) {
+        (*it)->Join();
+    }
+}
+
+
+void CThreadPoolIOEngine::Run(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    for (;;) {
+        if ( !m_Work.empty() ) {
+            SAsyncRequest* req = m_Work.front();
+            m_Work.pop_front();
+            guard.Release();
+            x_Execute(*req);
+            guard.Guard(m_Mutex);
+            m_Done.push_back(req->slot);
+            m_DoneCond.SignalSome();
+            continue;
+        }
+        if ( m_Stop ) {
+            break;
+        }
+        ++m_Idle;
+        m_WorkCond.WaitForSignal(m_Mutex);
+        --m_Idle;
+    }
+}
+
+
+void CThreadPoolIOEngine::Start(SAsyncRequest& req)
+{
+    CFastMutexGuard guard(m_Mutex);
+#if defined(NCBI_THREADS)
+    if (m_Idle < m_Work.size() + 1  &&  m_Threads.size() < m_MaxThreads) {
+        CRef<CThread> thr(new CAsyncIOWorker(*this));
+        try {
+            thr->Run();
+            m_Threads.push_back(thr);
+        }
+        catch (CThreadException&) {
+            m_MaxThreads = (unsigned int) m_Threads.size();
+        }
+    }
+    if ( !m_Threads.empty() ) {
+        m_Work.push_back(&req);
+        if (m_Idle > 0) {
+            m_WorkCond.SignalSome();
+        }
+        return;
+    }
+#endif
+    // No threads available, do it now
+    guard.Release();
+    x_Execute(req);
+    guard.Guard(m_Mutex);
+    m_Done.push_back(req.slot);
+}
+
+
+void CThreadPoolIOEngine::Reap(vector<unsigned>& slots, bool wait)
+{
+    CFastMutexGuard guard(m_Mutex);
+    while (wait  &&  m_Done.empty()) {
+        m_DoneCond.WaitForSignal(m_Mutex);
+    }
+    slots.insert(slots.end(), m_Done.begin(), m_Done.end());
+    m_Done.clear();
+}
+
+} // namespace
+
+
+bool CFileAsyncIO::IsIOUringAvailable(void)
+{
+#if defined(USE_IO_URING)
+    static atomic<int> s_Available(-1);
+    int available = s_Available.load(memory_order_relaxed);
+    if (available < 0) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        int fd = CIOUringEngine::Setup(1, &p);
+        available = fd >= 0;
+        if (fd >= 0) {
+            close(fd);
+        }
+        s_Available = available;
+    }
+    return available != 0;
+#else
+    return false;
+#endif
+}
+
+
+CFileAsyncIO::CFileAsyncIO(unsigned int queue_depth, EBackend backend)
+    : m_QueueDepth(min(queue_depth ? queue_depth : 64u, 4096u)),
+      m_BackendType(backend),
+      m_Started(0)
+{
+    // Slots are never reallocated, engines keep pointers to them
+    m_Slots.resize(m_QueueDepth);
+    m_FreeSlots.reserve(m_QueueDepth);
+    for (unsigned i = m_QueueDepth;  i > 0;  --i) {
+        m_Slots[i - 1].slot = i - 1;
+        m_FreeSlots.push_back(i - 1);
+    }
+#if defined(USE_IO_URING)
+    if (backend == eIOUring  ||
+        (backend == eDefault  &&
+         NCBI_PARAM_TYPE(NCBI, FileAPIUseIOUring)::GetDefault()  &&
+         IsIOUringAvailable())) {
+        try {
+            m_Engine.reset(new CIOUringEngine(m_QueueDepth));
+            m_BackendType = eIOUring;
+        }
+        catch (CFileException&) {
+            if (backend == eIOUring) {
+                throw;
+            }
+        }
+    }
+#else
+    if (backend == eIOUring) {
+        NCBI_THROW(CFileException, eFileIO,
+                   "io_uring is not supported on this platform");
+    }
+#endif
+    if ( !m_Engine ) {
+        m_Engine.reset(new CThreadPoolIOEngine(min(m_QueueDepth, 64u)));
+        m_BackendType = eThreadPool;
+    }
+}
+
+
+CFileAsyncIO::~CFileAsyncIO(void)
+{
+    // The buffers of started requests can be used until they complete
+    m_Queued.clear();
+    try {
+        while (m_Started > 0) {
+            m_Reaped.clear();
+            m_Engine->Reap(m_Reaped, true);
+            m_Started -= m_Reaped.size();
+        }
+    }
+    NCBI_CATCH_ALL("Error while waiting for asynchronous I/O [IGNORED]");
+}
+
+
+void CFileAsyncIO::x_Queue(TFileHandle handle, EOperation op, Uint8 position,
+                           char* buf, size_t count, void* cookie)
+{
+    m_Queued.push_back(SRequest());
+    SRequest& req = m_Queued.back();
+    req.handle   = handle;
+    req.op       = op;
+    req.position = position;
+    req.buf      = buf;
+    req.count    = count;
+    req.done     = 0;
+    req.error    = 0;
+    req.cookie   = cookie;
+}
+
+
+void CFileAsyncIO::Read(TFileHandle handle, Uint8 position, void* buf,
+                        size_t count, void* cookie)
+{
+    x_Queue(handle, eRead, position, (char*) buf, count, cookie);
+}
+
+
+void CFileAsyncIO::Write(TFileHandle handle, Uint8 position, const void* buf,
+                         size_t count, void* cookie)
+{
+    x_Queue(handle, eWrite, position, (char*) buf, count, cookie);
+}
+
+
+size_t CFileAsyncIO::Submit(void)
+{
+    size_t n = 0;
+    while ( !m_Queued.empty()  &&  !m_FreeSlots.empty() ) {
+        unsigned slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        SRequest& req = m_Slots[slot];
+        req = m_Queued.front();
+        req.slot = slot;
+        m_Queued.pop_front();
+        m_Engine->Start(req);
+        ++m_Started;
+        ++n;
+    }
+    if ( n ) {
+        m_Engine->Commit();
+    }
+    return n;
+}
+
+
+size_t CFileAsyncIO::Wait(TCompletions& completions, size_t min_count)
+{
+    size_t count = 0;
+    for (;;) {
+        Submit();
+        m_Reaped.clear();
+        m_Engine->Reap(m_Reaped, count < min_count  &&  m_Started > 0);
+        ITERATE(vector<unsigned>, it, m_Reaped) {
+            const SRequest& req = m_Slots[*it];
+            SCompletion c;
+            c.cookie   = req.cookie;
+            c.op       = req.op;
+            c.position = req.position;
+            c.bytes    = req.done;
+            c.error    = req.error;
+            completions.push_back(c);
+            m_FreeSlots.push_back(*it);
+        }
+        m_Started -= m_Reaped.size();
+        count     += m_Reaped.size();
+        if (count >= min_count  ||  GetPending() == 0) {
+            break;
+        }
+    }
+    // Keep the queue full while the caller processes the results
+    Submit();
+    return count;
+}
+
+
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // CFileLock
@@ -35,6 +35,7 @@
 
 #include <ncbi_pch.hpp>
 #include <corelib/ncbimempool.hpp>
+#include <corelib/ncbithr.hpp>
 #include <corelib/error_codes.hpp>
 
 //#define DEBUG_MEMORY_POOL
@@ -94,6 +95,11 @@ void DeregisterMemoryChunk(size_t /*size*/)
 # define ObjFatal Critical
 #endif
 
+
+// Memory pool used by the current thread for plain 'new' of CObjects.
+static DECLARE_TLS_VAR(CObjectMemoryPool*, s_ThreadPool);
+
+
 class CObjectMemoryPoolChunk : public CObject
 {
 private:
@@ -171,7 +177,18 @@ private:
 
 CObjectMemoryPoolChunk* CObjectMemoryPoolChunk::CreateChunk(size_t size)
 {
-    void* ptr = CObject::operator new(sizeof(CObjectMemoryPoolChunk)+size);
+    // The chunk itself must be allocated in heap, not in the current pool.
+    CObjectMemoryPool* thread_pool = s_ThreadPool;
+    s_ThreadPool = 0;
+    void* ptr;
+    try {
+        ptr = CObject::operator new(sizeof(CObjectMemoryPoolChunk)+size);
+    }
+    catch (...) {
+        s_ThreadPool = thread_pool;
+        throw;
+    }
+    s_ThreadPool = thread_pool;
     CObjectMemoryPoolChunk* chunk = ::new(ptr) CObjectMemoryPoolChunk(size);
     chunk->DoDeleteThisObject();
     return chunk;
@@ -282,6 +299,28 @@ void CObjectMemoryPool::Deallocate(void* ptr)
 }
 
 
+CObjectMemoryPool* CObjectMemoryPool::GetThreadPool(void)
+{
+    return s_ThreadPool;
+}
+
+
+CObjectMemoryPoolGuard::CObjectMemoryPoolGuard(CObjectMemoryPool* pool)
+    : m_Pool(pool),
+      m_SavedPool(s_ThreadPool)
+{
+    if ( pool ) {
+        s_ThreadPool = pool;
+    }
+}
+
+
+CObjectMemoryPoolGuard::~CObjectMemoryPoolGuard(void)
+{
+    s_ThreadPool = m_SavedPool;
+}
+
+
 void CObjectMemoryPool::Delete(const CObject* object)
 {
     CObjectMemoryPoolChunk* chunk = CObjectMemoryPoolChunk::GetChunk(object);
@@ -37,6 +37,7 @@
 #include <corelib/ncbimtx.hpp>
 #include <corelib/ncbi_limits.h>
 #include <corelib/obj_pool.hpp>
+#include <corelib/ncbithr.hpp>
 #include "ncbidbg_p.hpp"
 #include <stdio.h>
 #include <algorithm>
@@ -2096,6 +2097,91 @@ CFastRWLock::WriteUnlock(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//  CDistributedRWLock::
+//
+
+// Slot assigned to the current thread plus one, zero if not assigned yet
+static DECLARE_TLS_VAR(unsigned, s_DistributedRWLockSlot);
+// Next slot to assign, threads get the slots in round-robin order
+static atomic<unsigned> s_DistributedRWLockNextSlot(0);
+
+
+CDistributedRWLock::CDistributedRWLock(void)
+    : m_Writer(false)
+{
+    for (unsigned i = 0;  i < kSlots;  ++i) {
+        m_Slots[i].m_Readers.store(0, memory_order_relaxed);
+    }
+}
+
+
+CDistributedRWLock::~CDistributedRWLock(void)
+{
+#ifdef _DEBUG
+    _ASSERT( !m_Writer.load() );
+    for (unsigned i = 0;  i < kSlots;  ++i) {
+        _ASSERT(m_Slots[i].m_Readers.load() == 0);
+    }
+#endif
+}
+
+
+unsigned CDistributedRWLock::x_GetSlot(void)
+{
+    unsigned slot = s_DistributedRWLockSlot;
+    if ( !slot ) {
+        slot = s_DistributedRWLockNextSlot.fetch_add(1) % kSlots + 1;
+        s_DistributedRWLockSlot = slot;
+    }
+    return slot - 1;
+}
+
+
+void CDistributedRWLock::ReadLock(void)
+{
+    atomic<int>& readers = m_Slots[x_GetSlot()].m_Readers;
+    for (;;) {
+        // The counter must be incremented before checking the writer flag,
+        // and the writer sets the flag before checking the counters, so
+        // that at least one of them sees the other (sequential consistency).
+        readers.fetch_add(1);
+        if ( !m_Writer.load() ) {
+            return;
+        }
+        readers.fetch_sub(1);
+        // Wait for the writer to finish
+        m_WriteLock.Lock();
+        m_WriteLock.Unlock();
+    }
+}
+
+
+void CDistributedRWLock::ReadUnlock(void)
+{
+    m_Slots[x_GetSlot()].m_Readers.fetch_sub(1, memory_order_release);
+}
+
+
+void CDistributedRWLock::WriteLock(void)
+{
+    m_WriteLock.Lock();
+    m_Writer.store(true);
+    for (unsigned i = 0;  i < kSlots;  ++i) {
+        while (m_Slots[i].m_Readers.load() != 0) {
+            NCBI_SCHED_YIELD();
+        }
+    }
+}
+
+
+void CDistributedRWLock::WriteUnlock(void)
+{
+    m_Writer.store(false, memory_order_release);
+    m_WriteLock.Unlock();
+}
+
+
 IRWLockHolder_Listener::~IRWLockHolder_Listener(void)
 {}
 
@@ -438,6 +438,11 @@ static inline void sx_FillNewMemory(void* ptr, size_t size)
 void* CObject::operator new(size_t size)
 {
     _ASSERT(size >= sizeof(CObject));
+    CObjectMemoryPool* thread_pool = CObjectMemoryPool::GetThreadPool();
+    if ( thread_pool  &&  size <= thread_pool->GetMallocThreshold() ) {
+        // allocate in the memory pool of the current thread
+        return operator new(size, thread_pool);
+    }
     size = max(size, sizeof(CObject) + sizeof(TCounter));
 
 #ifdef USE_SINGLE_ALLOC
@@ -474,25 +479,27 @@ void CObject::operator delete(void* ptr)
 {
     // Can be called either from regular destruction (with counter initialized)
     // or before CObject constructor is called (counter is not set yet).
+    // The memory may come from the thread's memory pool, so the magic
+    // is always checked.
 #if USE_TLS_PTR
-# ifdef _DEBUG
     TCount magic = sx_PopLastNewPtr(ptr);
     if ( !magic ) { // counter already initialized
         magic = static_cast<CObject*>(ptr)->m_Counter.Get();
     }
-# else// !_DEBUG
-    // Just remove saved operator new info.
-    sx_PopLastNewPtr(ptr);
-# endif// _DEBUG
 #else// !USE_TLS_PTR
-# ifdef _DEBUG
     TCount magic = static_cast<CObject*>(ptr)->m_Counter.Get();
-# endif// _DEBUG
 #endif// USE_TLS_PTR
 
     // magic can be equal to:
     // 1. eMagicCounterDeleted when memory is freed after CObject destructor.
     // 2. eMagicCounterNew when memory is freed before CObject constructor.
+    // 3. eMagicCounterPoolDeleted or eMagicCounterPoolNew if the memory
+    //    was allocated in the thread's memory pool.
+    if ( magic == eMagicCounterPoolDeleted  ||
+         magic == eMagicCounterPoolNew ) {
+        CObjectMemoryPool::Deallocate(ptr);
+        return;
+    }
     _ASSERT(magic == eMagicCounterDeleted  || magic == eMagicCounterNew);
     ::operator delete(ptr);
 }
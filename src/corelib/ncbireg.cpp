@@ -39,11 +39,15 @@
 #include <corelib/metareg.hpp>
 #include <corelib/ncbiapp.hpp>
 #include <corelib/ncbimtx.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbi_process.hpp>
+#include <corelib/ncbi_safe_static.hpp>
 #include <corelib/error_codes.hpp>
 #include <corelib/resource_info.hpp>
 #include "ncbisys.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <set>
 
 
@@ -1739,6 +1743,26 @@ const string& CNcbiRegistry::x_GetComment(const string& section,
 }
 
 
+void CNcbiRegistry::x_SetModifiedFlag(bool modified, TFlags flags)
+{
+    if ( modified ) {
+        // Values in the snapshot may be out of date now.
+        CRegistrySnapshot::Deactivate(this);
+    }
+    CCompoundRWRegistry::x_SetModifiedFlag(modified, flags);
+}
+
+
+void CNcbiRegistry::ReadSnapshot(const CRegistrySnapshot& snapshot)
+{
+    bool was_empty = m_FileRegistry->Empty(fPersistent);
+    snapshot.Load(*m_FileRegistry);
+    if ( was_empty ) {
+        m_FileRegistry->SetModifiedFlag(false, fPersistent);
+    }
+}
+
+
 //////////////////////////////////////////////////////////////////////
 //
 // CCompoundRWRegistry -- general-purpose setup
@@ -2097,6 +2121,433 @@ void CCompoundRWRegistry::x_Add(const IRegistry& reg, TPriority prio,
 }
 
 
+//////////////////////////////////////////////////////////////////////
+//
+// CRegistrySnapshot -- compiled memory-mapped registry
+//
+// File layout (native byte order):
+//   SHeader
+//   SSource[source_count]
+//   SEntry[entry_count]    -- sorted by section and name (case-insensitive)
+//   string pool            -- all names and values, not 0-terminated
+
+static const char  kSnapshotMagic[8] = { 'N','C','B','I','R','G','S','1' };
+static const Uint4 kSnapshotByteOrder = 0x01020304;
+
+struct CRegistrySnapshot::SHeader
+{
+    char  magic[8];
+    Uint4 byte_order;
+    Uint4 source_count;
+    Uint8 entry_count;
+    Uint8 strings_size;
+    Uint4 key_offset;
+    Uint4 key_length;
+};
+
+
+struct CRegistrySnapshot::SSource
+{
+    Uint8 size;
+    Int8  mtime;
+    Int8  mtime_nsec;
+    Uint4 name_offset;
+    Uint4 name_length;
+};
+
+
+struct CRegistrySnapshot::SEntry
+{
+    Uint4 section_offset;
+    Uint4 section_length;
+    Uint4 name_offset;
+    Uint4 name_length;
+    Uint4 value_offset;
+    Uint4 value_length;
+};
+
+
+static bool s_StatSnapshotSource(const string& name,
+                                 Uint8*        size,
+                                 Int8*         mtime,
+                                 Int8*         mtime_nsec)
+{
+    CDirEntry::SStat st;
+    if ( !CDirEntry(name).Stat(&st, eFollowLinks) ) {
+        return false;
+    }
+    *size       = (Uint8) st.orig.st_size;
+    *mtime      = (Int8)  st.orig.st_mtime;
+    *mtime_nsec = (Int8)  st.mtime_nsec;
+    return true;
+}
+
+
+static inline
+int s_CompareSnapshotKeys(const CTempString& section1, const CTempString& name1,
+                          const CTempString& section2, const CTempString& name2)
+{
+    int res = NStr::CompareNocase(section1, section2);
+    return res ? res : NStr::CompareNocase(name1, name2);
+}
+
+
+namespace {
+    struct SSnapshotEntry
+    {
+        string section;
+        string name;
+        string value;
+
+        bool operator<(const SSnapshotEntry& e) const
+        {
+            return s_CompareSnapshotKeys(section, name,
+                                         e.section, e.name) < 0;
+        }
+    };
+
+    class CSnapshotStrings
+    {
+    public:
+        Uint4 Add(const string& str)
+        {
+            if (m_Pool.size() + str.size() > kMax_UI4) {
+                NCBI_THROW2(CRegistryException, eErr,
+                            "Registry is too large to compile a snapshot", 0);
+            }
+            Uint4 offset = (Uint4) m_Pool.size();
+            m_Pool += str;
+            return offset;
+        }
+        const string& GetPool(void) const { return m_Pool; }
+
+    private:
+        string m_Pool;
+    };
+}
+
+
+void CRegistrySnapshot::Write(const IRegistry& reg,
+                              const string&    path,
+                              const TSources&  sources,
+                              const string&    key)
+{
+    const IRegistry::TFlags flags
+        = IRegistry::fPersistent | IRegistry::fNotJustCore;
+
+    vector<SSnapshotEntry> entries;
+    list<string> sections;
+    reg.EnumerateSections(&sections, flags);
+    ITERATE(list<string>, sit, sections) {
+        list<string> names;
+        reg.EnumerateEntries(*sit, &names, flags);
+        ITERATE(list<string>, nit, names) {
+            SSnapshotEntry e;
+            e.section = *sit;
+            e.name    = *nit;
+            e.value   = reg.Get(*sit, *nit, flags);
+            entries.push_back(e);
+        }
+    }
+    sort(entries.begin(), entries.end());
+
+    CSnapshotStrings strings;
+    SHeader header;
+    memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.byte_order   = kSnapshotByteOrder;
+    header.source_count = (Uint4) sources.size();
+    header.entry_count  = entries.size();
+    header.key_offset   = strings.Add(key);
+    header.key_length   = (Uint4) key.size();
+
+    vector<SSource> src(sources.size());
+    for (size_t i = 0;  i < sources.size();  ++i) {
+        if ( !s_StatSnapshotSource(sources[i], &src[i].size,
+                                   &src[i].mtime, &src[i].mtime_nsec) ) {
+            NCBI_THROW2(CRegistryException, eErr,
+                        "Cannot get status of configuration file " +
+                        sources[i], 0);
+        }
+        src[i].name_offset = strings.Add(sources[i]);
+        src[i].name_length = (Uint4) sources[i].size();
+    }
+
+    vector<SEntry> ent(entries.size());
+    for (size_t i = 0;  i < entries.size();  ++i) {
+        // Entries are grouped by section, store each section name once.
+        if (i > 0  &&  entries[i].section == entries[i - 1].section) {
+            ent[i].section_offset = ent[i - 1].section_offset;
+        } else {
+            ent[i].section_offset = strings.Add(entries[i].section);
+        }
+        ent[i].section_length = (Uint4) entries[i].section.size();
+        ent[i].name_offset    = strings.Add(entries[i].name);
+        ent[i].name_length    = (Uint4) entries[i].name.size();
+        ent[i].value_offset   = strings.Add(entries[i].value);
+        ent[i].value_length   = (Uint4) entries[i].value.size();
+    }
+    header.strings_size = strings.GetPool().size();
+
+    // Write to a temporary file and rename it, so that readers never
+    // map a partially written snapshot.
+    string tmp_path = path + ".tmp" +
+        NStr::NumericToString(CProcess::GetCurrentPid());
+    {{
+        CNcbiOfstream out(tmp_path.c_str(),
+                          IOS_BASE::out | IOS_BASE::binary | IOS_BASE::trunc);
+        out.write((const char*) &header, sizeof(header));
+        if ( !src.empty() ) {
+            out.write((const char*) &src[0], src.size() * sizeof(SSource));
+        }
+        if ( !ent.empty() ) {
+            out.write((const char*) &ent[0], ent.size() * sizeof(SEntry));
+        }
+        out.write(strings.GetPool().data(), strings.GetPool().size());
+        out.close();
+        if ( !out ) {
+            CFile(tmp_path).Remove();
+            NCBI_THROW2(CRegistryException, eErr,
+                        "Failed to write registry snapshot " + tmp_path, 0);
+        }
+    }}
+    if ( !CFile(tmp_path).Rename(path, CDirEntry::fRF_Overwrite) ) {
+        CFile(tmp_path).Remove();
+        NCBI_THROW2(CRegistryException, eErr,
+                    "Failed to rename registry snapshot to " + path, 0);
+    }
+}
+
+
+CRef<CRegistrySnapshot> CRegistrySnapshot::Open(const string& path,
+                                                const string& key)
+{
+    CRef<CRegistrySnapshot> snapshot;
+    if ( !CFile(path).IsFile() ) {
+        return snapshot;
+    }
+    snapshot.Reset(new CRegistrySnapshot);
+    try {
+        snapshot->m_File.reset(new CMemoryFile(path));
+        snapshot->m_Data = (const char*) snapshot->m_File->Map();
+        snapshot->m_Size = snapshot->m_File->GetSize();
+    }
+    catch (CFileException& e) {
+        ERR_POST_X(9, Warning << "Cannot map registry snapshot "
+                   << path << ": " << e.what());
+        snapshot.Reset();
+        return snapshot;
+    }
+    if ( !snapshot->x_Init(key)  ||  snapshot->IsStale() ) {
+        snapshot.Reset();
+    }
+    return snapshot;
+}
+
+
+CRegistrySnapshot::CRegistrySnapshot(void)
+    : m_Data(NULL),
+      m_Size(0),
+      m_SourceInfo(NULL),
+      m_Entries(NULL),
+      m_EntryCount(0),
+      m_Strings(NULL),
+      m_StringsSize(0)
+{
+}
+
+
+CRegistrySnapshot::~CRegistrySnapshot(void)
+{
+}
+
+
+bool CRegistrySnapshot::x_Init(const string& key)
+{
+    if ( !m_Data  ||  m_Size < sizeof(SHeader) ) {
+        return false;
+    }
+    const SHeader* header = reinterpret_cast<const SHeader*>(m_Data);
+    if (memcmp(header->magic, kSnapshotMagic, sizeof(header->magic)) != 0  ||
+        header->byte_order != kSnapshotByteOrder) {
+        return false;
+    }
+    // Check sizes without overflowing.
+    Uint8 avail = m_Size - sizeof(SHeader);
+    if (header->source_count > avail / sizeof(SSource)) {
+        return false;
+    }
+    avail -= header->source_count * sizeof(SSource);
+    if (header->entry_count > avail / sizeof(SEntry)) {
+        return false;
+    }
+    avail -= header->entry_count * sizeof(SEntry);
+    if (header->strings_size != avail) {
+        return false;
+    }
+    const char* ptr = m_Data + sizeof(SHeader);
+    m_SourceInfo  = reinterpret_cast<const SSource*>(ptr);
+    ptr          += header->source_count * sizeof(SSource);
+    m_Entries     = reinterpret_cast<const SEntry*>(ptr);
+    ptr          += header->entry_count * sizeof(SEntry);
+    m_Strings     = ptr;
+    m_StringsSize = (size_t) header->strings_size;
+    m_EntryCount  = (size_t) header->entry_count;
+
+    // Validate all string references once, so that lookups need not.
+    Uint8 max_string = header->key_offset + (Uint8) header->key_length;
+    for (Uint4 i = 0;  i < header->source_count;  ++i) {
+        max_string = max(max_string, m_SourceInfo[i].name_offset +
+                                     (Uint8) m_SourceInfo[i].name_length);
+    }
+    for (size_t i = 0;  i < m_EntryCount;  ++i) {
+        const SEntry& e = m_Entries[i];
+        max_string = max(max_string,
+                         e.section_offset + (Uint8) e.section_length);
+        max_string = max(max_string, e.name_offset + (Uint8) e.name_length);
+        max_string = max(max_string, e.value_offset + (Uint8) e.value_length);
+    }
+    if (max_string > m_StringsSize) {
+        return false;
+    }
+    if (x_GetString(header->key_offset, header->key_length) != key) {
+        return false;
+    }
+    m_Sources.clear();
+    for (Uint4 i = 0;  i < header->source_count;  ++i) {
+        m_Sources.push_back(x_GetString(m_SourceInfo[i].name_offset,
+                                        m_SourceInfo[i].name_length));
+    }
+    return true;
+}
+
+
+inline
+CTempString CRegistrySnapshot::x_GetString(Uint4 offset, Uint4 length) const
+{
+    return CTempString(m_Strings + offset, length);
+}
+
+
+bool CRegistrySnapshot::IsStale(void) const
+{
+    for (size_t i = 0;  i < m_Sources.size();  ++i) {
+        Uint8 size;
+        Int8  mtime, mtime_nsec;
+        if ( !s_StatSnapshotSource(m_Sources[i], &size, &mtime, &mtime_nsec)
+            ||  size       != m_SourceInfo[i].size
+            ||  mtime      != m_SourceInfo[i].mtime
+            ||  mtime_nsec != m_SourceInfo[i].mtime_nsec ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool CRegistrySnapshot::Find(const CTempString& section,
+                             const CTempString& name,
+                             CTempString*       value) const
+{
+    size_t lo = 0, hi = m_EntryCount;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const SEntry& e = m_Entries[mid];
+        int res = s_CompareSnapshotKeys(
+            x_GetString(e.section_offset, e.section_length),
+            x_GetString(e.name_offset, e.name_length),
+            section, name);
+        if (res < 0) {
+            lo = mid + 1;
+        } else if (res > 0) {
+            hi = mid;
+        } else {
+            if ( value ) {
+                *value = x_GetString(e.value_offset, e.value_length);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+
+string CRegistrySnapshot::Get(const CTempString& section,
+                              const CTempString& name) const
+{
+    CTempString value;
+    return Find(section, name, &value) ? string(value) : kEmptyStr;
+}
+
+
+void CRegistrySnapshot::Load(IRWRegistry& reg) const
+{
+    for (size_t i = 0;  i < m_EntryCount;  ++i) {
+        const SEntry& e = m_Entries[i];
+        reg.Set(x_GetString(e.section_offset, e.section_length),
+                x_GetString(e.name_offset, e.name_length),
+                x_GetString(e.value_offset, e.value_length),
+                IRegistry::fPersistent | IRegistry::fInternalSpaces
+                | IRegistry::fSectionlessEntries);
+    }
+}
+
+
+DEFINE_STATIC_FAST_MUTEX(s_ActiveSnapshotMutex);
+static atomic<const CRegistrySnapshot*> s_ActiveSnapshot(NULL);
+static const IRegistry*                 s_ActiveSnapshotRegistry = NULL;
+
+
+// All snapshots ever activated. Lock-free readers may still use a
+// deactivated snapshot, so they are released only on exit.
+class CActivatedSnapshots
+{
+public:
+    ~CActivatedSnapshots(void)
+    {
+        s_ActiveSnapshot.store(NULL, memory_order_release);
+    }
+
+    typedef vector< CRef<CRegistrySnapshot> > TSnapshots;
+    TSnapshots m_Snapshots;
+};
+
+static CSafeStatic<CActivatedSnapshots> s_ActivatedSnapshots;
+
+
+void CRegistrySnapshot::Activate(CRegistrySnapshot& snapshot,
+                                 const IRegistry&   reg)
+{
+    CFastMutexGuard guard(s_ActiveSnapshotMutex);
+    CActivatedSnapshots::TSnapshots& snapshots
+        = s_ActivatedSnapshots->m_Snapshots;
+    CRef<CRegistrySnapshot> ref(&snapshot);
+    if (find(snapshots.begin(), snapshots.end(), ref) == snapshots.end()) {
+        snapshots.push_back(ref);
+    }
+    s_ActiveSnapshotRegistry = &reg;
+    s_ActiveSnapshot.store(&snapshot, memory_order_release);
+}
+
+
+void CRegistrySnapshot::Deactivate(const IRegistry* reg)
+{
+    if ( !s_ActiveSnapshot.load(memory_order_acquire) ) {
+        return;
+    }
+    CFastMutexGuard guard(s_ActiveSnapshotMutex);
+    if ( !reg  ||  reg == s_ActiveSnapshotRegistry ) {
+        s_ActiveSnapshot.store(NULL, memory_order_release);
+        s_ActiveSnapshotRegistry = NULL;
+    }
+}
+
+
+const CRegistrySnapshot* CRegistrySnapshot::GetActive(void)
+{
+    return s_ActiveSnapshot.load(memory_order_acquire);
+}
+
+
 //////////////////////////////////////////////////////////////////////
 //
 // CRegistryException -- error reporting
@@ -45,6 +45,9 @@
 #include <stdio.h>
 #include <locale.h>
 #include <math.h>
+#if NCBI_SSE >= 20
+#  include <emmintrin.h>
+#endif
 
 
 #define NCBI_USE_ERRCODE_X   Corelib_Util
@@ -63,6 +66,144 @@ SIZE_TYPE s_DiffPtr(const char* end, const char* start)
     return end ? (SIZE_TYPE)(end - start) : (SIZE_TYPE) 0;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//  Scanning and comparison kernels.
+//  The vectorized versions are selected at compile time (see NCBI_SSE),
+//  the scalar code is used for the string tails and on other platforms.
+//
+
+// Max number of delimiters handled by the vectorized scan
+static const SIZE_TYPE kMaxFastDelims = 4;
+
+
+#if NCBI_SSE >= 20
+// Index of the lowest set bit, 'mask' must not be zero
+static inline
+unsigned s_LowestBit(unsigned mask)
+{
+#  if defined(__GNUC__)
+    return (unsigned) __builtin_ctz(mask);
+#  else
+    unsigned n = 0;
+    while ( !(mask & 1) ) {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#  endif
+}
+#endif
+
+
+// Find the first character at or after 'pos' which is (kMatch == true)
+// or is not (kMatch == false) one of the characters in 'delim'.
+template<bool kMatch>
+static
+SIZE_TYPE s_FindDelim(const CTempString str, const CTempString delim,
+                      SIZE_TYPE pos)
+{
+    SIZE_TYPE nd = delim.size();
+    if (pos >= str.size()  ||  nd == 0  ||  nd > kMaxFastDelims) {
+        return kMatch ? str.find_first_of(delim, pos)
+                      : str.find_first_not_of(delim, pos);
+    }
+    const char* begin = str.data();
+    const char* p     = begin + pos;
+    const char* end   = begin + str.size();
+
+    if (kMatch  &&  nd == 1) {
+        const void* found = memchr(p, delim[0], end - p);
+        return found ? SIZE_TYPE((const char*)found - begin) : NPOS;
+    }
+#if NCBI_SSE >= 20
+    __m128i d[kMaxFastDelims];
+    for (SIZE_TYPE i = 0;  i < kMaxFastDelims;  ++i) {
+        // repeat the first delimiter if there are less than 4 of them
+        d[i] = _mm_set1_epi8(delim[i < nd ? i : 0]);
+    }
+    for ( ;  end - p >= 16;  p += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, d[0]),
+                         _mm_cmpeq_epi8(chunk, d[1])),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, d[2]),
+                         _mm_cmpeq_epi8(chunk, d[3])));
+        unsigned mask = (unsigned) _mm_movemask_epi8(eq);
+        if ( !kMatch ) {
+            mask ^= 0xFFFF;
+        }
+        if ( mask ) {
+            return SIZE_TYPE(p - begin) + s_LowestBit(mask);
+        }
+    }
+#endif
+    for ( ;  p != end;  ++p) {
+        bool is_delim = false;
+        for (SIZE_TYPE i = 0;  i < nd;  ++i) {
+            if (*p == delim[i]) {
+                is_delim = true;
+                break;
+            }
+        }
+        if (is_delim == kMatch) {
+            return SIZE_TYPE(p - begin);
+        }
+    }
+    return NPOS;
+}
+
+
+static inline
+bool s_NocaseEqual(char c1, char c2)
+{
+    return c1 == c2  ||
+        tolower((unsigned char) c1) == tolower((unsigned char) c2);
+}
+
+
+// Length of the common case-insensitive prefix of p1 and p2, up to 'n'.
+// Blocks of plain ASCII text are folded and compared 16 bytes at a time,
+// blocks containing any other characters are compared using tolower().
+static
+SIZE_TYPE s_NocaseCommonPrefix(const char* p1, const char* p2, SIZE_TYPE n)
+{
+    SIZE_TYPE i = 0;
+#if NCBI_SSE >= 20
+    const __m128i kUpperMin = _mm_set1_epi8('A' - 1);
+    const __m128i kUpperMax = _mm_set1_epi8('Z' + 1);
+    const __m128i kCaseBit  = _mm_set1_epi8(0x20);
+    for ( ;  n - i >= 16;  i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p2 + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF) {
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_or_si128(a, b)) == 0) {
+            // ASCII only: set the case bit on upper case letters
+            __m128i ua = _mm_and_si128(_mm_cmpgt_epi8(a, kUpperMin),
+                                       _mm_cmplt_epi8(a, kUpperMax));
+            __m128i ub = _mm_and_si128(_mm_cmpgt_epi8(b, kUpperMin),
+                                       _mm_cmplt_epi8(b, kUpperMax));
+            a = _mm_or_si128(a, _mm_and_si128(ua, kCaseBit));
+            b = _mm_or_si128(b, _mm_and_si128(ub, kCaseBit));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF) {
+                continue;
+            }
+        }
+        for (SIZE_TYPE j = i;  j < i + 16;  ++j) {
+            if ( !s_NocaseEqual(p1[j], p2[j]) ) {
+                return j;
+            }
+        }
+    }
+#endif
+    while (i < n  &&  s_NocaseEqual(p1[i], p2[i])) {
+        ++i;
+    }
+    return i;
+}
+
+
 const char *const kEmptyCStr = "";
 
 #if defined(HAVE_WSTRING)
@@ -195,13 +336,10 @@ int NStr::CompareNocase(const CTempStringEx s1, const CTempStringEx s2)
         return 1;
     }
     SIZE_TYPE n = min(n1, n2);
-    const char* p1 = s1.data();
-    const char* p2 = s2.data();
-
-    while (n  &&  (*p1 == *p2  ||  
-                   tolower((unsigned char)(*p1)) == tolower((unsigned char)(*p2))) ) {
-        p1++;  p2++;  n--;
-    }
+    SIZE_TYPE n_eq = s_NocaseCommonPrefix(s1.data(), s2.data(), n);
+    const char* p1 = s1.data() + n_eq;
+    const char* p2 = s2.data() + n_eq;
+    n -= n_eq;
     if ( !n ) {
         return (n1 == n2) ? 0 : (n1 > n2 ? 1 : -1);
     }
@@ -258,12 +396,11 @@ int NStr::CompareNocase(const CTempString str, SIZE_TYPE pos, SIZE_TYPE n,
     if (n_cmp > pattern.length()) {
         n_cmp = pattern.length();
     }
-    const char* s = str.data() + pos;
-    const char* p = pattern.data();
-    while (n_cmp  &&  (*s == *p  ||
-           tolower((unsigned char)(*s)) == tolower((unsigned char)(*p))) ) {
-        s++;  p++;  n_cmp--;
-    }
+    SIZE_TYPE n_eq = s_NocaseCommonPrefix(str.data() + pos, pattern.data(),
+                                          n_cmp);
+    const char* s = str.data() + pos + n_eq;
+    const char* p = pattern.data() + n_eq;
+    n_cmp -= n_eq;
     if (n_cmp == 0) {
         return (n == pattern.length()) ? 0 : (n > pattern.length() ? 1 : -1);
     }
@@ -570,6 +707,34 @@ string CS2N_Guard::Message(const CTempString str, const char* to_type, const CTe
     }
 
 
+// Convert 8 decimal digits starting at 'p' at once (SWAR).
+// Return false if any of the 8 characters is not a decimal digit.
+static inline
+bool s_Parse8Digits(const char* p, Uint8& value)
+{
+#if defined(WORDS_BIGENDIAN)
+    return false;
+#else
+    const Uint8 kZeros = NCBI_CONST_UINT8(0x3030303030303030);
+    const Uint8 kHigh  = NCBI_CONST_UINT8(0xF0F0F0F0F0F0F0F0);
+    const Uint8 kLow   = NCBI_CONST_UINT8(0x000000FF000000FF);
+    Uint8 v;
+    memcpy(&v, p, 8);
+    if ((v & kHigh) != kZeros  ||
+        ((v + NCBI_CONST_UINT8(0x0606060606060606)) & kHigh) != kZeros) {
+        return false;
+    }
+    v -= kZeros;
+    // combine pairs, then quads, then both halves of the number
+    v = (v * 10) + (v >> 8);
+    v = (((v & kLow) * (100 + (NCBI_CONST_UINT8(1000000) << 32))) +
+         (((v >> 16) & kLow) * (1 + (NCBI_CONST_UINT8(10000) << 32)))) >> 32;
+    value = v;
+    return true;
+#endif
+}
+
+
 int NStr::StringToInt(const CTempString str, TStringToNumFlags flags, int base)
 {
     S2N_CONVERT_GUARD_EX(flags);
@@ -737,6 +902,56 @@ Int8 NStr::StringToInt8(const CTempString str, TStringToNumFlags flags, int base
 {
     S2N_CONVERT_GUARD(flags);
 
+    const TStringToNumFlags slow_flags =
+        fMandatorySign|fAllowCommas|fAllowLeadingSymbols|fAllowTrailingSymbols;
+
+    if ( base == 10  &&  (flags & slow_flags) == 0 ) {
+        // fast conversion
+
+        // Current position in the string
+        CTempString::const_iterator ptr = str.begin(), end = str.end();
+
+        // Determine sign
+        bool sign = false;
+        if ( ptr != end  &&  (*ptr == '-'  ||  *ptr == '+') ) {
+            sign = *ptr == '-';
+            ++ptr;
+        }
+        if ( ptr == end ) {
+            S2N_CONVERT_ERROR(Int8, kEmptyStr, EINVAL, ptr-str.begin());
+        }
+
+        // Begin conversion
+        Uint8 n = 0;
+
+        // Up to 18 digits cannot overflow, convert them by 8 at once
+        CTempString::const_iterator fast_end =
+            end - ptr > 18 ? ptr + 18 : end;
+        Uint8 block;
+        while ( fast_end - ptr >= 8  &&  s_Parse8Digits(ptr, block) ) {
+            n = n*100000000 + block;
+            ptr += 8;
+        }
+
+        const Uint8 limdiv = kMax_I8/10;
+        const int   limoff = int(kMax_I8 % 10) + (sign ? 1 : 0);
+
+        for ( ;  ptr != end;  ++ptr ) {
+            char ch = *ptr;
+            int  delta = ch - '0';
+            if ( unsigned(delta) >= 10 ) {
+                S2N_CONVERT_ERROR(Int8, kEmptyStr, EINVAL, ptr-str.begin());
+            }
+            // Overflow check
+            if ( n >= limdiv && (n > limdiv || delta > limoff) ) {
+                S2N_CONVERT_ERROR(Int8, "overflow", ERANGE, ptr-str.begin());
+            }
+            n = n*10+delta;
+        }
+
+        return sign ? Int8(0 - n) : Int8(n);
+    }
+
     // Current position in the string
     SIZE_TYPE pos = 0;
 
@@ -838,10 +1053,19 @@ Uint8 NStr::StringToUInt8(const CTempString str,
         // Begin conversion
         Uint8 n = 0;
 
+        // Up to 19 digits cannot overflow, convert them by 8 at once
+        CTempString::const_iterator fast_end =
+            end - ptr > 19 ? ptr + 19 : end;
+        Uint8 block;
+        while ( fast_end - ptr >= 8  &&  s_Parse8Digits(ptr, block) ) {
+            n = n*100000000 + block;
+            ptr += 8;
+        }
+
         const Uint8 limdiv = kMax_UI8/10;
         const int   limoff = int(kMax_UI8 % 10);
 
-        do {
+        for ( ;  ptr != end;  ++ptr ) {
             char ch = *ptr;
             int  delta = ch - '0';
             if ( unsigned(delta) >= 10 ) {
@@ -852,7 +1076,7 @@ Uint8 NStr::StringToUInt8(const CTempString str,
                 S2N_CONVERT_ERROR(Uint8, kEmptyStr, ERANGE, ptr-str.begin());
             }
             n = n*10+delta;
-        } while ( ++ptr != end );
+        }
 
         return n;
     }
@@ -2884,7 +3108,7 @@ SIZE_TYPE NStr::Find(const CTempString str,
 
         if (direction == eForwardSearch) {
             do {
-                pos = str.find_first_of(x_first, search_pos);
+                pos = s_FindDelim<true>(str, x_first, search_pos);
                 while (pos != NPOS) {
                     if ( (pos + plen) > slen ) {
                         return NPOS;
@@ -2892,7 +3116,7 @@ SIZE_TYPE NStr::Find(const CTempString str,
                     if ( CompareNocase(str, pos, plen, pattern) == 0 ) {
                         break;
                     }
-                    pos = str.find_first_of(x_first, pos + 1);
+                    pos = s_FindDelim<true>(str, x_first, pos + 1);
                 }
                 if (pos > slen) {
                     return NPOS;
@@ -6971,9 +7195,9 @@ CTempString::CTempString(const string& str, size_type len)
 void CTempStringList::Join(string* s) const
 {
     s->reserve(GetSize());
-    *s = m_FirstNode.str;
-    for (const SNode* node = m_FirstNode.next.get();  node != NULL;
-         node = node->next.get()) {
+    s->assign(m_FirstNode.str.data(), m_FirstNode.str.size());
+    for (const SNode* node = &m_FirstNode;  !x_IsLast(node);  ) {
+        node = node->next.get();
         s->append(node->str.data(), node->str.size());
     }
 }
@@ -6989,7 +7213,7 @@ void CTempStringList::Join(CTempString* s) const
 
 void CTempStringList::Join(CTempStringEx* s) const
 {
-    if (m_FirstNode.next.get() == NULL) {
+    if ( x_IsLast(&m_FirstNode) ) {
         *s = m_FirstNode.str;
     } else {
         if ( !m_Storage ) {
@@ -6999,10 +7223,12 @@ void CTempStringList::Join(CTempStringEx* s) const
         SIZE_TYPE n = GetSize();
         char* buf = m_Storage->Allocate(n + 1);
         char* p = buf;
-        for (const SNode* node = &m_FirstNode;  node != NULL;
-             node = node->next.get()) {
+        for (const SNode* node = &m_FirstNode;  ;  node = node->next.get()) {
             memcpy(p, node->str.data(), node->str.size());
             p += node->str.size();
+            if ( x_IsLast(node) ) {
+                break;
+            }
         }
         *p = '\0';
         s->assign(buf, n);
@@ -7010,11 +7236,22 @@ void CTempStringList::Join(CTempStringEx* s) const
 }
 
 
+void CTempStringList::Join(CTempString* s, string* buffer) const
+{
+    if ( x_IsLast(&m_FirstNode) ) {
+        *s = m_FirstNode.str;
+    } else {
+        Join(buffer);
+        *s = *buffer;
+    }
+}
+
+
 SIZE_TYPE CTempStringList::GetSize(void) const
 {
     SIZE_TYPE total = m_FirstNode.str.size();
-    for (const SNode* node = m_FirstNode.next.get();  node != NULL;
-         node = node->next.get()) {
+    for (const SNode* node = &m_FirstNode;  !x_IsLast(node);  ) {
+        node = node->next.get();
         total += node->str.size();
     }
     return total;
@@ -7072,7 +7309,7 @@ bool CStrTokenizeBase::Advance(CTempStringList* part_collector, SIZE_TYPE* ptr_p
     // Each chunk covers the half-open interval [part_start, delim_pos).
 
     while ( !done  &&
-            ((delim_pos = m_Str.find_first_of(m_InternalDelim, pos)) != NPOS)) {
+            ((delim_pos = s_FindDelim<true>(m_Str, m_InternalDelim, pos)) != NPOS)) {
 
         SIZE_TYPE next_start = pos = delim_pos + 1;
         bool      handled    = false;
@@ -7161,7 +7398,7 @@ void CStrTokenizeBase::x_SkipDelims(bool force_skip)
     }
     // skip all delimiters, starting from the current position
     if ((m_Flags & NStr::fSplit_ByPattern) == 0) {
-        m_Pos = m_Str.find_first_not_of(m_Delim, m_Pos);
+        m_Pos = s_FindDelim<false>(m_Str, m_Delim, m_Pos);
     } else {
         while (m_Pos != NPOS 
                 &&  m_Pos + m_Delim.size() <= m_Str.size()
@@ -7195,4 +7432,105 @@ void CStrTokenizeBase::x_ExtendInternalDelim()
 }
 
 
+CStrTokenView::CStrTokenView(const CTempString& str, const CTempString& delim,
+                             TFlags flags)
+    : m_Str(str),
+      m_Delim(delim),
+      m_Flags(flags),
+      m_Tokenizer(m_Str, m_Delim, flags, NULL),
+      m_Parts(NULL),
+      m_State(eStart),
+      m_DelimPos(NPOS),
+      m_EmptyAhead(0),
+      m_TokenPos(NPOS)
+{
+}
+
+
+CStrTokenView::const_iterator CStrTokenView::begin(void)
+{
+    // Special cases, the same as in CStrTokenize::Do()
+    if ( m_Str.empty() ) {
+        m_State = eEnd;
+    } else if ( m_Delim.empty() ) {
+        m_State = eSingle;
+    } else {
+        m_State = eStart;
+        m_Tokenizer.SetPos(0);
+    }
+    m_DelimPos = NPOS;
+    m_EmptyAhead = 0;
+    return const_iterator(x_Next() ? this : NULL);
+}
+
+
+bool CStrTokenView::x_NextRaw(void)
+{
+    switch ( m_State ) {
+    case eEnd:
+        return false;
+    case eSingle:
+        m_Token = m_Str;
+        m_TokenPos = 0;
+        m_State = eEnd;
+        return true;
+    case eTokens:
+        if ( m_Tokenizer.AtEnd() ) {
+            m_State = eEnd;
+            if ((m_Flags & NStr::fSplit_Truncate_End) == 0  &&
+                m_DelimPos != NPOS) {
+                // empty token after the trailing delimiter
+                m_Token.clear();
+                m_TokenPos = m_DelimPos + 1;
+                return true;
+            }
+            return false;
+        }
+        break;
+    case eStart:
+        m_State = eTokens;
+        break;
+    }
+    m_Parts.Clear();
+    m_Tokenizer.Advance(&m_Parts, &m_TokenPos, &m_DelimPos);
+    m_Parts.Join(&m_Token, &m_Buffer);
+    return true;
+}
+
+
+bool CStrTokenView::x_Next(void)
+{
+    if ( !x_NextRaw() ) {
+        return false;
+    }
+    if ((m_Flags & NStr::fSplit_Truncate_End) == 0  ||  !m_Token.empty()) {
+        return true;
+    }
+    if (m_EmptyAhead > 0) {
+        --m_EmptyAhead;
+        return true;
+    }
+    // Empty token: keep it only if a non-empty one follows. Look ahead
+    // and count the empty tokens, then return to the current position.
+    EState    state     = m_State;
+    SIZE_TYPE pos       = m_Tokenizer.GetPos();
+    SIZE_TYPE delim_pos = m_DelimPos;
+    SIZE_TYPE token_pos = m_TokenPos;
+    size_t    empty     = 0;
+    while ( x_NextRaw() ) {
+        if ( !m_Token.empty() ) {
+            m_State = state;
+            m_Tokenizer.SetPos(pos);
+            m_DelimPos = delim_pos;
+            m_Token.clear();
+            m_TokenPos = token_pos;
+            m_EmptyAhead = empty;
+            return true;
+        }
+        ++empty;
+    }
+    return false;
+}
+
+
 END_NCBI_NAMESPACE;
@@ -33,6 +33,14 @@
 #include <ncbi_pch.hpp>
 #include <corelib/perf_log.hpp>
 #include <corelib/ncbi_param.hpp>
+#include <corelib/ncbi_safe_static.hpp>
+#include <corelib/error_codes.hpp>
+#include <corelib/ncbithr.hpp>
+#include <atomic>
+#include <math.h>
+
+
+#define NCBI_USE_ERRCODE_X   Corelib_Diag
 
 
 BEGIN_NCBI_SCOPE
@@ -49,6 +57,445 @@ NCBI_PARAM_DECL(bool, Log, PerfLogging);
 NCBI_PARAM_DEF_EX(bool, Log, PerfLogging, false, eParam_NoThread, LOG_PERFLOGGING);
 typedef NCBI_PARAM_TYPE(Log, PerfLogging) TPerfLogging;
 
+/// Aggregate timings into per-resource/status histograms
+// Registry file:
+//     [Log]
+//     PerfLogging_Aggregate = true/false
+// Environment variable:
+//     LOG_PERFLOGGING_AGGREGATE
+//
+NCBI_PARAM_DECL(bool, Log, PerfLogging_Aggregate);
+NCBI_PARAM_DEF_EX(bool, Log, PerfLogging_Aggregate, false, eParam_NoThread,
+                  LOG_PERFLOGGING_AGGREGATE);
+typedef NCBI_PARAM_TYPE(Log, PerfLogging_Aggregate) TPerfLoggingAggregate;
+
+/// Interval in seconds between aggregated reports, 0 = report only when
+/// CPerfLogger::ReportAggregated() is called
+// Registry file:
+//     [Log]
+//     PerfLogging_Interval = <seconds>
+// Environment variable:
+//     LOG_PERFLOGGING_INTERVAL
+//
+NCBI_PARAM_DECL(double, Log, PerfLogging_Interval);
+NCBI_PARAM_DEF_EX(double, Log, PerfLogging_Interval, 60, eParam_NoThread,
+                  LOG_PERFLOGGING_INTERVAL);
+typedef NCBI_PARAM_TYPE(Log, PerfLogging_Interval) TPerfLoggingInterval;
+
+/// Print one of every N raw perf records, 0 = do not print them at all
+// Registry file:
+//     [Log]
+//     PerfLogging_Sample = <N>
+// Environment variable:
+//     LOG_PERFLOGGING_SAMPLE
+//
+NCBI_PARAM_DECL(unsigned int, Log, PerfLogging_Sample);
+NCBI_PARAM_DEF_EX(unsigned int, Log, PerfLogging_Sample, 1, eParam_NoThread,
+                  LOG_PERFLOGGING_SAMPLE);
+typedef NCBI_PARAM_TYPE(Log, PerfLogging_Sample) TPerfLoggingSample;
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Latency histogram
+//
+// Log-linear buckets: values below kSubCount microseconds have their own
+// buckets, each following power of two is split into kSubCount buckets.
+// All updates are lock-free.
+//
+
+class CPerfLogHistogram
+{
+public:
+    enum {
+        kSubBits     = 4,
+        kSubCount    = 1 << kSubBits,
+        kBucketCount = (64 - kSubBits + 1) * kSubCount
+    };
+
+    CPerfLogHistogram(void);
+
+    /// Add a value (in microseconds).
+    void Add(Uint8 usec);
+
+    struct SSnapshot {
+        Uint8 m_Count;
+        Uint8 m_Sum;
+        Uint8 m_Min;
+        Uint8 m_Max;
+        vector<Uint8> m_Buckets;
+
+        /// Get value at the given percentile (0..1), in microseconds.
+        Uint8 GetPercentile(double pct) const;
+    };
+
+    /// Get collected values and reset the histogram.
+    void Extract(SSnapshot& snapshot);
+
+    static size_t GetIndex(Uint8 usec);
+    /// Get the lowest value and the width of the bucket.
+    static Uint8 GetBucketLow(size_t idx, Uint8* width);
+
+private:
+    atomic<Uint8> m_Buckets[kBucketCount];
+    atomic<Uint8> m_Sum;
+    atomic<Uint8> m_Min;
+    atomic<Uint8> m_Max;
+};
+
+
+CPerfLogHistogram::CPerfLogHistogram(void)
+    : m_Sum(0), m_Min(numeric_limits<Uint8>::max()), m_Max(0)
+{
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        m_Buckets[i].store(0, memory_order_relaxed);
+    }
+}
+
+
+static inline unsigned s_HighBit(Uint8 value)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    unsigned ret = 0;
+    while (value >>= 1) {
+        ++ret;
+    }
+    return ret;
+#endif
+}
+
+
+size_t CPerfLogHistogram::GetIndex(Uint8 usec)
+{
+    if (usec < kSubCount) {
+        return (size_t)usec;
+    }
+    unsigned hb = s_HighBit(usec);
+    size_t sub = (size_t)(usec >> (hb - kSubBits)) & (kSubCount - 1);
+    return (hb - kSubBits + 1)*kSubCount + sub;
+}
+
+
+Uint8 CPerfLogHistogram::GetBucketLow(size_t idx, Uint8* width)
+{
+    if (idx < kSubCount) {
+        *width = 1;
+        return idx;
+    }
+    unsigned shift = unsigned(idx/kSubCount - 1);
+    *width = Uint8(1) << shift;
+    return Uint8(kSubCount + idx % kSubCount) << shift;
+}
+
+
+void CPerfLogHistogram::Add(Uint8 usec)
+{
+    m_Buckets[GetIndex(usec)].fetch_add(1, memory_order_relaxed);
+    m_Sum.fetch_add(usec, memory_order_relaxed);
+    Uint8 cur = m_Min.load(memory_order_relaxed);
+    while (usec < cur  &&
+        !m_Min.compare_exchange_weak(cur, usec, memory_order_relaxed)) {
+    }
+    cur = m_Max.load(memory_order_relaxed);
+    while (usec > cur  &&
+        !m_Max.compare_exchange_weak(cur, usec, memory_order_relaxed)) {
+    }
+}
+
+
+void CPerfLogHistogram::Extract(SSnapshot& snapshot)
+{
+    // Values added concurrently may go either to this or to the next
+    // snapshot, which is good enough for statistics.
+    snapshot.m_Count = 0;
+    snapshot.m_Buckets.resize(kBucketCount);
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        snapshot.m_Buckets[i] = m_Buckets[i].exchange(0, memory_order_relaxed);
+        snapshot.m_Count += snapshot.m_Buckets[i];
+    }
+    snapshot.m_Sum = m_Sum.exchange(0, memory_order_relaxed);
+    snapshot.m_Min = m_Min.exchange(numeric_limits<Uint8>::max(),
+        memory_order_relaxed);
+    snapshot.m_Max = m_Max.exchange(0, memory_order_relaxed);
+    if (snapshot.m_Min > snapshot.m_Max) {
+        snapshot.m_Min = snapshot.m_Max;
+    }
+}
+
+
+Uint8 CPerfLogHistogram::SSnapshot::GetPercentile(double pct) const
+{
+    if (m_Count == 0) {
+        return 0;
+    }
+    Uint8 rank = Uint8(ceil(pct*double(m_Count)));
+    if (rank == 0) {
+        rank = 1;
+    }
+    Uint8 seen = 0;
+    for (size_t i = 0; i < m_Buckets.size(); ++i) {
+        seen += m_Buckets[i];
+        if (seen >= rank) {
+            Uint8 width = 0;
+            Uint8 value = GetBucketLow(i, &width) + width/2;
+            return max(m_Min, min(m_Max, value));
+        }
+    }
+    return m_Max;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Aggregator -- fixed-size lock-free hash table of histograms
+//
+
+class CPerfLogReportThread;
+
+class CPerfLogAggregator
+{
+public:
+    CPerfLogAggregator(void);
+    ~CPerfLogAggregator(void);
+
+    void Add(CTempString resource, int status, double elapsed);
+    void Report(void);
+    /// Stop periodic reports and report the remaining timings.
+    void Shutdown(void);
+
+private:
+    struct SEntry {
+        SEntry(CTempString resource, int status, size_t hash)
+            : m_Resource(resource), m_Status(status), m_Hash(hash) {}
+
+        string            m_Resource;
+        int               m_Status;
+        size_t            m_Hash;
+        CPerfLogHistogram m_Histogram;
+    };
+
+    enum {
+        kTableSize = 1024  ///< Max number of resource/status pairs
+    };
+
+    SEntry* x_GetEntry(CTempString resource, int status);
+    void x_StartThread(void);
+    void x_StopThread(void);
+
+    atomic<SEntry*>       m_Table[kTableSize];
+    CFastMutex            m_ReportMutex;
+    atomic<bool>          m_ThreadStarted;
+    CFastMutex            m_ThreadMutex;
+    CPerfLogReportThread* m_Thread;
+};
+
+
+// Background thread printing aggregated reports every
+// [Log]PerfLogging_Interval seconds, so that request threads never
+// do it inline.
+class CPerfLogReportThread : public CThread
+{
+public:
+    CPerfLogReportThread(CPerfLogAggregator& aggregator)
+        : m_Aggregator(aggregator), m_Signal(0, 1), m_NeedStop(false) {}
+
+    virtual void* Main(void);
+    void Stop(void);
+
+private:
+    CPerfLogAggregator& m_Aggregator;
+    CSemaphore          m_Signal;
+    atomic<bool>        m_NeedStop;
+};
+
+
+void* CPerfLogReportThread::Main(void)
+{
+    while ( !m_NeedStop.load() ) {
+        double interval = TPerfLoggingInterval::GetDefault();
+        if (interval <= 0) {
+            // Periodic reports are disabled, wait for Stop().
+            m_Signal.Wait();
+            continue;
+        }
+        unsigned int sec = (unsigned int)interval;
+        unsigned int nsec = (unsigned int)((interval - sec)*kNanoSecondsPerSecond);
+        if ( !m_Signal.TryWait(sec, nsec) ) {
+            m_Aggregator.Report();
+        }
+    }
+    return 0;
+}
+
+
+void CPerfLogReportThread::Stop(void)
+{
+    m_NeedStop.store(true);
+    m_Signal.Post();
+    Join();
+}
+
+
+CPerfLogAggregator::CPerfLogAggregator(void)
+    : m_ThreadStarted(false),
+      m_Thread(0)
+{
+    for (size_t i = 0; i < kTableSize; ++i) {
+        m_Table[i].store(0, memory_order_relaxed);
+    }
+}
+
+
+CPerfLogAggregator::~CPerfLogAggregator(void)
+{
+    // Too late to print anything, just make sure the thread is not
+    // using the table.
+    x_StopThread();
+    for (size_t i = 0; i < kTableSize; ++i) {
+        delete m_Table[i].load(memory_order_relaxed);
+    }
+}
+
+
+CPerfLogAggregator::SEntry*
+CPerfLogAggregator::x_GetEntry(CTempString resource, int status)
+{
+    size_t hash = (size_t)status;
+    for (size_t i = 0; i < resource.size(); ++i) {
+        hash = hash*31 + (unsigned char)resource[i];
+    }
+    SEntry* new_entry = 0;
+    for (size_t i = 0; i < kTableSize; ++i) {
+        atomic<SEntry*>& slot = m_Table[(hash + i) % kTableSize];
+        SEntry* entry = slot.load(memory_order_acquire);
+        if ( !entry ) {
+            if ( !new_entry ) {
+                new_entry = new SEntry(resource, status, hash);
+            }
+            if ( slot.compare_exchange_strong(entry, new_entry,
+                memory_order_acq_rel) ) {
+                return new_entry;
+            }
+            // Another thread has filled the slot, 'entry' is updated.
+        }
+        if (entry->m_Hash == hash  &&  entry->m_Status == status  &&
+            entry->m_Resource == resource) {
+            delete new_entry;
+            return entry;
+        }
+    }
+    delete new_entry;
+    return 0;
+}
+
+
+void CPerfLogAggregator::Add(CTempString resource, int status, double elapsed)
+{
+    SEntry* entry = x_GetEntry(resource, status);
+    if ( !entry ) {
+        ERR_POST_X_ONCE(35, Warning << "Too many resources in aggregated "
+            "performance log, timing of '" << resource << "' is ignored");
+        return;
+    }
+    entry->m_Histogram.Add(Uint8(elapsed*kMicroSecondsPerSecond + 0.5));
+    if ( !m_ThreadStarted.load(memory_order_relaxed) ) {
+        x_StartThread();
+    }
+}
+
+
+void CPerfLogAggregator::x_StartThread(void)
+{
+    CFastMutexGuard guard(m_ThreadMutex);
+    if ( m_ThreadStarted.load() ) {
+        return;
+    }
+    // Never restart the thread after Shutdown().
+    m_ThreadStarted.store(true);
+    if (TPerfLoggingInterval::GetDefault() <= 0) {
+        return;
+    }
+    CPerfLogReportThread* thr = new CPerfLogReportThread(*this);
+    thr->AddReference();
+    try {
+        thr->Run();
+    }
+    catch (CThreadException& e) {
+        thr->RemoveReference();
+        ERR_POST_X(30, Warning << "Failed to start aggregated performance "
+            "log thread, timings are reported on exit only: " << e.what());
+        return;
+    }
+    m_Thread = thr;
+}
+
+
+void CPerfLogAggregator::x_StopThread(void)
+{
+    CFastMutexGuard guard(m_ThreadMutex);
+    m_ThreadStarted.store(true);
+    if ( m_Thread ) {
+        m_Thread->Stop();
+        m_Thread->RemoveReference();
+        m_Thread = 0;
+    }
+}
+
+
+void CPerfLogAggregator::Shutdown(void)
+{
+    x_StopThread();
+    Report();
+}
+
+
+static string s_FormatUsec(Uint8 usec)
+{
+    return NStr::DoubleToString(double(usec)/kMicroSecondsPerSecond,
+        6, NStr::fDoubleFixed);
+}
+
+
+void CPerfLogAggregator::Report(void)
+{
+    CFastMutexGuard guard(m_ReportMutex);
+    CPerfLogHistogram::SSnapshot snapshot;
+    for (size_t i = 0; i < kTableSize; ++i) {
+        SEntry* entry = m_Table[i].load(memory_order_acquire);
+        if ( !entry ) {
+            continue;
+        }
+        entry->m_Histogram.Extract(snapshot);
+        if (snapshot.m_Count == 0) {
+            continue;
+        }
+        SDiagMessage::TExtraArgs args;
+        args.push_back(SDiagMessage::TExtraArg("resource", entry->m_Resource));
+        args.push_back(SDiagMessage::TExtraArg("count",
+            NStr::NumericToString(snapshot.m_Count)));
+        args.push_back(SDiagMessage::TExtraArg("min",
+            s_FormatUsec(snapshot.m_Min)));
+        args.push_back(SDiagMessage::TExtraArg("p50",
+            s_FormatUsec(snapshot.GetPercentile(0.5))));
+        args.push_back(SDiagMessage::TExtraArg("p99",
+            s_FormatUsec(snapshot.GetPercentile(0.99))));
+        args.push_back(SDiagMessage::TExtraArg("p999",
+            s_FormatUsec(snapshot.GetPercentile(0.999))));
+        args.push_back(SDiagMessage::TExtraArg("max",
+            s_FormatUsec(snapshot.m_Max)));
+        // The time of the aggregated record is the average time.
+        double avg = double(snapshot.m_Sum)/snapshot.m_Count;
+        CPerfLogger::x_PostAggregated(entry->m_Status,
+            avg/kMicroSecondsPerSecond, args);
+    }
+}
+
+
+static CSafeStatic<CPerfLogAggregator> s_PerfLogAggregator;
+static atomic<Uint8> s_PerfLogSampleCounter(0);
+
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -66,12 +513,56 @@ void CPerfLogger::SetON(bool enable) {
 }
 
 
+bool CPerfLogger::IsAggregating(void)
+{
+    return TPerfLoggingAggregate::GetDefault();
+}
+
+
+void CPerfLogger::SetAggregating(bool enable)
+{
+    TPerfLoggingAggregate::SetDefault(enable);
+    if (enable  &&  !IsON()) {
+        ERR_POST_X(31, Warning << "Aggregated performance logging "
+            "requires [Log]PerfLogging to be enabled");
+    }
+}
+
+
+void CPerfLogger::ReportAggregated(void)
+{
+    s_PerfLogAggregator->Report();
+}
+
+
+void CPerfLogger::FlushAggregated(void)
+{
+    if ( IsAggregating() ) {
+        s_PerfLogAggregator->Shutdown();
+    }
+}
+
+
+void CPerfLogger::x_PostAggregated(int                       status,
+                                   double                    timespan,
+                                   SDiagMessage::TExtraArgs& args)
+{
+    // Do not use g_PostPerf() - hit id of the current request
+    // has nothing to do with the aggregated data.
+    CDiagContext_Extra(status, timespan, args).Flush();
+}
+
+
 CDiagContext_Extra CPerfLogger::Post(int         status,
                                      CTempString resource,
                                      CTempString status_msg)
 {
     Suspend();
     if ( !x_CheckValidity("Post")  ||  !CPerfLogger::IsON() ) {
+        if ( IsAggregating() ) {
+            ERR_POST_X_ONCE(31, Warning << "Aggregated performance logging "
+                "requires [Log]PerfLogging to be enabled");
+        }
         Discard();
         return GetDiagContext().Extra();
     }
@@ -80,13 +571,28 @@ CDiagContext_Extra CPerfLogger::Post(int         status,
         NCBI_THROW(CCoreException, eInvalidArg,
             "CPerfLogger::Log: resource name is not specified");
     }
+    double elapsed = m_StopWatch->Elapsed() + m_Adjustment;
+    if (elapsed < 0.0) {
+        elapsed = 0.0;
+    }
+    if ( IsAggregating() ) {
+        s_PerfLogAggregator->Add(resource, status, elapsed);
+    }
+    unsigned int sample = TPerfLoggingSample::GetDefault();
+    if (sample != 1  &&  (sample == 0  ||
+        s_PerfLogSampleCounter.fetch_add(1, memory_order_relaxed) % sample)) {
+        // Skip the raw record, any arguments added by the caller
+        // are ignored too.
+        Discard();
+        CDiagContext_Extra extra((int)status, elapsed, args);
+        extra.m_Discarded = true;
+        return extra;
+    }
     args.push_back(SDiagMessage::TExtraArg("resource", resource));
     if ( !status_msg.empty() ) {
         args.push_back(SDiagMessage::TExtraArg("status_msg", status_msg));
     }
-    double elapsed = m_StopWatch->Elapsed() + m_Adjustment;
-    CDiagContext_Extra extra = g_PostPerf((int)status,
-        elapsed < 0.0 ? 0.0 : elapsed, args);
+    CDiagContext_Extra extra = g_PostPerf((int)status, elapsed, args);
     Discard();
     return extra;
 }
@@ -34,6 +34,7 @@
 #include <corelib/ncbiapp.hpp>
 #include <corelib/ncbienv.hpp>
 #include <corelib/ncbireg.hpp>
+#include <corelib/ncbimempool.hpp>
 #include <algorithm>
 #include <unordered_map>
 
@@ -921,6 +922,51 @@ BOOST_AUTO_TEST_CASE(TestHeapStack)
 }
 
 
+class CBigObject : public CObject
+{
+public:
+    char m_Data[16384];
+};
+
+BOOST_AUTO_TEST_CASE(TestThreadMemoryPool)
+{
+    CRef<CObjectMemoryPool> pool(new CObjectMemoryPool);
+    CRef<CObjectInt> ref;
+    {
+        CObjectMemoryPoolGuard guard(pool);
+        BOOST_CHECK(CObjectMemoryPool::GetThreadPool() == pool);
+        CRef<CObjectInt> obj1(new CObjectInt(1));
+        CRef<CObjectInt> obj2(new CObjectInt(2));
+        BOOST_CHECK(obj1->CanBeDeleted());
+        BOOST_CHECK(obj2->CanBeDeleted());
+        // Both objects are bump allocated in the same chunk.
+        const char* ptr1 = reinterpret_cast<const char*>(obj1.GetPointer());
+        const char* ptr2 = reinterpret_cast<const char*>(obj2.GetPointer());
+        BOOST_CHECK(ptr2 > ptr1);
+        BOOST_CHECK(size_t(ptr2 - ptr1) < pool->GetChunkSize());
+        ref = obj2;
+
+        // Plain delete must work for objects from the pool.
+        CObjectInt* obj3 = new CObjectInt(3);
+        delete obj3;
+
+        // Big objects are allocated in heap.
+        CRef<CBigObject> big(new CBigObject);
+        BOOST_CHECK(big->CanBeDeleted());
+        {
+            // Null pool does not change the current one.
+            CObjectMemoryPoolGuard null_guard(0);
+            BOOST_CHECK(CObjectMemoryPool::GetThreadPool() == pool);
+        }
+    }
+    BOOST_CHECK(!CObjectMemoryPool::GetThreadPool());
+    // Objects may live longer than the pool.
+    pool.Reset();
+    BOOST_CHECK_EQUAL(ref->m_Int, 2);
+    ref.Reset();
+}
+
+
 #if (defined(NCBI_COMPILER_GCC) && (NCBI_COMPILER_VERSION < 300)) || defined(NCBI_COMPILER_MIPSPRO)
 # define NO_EMPTY_BASE_OPTIMIZATION
 #endif
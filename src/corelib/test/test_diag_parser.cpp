@@ -58,6 +58,7 @@ public:
 private:
     void x_CheckMessage(void);
     void x_CheckMessage(const string& message, bool valid);
+    void x_CheckBinary(void);
 };
 
 
@@ -283,6 +284,7 @@ int CDiagParserApp::Run(void)
                 "UNK_SESSION cgi_sample.cgi start", false);
 
     x_CheckMessage();
+    x_CheckBinary();
 
     return 0;
 }
@@ -358,6 +360,90 @@ void CDiagParserApp::x_CheckMessage(const string& message, bool valid)
 }
 
 
+class CCollectDiagMessages : public INextDiagMessage
+{
+public:
+    virtual void operator()(SDiagMessage& msg)
+    {
+        string text;
+        msg.Write(text);
+        m_Messages.push_back(text);
+    }
+    vector<string> m_Messages;
+};
+
+
+void CDiagParserApp::x_CheckBinary(void)
+{
+    // Parse text messages, write them in binary format, read back
+    // and compare the resulting text.
+    static const char* kMessages[] = {
+        "03960/000/0000/AB 2C2D0F7851AB7E40 0005/0005 "
+        "2006-09-27T13:41:56.123456 NCBIPC1204 UNK_CLIENT "
+        "UNK_SESSION cgi_sample.cgi start",
+        "03960/000/0000/RB 2C2D0F7851AB7E40 0010/0010 "
+        "2006-09-27T13:41:56.123456 NCBIPC1204 UNK_CLIENT "
+        "2C2D0F7851AB7E40_0000SID cgi_sample.cgi "
+        "request-start foo=bar&x=1%202",
+        "15176/003/0006/R 2A763B485350C030 0098/0008 "
+        "2006-10-17T12:59:47.123456 widget3 UNK_CLIENT "
+        "UNK_SESSION my_app Error: TEST(error text) "
+        "\"/home/user/c++/src/corelib/test/my_app.cpp\", "
+        "line 81: CMyApp::Thread_Run() "
+        "--- Message from thread 6",
+        "03960/000/0000/AE 2C2D0F7851AB7E40 0005/0005 "
+        "2006-09-27T13:41:56.123456 NCBIPC1204 UNK_CLIENT "
+        "UNK_SESSION cgi_sample.cgi stop 0 1.077030896"
+    };
+    string bin;
+    vector<string> expected;
+    // The same records written by the handler, directly and through
+    // ComposeMessage()/WriteMessage() as the async writer does.
+    CNcbiOstrstream handler_out;
+    CBinaryDiagHandler handler(&handler_out);
+    for (size_t i = 0; i < sizeof(kMessages)/sizeof(kMessages[0]); ++i) {
+        bool parsed = false;
+        SDiagMessage msg(kMessages[i], &parsed);
+        _ASSERT(parsed);
+        string text;
+        msg.Write(text);
+        expected.push_back(text);
+        msg.WriteBinary(bin);
+        handler.Post(msg);
+        _ASSERT(handler.AllowAsyncWrite(msg));
+        EDiagFileType file_type = eDiagFile_Err;
+        string composed = handler.ComposeMessage(msg, &file_type);
+        _ASSERT(file_type == eDiagFile_All);
+        handler.WriteMessage(composed.data(), composed.size(), file_type);
+    }
+    {{
+        CNcbiIstrstream in(bin.data(), bin.size());
+        CCollectDiagMessages collect;
+        SDiagMessage::ParseBinaryStream(in, collect);
+        _ASSERT(collect.m_Messages == expected);
+    }}
+    {{
+        string handler_bin = CNcbiOstrstreamToString(handler_out);
+        CNcbiIstrstream in(handler_bin.data(), handler_bin.size());
+        CCollectDiagMessages collect;
+        SDiagMessage::ParseBinaryStream(in, collect);
+        _ASSERT(collect.m_Messages.size() == expected.size()*2);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            _ASSERT(collect.m_Messages[i*2] == expected[i]);
+            _ASSERT(collect.m_Messages[i*2 + 1] == expected[i]);
+        }
+    }}
+    {{
+        // A corrupt length prefix must not allocate the claimed size.
+        string bad = bin + string(4, '\xff');
+        CNcbiIstrstream in(bad.data(), bad.size());
+        CCollectDiagMessages collect;
+        SDiagMessage::ParseBinaryStream(in, collect);
+        _ASSERT(collect.m_Messages == expected);
+    }}
+}
+
+
 ///////////////////////////////////
 // MAIN
 //
@@ -0,0 +1,204 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ * File Description:
+ *   Test and contention benchmark for CDistributedRWLock compared to
+ *   CFastRWLock and CRWLock.
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbithr.hpp>
+#include <corelib/ncbimtx.hpp>
+#include <corelib/ncbitime.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Shared table: readers check that all values are equal, writers
+//  increment all of them.
+
+template<class TLock>
+struct STable
+{
+    enum { kSize = 16 };
+
+    STable(void) { memset(m_Values, 0, sizeof(m_Values)); }
+
+    TLock m_Lock;
+    int   m_Values[kSize];
+};
+
+
+template<class TLock>
+class CTestThread : public CThread
+{
+public:
+    CTestThread(STable<TLock>& table, int iterations, int write_every)
+        : m_Table(table), m_Iterations(iterations), m_WriteEvery(write_every)
+        {}
+
+protected:
+    virtual void* Main(void)
+    {
+        for (int i = 1;  i <= m_Iterations;  ++i) {
+            if (m_WriteEvery  &&  i % m_WriteEvery == 0) {
+                typename TLock::TWriteLockGuard guard(m_Table.m_Lock);
+                for (int j = 0;  j < STable<TLock>::kSize;  ++j) {
+                    ++m_Table.m_Values[j];
+                }
+            }
+            else {
+                typename TLock::TReadLockGuard guard(m_Table.m_Lock);
+                int value = m_Table.m_Values[0];
+                for (int j = 1;  j < STable<TLock>::kSize;  ++j) {
+                    assert(m_Table.m_Values[j] == value);
+                }
+            }
+        }
+        return 0;
+    }
+
+private:
+    STable<TLock>& m_Table;
+    int            m_Iterations;
+    int            m_WriteEvery;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestDistributedRWLockApp : public CNcbiApplication
+{
+public:
+    void Init(void);
+    int  Run(void);
+
+private:
+    // Run the test with the given number of threads, return number of
+    // lock operations per second.
+    template<class TLock>
+    double x_Run(int threads);
+
+    template<class TLock>
+    void x_Test(const char* name);
+
+    int m_MaxThreads;
+    int m_Iterations;
+    int m_WriteEvery;
+};
+
+
+void CTestDistributedRWLockApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext("test_distributed_rwlock",
+                       "CDistributedRWLock test and benchmark");
+    d->AddDefaultKey("threads", "Threads", "Max number of threads",
+                     CArgDescriptions::eInteger, "8");
+    d->AddDefaultKey("iterations", "Iterations",
+                     "Number of lock operations per thread",
+                     CArgDescriptions::eInteger, "1000000");
+    d->AddDefaultKey("write_every", "WriteEvery",
+                     "Take write lock every N operations (0 - never)",
+                     CArgDescriptions::eInteger, "10000");
+    SetupArgDescriptions(d.release());
+}
+
+
+template<class TLock>
+double CTestDistributedRWLockApp::x_Run(int threads)
+{
+    STable<TLock> table;
+    vector< CRef<CThread> > thr;
+    CStopWatch sw(CStopWatch::eStart);
+    for (int i = 0;  i < threads;  ++i) {
+        thr.push_back(CRef<CThread>(
+            new CTestThread<TLock>(table, m_Iterations, m_WriteEvery)));
+        thr.back()->Run();
+    }
+    for (int i = 0;  i < threads;  ++i) {
+        thr[i]->Join();
+    }
+    double elapsed = sw.Elapsed();
+
+    int writes = m_WriteEvery ? m_Iterations / m_WriteEvery * threads : 0;
+    for (int j = 0;  j < STable<TLock>::kSize;  ++j) {
+        assert(table.m_Values[j] == writes);
+    }
+    return elapsed > 0 ? double(m_Iterations)*threads/elapsed : 0;
+}
+
+
+template<class TLock>
+void CTestDistributedRWLockApp::x_Test(const char* name)
+{
+    NcbiCout << setw(20) << left << name;
+    for (int threads = 1;  threads <= m_MaxThreads;  threads *= 2) {
+        NcbiCout << " " << setw(10) << right
+                 << (Uint8) (x_Run<TLock>(threads) / 1000);
+    }
+    NcbiCout << NcbiEndl;
+}
+
+
+int CTestDistributedRWLockApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    m_MaxThreads = args["threads"].AsInteger();
+    m_Iterations = args["iterations"].AsInteger();
+    m_WriteEvery = args["write_every"].AsInteger();
+
+    NcbiCout << "Thousands of lock operations per second by thread count"
+             << NcbiEndl << setw(20) << left << "threads:";
+    for (int threads = 1;  threads <= m_MaxThreads;  threads *= 2) {
+        NcbiCout << " " << setw(10) << right << threads;
+    }
+    NcbiCout << NcbiEndl;
+
+    x_Test<CRWLock>("CRWLock");
+    x_Test<CFastRWLock>("CFastRWLock");
+    x_Test<CDistributedRWLock>("CDistributedRWLock");
+
+    NcbiCout << "Test completed successfully!" << NcbiEndl;
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestDistributedRWLockApp().AppMain(argc, argv);
+}
@@ -0,0 +1,418 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ * File Description:
+ *   Test for CFileAsyncIO, and random read benchmark comparing it with
+ *   a loop of positioned reads (CFileIO::ReadAt).
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbitime.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test data: each 4-byte word of the file contains its own index,
+//  scrambled a bit.
+
+static inline Uint4 s_Word(Uint8 index)
+{
+    return (Uint4) (index * 2654435761u) ^ 0x5bd1e995;
+}
+
+
+static void s_Fill(char* buf, Uint8 position, size_t size)
+{
+    Uint4* p = (Uint4*) buf;
+    for (size_t i = 0;  i < size / 4;  ++i) {
+        p[i] = s_Word(position / 4 + i);
+    }
+}
+
+
+static bool s_Check(const char* buf, Uint8 position, size_t size)
+{
+    const Uint4* p = (const Uint4*) buf;
+    for (size_t i = 0;  i < size / 4;  ++i) {
+        if (p[i] != s_Word(position / 4 + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// xorshift64*, good enough for random file positions
+class CRand
+{
+public:
+    CRand(Uint8 seed) : m_State(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+    Uint8 GetIndex(Uint8 size)
+    {
+        m_State ^= m_State >> 12;
+        m_State ^= m_State << 25;
+        m_State ^= m_State >> 27;
+        return (m_State * 0x2545F4914F6CDD1DULL >> 11) % size;
+    }
+private:
+    Uint8 m_State;
+};
+
+
+static const char* s_BackendName(CFileAsyncIO::EBackend backend)
+{
+    switch (backend) {
+    case CFileAsyncIO::eIOUring:    return "io_uring";
+    case CFileAsyncIO::eThreadPool: return "thread pool";
+    default:                        break;
+    }
+    return "default";
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestFileAsyncIOApp : public CNcbiApplication
+{
+public:
+    void Init(void);
+    int  Run(void);
+
+private:
+    void x_CreateFile(const string& path);
+    void x_Test(CFileAsyncIO::EBackend backend);
+
+    // Random reads benchmark, return number of reads per second.
+    // 'depth' 0 means synchronous CFileIO::ReadAt() loop.
+    double x_Benchmark(CFileAsyncIO::EBackend backend, unsigned int depth);
+
+    string       m_Path;
+    Uint8        m_Size;
+    size_t       m_Block;
+    int          m_Reads;
+    bool         m_Verify;
+    CFileIO      m_File;
+};
+
+
+void CTestFileAsyncIOApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext("test_file_async_io",
+                       "CFileAsyncIO test and random read benchmark");
+    d->AddDefaultKey("size", "MB", "Size of the test file, in megabytes",
+                     CArgDescriptions::eInteger, "64");
+    d->AddDefaultKey("block", "Bytes", "Size of each random read",
+                     CArgDescriptions::eInteger, "4096");
+    d->AddDefaultKey("reads", "Reads", "Number of random reads to benchmark",
+                     CArgDescriptions::eInteger, "20000");
+    d->AddDefaultKey("depth", "Depth", "Max queue depth to benchmark",
+                     CArgDescriptions::eInteger, "64");
+    d->AddOptionalKey("file", "File",
+                      "Existing file to use for the read benchmark instead "
+                      "of the test one.  Use a file much larger than RAM, "
+                      "or drop the page cache, to measure the device.",
+                      CArgDescriptions::eInputFile);
+    SetupArgDescriptions(d.release());
+}
+
+
+void CTestFileAsyncIOApp::x_CreateFile(const string& path)
+{
+    // Write the file with asynchronous writes, 1MB each
+    const size_t kChunk = 1024 * 1024;
+    size_t chunks = (size_t) ((m_Size + kChunk - 1) / kChunk);
+    vector<char> data(chunks * kChunk);
+    s_Fill(data.data(), 0, data.size());
+
+    CFileIO file;
+    file.Open(path, CFileIO::eCreate, CFileIO::eReadWrite);
+    CFileAsyncIO aio(8);
+    for (size_t i = 0;  i < chunks;  ++i) {
+        Uint8 pos = (Uint8) i * kChunk;
+        size_t n = (size_t) min((Uint8) kChunk, m_Size - pos);
+        aio.Write(file.GetFileHandle(), pos, &data[(size_t) pos], n,
+                  (void*) i);
+    }
+    CFileAsyncIO::TCompletions done;
+    assert(aio.WaitAll(done) == chunks);
+    assert(aio.GetPending() == 0);
+    vector<bool> seen(chunks);
+    ITERATE(CFileAsyncIO::TCompletions, it, done) {
+        size_t i = (size_t) it->cookie;
+        assert(it->error == 0);
+        assert(it->op == CFileAsyncIO::eWrite);
+        assert(it->position == (Uint8) i * kChunk);
+        assert(it->bytes == (size_t) min((Uint8) kChunk,
+                                         m_Size - it->position));
+        assert( !seen[i] );
+        seen[i] = true;
+    }
+    assert(file.GetFileSize() == m_Size);
+}
+
+
+void CTestFileAsyncIOApp::x_Test(CFileAsyncIO::EBackend backend)
+{
+    NcbiCout << "Testing " << s_BackendName(backend) << NcbiEndl;
+
+    CFileAsyncIO aio(16, backend);
+    assert(aio.GetBackend() == backend);
+    assert(aio.GetQueueDepth() == 16);
+    TFileHandle fh = m_File.GetFileHandle();
+    CFileAsyncIO::TCompletions done;
+
+    // Nothing to wait for
+    assert(aio.Wait(done) == 0);
+    assert(aio.WaitAll(done) == 0);
+    assert(done.empty());
+
+    // Many more random reads than the queue depth; buffers are reused
+    // as soon as they are reaped.
+    const int    kReads = 1000;
+    const size_t kBlock = 4096;
+    CRand rnd(1);
+    vector< vector<char> > bufs(32, vector<char>(kBlock * 2));
+    vector<size_t> free_bufs;
+    for (size_t i = 0;  i < bufs.size();  ++i) {
+        free_bufs.push_back(i);
+    }
+    Uint8 blocks = m_Size / kBlock - 2;
+    int queued = 0, completed = 0;
+    while (completed < kReads) {
+        while (queued < kReads  &&  !free_bufs.empty()) {
+            size_t b = free_bufs.back();
+            free_bufs.pop_back();
+            Uint8 pos = (Uint8) rnd.GetIndex(blocks) * kBlock + 4 * b;
+            aio.Read(fh, pos, bufs[b].data(), bufs[b].size(), (void*) b);
+            ++queued;
+        }
+        done.clear();
+        size_t n = aio.Wait(done, 4);
+        assert(n == done.size()  &&  n > 0);
+        ITERATE(CFileAsyncIO::TCompletions, it, done) {
+            size_t b = (size_t) it->cookie;
+            assert(it->error == 0);
+            assert(it->op == CFileAsyncIO::eRead);
+            assert(it->bytes == bufs[b].size());
+            assert(s_Check(bufs[b].data(), it->position, it->bytes));
+            free_bufs.push_back(b);
+        }
+        completed += (int) n;
+    }
+    assert(aio.GetPending() == 0);
+
+    // Reads at and after the end of file
+    vector<char> buf(10000);
+    aio.Read(fh, m_Size - 400, buf.data(), buf.size());
+    aio.Read(fh, m_Size, buf.data(), 100);
+    aio.Read(fh, m_Size + 4096, buf.data(), 100);
+    done.clear();
+    assert(aio.WaitAll(done) == 3);
+    ITERATE(CFileAsyncIO::TCompletions, it, done) {
+        assert(it->error == 0);
+        assert(it->bytes == (it->position < m_Size ? 400 : 0));
+    }
+    assert(s_Check(buf.data(), m_Size - 400, 400));
+
+    // Errors are reported for each request
+    CFileIO rdonly;
+    rdonly.Open(m_Path, CFileIO::eOpen, CFileIO::eRead);
+    aio.Write(rdonly.GetFileHandle(), 0, buf.data(), 100, (void*) 1);
+    aio.Read(fh, 0, buf.data(), 100, (void*) 2);
+    done.clear();
+    assert(aio.WaitAll(done) == 2);
+    ITERATE(CFileAsyncIO::TCompletions, it, done) {
+        if (it->cookie == (void*) 1) {
+            assert(it->error != 0);
+        } else {
+            assert(it->error == 0  &&  it->bytes == 100);
+        }
+    }
+
+    // Non-blocking reaping
+    aio.Read(fh, 0, buf.data(), 100);
+    assert(aio.Submit() == 1);
+    done.clear();
+    while (aio.Wait(done, 0) == 0) {
+        assert(aio.GetPending() == 1);
+    }
+    assert(done.size() == 1  &&  aio.GetPending() == 0);
+
+    // Requests still running are waited for in the destructor
+    {{
+        CFileAsyncIO aio2(4, backend);
+        for (int i = 0;  i < 10;  ++i) {
+            aio2.Read(fh, i * 1000, buf.data() + i * 1000, 1000);
+        }
+        aio2.Submit();
+    }}
+}
+
+
+double CTestFileAsyncIOApp::x_Benchmark(CFileAsyncIO::EBackend backend,
+                                        unsigned int           depth)
+{
+    CRand rnd(2);
+    Uint8 blocks = m_Size / m_Block;
+    unsigned int bufs = max(depth, 1u);
+    vector<char> data(bufs * m_Block);
+    TFileHandle fh = m_File.GetFileHandle();
+
+    CStopWatch sw(CStopWatch::eStart);
+    if (depth == 0) {
+        for (int i = 0;  i < m_Reads;  ++i) {
+            Uint8 pos = rnd.GetIndex(blocks) * m_Block;
+            size_t n = m_File.ReadAt(pos, data.data(), m_Block);
+            assert(n == m_Block);
+            assert( !m_Verify  ||  s_Check(data.data(), pos, n) );
+        }
+    } else {
+        CFileAsyncIO aio(depth, backend);
+        CFileAsyncIO::TCompletions done;
+        vector<char*> free_bufs;
+        for (unsigned int i = 0;  i < bufs;  ++i) {
+            free_bufs.push_back(&data[i * m_Block]);
+        }
+        int queued = 0, completed = 0;
+        while (completed < m_Reads) {
+            while (queued < m_Reads  &&  !free_bufs.empty()) {
+                char* buf = free_bufs.back();
+                free_bufs.pop_back();
+                Uint8 pos = rnd.GetIndex(blocks) * m_Block;
+                aio.Read(fh, pos, buf, m_Block, buf);
+                ++queued;
+            }
+            done.clear();
+            completed += (int) aio.Wait(done);
+            ITERATE(CFileAsyncIO::TCompletions, it, done) {
+                char* buf = (char*) it->cookie;
+                assert(it->error == 0  &&  it->bytes == m_Block);
+                assert( !m_Verify  ||  s_Check(buf, it->position, m_Block) );
+                free_bufs.push_back(buf);
+            }
+        }
+    }
+    double elapsed = sw.Elapsed();
+    return elapsed > 0 ? m_Reads / elapsed : 0;
+}
+
+
+int CTestFileAsyncIOApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    m_Size   = (Uint8) args["size"].AsInteger() * 1024 * 1024;
+    m_Block  = (size_t) args["block"].AsInteger();
+    m_Reads  = args["reads"].AsInteger();
+    unsigned int max_depth = (unsigned int) args["depth"].AsInteger();
+
+    vector<CFileAsyncIO::EBackend> backends;
+    if ( CFileAsyncIO::IsIOUringAvailable() ) {
+        backends.push_back(CFileAsyncIO::eIOUring);
+    }
+    backends.push_back(CFileAsyncIO::eThreadPool);
+    {{
+        CFileAsyncIO aio;
+        NcbiCout << "Default engine: " << s_BackendName(aio.GetBackend())
+                 << NcbiEndl;
+        assert(aio.GetBackend() != CFileAsyncIO::eDefault);
+    }}
+
+    // Functional tests on the generated file
+    m_Path = CFile::GetTmpName();
+    x_CreateFile(m_Path);
+    m_File.Open(m_Path, CFileIO::eOpen, CFileIO::eReadWrite);
+    ITERATE(vector<CFileAsyncIO::EBackend>, it, backends) {
+        x_Test(*it);
+    }
+
+    // Positioned synchronous I/O does not move the file pointer on UNIX
+    vector<char> buf(1000);
+    m_File.SetFilePos(10);
+    assert(m_File.ReadAt(4000, buf.data(), buf.size()) == buf.size());
+    assert(s_Check(buf.data(), 4000, buf.size()));
+    assert(m_File.ReadAt(m_Size - 8, buf.data(), buf.size()) == 8);
+    assert(m_File.ReadAt(m_Size, buf.data(), buf.size()) == 0);
+#if defined(NCBI_OS_UNIX)
+    assert(m_File.GetFilePos() == 10);
+#endif
+    s_Fill(buf.data(), 0, buf.size());
+    assert(m_File.WriteAt(0, buf.data(), buf.size()) == buf.size());
+
+    // Random reads benchmark
+    m_Verify = true;
+    if ( args["file"] ) {
+        m_File.Close();
+        m_File.Open(args["file"].AsString(), CFileIO::eOpen, CFileIO::eRead);
+        m_Size   = m_File.GetFileSize();
+        m_Verify = false;
+    }
+    if (m_Size / m_Block == 0) {
+        ERR_POST(Fatal << "File is too small for the benchmark");
+    }
+    NcbiCout << NcbiEndl << "Random " << m_Block << "-byte reads from "
+             << m_Size / (1024 * 1024) << "MB file, thousands per second"
+             << NcbiEndl << setw(14) << left << "ReadAt() loop"
+             << setw(10) << right
+             << (Uint8) (x_Benchmark(CFileAsyncIO::eDefault, 0) / 1000)
+             << NcbiEndl << setw(14) << left << "queue depth:";
+    for (unsigned int depth = 1;  depth <= max_depth;  depth *= 4) {
+        NcbiCout << setw(10) << right << depth;
+    }
+    NcbiCout << NcbiEndl;
+    ITERATE(vector<CFileAsyncIO::EBackend>, it, backends) {
+        NcbiCout << setw(14) << left << s_BackendName(*it);
+        for (unsigned int depth = 1;  depth <= max_depth;  depth *= 4) {
+            NcbiCout << setw(10) << right
+                     << (Uint8) (x_Benchmark(*it, depth) / 1000);
+        }
+        NcbiCout << NcbiEndl;
+    }
+
+    m_File.Close();
+    CFile(m_Path).Remove();
+
+    NcbiCout << "Test completed successfully!" << NcbiEndl;
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestFileAsyncIOApp().AppMain(argc, argv);
+}
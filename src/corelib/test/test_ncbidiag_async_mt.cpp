@@ -0,0 +1,161 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ * File Description:
+ *   Test for CAsyncDiagHandler with per-thread buffers
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/test_mt.hpp>
+#include <corelib/ncbidiag.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+static const int kMessagesPerThread = 2000;
+static const char* kMarker = "async-test ";
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestAsyncDiagApp : public CThreadedApp
+{
+public:
+    virtual bool Thread_Run(int idx);
+protected:
+    virtual bool TestApp_Args(CArgDescriptions& args);
+    virtual bool TestApp_Init(void);
+    virtual bool TestApp_Exit(void);
+private:
+    CAsyncDiagHandler m_Handler;
+    bool              m_Drop;
+};
+
+
+static CNcbiOstrstream s_Sout;
+
+
+bool CTestAsyncDiagApp::TestApp_Args(CArgDescriptions& args)
+{
+    args.AddDefaultKey("overflow", "Policy", "Full buffer policy",
+        CArgDescriptions::eString, "Block");
+    args.SetConstraint("overflow", &(*new CArgAllow_Strings, "Block", "Drop"));
+    return true;
+}
+
+
+bool CTestAsyncDiagApp::Thread_Run(int idx)
+{
+    for (int i = 0; i < kMessagesPerThread; ++i) {
+        ERR_POST(Note << kMarker << idx << " " << i);
+    }
+    return true;
+}
+
+
+bool CTestAsyncDiagApp::TestApp_Init(void)
+{
+    const CArgs& args = GetArgs();
+    m_Drop = args["overflow"].AsString() == "Drop";
+    // Use small buffers to make sure they overflow. The registry is not
+    // loaded from a file, so use environment to set the parameters.
+    CNcbiEnvironment& env = SetEnvironment();
+    env.Set("DIAG_ASYNC_THREAD_BUFFER_SIZE", "4096");
+    env.Set("DIAG_ASYNC_OVERFLOW", args["overflow"].AsString());
+
+    NcbiCout << NcbiEndl
+             << "Testing CAsyncDiagHandler with "
+             << NStr::IntToString(s_NumThreads)
+             << " threads (" << args["overflow"].AsString() << ")..."
+             << NcbiEndl;
+    GetDiagContext().SetOldPostFormat(true);
+    SetDiagPostFlag(eDPF_Severity);
+    UnsetDiagPostFlag(eDPF_File);
+    UnsetDiagPostFlag(eDPF_Line);
+    SetDiagStream(&s_Sout);
+    m_Handler.InstallToDiag(); /* NCBI_FAKE_WARNING */
+    return true;
+}
+
+
+bool CTestAsyncDiagApp::TestApp_Exit(void)
+{
+    Uint8 dropped = m_Handler.GetDroppedCount();
+    m_Handler.RemoveFromDiag();
+    SetDiagStream(0);
+
+    string test_res = CNcbiOstrstreamToString(s_Sout);
+    vector<string> lines;
+    NStr::Split(test_res, "\r\n", lines,
+        NStr::fSplit_MergeDelimiters | NStr::fSplit_Truncate);
+
+    // Messages from each thread must be printed in the original order.
+    vector<int> last(s_NumThreads + 1, -1);
+    size_t count = 0;
+    ITERATE(vector<string>, it, lines) {
+        SIZE_TYPE pos = NStr::Find(*it, kMarker);
+        if (pos == NPOS) {
+            continue;
+        }
+        string thr, seq;
+        NStr::SplitInTwo(it->substr(pos + strlen(kMarker)), " ", thr, seq);
+        size_t idx = NStr::StringToNumeric<size_t>(thr);
+        int i = NStr::StringToInt(seq);
+        assert(idx < last.size());
+        assert(i > last[idx]);
+        last[idx] = i;
+        ++count;
+    }
+
+    size_t total = size_t(s_NumThreads)*kMessagesPerThread;
+    if ( m_Drop ) {
+        assert(count + dropped == total);
+    }
+    else {
+        assert(dropped == 0);
+        assert(count == total);
+    }
+
+    NcbiCout << "Printed " << count << " messages, dropped " << dropped
+             << NcbiEndl
+             << "Test completed successfully!"
+             << NcbiEndl << NcbiEndl;
+    return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestAsyncDiagApp().AppMain(argc, argv);
+}
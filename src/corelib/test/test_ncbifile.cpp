@@ -1052,6 +1052,164 @@ static void s_TEST_Link(void)
 }
 
 
+//----------------------------------------------------------------------------
+//  Parallel directory tree walking
+//----------------------------------------------------------------------------
+
+// Collect relative paths and sizes of all entries
+class CCollectVisitor : public CDirTreeWalker::IVisitor
+{
+public:
+    CCollectVisitor(const string& top) : m_Top(top), m_DirEnds(0) {}
+
+    virtual EAction OnEntry(const SEntry& entry)
+    {
+        assert( entry.has_stat );
+        CFastMutexGuard guard(m_Mutex);
+        string rel = entry.path.substr(m_Top.size());
+        Int8 size = entry.type == CDirEntry::eFile ?
+            (Int8) entry.stat.orig.st_size : -1;
+        assert( m_Entries.insert(make_pair(rel, size)).second );
+        return CDirTreeWalker::eContinue;
+    }
+    virtual EAction OnDirEnd(const SEntry& dir)
+    {
+        CFastMutexGuard guard(m_Mutex);
+        // All entries in the directory are visited already
+        string self = dir.path.substr(m_Top.size());
+        string rel  = CDirEntry::AddTrailingPathSeparator(self);
+        ITERATE(TEntries, it, m_Entries) {
+            if (it->first != self  &&  NStr::StartsWith(it->first, rel)) {
+                assert( m_Ended.find(it->first) != m_Ended.end()  ||
+                        it->second >= 0 );
+            }
+        }
+        m_Ended.insert(self);
+        ++m_DirEnds;
+        return CDirTreeWalker::eContinue;
+    }
+
+    typedef map<string, Int8> TEntries;
+    string      m_Top;
+    TEntries    m_Entries;
+    set<string> m_Ended;
+    int         m_DirEnds;
+    CFastMutex  m_Mutex;
+};
+
+
+// Stop after the given number of entries
+class CStopVisitor : public CDirTreeWalker::IVisitor
+{
+public:
+    CStopVisitor(int limit, bool do_throw)
+        : m_Count(0), m_Limit(limit), m_Throw(do_throw) {}
+
+    virtual EAction OnEntry(const SEntry& /*entry*/)
+    {
+        CFastMutexGuard guard(m_Mutex);
+        if (++m_Count < m_Limit) {
+            return CDirTreeWalker::eContinue;
+        }
+        if ( m_Throw ) {
+            NCBI_THROW(CFileException, eNotExists, "Stop walking");
+        }
+        return CDirTreeWalker::eStop;
+    }
+
+    int        m_Count;
+    int        m_Limit;
+    bool       m_Throw;
+    CFastMutex m_Mutex;
+};
+
+
+static void s_TEST_DirTreeWalker(void)
+{
+    const string top = "dir_walker";
+    const int kDirs = 5, kDepth = 3, kFiles = 10;
+    int expected = 1, dirs = 1;
+
+    // Create tree
+    CDir(top).Remove();
+    assert( CDir(top).Create() );
+    vector<string> level(1, top);
+    for (int depth = 0;  depth < kDepth;  ++depth) {
+        vector<string> next;
+        ITERATE(vector<string>, it, level) {
+            for (int i = 0;  i < kFiles;  ++i) {
+                string file = CDirEntry::ConcatPath(*it, "file" + NStr::IntToString(i));
+                CNcbiOfstream fs(file.c_str(), ios::out | ios::binary);
+                fs << string(i * 10, 'x');
+                assert( fs.good() );
+                ++expected;
+            }
+            for (int i = 0;  i < kDirs;  ++i) {
+                string dir = CDirEntry::ConcatPath(*it, "dir" + NStr::IntToString(i));
+                assert( CDir(dir).CreatePath() );
+                next.push_back(dir);
+                ++expected;
+                ++dirs;
+            }
+        }
+        level.swap(next);
+    }
+
+    // Walk with different number of threads, results must be the same
+    CCollectVisitor::TEntries entries;
+    for (unsigned int threads = 1;  threads <= 8;  threads *= 2) {
+        CDirTreeWalker walker(threads, CDirTreeWalker::fStat);
+        CCollectVisitor visitor(top);
+        assert( walker.Walk(top, visitor) );
+        assert( (int) visitor.m_Entries.size() == expected );
+        assert( visitor.m_DirEnds == dirs );
+        if (threads == 1) {
+            entries = visitor.m_Entries;
+        } else {
+            assert( visitor.m_Entries == entries );
+        }
+    }
+
+    // Stop walking, by request and by exception
+    {{
+        CDirTreeWalker walker(4);
+        CStopVisitor visitor(20, false);
+        assert( !walker.Walk(top, visitor) );
+        assert( visitor.m_Count < expected );
+    }}
+    {{
+        CDirTreeWalker walker(4);
+        CStopVisitor visitor(20, true);
+        try {
+            walker.Walk(top, visitor);
+            assert( false );
+        }
+        catch (CFileException& e) {
+            assert( e.GetMsg() == "Stop walking" );
+        }
+    }}
+
+    // Copy and compare
+    const string copy = "dir_walker_copy";
+    CDir(copy).Remove();
+    assert( CDir(top).CopyParallel(copy, CDirEntry::fCF_Default, 4) );
+    {{
+        CDirTreeWalker walker(4, CDirTreeWalker::fStat);
+        CCollectVisitor visitor(copy);
+        assert( walker.Walk(copy, visitor) );
+        assert( visitor.m_Entries == entries );
+    }}
+
+    // Remove
+    assert( CDir(top).RemoveParallel(CDir::eRecursive, 4) );
+    assert( !CDir(top).Exists() );
+    assert( CDir(copy).RemoveParallel() );
+    assert( !CDir(copy).Exists() );
+    assert( !CDir(copy).RemoveParallel() );
+    assert( CDir(copy).RemoveParallel(CDir::eRecursiveIgnoreMissing) );
+}
+
+
 //----------------------------------------------------------------------------
 // Memory mapping
 //----------------------------------------------------------------------------
@@ -1695,6 +1853,8 @@ int CTest::Run(void)
         s_TEST_Dir();
         // CSymLink
         s_TEST_Link();
+        // CDirTreeWalker
+        s_TEST_DirTreeWalker();
         // CMemoryFile
         s_TEST_MemoryFile();
         // CFileIO
@@ -34,6 +34,7 @@
 #include <corelib/ncbi_limits.h>
 #include <corelib/version.hpp>
 #include <corelib/ncbi_xstr.hpp>
+#include <corelib/ncbistr_util.hpp>
 #include <corelib/ncbifloat.h>
 #include <corelib/ncbitime.hpp>
 #include <corelib/ncbiexec.hpp>
@@ -3282,6 +3283,54 @@ BOOST_AUTO_TEST_CASE(s_Split_Flags)
 }
 
 
+BOOST_AUTO_TEST_CASE(s_StrTokenView)
+{
+    size_t count = (sizeof(s_SplitTest) / sizeof(s_SplitTest[0]));
+
+    for (size_t i = 0; i < count; i++) {
+        const SSplit& data = s_SplitTest[i];
+
+        // Must produce the same tokens at the same positions as Split()
+        CTempString_Storage   storage;
+        vector<CTempStringEx> v;
+        vector<SIZE_TYPE>     token_pos;
+        bool split_ok = true;
+        try {
+            NStr::Split(data.str, data.delim, v, data.flags, &token_pos, &storage);
+        } catch (CStringException&) {
+            split_ok = false;
+        }
+        // Use the view twice to check that begin() restarts it
+        CStrTokenView view(data.str, data.delim, data.flags);
+        for (int pass = 0;  pass < 2;  ++pass) {
+            size_t j = 0;
+            try {
+                for (CStrTokenView::const_iterator it = view.begin();
+                     it != view.end();  ++it, ++j) {
+                    BOOST_REQUIRE(j < v.size());
+                    BOOST_CHECK_EQUAL(*it, v[j]);
+                    BOOST_CHECK_EQUAL(view.GetTokenPos(), token_pos[j]);
+                }
+                BOOST_CHECK(split_ok);
+                BOOST_CHECK_EQUAL(j, v.size());
+            } catch (CStringException&) {
+                BOOST_CHECK( !split_ok );
+            }
+        }
+    }
+
+    // Range-based for
+    string s;
+    for (CTempString token : CStrTokenView("a,\"b,c\",,d,", ",",
+                                           NStr::fSplit_CanQuote |
+                                           NStr::fSplit_MergeDelimiters |
+                                           NStr::fSplit_Truncate)) {
+        s += string(token) + "|";
+    }
+    BOOST_CHECK_EQUAL(s, "a|b,c|d|");
+}
+
+
 //----------------------------------------------------------------------------
 // NStr::SplitInTwo()
 //----------------------------------------------------------------------------
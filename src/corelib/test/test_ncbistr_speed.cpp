@@ -0,0 +1,387 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ * File Description:
+ *   Speed and correctness test for NStr search, split, nocase compare
+ *   and integer conversion, compared to plain byte-at-a-time loops.
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/ncbistr.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+// Simple reproducible random numbers in [from, to]
+static Uint8 s_Rand(Uint8 from, Uint8 to)
+{
+    static Uint8 s_Seed = 1;
+    s_Seed = s_Seed*NCBI_CONST_UINT8(6364136223846793005) + 1442695040888963407;
+    return from + (s_Seed >> 33) % (to - from + 1);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Reference implementations (byte-at-a-time)
+
+static void s_RefSplit(const string& str, char delim, vector<CTempString>& arr)
+{
+    arr.clear();
+    SIZE_TYPE start = 0;
+    for (SIZE_TYPE i = 0;  i < str.size();  ++i) {
+        if (str[i] == delim) {
+            arr.push_back(CTempString(str, start, i - start));
+            start = i + 1;
+        }
+    }
+    arr.push_back(CTempString(str, start, str.size() - start));
+}
+
+
+static int s_RefCompareNocase(const CTempString s1, const CTempString s2)
+{
+    SIZE_TYPE n = min(s1.size(), s2.size());
+    for (SIZE_TYPE i = 0;  i < n;  ++i) {
+        int c1 = tolower((unsigned char) s1[i]);
+        int c2 = tolower((unsigned char) s2[i]);
+        if (c1 != c2) {
+            return c1 - c2;
+        }
+    }
+    return s1.size() == s2.size() ? 0 : (s1.size() > s2.size() ? 1 : -1);
+}
+
+
+static SIZE_TYPE s_RefFindNocase(const CTempString str,
+                                 const CTempString pattern)
+{
+    if (pattern.size() > str.size()) {
+        return NPOS;
+    }
+    for (SIZE_TYPE i = 0;  i + pattern.size() <= str.size();  ++i) {
+        if (s_RefCompareNocase(CTempString(str, i, pattern.size()),
+                               pattern) == 0) {
+            return i;
+        }
+    }
+    return NPOS;
+}
+
+
+static Int8 s_RefStringToInt8(const CTempString str)
+{
+    SIZE_TYPE pos = 0;
+    bool sign = false;
+    if (pos < str.size()  &&  (str[pos] == '-'  ||  str[pos] == '+')) {
+        sign = str[pos++] == '-';
+    }
+    Int8 n = 0;
+    for ( ;  pos < str.size();  ++pos) {
+        n = n*10 + (str[pos] - '0');
+    }
+    return sign ? -n : n;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestNStrSpeedApp : public CNcbiApplication
+{
+public:
+    void Init(void);
+    int  Run(void);
+
+private:
+    void x_MakeData(void);
+    void x_Report(const char* name, double ref_time, double time);
+
+    void x_TestSplit(void);
+    void x_TestCompareNocase(void);
+    void x_TestFindNocase(void);
+    void x_TestStringToInt(void);
+
+    int            m_Count;
+    vector<string> m_GffLines;
+    vector<string> m_Numbers;
+};
+
+
+void CTestNStrSpeedApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext("test_ncbistr_speed",
+                       "NStr kernels speed and correctness test");
+    d->AddDefaultKey("count", "Count", "Number of passes over the data",
+                     CArgDescriptions::eInteger, "100");
+    SetupArgDescriptions(d.release());
+}
+
+
+void CTestNStrSpeedApp::x_MakeData(void)
+{
+    static const char* const kSeqIds[] = {
+        "NC_000001.11", "NW_025791756.1", "NT_187361.1", "chrUn_KI270742v1"
+    };
+    static const char* const kTypes[] = {
+        "gene", "mRNA", "exon", "CDS", "region", "five_prime_UTR"
+    };
+    for (int i = 0;  i < 2000;  ++i) {
+        Uint8 start = s_Rand(1, 248000000);
+        string line = string(kSeqIds[s_Rand(0, 3)])
+            + "\tRefSeq\t" + kTypes[s_Rand(0, 5)]
+            + "\t" + NStr::UInt8ToString(start)
+            + "\t" + NStr::UInt8ToString(start + s_Rand(1, 50000))
+            + "\t.\t" + (s_Rand(0, 1) ? "+" : "-") + "\t"
+            + NStr::UInt8ToString(s_Rand(0, 2))
+            + "\tID=exon-NM_" + NStr::UInt8ToString(s_Rand(0, kMax_Int))
+            + ";Parent=rna-NM_" + NStr::UInt8ToString(s_Rand(0, kMax_Int))
+            + ";Dbxref=GeneID:" + NStr::UInt8ToString(s_Rand(0, kMax_Int))
+            + ",HGNC:HGNC:" + NStr::UInt8ToString(s_Rand(1, 50000))
+            + ";gbkey=mRNA;gene=SAMD11;product=sterile alpha motif domain "
+              "containing 11, transcript variant X"
+            + NStr::UInt8ToString(s_Rand(1, 20));
+        m_GffLines.push_back(line);
+
+        Int8 num = Int8(s_Rand(0, kMax_I8) >> s_Rand(0, 62));
+        m_Numbers.push_back(NStr::Int8ToString(s_Rand(0, 1) ? num : -num));
+    }
+    m_Numbers.push_back(NStr::Int8ToString(kMax_I8));
+    m_Numbers.push_back(NStr::Int8ToString(kMin_I8));
+    m_Numbers.push_back("+00000000000000000000012345678901234567");
+}
+
+
+void CTestNStrSpeedApp::x_Report(const char* name,
+                                 double ref_time, double time)
+{
+    NcbiCout << setw(16) << left << name
+             << " scalar: " << setw(10) << ref_time
+             << " NStr: " << setw(10) << time
+             << " x" << (time > 0 ? ref_time/time : 0) << NcbiEndl;
+}
+
+
+void CTestNStrSpeedApp::x_TestSplit(void)
+{
+    vector<CTempString> ref, res;
+    size_t ref_count = 0, count = 0;
+    CStopWatch sw(CStopWatch::eStart);
+    for (int pass = 0;  pass < m_Count;  ++pass) {
+        ITERATE(vector<string>, it, m_GffLines) {
+            s_RefSplit(*it, '\t', ref);
+            ref_count += ref.size();
+        }
+    }
+    double ref_time = sw.Restart();
+    for (int pass = 0;  pass < m_Count;  ++pass) {
+        ITERATE(vector<string>, it, m_GffLines) {
+            res.clear();
+            NStr::Split(*it, "\t", res);
+            count += res.size();
+        }
+    }
+    x_Report("Split", ref_time, sw.Elapsed());
+    assert(ref_count == count);
+
+    ITERATE(vector<string>, it, m_GffLines) {
+        s_RefSplit(*it, '\t', ref);
+        res.clear();
+        NStr::Split(*it, "\t", res);
+        assert(ref == res);
+        // Multiple delimiters
+        vector<CTempString> attrs;
+        NStr::Split(res.back(), ";=,", attrs);
+        assert(attrs.size() == 14);
+        assert(attrs[0] == "ID"  &&  attrs[11] == "product");
+        // Merged delimiters
+        attrs.clear();
+        NStr::Split(*it, " \t", attrs, NStr::fSplit_Tokenize);
+        assert(attrs.size() == 17);
+        ITERATE(vector<CTempString>, a, attrs) {
+            assert( !a->empty() );
+        }
+    }
+}
+
+
+void CTestNStrSpeedApp::x_TestCompareNocase(void)
+{
+    // The same lines in upper case, and with a non-ASCII character
+    // at different positions.
+    vector<string> upper, other;
+    ITERATE(vector<string>, it, m_GffLines) {
+        upper.push_back(*it);
+        NStr::ToUpper(upper.back());
+        other.push_back(upper.back());
+        other.back()[other.back().size()*upper.size()/(m_GffLines.size()+1)]
+            = '\x80';
+    }
+    int ref_sum = 0, sum = 0;
+    CStopWatch sw(CStopWatch::eStart);
+    for (int pass = 0;  pass < m_Count;  ++pass) {
+        for (size_t i = 0;  i < m_GffLines.size();  ++i) {
+            ref_sum += s_RefCompareNocase(m_GffLines[i], upper[i]) == 0;
+            ref_sum += s_RefCompareNocase(m_GffLines[i], other[i]) < 0;
+        }
+    }
+    double ref_time = sw.Restart();
+    for (int pass = 0;  pass < m_Count;  ++pass) {
+        for (size_t i = 0;  i < m_GffLines.size();  ++i) {
+            sum += NStr::CompareNocase(m_GffLines[i], upper[i]) == 0;
+            sum += NStr::CompareNocase(m_GffLines[i], other[i]) < 0;
+        }
+    }
+    x_Report("CompareNocase", ref_time, sw.Elapsed());
+    assert(ref_sum == sum);
+
+    for (size_t i = 0;  i < m_GffLines.size();  ++i) {
+        int ref = s_RefCompareNocase(m_GffLines[i], other[i]);
+        int res = NStr::CompareNocase(m_GffLines[i], other[i]);
+        assert((ref < 0) == (res < 0)  &&  (ref > 0) == (res > 0));
+        ref = s_RefCompareNocase(other[i], m_GffLines[i]);
+        res = NStr::CompareNocase(other[i], m_GffLines[i]);
+        assert((ref < 0) == (res < 0)  &&  (ref > 0) == (res > 0));
+        // Prefix of a different length
+        CTempString prefix(m_GffLines[i], 0, i % m_GffLines[i].size());
+        assert(NStr::CompareNocase(upper[i], 0, prefix.size(), prefix) == 0);
+        assert(NStr::CompareNocase(upper[i], prefix) > 0);
+        assert(NStr::CompareNocase(prefix, upper[i]) < 0);
+    }
+    // Non-letters next to the letter ranges must not be folded
+    assert(NStr::CompareNocase("@[`{@[`{@[`{@[`{@[`{",
+                               "@[`{@[`{@[`{@[`{@[`{") == 0);
+    assert(NStr::CompareNocase("@@@@@@@@@@@@@@@@@@@@",
+                               "````````````````````") != 0);
+    assert(NStr::CompareNocase("[[[[[[[[[[[[[[[[[[[[",
+                               "{{{{{{{{{{{{{{{{{{{{") != 0);
+}
+
+
+void CTestNStrSpeedApp::x_TestFindNocase(void)
+{
+    static const char* const kPatterns[] = {
+        "PRODUCT=", "hgnc:hgnc", "Transcript Variant X1", "not-there"
+    };
+    SIZE_TYPE ref_sum = 0, sum = 0;
+    CStopWatch sw(CStopWatch::eStart);
+    for (int pass = 0;  pass < m_Count;  ++pass) {
+        ITERATE(vector<string>, it, m_GffLines) {
+            for (size_t i = 0;  i < ArraySize(kPatterns);  ++i) {
+                ref_sum += s_RefFindNocase(*it, kPatterns[i]);
+            }
+        }
+    }
+    double ref_time = sw.Restart();
+    for (int pass = 0;  pass < m_Count;  ++pass) {
+        ITERATE(vector<string>, it, m_GffLines) {
+            for (size_t i = 0;  i < ArraySize(kPatterns);  ++i) {
+                sum += NStr::FindNoCase(*it, kPatterns[i]);
+            }
+        }
+    }
+    x_Report("FindNoCase", ref_time, sw.Elapsed());
+    assert(ref_sum == sum);
+
+    ITERATE(vector<string>, it, m_GffLines) {
+        for (size_t i = 0;  i < ArraySize(kPatterns);  ++i) {
+            assert(s_RefFindNocase(*it, kPatterns[i]) ==
+                   NStr::FindNoCase(*it, kPatterns[i]));
+        }
+        assert(NStr::Find(*it, "RefSeq") == it->find("RefSeq"));
+        assert(NStr::Find(*it, "gene=") == it->find("gene="));
+    }
+}
+
+
+void CTestNStrSpeedApp::x_TestStringToInt(void)
+{
+    Int8 ref_sum = 0, sum = 0;
+    CStopWatch sw(CStopWatch::eStart);
+    for (int pass = 0;  pass < m_Count;  ++pass) {
+        ITERATE(vector<string>, it, m_Numbers) {
+            ref_sum ^= s_RefStringToInt8(*it);
+        }
+    }
+    double ref_time = sw.Restart();
+    for (int pass = 0;  pass < m_Count;  ++pass) {
+        ITERATE(vector<string>, it, m_Numbers) {
+            sum ^= NStr::StringToInt8(*it);
+        }
+    }
+    x_Report("StringToInt8", ref_time, sw.Elapsed());
+    assert(ref_sum == sum);
+
+    ITERATE(vector<string>, it, m_Numbers) {
+        assert(s_RefStringToInt8(*it) == NStr::StringToInt8(*it));
+    }
+    static const char* const kBad[] = {
+        "", "-", "+", "12345678a", "1234567a90", "-1234567890123456789012",
+        "9223372036854775808", "-9223372036854775809", "123456789 "
+    };
+    for (size_t i = 0;  i < ArraySize(kBad);  ++i) {
+        Int8 res = NStr::StringToInt8(kBad[i], NStr::fConvErr_NoThrow);
+        assert(res == 0  &&  errno != 0);
+    }
+    assert(NStr::StringToInt8("-9223372036854775808") == kMin_I8);
+    assert(NStr::StringToUInt8("18446744073709551615") == kMax_UI8);
+    assert(NStr::StringToUInt8("18446744073709551616",
+                               NStr::fConvErr_NoThrow) == 0);
+    assert(NStr::StringToUInt8("00000000000000000000000000000042") == 42);
+    assert(NStr::StringToInt("-2147483648") == kMin_Int);
+}
+
+
+int CTestNStrSpeedApp::Run(void)
+{
+    m_Count = GetArgs()["count"].AsInteger();
+    x_MakeData();
+
+    NcbiCout << setprecision(3);
+    x_TestSplit();
+    x_TestCompareNocase();
+    x_TestFindNocase();
+    x_TestStringToInt();
+
+    NcbiCout << "Test completed successfully!" << NcbiEndl;
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestNStrSpeedApp().AppMain(argc, argv);
+}
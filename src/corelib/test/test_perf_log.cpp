@@ -0,0 +1,176 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ * File Description:
+ *   Test for aggregated and sampled performance logging
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/perf_log.hpp>
+#include <math.h>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+class CPerfLogTestApp : public CNcbiApplication
+{
+public:
+    void Init(void);
+    int  Run(void);
+};
+
+
+void CPerfLogTestApp::Init(void)
+{
+    // Make sure no automatic report is printed while the test is running,
+    // print one of every 100 raw records.
+    CNcbiEnvironment& env = SetEnvironment();
+    env.Set("LOG_PERFLOGGING_INTERVAL", "3600");
+    env.Set("LOG_PERFLOGGING_SAMPLE", "100");
+}
+
+
+// Get value of the named argument as a double.
+static double s_GetArg(const SDiagMessage& msg, const string& name)
+{
+    ITERATE(SDiagMessage::TExtraArgs, it, msg.m_ExtraArgs) {
+        if (it->first == name) {
+            return NStr::StringToDouble(it->second);
+        }
+    }
+    _TROUBLE;
+    return 0;
+}
+
+
+// Check that the value is within the precision of the histogram.
+static bool s_IsClose(double value, double expected)
+{
+    return fabs(value - expected) <= expected*0.07;
+}
+
+
+int CPerfLogTestApp::Run(void)
+{
+    CPerfLogger::SetON();
+    CPerfLogger::SetAggregating();
+
+    CNcbiOstrstream str;
+    GetDiagContext().SetOldPostFormat(false);
+    SetDiagStream(&str);
+
+    // 1000 records with times 1ms..1s, 10 errors with time 2s,
+    // 10 records from a guard.
+    for (int i = 1; i <= 1000; ++i) {
+        CPerfLogger perf_logger(CPerfLogger::eSuspend);
+        perf_logger.Adjust(CTimeSpan(i/1000.0));
+        PERF_POST(perf_logger, e200_Ok, "test_resource",
+                  .Print("iteration", i));
+    }
+    for (int i = 0; i < 10; ++i) {
+        CPerfLogger perf_logger(CPerfLogger::eSuspend);
+        perf_logger.Adjust(CTimeSpan(2, 0));
+        perf_logger.Post(CRequestStatus::e500_InternalServerError,
+                         "test_resource");
+    }
+    for (int i = 0; i < 10; ++i) {
+        CPerfLogGuard guard("guard_resource");
+        guard.AddParameter("iteration", NStr::IntToString(i));
+        guard.Post(CRequestStatus::e200_Ok);
+    }
+    CPerfLogger::ReportAggregated();
+    SetDiagStream(&NcbiCerr);
+
+    string output = CNcbiOstrstreamToString(str);
+    vector<string> lines;
+    NStr::Split(output, "\n", lines, NStr::fSplit_Tokenize);
+
+    size_t raw = 0;
+    size_t aggregated = 0;
+    ITERATE(vector<string>, it, lines) {
+        bool parsed = false;
+        SDiagMessage msg(*it, &parsed);
+        assert(parsed);
+        // Sampled out records must not produce any output.
+        assert(msg.m_Event == SDiagMessage::eEvent_PerfLog);
+        bool is_aggregated = false;
+        ITERATE(SDiagMessage::TExtraArgs, arg, msg.m_ExtraArgs) {
+            if (arg->first == "count") is_aggregated = true;
+        }
+        if ( !is_aggregated ) {
+            ++raw;
+            continue;
+        }
+        ++aggregated;
+        string status = NStr::GetField(
+            CTempString(msg.m_Buffer, msg.m_BufferLen), 0, ' ');
+        if (NStr::Find(*it, "resource=guard_resource") != NPOS) {
+            assert(s_GetArg(msg, "count") == 10);
+        }
+        else if (status == "200") {
+            assert(s_GetArg(msg, "count") == 1000);
+            assert(s_IsClose(s_GetArg(msg, "min"), 0.001));
+            assert(s_IsClose(s_GetArg(msg, "p50"), 0.5));
+            assert(s_IsClose(s_GetArg(msg, "p99"), 0.99));
+            assert(s_IsClose(s_GetArg(msg, "p999"), 0.999));
+            assert(s_IsClose(s_GetArg(msg, "max"), 1.0));
+        }
+        else {
+            assert(status == "500");
+            assert(s_GetArg(msg, "count") == 10);
+            assert(s_IsClose(s_GetArg(msg, "p50"), 2.0));
+        }
+    }
+    // One of every 100 raw records (1020 total).
+    assert(raw == 11);
+    assert(aggregated == 3);
+
+    // Flushing stops the report thread and prints the remaining timings.
+    CNcbiOstrstream flush_str;
+    SetDiagStream(&flush_str);
+    for (int i = 0; i < 5; ++i) {
+        CPerfLogger perf_logger(CPerfLogger::eSuspend);
+        perf_logger.Post(CRequestStatus::e200_Ok, "flush_resource");
+    }
+    CPerfLogger::FlushAggregated();
+    SetDiagStream(&NcbiCerr);
+    output = CNcbiOstrstreamToString(flush_str);
+    assert(NStr::Find(output, "resource=flush_resource&count=5") != NPOS);
+
+    NcbiCout << "Test completed successfully!" << NcbiEndl;
+    return 0;
+}
+
+
+int main(int argc, const char* argv[])
+{
+    return CPerfLogTestApp().AppMain(argc, argv);
+}
@@ -0,0 +1,310 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author:  agent
+ *
+ * File Description:
+ *   Test for CRegistrySnapshot - compiled memory-mapped registry.
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbireg.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbi_param.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/ncbiexec.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CTestRegSnapshotApp : public CNcbiApplication
+{
+public:
+    CTestRegSnapshotApp(void) : m_LoadConfigCalls(0) {}
+
+    void Init(void);
+    int  Run(void);
+
+    using CNcbiApplication::LoadConfig;
+    virtual bool LoadConfig(CNcbiRegistry& reg, const string* conf);
+
+private:
+    void x_WriteIni(const string& path, int count, const string& extra);
+    void x_CheckSnapshot(const CRegistrySnapshot& snapshot,
+                         const IRegistry&         reg);
+    void x_Benchmark(int count);
+    void x_TestApplication(const string& ini_path);
+    int  x_RunChild(const string& mode);
+
+    int    m_LoadConfigCalls;
+    string m_ChildConf;
+};
+
+
+void CTestRegSnapshotApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext("test_reg_snapshot",
+                       "CRegistrySnapshot test");
+    d->AddDefaultKey("entries", "Entries", "Number of entries per section",
+                     CArgDescriptions::eInteger, "100");
+    d->AddDefaultKey("lookups", "Lookups",
+                     "Number of lookups to benchmark, 0 to skip benchmark",
+                     CArgDescriptions::eInteger, "0");
+    d->AddOptionalKey("child", "Mode",
+                      "Check configuration loaded by the application "
+                      "(used internally by the test)",
+                      CArgDescriptions::eString);
+    d->SetConstraint("child",
+                     &(*new CArgAllow_Strings, "compile", "load", "transient"));
+    SetupArgDescriptions(d.release());
+}
+
+
+bool CTestRegSnapshotApp::LoadConfig(CNcbiRegistry& reg, const string* conf)
+{
+    ++m_LoadConfigCalls;
+    // Arguments are not parsed yet.
+    const CNcbiArguments& args = GetArguments();
+    for (SIZE_TYPE i = 1;  i + 1 < args.Size();  ++i) {
+        if (args[i] == "-child"  &&  args[i + 1] == "transient") {
+            // Transient entries prevent the use of the snapshot.
+            reg.Set("Transient", "entry", "1", 0);
+        }
+    }
+    return CNcbiApplication::LoadConfig(reg, conf);
+}
+
+
+void CTestRegSnapshotApp::x_WriteIni(const string& path,
+                                     int           count,
+                                     const string& extra)
+{
+    CNcbiOfstream out(path.c_str());
+    for (int s = 0;  s < 10;  ++s) {
+        out << "[Section" << s << "]" << NcbiEndl;
+        for (int i = 0;  i < count;  ++i) {
+            out << "Entry" << i << " = value " << s << "." << i << NcbiEndl;
+        }
+        out << "empty =" << NcbiEndl;
+    }
+    out << extra;
+}
+
+
+void CTestRegSnapshotApp::x_CheckSnapshot(const CRegistrySnapshot& snapshot,
+                                          const IRegistry&         reg)
+{
+    size_t count = 0;
+    list<string> sections;
+    reg.EnumerateSections(&sections);
+    ITERATE(list<string>, sit, sections) {
+        list<string> names;
+        reg.EnumerateEntries(*sit, &names);
+        ITERATE(list<string>, nit, names) {
+            CTempString value;
+            assert(snapshot.Find(*sit, *nit, &value));
+            assert(value == reg.Get(*sit, *nit));
+            // Lookups are case-insensitive.
+            string section = *sit, name = *nit;
+            assert(snapshot.Get(NStr::ToUpper(section), NStr::ToLower(name))
+                   == reg.Get(*sit, *nit));
+            ++count;
+        }
+    }
+    assert(snapshot.GetSize() == count);
+    assert( !snapshot.Find("Section0", "NoSuchEntry", NULL) );
+    assert( !snapshot.Find("NoSuchSection", "Entry0", NULL) );
+    assert( !snapshot.Find("", "", NULL) );
+}
+
+
+void CTestRegSnapshotApp::x_Benchmark(int count)
+{
+    CStopWatch sw(CStopWatch::eStart);
+    for (int i = 0;  i < count;  ++i) {
+        g_GetConfigString("Section5", "Entry7", "", "");
+    }
+    NcbiCout << "  " << (Uint8) (count / max(sw.Elapsed(), 1e-9) / 1000)
+             << " thousand lookups per second" << NcbiEndl;
+}
+
+
+// Run the test application with NCBI_CONFIG_SNAPSHOT set.
+int CTestRegSnapshotApp::x_RunChild(const string& mode)
+{
+    string app = GetArguments().GetProgramName();
+    return CExec::SpawnL(CExec::eWait, app.c_str(),
+                         "-child", mode.c_str(),
+                         "-conffile", m_ChildConf.c_str(), NULL).GetExitCode();
+}
+
+
+// Get file serial number, it's changed when the snapshot is recompiled.
+static Uint8 s_GetFileId(const string& path)
+{
+    CDirEntry::SStat st;
+    assert(CDirEntry(path).Stat(&st));
+    return (Uint8) st.orig.st_ino;
+}
+
+
+void CTestRegSnapshotApp::x_TestApplication(const string& ini_path)
+{
+    string snap_path = CFile::GetTmpName();
+    m_ChildConf = ini_path;
+    SetEnvironment().Set("NCBI_CONFIG_SNAPSHOT", snap_path);
+
+    // The first run compiles the snapshot, the next ones load it.
+    assert(x_RunChild("compile") == 0);
+    assert(CFile(snap_path).Exists());
+    Uint8 id = s_GetFileId(snap_path);
+    assert(x_RunChild("load") == 0);
+    assert(s_GetFileId(snap_path) == id);
+    assert(x_RunChild("transient") == 0);
+    assert(s_GetFileId(snap_path) == id);
+
+    SetEnvironment().Unset("NCBI_CONFIG_SNAPSHOT");
+    CFile(snap_path).Remove();
+}
+
+
+int CTestRegSnapshotApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    int entries = args["entries"].AsInteger();
+    int lookups = args["lookups"].AsInteger();
+
+    if ( args["child"] ) {
+        // Overridden LoadConfig() is called even if the snapshot is used.
+        assert(m_LoadConfigCalls == 1);
+        assert(GetConfig().Get("Section5", "Entry7") == "value 5.7");
+        assert(g_GetConfigString("Section5", "Entry7", "", "")
+               == "value 5.7");
+        if (args["child"].AsString() == "transient") {
+            assert( !CRegistrySnapshot::GetActive() );
+            assert(GetConfig().Get("Transient", "entry") == "1");
+        } else {
+            assert(CRegistrySnapshot::GetActive());
+        }
+        return 0;
+    }
+
+    string ini_path  = CFile::GetTmpName();
+    string snap_path = CFile::GetTmpName();
+    x_WriteIni(ini_path, entries,
+               "[Values]\nspaced = value with  spaces \nquoted = \"a;b\"\n");
+
+    CNcbiRegistry reg;
+    {{
+        CNcbiIfstream in(ini_path.c_str(), IOS_BASE::binary);
+        reg.Read(in);
+    }}
+    CRegistrySnapshot::TSources sources;
+    sources.push_back(ini_path);
+
+    // Compile and map.
+    CRegistrySnapshot::Write(reg, snap_path, sources, "test");
+    CRef<CRegistrySnapshot> snapshot = CRegistrySnapshot::Open(snap_path,
+                                                               "test");
+    assert(snapshot);
+    assert(snapshot->GetSources() == sources);
+    assert( !snapshot->IsStale() );
+    x_CheckSnapshot(*snapshot, reg);
+
+    // Different configuration key.
+    assert( !CRegistrySnapshot::Open(snap_path, "other") );
+
+    // Loading the snapshot reproduces the registry.
+    CNcbiRegistry reg2;
+    reg2.ReadSnapshot(*snapshot);
+    x_CheckSnapshot(*snapshot, reg2);
+    assert(reg2.Get("Values", "spaced") == reg.Get("Values", "spaced"));
+
+    // Lock-free lookups through g_GetConfigXxx().
+    LoadConfig(GetRWConfig(), &ini_path);
+    GetRWConfig().Set("Section5", "Entry7", "from app registry");
+    if ( lookups ) {
+        NcbiCout << "Registry lookup:" << NcbiEndl;
+        x_Benchmark(lookups);
+    }
+    assert(g_GetConfigString("Section5", "Entry7", "", "")
+           == "from app registry");
+
+    CRegistrySnapshot::Activate(*snapshot, GetConfig());
+    assert(CRegistrySnapshot::GetActive() == snapshot.GetPointer());
+    if ( lookups ) {
+        NcbiCout << "Snapshot lookup:" << NcbiEndl;
+        x_Benchmark(lookups);
+    }
+    assert(g_GetConfigString("Section5", "Entry7", "", "") == "value 5.7");
+    assert(g_GetConfigInt("Section3", "Entry4", "", 0) == 0);
+    assert(g_GetConfigString("Section3", "NoSuchEntry", "", "def") == "def");
+
+    // Modifying the registry deactivates the snapshot.
+    GetRWConfig().Set("Section5", "Entry7", "modified");
+    assert( !CRegistrySnapshot::GetActive() );
+    assert(g_GetConfigString("Section5", "Entry7", "", "") == "modified");
+
+    // Any change of the source file makes the snapshot stale.
+    SleepMilliSec(10);
+    x_WriteIni(ini_path, entries, "[New]\nentry = 1\n");
+    assert(snapshot->IsStale());
+    assert( !CRegistrySnapshot::Open(snap_path, "test") );
+
+    // Corrupted snapshot is ignored.
+    {{
+        CNcbiOfstream out(snap_path.c_str(), IOS_BASE::binary);
+        out << "NCBIRGS1 truncated";
+    }}
+    assert( !CRegistrySnapshot::Open(snap_path, "test") );
+    assert( !CRegistrySnapshot::Open(snap_path + ".none", "test") );
+
+    // Application configuration loaded through NCBI_CONFIG_SNAPSHOT.
+    x_TestApplication(ini_path);
+
+    CFile(ini_path).Remove();
+    CFile(snap_path).Remove();
+
+    NcbiCout << "Test completed successfully!" << NcbiEndl;
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CTestRegSnapshotApp().AppMain(argc, argv);
+}
@@ -184,7 +184,8 @@ protected:
         }
     virtual void x_Unindex(const CSeq_id_Info* info) = 0;
 
-    typedef CFastMutex TTreeLock;
+    // The trees are read by all threads and modified relatively rarely
+    typedef CDistributedRWLock TTreeLock;
     typedef TTreeLock::TReadLockGuard TReadLockGuard;
     typedef TTreeLock::TWriteLockGuard TWriteLockGuard;
 
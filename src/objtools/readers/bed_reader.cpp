@@ -36,6 +36,7 @@
 #include <corelib/ncbithr.hpp>
 #include <corelib/ncbiutil.hpp>
 #include <corelib/ncbiexpt.hpp>
+#include <corelib/ncbistr_util.hpp>
 #include <corelib/stream_utils.hpp>
 
 #include <util/static_map.hpp>
@@ -491,46 +492,44 @@ bool CBedReader::xDetermineLikelyColumnCount(
             }
         }
         if (validColumnCount >= 11) {
-            vector<string> blockSizes;
-            auto col10 = columns[10];
+            CTempString col10 = columns[10];
             if (NStr::EndsWith(col10, ",")) {
                 col10 = col10.substr(0, col10.size()-1);
             }
-            NStr::Split(col10, ",", blockSizes, NStr::fSplit_MergeDelimiters);
-            if (blockSizes.size() != blockCount) {
-                validColumnCount = 9;
-            }
-            else {
-                try {
-                    for (auto blockSize: blockSizes) {
-                        NStr::StringToULong(blockSize);
-                    }
+            int blockSizeCount = 0;
+            try {
+                for (CTempString blockSize: CStrTokenView(
+                        col10, ",", NStr::fSplit_MergeDelimiters)) {
+                    NStr::StringToULong(blockSize);
+                    ++blockSizeCount;
                 }
-                catch(CException&) {
+                if (blockSizeCount != blockCount) {
                     validColumnCount = 9;
                 }
             }
+            catch(CException&) {
+                validColumnCount = 9;
+            }
         }
         if (validColumnCount >= 12) {
-            vector<string> blockStarts;
-            auto col11 = columns[11];
+            CTempString col11 = columns[11];
             if (NStr::EndsWith(col11, ",")) {
                 col11 = col11.substr(0, col11.size()-1);
             }
-            NStr::Split(col11, ",", blockStarts, NStr::fSplit_MergeDelimiters);
-            if (blockStarts.size() != blockCount) {
-                validColumnCount = 9;
-            }
-            else {
-                try {
-                    for (auto blockStart: blockStarts) {
-                        NStr::StringToULong(blockStart);
-                    }
+            int blockStartCount = 0;
+            try {
+                for (CTempString blockStart: CStrTokenView(
+                        col11, ",", NStr::fSplit_MergeDelimiters)) {
+                    NStr::StringToULong(blockStart);
+                    ++blockStartCount;
                 }
-                catch(CException&) {
+                if (blockStartCount != blockCount) {
                     validColumnCount = 9;
                 }
             }
+            catch(CException&) {
+                validColumnCount = 9;
+            }
         }   
     } 
     mRealColumnCount = realColumnCount;
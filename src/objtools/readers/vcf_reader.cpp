@@ -36,6 +36,7 @@
 #include <corelib/ncbithr.hpp>
 #include <corelib/ncbiutil.hpp>
 #include <corelib/ncbiexpt.hpp>
+#include <corelib/ncbistr_util.hpp>
 #include <corelib/stream_utils.hpp>
 
 #include <util/static_map.hpp>
@@ -862,10 +863,9 @@ CVcfReader::xParseData(
         }
         data.m_strFilter = columns[6];
 
-        vector<string> infos;
         if ( columns[7] != "." ) {
-            NStr::Split( columns[7], ";", infos, NStr::fSplit_MergeDelimiters | NStr::fSplit_Truncate );
-            for ( vector<string>::iterator it = infos.begin(); 
+            CStrTokenView infos( columns[7], ";", NStr::fSplit_MergeDelimiters | NStr::fSplit_Truncate );
+            for ( CStrTokenView::const_iterator it = infos.begin(); 
                 it != infos.end(); ++it ) 
             {
                 string key, value;
@@ -37,6 +37,8 @@
 #include <serial/impl/classinfo.hpp>
 #include <serial/objistr.hpp>
 #include <serial/objostr.hpp>
+#include <serial/objistrasnb.hpp>
+#include <serial/objostrasnb.hpp>
 #include <serial/objcopy.hpp>
 #include <serial/delaybuf.hpp>
 #include <serial/impl/stdtypes.hpp>
@@ -84,6 +86,8 @@ void CClassTypeInfo::InitClassTypeInfo(void)
 {
     m_ClassType = eSequential;
     m_ParentClassInfo = 0;
+    m_AsnBinaryReadFunction = 0;
+    m_AsnBinaryWriteFunction = 0;
 
     UpdateFunctions();
 }
@@ -109,6 +113,16 @@ CClassTypeInfo* CClassTypeInfo::SetImplicit(void)
     return this;
 }
 
+CClassTypeInfo*
+CClassTypeInfo::SetAsnBinaryFunctions(TAsnBinaryReadFunction readFunc,
+                                      TAsnBinaryWriteFunction writeFunc)
+{
+    m_AsnBinaryReadFunction = readFunc;
+    m_AsnBinaryWriteFunction = writeFunc;
+    UpdateFunctions();
+    return this;
+}
+
 bool CClassTypeInfo::IsImplicitNonEmpty(void) const
 {
     _ASSERT(Implicit());
@@ -246,8 +260,10 @@ void CClassTypeInfo::UpdateFunctions(void)
 {
     switch ( m_ClassType ) {
     case eSequential:
-        SetReadFunction(&ReadClassSequential);
-        SetWriteFunction(&WriteClassSequential);
+        SetReadFunction(m_AsnBinaryReadFunction ?
+                        &ReadClassSequentialGenerated : &ReadClassSequential);
+        SetWriteFunction(m_AsnBinaryWriteFunction ?
+                         &WriteClassSequentialGenerated : &WriteClassSequential);
         SetCopyFunction(&CopyClassSequential);
         SetSkipFunction(&SkipClassSequential);
         break;
@@ -276,6 +292,22 @@ void CClassTypeInfo::ReadClassSequential(CObjectIStream& in,
     in.ReadClassSequential(classType, objectPtr);
 }
 
+void CClassTypeInfo::ReadClassSequentialGenerated(CObjectIStream& in,
+                                                  TTypeInfo objectType,
+                                                  TObjectPtr objectPtr)
+{
+    const CClassTypeInfo* classType =
+        CTypeConverter<CClassTypeInfo>::SafeCast(objectType);
+
+    if ( in.GetDataFormat() == eSerial_AsnBinary ) {
+        static_cast<CObjectIStreamAsnBinary&>(in)
+            .ReadGeneratedClass(classType, objectPtr);
+    }
+    else {
+        in.ReadClassSequential(classType, objectPtr);
+    }
+}
+
 void CClassTypeInfo::ReadClassRandom(CObjectIStream& in,
                                      TTypeInfo objectType,
                                      TObjectPtr objectPtr)
@@ -333,6 +365,22 @@ void CClassTypeInfo::WriteClassSequential(CObjectOStream& out,
     out.WriteClassSequential(classType, objectPtr);
 }
 
+void CClassTypeInfo::WriteClassSequentialGenerated(CObjectOStream& out,
+                                                   TTypeInfo objectType,
+                                                   TConstObjectPtr objectPtr)
+{
+    const CClassTypeInfo* classType =
+        CTypeConverter<CClassTypeInfo>::SafeCast(objectType);
+
+    if ( out.GetDataFormat() == eSerial_AsnBinary ) {
+        static_cast<CObjectOStreamAsnBinary&>(out)
+            .WriteGeneratedClass(classType, objectPtr);
+    }
+    else {
+        out.WriteClassSequential(classType, objectPtr);
+    }
+}
+
 void CClassTypeInfo::WriteImplicitMember(CObjectOStream& out,
                                          TTypeInfo objectType,
                                          TConstObjectPtr objectPtr)
@@ -30,11 +30,13 @@
 */
 
 #include <ncbi_pch.hpp>
+#include "datatool.hpp"
 #include "exceptions.hpp"
 #include "blocktype.hpp"
 #include "unitype.hpp"
 #include "reftype.hpp"
 #include "statictype.hpp"
+#include "enumtype.hpp"
 #include <serial/impl/autoptrinfo.hpp>
 #include "value.hpp"
 #include "classstr.hpp"
@@ -854,6 +856,8 @@ AutoPtr<CTypeStrings> CDataContainerType::AddMembers(
 */
     code->SetHaveUserClass(haveUserClass);
     code->SetObject(true /*isObject*/ );
+    bool lazyMembers = IsASNDataSpec() &&
+        DataTool().IsSetCodeGenerationStyle(CDataTool::eLazyMembers);
     ITERATE ( TMembers, i, GetMembers() ) {
         string defaultCode;
         bool optional = (*i)->Optional();
@@ -863,7 +867,17 @@ AutoPtr<CTypeStrings> CDataContainerType::AddMembers(
             _ASSERT(!defaultCode.empty());
         }
 
-        bool delayed = GetBoolVar((*i)->GetName()+"._delay");
+        // in lazy mode all constructed members are delayed by default,
+        // primitive ones are cheaper to parse than to keep unparsed;
+        // implicitly tagged values cannot be stored with their own tag
+        bool lazy = false;
+        if ( lazyMembers &&
+             (*i)->GetType()->GetTagType() != CAsnBinaryDefs::eImplicit ) {
+            const CDataType* resolved = (*i)->GetType()->Resolve();
+            lazy = dynamic_cast<const CStaticDataType*>(resolved) == 0 &&
+                   dynamic_cast<const CEnumDataType*>(resolved) == 0;
+        }
+        bool delayed = GetBoolVar((*i)->GetName()+"._delay", lazy);
         AutoPtr<CTypeStrings> memberType = (*i)->GetType()->GetFullCType();
         string external_name = (*i)->GetName();
         string member_name = (*i)->GetType()->DefClassMemberName();
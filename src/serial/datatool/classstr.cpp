@@ -359,6 +359,27 @@ void CClassTypeStrings::GenerateClassCode(CClassCode& code,
         generateDoNotDeleteThisObject = false;
     if ( delayed )
         code.HPPIncludes().insert("serial/delaybuf");
+    // check if binary ASN.1 codecs can be generated
+    bool asnbCodecs =
+        DataTool().IsSetCodeGenerationStyle(CDataTool::eAsnBinaryCodecs) &&
+        CDataType::IsASNDataSpec() && !m_Members.empty() &&
+        !wrapperClass && !isSet && m_ParentClassName.empty();
+    if ( asnbCodecs ) {
+        ITERATE ( TMembers, i, m_Members ) {
+            if ( i->attlist || i->noTag || x_IsAnyContentType(i) ||
+                 (i->memberTag >= 0 && i->dataType &&
+                  (i->dataType->GetTagClass() != CAsnBinaryDefs::eContextSpecific ||
+                   i->dataType->GetTagType() == CAsnBinaryDefs::eImplicit)) ) {
+                asnbCodecs = false;
+                break;
+            }
+        }
+    }
+    if ( asnbCodecs ) {
+        code.CPPIncludes().insert("serial/objistrasnb");
+        code.CPPIncludes().insert("serial/objostrasnb");
+        code.CPPIncludes().insert("serial/impl/member");
+    }
 
     // generate member types
     {
@@ -1273,6 +1294,15 @@ mem_simple = false;
                 }
             }
         }
+        if ( asnbCodecs ) {
+            code.ClassPrivate() <<
+                "\n"
+                "    // binary ASN.1 codecs\n"
+                "    static void x_ReadAsnBinary("<<ncbiNamespace<<"CObjectIStreamAsnBinary& in, "
+                "const "<<ncbiNamespace<<"CClassTypeInfo* type, "<<ncbiNamespace<<"TObjectPtr ptr);\n"
+                "    static void x_WriteAsnBinary("<<ncbiNamespace<<"CObjectOStreamAsnBinary& out, "
+                "const "<<ncbiNamespace<<"CClassTypeInfo* type, "<<ncbiNamespace<<"TConstObjectPtr ptr);\n";
+        }
     }
 
     // generate member initializers
@@ -1355,6 +1385,73 @@ mem_simple = false;
         }
     }
 
+    // generate binary ASN.1 codecs
+    if ( asnbCodecs ) {
+        // members which can be accessed directly
+        vector<bool> direct;
+        bool haveDirect = false;
+        ITERATE ( TMembers, i, m_Members ) {
+            bool d = !i->ref && !i->delayed && !x_IsNullType(i) &&
+                (i->type->GetKind() == eKindStd ||
+                 i->type->GetKind() == eKindString) &&
+                !i->type->HaveSpecialRef();
+            direct.push_back(d);
+            haveDirect = haveDirect || d;
+        }
+        string objType = classPrefix + GetClassNameDT();
+        const string& codeClassName = code.GetClassNameDT();
+        methods <<
+            "void "<<methodPrefix<<"x_ReadAsnBinary("<<ncbiNamespace<<"CObjectIStreamAsnBinary& in, "
+            "const "<<ncbiNamespace<<"CClassTypeInfo* type, "<<ncbiNamespace<<"TObjectPtr ptr)\n"
+            "{\n";
+        if ( haveDirect ) {
+            methods <<
+                "    "<<codeClassName<<"& obj = *static_cast<"<<objType<<"*>(ptr);\n";
+        }
+        methods <<
+            "    const "<<ncbiNamespace<<"CMemberInfo* info;\n";
+        size_t index = 0;
+        ITERATE ( TMembers, i, m_Members ) {
+            methods <<
+                "    if ( (info = in.BeginGeneratedMember(type, "<<index+1<<")) != 0 ) {\n"
+                "        in.ReadGeneratedMember(info, ptr";
+            if ( direct[index] ) {
+                methods << ", obj."<<i->mName;
+            }
+            methods << ");\n"
+                "        in.EndGeneratedMember();\n"
+                "    }\n"
+                "    else {\n"
+                "        type->GetMemberInfo("<<index+1<<")->ReadMissingMember(in, ptr);\n"
+                "    }\n";
+            ++index;
+        }
+        methods <<
+            "    in.EndGeneratedMembers(type);\n"
+            "}\n"
+            "\n"
+            "void "<<methodPrefix<<"x_WriteAsnBinary("<<ncbiNamespace<<"CObjectOStreamAsnBinary& out, "
+            "const "<<ncbiNamespace<<"CClassTypeInfo* type, "<<ncbiNamespace<<"TConstObjectPtr ptr)\n"
+            "{\n";
+        if ( haveDirect ) {
+            methods <<
+                "    const "<<codeClassName<<"& obj = *static_cast<const "<<objType<<"*>(ptr);\n";
+        }
+        index = 0;
+        ITERATE ( TMembers, i, m_Members ) {
+            methods <<
+                "    out.WriteGeneratedMember(type->GetMemberInfo("<<index+1<<"), ptr";
+            if ( direct[index] ) {
+                methods << ", obj."<<i->mName;
+            }
+            methods << ");\n";
+            ++index;
+        }
+        methods <<
+            "}\n"
+            "\n";
+    }
+
     // generate type info
     methods << "BEGIN_NAMED_";
     if ( haveUserClass )
@@ -1623,6 +1720,9 @@ mem_simple = false;
             // Just query the flag to avoid warnings.
             methods << "    info->RandomOrder();\n";
         }
+        if ( asnbCodecs ) {
+            methods << "    info->SetAsnBinaryFunctions(&x_ReadAsnBinary, &x_WriteAsnBinary);\n";
+        }
     }
     methods <<  "    info->CodeVersion(" << DATATOOL_VERSION << ");\n";
     methods <<  "    info->DataSpec(" << CDataType::GetSourceDataSpecString() << ");\n";
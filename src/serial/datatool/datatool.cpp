@@ -281,6 +281,10 @@ bool CDataTool::ProcessModules(void)
                 m_codestyle |= FCodeGenerationStyle(eXmlElementEnums);
             } else if (NStr::CompareNocase(v,"no_restrictions")==0) {
                 m_codestyle |= FCodeGenerationStyle(eNoRestrictions);
+            } else if (NStr::CompareNocase(v,"asnb_codecs")==0) {
+                m_codestyle |= FCodeGenerationStyle(eAsnBinaryCodecs);
+            } else if (NStr::CompareNocase(v,"lazy_members")==0) {
+                m_codestyle |= FCodeGenerationStyle(eLazyMembers);
             } else {
                 ERR_POST_X(1, Warning << "Unknown code generation value: " << v);
             }
@@ -50,17 +50,25 @@ void CDelayBuffer::SetData(const CItemInfo* itemInfo, TObjectPtr object,
 {
     _ASSERT(!Delayed());
 
+    CFastMutexGuard guard(m_Mutex);
     m_Info.reset(new SInfo(itemInfo, object, dataFormat, flags, data));
+    m_Delayed.store(true, memory_order_release);
 }
 
 void CDelayBuffer::Forget(void)
 {
+    CFastMutexGuard guard(m_Mutex);
+    m_Delayed.store(false, memory_order_release);
     m_Info.reset(0);
 }
 
 void CDelayBuffer::DoUpdate(void)
 {
-    _ASSERT(m_Info.get() != 0);
+    CFastMutexGuard guard(m_Mutex);
+    if ( !m_Info.get() ) {
+        // parsed by another thread
+        return;
+    }
     SInfo& info = *m_Info;
 
     {
@@ -72,6 +80,7 @@ void CDelayBuffer::DoUpdate(void)
     }
 
     m_Info.reset(0);
+    m_Delayed.store(false, memory_order_release);
 }
 
 TMemberIndex CDelayBuffer::GetIndex(void) const
@@ -872,7 +872,7 @@ void CMemberInfoFunctions::ReadLongMember(CObjectIStream& in,
             if (!in.ShouldParseDelayBuffer()) {
                 memberInfo->UpdateSetFlagYes(classPtr);
                 in.StartDelayBuffer();
-                memberInfo->GetTypeInfo()->SkipData(in);
+                in.SkipDelayedObject(memberInfo->GetTypeInfo());
                 in.EndDelayBuffer(buffer, memberInfo, classPtr);
                 return;
             }
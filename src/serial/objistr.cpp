@@ -917,6 +917,7 @@ set<TTypeInfo> CObjectIStream::GuessDataType(set<TTypeInfo>& known_types,
 
 void CObjectIStream::Read(const CObjectInfo& object, ENoFileHeader)
 {
+    CObjectMemoryPoolGuard pool_guard(GetMemoryPool());
     // root object
     BEGIN_OBJECT_FRAME2(eFrameNamed, object.GetTypeInfo());
     
@@ -936,6 +937,7 @@ void CObjectIStream::Read(const CObjectInfo& object)
 
 void CObjectIStream::Read(TObjectPtr object, TTypeInfo typeInfo, ENoFileHeader)
 {
+    CObjectMemoryPoolGuard pool_guard(GetMemoryPool());
     // root object
     BEGIN_OBJECT_FRAME2(eFrameNamed, typeInfo);
 
@@ -1007,6 +1009,11 @@ void CObjectIStream::EndDelayBuffer(CDelayBuffer& buffer,
     buffer.SetData(itemInfo, objectPtr, GetDataFormat(), GetFlags(), *src);
 }
 
+void CObjectIStream::SkipDelayedObject(TTypeInfo type)
+{
+    type->SkipData(*this);
+}
+
 bool CObjectIStream::ExpectedMember(const CMemberInfo* memberInfo)
 {
     const CItemInfo* info = CItemsInfo::FindNextMandatory(memberInfo);
@@ -1054,6 +1061,7 @@ CObjectInfo CObjectIStream::ReadObject(void)
 {
     TTypeInfo typeInfo = MapType(ReadFileHeader());
     TObjectPtr objectPtr = 0;
+    CObjectMemoryPoolGuard pool_guard(GetMemoryPool());
     BEGIN_OBJECT_FRAME2(eFrameNamed, typeInfo);
 
     CRef<CObject> ref;
@@ -63,10 +63,21 @@ CObjectIStream* CObjectIStream::CreateObjectIStreamAsnBinary(void)
     return new CObjectIStreamAsnBinary();
 }
 
+NCBI_PARAM_DECL(bool, SERIAL, USE_GENERATED_ASNB);
+NCBI_PARAM_DEF_EX(bool, SERIAL, USE_GENERATED_ASNB, true,
+                  eParam_NoThread, SERIAL_USE_GENERATED_ASNB);
+
+static bool s_UseGeneratedCode(void)
+{
+    static CSafeStatic<NCBI_PARAM_TYPE(SERIAL, USE_GENERATED_ASNB)> s_Use;
+    return s_Use->Get();
+}
+
 
 CObjectIStreamAsnBinary::CObjectIStreamAsnBinary(EFixNonPrint how)
     : CObjectIStream(eSerial_AsnBinary)
 {
+    SetUseGeneratedCode(s_UseGeneratedCode());
     FixNonPrint(how);
     ResetThisState();
 }
@@ -75,6 +86,7 @@ CObjectIStreamAsnBinary::CObjectIStreamAsnBinary(CNcbiIstream& in,
                                                  EFixNonPrint how)
     : CObjectIStream(eSerial_AsnBinary)
 {
+    SetUseGeneratedCode(s_UseGeneratedCode());
     FixNonPrint(how);
     ResetThisState();
     Open(in);
@@ -85,6 +97,7 @@ CObjectIStreamAsnBinary::CObjectIStreamAsnBinary(CNcbiIstream& in,
                                                  EFixNonPrint how)
     : CObjectIStream(eSerial_AsnBinary)
 {
+    SetUseGeneratedCode(s_UseGeneratedCode());
     FixNonPrint(how);
     ResetThisState();
     Open(in, deleteIn ? eTakeOwnership : eNoOwnership);
@@ -95,6 +108,7 @@ CObjectIStreamAsnBinary::CObjectIStreamAsnBinary(CNcbiIstream& in,
                                                  EFixNonPrint how)
     : CObjectIStream(eSerial_AsnBinary)
 {
+    SetUseGeneratedCode(s_UseGeneratedCode());
     FixNonPrint(how);
     ResetThisState();
     Open(in, deleteIn);
@@ -104,6 +118,7 @@ CObjectIStreamAsnBinary::CObjectIStreamAsnBinary(CByteSourceReader& reader,
                                                  EFixNonPrint how)
     : CObjectIStream(eSerial_AsnBinary)
 {
+    SetUseGeneratedCode(s_UseGeneratedCode());
     FixNonPrint(how);
     ResetThisState();
     Open(reader);
@@ -114,6 +129,7 @@ CObjectIStreamAsnBinary::CObjectIStreamAsnBinary(const char* buffer,
                                                  EFixNonPrint how)
     : CObjectIStream(eSerial_AsnBinary)
 {
+    SetUseGeneratedCode(s_UseGeneratedCode());
     FixNonPrint(how);
     ResetThisState();
     OpenFromBuffer(buffer, size);
@@ -1170,6 +1186,178 @@ void CObjectIStreamAsnBinary::EndClassMember(void)
     }
 }
 
+void CObjectIStreamAsnBinary::ReadGeneratedClass(const CClassTypeInfo* classType,
+                                                 TObjectPtr classPtr)
+{
+    CClassTypeInfo::TAsnBinaryReadFunction func =
+        classType->GetAsnBinaryReadFunction();
+#if USE_OLD_TAGS
+    func = 0;
+#endif
+    // generated readers expect members in the order of declaration,
+    // other cases are left to the generic code
+    if ( !func  ||  (GetFlags() & fFlagNoGeneratedCode)  ||
+         classType->GetTagType() != eAutomatic  ||
+         CanSkipUnknownMembers() ) {
+        ReadClassSequential(classType, classPtr);
+        return;
+    }
+    BEGIN_OBJECT_FRAME3(eFrameClass, classType, classPtr);
+    CObjectIStreamAsnBinary::BeginClass(classType);
+    BEGIN_OBJECT_FRAME(eFrameClassMember);
+
+    func(*this, classType, classPtr);
+
+    END_OBJECT_FRAME();
+    CObjectIStreamAsnBinary::EndClass();
+    END_OBJECT_FRAME();
+}
+
+const CMemberInfo*
+CObjectIStreamAsnBinary::BeginGeneratedMember(const CClassTypeInfo* classType,
+                                              TMemberIndex index)
+{
+#if USE_DEF_LEN
+    if (!HaveMoreElements()) {
+        return 0;
+    }
+    TByte first_tag_byte = PeekTagByte();
+#else
+    TByte first_tag_byte = PeekTagByte();
+    if ( first_tag_byte == eEndOfContentsByte )
+        return 0;
+#endif
+    const CMemberInfo* memberInfo = classType->GetMemberInfo(index);
+    TLongTag tag = PeekTag(first_tag_byte, eContextSpecific, eConstructed);
+    if ( tag != memberInfo->GetId().GetTag() ) {
+        // absent member, the tag will be checked against the next ones
+        UndoPeekTag();
+        return 0;
+    }
+    ExpectIndefiniteLength();
+    SetTopMemberId(memberInfo->GetId());
+    return memberInfo;
+}
+
+void CObjectIStreamAsnBinary::EndGeneratedMember(void)
+{
+    CObjectIStreamAsnBinary::EndClassMember();
+}
+
+void CObjectIStreamAsnBinary::EndGeneratedMembers(const CClassTypeInfo* classType)
+{
+#if USE_DEF_LEN
+    if (!HaveMoreElements()) {
+        return;
+    }
+    TByte first_tag_byte = PeekTagByte();
+#else
+    TByte first_tag_byte = PeekTagByte();
+    if ( first_tag_byte == eEndOfContentsByte )
+        return;
+#endif
+    // unknown, duplicated or misplaced member
+    TLongTag tag = PeekTag(first_tag_byte, eContextSpecific, eConstructed);
+    UnexpectedMember(tag, classType->GetItems());
+}
+
+bool CObjectIStreamAsnBinary::x_BeginGeneratedValue(const CMemberInfo* memberInfo,
+                                                    TObjectPtr classPtr)
+{
+    if ( !memberInfo->HaveSetFlag()  ||  memberInfo->CanBeDelayed()  ||
+         memberInfo->Nillable()  ||  memberInfo->GetId().HaveNoPrefix()  ||
+         memberInfo->HaveReadHooks() ) {
+        memberInfo->ReadMember(*this, classPtr);
+        return false;
+    }
+    memberInfo->UpdateSetFlagYes(classPtr);
+    return true;
+}
+
+void CObjectIStreamAsnBinary::x_EndGeneratedValue(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr)
+{
+    if (GetVerifyData() == eSerialVerifyData_Yes) {
+        memberInfo->Validate(classPtr, *this);
+    }
+}
+
+void CObjectIStreamAsnBinary::ReadGeneratedMember(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr)
+{
+    memberInfo->ReadMember(*this, classPtr);
+}
+
+void CObjectIStreamAsnBinary::ReadGeneratedMember(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr,
+                                                  bool& data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        data = CObjectIStreamAsnBinary::ReadBool();
+        x_EndGeneratedValue(memberInfo, classPtr);
+    }
+}
+
+void CObjectIStreamAsnBinary::ReadGeneratedMember(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr,
+                                                  Int4& data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        data = CObjectIStreamAsnBinary::ReadInt4();
+        x_EndGeneratedValue(memberInfo, classPtr);
+    }
+}
+
+void CObjectIStreamAsnBinary::ReadGeneratedMember(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr,
+                                                  Uint4& data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        data = CObjectIStreamAsnBinary::ReadUint4();
+        x_EndGeneratedValue(memberInfo, classPtr);
+    }
+}
+
+void CObjectIStreamAsnBinary::ReadGeneratedMember(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr,
+                                                  Int8& data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        data = CObjectIStreamAsnBinary::ReadInt8();
+        x_EndGeneratedValue(memberInfo, classPtr);
+    }
+}
+
+void CObjectIStreamAsnBinary::ReadGeneratedMember(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr,
+                                                  Uint8& data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        data = CObjectIStreamAsnBinary::ReadUint8();
+        x_EndGeneratedValue(memberInfo, classPtr);
+    }
+}
+
+void CObjectIStreamAsnBinary::ReadGeneratedMember(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr,
+                                                  double& data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        data = CObjectIStreamAsnBinary::ReadDouble();
+        x_EndGeneratedValue(memberInfo, classPtr);
+    }
+}
+
+void CObjectIStreamAsnBinary::ReadGeneratedMember(const CMemberInfo* memberInfo,
+                                                  TObjectPtr classPtr,
+                                                  string& data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        CObjectIStreamAsnBinary::ReadString(data, eStringTypeVisible);
+        x_EndGeneratedValue(memberInfo, classPtr);
+    }
+}
+
 #ifdef VIRTUAL_MID_LEVEL_IO
 void CObjectIStreamAsnBinary::ReadClassRandom(const CClassTypeInfo* classType,
                                               TObjectPtr classPtr)
@@ -1712,6 +1900,17 @@ void CObjectIStreamAsnBinary::SkipAnyContentObject(void)
     SkipAnyContent();
 }
 
+void CObjectIStreamAsnBinary::SkipDelayedObject(TTypeInfo type)
+{
+    if ( m_SkipNextTag ) {
+        // implicitly tagged value, its tag is already read
+        CObjectIStream::SkipDelayedObject(type);
+        return;
+    }
+    // the value is a single TLV, find its end without decoding it
+    SkipAnyContent();
+}
+
 void CObjectIStreamAsnBinary::SkipAnyContentVariant(void)
 {
     SkipAnyContent();
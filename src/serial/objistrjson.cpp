@@ -36,10 +36,128 @@
 
 #include <serial/objistrjson.hpp>
 
+#if NCBI_SSE >= 20
+#  include <emmintrin.h>
+#endif
+
 #define NCBI_USE_ERRCODE_X   Serial_OStream
 
 BEGIN_NCBI_SCOPE
 
+NCBI_PARAM_DECL(bool, SERIAL, JSON_FAST_SCAN);
+NCBI_PARAM_DEF_EX(bool, SERIAL, JSON_FAST_SCAN, true,
+                  eParam_NoThread, SERIAL_JSON_FAST_SCAN);
+
+static bool s_FastScan(void)
+{
+    static CSafeStatic<NCBI_PARAM_TYPE(SERIAL, JSON_FAST_SCAN)> s_Scan;
+    return s_Scan->Get();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Structural character scan.
+//  The input buffer is searched for the characters which end a run of
+//  plain text: 16 bytes at a time where SSE2 is available (see NCBI_SSE),
+//  the scalar code is used for the buffer tails and on other platforms.
+//
+
+#if NCBI_SSE >= 20
+// Index of the lowest set bit, 'mask' must not be zero
+static inline
+unsigned s_LowestBit(unsigned mask)
+{
+#  if defined(__GNUC__)
+    return (unsigned) __builtin_ctz(mask);
+#  else
+    unsigned n = 0;
+    while ( !(mask & 1) ) {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#  endif
+}
+#endif
+
+// Find the end of unescaped text in a quoted string:
+// closing quote, escape sequence or end of line
+static inline
+const char* s_FindStringStop(const char* pos, const char* end)
+{
+#if NCBI_SSE >= 20
+    const __m128i kQuote  = _mm_set1_epi8('\"');
+    const __m128i kEscape = _mm_set1_epi8('\\');
+    const __m128i kCR     = _mm_set1_epi8('\r');
+    const __m128i kLF     = _mm_set1_epi8('\n');
+    for ( ;  end - pos >= 16;  pos += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) pos);
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, kQuote),
+                         _mm_cmpeq_epi8(chunk, kEscape)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, kCR),
+                         _mm_cmpeq_epi8(chunk, kLF)));
+        unsigned mask = (unsigned) _mm_movemask_epi8(eq);
+        if ( mask ) {
+            return pos + s_LowestBit(mask);
+        }
+    }
+#endif
+    for ( ;  pos != end;  ++pos) {
+        char c = *pos;
+        if (c == '\"' || c == '\\' || c == '\r' || c == '\n') {
+            break;
+        }
+    }
+    return pos;
+}
+
+// Find the end of unquoted data (number, true, false, null):
+// same set of terminators as in x_ReadData, plus escape sequence
+static inline
+const char* s_FindDataStop(const char* pos, const char* end)
+{
+#if NCBI_SSE >= 20
+    const __m128i kComma   = _mm_set1_epi8(',');
+    const __m128i kBracket = _mm_set1_epi8(']');
+    const __m128i kBrace   = _mm_set1_epi8('}');
+    const __m128i kSpace   = _mm_set1_epi8(' ');
+    const __m128i kCR      = _mm_set1_epi8('\r');
+    const __m128i kLF      = _mm_set1_epi8('\n');
+    const __m128i kEscape  = _mm_set1_epi8('\\');
+    const __m128i kZero    = _mm_setzero_si128();
+    for ( ;  end - pos >= 16;  pos += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) pos);
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, kComma),
+                             _mm_cmpeq_epi8(chunk, kBracket)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, kBrace),
+                             _mm_cmpeq_epi8(chunk, kSpace))),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, kCR),
+                             _mm_cmpeq_epi8(chunk, kLF)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, kEscape),
+                             _mm_cmpeq_epi8(chunk, kZero))));
+        unsigned mask = (unsigned) _mm_movemask_epi8(eq);
+        if ( mask ) {
+            return pos + s_LowestBit(mask);
+        }
+    }
+#endif
+    for ( ;  pos != end;  ++pos) {
+        switch ( *pos ) {
+        case ',': case ']': case '}': case ' ':
+        case '\r': case '\n': case '\\': case '\0':
+            return pos;
+        default:
+            break;
+        }
+    }
+    return pos;
+}
+
+
 CObjectIStream* CObjectIStream::CreateObjectIStreamJson()
 {
     return new CObjectIStreamJson();
@@ -54,7 +172,8 @@ CObjectIStreamJson::CObjectIStreamJson(void)
     m_GotNameless(false),
     m_Closing(0),
     m_StringEncoding( eEncoding_UTF8 ),
-    m_BinaryFormat(eDefault)
+    m_BinaryFormat(eDefault),
+    m_FastScan(s_FastScan())
 {
     m_Utf8Pos = m_Utf8Buf.begin();
 }
@@ -67,7 +186,8 @@ CObjectIStreamJson::CObjectIStreamJson(CNcbiIstream& in, EOwnership deleteIn)
     m_GotNameless(false),
     m_Closing(0),
     m_StringEncoding( eEncoding_UTF8 ),
-    m_BinaryFormat(eDefault)
+    m_BinaryFormat(eDefault),
+    m_FastScan(s_FastScan())
 {
     m_Utf8Pos = m_Utf8Buf.begin();
     Open(in, deleteIn);
@@ -309,12 +429,74 @@ TUnicodeSymbol CObjectIStreamJson::ReadUtf8Char(char c)
     return chU;
 }
 
+bool CObjectIStreamJson::x_CanScanPlain(EStringType type) const
+{
+    // plain chars are copied as is only when no recoding is needed
+    // and there are no pending bytes of a decoded escape sequence
+    if ( !m_FastScan  ||  !m_Utf8Buf.empty() ) {
+        return false;
+    }
+    EEncoding enc_out( type == eStringTypeUTF8 ? eEncoding_UTF8 : m_StringEncoding);
+    return enc_out == eEncoding_UTF8 || enc_out == eEncoding_Unknown;
+}
+
+size_t CObjectIStreamJson::x_ScanPlainChars(bool quoted)
+{
+    m_Input.PeekChar();
+    const char* pos = m_Input.GetCurrentPos();
+    const char* end = pos + m_Input.GetAvailableChars();
+    return (quoted ? s_FindStringStop(pos, end) : s_FindDataStop(pos, end)) - pos;
+}
+
+bool CObjectIStreamJson::x_ReadPlainInteger(Uint8& value, bool is_signed, bool& negative)
+{
+    if ( !x_CanScanPlain(eStringTypeUTF8) ) {
+        return false;
+    }
+    SkipWhiteSpace();
+    size_t count = x_ScanPlainChars(false);
+    if (count == m_Input.GetAvailableChars()) {
+        // the number may continue beyond the buffer
+        return false;
+    }
+    const char* pos = m_Input.GetCurrentPos();
+    const char* end = pos + count;
+    negative = is_signed && pos != end && *pos == '-';
+    if (negative) {
+        ++pos;
+    }
+    // at most 18 digits, so that it cannot overflow;
+    // anything else is left for the generic code
+    if (pos == end || end - pos > 18) {
+        return false;
+    }
+    Uint8 v = 0;
+    for ( ; pos != end; ++pos) {
+        unsigned d = (unsigned)(*pos - '0');
+        if (d > 9) {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+    m_Input.SkipChars(count);
+    value = v;
+    return true;
+}
+
 string CObjectIStreamJson::x_ReadString(EStringType type)
 {
     m_ExpectValue = false;
     Expect('\"',true);
     string str;
     for (;;) {
+        if ( x_CanScanPlain(type) ) {
+            size_t count = x_ScanPlainChars(true);
+            if (count != 0) {
+                str.append(m_Input.GetCurrentPos(), count);
+                m_Input.SkipChars(count);
+                continue;
+            }
+        }
         bool encoded = false;
         char c = ReadEncodedChar(type, encoded);
         if (!encoded) {
@@ -338,6 +520,14 @@ void CObjectIStreamJson::x_ReadData(string& str, EStringType type /*= eStringTyp
 {
     SkipWhiteSpace();
     for (;;) {
+        if ( x_CanScanPlain(type) ) {
+            size_t count = x_ScanPlainChars(false);
+            if (count != 0) {
+                str.append(m_Input.GetCurrentPos(), count);
+                m_Input.SkipChars(count);
+                continue;
+            }
+        }
         bool encoded = false;
         char c = ReadEncodedChar(type, encoded);
         if (!encoded && strchr(",]} \r\n", c)) {
@@ -372,6 +562,13 @@ void  CObjectIStreamJson::x_SkipData(void)
     m_ExpectValue = false;
     char to = GetChar(true);
     for (;;) {
+        if ( x_CanScanPlain(eStringTypeUTF8) ) {
+            size_t count = x_ScanPlainChars(to == '\"');
+            if (count != 0) {
+                m_Input.SkipChars(count);
+                continue;
+            }
+        }
         bool encoded = false;
         char c = ReadEncodedChar(eStringTypeUTF8, encoded);
         if (!encoded) {
@@ -515,6 +712,11 @@ void CObjectIStreamJson::SkipChar(void)
 
 Int8 CObjectIStreamJson::ReadInt8(void)
 {
+    Uint8 value;
+    bool negative;
+    if (x_ReadPlainInteger(value, true, negative)) {
+        return negative ? -Int8(value) : Int8(value);
+    }
     string str;
     if (x_ReadDataAndCheck(str)) {
         if (str.empty() || !(isdigit(str[0]) || str[0] == '+' || str[0] == '-')) {
@@ -527,6 +729,11 @@ Int8 CObjectIStreamJson::ReadInt8(void)
 
 Uint8 CObjectIStreamJson::ReadUint8(void)
 {
+    Uint8 value;
+    bool negative;
+    if (x_ReadPlainInteger(value, false, negative)) {
+        return value;
+    }
     string str;
     if (x_ReadDataAndCheck(str)) {
         if (str.empty() || !(isdigit(str[0]) || str[0] == '+')) {
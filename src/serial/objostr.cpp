@@ -303,6 +303,23 @@ CObjectOStream::CObjectOStream(ESerialDataFormat format,
 {
 }
 
+CObjectOStream::CObjectOStream(ESerialDataFormat format,
+                               CScatterGatherBuffer& out)
+    : m_Output(out), m_Fail(fNoError), m_Flags(fFlagNone),
+      m_Separator(""),
+      m_DataFormat(format),
+      m_ParseDelayBuffers(eDelayBufferPolicyNotSet),
+      m_SpecialCaseWrite(eWriteAsNormal),
+      m_AutoSeparator(false),
+      m_WriteNamedIntegersByValue(false),
+      m_FastWriteDouble(s_FastWriteDouble->Get()),
+      m_EnforceWritingDefaults(false),
+      m_TypeAlias(nullptr),
+      m_FixMethod(x_GetFixCharsMethodDefault()),
+      m_VerifyData(x_GetVerifyDataDefault())
+{
+}
+
 CObjectOStream::~CObjectOStream(void)
 {
     try {
@@ -1124,6 +1141,12 @@ void CObjectOStream::ByteBlock::End(void)
     }
 }
 
+void CObjectOStream::WriteExternalBytes(const ByteBlock& block,
+                                        const char* bytes, size_t length)
+{
+    WriteBytes(block, bytes, length);
+}
+
 CObjectOStream::ByteBlock::~ByteBlock(void)
 {
     if ( !m_Ended ) {
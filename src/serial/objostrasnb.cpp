@@ -42,6 +42,7 @@
 #include <serial/enumvalues.hpp>
 #include <serial/impl/memberlist.hpp>
 #include <serial/objhook.hpp>
+#include <serial/impl/member.hpp>
 #include <serial/impl/classinfo.hpp>
 #include <serial/impl/choice.hpp>
 #include <serial/impl/continfo.hpp>
@@ -69,10 +70,19 @@ CObjectOStream* CObjectOStream::OpenObjectOStreamAsnBinary(CNcbiOstream& out,
     return new CObjectOStreamAsnBinary(out, deleteOut);
 }
 
+NCBI_PARAM_DECL(bool, SERIAL, USE_GENERATED_ASNB);
+
+static bool s_UseGeneratedCode(void)
+{
+    static CSafeStatic<NCBI_PARAM_TYPE(SERIAL, USE_GENERATED_ASNB)> s_Use;
+    return s_Use->Get();
+}
+
 CObjectOStreamAsnBinary::CObjectOStreamAsnBinary(CNcbiOstream& out,
                                                  EFixNonPrint how)
     : CObjectOStream(eSerial_AsnBinary, out),
-      m_CStyleBigInt(false), m_SkipNextTag(false), m_AutomaticTagging(true)
+      m_CStyleBigInt(false), m_SkipNextTag(false), m_AutomaticTagging(true),
+      m_UseGeneratedCode(s_UseGeneratedCode())
 {
     FixNonPrint(how);
 #if CHECK_OUTSTREAM_INTEGRITY
@@ -86,7 +96,8 @@ CObjectOStreamAsnBinary::CObjectOStreamAsnBinary(CNcbiOstream& out,
                                                  bool deleteOut,
                                                  EFixNonPrint how)
     : CObjectOStream(eSerial_AsnBinary, out, deleteOut ? eTakeOwnership : eNoOwnership),
-      m_CStyleBigInt(false), m_SkipNextTag(false), m_AutomaticTagging(true)
+      m_CStyleBigInt(false), m_SkipNextTag(false), m_AutomaticTagging(true),
+      m_UseGeneratedCode(s_UseGeneratedCode())
 {
     FixNonPrint(how);
 #if CHECK_OUTSTREAM_INTEGRITY
@@ -100,7 +111,22 @@ CObjectOStreamAsnBinary::CObjectOStreamAsnBinary(CNcbiOstream& out,
                                                  EOwnership deleteOut,
                                                  EFixNonPrint how)
     : CObjectOStream(eSerial_AsnBinary, out, deleteOut),
-      m_CStyleBigInt(false), m_SkipNextTag(false), m_AutomaticTagging(true)
+      m_CStyleBigInt(false), m_SkipNextTag(false), m_AutomaticTagging(true),
+      m_UseGeneratedCode(s_UseGeneratedCode())
+{
+    FixNonPrint(how);
+#if CHECK_OUTSTREAM_INTEGRITY
+    m_CurrentPosition = 0;
+    m_CurrentTagState = eTagStart;
+    m_CurrentTagLimit = 0;
+#endif
+}
+
+CObjectOStreamAsnBinary::CObjectOStreamAsnBinary(CScatterGatherBuffer& out,
+                                                 EFixNonPrint how)
+    : CObjectOStream(eSerial_AsnBinary, out),
+      m_CStyleBigInt(false), m_SkipNextTag(false), m_AutomaticTagging(true),
+      m_UseGeneratedCode(s_UseGeneratedCode())
 {
     FixNonPrint(how);
 #if CHECK_OUTSTREAM_INTEGRITY
@@ -227,7 +253,8 @@ void CObjectOStreamAsnBinary::WriteByte(Uint1 byte)
 #if !CHECK_OUTSTREAM_INTEGRITY
 inline
 #endif
-void CObjectOStreamAsnBinary::WriteBytes(const char* bytes, size_t size)
+void CObjectOStreamAsnBinary::WriteBytes(const char* bytes, size_t size,
+                                         bool external)
 {
     if ( size == 0 )
         return;
@@ -243,7 +270,12 @@ void CObjectOStreamAsnBinary::WriteBytes(const char* bytes, size_t size)
     if ( new_pos == m_CurrentTagLimit )
         EndTag();
 #endif
-    m_Output.PutString(bytes, size);
+    if ( external ) {
+        m_Output.WriteExternal(bytes, size);
+    }
+    else {
+        m_Output.PutString(bytes, size);
+    }
 }
 
 template<typename T>
@@ -1339,6 +1371,149 @@ void CObjectOStreamAsnBinary::EndClassMember(void)
 #endif
 }
 
+void CObjectOStreamAsnBinary::WriteGeneratedClass(const CClassTypeInfo* classType,
+                                                  TConstObjectPtr classPtr)
+{
+    CClassTypeInfo::TAsnBinaryWriteFunction func =
+        classType->GetAsnBinaryWriteFunction();
+#if USE_OLD_TAGS
+    func = 0;
+#endif
+    if ( !func  ||  !m_UseGeneratedCode ) {
+        WriteClassSequential(classType, classPtr);
+        return;
+    }
+    BEGIN_OBJECT_FRAME2(eFrameClass, classType);
+    CObjectOStreamAsnBinary::BeginClass(classType);
+
+    func(*this, classType, classPtr);
+
+    CObjectOStreamAsnBinary::EndClass();
+    END_OBJECT_FRAME();
+}
+
+bool CObjectOStreamAsnBinary::x_BeginGeneratedValue(const CMemberInfo* memberInfo,
+                                                    TConstObjectPtr classPtr)
+{
+    if ( !memberInfo->HaveSetFlag()  ||  memberInfo->CanBeDelayed()  ||
+         memberInfo->Nillable()  ||  memberInfo->GetId().HaveNoPrefix()  ||
+         memberInfo->GetSetFlag(classPtr) != CMemberInfo::eSetYes  ||
+         (memberInfo->GetDefault() && IsWritingDefaultValuesEnforced())  ||
+         memberInfo->HaveWriteHooks() ) {
+        memberInfo->WriteMember(*this, classPtr);
+        return false;
+    }
+    if (GetVerifyData() == eSerialVerifyData_Yes) {
+        memberInfo->Validate(classPtr, *this);
+    }
+    return true;
+}
+
+void CObjectOStreamAsnBinary::WriteGeneratedMember(const CMemberInfo* memberInfo,
+                                                   TConstObjectPtr classPtr)
+{
+    memberInfo->WriteMember(*this, classPtr);
+}
+
+void CObjectOStreamAsnBinary::WriteGeneratedMember(const CMemberInfo* memberInfo,
+                                                   TConstObjectPtr classPtr,
+                                                   bool data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        BEGIN_OBJECT_FRAME2(eFrameClassMember, memberInfo->GetId());
+        CObjectOStreamAsnBinary::BeginClassMember(memberInfo->GetId());
+        CObjectOStreamAsnBinary::WriteBool(data);
+        CObjectOStreamAsnBinary::EndClassMember();
+        END_OBJECT_FRAME();
+    }
+}
+
+void CObjectOStreamAsnBinary::WriteGeneratedMember(const CMemberInfo* memberInfo,
+                                                   TConstObjectPtr classPtr,
+                                                   Int4 data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        BEGIN_OBJECT_FRAME2(eFrameClassMember, memberInfo->GetId());
+        CObjectOStreamAsnBinary::BeginClassMember(memberInfo->GetId());
+        CObjectOStreamAsnBinary::WriteInt4(data);
+        CObjectOStreamAsnBinary::EndClassMember();
+        END_OBJECT_FRAME();
+    }
+}
+
+void CObjectOStreamAsnBinary::WriteGeneratedMember(const CMemberInfo* memberInfo,
+                                                   TConstObjectPtr classPtr,
+                                                   Uint4 data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        BEGIN_OBJECT_FRAME2(eFrameClassMember, memberInfo->GetId());
+        CObjectOStreamAsnBinary::BeginClassMember(memberInfo->GetId());
+        CObjectOStreamAsnBinary::WriteUint4(data);
+        CObjectOStreamAsnBinary::EndClassMember();
+        END_OBJECT_FRAME();
+    }
+}
+
+void CObjectOStreamAsnBinary::WriteGeneratedMember(const CMemberInfo* memberInfo,
+                                                   TConstObjectPtr classPtr,
+                                                   Int8 data)
+{
+    if ( m_CStyleBigInt ) {
+        // BigInt members may need their own encoding
+        memberInfo->WriteMember(*this, classPtr);
+    }
+    else if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        BEGIN_OBJECT_FRAME2(eFrameClassMember, memberInfo->GetId());
+        CObjectOStreamAsnBinary::BeginClassMember(memberInfo->GetId());
+        CObjectOStreamAsnBinary::WriteInt8(data);
+        CObjectOStreamAsnBinary::EndClassMember();
+        END_OBJECT_FRAME();
+    }
+}
+
+void CObjectOStreamAsnBinary::WriteGeneratedMember(const CMemberInfo* memberInfo,
+                                                   TConstObjectPtr classPtr,
+                                                   Uint8 data)
+{
+    if ( m_CStyleBigInt ) {
+        // BigInt members may need their own encoding
+        memberInfo->WriteMember(*this, classPtr);
+    }
+    else if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        BEGIN_OBJECT_FRAME2(eFrameClassMember, memberInfo->GetId());
+        CObjectOStreamAsnBinary::BeginClassMember(memberInfo->GetId());
+        CObjectOStreamAsnBinary::WriteUint8(data);
+        CObjectOStreamAsnBinary::EndClassMember();
+        END_OBJECT_FRAME();
+    }
+}
+
+void CObjectOStreamAsnBinary::WriteGeneratedMember(const CMemberInfo* memberInfo,
+                                                   TConstObjectPtr classPtr,
+                                                   double data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        BEGIN_OBJECT_FRAME2(eFrameClassMember, memberInfo->GetId());
+        CObjectOStreamAsnBinary::BeginClassMember(memberInfo->GetId());
+        CObjectOStreamAsnBinary::WriteDouble(data);
+        CObjectOStreamAsnBinary::EndClassMember();
+        END_OBJECT_FRAME();
+    }
+}
+
+void CObjectOStreamAsnBinary::WriteGeneratedMember(const CMemberInfo* memberInfo,
+                                                   TConstObjectPtr classPtr,
+                                                   const string& data)
+{
+    if ( x_BeginGeneratedValue(memberInfo, classPtr) ) {
+        BEGIN_OBJECT_FRAME2(eFrameClassMember, memberInfo->GetId());
+        CObjectOStreamAsnBinary::BeginClassMember(memberInfo->GetId());
+        CObjectOStreamAsnBinary::WriteString(data, eStringTypeVisible);
+        CObjectOStreamAsnBinary::EndClassMember();
+        END_OBJECT_FRAME();
+    }
+}
+
 #ifdef VIRTUAL_MID_LEVEL_IO
 void CObjectOStreamAsnBinary::WriteClass(const CClassTypeInfo* classType,
                                          TConstObjectPtr classPtr)
@@ -1675,6 +1850,13 @@ void CObjectOStreamAsnBinary::WriteBytes(const ByteBlock& ,
     WriteBytes(bytes, length);
 }
 
+void CObjectOStreamAsnBinary::WriteExternalBytes(const ByteBlock& ,
+                                                 const char* bytes,
+                                                 size_t length)
+{
+    WriteBytes(bytes, length, true);
+}
+
 void CObjectOStreamAsnBinary::BeginChars(const CharBlock& block)
 {
     if ( block.GetLength() == 0 ) {
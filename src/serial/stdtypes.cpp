@@ -1539,7 +1539,7 @@ public:
             size_t length = o.size();
             CObjectOStream::ByteBlock block(out, length);
             if ( length > 0 )
-                block.Write(ToChar(&o.front()), length);
+                block.WriteExternal(ToChar(&o.front()), length);
             block.End();
         }
 };
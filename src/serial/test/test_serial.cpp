@@ -32,6 +32,10 @@
 
 #include <ncbi_pch.hpp>
 #include "test_serial.hpp"
+#if defined(NCBI_OS_UNIX)
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
 #ifndef HAVE_NCBI_C
 
 /////////////////////////////////////////////////////////////////////////////
@@ -102,6 +106,688 @@ BOOST_AUTO_TEST_CASE(s_TestAsnSerialization)
         BOOST_CHECK( CFile( bin_in).Compare( bin_out) );
     }
 }
+
+/////////////////////////////////////////////////////////////////////////////
+// Test generated binary ASN.1 codecs against the generic code
+
+BOOST_AUTO_TEST_CASE(s_TestAsnBinaryGeneratedCode)
+{
+    // the test module is generated with the codecs
+    TTypeInfo types[] = {
+        CWeb_Env::GetTypeInfo(), CArgument::GetTypeInfo(),
+        CDb_Env::GetTypeInfo(), CFilter_Value::GetTypeInfo(),
+        CDb_Clipboard::GetTypeInfo(), CItem_Set::GetTypeInfo(),
+        CQuery_History::GetTypeInfo(), CQuery_Search::GetTypeInfo(),
+        CQuery_Select::GetTypeInfo(), CQuery_Related::GetTypeInfo(),
+        CFull_Time::GetTypeInfo()
+    };
+    for (size_t i = 0;  i < ArraySize(types);  ++i) {
+        const CClassTypeInfo* classType =
+            dynamic_cast<const CClassTypeInfo*>(types[i]);
+        BOOST_REQUIRE( classType );
+        BOOST_CHECK_MESSAGE( classType->GetAsnBinaryReadFunction(),
+                             types[i]->GetName() );
+        BOOST_CHECK_MESSAGE( classType->GetAsnBinaryWriteFunction(),
+                             types[i]->GetName() );
+    }
+
+    string  bin_in("webenv.bin"),  bin_out("webenv.bino");
+    CRef<CWeb_Env> env[2];
+    for (int generated = 0;  generated < 2;  ++generated) {
+        env[generated].Reset(new CWeb_Env);
+        {
+            CNcbiIfstream ifs(bin_in.c_str(), IOS_BASE::in | IOS_BASE::binary);
+            CObjectIStreamAsnBinary in(ifs);
+            in.SetUseGeneratedCode(generated != 0);
+            in >> *env[generated];
+        }
+        // parse delayed members, if any, by the streams
+        // created with the same setting
+        CNcbiOstrstream ostrs;
+        ostrs << MSerial_AsnText << *env[generated];
+        {
+            CNcbiOfstream ofs(bin_out.c_str(),
+                IOS_BASE::out | IOS_BASE::trunc | IOS_BASE::binary);
+            CObjectOStreamAsnBinary out(ofs);
+            out.SetUseGeneratedCode(generated != 0);
+            out << *env[generated];
+        }
+        BOOST_CHECK( CFile( bin_in).Compare( bin_out) );
+    }
+    BOOST_CHECK( env[0]->Equals(*env[1]) );
+}
+
+// Compare the speed of the generated and generic readers
+BOOST_AUTO_TEST_CASE(s_TestAsnBinaryGeneratedCodeSpeed)
+{
+    CRef<CWeb_Env> env(new CWeb_Env);
+    {
+        unique_ptr<CObjectIStream> in(
+            CObjectIStream::Open("webenv.bin",eSerial_AsnBinary));
+        *in >> *env;
+    }
+    CRef<CWeb_Env> big(new CWeb_Env);
+    for (int i = 0;  i < 20000;  ++i) {
+        CRef<CArgument> arg(new CArgument);
+        arg->SetName("arg" + NStr::NumericToString(i));
+        arg->SetValue(string(i % 50, 'v'));
+        big->SetArguments().push_back(arg);
+    }
+    for (int i = 0;  i < 2000;  ++i) {
+        CRef<CDb_Env> db(new CDb_Env);
+        db->SetName("db" + NStr::NumericToString(i));
+        db->SetArguments() = big->GetArguments();
+        db->SetArguments().resize(5);
+        for (int j = 0;  j < 3;  ++j) {
+            CRef<CFilter_Value> filter(new CFilter_Value);
+            filter->SetName("field");
+            filter->SetValue(NStr::NumericToString(j));
+            db->SetFilters().push_back(filter);
+        }
+        big->SetDb_Env().push_back(db);
+    }
+    for (int i = 0;  i < 200;  ++i) {
+        ITERATE ( CWeb_Env::TQueries, it, env->GetQueries() ) {
+            big->SetQueries().push_back(*it);
+        }
+    }
+    string data;
+    {
+        CNcbiOstrstream ostrs;
+        ostrs << MSerial_AsnBinary << *big;
+        data = CNcbiOstrstreamToString(ostrs);
+    }
+
+    const char* names[] = { "generic", "generated" };
+    for (int generated = 0;  generated < 2;  ++generated) {
+        const int kRuns = 3;
+        CStopWatch sw(CStopWatch::eStart);
+        for (int run = 0;  run < kRuns;  ++run) {
+            CRef<CWeb_Env> obj(new CWeb_Env);
+            CObjectIStreamAsnBinary in(data.data(), data.size());
+            in.SetUseGeneratedCode(generated != 0);
+            in.SetDelayBufferParsingPolicy(
+                CObjectIStream::eDelayBufferPolicyAlwaysParse);
+            in >> *obj;
+            BOOST_CHECK( obj->Equals(*big) );
+        }
+        LOG_POST("Web-Env " << data.size() << " bytes, " << names[generated]
+                 << " reader: " << sw.Elapsed() / kRuns << " s");
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Test lazy member decoding (we_lazy module) against the full parsing
+
+static bool s_IsDelayed(const CSerialObject& obj, const char* member)
+{
+    const CClassTypeInfo* type =
+        dynamic_cast<const CClassTypeInfo*>(obj.GetThisTypeInfo());
+    const CMemberInfo* info =
+        type->GetMemberInfo(type->GetMembers().Find(member));
+    return info->CanBeDelayed() &&
+        info->GetDelayBuffer(dynamic_cast<const void*>(&obj)).Delayed();
+}
+
+BOOST_AUTO_TEST_CASE(s_TestLazyMembers)
+{
+    // the queries from webenv.bin, and DB environments with arguments
+    string data;
+    {
+        CRef<CLazy_Web_Env> env(new CLazy_Web_Env);
+        unique_ptr<CObjectIStream> in(
+            CObjectIStream::Open("webenv.bin",eSerial_AsnBinary));
+        *in >> *env;
+        for (int i = 0;  i < 10;  ++i) {
+            CRef<CLazy_Db_Env> db(new CLazy_Db_Env);
+            db->SetName("db" + NStr::NumericToString(i));
+            for (int j = 0;  j < i;  ++j) {
+                CRef<CLazy_Argument> arg(new CLazy_Argument);
+                arg->SetName("arg");
+                arg->SetValue(NStr::NumericToString(j));
+                db->SetArguments().push_back(arg);
+            }
+            env->SetDb_Env().push_back(db);
+        }
+        CNcbiOstrstream ostrs;
+        ostrs << MSerial_AsnBinary << *env;
+        data = CNcbiOstrstreamToString(ostrs);
+    }
+    CRef<CLazy_Web_Env> eager(new CLazy_Web_Env);
+    {
+        CObjectIStreamAsnBinary in(data.data(), data.size());
+        in.SetDelayBufferParsingPolicy(
+            CObjectIStream::eDelayBufferPolicyAlwaysParse);
+        in >> *eager;
+    }
+    BOOST_REQUIRE( eager->IsSetDb_Env() && eager->IsSetQueries() );
+    BOOST_CHECK( !s_IsDelayed(*eager, "db-Env") );
+
+    CRef<CLazy_Web_Env> lazy(new CLazy_Web_Env);
+    {
+        CObjectIStreamAsnBinary in(data.data(), data.size());
+        in >> *lazy;
+    }
+    // members stay delayed after reading
+    BOOST_CHECK( s_IsDelayed(*lazy, "db-Env") );
+    BOOST_CHECK( s_IsDelayed(*lazy, "queries") );
+    // untouched object is written back from the stored data
+    {
+        CNcbiOstrstream ostrs;
+        ostrs << MSerial_AsnBinary << *lazy;
+        BOOST_CHECK( string(CNcbiOstrstreamToString(ostrs)) == data );
+        BOOST_CHECK( s_IsDelayed(*lazy, "db-Env") );
+    }
+    // getters decode the members, nested members are delayed again
+    BOOST_REQUIRE_EQUAL( lazy->GetDb_Env().size(), eager->GetDb_Env().size() );
+    BOOST_CHECK( !s_IsDelayed(*lazy, "db-Env") );
+    BOOST_CHECK( s_IsDelayed(*lazy, "queries") );
+    const CLazy_Db_Env& db = *lazy->GetDb_Env().back();
+    const CLazy_Db_Env& eager_db = *eager->GetDb_Env().back();
+    BOOST_CHECK_EQUAL( db.GetName(), eager_db.GetName() );
+    BOOST_CHECK( s_IsDelayed(db, "arguments") );
+    BOOST_REQUIRE_EQUAL( db.GetArguments().size(),
+                         eager_db.GetArguments().size() );
+    BOOST_CHECK( !s_IsDelayed(db, "arguments") );
+    BOOST_CHECK_EQUAL( db.GetArguments().back()->GetValue(),
+                       eager_db.GetArguments().back()->GetValue() );
+    BOOST_CHECK_EQUAL( lazy->GetQueries().size(), eager->GetQueries().size() );
+    BOOST_CHECK( lazy->Equals(*eager) );
+
+    // the same delayed member is decoded by several threads at once
+    for (int i = 0;  i < 10;  ++i) {
+        CRef<CLazy_Web_Env> shared(new CLazy_Web_Env);
+        {
+            CObjectIStreamAsnBinary in(data.data(), data.size());
+            in >> *shared;
+        }
+        const CLazy_Web_Env& obj = *shared;
+        atomic<size_t> errors(0);
+        vector<thread> readers;
+        for (int t = 0;  t < 4;  ++t) {
+            readers.push_back(thread([&]() {
+                if ( obj.GetQueries().size() != eager->GetQueries().size() ||
+                     obj.GetDb_Env().size() != eager->GetDb_Env().size() ) {
+                    ++errors;
+                }
+            }));
+        }
+        NON_CONST_ITERATE(vector<thread>, it, readers) {
+            it->join();
+        }
+        BOOST_CHECK_EQUAL( errors.load(), 0U );
+        BOOST_CHECK( obj.Equals(*eager) );
+    }
+}
+
+// Reading of a large object with delayed members
+// is compared with the full parsing
+BOOST_AUTO_TEST_CASE(s_TestLazyMembersSpeed)
+{
+    const int kDbs = 1000, kArguments = 300;
+    CRef<CLazy_Web_Env> env(new CLazy_Web_Env);
+    for (int i = 0;  i < kDbs;  ++i) {
+        CRef<CLazy_Db_Env> db(new CLazy_Db_Env);
+        db->SetName("db" + NStr::NumericToString(i));
+        for (int j = 0;  j < kArguments;  ++j) {
+            CRef<CLazy_Argument> arg(new CLazy_Argument);
+            arg->SetName("arg");
+            arg->SetValue(NStr::NumericToString(j));
+            db->SetArguments().push_back(arg);
+        }
+        env->SetDb_Env().push_back(db);
+    }
+    string data;
+    {
+        CNcbiOstrstream ostrs;
+        ostrs << MSerial_AsnBinary << *env;
+        data = CNcbiOstrstreamToString(ostrs);
+    }
+    env.Reset();
+
+    CRef<CLazy_Web_Env> obj[2];
+    double elapsed[2];
+    const char* names[] = { "full parsing", "lazy" };
+    for (int lazy = 0;  lazy < 2;  ++lazy) {
+        obj[lazy].Reset(new CLazy_Web_Env);
+        CStopWatch sw(CStopWatch::eStart);
+        CObjectIStreamAsnBinary in(data.data(), data.size());
+        if ( !lazy ) {
+            in.SetDelayBufferParsingPolicy(
+                CObjectIStream::eDelayBufferPolicyAlwaysParse);
+        }
+        in >> *obj[lazy];
+        elapsed[lazy] = sw.Elapsed();
+        LOG_POST("Lazy-Web-Env with " << kDbs * kArguments << " arguments, "
+                 << data.size() << " bytes, " << names[lazy] << ": "
+                 << elapsed[lazy] << " s");
+    }
+    BOOST_CHECK( elapsed[1] < elapsed[0] );
+    BOOST_CHECK( obj[1]->Equals(*obj[0]) );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Test ASN binary output into scatter/gather buffer
+
+BOOST_AUTO_TEST_CASE(s_TestScatterGatherOutput)
+{
+    string  bin_in("webenv.bin"),  bin_out("webenv.bino");
+    CRef<CWeb_Env> env(new CWeb_Env);
+    {
+        unique_ptr<CObjectIStream> in(
+            CObjectIStream::Open(bin_in,eSerial_AsnBinary));
+        *in >> *env;
+    }
+    // small chunks and threshold, so that OCTET STRING data is referenced
+    CScatterGatherBuffer buffer(16);
+    buffer.SetExternalThreshold(1);
+    for (int i = 0;  i < 2;  ++i) {
+        {
+            CObjectOStreamAsnBinary out(buffer);
+            out << *env;
+        }
+        BOOST_CHECK_EQUAL( buffer.GetSize(), (size_t)CFile(bin_in).GetLength() );
+        BOOST_CHECK( buffer.GetSegments().size() > 1 );
+        {
+            CNcbiOfstream ofs(bin_out.c_str(),
+                IOS_BASE::out | IOS_BASE::trunc | IOS_BASE::binary);
+            buffer.WriteTo(ofs);
+        }
+        BOOST_CHECK_EQUAL( buffer.GetSize(), 0U );
+        BOOST_CHECK( CFile( bin_in).Compare( bin_out) );
+    }
+}
+
+// Writer which accepts at most 1000 bytes per call, and every
+// 'fail_every'-th call writes a few bytes and returns 'failure'
+class CPartialWriter : public IWriter
+{
+public:
+    CPartialWriter(int fail_every, ERW_Result failure)
+        : m_Calls(0), m_Failures(0),
+          m_FailEvery(fail_every), m_Failure(failure)
+        {
+        }
+    virtual ERW_Result Write(const void* buf, size_t count,
+                             size_t* bytes_written = 0)
+        {
+            bool fail = ++m_Calls % m_FailEvery == 0;
+            size_t n = min(count, size_t(fail ? 10 : 1000));
+            m_Data.append(static_cast<const char*>(buf), n);
+            if ( bytes_written ) {
+                *bytes_written = n;
+            }
+            if ( fail ) {
+                ++m_Failures;
+                return m_Failure;
+            }
+            return eRW_Success;
+        }
+    virtual ERW_Result Flush(void)
+        {
+            return eRW_Success;
+        }
+
+    string m_Data;
+    int    m_Calls;
+    int    m_Failures;
+private:
+    int        m_FailEvery;
+    ERW_Result m_Failure;
+};
+
+BOOST_AUTO_TEST_CASE(s_TestScatterGatherExternal)
+{
+    CItem_Set items;
+    items.SetCount(3);
+    vector<char>& data = items.SetItems();
+    for (int i = 0;  i < 3000000;  ++i) {
+        data.push_back(char(i * 7));
+    }
+    string expected;
+    {
+        CNcbiOstrstream ostrs;
+        {
+            CObjectOStreamAsnBinary out(ostrs);
+            out << items;
+        }
+        expected = CNcbiOstrstreamToString(ostrs);
+    }
+    CScatterGatherBuffer buffer(1024);
+    {
+        CObjectOStreamAsnBinary out(buffer);
+        out << items;
+    }
+    BOOST_CHECK_EQUAL( buffer.GetSize(), expected.size() );
+    // the OCTET STRING is not copied
+    string gathered;
+    bool external = false;
+    ITERATE ( CScatterGatherBuffer::TSegments, it, buffer.GetSegments() ) {
+        gathered.append(it->data, it->size);
+        if ( it->data == data.data() ) {
+            external = it->size == data.size();
+        }
+    }
+    BOOST_CHECK( external );
+    BOOST_CHECK( gathered == expected );
+
+    // partial writes are retried, errors stop writing and keep the rest
+    {{
+        CPartialWriter writer(7, eRW_Timeout);
+        while ( buffer.GetSize() != 0 ) {
+            if ( buffer.WriteTo(writer) != eRW_Success ) {
+                BOOST_CHECK_EQUAL( buffer.GetSize(),
+                                   expected.size() - writer.m_Data.size() );
+            }
+        }
+        BOOST_CHECK( writer.m_Failures > 0 );
+        BOOST_CHECK( writer.m_Data == expected );
+    }}
+    {{
+        {
+            CObjectOStreamAsnBinary out(buffer);
+            out << items;
+        }
+        CPartialWriter writer(1, eRW_Error);
+        BOOST_CHECK_EQUAL( buffer.WriteTo(writer), eRW_Error );
+        BOOST_CHECK_EQUAL( writer.m_Calls, 1 );
+        BOOST_CHECK( !writer.m_Data.empty() );
+        BOOST_CHECK_EQUAL( buffer.GetSize(),
+                           expected.size() - writer.m_Data.size() );
+        CNcbiOstrstream ostrs;
+        buffer.WriteTo(ostrs);
+        BOOST_CHECK_EQUAL( buffer.GetSize(), 0U );
+        BOOST_CHECK( writer.m_Data + string(CNcbiOstrstreamToString(ostrs))
+                     == expected );
+    }}
+
+#if defined(NCBI_OS_UNIX)
+    {{
+        {
+            CObjectOStreamAsnBinary out(buffer);
+            out << items;
+        }
+        BOOST_CHECK_THROW( buffer.WriteTo(-1), CIOException );
+        BOOST_CHECK_EQUAL( buffer.GetSize(), expected.size() );
+
+        string filename = CFile::GetTmpName();
+        int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        BOOST_REQUIRE( fd >= 0 );
+        buffer.WriteTo(fd);
+        close(fd);
+        BOOST_CHECK_EQUAL( buffer.GetSize(), 0U );
+        {
+            CNcbiIfstream ifs(filename.c_str(),
+                              IOS_BASE::in | IOS_BASE::binary);
+            CNcbiOstrstream ostrs;
+            NcbiStreamCopy(ostrs, ifs);
+            BOOST_CHECK( string(CNcbiOstrstreamToString(ostrs)) == expected );
+        }
+        CFile(filename).Remove();
+    }}
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Test JSON block scanning against the character by character reader
+
+BOOST_AUTO_TEST_CASE(s_TestJsonFastScan)
+{
+    CRef<CWeb_Env> env(new CWeb_Env);
+    {
+        unique_ptr<CObjectIStream> in(
+            CObjectIStream::Open("webenv.bin",eSerial_AsnBinary));
+        *in >> *env;
+    }
+    // the Item-Set of the stored queries does not survive a JSON round trip,
+    // so they are replaced with queries made of INTEGER fields
+    env->ResetQueries();
+    const int numbers[] = {
+        0, 1, -1, 9, -10, 123456789, -123456789, kMax_Int, kMin_Int
+    };
+    for (size_t i = 0;  i < ArraySize(numbers);  ++i) {
+        CRef<CQuery_History> query(new CQuery_History);
+        query->SetSeqNumber(numbers[i]);
+        if (i % 2 == 0) {
+            query->SetTime().SetUnix(numbers[ArraySize(numbers) - 1 - i]);
+        } else {
+            CFull_Time& t = query->SetTime().SetFull();
+            t.SetYear(numbers[i]);
+            t.SetMonth(-numbers[i]);
+            t.SetDay(0);
+            t.SetHour(23);
+            t.SetMinute(-59);
+            t.SetSecond(kMax_Int);
+        }
+        CQuery_Search& search = query->SetCommand().SetSearch();
+        search.SetDb("db");
+        search.SetTerm("term");
+        search.SetCount(numbers[(i + 1) % ArraySize(numbers)]);
+        if (i % 3 == 0) {
+            search.SetFlags(-numbers[i]);
+        }
+        env->SetQueries().push_back(query);
+    }
+    // strings with escapes, non-ASCII text and runs longer than one block
+    const char* pieces[] = {
+        "a", "bc", "\"", "\\", "/", "\t", "\xc3\xa9", "0123456789abcdef",
+        "x y,z]}"
+    };
+    for (size_t i = 0;  i < 200;  ++i) {
+        CRef<CArgument> arg(new CArgument);
+        string value;
+        for (size_t j = 0;  j < (i % 20 == 0 ? 5000 : i % 40);  ++j) {
+            value += pieces[(i * 7 + j * 3) % ArraySize(pieces)];
+        }
+        arg->SetName(NStr::NumericToString(i));
+        arg->SetValue(value);
+        env->SetArguments().push_back(arg);
+    }
+    CNcbiOstrstream ostrs;
+    ostrs << MSerial_Json << *env;
+    string json = CNcbiOstrstreamToString(ostrs);
+    CRef<CWeb_Env> env_in[2];
+    for (int fast = 0;  fast < 2;  ++fast) {
+        env_in[fast].Reset(new CWeb_Env);
+        CNcbiIstrstream is(json.data(), json.size());
+        CObjectIStreamJson in(is, eNoOwnership);
+        in.SetFastScan(fast != 0);
+        in >> *env_in[fast];
+        BOOST_CHECK( env->Equals(*env_in[fast]) );
+    }
+    CNcbiOstrstream ostrs_in;
+    ostrs_in << MSerial_Json << *env_in[1];
+    BOOST_CHECK_EQUAL( json, string(CNcbiOstrstreamToString(ostrs_in)) );
+
+    // strings are recoded, integers are still scanned as plain chars
+    for (int fast = 0;  fast < 2;  ++fast) {
+        env_in[fast].Reset(new CWeb_Env);
+        CNcbiIstrstream is(json.data(), json.size());
+        CObjectIStreamJson in(is, eNoOwnership);
+        in.SetDefaultStringEncoding(eEncoding_Windows_1252);
+        in.SetFastScan(fast != 0);
+        in >> *env_in[fast];
+    }
+    BOOST_CHECK( env_in[0]->Equals(*env_in[1]) );
+    BOOST_CHECK( env_in[1]->GetQueries().front()->Equals(
+                 *env->GetQueries().front()) );
+}
+
+// Holder of the integers read by s_TestJsonFastScanIntegers
+class CJsonIntegers : public CSerialObject
+{
+public:
+    DECLARE_INTERNAL_TYPE_INFO();
+
+    vector<Int8> m_Signed;
+    vector<Uint8> m_Unsigned;
+};
+
+BEGIN_CLASS_INFO(CJsonIntegers)
+{
+    ADD_MEMBER(m_Signed, STL_vector, (STD, (Int8)))->SetOptional();
+    ADD_MEMBER(m_Unsigned, STL_vector, (STD, (Uint8)))->SetOptional();
+}
+END_CLASS_INFO
+
+// Read JSON object with and without the fast scan;
+// returns the error message, if any
+static string s_ReadJsonIntegers(const string& json, CJsonIntegers& values,
+                                 bool fast)
+{
+    values.m_Signed.clear();
+    values.m_Unsigned.clear();
+    try {
+        CNcbiIstrstream is(json.data(), json.size());
+        CObjectIStreamJson in(is, eNoOwnership);
+        in.SetFastScan(fast);
+        in.Read(&values, values.GetThisTypeInfo(),
+                CObjectIStream::eNoFileHeader);
+    }
+    catch (CException& e) {
+        return e.GetMsg();
+    }
+    return kEmptyStr;
+}
+
+static void s_CompareJsonIntegers(const string& json)
+{
+    CJsonIntegers values[2];
+    string error[2];
+    for (int fast = 0;  fast < 2;  ++fast) {
+        error[fast] = s_ReadJsonIntegers(json, values[fast], fast != 0);
+    }
+    BOOST_CHECK_MESSAGE( error[0] == error[1], json );
+    BOOST_CHECK_MESSAGE( values[0].m_Signed == values[1].m_Signed, json );
+    BOOST_CHECK_MESSAGE( values[0].m_Unsigned == values[1].m_Unsigned, json );
+}
+
+BOOST_AUTO_TEST_CASE(s_TestJsonFastScanIntegers)
+{
+    const char* numbers[] = {
+        "0", "7", "-7", "-0", "+5", "-", "+", "--1", "1-", "12a",
+        "\"12\"", "\"-12\"", "null", "1.5", "1e3",
+        "999999999999999999", "-999999999999999999",
+        "1000000000000000000", "-1000000000000000000",
+        "1234567890123456789", "-1234567890123456789",
+        "9223372036854775807", "-9223372036854775808",
+        "9223372036854775808", "-9223372036854775809",
+        "18446744073709551615", "18446744073709551616",
+        "000000000000000000001"
+    };
+    const char* members[] = { "m_Signed", "m_Unsigned" };
+    for (size_t i = 0;  i < ArraySize(numbers);  ++i) {
+        for (size_t m = 0;  m < ArraySize(members);  ++m) {
+            string json = string("{\"") + members[m] + "\":[";
+            s_CompareJsonIntegers(json + numbers[i] + "]}");
+            s_CompareJsonIntegers(json + " 1,\n " + numbers[i] + " , 2 ]}");
+        }
+    }
+    CJsonIntegers values;
+    BOOST_CHECK( s_ReadJsonIntegers(
+        "{\"m_Signed\":[-999999999999999999,1234567890123456789,"
+        "-9223372036854775808],\"m_Unsigned\":[18446744073709551615]}",
+        values, true).empty() );
+    BOOST_REQUIRE_EQUAL( values.m_Signed.size(), 3u );
+    BOOST_CHECK_EQUAL( values.m_Signed[0], -NCBI_CONST_INT8(999999999999999999) );
+    BOOST_CHECK_EQUAL( values.m_Signed[1], NCBI_CONST_INT8(1234567890123456789) );
+    BOOST_CHECK_EQUAL( values.m_Signed[2], numeric_limits<Int8>::min() );
+    BOOST_REQUIRE_EQUAL( values.m_Unsigned.size(), 1u );
+    BOOST_CHECK_EQUAL( values.m_Unsigned[0], numeric_limits<Uint8>::max() );
+    BOOST_CHECK( !s_ReadJsonIntegers(
+        "{\"m_Unsigned\":[-1]}", values, true).empty() );
+
+    // numbers of all lengths cross the ends of the input buffer
+    CJsonIntegers expected;
+    string json = "{\"m_Signed\":[";
+    Int8 value = 1;
+    for (int i = 0;  i < 20000;  ++i) {
+        if (i != 0) {
+            json += (i % 5 == 0 ? ",\n" : ",");
+        }
+        expected.m_Signed.push_back(i % 2 ? -value : value);
+        json += NStr::NumericToString(expected.m_Signed.back());
+        value = value < NCBI_CONST_INT8(100000000000000000) ?
+            value * 10 + i % 10 : 1;
+    }
+    json += "]}";
+    for (int fast = 0;  fast < 2;  ++fast) {
+        BOOST_CHECK( s_ReadJsonIntegers(json, values, fast != 0).empty() );
+        BOOST_CHECK( values.m_Signed == expected.m_Signed );
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Test objects read into per-thread memory pools and released in
+// other threads
+
+BOOST_AUTO_TEST_CASE(s_TestMemoryPoolThreads)
+{
+    string data;
+    {
+        CNcbiIfstream ifs("webenv.bin", IOS_BASE::in | IOS_BASE::binary);
+        CNcbiOstrstream ostrs;
+        NcbiStreamCopy(ostrs, ifs);
+        data = CNcbiOstrstreamToString(ostrs);
+    }
+    CRef<CWeb_Env> env(new CWeb_Env);
+    {
+        CNcbiIstrstream is(data.data(), data.size());
+        CObjectIStreamAsnBinary in(is);
+        in >> *env;
+    }
+
+    const size_t kThreads = 4, kObjects = 50;
+    vector< vector< CRef<CWeb_Env> > > objects(kThreads);
+    atomic<size_t> errors(0);
+    {
+        vector<thread> readers;
+        for (size_t t = 0;  t < kThreads;  ++t) {
+            readers.push_back(thread([&, t]() {
+                // The pool is released before the objects allocated in it.
+                CRef<CObjectMemoryPool> pool(new CObjectMemoryPool(1024));
+                for (size_t i = 0;  i < kObjects;  ++i) {
+                    CNcbiIstrstream is(data.data(), data.size());
+                    CObjectIStreamAsnBinary in(is);
+                    in.SetMemoryPool(pool);
+                    CRef<CWeb_Env> obj;
+                    {
+                        CObjectMemoryPoolGuard guard(pool);
+                        obj.Reset(new CWeb_Env);
+                    }
+                    in >> *obj;
+                    if (CObjectMemoryPool::GetThreadPool()) {
+                        ++errors;
+                    }
+                    objects[t].push_back(obj);
+                }
+            }));
+        }
+        NON_CONST_ITERATE(vector<thread>, it, readers) {
+            it->join();
+        }
+    }
+    {
+        // Objects from the same pool chunks are checked and released
+        // concurrently by all threads.
+        vector<thread> releasers;
+        for (size_t t = 0;  t < kThreads;  ++t) {
+            releasers.push_back(thread([&, t]() {
+                for (size_t i = t;  i < kThreads*kObjects;  i += kThreads) {
+                    CRef<CWeb_Env>& obj = objects[i % kThreads][i / kThreads];
+                    if ( !obj->Equals(*env) ) {
+                        ++errors;
+                    }
+                    obj.Reset();
+                }
+            }));
+        }
+        NON_CONST_ITERATE(vector<thread>, it, releasers) {
+            it->join();
+        }
+    }
+    BOOST_CHECK_EQUAL( errors.load(), 0U );
+}
 #endif
 
 /////////////////////////////////////////////////////////////////////////////
@@ -423,6 +1109,82 @@ BOOST_AUTO_TEST_CASE(s_TestSerialFilter)
         }
         BOOST_CHECK(gotit);
     }
+    {
+        // pipeline mode: the objects come in the same order
+        // as from the synchronous iterator
+        ESerialDataFormat formats[] = {
+            eSerial_AsnText, eSerial_AsnBinary, eSerial_Json
+        };
+        for (size_t f = 0;  f < ArraySize(formats);  ++f) {
+            string objects;
+            {
+                CRef<CWeb_Env> web(new CWeb_Env);
+                web->Assign(*env);
+                if (formats[f] == eSerial_Json) {
+                    // JSON output of Item-Set OCTET STRING cannot be read back
+                    web->ResetQueries();
+                }
+                CNcbiOstrstream ostrs;
+                {
+                    unique_ptr<CObjectOStream> os(
+                        CObjectOStream::Open(formats[f], ostrs));
+                    for (int i = 0;  i < 20;  ++i) {
+                        CRef<CArgument> arg(new CArgument);
+                        arg->SetName(NStr::NumericToString(i));
+                        arg->SetValue(string(i * 10, 'v'));
+                        web->SetArguments().push_back(arg);
+                        *os << *web;
+                    }
+                }
+                objects = CNcbiOstrstreamToString(ostrs);
+            }
+            vector< CRef<CWeb_Env> > expected;
+            {
+                CNcbiIstrstream istrs(objects.data(), objects.size());
+                for (const CWeb_Env& obj : CObjectIStreamIterator<CWeb_Env>(
+                        *CObjectIStream::Open(formats[f], istrs), eTakeOwnership)) {
+                    CRef<CWeb_Env> copy(new CWeb_Env);
+                    copy->Assign(obj);
+                    expected.push_back(copy);
+                }
+            }
+            BOOST_CHECK_EQUAL(expected.size(), 20U);
+            // one object per raw data buffer, the smallest possible window,
+            // and larger buffers
+            size_t buffer_sizes[] = { 1, 1000 };
+            for (size_t b = 0;  b < ArraySize(buffer_sizes);  ++b) {
+                CNcbiIstrstream istrs(objects.data(), objects.size());
+                size_t count = 0;
+                for (CWeb_Env& obj : CObjectIStreamAsyncIterator<CWeb_Env>(
+                        *CObjectIStream::Open(formats[f], istrs), eTakeOwnership,
+                        CObjectIStreamAsyncIterator<CWeb_Env>::CParams().Pipeline(true).
+                            MinRawBufferSize(buffer_sizes[b]).
+                            MaxTotalRawSize(buffer_sizes[b]).MaxParserThreads(2))) {
+                    BOOST_REQUIRE(count < expected.size());
+                    BOOST_CHECK(obj.Equals(*expected[count]));
+                    ++count;
+                }
+                BOOST_CHECK_EQUAL(count, expected.size());
+            }
+        }
+    }
+    // pipeline mode with exception transfer
+    {
+        CNcbiIstrstream istrs(buf);
+        // generates NCBI exception (wrong format)
+        bool gotit = false;
+        try {
+            for (CTestSerialObject& obj : CObjectIStreamAsyncIterator<CTestSerialObject>(
+                *CObjectIStream::Open(eSerial_AsnBinary, istrs), eTakeOwnership,
+                CObjectIStreamAsyncIterator<CTestSerialObject>::CParams().Pipeline(true))) {
+                cout << MSerial_AsnText << obj << endl;
+            }
+        } catch (CSerialException& e) {
+            gotit = e.GetErrCode() == CSerialException::eFormatError;
+        } catch (...) {
+        }
+        BOOST_CHECK(gotit);
+    }
     {
         // find serial objects of a specific type
         // process them right here
@@ -9,9 +9,13 @@
 #include <serial/serialasn.hpp>
 #include <serial/objistr.hpp>
 #include <serial/objostr.hpp>
+#include <serial/objistrasnb.hpp>
+#include <serial/objostrasnb.hpp>
+#include <serial/objistrjson.hpp>
 #include <serial/objectio.hpp>
 #include <serial/iterator.hpp>
 #include <serial/objhook.hpp>
+#include <serial/impl/classinfo.hpp>
 #include "cppwebenv.hpp"
 #include <serial/serialimpl.hpp>
 #include <serial/streamiter.hpp>
@@ -21,10 +25,29 @@
 # include "twebenv.h"
 #else
 # include <serial/test/Web_Env.hpp>
+# include <serial/test/Argument.hpp>
+# include <serial/test/Db_Env.hpp>
+# include <serial/test/Db_Clipboard.hpp>
+# include <serial/test/Filter_Value.hpp>
+# include <serial/test/Item_Set.hpp>
+# include <serial/test/Query_History.hpp>
+# include <serial/test/Query_Search.hpp>
+# include <serial/test/Query_Select.hpp>
+# include <serial/test/Query_Related.hpp>
+# include <serial/test/Query_Command.hpp>
+# include <serial/test/Full_Time.hpp>
+# include <serial/test/Time.hpp>
+# include <serial/test/Lazy_Web_Env.hpp>
+# include <serial/test/Lazy_Db_Env.hpp>
+# include <serial/test/Lazy_Argument.hpp>
 #endif
 
 #include <corelib/ncbifile.hpp>
+#include <corelib/ncbitime.hpp>
+#include <corelib/ncbimempool.hpp>
 #include <corelib/test_boost.hpp>
+#include <atomic>
+#include <thread>
 
 /////////////////////////////////////////////////////////////////////////////
 // TestHooks
@@ -42,6 +42,9 @@
 // And include MurmurHash directly
 #include "checksum/murmurhash/MurmurHash2.cxx"
 #include "checksum/murmurhash/MurmurHash3.cxx"
+// xxHash is a header-only library, make all its functions static
+#define XXH_INLINE_ALL
+#include "checksum/xxhash/xxhash.h"
 
 
 #define USE_CRC32C_INTEL // try to use Intel CRC32C instructions
@@ -122,27 +125,76 @@ CChecksumBase::CChecksumBase(const CChecksumBase& other)
     : m_Method(other.m_Method),
       m_CharCount(other.m_CharCount)
 {
-    if ( m_Method == eMD5 ) {
-        m_Value.md5 = new CMD5(*other.m_Value.md5);
-    } else {
-        m_Value.v64 = other.m_Value.v64;
-    }
+    x_Copy(other);
 }
 
 
 CChecksumBase& CChecksumBase::operator= (const CChecksumBase& other)
 {
+    if ( this == &other ) {
+        return *this;
+    }
     x_Free();
 
     m_Method    = other.m_Method;
     m_CharCount = other.m_CharCount;
 
-    if ( m_Method == eMD5 ) {
+    x_Copy(other);
+    return *this;
+}
+
+
+void CChecksumBase::x_Copy(const CChecksumBase& other)
+{
+    switch ( m_Method ) {
+    case eMD5:
         m_Value.md5 = new CMD5(*other.m_Value.md5);
-    } else {
+        break;
+    case eXXH3_64:
+    case eXXH3_128:
+        m_Value.xxh3 = XXH3_createState();
+        if ( !m_Value.xxh3 ) {
+            m_Method = eNone;
+            throw bad_alloc();
+        }
+        XXH3_copyState((XXH3_state_t*)m_Value.xxh3, (const XXH3_state_t*)other.m_Value.xxh3);
+        break;
+    default:
         m_Value.v64 = other.m_Value.v64;
     }
-    return *this;
+}
+
+
+void CChecksumBase::x_Free(void)
+{
+    switch ( m_Method ) {
+    case eMD5:
+        delete m_Value.md5;
+        m_Value.md5 = NULL;
+        break;
+    case eXXH3_64:
+    case eXXH3_128:
+        XXH3_freeState((XXH3_state_t*)m_Value.xxh3);
+        m_Value.xxh3 = NULL;
+        break;
+    default:
+        break;
+    }
+}
+
+
+Uint8 CChecksumBase::x_GetResultXXH3_64(void) const
+{
+    return XXH3_64bits_digest((const XXH3_state_t*)m_Value.xxh3);
+}
+
+
+void CChecksumBase::GetResult128(Uint8& high, Uint8& low) const
+{
+    _ASSERT(m_Method == eXXH3_128);
+    XXH128_hash_t hash = XXH3_128bits_digest((const XXH3_state_t*)m_Value.xxh3);
+    high = hash.high64;
+    low  = hash.low64;
 }
 
 
@@ -151,6 +203,18 @@ string CChecksumBase::GetResultHex(void) const
     switch (m_Method ) {
     case eMD5:
         return m_Value.md5->GetHexSum();
+    case eXXH3_128:
+    {
+        // canonical representation: 32 digits, high part first, as for MD5
+        Uint8 value[2];
+        GetResult128(value[0], value[1]);
+        string hex;
+        for (Uint8 v : value) {
+            string str = NStr::NumericToString(v, 0, 16);
+            hex += string(16 - str.size(), '0') + str;
+        }
+        return NStr::ToLower(hex);
+    }
     default:
         if (GetBits() == 64) {
             return NStr::NumericToString(GetResult64(), 0, 16);
@@ -197,6 +261,19 @@ void CChecksumBase::x_Reset(EMethodDef method)
     case eMD5:
         m_Value.md5 = new CMD5;
         break;
+    case eXXH3_64:
+    case eXXH3_128:
+        m_Value.xxh3 = XXH3_createState();
+        if ( !m_Value.xxh3 ) {
+            m_Method = eNone;
+            throw bad_alloc();
+        }
+        if ( method == eXXH3_64 ) {
+            XXH3_64bits_reset((XXH3_state_t*)m_Value.xxh3);
+        } else {
+            XXH3_128bits_reset((XXH3_state_t*)m_Value.xxh3);
+        }
+        break;
     case eCityHash32:
     case eCityHash64:
     case eFarmHash32:
@@ -320,8 +397,8 @@ bool CChecksum::ValidChecksumLineLong(const char* line, size_t len) const
 
 CNcbiOstream& CChecksum::WriteHexSum(CNcbiOstream& out) const
 {
-    if ( GetMethod() == eMD5 ) {
-        out << m_Value.md5->GetHexSum();
+    if ( GetBits() != 32 ) {
+        out << GetResultHex();
     } else {
         IOS_BASE::fmtflags flags = out.setf(IOS_BASE::hex, IOS_BASE::basefield);
         out << setprecision(8);
@@ -348,6 +425,12 @@ CNcbiOstream& CChecksum::WriteChecksumData(CNcbiOstream& out) const
     case eCRC32C:
         out << "CRC32: ";
         break;
+    case eXXH3_64:
+        out << "XXH3: ";
+        break;
+    case eXXH3_128:
+        out << "XXH128: ";
+        break;
     default:
         _ASSERT(0);
         return out;
@@ -1032,6 +1115,99 @@ Uint8 s_CRC32C(Uint8 checksum, const Uint8* data)
 }
 #endif // HAVE_CRC32C_64
 
+#ifdef HAVE_CRC32C_64
+
+// The hardware CRC32C instruction has latency of 3 cycles but can start
+// every cycle, so long buffers are split into 3 parts that are processed
+// in parallel. Their CRCs are combined by shifting the CRC of the leading
+// part over the length of the next part, i.e. appending that many zero
+// bytes, which is a linear operator in GF(2) and is applied with tables
+// like the byte-wise CRC tables.
+static const size_t kCRC32CLong  = 8192;
+static const size_t kCRC32CShort = 256;
+
+static inline
+Uint4 s_GF2MatrixTimes(const Uint4* mat, Uint4 vec)
+{
+    Uint4 sum = 0;
+    for ( ; vec; vec >>= 1, ++mat ) {
+        if ( vec & 1 ) {
+            sum ^= *mat;
+        }
+    }
+    return sum;
+}
+
+static inline
+void s_GF2MatrixSquare(Uint4* square, const Uint4* mat)
+{
+    for ( size_t n = 0; n < 32; ++n ) {
+        square[n] = s_GF2MatrixTimes(mat, mat[n]);
+    }
+}
+
+struct SCRC32CShift
+{
+    // Build the operator for 'len' zero bytes, 'len' must be a power of 2
+    SCRC32CShift(size_t len)
+    {
+        Uint4 odd[32], even[32];
+        // operator for one zero bit
+        odd[0] = 0x82f63b78; // reversed CRC32C polynomial
+        for ( size_t n = 1; n < 32; ++n ) {
+            odd[n] = Uint4(1) << (n - 1);
+        }
+        s_GF2MatrixSquare(even, odd); // 2 bits
+        s_GF2MatrixSquare(odd, even); // 4 bits
+        const Uint4* op = odd;
+        // square until the operator is for 'len' bytes
+        for ( size_t n = len; n; n >>= 1 ) {
+            if ( op == odd ) {
+                s_GF2MatrixSquare(even, odd);
+                op = even;
+            } else {
+                s_GF2MatrixSquare(odd, even);
+                op = odd;
+            }
+        }
+        for ( Uint4 n = 0; n < 256; ++n ) {
+            m_Table[0][n] = s_GF2MatrixTimes(op, n);
+            m_Table[1][n] = s_GF2MatrixTimes(op, n << 8);
+            m_Table[2][n] = s_GF2MatrixTimes(op, n << 16);
+            m_Table[3][n] = s_GF2MatrixTimes(op, n << 24);
+        }
+    }
+    Uint4 Shift(Uint4 crc) const
+    {
+        return m_Table[0][crc & 0xff] ^ m_Table[1][(crc >> 8) & 0xff] ^
+               m_Table[2][(crc >> 16) & 0xff] ^ m_Table[3][crc >> 24];
+    }
+    Uint4 m_Table[4][256];
+};
+
+static inline
+Uint8 s_UpdateCRC32CIntel3Way(Uint8 crc0, const char*& str, size_t& count,
+                              size_t block, const SCRC32CShift& shift)
+{
+    while ( count >= block * 3 ) {
+        Uint8 crc1 = 0, crc2 = 0;
+        const char* end = str + block;
+        do {
+            crc0 = s_CRC32C(crc0, (const Uint8*)str);
+            crc1 = s_CRC32C(crc1, (const Uint8*)(str + block));
+            crc2 = s_CRC32C(crc2, (const Uint8*)(str + block * 2));
+            str += 8;
+        } while ( str < end );
+        crc0 = shift.Shift(Uint4(crc0)) ^ crc1;
+        crc0 = shift.Shift(Uint4(crc0)) ^ crc2;
+        str   += block * 2;
+        count -= block * 3;
+    }
+    return crc0;
+}
+
+#endif // HAVE_CRC32C_64
+
 static inline
 Uint4 s_UpdateCRC32CIntel(Uint4 checksum, const char *str, size_t count)
 {
@@ -1058,6 +1234,12 @@ Uint4 s_UpdateCRC32CIntel(Uint4 checksum, const char *str, size_t count)
             str += 4;
         }
         Uint8 crc = checksum;
+        if ( count >= kCRC32CShort * 3 ) {
+            static const SCRC32CShift s_Long(kCRC32CLong);
+            static const SCRC32CShift s_Short(kCRC32CShort);
+            crc = s_UpdateCRC32CIntel3Way(crc, str, count, kCRC32CLong, s_Long);
+            crc = s_UpdateCRC32CIntel3Way(crc, str, count, kCRC32CShort, s_Short);
+        }
         while ( count >= 8 ) {
             crc = s_CRC32C(crc, (const Uint8*)str);
             count -= 8;
@@ -1214,6 +1396,12 @@ void CChecksumBase::x_Update(const char* str, size_t count)
             MurmurHash3_x86_32(str, n, (uint32_t)m_Seed, &m_Value.v32);
         }}
         break;
+    case eXXH3_64:
+        XXH3_64bits_update((XXH3_state_t*)m_Value.xxh3, str, count);
+        break;
+    case eXXH3_128:
+        XXH3_128bits_update((XXH3_state_t*)m_Value.xxh3, str, count);
+        break;
     default:
         _ASSERT(0);
         break;
@@ -1221,6 +1409,68 @@ void CChecksumBase::x_Update(const char* str, size_t count)
 }
 
 
+void CChecksum::AddCharsBatch(CChecksum* const checksums[], const CTempString data[], size_t count)
+{
+    vector<CMD5*> md5;
+    vector<CTempString> md5_data;
+#if defined(USE_CRC32C_INTEL)  &&  defined(HAVE_CRC32C_64)
+    vector<size_t> crc32c;
+    bool crc32c_intel = s_IsCRC32CIntelEnabled();
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        CChecksum& sum = *checksums[i];
+        if ( sum.GetMethod() == eMD5 ) {
+            md5.push_back(sum.m_Value.md5);
+            md5_data.push_back(data[i]);
+            sum.m_CharCount += data[i].size();
+            continue;
+        }
+#if defined(USE_CRC32C_INTEL)  &&  defined(HAVE_CRC32C_64)
+        if ( sum.GetMethod() == eCRC32C  &&  crc32c_intel ) {
+            crc32c.push_back(i);
+            continue;
+        }
+#endif
+        sum.AddChars(data[i].data(), data[i].size());
+    }
+    if ( !md5.empty() ) {
+        CMD5::UpdateBatch(md5.data(), md5_data.data(), md5.size());
+    }
+
+#if defined(USE_CRC32C_INTEL)  &&  defined(HAVE_CRC32C_64)
+    // Group buffers of similar size, and process the common part
+    // of each 3 buffers with interleaved instructions
+    sort(crc32c.begin(), crc32c.end(),
+         [data](size_t a, size_t b) { return data[a].size() < data[b].size(); });
+    size_t i = 0;
+    for ( ; i + 3 <= crc32c.size(); i += 3) {
+        const char* str[3];
+        Uint8 crc[3];
+        for (size_t k = 0; k < 3; ++k) {
+            str[k] = data[crc32c[i + k]].data();
+            crc[k] = checksums[crc32c[i + k]]->m_Value.v32;
+        }
+        // sorted by size, so the first one is the shortest
+        size_t common = data[crc32c[i]].size() & ~size_t(7);
+        for (size_t n = 0; n < common; n += 8) {
+            crc[0] = s_CRC32C(crc[0], (const Uint8*)(str[0] + n));
+            crc[1] = s_CRC32C(crc[1], (const Uint8*)(str[1] + n));
+            crc[2] = s_CRC32C(crc[2], (const Uint8*)(str[2] + n));
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            CChecksum& sum = *checksums[crc32c[i + k]];
+            size_t size = data[crc32c[i + k]].size();
+            sum.m_Value.v32 = s_UpdateCRC32CIntel(Uint4(crc[k]), str[k] + common, size - common);
+            sum.m_CharCount += size;
+        }
+    }
+    for ( ; i < crc32c.size(); ++i) {
+        checksums[crc32c[i]]->AddChars(data[crc32c[i]].data(), data[crc32c[i]].size());
+    }
+#endif
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // NHash
@@ -1307,6 +1557,16 @@ Uint4 NHash::MurmurHash3_x86_32(const char* str, size_t len, Uint4 seed)
     return result;
 }
 
+Uint8 NHash::XXHash3_64(const CTempString str, Uint8 seed)
+{
+    return XXH3_64bits_withSeed(str.data(), str.length(), seed);
+}
+
+Uint8 NHash::XXHash3_64(const char* str, size_t len, Uint8 seed)
+{
+    return XXH3_64bits_withSeed(str, len, seed);
+}
+
 
 
 //////////////////////////////////////////////////////////////////////////////
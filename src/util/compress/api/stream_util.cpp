@@ -41,6 +41,9 @@ const ICompression::TFlags kDefault_LZO      = 0;
 #endif
 const ICompression::TFlags kDefault_Zip      = 0;
 const ICompression::TFlags kDefault_GZipFile = CZipCompression::fGZip;
+#if defined(HAVE_LIBZSTD)
+const ICompression::TFlags kDefault_Zstd     = 0;
+#endif
 
 
 // Type of initialization
@@ -117,6 +120,39 @@ CCompressionStreamProcessor* s_Init(EInitType                type,
         }
         break;
 
+    case CCompressStream::eGZipFileMT:
+    case CCompressStream::eBGZF:
+        if (flags == CCompressStream::fDefault) {
+            flags = kDefault_GZipFile;
+        } else {
+            flags |= kDefault_GZipFile;
+        }
+        if (type == eCompress) {
+            if (method == CCompressStream::eBGZF) {
+                processor = new CBGZFStreamCompressor(level, 0, flags);
+            } else {
+                processor = new CZipMTStreamCompressor(level, 0, flags);
+            }
+        } else {
+            processor = new CZipStreamDecompressor(flags);
+        }
+        break;
+
+    case CCompressStream::eZstd:
+#if defined(HAVE_LIBZSTD)
+        if (flags == CCompressStream::fDefault) {
+            flags = kDefault_Zstd;
+        } else {
+            flags |= kDefault_Zstd;
+        }
+        if (type == eCompress) {
+            processor = new CZstdStreamCompressor(level, flags);
+        } else {
+            processor = new CZstdStreamDecompressor(flags);
+        }
+#endif 
+        break;
+
     default:
         NCBI_THROW(CCompressionException, eCompression, 
             "Unknown compression/decompression method");
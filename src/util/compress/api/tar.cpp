@@ -51,6 +51,7 @@
 #endif /*_FORTIFY_SOURCE*/
 #define  _FORTIFY_SOURCE 0
 #include <corelib/ncbi_system.hpp>
+#include <corelib/ncbithr.hpp>
 #include <util/compress/tar.hpp>
 #include <util/error_codes.hpp>
 
@@ -63,6 +64,9 @@
 #  include <grp.h>
 #  include <pwd.h>
 #  include <unistd.h>
+#  ifdef NCBI_OS_LINUX
+#    include <fcntl.h>
+#  endif
 #  ifdef NCBI_OS_IRIX
 #    include <sys/mkdev.h>
 #    if !defined(major)  ||  !defined(minor)  ||  !defined(makedev)
@@ -1295,6 +1299,308 @@ inline void s_SetStateSafe(CNcbiIos& ios, IOS_BASE::iostate state) throw()
 }
 
 
+//////////////////////////////////////////////////////////////////////////////
+//
+// CTarWriteQueue -- write out extracted files in a set of threads
+//
+
+// Max amount of file data pending output
+static const size_t kTarMaxPendingData = 64 << 20;
+// Size of file data pieces handed over to the worker threads
+static const size_t kTarWriteChunkSize =  1 << 20;
+
+
+// Reserve disk space for a file being extracted (best effort only)
+static void s_Preallocate(const CFileIO& file, Uint8 size)
+{
+#ifdef NCBI_OS_LINUX
+    // NB: unlike posix_fallocate(), this never falls back to writing zeros
+    if (size) {
+        (void) fallocate(file.GetFileHandle(), 0, 0, (off_t) size);
+    }
+#endif //NCBI_OS_LINUX
+}
+
+
+// A file being written out
+class CTarOutFile : public CObject
+{
+public:
+    CTarOutFile(const CTarEntryInfo& info, const string& path)
+        : m_Info(info), m_Path(path),
+          m_Pending(0), m_Complete(false), m_Failed(false), m_Errno(0)
+    { }
+
+    CTarEntryInfo m_Info;
+    string        m_Path;
+    CFileIO       m_File;
+    size_t        m_Pending;   // pieces queued but not yet written
+    bool          m_Complete;  // all data have been queued
+    bool          m_Failed;    // write (or close) error occurred
+    int           m_Errno;     // errno of the first error, if known
+};
+
+
+// A piece of file data
+struct STarOutChunk
+{
+    STarOutChunk(CTarOutFile* file, Uint8 offset)
+        : m_File(file), m_Offset(offset)
+    { }
+
+    CRef<CTarOutFile> m_File;
+    Uint8             m_Offset;
+    vector<char>      m_Data;
+};
+
+
+class CTarWriteQueue
+{
+public:
+    CTarWriteQueue(unsigned int threads);
+    ~CTarWriteQueue(void);
+
+    // Create a new file, and preallocate "size" bytes for it.
+    // Throw CFileException on errors.
+    CRef<CTarOutFile> Open(const CTarEntryInfo& info, const string& path,
+                           Uint8 size);
+    // Queue file data at the specified offset (swapped out of "data").
+    // Block while there are too much data pending output.
+    void Write(CTarOutFile* file, Uint8 offset, vector<char>& data);
+    // Mark that no more data will follow for the file.
+    void Close(CTarOutFile* file);
+    // Check whether the path is being written.
+    bool IsBusy(const string& path);
+    // Pick up the files that have been completely written out
+    // (optionally, wait for all files currently open to complete first).
+    void GetDone(list< CRef<CTarOutFile> >& done, bool wait);
+
+    // Thread's main loop
+    void Run(void);
+
+private:
+    class CWorker;
+
+    void x_Write (STarOutChunk* chunk);
+    void x_Finish(CTarOutFile*  file);
+    void x_Fail  (CTarOutFile*  file, int x_errno);
+
+    unsigned int              m_MaxThreads;
+    CFastMutex                m_Mutex;
+    CConditionVariable        m_WorkCond;   // new data queued
+    CConditionVariable        m_SpaceCond;  // pending data decreased
+    CConditionVariable        m_DoneCond;   // a file completed
+    deque<STarOutChunk*>      m_Todo;
+    vector< CRef<CThread> >   m_Threads;
+    size_t                    m_Pending;    // bytes queued, not yet written
+    size_t                    m_Open;       // files not yet completed
+    set<string>               m_Busy;       // paths of those files
+    list< CRef<CTarOutFile> > m_Done;
+    unsigned int              m_Waiting;    // idle threads
+    bool                      m_Stop;
+};
+
+
+class CTarWriteQueue::CWorker : public CThread
+{
+public:
+    CWorker(CTarWriteQueue& queue) : m_Queue(queue) {}
+
+protected:
+    virtual void* Main(void)
+    {
+        m_Queue.Run();
+        return 0;
+    }
+
+private:
+    CTarWriteQueue& m_Queue;
+};
+
+
+CTarWriteQueue::CTarWriteQueue(unsigned int threads)
+    : m_MaxThreads(threads), m_Pending(0), m_Open(0), m_Waiting(0),
+      m_Stop(false)
+{
+#if !defined(NCBI_THREADS)
+    m_MaxThreads = 1;
+#endif
+}
+
+
+CTarWriteQueue::~CTarWriteQueue(void)
+{
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        m_Stop = true;
+        ITERATE(deque<STarOutChunk*>, it, m_Todo) {
+            delete *it;
+        }
+        m_Todo.clear();
+        m_WorkCond.SignalAll();
+    }}
+    NON_CONST_ITERATE(vector< CRef<CThread> >, it, m_Threads) {
+        (*it)->Join();
+    }
+}
+
+
+CRef<CTarOutFile> CTarWriteQueue::Open(const CTarEntryInfo& info,
+                                       const string& path, Uint8 size)
+{
+    CRef<CTarOutFile> file(new CTarOutFile(info, path));
+    file->m_File.Open(path, CFileIO::eCreate, CFileIO::eWrite);
+    s_Preallocate(file->m_File, size);
+    CFastMutexGuard guard(m_Mutex);
+    m_Busy.insert(path);
+    ++m_Open;
+    return file;
+}
+
+
+void CTarWriteQueue::Write(CTarOutFile* file, Uint8 offset,
+                           vector<char>& data)
+{
+    unique_ptr<STarOutChunk> chunk(new STarOutChunk(file, offset));
+    chunk->m_Data.swap(data);
+    if (m_MaxThreads > 1) {
+        CFastMutexGuard guard(m_Mutex);
+        while (m_Pending >= kTarMaxPendingData  &&  !m_Threads.empty()) {
+            m_SpaceCond.WaitForSignal(m_Mutex);
+        }
+#if defined(NCBI_THREADS)
+        // Start more threads only if there is enough work for them
+        if (m_Todo.size() >= m_Waiting  &&  m_Threads.size() < m_MaxThreads) {
+            CRef<CThread> thr(new CWorker(*this));
+            try {
+                thr->Run();
+                m_Threads.push_back(thr);
+            }
+            catch (CThreadException&) {
+                m_MaxThreads = (unsigned int) m_Threads.size();
+            }
+        }
+#endif
+        if ( !m_Threads.empty() ) {
+            m_Pending += chunk->m_Data.size();
+            ++file->m_Pending;
+            m_Todo.push_back(chunk.release());
+            m_WorkCond.SignalSome();
+            return;
+        }
+        // Cannot start any thread, write all data in the current one
+        m_MaxThreads = 1;
+    }
+    x_Write(chunk.get());
+}
+
+
+void CTarWriteQueue::Close(CTarOutFile* file)
+{
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        file->m_Complete = true;
+        if (file->m_Pending) {
+            // The last worker writing the file will finish it
+            return;
+        }
+    }}
+    x_Finish(file);
+}
+
+
+bool CTarWriteQueue::IsBusy(const string& path)
+{
+    CFastMutexGuard guard(m_Mutex);
+    return m_Busy.find(path) != m_Busy.end();
+}
+
+
+void CTarWriteQueue::GetDone(list< CRef<CTarOutFile> >& done, bool wait)
+{
+    CFastMutexGuard guard(m_Mutex);
+    while (wait  &&  m_Open) {
+        m_DoneCond.WaitForSignal(m_Mutex);
+    }
+    done.splice(done.end(), m_Done);
+}
+
+
+void CTarWriteQueue::Run(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    while ( !m_Stop ) {
+        if ( m_Todo.empty() ) {
+            ++m_Waiting;
+            m_WorkCond.WaitForSignal(m_Mutex);
+            --m_Waiting;
+            continue;
+        }
+        unique_ptr<STarOutChunk> chunk(m_Todo.front());
+        m_Todo.pop_front();
+        guard.Release();
+        x_Write(chunk.get());
+        guard.Guard(m_Mutex);
+        CRef<CTarOutFile> file(chunk->m_File);
+        m_Pending -= chunk->m_Data.size();
+        m_SpaceCond.SignalSome();
+        if (!--file->m_Pending  &&  file->m_Complete) {
+            guard.Release();
+            chunk.reset();
+            x_Finish(file);
+            guard.Guard(m_Mutex);
+        }
+    }
+}
+
+
+void CTarWriteQueue::x_Write(STarOutChunk* chunk)
+{
+    if (chunk->m_Data.empty()) {
+        return;
+    }
+    try {
+        chunk->m_File->m_File.WriteAt(chunk->m_Offset, &chunk->m_Data[0],
+                                      chunk->m_Data.size());
+    }
+    catch (CFileErrnoException& e) {
+        x_Fail(chunk->m_File, e.GetErrno());
+    }
+    catch (CException&) {
+        x_Fail(chunk->m_File, 0);
+    }
+}
+
+
+void CTarWriteQueue::x_Finish(CTarOutFile* file)
+{
+    try {
+        file->m_File.Close();
+    }
+    catch (CFileErrnoException& e) {
+        x_Fail(file, e.GetErrno());
+    }
+    catch (CException&) {
+        x_Fail(file, 0);
+    }
+    CFastMutexGuard guard(m_Mutex);
+    m_Done.push_back(CRef<CTarOutFile>(file));
+    m_Busy.erase(file->m_Path);
+    --m_Open;
+    m_DoneCond.SignalAll();
+}
+
+
+void CTarWriteQueue::x_Fail(CTarOutFile* file, int x_errno)
+{
+    CFastMutexGuard guard(m_Mutex);
+    if (!file->m_Failed) {
+        file->m_Failed = true;
+        file->m_Errno  = x_errno;
+    }
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // CTar
@@ -1313,7 +1619,9 @@ CTar::CTar(const string& filename, size_t blocking_factor)
       m_OpenMode(eNone),
       m_Modified(false),
       m_Bad(false),
-      m_Flags(fDefault)
+      m_Flags(fDefault),
+      m_Threads(1),
+      m_WriteQueue(0)
 {
     x_Init();
 }
@@ -1332,7 +1640,9 @@ CTar::CTar(CNcbiIos& stream, size_t blocking_factor)
       m_OpenMode(eNone),
       m_Modified(false),
       m_Bad(false),
-      m_Flags(fDefault)
+      m_Flags(fDefault),
+      m_Threads(1),
+      m_WriteQueue(0)
 {
     x_Init();
 }
@@ -1621,10 +1931,35 @@ void CTar::x_Open(EAction action)
 }
 
 
+void CTar::SetThreads(unsigned int threads)
+{
+#if defined(NCBI_THREADS)
+    m_Threads = threads;
+#else
+    m_Threads = 1;
+#endif
+}
+
+
 unique_ptr<CTar::TEntries> CTar::Extract(void)
 {
     x_Open(eExtract);
-    unique_ptr<TEntries> entries = x_ReadAndProcess(eExtract);
+    unique_ptr<TEntries> entries;
+    unsigned int threads = m_Threads ? m_Threads : GetCpuCount();
+    if (threads > 1) {
+        CTarWriteQueue queue(threads);
+        m_WriteQueue = &queue;
+        try {
+            entries = x_ReadAndProcess(eExtract);
+            x_FlushWrites(true/*wait*/);
+        } catch (...) {
+            m_WriteQueue = 0;
+            throw;
+        }
+        m_WriteQueue = 0;
+    } else {
+        entries = x_ReadAndProcess(eExtract);
+    }
 
     // Restore attributes of "postponed" directory entries
     if (m_Flags & fPreserveAll) {
@@ -3330,6 +3665,11 @@ bool CTar::x_ProcessEntry(EAction action, Uint8 size,
             dst->DereferenceLink();
         }
 
+        // Wait for the destination if it is still being written out
+        if (m_WriteQueue  &&  m_WriteQueue->IsBusy(dst->GetPath())) {
+            x_FlushWrites(true/*wait*/);
+        }
+
         // Actual type in file system (if exists)
         CDirEntry::EType dst_type = dst->GetType();
 
@@ -3537,6 +3877,10 @@ bool CTar::x_ExtractEntry(Uint8& size, const CDirEntry* dst,
 
             if (type == CTarEntryInfo::eHardLink) {
                 _ASSERT(src);
+                if (m_WriteQueue) {
+                    // The source may not have been written out completely
+                    x_FlushWrites(true/*wait*/);
+                }
 #ifdef NCBI_OS_UNIX
                 if (link(src->GetPath().c_str(), dst->GetPath().c_str()) == 0){
                     if (m_Flags & fPreserveAll) {
@@ -3562,6 +3906,10 @@ bool CTar::x_ExtractEntry(Uint8& size, const CDirEntry* dst,
             } else if (type == CTarEntryInfo::eSparseFile  &&  size) {
                 if (!(extracted = x_ExtractSparseFile(size, dst)))
                     break;
+            } else if (m_WriteQueue) {
+                // NB: attributes get restored once the data are written out
+                x_ExtractPlainFileMT(size, dst);
+                break;
             } else {
                 x_ExtractPlainFile(size, dst);
             }
@@ -3748,6 +4096,74 @@ void CTar::x_ExtractPlainFile(Uint8& size, const CDirEntry* dst)
 }
 
 
+void CTar::x_ExtractPlainFileMT(Uint8& size, const CDirEntry* dst)
+{
+    _ASSERT(m_WriteQueue);
+    CRef<CTarOutFile> file;
+    try {
+        file = m_WriteQueue->Open(m_Current, dst->GetPath(), size);
+    } catch (CFileErrnoException& e) {
+        TAR_THROW(this, eCreate,
+                  "Cannot create file '" + dst->GetPath() + '\''
+                  + s_OSReason(e.GetErrno()));
+    }
+    if (m_Flags & fPreserveMode) {  // NB: secure
+        x_RestoreAttrs(m_Current, fPreserveMode,
+                       dst, fTarURead | fTarUWrite);
+    }
+
+    // Read the archive in the current thread, and pass the data over in
+    // large pieces to be written out in the background
+    Uint8 offset = 0;
+    vector<char> chunk;
+    while (size) {
+        size_t nread = size < m_BufferSize ? (size_t) size : m_BufferSize;
+        const char* data = x_ReadArchive(nread);
+        if (!data) {
+            TAR_THROW(this, eRead,
+                      "Unexpected EOF in archive");
+        }
+        _ASSERT(nread);
+        if (chunk.empty()) {
+            chunk.reserve(size < kTarWriteChunkSize
+                          ? (size_t) size : kTarWriteChunkSize);
+        }
+        chunk.insert(chunk.end(), data, data + nread);
+        size        -=            nread;
+        m_StreamPos += ALIGN_SIZE(nread);
+        if (chunk.size() >= kTarWriteChunkSize  ||  !size) {
+            size_t n = chunk.size();
+            m_WriteQueue->Write(file, offset, chunk);
+            offset += n;
+            chunk.clear();
+        }
+    }
+    m_WriteQueue->Close(file);
+
+    x_FlushWrites(false);
+}
+
+
+void CTar::x_FlushWrites(bool wait)
+{
+    _ASSERT(m_WriteQueue);
+    list< CRef<CTarOutFile> > done;
+    m_WriteQueue->GetDone(done, wait);
+    ITERATE(list< CRef<CTarOutFile> >, it, done) {
+        const CTarOutFile& file = **it;
+        if (file.m_Failed) {
+            TAR_THROW(this, eWrite,
+                      "Cannot write file '" + file.m_Path + '\''
+                      + s_OSReason(file.m_Errno));
+        }
+        if (m_Flags & fPreserveAll) {
+            CDirEntry dst(file.m_Path);
+            x_RestoreAttrs(file.m_Info, m_Flags, &dst);
+        }
+    }
+}
+
+
 string CTar::x_ReadLine(Uint8& size, const char*& data, size_t& nread)
 {
     string line;
@@ -4678,4 +5094,138 @@ IReader* CTar::GetNextEntryData(void)
 }
 
 
+unique_ptr<CTar::TIndex> CTar::BuildIndex(void)
+{
+    unique_ptr<TIndex> index(new TIndex);
+    unique_ptr<TEntries> entries = List();
+    // NB: later entries (if updated) override earlier ones of the same name
+    ITERATE(TEntries, e, *entries) {
+        (*index)[e->GetName()] = e->GetPosition(CTarEntryInfo::ePos_Header);
+    }
+    return index;
+}
+
+
+void CTar::WriteIndex(const TIndex& index, CNcbiOstream& os)
+{
+    ITERATE(TIndex, it, index) {
+        os << it->second << ' ' << NStr::PrintableString(it->first) << '\n';
+    }
+    if (!os.flush()) {
+        NCBI_THROW(CTarException, eWrite, "Cannot write index");
+    }
+}
+
+
+unique_ptr<CTar::TIndex> CTar::ReadIndex(CNcbiIstream& is)
+{
+    unique_ptr<TIndex> index(new TIndex);
+    string line;
+    size_t lineno = 0;
+    while (NcbiGetlineEOL(is, line)) {
+        ++lineno;
+        if (line.empty()) {
+            continue;
+        }
+        SIZE_TYPE sp = line.find(' ');
+        Uint8  pos = 0;
+        string name;
+        if (sp != NPOS) {
+            pos = NStr::StringToUInt8(CTempString(line, 0, sp),
+                                      NStr::fConvErr_NoThrow);
+            if (pos  ||  !errno) {
+                name = NStr::ParseEscapes(CTempString(line, sp + 1,
+                                                      line.size() - sp - 1));
+            }
+        }
+        if (name.empty()  ||  OFFSET_OF(pos)) {
+            NCBI_THROW(CTarException, eRead,
+                       "Malformed index at line "
+                       + NStr::NumericToString(lineno));
+        }
+        (*index)[name] = pos;
+    }
+    if (is.bad()) {
+        NCBI_THROW(CTarException, eRead, "Cannot read index");
+    }
+    return index;
+}
+
+
+bool CTar::x_SeekEntry(const TIndex& index, const string& name)
+{
+    TIndex::const_iterator it = index.find(name);
+    if (it == index.end()) {
+        return false;
+    }
+    _ASSERT(!OFFSET_OF(it->second));
+
+    x_Open(eInternal);
+    // Drop any buffered data, and reposition the archive at the record,
+    // which contains the header (so that the records stay aligned)
+    Uint8 record = it->second / m_BufferSize * m_BufferSize;
+    CT_POS_TYPE pos = (CT_POS_TYPE)((CT_OFF_TYPE) record);
+    m_Stream.clear();
+    if (m_Stream.rdbuf()->PUBSEEKPOS(pos) != pos) {
+        TAR_THROW(this, eRead,
+                  "Cannot position archive at entry '" + name + '\'');
+    }
+    m_BufferPos = 0;
+    m_StreamPos = record;
+    x_Skip(BLOCK_OF(it->second - record));
+
+    // Read the entry in disregarding any masks
+    SMask masks[2];
+    swap(masks[eExtractMask], m_Mask[eExtractMask]);
+    swap(masks[eExcludeMask], m_Mask[eExcludeMask]);
+    unique_ptr<TEntries> temp;
+    try {
+        temp = x_ReadAndProcess(eInternal);
+    } catch (...) {
+        swap(masks[eExtractMask], m_Mask[eExtractMask]);
+        swap(masks[eExcludeMask], m_Mask[eExcludeMask]);
+        throw;
+    }
+    swap(masks[eExtractMask], m_Mask[eExtractMask]);
+    swap(masks[eExcludeMask], m_Mask[eExcludeMask]);
+
+    _ASSERT(temp.get()  &&  temp->size() < 2);
+    if (temp->size() < 1  ||  m_Current.GetName() != name) {
+        TAR_THROW(this, eBadName,
+                  "Index is not consistent with archive: no entry '"
+                  + name + "' at block "
+                  + NStr::UInt8ToString(BLOCK_OF(it->second)));
+    }
+    return true;
+}
+
+
+unique_ptr<CTar::TEntries> CTar::Extract(const TIndex& index,
+                                         const string& name)
+{
+    unique_ptr<TEntries> done(new TEntries);
+    if (!x_SeekEntry(index, name)) {
+        return done;
+    }
+    if (m_Current.GetType() == CTarEntryInfo::eSparseFile) {
+        TAR_THROW(this, eUnsupportedEntryType,
+                  "Sparse file cannot be extracted by index");
+    }
+    if (x_ProcessEntry(eExtract, m_Current.GetSize(), 0)) {
+        done->push_back(m_Current);
+        if (m_Current.GetType() == CTarEntryInfo::eDir
+            &&  (m_Flags & fPreserveAll)) {
+            x_RestoreAttrs(m_Current, m_Flags);
+        }
+    }
+    return done;
+}
+
+
+IReader* CTar::GetEntryData(const TIndex& index, const string& name)
+{
+    return x_SeekEntry(index, name) ? GetNextEntryData() : 0;
+}
+
+
 END_NCBI_SCOPE
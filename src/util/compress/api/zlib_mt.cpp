@@ -0,0 +1,1402 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  agent
+ *
+ * File Description:  Multi-threaded gzip and BGZF compression
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbi_limits.h>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbi_system.hpp>
+#include <corelib/ncbithr.hpp>
+#include <corelib/ncbimtx.hpp>
+#include <util/compress/zlib_mt.hpp>
+#include <util/error_codes.hpp>
+#include <zlib.h>
+
+#include <deque>
+
+
+#define NCBI_USE_ERRCODE_X   Util_Compress
+
+BEGIN_NCBI_SCOPE
+
+
+// Macro to check flags
+#define F_ISSET(mask) ((GetFlags() & (mask)) == (mask))
+
+// Identify as Unix by default.
+#ifndef OS_CODE
+#  define OS_CODE 0x03
+#endif
+
+// Size of the window, and maximum size of the preset dictionary
+const size_t kWindowSize = 32*1024;
+
+// Maximum size of uncompressed data in one BGZF block (as in htslib)
+const size_t kBGZFBlockDataSize = 0xFF00;
+// Maximum size of the BGZF block
+const size_t kBGZFMaxBlockSize  = 0x10000;
+// Size of the BGZF block header and footer
+const size_t kBGZFHeaderSize    = 18;
+const size_t kBGZFFooterSize    = 8;
+
+// Empty BGZF block, that marks the end of file
+const char kBGZFEOF[28] = {
+    '\x1f', '\x8b', '\x08', '\x04', '\x00', '\x00', '\x00', '\x00',
+    '\x00', '\xff', '\x06', '\x00', '\x42', '\x43', '\x02', '\x00',
+    '\x1b', '\x00', '\x03', '\x00', '\x00', '\x00', '\x00', '\x00',
+    '\x00', '\x00', '\x00', '\x00'
+};
+
+
+static unsigned int s_GetThreads(unsigned int threads)
+{
+    return threads ? threads : GetCpuCount();
+}
+
+
+static string s_MakeGZipHeader(const CZipCompression::SFileInfo& info)
+{
+    string header(10, '\0');
+    unsigned char flags = 0;
+
+    if ( !info.name.empty() ) {
+        flags |= 0x08;  // ORIG_NAME
+        header.append(info.name.c_str());
+        header += '\0';
+    }
+    if ( !info.comment.empty() ) {
+        flags |= 0x10;  // COMMENT
+        header.append(info.comment.c_str());
+        header += '\0';
+    }
+    header[0] = '\x1f';
+    header[1] = '\x8b';
+    header[2] = Z_DEFLATED;
+    header[3] = flags;
+    /* 4-7 mtime */
+    if ( info.mtime ) {
+        CCompressionUtil::StoreUI4(&header[4], (unsigned long)info.mtime);
+    }
+    /* 8 - xflags == 0*/
+    header[9] = OS_CODE;
+    return header;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CZipMTQueue -- run jobs in a set of threads
+//
+
+// Job processed by one of the queue threads.
+// Job should not throw exceptions, but keep an error state instead.
+class CZipMTJob
+{
+public:
+    CZipMTJob(void) : m_Done(false) {}
+    virtual ~CZipMTJob(void) {}
+    virtual void Run(void) = 0;
+
+private:
+    friend class CZipMTQueue;
+    bool m_Done;  // guarded by queue's mutex
+};
+
+
+class CZipMTQueue
+{
+public:
+    CZipMTQueue(unsigned int threads);
+    ~CZipMTQueue(void);
+
+    unsigned int GetThreads(void) const { return m_MaxThreads; }
+
+    // Add job to the queue. With one thread run it immediately.
+    void Submit(CZipMTJob* job);
+    // Check/wait for job completion.
+    bool IsDone(CZipMTJob* job);
+    void Wait(CZipMTJob* job);
+    // Drop all queued jobs and wait for running ones.
+    void Cancel(void);
+
+    // Thread's main loop
+    void Run(void);
+
+private:
+    class CWorker;
+
+    unsigned int            m_MaxThreads;
+    CFastMutex              m_Mutex;
+    CConditionVariable      m_WorkCond;
+    CConditionVariable      m_DoneCond;
+    deque<CZipMTJob*>       m_Todo;
+    vector< CRef<CThread> > m_Threads;
+    unsigned int            m_Running;  // threads running a job
+    unsigned int            m_Waiting;  // idle threads
+    bool                    m_Stop;
+};
+
+
+class CZipMTQueue::CWorker : public CThread
+{
+public:
+    CWorker(CZipMTQueue& queue) : m_Queue(queue) {}
+
+protected:
+    virtual void* Main(void)
+    {
+        m_Queue.Run();
+        return 0;
+    }
+
+private:
+    CZipMTQueue& m_Queue;
+};
+
+
+CZipMTQueue::CZipMTQueue(unsigned int threads)
+    : m_MaxThreads(threads), m_Running(0), m_Waiting(0), m_Stop(false)
+{
+#if !defined(NCBI_THREADS)
+    m_MaxThreads = 1;
+#endif
+}
+
+
+CZipMTQueue::~CZipMTQueue(void)
+{
+    {{
+        CFastMutexGuard guard(m_Mutex);
+        m_Stop = true;
+        m_Todo.clear();
+        m_WorkCond.SignalAll();
+    }}
+    NON_CONST_ITERATE(vector< CRef<CThread> >, it, m_Threads) {
+        (*it)->Join();
+    }
+}
+
+
+void CZipMTQueue::Submit(CZipMTJob* job)
+{
+    if (m_MaxThreads > 1) {
+        CFastMutexGuard guard(m_Mutex);
+        m_Todo.push_back(job);
+#if defined(NCBI_THREADS)
+        // Start more threads only if there is enough work for them
+        if (m_Todo.size() > m_Waiting  &&  m_Threads.size() < m_MaxThreads) {
+            CRef<CThread> thr(new CWorker(*this));
+            try {
+                thr->Run();
+                m_Threads.push_back(thr);
+            }
+            catch (CThreadException&) {
+                m_MaxThreads = (unsigned int) m_Threads.size();
+            }
+        }
+#endif
+        if ( !m_Threads.empty() ) {
+            m_WorkCond.SignalSome();
+            return;
+        }
+        // Cannot start any thread, process all jobs in the current one
+        m_Todo.pop_back();
+        m_MaxThreads = 1;
+    }
+    job->Run();
+    job->m_Done = true;
+}
+
+
+bool CZipMTQueue::IsDone(CZipMTJob* job)
+{
+    CFastMutexGuard guard(m_Mutex);
+    return job->m_Done;
+}
+
+
+void CZipMTQueue::Wait(CZipMTJob* job)
+{
+    CFastMutexGuard guard(m_Mutex);
+    while ( !job->m_Done ) {
+        m_DoneCond.WaitForSignal(m_Mutex);
+    }
+}
+
+
+void CZipMTQueue::Cancel(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    m_Todo.clear();
+    while ( m_Running ) {
+        m_DoneCond.WaitForSignal(m_Mutex);
+    }
+}
+
+
+void CZipMTQueue::Run(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    while ( !m_Stop ) {
+        if ( m_Todo.empty() ) {
+            ++m_Waiting;
+            m_WorkCond.WaitForSignal(m_Mutex);
+            --m_Waiting;
+            continue;
+        }
+        CZipMTJob* job = m_Todo.front();
+        m_Todo.pop_front();
+        ++m_Running;
+        guard.Release();
+        job->Run();
+        guard.Guard(m_Mutex);
+        job->m_Done = true;
+        --m_Running;
+        m_DoneCond.SignalAll();
+    }
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CZipMTEngine -- split data into blocks, compress them in parallel
+//                 and return compressed data in the original order.
+//
+
+class CZipMTEngine
+{
+public:
+    enum EFormat {
+        eGZip,  // deflate blocks of one gzip member
+        eBGZF   // separate BGZF blocks
+    };
+    CZipMTEngine(EFormat format, unsigned int threads, size_t block_size);
+
+    // Start new compression session
+    void   Reset(int level, int window_bits, int mem_level, int strategy,
+                 CBGZFIndex* index = 0);
+    // Add data to the output as is
+    void   AddOutput(const string& data);
+    // Add data to compress, return number of bytes accepted,
+    // 0 if too many blocks are waiting for output already.
+    size_t Write(const char* buf, size_t len);
+    // Start compression of the current (incomplete) block
+    void   Flush(void);
+    // Start compression of the last block, add format trailer
+    void   Finish(void);
+    // Get compressed data in order, optionally wait for the next
+    // block to be compressed if nothing is ready yet.
+    size_t Read(char* buf, size_t size, bool wait);
+    // TRUE if no data waiting for output
+    bool   IsEmpty(void) const { return m_Jobs.empty(); }
+    // zlib error code of the first failed block
+    int    GetError(void) const { return m_Error; }
+
+private:
+    struct SJob : public CZipMTJob
+    {
+        enum EKind {
+            eData,     // block of data to compress
+            eOutput,   // data for output as is
+            eTrailer   // gzip footer, created on output
+        };
+        SJob(CZipMTEngine& engine, EKind job_kind)
+            : m_Engine(engine), kind(job_kind), in_size(0), crc(0),
+              last(false), errcode(Z_OK)
+        {}
+        virtual void Run(void);
+
+        CZipMTEngine& m_Engine;
+        EKind         kind;
+        string        in;       // data to compress
+        string        dict;     // preset dictionary
+        string        out;      // compressed data
+        size_t        in_size;  // size of compressed data
+        unsigned long crc;      // CRC32 of compressed data
+        bool          last;     // last gzip block
+        int           errcode;  // zlib error code
+    };
+
+    void x_Submit(bool last);
+    int  x_Deflate(const string& in, const string& dict, string& out,
+                   int level, int flush);
+    void x_CompressGZip(SJob& job);
+    void x_CompressBGZF(SJob& job);
+
+private:
+    EFormat      m_Format;
+    size_t       m_BlockSize;   // max size of the data block
+    size_t       m_MaxJobs;     // max number of blocks waiting for output
+    int          m_Level;       // compression parameters
+    int          m_WindowBits;
+    int          m_MemLevel;
+    int          m_Strategy;
+    CBGZFIndex*  m_Index;       // index to collect BGZF block offsets
+
+    string       m_Block;       // current data block
+    string       m_History;     // last 32KB of data (gzip dictionary)
+    bool         m_Finished;    // last block is submitted
+    deque< unique_ptr<SJob> > m_Jobs;  // blocks in output order
+    size_t       m_OutPos;      // output position in the first block
+    unsigned long m_CRC;        // CRC32 of all output blocks
+    Uint8        m_InSize;      // size of uncompressed output data
+    Uint8        m_OutSize;     // size of output
+    int          m_Error;       // zlib error code, Z_OK if none
+
+    // Should go last, to stop threads before destroying jobs
+    CZipMTQueue  m_Queue;
+};
+
+
+CZipMTEngine::CZipMTEngine(EFormat format, unsigned int threads,
+                           size_t block_size)
+    : m_Format(format),
+      m_Level(Z_DEFAULT_COMPRESSION), m_WindowBits(MAX_WBITS),
+      m_MemLevel(8), m_Strategy(Z_DEFAULT_STRATEGY), m_Index(0),
+      m_Finished(false), m_OutPos(0), m_CRC(0), m_InSize(0), m_OutSize(0),
+      m_Error(Z_OK),
+      m_Queue(s_GetThreads(threads))
+{
+    if (format == eBGZF) {
+        m_BlockSize = kBGZFBlockDataSize;
+    } else {
+        // Avoid too small blocks, and limit size to the zlib's uInt
+        m_BlockSize = max(block_size, kWindowSize);
+        m_BlockSize = min(m_BlockSize, (size_t)kMax_Int);
+    }
+    // Some blocks are compressed while others are waiting for output
+    unsigned int n = m_Queue.GetThreads();
+    m_MaxJobs = n > 1 ? n * 4 : 2;
+}
+
+
+void CZipMTEngine::Reset(int level, int window_bits, int mem_level,
+                         int strategy, CBGZFIndex* index)
+{
+    m_Queue.Cancel();
+    m_Jobs.clear();
+    m_Level      = level;
+    m_WindowBits = window_bits;
+    m_MemLevel   = mem_level;
+    m_Strategy   = strategy;
+    m_Index      = index;
+    if ( m_Index ) {
+        m_Index->Clear();
+    }
+    m_Block.erase();
+    m_History.erase();
+    m_Finished = false;
+    m_OutPos   = 0;
+    m_CRC      = crc32(0L, Z_NULL, 0);
+    m_InSize   = 0;
+    m_OutSize  = 0;
+    m_Error    = Z_OK;
+}
+
+
+void CZipMTEngine::AddOutput(const string& data)
+{
+    unique_ptr<SJob> job(new SJob(*this, SJob::eOutput));
+    job->out = data;
+    CZipMTJob* p = job.get();
+    m_Jobs.push_back(std::move(job));
+    m_Queue.Submit(p);
+}
+
+
+size_t CZipMTEngine::Write(const char* buf, size_t len)
+{
+    _ASSERT(!m_Finished);
+    size_t n = 0;
+    while (n < len) {
+        if (m_Block.size() == m_BlockSize) {
+            if (m_Jobs.size() >= m_MaxJobs) {
+                break;
+            }
+            x_Submit(false);
+        }
+        if ( m_Block.empty() ) {
+            m_Block.reserve(m_BlockSize);
+        }
+        size_t k = min(len - n, m_BlockSize - m_Block.size());
+        m_Block.append(buf + n, k);
+        n += k;
+    }
+    return n;
+}
+
+
+void CZipMTEngine::Flush(void)
+{
+    if ( !m_Block.empty() ) {
+        x_Submit(false);
+    }
+}
+
+
+void CZipMTEngine::Finish(void)
+{
+    if ( m_Finished ) {
+        return;
+    }
+    if (m_Format == eGZip) {
+        // Previous blocks are not final, always write the last one
+        x_Submit(true);
+        unique_ptr<SJob> job(new SJob(*this, SJob::eTrailer));
+        CZipMTJob* p = job.get();
+        m_Jobs.push_back(std::move(job));
+        m_Queue.Submit(p);
+    } else {
+        Flush();
+        AddOutput(string(kBGZFEOF, sizeof(kBGZFEOF)));
+    }
+    m_Finished = true;
+}
+
+
+void CZipMTEngine::x_Submit(bool last)
+{
+    unique_ptr<SJob> job(new SJob(*this, SJob::eData));
+    job->in.swap(m_Block);
+    job->last = last;
+    if (m_Format == eGZip) {
+        // Use previous data as a dictionary, and keep the tail
+        // of the current block for the next one
+        job->dict = m_History;
+        const string& in = job->in;
+        if (in.size() >= kWindowSize) {
+            m_History.assign(in, in.size() - kWindowSize, kWindowSize);
+        } else {
+            m_History.append(in);
+            if (m_History.size() > kWindowSize) {
+                m_History.erase(0, m_History.size() - kWindowSize);
+            }
+        }
+    }
+    CZipMTJob* p = job.get();
+    m_Jobs.push_back(std::move(job));
+    m_Queue.Submit(p);
+}
+
+
+size_t CZipMTEngine::Read(char* buf, size_t size, bool wait)
+{
+    size_t n = 0;
+    while (n < size  &&  !m_Jobs.empty()) {
+        SJob* job = m_Jobs.front().get();
+        if ( !m_Queue.IsDone(job) ) {
+            if (!wait  ||  n) {
+                break;
+            }
+            m_Queue.Wait(job);
+        }
+        if (m_OutPos == 0) {
+            // Starting output of the next block
+            if (job->errcode != Z_OK) {
+                m_Error = job->errcode;
+                break;
+            }
+            switch (job->kind) {
+            case SJob::eData:
+                if ( m_Index ) {
+                    m_Index->AddBlock(m_OutSize, m_InSize);
+                }
+                m_CRC = crc32_combine(m_CRC, job->crc, (z_off_t)job->in_size);
+                m_InSize += job->in_size;
+                break;
+            case SJob::eTrailer:
+                job->out.resize(8);
+                CCompressionUtil::StoreUI4(&job->out[0], m_CRC);
+                CCompressionUtil::StoreUI4(&job->out[4],
+                                           (unsigned long)(m_InSize & 0xFFFFFFFFL));
+                break;
+            case SJob::eOutput:
+                break;
+            }
+        }
+        size_t k = min(size - n, job->out.size() - m_OutPos);
+        memcpy(buf + n, job->out.data() + m_OutPos, k);
+        n += k;
+        m_OutPos  += k;
+        m_OutSize += k;
+        if (m_OutPos == job->out.size()) {
+            m_Jobs.pop_front();
+            m_OutPos = 0;
+        }
+    }
+    return n;
+}
+
+
+void CZipMTEngine::SJob::Run(void)
+{
+    if (kind != eData) {
+        return;
+    }
+    try {
+        if (m_Engine.m_Format == CZipMTEngine::eGZip) {
+            m_Engine.x_CompressGZip(*this);
+        } else {
+            m_Engine.x_CompressBGZF(*this);
+        }
+    }
+    catch (...) {
+        errcode = Z_MEM_ERROR;
+    }
+    // Free memory, only size is necessary from now
+    in_size = in.size();
+    string().swap(in);
+    string().swap(dict);
+}
+
+
+int CZipMTEngine::x_Deflate(const string& in, const string& dict, string& out,
+                            int level, int flush)
+{
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    int errcode = deflateInit2(&strm, level, Z_DEFLATED, -m_WindowBits,
+                               m_MemLevel, m_Strategy);
+    if (errcode != Z_OK) {
+        return errcode;
+    }
+    if ( !dict.empty() ) {
+        errcode = deflateSetDictionary(&strm, (const Bytef*)dict.data(),
+                                       (uInt)dict.size());
+    }
+    if (errcode == Z_OK) {
+        // Sync flush adds an empty stored block to the bound
+        size_t out_size = out.size();
+        out.resize(out_size + deflateBound(&strm, (uLong)in.size()) + 16);
+        strm.next_in   = (Bytef*)in.data();
+        strm.avail_in  = (uInt)in.size();
+        strm.next_out  = (Bytef*)&out[out_size];
+        strm.avail_out = (uInt)(out.size() - out_size);
+        for (;;) {
+            errcode = deflate(&strm, flush);
+            if (flush == Z_FINISH ? errcode == Z_STREAM_END
+                                  : errcode == Z_OK  &&  strm.avail_out) {
+                errcode = Z_OK;
+                break;
+            }
+            if ((errcode != Z_OK  &&  errcode != Z_BUF_ERROR)  ||
+                strm.avail_out) {
+                if (errcode == Z_OK) {
+                    errcode = Z_STREAM_ERROR;
+                }
+                break;
+            }
+            // Should not happen, but grow output buffer just in case
+            size_t used = out.size() - strm.avail_out;
+            out.resize(out.size() * 2);
+            strm.next_out  = (Bytef*)&out[used];
+            strm.avail_out = (uInt)(out.size() - used);
+        }
+        out.resize(out.size() - strm.avail_out);
+    }
+    deflateEnd(&strm);
+    return errcode;
+}
+
+
+void CZipMTEngine::x_CompressGZip(SJob& job)
+{
+    job.crc = crc32(0L, (const Bytef*)job.in.data(), (uInt)job.in.size());
+    job.errcode = x_Deflate(job.in, job.dict, job.out, m_Level,
+                            job.last ? Z_FINISH : Z_SYNC_FLUSH);
+}
+
+
+void CZipMTEngine::x_CompressBGZF(SJob& job)
+{
+    _ASSERT(job.in.size() <= kBGZFBlockDataSize);
+    const string kNoDict;
+    job.crc = crc32(0L, (const Bytef*)job.in.data(), (uInt)job.in.size());
+
+    // Header with "BC" extra field, block size is set below
+    static const char kHeader[kBGZFHeaderSize] = {
+        '\x1f', '\x8b', '\x08', '\x04', '\x00', '\x00', '\x00', '\x00',
+        '\x00', '\xff', '\x06', '\x00', '\x42', '\x43', '\x02', '\x00',
+        '\x00', '\x00'
+    };
+    job.out.assign(kHeader, kBGZFHeaderSize);
+    job.errcode = x_Deflate(job.in, kNoDict, job.out, m_Level, Z_FINISH);
+    if (job.errcode == Z_OK  &&
+        job.out.size() + kBGZFFooterSize > kBGZFMaxBlockSize) {
+        // Incompressible data, store it as is -- always fit into a block
+        job.out.assign(kHeader, kBGZFHeaderSize);
+        job.errcode = x_Deflate(job.in, kNoDict, job.out,
+                                Z_NO_COMPRESSION, Z_FINISH);
+    }
+    if (job.errcode != Z_OK) {
+        return;
+    }
+    size_t size = job.out.size();
+    job.out.resize(size + kBGZFFooterSize);
+    CCompressionUtil::StoreUI4(&job.out[size], job.crc);
+    CCompressionUtil::StoreUI4(&job.out[size + 4], (unsigned long)job.in.size());
+    CCompressionUtil::StoreUI2(&job.out[16], (unsigned long)(job.out.size() - 1));
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CZipMTCompressor
+//
+
+CZipMTCompressor::CZipMTCompressor(ELevel level, unsigned int threads,
+                                   size_t block_size, TZipFlags flags)
+    : CZipCompression(level),
+      m_Threads(s_GetThreads(threads)), m_BlockSize(block_size),
+      m_NeedWriteHeader(true)
+{
+    SetFlags(flags | fWriteGZipFormat);
+}
+
+
+CZipMTCompressor::~CZipMTCompressor()
+{
+    return;
+}
+
+
+void CZipMTCompressor::SetFileInfo(const SFileInfo& info)
+{
+    m_FileInfo = info;
+}
+
+
+CCompressionProcessor::EStatus CZipMTCompressor::Init(void)
+{
+    if ( IsBusy() ) {
+        // Abnormal previous session termination
+        End();
+    }
+    // Initialize members
+    Reset();
+    SetBusy();
+    m_NeedWriteHeader = true;
+
+    if ( !m_Engine ) {
+        m_Engine.reset(new CZipMTEngine(CZipMTEngine::eGZip, m_Threads,
+                                        m_BlockSize));
+    }
+    m_Engine->Reset(GetLevel(), m_WindowBits, m_MemLevel, m_Strategy);
+    SetError(Z_OK, zError(Z_OK));
+    return eStatus_Success;
+}
+
+
+CCompressionProcessor::EStatus CZipMTCompressor::Process(
+                      const char* in_buf,  size_t  in_len,
+                      char*       out_buf, size_t  out_size,
+                      /* out */            size_t* in_avail,
+                      /* out */            size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    if (m_NeedWriteHeader  &&  in_len) {
+        m_Engine->AddOutput(s_MakeGZipHeader(m_FileInfo));
+        m_NeedWriteHeader = false;
+    }
+    // Wait for compressed data only if cannot add more input
+    size_t n = m_Engine->Write(in_buf, in_len);
+    *out_avail = m_Engine->Read(out_buf, out_size, !n);
+    *in_avail  = in_len - n;
+    IncreaseProcessedSize(n);
+    IncreaseOutputSize(*out_avail);
+
+    int errcode = m_Engine->GetError();
+    SetError(errcode, zError(errcode));
+    if (errcode == Z_OK) {
+        return eStatus_Success;
+    }
+    ERR_COMPRESS(122, FormatErrorMessage("CZipMTCompressor::Process", GetProcessedSize()));
+    return eStatus_Error;
+}
+
+
+CCompressionProcessor::EStatus CZipMTCompressor::Flush(
+                      char* out_buf, size_t  out_size,
+                      /* out */      size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    // Nothing to flush, don't write header
+    if ( !GetProcessedSize() ) {
+        return eStatus_Success;
+    }
+    m_Engine->Flush();
+    *out_avail = m_Engine->Read(out_buf, out_size, true);
+    IncreaseOutputSize(*out_avail);
+
+    int errcode = m_Engine->GetError();
+    SetError(errcode, zError(errcode));
+    if (errcode == Z_OK) {
+        return m_Engine->IsEmpty() ? eStatus_Success : eStatus_Overflow;
+    }
+    ERR_COMPRESS(123, FormatErrorMessage("CZipMTCompressor::Flush", GetProcessedSize()));
+    return eStatus_Error;
+}
+
+
+CCompressionProcessor::EStatus CZipMTCompressor::Finish(
+                      char* out_buf, size_t  out_size,
+                      /* out */      size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    // Default behavior on empty data -- don't write header/footer
+    if ( !GetProcessedSize()  &&  !F_ISSET(fAllowEmptyData) ) {
+        return eStatus_EndOfData;
+    }
+    if ( m_NeedWriteHeader ) {
+        m_Engine->AddOutput(s_MakeGZipHeader(m_FileInfo));
+        m_NeedWriteHeader = false;
+    }
+    m_Engine->Finish();
+    *out_avail = m_Engine->Read(out_buf, out_size, true);
+    IncreaseOutputSize(*out_avail);
+
+    int errcode = m_Engine->GetError();
+    SetError(errcode, zError(errcode));
+    if (errcode == Z_OK) {
+        return m_Engine->IsEmpty() ? eStatus_EndOfData : eStatus_Overflow;
+    }
+    ERR_COMPRESS(124, FormatErrorMessage("CZipMTCompressor::Finish", GetProcessedSize()));
+    return eStatus_Error;
+}
+
+
+CCompressionProcessor::EStatus CZipMTCompressor::End(int /*abandon*/)
+{
+    // Drop all unwritten data, stop compression of pending blocks
+    if ( m_Engine ) {
+        m_Engine->Reset(GetLevel(), m_WindowBits, m_MemLevel, m_Strategy);
+    }
+    SetBusy(false);
+    return eStatus_Success;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CBGZFCompressor
+//
+
+CBGZFCompressor::CBGZFCompressor(ELevel level, unsigned int threads,
+                                 TZipFlags flags, CBGZFIndex* index)
+    : CZipCompression(level),
+      m_Threads(s_GetThreads(threads)), m_Index(index)
+{
+    SetFlags(flags | fWriteGZipFormat);
+}
+
+
+CBGZFCompressor::~CBGZFCompressor()
+{
+    return;
+}
+
+
+CCompressionProcessor::EStatus CBGZFCompressor::Init(void)
+{
+    if ( IsBusy() ) {
+        // Abnormal previous session termination
+        End();
+    }
+    // Initialize members
+    Reset();
+    SetBusy();
+
+    if ( !m_Engine ) {
+        m_Engine.reset(new CZipMTEngine(CZipMTEngine::eBGZF, m_Threads, 0));
+    }
+    m_Engine->Reset(GetLevel(), m_WindowBits, m_MemLevel, m_Strategy, m_Index);
+    SetError(Z_OK, zError(Z_OK));
+    return eStatus_Success;
+}
+
+
+CCompressionProcessor::EStatus CBGZFCompressor::Process(
+                      const char* in_buf,  size_t  in_len,
+                      char*       out_buf, size_t  out_size,
+                      /* out */            size_t* in_avail,
+                      /* out */            size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    // Wait for compressed data only if cannot add more input
+    size_t n = m_Engine->Write(in_buf, in_len);
+    *out_avail = m_Engine->Read(out_buf, out_size, !n);
+    *in_avail  = in_len - n;
+    IncreaseProcessedSize(n);
+    IncreaseOutputSize(*out_avail);
+
+    int errcode = m_Engine->GetError();
+    SetError(errcode, zError(errcode));
+    if (errcode == Z_OK) {
+        return eStatus_Success;
+    }
+    ERR_COMPRESS(125, FormatErrorMessage("CBGZFCompressor::Process", GetProcessedSize()));
+    return eStatus_Error;
+}
+
+
+CCompressionProcessor::EStatus CBGZFCompressor::Flush(
+                      char* out_buf, size_t  out_size,
+                      /* out */      size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    m_Engine->Flush();
+    *out_avail = m_Engine->Read(out_buf, out_size, true);
+    IncreaseOutputSize(*out_avail);
+
+    int errcode = m_Engine->GetError();
+    SetError(errcode, zError(errcode));
+    if (errcode == Z_OK) {
+        return m_Engine->IsEmpty() ? eStatus_Success : eStatus_Overflow;
+    }
+    ERR_COMPRESS(126, FormatErrorMessage("CBGZFCompressor::Flush", GetProcessedSize()));
+    return eStatus_Error;
+}
+
+
+CCompressionProcessor::EStatus CBGZFCompressor::Finish(
+                      char* out_buf, size_t  out_size,
+                      /* out */      size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    // Default behavior on empty data -- don't write EOF block
+    if ( !GetProcessedSize()  &&  !F_ISSET(fAllowEmptyData) ) {
+        return eStatus_EndOfData;
+    }
+    m_Engine->Finish();
+    *out_avail = m_Engine->Read(out_buf, out_size, true);
+    IncreaseOutputSize(*out_avail);
+
+    int errcode = m_Engine->GetError();
+    SetError(errcode, zError(errcode));
+    if (errcode == Z_OK) {
+        return m_Engine->IsEmpty() ? eStatus_EndOfData : eStatus_Overflow;
+    }
+    ERR_COMPRESS(127, FormatErrorMessage("CBGZFCompressor::Finish", GetProcessedSize()));
+    return eStatus_Error;
+}
+
+
+CCompressionProcessor::EStatus CBGZFCompressor::End(int /*abandon*/)
+{
+    // Drop all unwritten data, stop compression of pending blocks
+    if ( m_Engine ) {
+        m_Engine->Reset(GetLevel(), m_WindowBits, m_MemLevel, m_Strategy);
+    }
+    SetBusy(false);
+    return eStatus_Success;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CBGZFIndex
+//
+
+// Read header of the BGZF block at the specified offset, and return
+// the block size, or 0 at the end of file.
+static size_t s_ReadBGZFBlockSize(const CFileIO& file, Uint8 offset)
+{
+    unsigned char header[12];
+    size_t n = file.ReadAt(offset, header, sizeof(header));
+    if ( !n ) {
+        return 0;
+    }
+    if (n == sizeof(header)  &&
+        header[0] == 0x1f  &&  header[1] == 0x8b  &&
+        header[2] == Z_DEFLATED  &&  (header[3] & 0x04) /* EXTRA_FIELD */) {
+        // Find "BC" subfield with a block size
+        size_t xlen = CCompressionUtil::GetUI2(header + 10);
+        AutoArray<unsigned char> extra(xlen);
+        if (file.ReadAt(offset + sizeof(header), extra.get(), xlen) == xlen) {
+            size_t pos = 0;
+            while (pos + 4 <= xlen) {
+                size_t slen = CCompressionUtil::GetUI2(extra.get() + pos + 2);
+                if (extra[pos] == 'B'  &&  extra[pos+1] == 'C'  &&
+                    slen == 2  &&  pos + 6 <= xlen) {
+                    size_t size = CCompressionUtil::GetUI2(extra.get() + pos + 4) + 1;
+                    if (size >= sizeof(header) + xlen + kBGZFFooterSize) {
+                        return size;
+                    }
+                    break;
+                }
+                pos += 4 + slen;
+            }
+        }
+    }
+    NCBI_THROW(CCompressionException, eCompressionFile,
+               "Wrong BGZF block header in file '" + file.GetPathname() +
+               "' at offset " + NStr::UInt8ToString(offset));
+    /*NOTREACHED*/
+    return 0;
+}
+
+
+void CBGZFIndex::AddBlock(Uint8 compressed, Uint8 uncompressed)
+{
+    _ASSERT(m_Blocks.empty()  ||
+            (m_Blocks.back().compressed   <  compressed  &&
+             m_Blocks.back().uncompressed <= uncompressed));
+    SBlock block = { compressed, uncompressed };
+    m_Blocks.push_back(block);
+}
+
+
+CBGZFIndex::TVirtualOffset CBGZFIndex::GetVirtualOffset(Uint8 uncompressed) const
+{
+    // Find last block that starts at or before the offset
+    size_t lo = 0, hi = m_Blocks.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (m_Blocks[mid].uncompressed <= uncompressed) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    Uint8 block_offset = 0, data_offset = uncompressed;
+    if (lo) {
+        block_offset = m_Blocks[lo - 1].compressed;
+        data_offset  = uncompressed - m_Blocks[lo - 1].uncompressed;
+    }
+    if (data_offset > 0xFFFF) {
+        NCBI_THROW(CCompressionException, eCompression,
+                   "Uncompressed offset " + NStr::UInt8ToString(uncompressed) +
+                   " is out of the indexed BGZF data");
+    }
+    return MakeVirtualOffset(block_offset, (size_t)data_offset);
+}
+
+
+void CBGZFIndex::Build(const string& bgzf_file)
+{
+    CFileIO file;
+    file.Open(bgzf_file, CFileIO::eOpen, CFileIO::eRead);
+    m_Blocks.clear();
+
+    Uint8 offset = 0, uncompressed = 0;
+    size_t size;
+    while ((size = s_ReadBGZFBlockSize(file, offset)) != 0) {
+        // Get uncompressed data size from the block footer
+        unsigned char isize[4];
+        if (file.ReadAt(offset + size - 4, isize, 4) != 4) {
+            NCBI_THROW(CCompressionException, eCompressionFile,
+                       "Truncated BGZF file '" + bgzf_file + "'");
+        }
+        Uint4 data_size = CCompressionUtil::GetUI4(isize);
+        // Skip empty blocks, like EOF marker
+        if (data_size) {
+            AddBlock(offset, uncompressed);
+            uncompressed += data_size;
+        }
+        offset += size;
+    }
+}
+
+
+// .gzi file keeps all numbers as 64-bit little-endian values
+static void s_StoreUI8(unsigned char* buf, Uint8 value)
+{
+    for (int i = 0;  i < 8;  ++i) {
+        buf[i] = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static Uint8 s_GetUI8(const unsigned char* buf)
+{
+    Uint8 value = 0;
+    for (int i = 7;  i >= 0;  --i) {
+        value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+
+void CBGZFIndex::Read(const string& gzi_file)
+{
+    CNcbiIfstream is(gzi_file.c_str(), IOS_BASE::in | IOS_BASE::binary);
+    unsigned char buf[16];
+    if ( !is.read((char*)buf, 8) ) {
+        NCBI_THROW(CCompressionException, eCompressionFile,
+                   "Cannot read BGZF index file '" + gzi_file + "'");
+    }
+    Uint8 count = s_GetUI8(buf);
+    m_Blocks.clear();
+    // The first block at zero offsets is not stored in the file
+    AddBlock(0, 0);
+    for (Uint8 i = 0;  i < count;  ++i) {
+        if ( !is.read((char*)buf, 16) ) {
+            NCBI_THROW(CCompressionException, eCompressionFile,
+                       "Truncated BGZF index file '" + gzi_file + "'");
+        }
+        AddBlock(s_GetUI8(buf), s_GetUI8(buf + 8));
+    }
+}
+
+
+void CBGZFIndex::Write(const string& gzi_file) const
+{
+    CNcbiOfstream os(gzi_file.c_str(), IOS_BASE::out | IOS_BASE::binary);
+    unsigned char buf[16];
+    size_t first = m_Blocks.empty() ? 0 : 1;
+    s_StoreUI8(buf, m_Blocks.size() - first);
+    os.write((char*)buf, 8);
+    for (size_t i = first;  i < m_Blocks.size();  ++i) {
+        s_StoreUI8(buf,     m_Blocks[i].compressed);
+        s_StoreUI8(buf + 8, m_Blocks[i].uncompressed);
+        os.write((char*)buf, 16);
+    }
+    if ( !os.flush() ) {
+        NCBI_THROW(CCompressionException, eCompressionFile,
+                   "Cannot write BGZF index file '" + gzi_file + "'");
+    }
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CBGZFReader
+//
+
+class CBGZFReaderImpl
+{
+public:
+    typedef CBGZFIndex::TVirtualOffset TVirtualOffset;
+
+    CBGZFReaderImpl(const string& file_name, unsigned int threads);
+
+    unsigned int GetThreads(void) const { return m_Queue.GetThreads(); }
+    void SetIndex(const CBGZFIndex& index);
+    void Seek(TVirtualOffset offset);
+    void SeekUncompressed(Uint8 offset);
+    TVirtualOffset Tell(void) const;
+
+    ERW_Result Read(void* buf, size_t count, size_t* bytes_read);
+    ERW_Result PendingCount(size_t* count);
+
+private:
+    struct SJob : public CZipMTJob
+    {
+        SJob(Uint8 block_offset) : offset(block_offset) {}
+        virtual void Run(void);
+
+        Uint8  offset;  // block offset in the file
+        string in;      // compressed block
+        string out;     // uncompressed data
+        string error;   // error description, empty on success
+    };
+
+    void x_ReadAhead(void);
+
+private:
+    string            m_FileName;
+    CFileIO           m_File;
+    CRef<CBGZFIndex>  m_Index;
+    size_t            m_MaxJobs;    // number of blocks to read ahead
+    Uint8             m_NextBlock;  // offset of the next block to read ahead
+    size_t            m_Skip;       // data to skip in the first block
+    size_t            m_Pos;        // read position in the first block
+    deque< unique_ptr<SJob> > m_Jobs;  // blocks in file order
+
+    // Should go last, to stop threads before destroying jobs
+    CZipMTQueue       m_Queue;
+};
+
+
+CBGZFReaderImpl::CBGZFReaderImpl(const string& file_name, unsigned int threads)
+    : m_FileName(file_name),
+      m_NextBlock(0), m_Skip(0), m_Pos(0),
+      m_Queue(s_GetThreads(threads))
+{
+    m_File.Open(file_name, CFileIO::eOpen, CFileIO::eRead);
+    unsigned int n = m_Queue.GetThreads();
+    m_MaxJobs = n > 1 ? n * 4 : 1;
+}
+
+
+void CBGZFReaderImpl::SetIndex(const CBGZFIndex& index)
+{
+    m_Index.Reset(new CBGZFIndex(index));
+}
+
+
+void CBGZFReaderImpl::Seek(TVirtualOffset offset)
+{
+    Uint8 block_offset = CBGZFIndex::GetBlockOffset(offset);
+    if (block_offset > m_File.GetFileSize()) {
+        NCBI_THROW(CCompressionException, eCompressionFile,
+                   "Cannot seek past the end of BGZF file '" + m_FileName + "'");
+    }
+    m_Queue.Cancel();
+    m_Jobs.clear();
+    m_NextBlock = block_offset;
+    m_Skip      = CBGZFIndex::GetDataOffset(offset);
+    m_Pos       = 0;
+}
+
+
+void CBGZFReaderImpl::SeekUncompressed(Uint8 offset)
+{
+    if ( !m_Index ) {
+        m_Index.Reset(new CBGZFIndex());
+        m_Index->Build(m_FileName);
+    }
+    Seek(m_Index->GetVirtualOffset(offset));
+}
+
+
+CBGZFReaderImpl::TVirtualOffset CBGZFReaderImpl::Tell(void) const
+{
+    if ( m_Jobs.empty() ) {
+        return CBGZFIndex::MakeVirtualOffset(m_NextBlock, m_Skip);
+    }
+    return CBGZFIndex::MakeVirtualOffset(m_Jobs.front()->offset, m_Pos + m_Skip);
+}
+
+
+void CBGZFReaderImpl::x_ReadAhead(void)
+{
+    while (m_Jobs.size() < m_MaxJobs) {
+        size_t size = s_ReadBGZFBlockSize(m_File, m_NextBlock);
+        if ( !size ) {
+            break;
+        }
+        unique_ptr<SJob> job(new SJob(m_NextBlock));
+        job->in.resize(size);
+        if (m_File.ReadAt(m_NextBlock, &job->in[0], size) != size) {
+            NCBI_THROW(CCompressionException, eCompressionFile,
+                       "Truncated BGZF file '" + m_FileName + "'");
+        }
+        m_NextBlock += size;
+        SJob* p = job.get();
+        m_Jobs.push_back(std::move(job));
+        m_Queue.Submit(p);
+    }
+}
+
+
+ERW_Result CBGZFReaderImpl::Read(void* buf, size_t count, size_t* bytes_read)
+{
+    size_t n = 0;
+    try {
+        while (n < count) {
+            x_ReadAhead();
+            if ( m_Jobs.empty() ) {
+                break;
+            }
+            SJob* job = m_Jobs.front().get();
+            if ( !m_Queue.IsDone(job) ) {
+                // Return data that we already have
+                if (n) {
+                    break;
+                }
+                m_Queue.Wait(job);
+            }
+            if ( !job->error.empty() ) {
+                NCBI_THROW(CCompressionException, eCompression,
+                           job->error + " in BGZF block at offset " +
+                           NStr::UInt8ToString(job->offset));
+            }
+            if ( m_Skip ) {
+                // First block after Seek()
+                if (m_Skip > job->out.size()) {
+                    NCBI_THROW(CCompressionException, eCompression,
+                               "Wrong virtual offset in BGZF block at offset " +
+                               NStr::UInt8ToString(job->offset));
+                }
+                m_Pos  = m_Skip;
+                m_Skip = 0;
+            }
+            size_t k = min(count - n, job->out.size() - m_Pos);
+            memcpy((char*)buf + n, job->out.data() + m_Pos, k);
+            n     += k;
+            m_Pos += k;
+            if (m_Pos == job->out.size()) {
+                m_Jobs.pop_front();
+                m_Pos = 0;
+            }
+        }
+    }
+    catch (CException& e) {
+        ERR_COMPRESS(128, "[CBGZFReader::Read]  " << e.GetMsg());
+        if ( bytes_read ) {
+            *bytes_read = n;
+        }
+        return n ? eRW_Success : eRW_Error;
+    }
+    if ( bytes_read ) {
+        *bytes_read = n;
+    }
+    return n  ||  !count ? eRW_Success : eRW_Eof;
+}
+
+
+ERW_Result CBGZFReaderImpl::PendingCount(size_t* count)
+{
+    *count = 0;
+    if ( !m_Jobs.empty() ) {
+        SJob* job = m_Jobs.front().get();
+        if (m_Queue.IsDone(job)  &&  job->error.empty()  &&
+            m_Pos + m_Skip < job->out.size()) {
+            *count = job->out.size() - m_Pos - m_Skip;
+        }
+    }
+    return eRW_Success;
+}
+
+
+void CBGZFReaderImpl::SJob::Run(void)
+{
+    try {
+        // Block header and size were checked on reading
+        const unsigned char* block = (const unsigned char*)in.data();
+        size_t xlen = CCompressionUtil::GetUI2(block + 10);
+        size_t data_size = in.size() - 12 - xlen - kBGZFFooterSize;
+        Uint4  crc   = CCompressionUtil::GetUI4(block + in.size() - 8);
+        Uint4  isize = CCompressionUtil::GetUI4(block + in.size() - 4);
+        if (isize > kBGZFMaxBlockSize) {
+            error = "Wrong uncompressed data size";
+            return;
+        }
+        out.resize(isize);
+
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+        int errcode = inflateInit2(&strm, -MAX_WBITS);
+        if (errcode == Z_OK) {
+            strm.next_in   = (Bytef*)block + 12 + xlen;
+            strm.avail_in  = (uInt)data_size;
+            strm.next_out  = (Bytef*)&out[0];
+            strm.avail_out = (uInt)isize;
+            errcode = inflate(&strm, Z_FINISH);
+            if (errcode == Z_STREAM_END) {
+                errcode = strm.total_out == isize ? Z_OK : Z_DATA_ERROR;
+            } else if (errcode == Z_OK  ||  errcode == Z_BUF_ERROR) {
+                errcode = Z_DATA_ERROR;
+            }
+            inflateEnd(&strm);
+        }
+        if (errcode != Z_OK) {
+            error = string("Decompression error: ") + zError(errcode);
+        } else if (crc32(0L, (const Bytef*)out.data(), (uInt)isize) != crc) {
+            error = "CRC32 mismatch";
+        }
+    }
+    catch (exception& e) {
+        error = e.what();
+    }
+    string().swap(in);
+}
+
+
+CBGZFReader::CBGZFReader(const string& file_name, unsigned int threads)
+    : m_Impl(new CBGZFReaderImpl(file_name, threads))
+{
+    return;
+}
+
+
+CBGZFReader::~CBGZFReader()
+{
+    return;
+}
+
+
+void CBGZFReader::SetIndex(const CBGZFIndex& index)
+{
+    m_Impl->SetIndex(index);
+}
+
+
+void CBGZFReader::Seek(TVirtualOffset offset)
+{
+    m_Impl->Seek(offset);
+}
+
+
+void CBGZFReader::SeekUncompressed(Uint8 offset)
+{
+    m_Impl->SeekUncompressed(offset);
+}
+
+
+CBGZFReader::TVirtualOffset CBGZFReader::Tell(void) const
+{
+    return m_Impl->Tell();
+}
+
+
+unsigned int CBGZFReader::GetThreads(void) const
+{
+    return m_Impl->GetThreads();
+}
+
+
+ERW_Result CBGZFReader::Read(void* buf, size_t count, size_t* bytes_read)
+{
+    return m_Impl->Read(buf, count, bytes_read);
+}
+
+
+ERW_Result CBGZFReader::PendingCount(size_t* count)
+{
+    return m_Impl->PendingCount(count);
+}
+
+
+END_NCBI_SCOPE
@@ -0,0 +1,1063 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors:  agent
+ *
+ * File Description:  Zstandard Compression API
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/ncbi_limits.h>
+#include <util/compress/zstd.hpp>
+#include <util/error_codes.hpp>
+
+#define NCBI_USE_ERRCODE_X   Util_Compress
+
+#if defined(HAVE_LIBZSTD)
+
+#include <zstd.h>
+#include <zstd_errors.h>
+#include <zdict.h>
+
+
+BEGIN_NCBI_SCOPE
+
+
+// Macro to check flags
+#define F_ISSET(mask) ((GetFlags() & (mask)) == (mask))
+
+// Get compression/decompression context pointers
+#define CCTX ((ZSTD_CCtx*)m_CCtx)
+#define DCTX ((ZSTD_DCtx*)m_DCtx)
+
+// Limit 'size_t' values to max values of other used types to avoid overflow
+#define LIMIT_SIZE_PARAM_LONG(value)  if (value > (size_t)kMax_Long) value = kMax_Long
+#define LIMIT_SIZE_PARAM_STREAMSIZE(value) \
+    if (value > (size_t)numeric_limits<std::streamsize>::max()) \
+        value = (size_t)numeric_limits<std::streamsize>::max()
+
+// Size of the frame magic number
+const size_t kMagicSize = 4;
+
+
+// Check that the buffer starts with a zstd frame magic number,
+// or with a magic number of the skippable frame.
+// The buffer should have at least 'kMagicSize' bytes.
+static bool s_IsZstdFrame(const void* buf)
+{
+    const unsigned char* p = (const unsigned char*)buf;
+    Uint4 magic = (Uint4)p[0]       | ((Uint4)p[1] << 8) |
+                  ((Uint4)p[2] << 16) | ((Uint4)p[3] << 24);
+    return magic == ZSTD_MAGICNUMBER  ||
+           (magic & ZSTD_MAGIC_SKIPPABLE_MASK) == ZSTD_MAGIC_SKIPPABLE_START;
+}
+
+
+// Convert CCompression level to zstd compression level.
+// zstd have levels [1..ZSTD_maxCLevel()], where levels above 19 need
+// a lot of memory, and are not used here.
+static int s_GetZstdLevel(CCompression::ELevel level)
+{
+    static const int kLevels[] = { 1, 1, 2, 3, 5, 7, 9, 12, 16, 19 };
+    int n = (int)level;
+    if (n < 0  ||  n >= (int)(sizeof(kLevels)/sizeof(kLevels[0]))) {
+        return ZSTD_CLEVEL_DEFAULT;
+    }
+    return kLevels[n];
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CZstdDictionary
+//
+
+
+CZstdDictionary::CZstdDictionary(const void* data, size_t size)
+    : m_Data((const char*)data, size), m_DDict(NULL)
+{
+    return;
+}
+
+
+CZstdDictionary::CZstdDictionary(const string& data)
+    : m_Data(data), m_DDict(NULL)
+{
+    return;
+}
+
+
+CZstdDictionary::~CZstdDictionary(void)
+{
+    ITERATE(TCDicts, it, m_CDicts) {
+        ZSTD_freeCDict((ZSTD_CDict*)it->second);
+    }
+    ZSTD_freeDDict((ZSTD_DDict*)m_DDict);
+    return;
+}
+
+
+CRef<CZstdDictionary> CZstdDictionary::Train(const vector<string>& samples,
+                                             size_t dict_size)
+{
+    // Put all samples into a continuous buffer
+    size_t total = 0;
+    ITERATE(vector<string>, it, samples) {
+        total += it->size();
+    }
+    string buf;
+    buf.reserve(total);
+    vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    ITERATE(vector<string>, it, samples) {
+        buf.append(*it);
+        sizes.push_back(it->size());
+    }
+    return Train(buf.data(), sizes, dict_size);
+}
+
+
+CRef<CZstdDictionary> CZstdDictionary::Train(const void* samples,
+                                             const vector<size_t>& sample_sizes,
+                                             size_t dict_size)
+{
+    if ( !samples  ||  sample_sizes.empty()  ||  !dict_size ) {
+        NCBI_THROW(CCompressionException, eCompression,
+                   "[CZstdDictionary::Train]  No samples to train dictionary");
+    }
+    if ( sample_sizes.size() > (size_t)kMax_UInt ) {
+        NCBI_THROW(CCompressionException, eCompression,
+                   "[CZstdDictionary::Train]  Too many samples");
+    }
+    AutoArray<char> dict(dict_size);
+    size_t res = ZDICT_trainFromBuffer(dict.get(), dict_size,
+                                       samples, &sample_sizes[0],
+                                       (unsigned int)sample_sizes.size());
+    if ( ZDICT_isError(res) ) {
+        NCBI_THROW(CCompressionException, eCompression,
+                   string("[CZstdDictionary::Train]  Cannot train dictionary: ")
+                   + ZDICT_getErrorName(res));
+    }
+    return CRef<CZstdDictionary>(new CZstdDictionary(dict.get(), res));
+}
+
+
+unsigned int CZstdDictionary::GetID(void) const
+{
+    return ZSTD_getDictID_fromDict(m_Data.data(), m_Data.size());
+}
+
+
+void* CZstdDictionary::x_GetCDict(int level) const
+{
+    CFastMutexGuard guard(m_Mutex);
+    TCDicts::const_iterator it = m_CDicts.find(level);
+    if (it != m_CDicts.end()) {
+        return it->second;
+    }
+    void* cdict = ZSTD_createCDict(m_Data.data(), m_Data.size(), level);
+    if ( cdict ) {
+        m_CDicts[level] = cdict;
+    }
+    return cdict;
+}
+
+
+void* CZstdDictionary::x_GetDDict(void) const
+{
+    CFastMutexGuard guard(m_Mutex);
+    if ( !m_DDict ) {
+        m_DDict = ZSTD_createDDict(m_Data.data(), m_Data.size());
+    }
+    return m_DDict;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CZstdCompression
+//
+
+
+CZstdCompression::CZstdCompression(ELevel level, unsigned int workers)
+    : CCompression(level), m_CCtx(NULL), m_DCtx(NULL), m_Workers(workers)
+{
+    return;
+}
+
+
+CZstdCompression::~CZstdCompression(void)
+{
+    ZSTD_freeCCtx(CCTX);
+    ZSTD_freeDCtx(DCTX);
+    return;
+}
+
+
+CVersionInfo CZstdCompression::GetVersion(void) const
+{
+    return CVersionInfo(ZSTD_versionString(), "zstd");
+}
+
+
+CCompression::ELevel CZstdCompression::GetLevel(void) const
+{
+    CCompression::ELevel level = CCompression::GetLevel();
+    // zstd do not support a zero compression level -- make conversion
+    if ( level == eLevel_NoCompression) {
+        return eLevel_Lowest;
+    }
+    return level;
+}
+
+
+void CZstdCompression::SetZstdError(size_t result)
+{
+    SetError((int)ZSTD_getErrorCode(result), ZSTD_getErrorName(result));
+}
+
+
+bool CZstdCompression::InitCompression(const char* where)
+{
+    if ( !m_CCtx ) {
+        m_CCtx = ZSTD_createCCtx();
+        if ( !m_CCtx ) {
+            SetError(ZSTD_error_memory_allocation,
+                     "Cannot create compression context");
+            ERR_COMPRESS(105, FormatErrorMessage(where));
+            return false;
+        }
+    }
+    int level = s_GetZstdLevel(GetLevel());
+
+    size_t res = ZSTD_CCtx_reset(CCTX, ZSTD_reset_session_and_parameters);
+    if ( !ZSTD_isError(res) ) {
+        res = ZSTD_CCtx_setParameter(CCTX, ZSTD_c_compressionLevel, level);
+    }
+    if ( !ZSTD_isError(res) ) {
+        res = ZSTD_CCtx_setParameter(CCTX, ZSTD_c_checksumFlag,
+                                     F_ISSET(fChecksum) ? 1 : 0);
+    }
+    if ( !ZSTD_isError(res)  &&  m_Workers ) {
+        // Fails if the library doesn't support multi-threading,
+        // compress in the current thread in this case.
+        ZSTD_CCtx_setParameter(CCTX, ZSTD_c_nbWorkers, (int)m_Workers);
+    }
+    if ( !ZSTD_isError(res)  &&  m_Dict ) {
+        ZSTD_CDict* cdict = (ZSTD_CDict*)m_Dict->x_GetCDict(level);
+        if ( !cdict ) {
+            SetError(ZSTD_error_dictionaryCreation_failed,
+                     "Cannot create compression dictionary");
+            ERR_COMPRESS(106, FormatErrorMessage(where));
+            return false;
+        }
+        res = ZSTD_CCtx_refCDict(CCTX, cdict);
+    }
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(107, FormatErrorMessage(where));
+        return false;
+    }
+    SetError(0);
+    return true;
+}
+
+
+bool CZstdCompression::InitDecompression(const char* where)
+{
+    if ( !m_DCtx ) {
+        m_DCtx = ZSTD_createDCtx();
+        if ( !m_DCtx ) {
+            SetError(ZSTD_error_memory_allocation,
+                     "Cannot create decompression context");
+            ERR_COMPRESS(108, FormatErrorMessage(where));
+            return false;
+        }
+    }
+    size_t res = ZSTD_DCtx_reset(DCTX, ZSTD_reset_session_and_parameters);
+    if ( !ZSTD_isError(res)  &&  m_Dict ) {
+        ZSTD_DDict* ddict = (ZSTD_DDict*)m_Dict->x_GetDDict();
+        if ( !ddict ) {
+            SetError(ZSTD_error_dictionaryCreation_failed,
+                     "Cannot create decompression dictionary");
+            ERR_COMPRESS(109, FormatErrorMessage(where));
+            return false;
+        }
+        res = ZSTD_DCtx_refDDict(DCTX, ddict);
+    }
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(110, FormatErrorMessage(where));
+        return false;
+    }
+    SetError(0);
+    return true;
+}
+
+
+bool CZstdCompression::CompressBuffer(
+                       const void* src_buf, size_t  src_len,
+                       void*       dst_buf, size_t  dst_size,
+                       /* out */            size_t* dst_len)
+{
+    *dst_len = 0;
+
+    // Check parameters
+    if (!src_len  &&  !F_ISSET(fAllowEmptyData)) {
+        src_buf = NULL;
+    }
+    if (!src_buf || !dst_buf || !dst_len) {
+        SetError(ZSTD_error_GENERIC, "bad argument");
+        ERR_COMPRESS(111, FormatErrorMessage("CZstdCompression::CompressBuffer"));
+        return false;
+    }
+    if ( !InitCompression("CZstdCompression::CompressBuffer") ) {
+        return false;
+    }
+    size_t res = ZSTD_compress2(CCTX, dst_buf, dst_size, src_buf, src_len);
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(112, FormatErrorMessage("CZstdCompression::CompressBuffer"));
+        return false;
+    }
+    *dst_len = res;
+    return true;
+}
+
+
+bool CZstdCompression::DecompressBuffer(
+                       const void* src_buf, size_t  src_len,
+                       void*       dst_buf, size_t  dst_size,
+                       /* out */            size_t* dst_len)
+{
+    *dst_len = 0;
+
+    // Check parameters
+    if ( !src_len ) {
+        if ( F_ISSET(fAllowEmptyData) ) {
+            SetError(0);
+            return true;
+        }
+        src_buf = NULL;
+    }
+    if (!src_buf || !dst_buf || !dst_len) {
+        SetError(ZSTD_error_GENERIC, "bad argument");
+        ERR_COMPRESS(113, FormatErrorMessage("CZstdCompression::DecompressBuffer"));
+        return false;
+    }
+
+    // Not a zstd data, but transparent read is allowed
+    if ( (src_len < kMagicSize  ||  !s_IsZstdFrame(src_buf))  &&
+         F_ISSET(fAllowTransparentRead) ) {
+        *dst_len = (dst_size < src_len) ? dst_size : src_len;
+        memcpy(dst_buf, src_buf, *dst_len);
+        return (dst_size >= src_len);
+    }
+    if ( !InitDecompression("CZstdCompression::DecompressBuffer") ) {
+        return false;
+    }
+    // Decompress all frames in the buffer
+    size_t res = ZSTD_decompressDCtx(DCTX, dst_buf, dst_size, src_buf, src_len);
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(114, FormatErrorMessage("CZstdCompression::DecompressBuffer"));
+        return false;
+    }
+    *dst_len = res;
+    return true;
+}
+
+
+size_t CZstdCompression::EstimateCompressionBufferSize(size_t src_len)
+{
+    return ZSTD_compressBound(src_len);
+}
+
+
+bool CZstdCompression::CompressFile(const string& src_file,
+                                    const string& dst_file,
+                                    size_t        buf_size)
+{
+    CZstdCompressionFile cf(GetLevel(), m_Workers);
+    cf.SetFlags(cf.GetFlags() | GetFlags());
+    cf.SetDictionary(GetDictionary());
+
+    // Open output file
+    if ( !cf.Open(dst_file, CCompressionFile::eMode_Write) ) {
+        SetError(cf.GetErrorCode(), cf.GetErrorDescription());
+        return false;
+    }
+    // Make compression
+    if ( !CCompression::x_CompressFile(src_file, cf, buf_size) ) {
+        if ( cf.GetErrorCode() ) {
+            SetError(cf.GetErrorCode(), cf.GetErrorDescription());
+        }
+        cf.Close();
+        return false;
+    }
+    // Close output file and return result
+    bool status = cf.Close();
+    SetError(cf.GetErrorCode(), cf.GetErrorDescription());
+    return status;
+}
+
+
+bool CZstdCompression::DecompressFile(const string& src_file,
+                                      const string& dst_file,
+                                      size_t        buf_size)
+{
+    CZstdCompressionFile cf(GetLevel());
+    cf.SetFlags(cf.GetFlags() | GetFlags());
+    cf.SetDictionary(GetDictionary());
+
+    // Open output file
+    if ( !cf.Open(src_file, CCompressionFile::eMode_Read) ) {
+        SetError(cf.GetErrorCode(), cf.GetErrorDescription());
+        return false;
+    }
+    // Make decompression
+    if ( !CCompression::x_DecompressFile(cf, dst_file, buf_size) ) {
+        if ( cf.GetErrorCode() ) {
+            SetError(cf.GetErrorCode(), cf.GetErrorDescription());
+        }
+        cf.Close();
+        return false;
+    }
+    // Close output file and return result
+    bool status = cf.Close();
+    SetError(cf.GetErrorCode(), cf.GetErrorDescription());
+    return status;
+}
+
+
+string CZstdCompression::FormatErrorMessage(string where, size_t pos) const
+{
+    string str = "[" + where + "]  " + GetErrorDescription();
+    str += ";  error code = " + NStr::IntToString(GetErrorCode()) +
+           ", number of processed bytes = " + NStr::SizetToString(pos);
+    return str + ".";
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CZstdCompressionFile
+//
+
+
+CZstdCompressionFile::CZstdCompressionFile(
+    const string& file_name, EMode mode, ELevel level, unsigned int workers)
+    : CZstdCompression(level, workers),
+      m_Mode(eMode_Read), m_File(0), m_Stream(0)
+{
+    if ( !Open(file_name, mode) ) {
+        const string smode = (mode == eMode_Read) ? "reading" : "writing";
+        NCBI_THROW(CCompressionException, eCompressionFile,
+                   "[CZstdCompressionFile]  Cannot open file '" + file_name +
+                   "' for " + smode + ".");
+    }
+    return;
+}
+
+
+CZstdCompressionFile::CZstdCompressionFile(ELevel level, unsigned int workers)
+    : CZstdCompression(level, workers),
+      m_Mode(eMode_Read), m_File(0), m_Stream(0)
+{
+    return;
+}
+
+
+CZstdCompressionFile::~CZstdCompressionFile(void)
+{
+    try {
+        Close();
+    }
+    COMPRESS_HANDLE_EXCEPTIONS(115, "CZstdCompressionFile::~CZstdCompressionFile");
+    return;
+}
+
+
+void CZstdCompressionFile::GetStreamError(void)
+{
+    int     errcode;
+    string  errdesc;
+    m_Stream->GetError(CCompressionStream::eRead, errcode, errdesc);
+    SetError(errcode, errdesc);
+}
+
+
+bool CZstdCompressionFile::Open(const string& file_name, EMode mode)
+{
+    m_Mode = mode;
+
+    // Open a file
+    if ( mode == eMode_Read ) {
+        m_File = new CNcbiFstream(file_name.c_str(),
+                                  IOS_BASE::in | IOS_BASE::binary);
+    } else {
+        m_File = new CNcbiFstream(file_name.c_str(),
+                                  IOS_BASE::out | IOS_BASE::binary | IOS_BASE::trunc);
+    }
+    if ( !m_File->good() ) {
+        Close();
+        string description = string("Cannot open file '") + file_name + "'";
+        SetError(-1, description.c_str());
+        return false;
+    }
+
+    // Create compression stream for I/O
+    if ( mode == eMode_Read ) {
+        CZstdDecompressor* decompressor =
+            new CZstdDecompressor(GetFlags(), GetDictionary());
+        CCompressionStreamProcessor* processor =
+            new CCompressionStreamProcessor(
+                decompressor, CCompressionStreamProcessor::eDelete,
+                kCompressionDefaultBufSize, kCompressionDefaultBufSize);
+        m_Stream =
+            new CCompressionIOStream(
+                *m_File, processor, 0, CCompressionStream::fOwnReader);
+    } else {
+        CZstdCompressor* compressor =
+            new CZstdCompressor(GetLevel(), GetFlags(), GetDictionary(),
+                                m_Workers);
+        CCompressionStreamProcessor* processor =
+            new CCompressionStreamProcessor(
+                compressor, CCompressionStreamProcessor::eDelete,
+                kCompressionDefaultBufSize, kCompressionDefaultBufSize);
+        m_Stream =
+            new CCompressionIOStream(
+                *m_File, 0, processor, CCompressionStream::fOwnWriter);
+    }
+    if ( !m_Stream->good() ) {
+        Close();
+        SetError(-1, "Cannot create compression stream");
+        return false;
+    }
+    return true;
+}
+
+
+long CZstdCompressionFile::Read(void* buf, size_t len)
+{
+    LIMIT_SIZE_PARAM_LONG(len);
+    LIMIT_SIZE_PARAM_STREAMSIZE(len);
+
+    if ( !m_Stream  ||  m_Mode != eMode_Read ) {
+        NCBI_THROW(CCompressionException, eCompressionFile,
+            "[CZstdCompressionFile::Read]  File must be opened for reading");
+    }
+    if ( !m_Stream->good() ) {
+        return 0;
+    }
+    m_Stream->read((char*)buf, len);
+    // Check decompression processor status
+    if ( m_Stream->GetStatus(CCompressionStream::eRead)
+         == CCompressionProcessor::eStatus_Error ) {
+        GetStreamError();
+        return -1;
+    }
+    long nread = (long)m_Stream->gcount();
+    if ( nread ) {
+        return nread;
+    }
+    if ( m_Stream->eof() ) {
+        return 0;
+    }
+    GetStreamError();
+    return -1;
+}
+
+
+long CZstdCompressionFile::Write(const void* buf, size_t len)
+{
+    if ( !m_Stream  ||  m_Mode != eMode_Write ) {
+        NCBI_THROW(CCompressionException, eCompressionFile,
+            "[CZstdCompressionFile::Write]  File must be opened for writing");
+    }
+    // Redefine standard behaviour for case of writing zero bytes
+    if (len == 0) {
+        return 0;
+    }
+    LIMIT_SIZE_PARAM_LONG(len);
+    LIMIT_SIZE_PARAM_STREAMSIZE(len);
+
+    m_Stream->write((char*)buf, len);
+    if ( m_Stream->good() ) {
+        return (long)len;
+    }
+    GetStreamError();
+    return -1;
+}
+
+
+bool CZstdCompressionFile::Close(void)
+{
+    // Close compression/decompression stream
+    if ( m_Stream ) {
+        m_Stream->Finalize();
+        GetStreamError();
+        delete m_Stream;
+        m_Stream = 0;
+    }
+    // Close file stream
+    if ( m_File ) {
+        m_File->close();
+        delete m_File;
+        m_File = 0;
+    }
+    return true;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CZstdCompressor
+//
+
+
+CZstdCompressor::CZstdCompressor(ELevel level, TZstdFlags flags,
+                                 CZstdDictionary* dict, unsigned int workers)
+    : CZstdCompression(level, workers)
+{
+    SetFlags(flags);
+    SetDictionary(dict);
+}
+
+
+CZstdCompressor::~CZstdCompressor()
+{
+    if ( IsBusy() ) {
+        // Abnormal session termination
+        End();
+    }
+}
+
+
+CCompressionProcessor::EStatus CZstdCompressor::Init(void)
+{
+    if ( IsBusy() ) {
+        // Abnormal previous session termination
+        End();
+    }
+    // Initialize members
+    Reset();
+    SetBusy();
+    // Prepare compression context for a new frame
+    if ( !InitCompression("CZstdCompressor::Init") ) {
+        return eStatus_Error;
+    }
+    return eStatus_Success;
+}
+
+
+CCompressionProcessor::EStatus CZstdCompressor::Process(
+                      const char* in_buf,  size_t  in_len,
+                      char*       out_buf, size_t  out_size,
+                      /* out */            size_t* in_avail,
+                      /* out */            size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    ZSTD_inBuffer  in  = { in_buf,  in_len,   0 };
+    ZSTD_outBuffer out = { out_buf, out_size, 0 };
+
+    size_t res = ZSTD_compressStream2(CCTX, &out, &in, ZSTD_e_continue);
+    *in_avail  = in_len - in.pos;
+    *out_avail = out.pos;
+    IncreaseProcessedSize(in.pos);
+    IncreaseOutputSize(out.pos);
+
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(116, FormatErrorMessage("CZstdCompressor::Process",
+                                             GetProcessedSize()));
+        return eStatus_Error;
+    }
+    SetError(0);
+    return eStatus_Success;
+}
+
+
+CCompressionProcessor::EStatus CZstdCompressor::Flush(
+                      char* out_buf, size_t  out_size,
+                      /* out */      size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    // Nothing to flush, don't write frame header
+    if ( !GetProcessedSize() ) {
+        return eStatus_Success;
+    }
+    ZSTD_inBuffer  in  = { NULL,    0,        0 };
+    ZSTD_outBuffer out = { out_buf, out_size, 0 };
+    size_t res;
+    do {
+        res = ZSTD_compressStream2(CCTX, &out, &in, ZSTD_e_flush);
+    } while (res  &&  !ZSTD_isError(res)  &&  out.pos < out.size);
+
+    *out_avail = out.pos;
+    IncreaseOutputSize(out.pos);
+
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(117, FormatErrorMessage("CZstdCompressor::Flush",
+                                             GetProcessedSize()));
+        return eStatus_Error;
+    }
+    SetError(0);
+    return res ? eStatus_Overflow : eStatus_Success;
+}
+
+
+CCompressionProcessor::EStatus CZstdCompressor::Finish(
+                      char* out_buf, size_t  out_size,
+                      /* out */      size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    // Default behavior on empty data -- don't write empty frame
+    if ( !GetProcessedSize()  &&  !F_ISSET(fAllowEmptyData) ) {
+        return eStatus_EndOfData;
+    }
+    ZSTD_inBuffer  in  = { NULL,    0,        0 };
+    ZSTD_outBuffer out = { out_buf, out_size, 0 };
+    size_t res;
+    do {
+        res = ZSTD_compressStream2(CCTX, &out, &in, ZSTD_e_end);
+    } while (res  &&  !ZSTD_isError(res)  &&  out.pos < out.size);
+
+    *out_avail = out.pos;
+    IncreaseOutputSize(out.pos);
+
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(118, FormatErrorMessage("CZstdCompressor::Finish",
+                                             GetProcessedSize()));
+        return eStatus_Error;
+    }
+    SetError(0);
+    return res ? eStatus_Overflow : eStatus_EndOfData;
+}
+
+
+CCompressionProcessor::EStatus CZstdCompressor::End(int /*abandon*/)
+{
+    // Drop unfinished frame if any, but keep context for reuse
+    if ( m_CCtx ) {
+        ZSTD_CCtx_reset(CCTX, ZSTD_reset_session_only);
+    }
+    SetBusy(false);
+    return eStatus_Success;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CZstdDecompressor
+//
+
+
+CZstdDecompressor::CZstdDecompressor(TZstdFlags flags, CZstdDictionary* dict)
+    : CZstdCompression(eLevel_Default),
+      m_NeedCheckMagic(true), m_HaveFrame(false)
+{
+    SetFlags(flags);
+    SetDictionary(dict);
+}
+
+
+CZstdDecompressor::~CZstdDecompressor()
+{
+}
+
+
+CCompressionProcessor::EStatus CZstdDecompressor::Init(void)
+{
+    // Initialize members
+    Reset();
+    SetBusy();
+    m_DecompressMode = eMode_Unknown;
+    m_NeedCheckMagic = true;
+    m_HaveFrame      = false;
+    m_Cache.erase();
+    // Prepare decompression context
+    if ( !InitDecompression("CZstdDecompressor::Init") ) {
+        return eStatus_Error;
+    }
+    return eStatus_Success;
+}
+
+
+size_t CZstdDecompressor::x_Decompress(
+                      const char* in_buf,  size_t in_len,   size_t* in_pos,
+                      char*       out_buf, size_t out_size, size_t* out_pos)
+{
+    ZSTD_outBuffer out = { out_buf, out_size, *out_pos };
+    size_t res = 1;
+
+    // Cached magic number goes first
+    if ( !m_Cache.empty() ) {
+        ZSTD_inBuffer in = { m_Cache.data(), m_Cache.size(), 0 };
+        res = ZSTD_decompressStream(DCTX, &out, &in);
+        if ( ZSTD_isError(res) ) {
+            *out_pos = out.pos;
+            return res;
+        }
+        m_Cache.erase(0, in.pos);
+    }
+    if ( m_Cache.empty()  &&  out.pos < out.size ) {
+        ZSTD_inBuffer in = { in_buf, in_len, *in_pos };
+        res = ZSTD_decompressStream(DCTX, &out, &in);
+        *in_pos = in.pos;
+    }
+    *out_pos = out.pos;
+    if ( res == 0 ) {
+        // The frame is completely decoded and flushed,
+        // check for next concatenated frame
+        m_NeedCheckMagic = true;
+        m_HaveFrame = true;
+    }
+    return res;
+}
+
+
+CCompressionProcessor::EStatus CZstdDecompressor::Process(
+                      const char* in_buf,  size_t  in_len,
+                      char*       out_buf, size_t  out_size,
+                      /* out */            size_t* in_avail,
+                      /* out */            size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    size_t in_pos  = 0;
+    size_t out_pos = 0;
+
+    // Check magic number at the beginning of each frame.
+    // It can be split between several input buffers, so cache it.
+    if ( m_NeedCheckMagic  &&  m_DecompressMode != eMode_TransparentRead ) {
+        in_pos = min(kMagicSize - m_Cache.size(), in_len);
+        m_Cache.append(in_buf, in_pos);
+        if ( m_Cache.size() < kMagicSize ) {
+            *in_avail = in_len - in_pos;
+            IncreaseProcessedSize(in_pos);
+            return eStatus_Success;
+        }
+        if ( s_IsZstdFrame(m_Cache.data()) ) {
+            m_DecompressMode = eMode_Decompress;
+            m_NeedCheckMagic = false;
+        } else if ( m_HaveFrame ) {
+            // Not a zstd data after the last frame -- stop here
+            m_Cache.erase();
+            *in_avail = in_len;
+            return eStatus_EndOfData;
+        } else if ( F_ISSET(fAllowTransparentRead) ) {
+            m_DecompressMode = eMode_TransparentRead;
+        } else {
+            SetError(ZSTD_error_prefix_unknown,
+                     ZSTD_getErrorString(ZSTD_error_prefix_unknown));
+            ERR_COMPRESS(119, FormatErrorMessage("CZstdDecompressor::Process",
+                                                 GetProcessedSize()));
+            return eStatus_Error;
+        }
+    }
+
+    // Transparent read
+    if ( m_DecompressMode == eMode_TransparentRead ) {
+        // Cached data goes first
+        out_pos = min(m_Cache.size(), out_size);
+        memcpy(out_buf, m_Cache.data(), out_pos);
+        m_Cache.erase(0, out_pos);
+        if ( m_Cache.empty() ) {
+            size_t n = min(in_len - in_pos, out_size - out_pos);
+            memcpy(out_buf + out_pos, in_buf + in_pos, n);
+            in_pos  += n;
+            out_pos += n;
+        }
+        *in_avail  = in_len - in_pos;
+        *out_avail = out_pos;
+        IncreaseProcessedSize(in_pos);
+        IncreaseOutputSize(out_pos);
+        return eStatus_Success;
+    }
+
+    // Decompress
+    size_t res = x_Decompress(in_buf, in_len, &in_pos, out_buf, out_size, &out_pos);
+    *in_avail  = in_len - in_pos;
+    *out_avail = out_pos;
+    IncreaseProcessedSize(in_pos);
+    IncreaseOutputSize(out_pos);
+
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(119, FormatErrorMessage("CZstdDecompressor::Process",
+                                             GetProcessedSize()));
+        return eStatus_Error;
+    }
+    SetError(0);
+    return (out_pos == out_size) ? eStatus_Overflow : eStatus_Success;
+}
+
+
+CCompressionProcessor::EStatus CZstdDecompressor::Flush(
+                      char* out_buf, size_t  out_size,
+                      /* out */      size_t* out_avail)
+{
+    *out_avail = 0;
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    size_t out_pos = 0;
+
+    switch (m_DecompressMode) {
+    case eMode_TransparentRead:
+        // Flush cached data only
+        out_pos = min(m_Cache.size(), out_size);
+        memcpy(out_buf, m_Cache.data(), out_pos);
+        m_Cache.erase(0, out_pos);
+        *out_avail = out_pos;
+        IncreaseOutputSize(out_pos);
+        return m_Cache.empty() ? eStatus_Success : eStatus_Overflow;
+    case eMode_Decompress:
+        if ( !m_NeedCheckMagic ) {
+            break;
+        }
+        // fall through
+    default:
+        // Nothing to flush
+        return eStatus_Success;
+    }
+
+    size_t in_pos = 0;
+    size_t res = x_Decompress(NULL, 0, &in_pos, out_buf, out_size, &out_pos);
+    *out_avail = out_pos;
+    IncreaseOutputSize(out_pos);
+
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(120, FormatErrorMessage("CZstdDecompressor::Flush",
+                                             GetProcessedSize()));
+        return eStatus_Error;
+    }
+    SetError(0);
+    return (out_pos == out_size) ? eStatus_Overflow : eStatus_Success;
+}
+
+
+CCompressionProcessor::EStatus CZstdDecompressor::Finish(
+                      char* out_buf, size_t  out_size,
+                      /* out */      size_t* out_avail)
+{
+    *out_avail = 0;
+
+    switch (m_DecompressMode) {
+    case eMode_Unknown:
+        // No data, or data is shorter than the frame magic number
+        if ( m_Cache.empty() ) {
+            if ( !F_ISSET(fAllowEmptyData) ) {
+                return eStatus_Error;
+            }
+            return eStatus_EndOfData;
+        }
+        if ( !F_ISSET(fAllowTransparentRead) ) {
+            SetError(ZSTD_error_srcSize_wrong,
+                     ZSTD_getErrorString(ZSTD_error_srcSize_wrong));
+            ERR_COMPRESS(121, FormatErrorMessage("CZstdDecompressor::Finish",
+                                                 GetProcessedSize()));
+            return eStatus_Error;
+        }
+        m_DecompressMode = eMode_TransparentRead;
+        // fall through
+    case eMode_TransparentRead:
+        {{
+            EStatus status = Flush(out_buf, out_size, out_avail);
+            return (status == eStatus_Success) ? eStatus_EndOfData : status;
+        }}
+    default:
+        ;
+    }
+
+    // All frames are decoded, ignore incomplete magic number
+    // of the next frame if any
+    if ( m_NeedCheckMagic ) {
+        return eStatus_EndOfData;
+    }
+    if ( !out_size ) {
+        return eStatus_Overflow;
+    }
+    size_t in_pos  = 0;
+    size_t out_pos = 0;
+    size_t res = x_Decompress(NULL, 0, &in_pos, out_buf, out_size, &out_pos);
+    *out_avail = out_pos;
+    IncreaseOutputSize(out_pos);
+
+    if ( ZSTD_isError(res) ) {
+        SetZstdError(res);
+        ERR_COMPRESS(121, FormatErrorMessage("CZstdDecompressor::Finish",
+                                             GetProcessedSize()));
+        return eStatus_Error;
+    }
+    if ( res == 0 ) {
+        return eStatus_EndOfData;
+    }
+    if ( out_pos ) {
+        return (out_pos == out_size) ? eStatus_Overflow : eStatus_Success;
+    }
+    // Need more input, but there is no more data
+    SetError(ZSTD_error_srcSize_wrong, "Unexpected end of compressed data");
+    ERR_COMPRESS(121, FormatErrorMessage("CZstdDecompressor::Finish",
+                                         GetProcessedSize()));
+    return eStatus_Error;
+}
+
+
+CCompressionProcessor::EStatus CZstdDecompressor::End(int /*abandon*/)
+{
+    if ( m_DCtx ) {
+        ZSTD_DCtx_reset(DCTX, ZSTD_reset_session_only);
+    }
+    m_Cache.erase();
+    SetBusy(false);
+    return eStatus_Success;
+}
+
+
+END_NCBI_SCOPE
+
+#endif  /* HAVE_LIBZSTD */
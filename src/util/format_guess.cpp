@@ -161,6 +161,7 @@ int CFormatGuess::s_CheckOrder[] =
     eGZip,
     eBZip2,
     eLzo,
+    eZstd,
     eSra,
     eRmo,
     eVcf,
@@ -233,7 +234,8 @@ const char* const CFormatGuess::sm_FormatNames[CFormatGuess::eFormat_max] =
     "VCF",
     "UCSC Region",
     "GFF Augustus",
-    "JSON"
+    "JSON",
+    "zstd"
 };
 
 const char*
@@ -516,6 +518,8 @@ bool CFormatGuess::x_TestFormat(EFormat format, EMode mode)
         return TestFormatBZip2( mode );
     case eLzo:
         return TestFormatLzo( mode );
+    case eZstd:
+        return TestFormatZstd( mode );
     case eSra:
         return TestFormatSra( mode );
     case eBam:
@@ -1908,6 +1912,27 @@ CFormatGuess::TestFormatLzo(
 }
 
 
+//  ----------------------------------------------------------------------------
+bool
+CFormatGuess::TestFormatZstd(
+    EMode /* not used */ )
+{
+    if ( ! EnsureTestBuffer()  ||  m_iTestDataSize < 4 ) {
+        return false;
+    }
+    // Little-endian frame magic number 0xFD2FB528,
+    // or skippable frame magic number 0x184D2A5?
+    const unsigned char* p = (const unsigned char*)m_pTestBuffer;
+    if (p[0] == 0x28  &&  p[1] == 0xB5  &&  p[2] == 0x2F  &&  p[3] == 0xFD) {
+        return true;
+    }
+    if ((p[0] & 0xF0) == 0x50  &&  p[1] == 0x2A  &&  p[2] == 0x4D  &&  p[3] == 0x18) {
+        return true;
+    }
+    return false;
+}
+
+
 bool CFormatGuess::TestFormatSra(EMode /* not used */ )
 {
     if ( !EnsureTestBuffer()  ||  m_iTestDataSize < 16
@@ -36,16 +36,83 @@
 #include <util/line_reader.hpp>
 #include <util/util_exception.hpp>
 #include <corelib/ncbifile.hpp>
+#include <corelib/ncbi_system.hpp>
+#include <corelib/ncbithr.hpp>
 #include <corelib/stream_utils.hpp>
 #include <util/error_codes.hpp>
 
 #include <string.h>
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif NCBI_SSE >= 20
+#  include <emmintrin.h>
+#endif
 
 #define NCBI_USE_ERRCODE_X   Util_LineReader
 
 BEGIN_NCBI_SCOPE
 
 
+#if NCBI_SSE >= 20  ||  defined(__AVX2__)
+// Index of the lowest set bit, 'mask' must not be zero
+static inline
+unsigned s_LowestBit(unsigned mask)
+{
+#  if defined(__GNUC__)
+    return (unsigned) __builtin_ctz(mask);
+#  else
+    unsigned n = 0;
+    while ( !(mask & 1) ) {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#  endif
+}
+#endif
+
+
+// Find the first line terminator ('\n' or '\r') in [p, end), or return 0.
+// The vectorized versions are selected at compile time (see NCBI_SSE),
+// the scalar code is used for the tails and on other platforms.
+static inline
+const char* s_FindEOL(const char* p, const char* end)
+{
+#if defined(__AVX2__)
+    const __m256i kLF32 = _mm256_set1_epi8('\n');
+    const __m256i kCR32 = _mm256_set1_epi8('\r');
+    for ( ;  end - p >= 32;  p += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+        __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, kLF32),
+                                     _mm256_cmpeq_epi8(chunk, kCR32));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(eq);
+        if ( mask ) {
+            return p + s_LowestBit(mask);
+        }
+    }
+#endif
+#if NCBI_SSE >= 20
+    const __m128i kLF = _mm_set1_epi8('\n');
+    const __m128i kCR = _mm_set1_epi8('\r');
+    for ( ;  end - p >= 16;  p += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+        __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(chunk, kLF),
+                                  _mm_cmpeq_epi8(chunk, kCR));
+        unsigned mask = (unsigned) _mm_movemask_epi8(eq);
+        if ( mask ) {
+            return p + s_LowestBit(mask);
+        }
+    }
+#endif
+    for ( ;  p < end;  ++p) {
+        if (*p == '\n'  ||  *p == '\r') {
+            return p;
+        }
+    }
+    return 0;
+}
+
+
 CRef<ILineReader> ILineReader::New(const string& filename)
 {
     CRef<ILineReader> lr;
@@ -362,9 +429,10 @@ CMemoryLineReader& CMemoryLineReader::operator++(void)
         /* If after UngetLine(), line is already in buffer, so end is known*/
         p = m_Line.end();
     } else {
-        /* Line is in stream, go char by char until delimiters */
-        while ( p < m_End  &&  *p != '\r'  && *p != '\n' ) {
-            ++p;
+        /* Line is in stream, scan for delimiters */
+        p = s_FindEOL(p, m_End);
+        if ( !p ) {
+            p = m_End;
         }
         m_Line = CTempString(m_Pos, p - m_Pos);
     }
@@ -522,7 +590,8 @@ CBufferedLineReader& CBufferedLineReader::operator++(void)
     // check if we are at the buffer end
     const char* start = m_Pos;
     const char* end = m_End;
-    for ( const char* p = start; p < end; ++p ) {
+    const char* p = s_FindEOL(start, end);
+    if ( p ) {
         if ( *p == '\n' ) {
             m_Line = CTempString(start, p - start);
             m_LastReadSize = p + 1 - start;
@@ -576,37 +645,36 @@ void CBufferedLineReader::x_LoadLong(void)
     while ( x_ReadBuffer() ) {
         start = m_Pos;
         end = m_End;
-        for ( const char* p = start; p < end; ++p ) {
+        const char* p = s_FindEOL(start, end);
+        if ( p ) {
             char c = *p;
-            if ( c == '\r' || c == '\n' ) {
-                m_String.append(start, p - start);
+            m_String.append(start, p - start);
+            m_Line = m_String;
+            m_LastReadSize = m_Line.size() + 1;
+            if ( ++p == end ) {
+                m_String = m_Line;
                 m_Line = m_String;
-                m_LastReadSize = m_Line.size() + 1;
-                if ( ++p == end ) {
-                    m_String = m_Line;
-                    m_Line = m_String;
-                    if ( x_ReadBuffer() ) {
-                        p = m_Pos;
-                        end = m_End;
-                        if ( p < end && c == '\r' && *p == '\n' ) {
-                            ++p;
-                            m_Pos = p;
-                            ++m_LastReadSize;
-                        }
+                if ( x_ReadBuffer() ) {
+                    p = m_Pos;
+                    end = m_End;
+                    if ( p < end && c == '\r' && *p == '\n' ) {
+                        ++p;
+                        m_Pos = p;
+                        ++m_LastReadSize;
                     }
                 }
-                else {
-                    if ( c == '\r' && *p == '\n' ) {
-                        if ( ++p == end ) {
-                            x_ReadBuffer();
-                            p = m_Pos;
-                            ++m_LastReadSize;
-                        }
+            }
+            else {
+                if ( c == '\r' && *p == '\n' ) {
+                    if ( ++p == end ) {
+                        x_ReadBuffer();
+                        p = m_Pos;
+                        ++m_LastReadSize;
                     }
-                    m_Pos = p;
                 }
-                return;
+                m_Pos = p;
             }
+            return;
         }
         m_String.append(start, end - start);
     }
@@ -690,4 +758,405 @@ unsigned int CBufferedLineReader::GetLineNumber(void) const
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//  CLineReadAhead -- fill a ring of buffers from IReader in the background
+//
+
+class CLineReadAhead
+{
+public:
+    // Number of buffers: one is being parsed, the rest are being filled
+    static const size_t kBuffers = 3;
+
+    CLineReadAhead(IReader* reader, size_t buffer_size);
+    ~CLineReadAhead(void);
+
+    // Return the current buffer (if any) for refilling, and get the next
+    // one filled.  Return false when there is no more data.
+    bool Next(const char*& data, size_t& size);
+
+    // Thread's main loop
+    void Run(void);
+
+private:
+    class CFiller;
+
+    // Fill one buffer in, return false at EOF or on error
+    bool x_Fill(size_t index);
+
+    IReader*           m_Reader;
+    size_t             m_BufferSize;
+    AutoArray<char>    m_Memory;
+    char*              m_Data[kBuffers];
+    size_t             m_Size[kBuffers];
+    size_t             m_Current;   // buffer being parsed (kBuffers if none)
+    deque<size_t>      m_Free;      // buffers to be filled
+    deque<size_t>      m_Ready;     // buffers filled and not yet parsed
+    bool               m_Done;      // no more data (EOF or error)
+    bool               m_Error;
+    bool               m_Stop;
+    CFastMutex         m_Mutex;
+    CConditionVariable m_FreeCond;
+    CConditionVariable m_ReadyCond;
+    CRef<CThread>      m_Thread;
+};
+
+
+class CLineReadAhead::CFiller : public CThread
+{
+public:
+    CFiller(CLineReadAhead& ahead) : m_Ahead(ahead) {}
+
+protected:
+    virtual void* Main(void)
+    {
+        m_Ahead.Run();
+        return 0;
+    }
+
+private:
+    CLineReadAhead& m_Ahead;
+};
+
+
+CLineReadAhead::CLineReadAhead(IReader* reader, size_t buffer_size)
+    : m_Reader(reader),
+      m_BufferSize(buffer_size),
+      m_Current(kBuffers),
+      m_Done(false),
+      m_Error(false),
+      m_Stop(false)
+{
+    // Make the buffers page-aligned
+    size_t pagesize = (size_t) GetVirtualMemoryPageSize();
+    if (pagesize < 4096  ||  (pagesize & (pagesize - 1))) {
+        pagesize = 4096;
+    }
+    m_BufferSize = (m_BufferSize + pagesize - 1) & ~(pagesize - 1);
+    m_Memory.reset(new char[kBuffers * m_BufferSize + pagesize]);
+    char* base = m_Memory.get();
+    base += (pagesize - (size_t) base % pagesize) % pagesize;
+    for (size_t i = 0;  i < kBuffers;  ++i) {
+        m_Data[i] = base + i * m_BufferSize;
+        m_Size[i] = 0;
+        m_Free.push_back(i);
+    }
+#if defined(NCBI_THREADS)
+    try {
+        m_Thread.Reset(new CFiller(*this));
+        m_Thread->Run();
+    }
+    catch (CThreadException& e) {
+        ERR_POST_X(1, Info << "CReadAheadLineReader: reading in the"
+                   " current thread due to exception: " << e.what());
+        m_Thread.Reset();
+    }
+#endif
+}
+
+
+CLineReadAhead::~CLineReadAhead(void)
+{
+    if ( m_Thread ) {
+        {{
+            CFastMutexGuard guard(m_Mutex);
+            m_Stop = true;
+            m_FreeCond.SignalAll();
+        }}
+        m_Thread->Join();
+    }
+}
+
+
+bool CLineReadAhead::x_Fill(size_t index)
+{
+    char*  buf  = m_Data[index];
+    size_t size = 0;
+    ERW_Result result = eRW_Success;
+    while (size < m_BufferSize  &&  result != eRW_Eof) {
+        size_t n = 0;
+        result = m_Reader->Read(buf + size, m_BufferSize - size, &n);
+        switch (result) {
+        case eRW_NotImplemented:
+        case eRW_Error:
+            m_Error = true;
+            m_Size[index] = size;
+            return false;
+        case eRW_Timeout:
+            // keep spinning around
+            break;
+        case eRW_Eof:
+        case eRW_Success:
+            size += n;
+            break;
+        default:
+            _ASSERT(0);
+        }
+    }
+    m_Size[index] = size;
+    return result != eRW_Eof;
+}
+
+
+void CLineReadAhead::Run(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    while ( !m_Stop  &&  !m_Done ) {
+        if ( m_Free.empty() ) {
+            m_FreeCond.WaitForSignal(m_Mutex);
+            continue;
+        }
+        size_t index = m_Free.front();
+        m_Free.pop_front();
+        guard.Release();
+        bool more = x_Fill(index);
+        guard.Guard(m_Mutex);
+        if ( m_Size[index] ) {
+            m_Ready.push_back(index);
+        } else {
+            m_Free.push_back(index);
+        }
+        if ( !more ) {
+            m_Done = true;
+        }
+        m_ReadyCond.SignalSome();
+    }
+}
+
+
+bool CLineReadAhead::Next(const char*& data, size_t& size)
+{
+    CFastMutexGuard guard(m_Mutex);
+    if (m_Current < kBuffers) {
+        m_Free.push_back(m_Current);
+        m_Current = kBuffers;
+        m_FreeCond.SignalSome();
+    }
+    if ( !m_Thread ) {
+        // Read synchronously
+        while (m_Ready.empty()  &&  !m_Done) {
+            size_t index = m_Free.front();
+            m_Free.pop_front();
+            if ( !x_Fill(index) ) {
+                m_Done = true;
+            }
+            if ( m_Size[index] ) {
+                m_Ready.push_back(index);
+            } else {
+                m_Free.push_back(index);
+            }
+        }
+    }
+    while (m_Ready.empty()  &&  !m_Done) {
+        m_ReadyCond.WaitForSignal(m_Mutex);
+    }
+    if ( m_Ready.empty() ) {
+        if ( m_Error ) {
+            NCBI_THROW(CIOException, eRead, "Read error");
+        }
+        return false;
+    }
+    m_Current = m_Ready.front();
+    m_Ready.pop_front();
+    data = m_Data[m_Current];
+    size = m_Size[m_Current];
+    return true;
+}
+
+
+CReadAheadLineReader::CReadAheadLineReader(IReader* reader,
+                                           EOwnership ownership,
+                                           size_t buffer_size)
+    : m_Reader(reader, ownership)
+{
+    x_Init(buffer_size);
+}
+
+
+CReadAheadLineReader::CReadAheadLineReader(CNcbiIstream& is,
+                                           EOwnership ownership,
+                                           size_t buffer_size)
+    : m_Reader(new CStreamReader(is, ownership))
+{
+    x_Init(buffer_size);
+}
+
+
+CReadAheadLineReader::CReadAheadLineReader(const string& filename,
+                                           size_t buffer_size)
+    : m_Reader(CFileReader::New(filename))
+{
+    x_Init(buffer_size);
+}
+
+
+CReadAheadLineReader::~CReadAheadLineReader()
+{
+    // Stop the background reading before the reader goes away
+    m_ReadAhead.reset();
+}
+
+
+void CReadAheadLineReader::x_Init(size_t buffer_size)
+{
+    _ASSERT(m_Reader);
+    m_Eof = false;
+    m_UngetLine = false;
+    m_LastReadSize = 0;
+    m_Buffer = m_Pos = m_End = 0;
+    m_InputPos = 0;
+    m_LineNumber = 0;
+    m_ReadAhead.reset(new CLineReadAhead(m_Reader.get(),
+                                         buffer_size ? buffer_size : 1));
+    x_ReadBuffer();
+}
+
+
+bool CReadAheadLineReader::x_ReadBuffer(void)
+{
+    if ( m_Eof ) {
+        return false;
+    }
+    // The current line may still be in the buffer about to be reused
+    if (m_Line.data() >= m_Buffer  &&  m_Line.data() < m_End) {
+        m_String.assign(m_Line.data(), m_Line.size());
+        m_Line = m_String;
+    }
+    m_InputPos += CT_OFF_TYPE(m_End - m_Buffer);
+    size_t size = 0;
+    if ( !m_ReadAhead->Next(m_Buffer, size) ) {
+        m_Eof = true;
+        m_Buffer = m_Pos = m_End = 0;
+        return false;
+    }
+    m_Pos = m_Buffer;
+    m_End = m_Buffer + size;
+    return true;
+}
+
+
+bool CReadAheadLineReader::AtEOF(void) const
+{
+    return m_Eof  &&  !m_UngetLine;
+}
+
+
+char CReadAheadLineReader::PeekChar(void) const
+{
+    _ASSERT(!AtEOF());
+    /* If at EOF - undefined behavior */
+    if (AtEOF()) {
+        return 0;
+    }
+    /* If line was ungot - return its first symbol */
+    if (m_UngetLine) {
+        /* if line is empty - return 0 */
+        if (m_Line.empty()) {
+            return 0;
+        }
+        return *m_Line.begin();
+    }
+    /* If line is empty - return 0 */
+    if (*m_Pos == '\n' || *m_Pos == '\r') {
+        return 0;
+    }
+    return *m_Pos;
+}
+
+
+void CReadAheadLineReader::UngetLine(void)
+{
+    _ASSERT(!m_UngetLine && m_Line.begin());
+    /* If after UngetLine() or after constructor - noop */
+    if (m_UngetLine || m_Line.begin() == NULL)
+        return;
+    --m_LineNumber;
+    m_UngetLine = true;
+}
+
+
+CReadAheadLineReader& CReadAheadLineReader::operator++(void)
+{
+    /* If at EOF - noop */
+    if (AtEOF()) {
+        m_Line = CTempString(NULL);
+        return *this;
+    }
+    ++m_LineNumber;
+    if ( m_UngetLine ) {
+        _ASSERT(m_Line.begin());
+        m_UngetLine = false;
+        return *this;
+    }
+    const char* eol = s_FindEOL(m_Pos, m_End);
+    if ( eol ) {
+        m_Line = CTempString(m_Pos, eol - m_Pos);
+    } else {
+        // The line continues in the next buffer(s)
+        m_Line = CTempString(NULL);
+        m_String.assign(m_Pos, m_End);
+        while ( x_ReadBuffer() ) {
+            eol = s_FindEOL(m_Pos, m_End);
+            m_String.append(m_Pos, (eol ? eol : m_End) - m_Pos);
+            if ( eol ) {
+                break;
+            }
+            m_Pos = m_End;
+        }
+        m_Line = m_String;
+    }
+    m_LastReadSize = m_Line.size();
+    if ( eol ) {
+        // Skip the terminator (CR, LF, or CRLF)
+        m_Pos = eol + 1;
+        ++m_LastReadSize;
+        if ( *eol == '\r' ) {
+            if ( m_Pos == m_End ) {
+                x_ReadBuffer();
+            }
+            if ( m_Pos < m_End  &&  *m_Pos == '\n' ) {
+                ++m_Pos;
+                ++m_LastReadSize;
+            }
+        }
+        if ( m_Pos == m_End ) {
+            x_ReadBuffer();
+        }
+    }
+    return *this;
+}
+
+
+CTempString CReadAheadLineReader::operator*(void) const
+{
+    _ASSERT(!m_UngetLine);
+    /* After UngetLine() - undefined behavior */
+    if (m_UngetLine) {
+        return CTempString(NULL);
+    }
+    /* Right after constructor (m_LineNumber is 0 and UngetLine() was not run,
+    the latter was already checked) - returns NULL */
+    if (m_Line.begin() == NULL) {
+        return CTempString(NULL);
+    }
+    return m_Line;
+}
+
+
+CT_POS_TYPE CReadAheadLineReader::GetPosition(void) const
+{
+    CT_OFF_TYPE offset = m_Pos - m_Buffer;
+    if (m_UngetLine) {
+        offset -= m_LastReadSize;
+    }
+    return m_InputPos + offset;
+}
+
+
+unsigned int CReadAheadLineReader::GetLineNumber(void) const
+{
+    return m_LineNumber;
+}
+
+
 END_NCBI_SCOPE
@@ -34,6 +34,10 @@
 #include <util/md5.hpp>
 #include <util/util_exception.hpp>
 
+#if NCBI_SSE >= 20
+#  include <emmintrin.h>
+#endif
+
 
 BEGIN_NCBI_SCOPE
 
@@ -280,4 +284,219 @@ void CMD5::Transform(void)
 }
 
 
+#if NCBI_SSE >= 20  &&  !defined(WORDS_BIGENDIAN)
+
+// The same core functions and step for 4 independent MD5 computations
+// in SSE2 lanes.
+
+#define F1_4(x, y, z) _mm_xor_si128(z, _mm_and_si128(x, _mm_xor_si128(y, z)))
+#define F2_4(x, y, z) _mm_or_si128(_mm_and_si128(z, x), _mm_andnot_si128(z, y))
+#define F3_4(x, y, z) _mm_xor_si128(x, _mm_xor_si128(y, z))
+#define F4_4(x, y, z) _mm_xor_si128(y, _mm_or_si128(x, _mm_xor_si128(z, _mm_set1_epi32(-1))))
+
+#define MD5STEP4(f, w, x, y, z, data, k, s) \
+        ( w = _mm_add_epi32(w, _mm_add_epi32(f(x, y, z), _mm_add_epi32(data, _mm_set1_epi32(int(k))))), \
+          w = _mm_or_si128(_mm_slli_epi32(w, s), _mm_srli_epi32(w, 32-s)), \
+          w = _mm_add_epi32(w, x) )
+
+// Process one 64-byte block of each lane; state[i] holds word i of all 4 lanes.
+static void s_Transform4(__m128i state[4], const char* const in[4])
+{
+    __m128i W[16];
+    // Transpose the input, so that W[i] holds word i of all 4 blocks
+    for (int g = 0; g < 4; ++g) {
+        __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[0]) + g);
+        __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[1]) + g);
+        __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[2]) + g);
+        __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[3]) + g);
+        __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+        __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+        __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+        __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+        W[g*4 + 0] = _mm_unpacklo_epi64(t0, t1);
+        W[g*4 + 1] = _mm_unpackhi_epi64(t0, t1);
+        W[g*4 + 2] = _mm_unpacklo_epi64(t2, t3);
+        W[g*4 + 3] = _mm_unpackhi_epi64(t2, t3);
+    }
+
+    __m128i a = state[0];
+    __m128i b = state[1];
+    __m128i c = state[2];
+    __m128i d = state[3];
+
+    MD5STEP4(F1_4, a, b, c, d, W[0], 0xd76aa478,  7);
+    MD5STEP4(F1_4, d, a, b, c, W[1], 0xe8c7b756, 12);
+    MD5STEP4(F1_4, c, d, a, b, W[2], 0x242070db, 17);
+    MD5STEP4(F1_4, b, c, d, a, W[3], 0xc1bdceee, 22);
+    MD5STEP4(F1_4, a, b, c, d, W[4], 0xf57c0faf,  7);
+    MD5STEP4(F1_4, d, a, b, c, W[5], 0x4787c62a, 12);
+    MD5STEP4(F1_4, c, d, a, b, W[6], 0xa8304613, 17);
+    MD5STEP4(F1_4, b, c, d, a, W[7], 0xfd469501, 22);
+    MD5STEP4(F1_4, a, b, c, d, W[8], 0x698098d8,  7);
+    MD5STEP4(F1_4, d, a, b, c, W[9], 0x8b44f7af, 12);
+    MD5STEP4(F1_4, c, d, a, b, W[10], 0xffff5bb1, 17);
+    MD5STEP4(F1_4, b, c, d, a, W[11], 0x895cd7be, 22);
+    MD5STEP4(F1_4, a, b, c, d, W[12], 0x6b901122,  7);
+    MD5STEP4(F1_4, d, a, b, c, W[13], 0xfd987193, 12);
+    MD5STEP4(F1_4, c, d, a, b, W[14], 0xa679438e, 17);
+    MD5STEP4(F1_4, b, c, d, a, W[15], 0x49b40821, 22);
+
+    MD5STEP4(F2_4, a, b, c, d, W[1], 0xf61e2562,  5);
+    MD5STEP4(F2_4, d, a, b, c, W[6], 0xc040b340,  9);
+    MD5STEP4(F2_4, c, d, a, b, W[11], 0x265e5a51, 14);
+    MD5STEP4(F2_4, b, c, d, a, W[0], 0xe9b6c7aa, 20);
+    MD5STEP4(F2_4, a, b, c, d, W[5], 0xd62f105d,  5);
+    MD5STEP4(F2_4, d, a, b, c, W[10], 0x02441453,  9);
+    MD5STEP4(F2_4, c, d, a, b, W[15], 0xd8a1e681, 14);
+    MD5STEP4(F2_4, b, c, d, a, W[4], 0xe7d3fbc8, 20);
+    MD5STEP4(F2_4, a, b, c, d, W[9], 0x21e1cde6,  5);
+    MD5STEP4(F2_4, d, a, b, c, W[14], 0xc33707d6,  9);
+    MD5STEP4(F2_4, c, d, a, b, W[3], 0xf4d50d87, 14);
+    MD5STEP4(F2_4, b, c, d, a, W[8], 0x455a14ed, 20);
+    MD5STEP4(F2_4, a, b, c, d, W[13], 0xa9e3e905,  5);
+    MD5STEP4(F2_4, d, a, b, c, W[2], 0xfcefa3f8,  9);
+    MD5STEP4(F2_4, c, d, a, b, W[7], 0x676f02d9, 14);
+    MD5STEP4(F2_4, b, c, d, a, W[12], 0x8d2a4c8a, 20);
+
+    MD5STEP4(F3_4, a, b, c, d, W[5], 0xfffa3942,  4);
+    MD5STEP4(F3_4, d, a, b, c, W[8], 0x8771f681, 11);
+    MD5STEP4(F3_4, c, d, a, b, W[11], 0x6d9d6122, 16);
+    MD5STEP4(F3_4, b, c, d, a, W[14], 0xfde5380c, 23);
+    MD5STEP4(F3_4, a, b, c, d, W[1], 0xa4beea44,  4);
+    MD5STEP4(F3_4, d, a, b, c, W[4], 0x4bdecfa9, 11);
+    MD5STEP4(F3_4, c, d, a, b, W[7], 0xf6bb4b60, 16);
+    MD5STEP4(F3_4, b, c, d, a, W[10], 0xbebfbc70, 23);
+    MD5STEP4(F3_4, a, b, c, d, W[13], 0x289b7ec6,  4);
+    MD5STEP4(F3_4, d, a, b, c, W[0], 0xeaa127fa, 11);
+    MD5STEP4(F3_4, c, d, a, b, W[3], 0xd4ef3085, 16);
+    MD5STEP4(F3_4, b, c, d, a, W[6], 0x04881d05, 23);
+    MD5STEP4(F3_4, a, b, c, d, W[9], 0xd9d4d039,  4);
+    MD5STEP4(F3_4, d, a, b, c, W[12], 0xe6db99e5, 11);
+    MD5STEP4(F3_4, c, d, a, b, W[15], 0x1fa27cf8, 16);
+    MD5STEP4(F3_4, b, c, d, a, W[2], 0xc4ac5665, 23);
+
+    MD5STEP4(F4_4, a, b, c, d, W[0], 0xf4292244,  6);
+    MD5STEP4(F4_4, d, a, b, c, W[7], 0x432aff97, 10);
+    MD5STEP4(F4_4, c, d, a, b, W[14], 0xab9423a7, 15);
+    MD5STEP4(F4_4, b, c, d, a, W[5], 0xfc93a039, 21);
+    MD5STEP4(F4_4, a, b, c, d, W[12], 0x655b59c3,  6);
+    MD5STEP4(F4_4, d, a, b, c, W[3], 0x8f0ccc92, 10);
+    MD5STEP4(F4_4, c, d, a, b, W[10], 0xffeff47d, 15);
+    MD5STEP4(F4_4, b, c, d, a, W[1], 0x85845dd1, 21);
+    MD5STEP4(F4_4, a, b, c, d, W[8], 0x6fa87e4f,  6);
+    MD5STEP4(F4_4, d, a, b, c, W[15], 0xfe2ce6e0, 10);
+    MD5STEP4(F4_4, c, d, a, b, W[6], 0xa3014314, 15);
+    MD5STEP4(F4_4, b, c, d, a, W[13], 0x4e0811a1, 21);
+    MD5STEP4(F4_4, a, b, c, d, W[4], 0xf7537e82,  6);
+    MD5STEP4(F4_4, d, a, b, c, W[11], 0xbd3af235, 10);
+    MD5STEP4(F4_4, c, d, a, b, W[2], 0x2ad7d2bb, 15);
+    MD5STEP4(F4_4, b, c, d, a, W[9], 0xeb86d391, 21);
+
+    state[0] = _mm_add_epi32(state[0], a);
+    state[1] = _mm_add_epi32(state[1], b);
+    state[2] = _mm_add_epi32(state[2], c);
+    state[3] = _mm_add_epi32(state[3], d);
+}
+
+#endif // NCBI_SSE >= 20
+
+
+void CMD5::UpdateBatch(CMD5* const md5[], const CTempString data[], size_t count)
+{
+#if NCBI_SSE >= 20  &&  !defined(WORDS_BIGENDIAN)
+    // Whole blocks of each buffer, to be hashed in lanes
+    struct SJob {
+        CMD5*       md5;
+        const char* ptr;
+        size_t      blocks;
+    };
+    vector<SJob> jobs;
+    for (size_t i = 0; i < count; ++i) {
+        CMD5& m = *md5[i];
+        const char* ptr = data[i].data();
+        size_t length = data[i].size();
+        if ( m.m_Finalized  ||  length < kBlockSize ) {
+            m.Update(ptr, length);
+            continue;
+        }
+        // Complete the pending partial block first
+        size_t head = (size_t)((m.m_Bits >> 3) % kBlockSize);
+        if ( head ) {
+            head = min(length, kBlockSize - head);
+            m.Update(ptr, head);
+            ptr    += head;
+            length -= head;
+        }
+        SJob job = { &m, ptr, length / kBlockSize };
+        if ( job.blocks ) {
+            jobs.push_back(job);
+            m.m_Bits += Int8(job.blocks * kBlockSize) << 3;
+        }
+        // The rest is less than a block, and is only copied to m_In
+        m.Update(ptr + job.blocks * kBlockSize, length % kBlockSize);
+    }
+
+    const size_t kLanes = 4;
+    static const char kDummy[kBlockSize] = { 0 };
+    SJob* lane[kLanes] = { 0 };
+    Uint4 buf[4][kLanes] = { { 0 } };
+    __m128i state[4];
+    size_t next = 0;
+    for (;;) {
+        // Assign the next jobs to free lanes
+        bool active = false;
+        for (size_t l = 0; l < kLanes; ++l) {
+            if ( !lane[l]  &&  next < jobs.size() ) {
+                lane[l] = &jobs[next++];
+                for (size_t w = 0; w < 4; ++w) {
+                    buf[w][l] = lane[l]->md5->m_Buf[w];
+                }
+            }
+            active |= lane[l] != 0;
+        }
+        if ( !active ) {
+            break;
+        }
+        for (size_t w = 0; w < 4; ++w) {
+            state[w] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf[w]));
+        }
+        // Run until the shortest job is done
+        size_t blocks = size_t(-1);
+        for (size_t l = 0; l < kLanes; ++l) {
+            if ( lane[l] ) {
+                blocks = min(blocks, lane[l]->blocks);
+            }
+        }
+        const char* in[kLanes];
+        for (size_t n = 0; n < blocks; ++n) {
+            for (size_t l = 0; l < kLanes; ++l) {
+                in[l] = lane[l] ? lane[l]->ptr + n * kBlockSize : kDummy;
+            }
+            s_Transform4(state, in);
+        }
+        for (size_t w = 0; w < 4; ++w) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(buf[w]), state[w]);
+        }
+        for (size_t l = 0; l < kLanes; ++l) {
+            if ( !lane[l] ) {
+                continue;
+            }
+            lane[l]->ptr    += blocks * kBlockSize;
+            lane[l]->blocks -= blocks;
+            if ( !lane[l]->blocks ) {
+                for (size_t w = 0; w < 4; ++w) {
+                    lane[l]->md5->m_Buf[w] = buf[w][l];
+                }
+                lane[l] = 0;
+            }
+        }
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        md5[i]->Update(data[i].data(), data[i].size());
+    }
+#endif
+}
+
+
 END_NCBI_SCOPE
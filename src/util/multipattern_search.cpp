@@ -30,39 +30,51 @@
  */
 
 #include <ncbi_pch.hpp>
+#include <corelib/ncbifile.hpp>
+#include <corelib/ncbi_system.hpp>
+#include <corelib/ncbithr.hpp>
 #include <util/multipattern_search.hpp>
 #include "multipattern_search_impl.hpp"
+#include <string.h>
+
+#if defined(__SSSE3__)
+#  include <tmmintrin.h>
+#endif
 
 BEGIN_NCBI_SCOPE
 
-CMultipatternSearch::CMultipatternSearch() : m_FSM(new CRegExFSA) {}
-CMultipatternSearch::~CMultipatternSearch() {}
+CMultipatternSearch::CMultipatternSearch() : m_FSM(new CRegExFSA), m_Compiled(nullptr), m_Prefilter(ePrefilter_Auto) {}
+CMultipatternSearch::~CMultipatternSearch() { x_ResetCompiled(); }
 
-void CMultipatternSearch::AddPattern(const char* s, TFlags f) { m_FSM->Add(CRegEx(s, f)); }
+void CMultipatternSearch::AddPattern(const char* s, TFlags f) { CRegExFSA& fsm = x_GetFSM(); x_ResetCompiled(); fsm.Add(CRegEx(s, f)); }
 
 void CMultipatternSearch::AddPatterns(const vector<string>& patterns)
 {
+    CRegExFSA& fsm = x_GetFSM();
     vector<unique_ptr<CRegEx>> v;
     for (const string& s : patterns) {
         v.push_back(unique_ptr<CRegEx>(new CRegEx(s)));
     }
-    m_FSM->Add(v);
+    x_ResetCompiled();
+    fsm.Add(v);
 }
 
 void CMultipatternSearch::AddPatterns(const vector<pair<string, TFlags>>& patterns)
 {
+    CRegExFSA& fsm = x_GetFSM();
     vector<unique_ptr<CRegEx>> v;
     for (auto& p : patterns) {
         v.push_back(unique_ptr<CRegEx>(new CRegEx(p.first, p.second)));
     }
-    m_FSM->Add(v);
+    x_ResetCompiled();
+    fsm.Add(v);
 }
 
-void CMultipatternSearch::GenerateDotGraph(ostream& out) const { m_FSM->GenerateDotGraph(out); }
+void CMultipatternSearch::GenerateDotGraph(ostream& out) const { x_GetFSM().GenerateDotGraph(out); }
 
-void CMultipatternSearch::GenerateArrayMapData(ostream& out) const { m_FSM->GenerateArrayMapData(out); }
+void CMultipatternSearch::GenerateArrayMapData(ostream& out) const { x_GetFSM().GenerateArrayMapData(out); }
 
-void CMultipatternSearch::GenerateSourceCode(ostream& out) const { m_FSM->GenerateSourceCode(out); }
+void CMultipatternSearch::GenerateSourceCode(ostream& out) const { x_GetFSM().GenerateSourceCode(out); }
 
 string CMultipatternSearch::QuoteString(const string& str)
 {
@@ -95,103 +107,172 @@ string CMultipatternSearch::QuoteString(const string& str)
 }
 
 
-void CMultipatternSearch::Search(const char* input, VoidCall1 report) const
+CRegExFSA& CMultipatternSearch::x_GetFSM() const
 {
-    const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
-    size_t state = 1;
-
-    set<size_t>& emit = m_FSM->m_States[state]->m_Emit;
-    for (auto e : emit) {
-        report(e);
+    if (!m_FSM) {
+        throw string("The patterns are not available for the FSM loaded by Load()");
     }
-    while (true) {
-        state = m_FSM->m_States[state]->m_Trans[*p];
-        set<size_t>& emit = m_FSM->m_States[state]->m_Emit;
-        for (auto e : emit) {
-            report(e);
-        }
-        if (!*p) {
-            return;
+    return *m_FSM;
+}
+
+
+DEFINE_STATIC_FAST_MUTEX(s_CompileMutex);
+
+// Compile on the first use; the search itself takes no locks
+const CCompiledRegExFSA& CMultipatternSearch::x_GetCompiled() const
+{
+    CCompiledRegExFSA* compiled = m_Compiled.load(memory_order_acquire);
+    if (!compiled) {
+        CFastMutexGuard guard(s_CompileMutex);
+        compiled = m_Compiled.load(memory_order_relaxed);
+        if (!compiled) {
+            compiled = new CCompiledRegExFSA(*m_FSM);
+            m_Compiled.store(compiled, memory_order_release);
         }
-        ++p;
     }
+    return *compiled;
 }
 
 
-void CMultipatternSearch::Search(const char* input, VoidCall2 report) const
+void CMultipatternSearch::x_ResetCompiled()
+{
+    delete m_Compiled.exchange(nullptr);
+}
+
+
+void CMultipatternSearch::Search(const char* input, VoidCall1 report) const
 {
     const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
-    size_t state = 1;
+    x_GetCompiled().Scan(p, p, p + strlen(input), true, 0, m_Prefilter, [&report](size_t e, size_t) { report(e); return false; });
+}
 
-    set<size_t>& emit = m_FSM->m_States[state]->m_Emit;
-    for (auto e : emit) {
-        report(e, p - (const unsigned char*)input);
-    }
-    while (true) {
-        state = m_FSM->m_States[state]->m_Trans[*p];
-        set<size_t>& emit = m_FSM->m_States[state]->m_Emit;
-        for (auto e : emit) {
-            report(e, p - (const unsigned char*)input);
-        }
-        if (!*p) {
-            return;
-        }
-        ++p;
-    }
+
+void CMultipatternSearch::Search(const char* input, VoidCall2 report) const
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
+    x_GetCompiled().Scan(p, p, p + strlen(input), true, 0, m_Prefilter, [&report](size_t e, size_t pos) { report(e, pos); return false; });
 }
 
 
 void CMultipatternSearch::Search(const char* input, BoolCall1 report) const
 {
     const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
-    size_t state = 1;
-
-    set<size_t>& emit = m_FSM->m_States[state]->m_Emit;
-    for (auto e : emit) {
-        if (report(e)) {
-            return;
-        }
-    }
-    while (true) {
-        state = m_FSM->m_States[state]->m_Trans[*p];
-        set<size_t>& emit = m_FSM->m_States[state]->m_Emit;
-        for (auto e : emit) {
-            if (report(e)) {
-                return;
-            }
-        }
-        if (!*p) {
-            return;
-        }
-        ++p;
-    }
+    x_GetCompiled().Scan(p, p, p + strlen(input), true, 0, m_Prefilter, [&report](size_t e, size_t) { return report(e); });
 }
 
 
 void CMultipatternSearch::Search(const char* input, BoolCall2 report) const
 {
     const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
-    size_t state = 1;
+    x_GetCompiled().Scan(p, p, p + strlen(input), true, 0, m_Prefilter, [&report](size_t e, size_t pos) { return report(e, pos); });
+}
 
-    set<size_t>& emit = m_FSM->m_States[state]->m_Emit;
-    for (auto e : emit) {
-        if (report(e, p - (const unsigned char*)input)) {
-            return;
-        }
+
+#if defined(NCBI_THREADS)
+// Search a part of the buffer, collecting the results
+class CMultipatternScanThread : public CThread
+{
+public:
+    CMultipatternScanThread(const CCompiledRegExFSA& fsa, const unsigned char* begin, const unsigned char* from, const unsigned char* to, bool at_end, size_t report_from, CMultipatternSearch::EPrefilter prefilter)
+        : m_FSA(fsa), m_Begin(begin), m_From(from), m_To(to), m_AtEnd(at_end), m_ReportFrom(report_from), m_Prefilter(prefilter) {}
+    vector<pair<size_t, size_t>> m_Found;
+    void* Main(void) override
+    {
+        m_Found.clear();
+        m_FSA.Scan(m_Begin, m_From, m_To, m_AtEnd, m_ReportFrom, m_Prefilter, [this](size_t e, size_t pos) { m_Found.push_back(make_pair(e, pos)); return false; });
+        return 0;
     }
-    while (true) {
-        state = m_FSM->m_States[state]->m_Trans[*p];
-        set<size_t>& emit = m_FSM->m_States[state]->m_Emit;
-        for (auto e : emit) {
-            if (report(e, p - (const unsigned char*)input)) {
-                return;
+
+private:
+    const CCompiledRegExFSA& m_FSA;
+    const unsigned char* m_Begin;
+    const unsigned char* m_From;
+    const unsigned char* m_To;
+    bool m_AtEnd;
+    size_t m_ReportFrom;
+    CMultipatternSearch::EPrefilter m_Prefilter;
+};
+#endif
+
+
+void CMultipatternSearch::SearchBuffer(const char* data, size_t size, VoidCall2 report, unsigned int threads) const
+{
+    static const size_t kMinPart = 1024 * 1024;
+    const CCompiledRegExFSA& fsa = x_GetCompiled();
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(data);
+    auto report2 = [&report](size_t e, size_t pos) { report(e, pos); return false; };
+    if (!threads) {
+        threads = GetCpuCount();
+    }
+    size_t overlap = fsa.MaxLength();
+    if (overlap == CRegEx::kUnlimited || size / kMinPart < 2) {
+        threads = 1;
+    }
+    else if (threads > size / kMinPart) {
+        threads = (unsigned int)(size / kMinPart);
+    }
+#if defined(NCBI_THREADS)
+    if (threads > 1) {
+        // The state at any position depends only on the preceding MaxLength() characters,
+        // so each part is scanned from that many characters before its beginning.
+        // The first part is searched in the current thread.
+        size_t part = size / threads;
+        vector<CRef<CMultipatternScanThread>> workers;
+        for (unsigned int i = 1; i < threads; i++) {
+            size_t from = i * part;
+            size_t to = i + 1 < threads ? from + part : size;
+            size_t start = from > overlap ? from - overlap : 0;
+            workers.push_back(CRef<CMultipatternScanThread>(new CMultipatternScanThread(fsa, begin, begin + start, begin + to, to == size, from, m_Prefilter)));
+        }
+        size_t started = 0;
+        try {
+            for (; started < workers.size(); started++) {
+                workers[started]->Run();
             }
         }
-        if (!*p) {
-            return;
+        catch (CThreadException&) {
+            // search the remaining parts in the current thread
         }
-        ++p;
+        fsa.Scan(begin, begin, begin + part, false, 0, m_Prefilter, report2);
+        for (size_t i = 0; i < workers.size(); i++) {
+            CMultipatternScanThread& w = *workers[i];
+            if (i < started) {
+                w.Join();
+            }
+            else {
+                w.Main();
+            }
+            for (auto& f : w.m_Found) {
+                report(f.first, f.second);
+            }
+        }
+        return;
     }
+#endif
+    fsa.Scan(begin, begin, begin + size, true, 0, m_Prefilter, report2);
+}
+
+
+void CMultipatternSearch::Save(ostream& out) const
+{
+    x_GetCompiled().Save(out);
+}
+
+
+void CMultipatternSearch::Load(const void* data, size_t size)
+{
+    unique_ptr<CCompiledRegExFSA> fsa(new CCompiledRegExFSA(data, size));
+    m_FSM.reset();
+    x_ResetCompiled();
+    m_Compiled.store(fsa.release(), memory_order_release);
+}
+
+
+void CMultipatternSearch::Load(const string& filename)
+{
+    shared_ptr<CMemoryFile> file(new CMemoryFile(filename));
+    Load(file->GetPtr(), file->GetSize());
+    m_Compiled.load()->m_Storage = file;
 }
 
 
@@ -1241,6 +1322,8 @@ void CRegExFSA::Add(const CRegEx& rx)
 {
     Create(rx, m_Str.size());
     m_Str.push_back(rx.m_Str);
+    m_Flag.push_back(rx.m_Flag);
+    m_Len.push_back(rx.MaxLength());
 }
 
 
@@ -1254,6 +1337,8 @@ void CRegExFSA::Add(const vector<unique_ptr<CRegEx>>& v)
         unique_ptr<CRegExFSA> p(new CRegExFSA);
         p->Create(*rx, m_Str.size());
         m_Str.push_back(rx->m_Str);
+        m_Flag.push_back(rx->m_Flag);
+        m_Len.push_back(rx->MaxLength());
         w.push_back(move(p));
     }
     while (w.size() > 1) {
@@ -1733,4 +1818,286 @@ void CRegExFSA::GenerateArrayMapData(ostream& out) const
     out << "\n};\n";
 }
 
+////////////////////////////////////////////////////////////////
+// CCompiledRegExFSA
+
+namespace {
+    struct SCompiledHeader {
+        char  m_Magic[8];
+        Uint4 m_ByteOrder;
+        Uint4 m_NumStates;
+        Uint4 m_NumEmit;
+        Uint4 m_Prefix;
+        Uint8 m_MaxLen;
+    };
+    const char   kCompiledMagic[] = "NCBIMPS1";
+    const Uint4  kByteOrder = 0x01020304;
+    inline size_t Align8(size_t n) { return (n + 7) & ~size_t(7); }
+}
+
+
+CCompiledRegExFSA::CCompiledRegExFSA(const CRegExFSA& fsa)
+{
+    m_NumStates = fsa.m_States.size();
+    m_TransData.resize(m_NumStates * 256);
+    m_EmitIdxData.push_back(0);
+    for (size_t n = 0; n < m_NumStates; n++) {
+        for (size_t c = 0; c < 256; c++) {
+            m_TransData[n * 256 + c] = Uint4(fsa.m_States[n]->m_Trans[c]);
+        }
+        for (auto e : fsa.m_States[n]->m_Emit) {
+            m_EmitData.push_back(Uint4(e));
+        }
+        m_EmitIdxData.push_back(Uint4(m_EmitData.size()));
+    }
+    m_MaxLen = 0;
+    for (auto len : fsa.m_Len) {
+        m_MaxLen = max(m_MaxLen, len);
+    }
+    m_Trans = m_TransData.data();
+    m_EmitIdx = m_EmitIdxData.data();
+    m_Emit = m_EmitData.data();
+    x_BuildPrefilter(fsa);
+    m_Idle = m_IdleData.data();
+}
+
+
+void CCompiledRegExFSA::x_BuildPrefilter(const CRegExFSA& fsa)
+{
+    m_Prefix = kMaxPrefix;
+    m_IdleData.assign(m_NumStates, 0);
+    memset(m_Table, 0, sizeof(m_Table));
+    memset(m_Low, 0, sizeof(m_Low));
+    memset(m_High, 0, sizeof(m_High));
+    // Only plain strings: no assertions, and a match cannot start
+    // anywhere but at the first character of a pattern.
+    for (size_t i = 0; i < fsa.m_Str.size(); i++) {
+        const string& str = fsa.m_Str[i];
+        if (str.empty() || str[0] == '/' || (fsa.m_Flag[i] & ~CMultipatternSearch::TFlags(CMultipatternSearch::fNoCase))) {
+            m_Prefix = 0;
+            return;
+        }
+        m_Prefix = min(m_Prefix, str.length());
+    }
+    if (fsa.m_Str.empty()) {
+        m_Prefix = 0;
+        return;
+    }
+    // Teddy-style buckets: each pattern prefix is assigned to one of 8 buckets;
+    // a position may start a match if the bucket bits of all prefix characters intersect.
+    bool first[256] = { false };
+    for (size_t i = 0; i < fsa.m_Str.size(); i++) {
+        const string& str = fsa.m_Str[i];
+        bool nocase = (fsa.m_Flag[i] & CMultipatternSearch::fNoCase) != 0;
+        size_t hash = 0;
+        for (size_t k = 0; k < m_Prefix; k++) {
+            hash = hash * 31 + (unsigned char)(nocase ? tolower((unsigned char)str[k]) : str[k]);
+        }
+        unsigned char bucket = (unsigned char)(1 << (hash % 8));
+        for (size_t k = 0; k < m_Prefix; k++) {
+            unsigned char c[2] = { (unsigned char)str[k], (unsigned char)str[k] };
+            if (nocase) {
+                c[0] = (unsigned char)tolower(c[0]);
+                c[1] = (unsigned char)toupper(c[1]);
+            }
+            for (auto x : c) {
+                m_Table[k][x] |= bucket;
+                m_Low[k][x & 15] |= bucket;
+                m_High[k][x >> 4] |= bucket;
+                if (!k) {
+                    first[x] = true;
+                }
+            }
+        }
+    }
+    // Idle states: no partial match in progress; reached from the initial state by the characters
+    // that do not start any pattern.
+    vector<size_t> queue(1, 1);
+    m_IdleData[1] = 1;
+    while (!queue.empty()) {
+        size_t n = queue.back();
+        queue.pop_back();
+        for (size_t c = 1; c < 256; c++) {
+            size_t next = m_Trans[n * 256 + c];
+            if (!first[c] && !m_IdleData[next]) {
+                m_IdleData[next] = 1;
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+
+CCompiledRegExFSA::CCompiledRegExFSA(const void* data, size_t size)
+{
+    const SCompiledHeader* header = static_cast<const SCompiledHeader*>(data);
+    if (size < sizeof(SCompiledHeader) || memcmp(header->m_Magic, kCompiledMagic, sizeof(header->m_Magic))) {
+        throw string("Invalid multipattern FSM data");
+    }
+    if (header->m_ByteOrder != kByteOrder || header->m_Prefix > kMaxPrefix || header->m_NumStates < 2) {
+        throw string("Incompatible multipattern FSM data");
+    }
+    m_NumStates = header->m_NumStates;
+    m_Prefix = header->m_Prefix;
+    m_MaxLen = header->m_MaxLen == Uint8(-1) ? CRegEx::kUnlimited : size_t(header->m_MaxLen);
+    size_t trans_size = Align8(m_NumStates * 256 * sizeof(Uint4));
+    size_t idx_size = Align8((m_NumStates + 1) * sizeof(Uint4));
+    size_t emit_size = Align8(header->m_NumEmit * sizeof(Uint4));
+    size_t idle_size = Align8(m_NumStates);
+    size_t total = sizeof(SCompiledHeader) + trans_size + idx_size + emit_size + idle_size + sizeof(m_Table) + sizeof(m_Low) + sizeof(m_High);
+    if (size < total) {
+        throw string("Truncated multipattern FSM data");
+    }
+    const char* p = static_cast<const char*>(data) + sizeof(SCompiledHeader);
+    m_Trans = reinterpret_cast<const Uint4*>(p);
+    for (size_t i = 0; i < m_NumStates * 256; i++) {
+        if (m_Trans[i] >= m_NumStates) {
+            throw string("Invalid multipattern FSM data: bad transition");
+        }
+    }
+    p += trans_size;
+    m_EmitIdx = reinterpret_cast<const Uint4*>(p);
+    if (m_EmitIdx[0] || m_EmitIdx[m_NumStates] != header->m_NumEmit) {
+        throw string("Invalid multipattern FSM data: bad emit index");
+    }
+    for (size_t i = 0; i < m_NumStates; i++) {
+        if (m_EmitIdx[i] > m_EmitIdx[i + 1]) {
+            throw string("Invalid multipattern FSM data: bad emit index");
+        }
+    }
+    p += idx_size;
+    m_Emit = reinterpret_cast<const Uint4*>(p);
+    p += emit_size;
+    m_Idle = reinterpret_cast<const unsigned char*>(p);
+    p += idle_size;
+    memcpy(m_Table, p, sizeof(m_Table));
+    p += sizeof(m_Table);
+    memcpy(m_Low, p, sizeof(m_Low));
+    p += sizeof(m_Low);
+    memcpy(m_High, p, sizeof(m_High));
+}
+
+
+void CCompiledRegExFSA::Save(ostream& out) const
+{
+    SCompiledHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_Magic, kCompiledMagic, sizeof(header.m_Magic));
+    header.m_ByteOrder = kByteOrder;
+    header.m_NumStates = Uint4(m_NumStates);
+    header.m_NumEmit = m_EmitIdx[m_NumStates];
+    header.m_Prefix = Uint4(m_Prefix);
+    header.m_MaxLen = m_MaxLen == CRegEx::kUnlimited ? Uint8(-1) : Uint8(m_MaxLen);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    static const char kPadding[8] = { 0 };
+    const char* arrays[] = {
+        reinterpret_cast<const char*>(m_Trans),
+        reinterpret_cast<const char*>(m_EmitIdx),
+        reinterpret_cast<const char*>(m_Emit),
+        reinterpret_cast<const char*>(m_Idle)
+    };
+    size_t sizes[] = {
+        m_NumStates * 256 * sizeof(Uint4),
+        (m_NumStates + 1) * sizeof(Uint4),
+        header.m_NumEmit * sizeof(Uint4),
+        m_NumStates
+    };
+    for (size_t i = 0; i < 4; i++) {
+        out.write(arrays[i], sizes[i]);
+        out.write(kPadding, Align8(sizes[i]) - sizes[i]);
+    }
+    out.write(reinterpret_cast<const char*>(m_Table), sizeof(m_Table));
+    out.write(reinterpret_cast<const char*>(m_Low), sizeof(m_Low));
+    out.write(reinterpret_cast<const char*>(m_High), sizeof(m_High));
+}
+
+
+// Find the first position where one of the pattern prefixes may start
+const unsigned char* CCompiledRegExFSA::x_Find(const unsigned char* p, const unsigned char* end, bool simd) const
+{
+    const size_t K = m_Prefix;
+#if defined(__SSSE3__)
+    if (simd && end - p >= ptrdiff_t(16 + K)) {
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i low[kMaxPrefix], high[kMaxPrefix];
+        for (size_t k = 0; k < K; k++) {
+            low[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_Low[k]));
+            high[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_High[k]));
+        }
+        for (; end - p >= ptrdiff_t(16 + K); p += 16) {
+            __m128i res = _mm_set1_epi8(char(0xff));
+            for (size_t k = 0; k < K; k++) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k));
+                __m128i lo = _mm_shuffle_epi8(low[k], _mm_and_si128(x, nibble));
+                __m128i hi = _mm_shuffle_epi8(high[k], _mm_and_si128(_mm_srli_epi16(x, 4), nibble));
+                res = _mm_and_si128(res, _mm_and_si128(lo, hi));
+            }
+            unsigned mask = ~unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(res, zero))) & 0xffff;
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+        }
+    }
+#endif
+    for (; p + K <= end; ++p) {
+        unsigned char res = m_Table[0][p[0]];
+        for (size_t k = 1; res && k < K; k++) {
+            res &= m_Table[k][p[k]];
+        }
+        if (res) {
+            return p;
+        }
+    }
+    return end;
+}
+
+
+bool CCompiledRegExFSA::Scan(const unsigned char* begin, const unsigned char* from, const unsigned char* to,
+                             bool at_end, size_t report_from, CMultipatternSearch::EPrefilter mode, const TReport& report) const
+{
+    size_t state = 1;
+    for (size_t i = m_EmitIdx[state]; i < m_EmitIdx[state + 1]; i++) {
+        if (size_t(from - begin) >= report_from && report(m_Emit[i], from - begin)) {
+            return false;
+        }
+    }
+    const unsigned char* p = from;
+    bool prefilter = mode != CMultipatternSearch::ePrefilter_Off && m_Prefix;
+    bool simd = mode == CMultipatternSearch::ePrefilter_Auto;
+    size_t calls = 0;
+    size_t skipped = 0;
+    while (p < to) {
+        if (prefilter && m_Idle[state]) {
+            const unsigned char* next = x_Find(p, to, simd);
+            skipped += next - p;
+            p = next;
+            if (p == to) {
+                break;
+            }
+            // Give up if the candidates are too frequent for the prefilter to pay off
+            if (++calls % 1024 == 0 && skipped < calls * 16) {
+                prefilter = false;
+            }
+        }
+        state = m_Trans[state * 256 + *p];
+        for (size_t i = m_EmitIdx[state]; i < m_EmitIdx[state + 1]; i++) {
+            if (size_t(p - begin) >= report_from && report(m_Emit[i], p - begin)) {
+                return false;
+            }
+        }
+        ++p;
+    }
+    if (at_end) {
+        state = m_Trans[state * 256];
+        for (size_t i = m_EmitIdx[state]; i < m_EmitIdx[state + 1]; i++) {
+            if (size_t(p - begin) >= report_from && report(m_Emit[i], p - begin)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
 END_NCBI_SCOPE
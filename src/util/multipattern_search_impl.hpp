@@ -62,6 +62,10 @@ public:
     CRegEx(const string& s, CMultipatternSearch::TFlags f = 0) : m_Str(s), m_Flag(f) { x_Parse(); }
     operator bool() const { return m_RegX != 0; }
     static bool IsWordCharacter(unsigned char c) { return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_'; }
+    // longest match in characters, including one character of context for the assertions; kUnlimited if not limited
+    size_t MaxLength() const { return m_RegX ? m_RegX->MaxLength() : 0; }
+    static const size_t kUnlimited = size_t(-1);
+    static size_t AddLength(size_t a, size_t b) { return a == kUnlimited || b == kUnlimited || a + b < a ? kUnlimited : a + b; }
 
 protected:
 
@@ -75,6 +79,7 @@ protected:
         virtual bool IsAssert() const { return false; }
         virtual void Print(ostream& out, size_t off) const = 0;
         virtual void Render(CRegExFSA& fsa, size_t from, size_t to) const = 0;
+        virtual size_t MaxLength() const = 0;
         static void PrintOffset(ostream& out, size_t off) { for (size_t n = 0; n < off; n++) out << ' '; }
         static void DummyTrans(CRegExFSA& fsa, size_t x, unsigned char t);
     };
@@ -85,6 +90,7 @@ protected:
         bool IsCaseInsensitive() const { return true; }
         void Print(ostream& out, size_t off) const { PrintOffset(out, off); out << "<empty>\n"; }
         void Render(CRegExFSA& fsa, size_t from, size_t to) const;
+        size_t MaxLength() const { return 0; }
     };
 
     struct CRegXChar : public CRegX  // /a/
@@ -96,6 +102,7 @@ protected:
         bool IsCaseInsensitive() const;
         void Print(ostream& out, size_t off) const;
         void Render(CRegExFSA& fsa, size_t from, size_t to) const;
+        size_t MaxLength() const { return 1; }
         bool m_Neg;
         set<unsigned char> m_Set;
     };
@@ -107,6 +114,12 @@ protected:
         bool IsCaseInsensitive() const { return m_RegX->IsCaseInsensitive(); }
         void Print(ostream& out, size_t off) const;
         void Render(CRegExFSA& fsa, size_t from, size_t to) const;
+        size_t MaxLength() const {
+            size_t len = m_RegX->MaxLength();
+            if (!len) return 0;
+            if (!m_Max || len == kUnlimited || m_Max > kUnlimited / len) return kUnlimited;
+            return len * m_Max;
+        }
         unique_ptr<CRegX> m_RegX;
         unsigned int m_Min;
         unsigned int m_Max;
@@ -121,6 +134,7 @@ protected:
         bool IsCaseInsensitive() const { for (size_t n = 0; n < m_Vec.size(); n++) if (!m_Vec[n]->IsCaseInsensitive()) return false; return true; }
         void Print(ostream& out, size_t off) const { PrintOffset(out, off); out << "<concat>\n"; for (size_t n = 0; n < m_Vec.size(); n++) m_Vec[n]->Print(out, off + 2); }
         void Render(CRegExFSA& fsa, size_t from, size_t to) const;
+        size_t MaxLength() const { size_t len = 0; for (size_t n = 0; n < m_Vec.size(); n++) len = AddLength(len, m_Vec[n]->MaxLength()); return len; }
         vector<unique_ptr<CRegX> > m_Vec;
     };
 
@@ -132,6 +146,7 @@ protected:
         bool IsCaseInsensitive() const { for (size_t n = 0; n < m_Vec.size(); n++) if (!m_Vec[n]->IsCaseInsensitive()) return false; return true; }
         void Print(ostream& out, size_t off) const { PrintOffset(out, off); out << "<select>\n"; for (size_t n = 0; n < m_Vec.size(); n++) m_Vec[n]->Print(out, off + 2); }
         void Render(CRegExFSA& fsa, size_t from, size_t to) const;
+        size_t MaxLength() const { size_t len = 0; for (size_t n = 0; n < m_Vec.size(); n++) len = max(len, m_Vec[n]->MaxLength()); return len; }
         vector<unique_ptr<CRegX> > m_Vec;
     };
 
@@ -155,6 +170,7 @@ protected:
         virtual bool IsAssert() const { return true; }
         void Print(ostream& out, size_t off) const;
         void Render(CRegExFSA& fsa, size_t from, size_t to) const;
+        size_t MaxLength() const { return 1; }  // may look at the adjacent character
         EAssert m_Assert;
         unique_ptr<CRegX> m_RegX;
     };
@@ -165,6 +181,7 @@ protected:
         bool IsCaseInsensitive() const { return false; }
         void Print(ostream& out, size_t off) const { PrintOffset(out, off); out << "<bkref>\t" << m_Num << "\n"; }
         void Render(CRegExFSA& fsa, size_t from, size_t to) const { throw string("back reference"); }
+        size_t MaxLength() const { return kUnlimited; }
         unsigned int m_Num;
     };
 
@@ -280,8 +297,54 @@ class CRegExFSA
     }
     TStates m_States;
     vector<string> m_Str;
+    vector<CMultipatternSearch::TFlags> m_Flag;
+    vector<size_t> m_Len;   // CRegEx::MaxLength() of each pattern
     friend class CRegEx;
     friend class CMultipatternSearch;
+    friend class CCompiledRegExFSA;
+};
+
+
+// Flat copy of the CRegExFSA transition table for the search,
+// which can be saved and used from the memory-mapped file.
+// For the sets of plain strings, a SIMD prefilter skips the input
+// to the positions where the pattern prefixes may start.
+class CCompiledRegExFSA
+{
+public:
+    typedef function<bool(size_t, size_t)> TReport; // return true to stop
+    CCompiledRegExFSA(const CRegExFSA& fsa);
+    CCompiledRegExFSA(const void* data, size_t size); // data is not copied
+    void Save(ostream& out) const;
+    // Run the search on [from, to) of the input that starts at begin, starting from the initial state;
+    // if at_end, the end of input is processed the same way as the terminating zero of a string;
+    // report the matches found at positions >= report_from only; return false if stopped.
+    bool Scan(const unsigned char* begin, const unsigned char* from, const unsigned char* to,
+              bool at_end, size_t report_from, CMultipatternSearch::EPrefilter mode, const TReport& report) const;
+    // maximum match length; the state at any position depends only on this number of preceding characters
+    size_t MaxLength() const { return m_MaxLen; }
+    shared_ptr<void> m_Storage; // keeps the mapped file, if any
+
+private:
+    static const size_t kMaxPrefix = 3;
+    void x_BuildPrefilter(const CRegExFSA& fsa);
+    const unsigned char* x_Find(const unsigned char* p, const unsigned char* end, bool simd) const;
+
+    size_t m_NumStates;
+    size_t m_MaxLen;
+    size_t m_Prefix;                // prefix length used by the prefilter; 0 - no prefilter
+    const Uint4* m_Trans;           // [state * 256 + char]
+    const Uint4* m_EmitIdx;         // emits of state n: m_Emit[m_EmitIdx[n]] .. m_Emit[m_EmitIdx[n + 1] - 1]
+    const Uint4* m_Emit;
+    const unsigned char* m_Idle;    // no partial match in progress: the prefilter can be used
+    vector<Uint4> m_TransData;
+    vector<Uint4> m_EmitIdxData;
+    vector<Uint4> m_EmitData;
+    vector<unsigned char> m_IdleData;
+    // bucket masks of the prefix characters, full table and nibble tables for SIMD
+    unsigned char m_Table[kMaxPrefix][256];
+    unsigned char m_Low[kMaxPrefix][16];
+    unsigned char m_High[kMaxPrefix][16];
 };
 
 
@@ -0,0 +1,893 @@
+/*  $Id$
+* ===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+* Authors: agent
+*
+* File Description:
+*   CMappedRowReader - zero-copy reader of delimited rows from a memory
+*   mapped file, with optional parallel tokenization
+*
+* ===========================================================================
+*/
+
+#include <ncbi_pch.hpp>
+#include <util/row_reader_mapped.hpp>
+#include <util/error_codes.hpp>
+
+#include <string.h>
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif NCBI_SSE >= 20
+#  include <emmintrin.h>
+#endif
+
+#define NCBI_USE_ERRCODE_X   Util_RowReader
+
+BEGIN_NCBI_SCOPE
+
+
+// CRR_MappedField::m_Flags
+enum EFieldFlags {
+    fField_Quoted   = (1 << 0),  // enclosed in double quotes
+    fField_Escaped  = (1 << 1),  // has doubled quotes inside
+    fField_NCBI_TSV = (1 << 2)   // '-' and 'na' values are translated
+};
+
+
+// Row found by the tokenizer
+struct SRR_RowRec
+{
+    const char* m_Begin;
+    const char* m_End;
+    Uint4       m_FirstField;
+    Uint4       m_Fields;
+    Uint4       m_Line;         // 0-based line number in the chunk
+    ERR_RowType m_Type;
+};
+
+
+// Field found by the tokenizer
+struct SRR_FieldRec
+{
+    const char* m_Data;
+    Uint4       m_Size;
+    Uint4       m_Flags;
+};
+
+
+struct CMappedRowReader::SChunk
+{
+    void Reset(const char* begin, const char* end)
+    {
+        m_Begin = begin;
+        m_End = end;
+        m_Rows.clear();
+        m_Fields.clear();
+        m_Lines = 0;
+        m_Done = false;
+        m_Error.clear();
+        m_ErrorLine = 0;
+        m_ErrorPos = begin;
+    }
+
+    const char*          m_Begin;
+    const char*          m_End;
+    vector<SRR_RowRec>   m_Rows;
+    vector<SRR_FieldRec> m_Fields;
+    Uint4                m_Lines;    // number of line breaks in the chunk
+    bool                 m_Done;     // tokenized (by a worker thread)
+
+    // Tokenizing error; the rows before it are still valid
+    string               m_Error;
+    Uint4                m_ErrorLine;
+    const char*          m_ErrorPos;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Tokenizer
+//
+
+#if defined(__AVX2__)
+static const size_t kBlockSize = 32;
+#else
+static const size_t kBlockSize = 16;
+#endif
+
+
+// Index of the lowest set bit, 'mask' must not be zero
+static inline
+unsigned s_LowestBit(unsigned mask)
+{
+#if defined(__GNUC__)
+    return (unsigned) __builtin_ctz(mask);
+#else
+    unsigned n = 0;
+    while ( !(mask & 1) ) {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+
+// Locate the separators, the line feeds and (if kQuotes) the double
+// quotes in a block of kBlockSize bytes.
+// The vectorized versions are selected at compile time (see NCBI_SSE),
+// the scalar code is used for the tails and on other platforms.
+template <bool kQuotes>
+class CRR_CharMask
+{
+public:
+    CRR_CharMask(char separator)
+        : m_Separator(separator)
+    {
+#if defined(__AVX2__)
+        m_Sep   = _mm256_set1_epi8(separator);
+        m_LF    = _mm256_set1_epi8('\n');
+        m_Quote = _mm256_set1_epi8('"');
+#elif NCBI_SSE >= 20
+        m_Sep   = _mm_set1_epi8(separator);
+        m_LF    = _mm_set1_epi8('\n');
+        m_Quote = _mm_set1_epi8('"');
+#endif
+    }
+
+    // Mask for kBlockSize bytes at p
+    unsigned Get(const char* p) const
+    {
+#if defined(__AVX2__)
+        __m256i block = _mm256_loadu_si256((const __m256i*) p);
+        __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi8(block, m_Sep),
+                                     _mm256_cmpeq_epi8(block, m_LF));
+        if (kQuotes)
+            eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(block, m_Quote));
+        return (unsigned) _mm256_movemask_epi8(eq);
+#elif NCBI_SSE >= 20
+        __m128i block = _mm_loadu_si128((const __m128i*) p);
+        __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(block, m_Sep),
+                                  _mm_cmpeq_epi8(block, m_LF));
+        if (kQuotes)
+            eq = _mm_or_si128(eq, _mm_cmpeq_epi8(block, m_Quote));
+        return (unsigned) _mm_movemask_epi8(eq);
+#else
+        return GetTail(p, kBlockSize);
+#endif
+    }
+
+    // Mask for size (< kBlockSize) bytes at p
+    unsigned GetTail(const char* p, size_t size) const
+    {
+        unsigned mask = 0;
+        for (size_t i = 0;  i < size;  ++i) {
+            if (p[i] == m_Separator  ||  p[i] == '\n'  ||
+                (kQuotes  &&  p[i] == '"')) {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+    }
+
+private:
+    char    m_Separator;
+#if defined(__AVX2__)
+    __m256i m_Sep, m_LF, m_Quote;
+#elif NCBI_SSE >= 20
+    __m128i m_Sep, m_LF, m_Quote;
+#endif
+};
+
+
+// Count double quotes in [p, end)
+static size_t s_CountQuotes(const char* p, const char* end)
+{
+    size_t count = 0;
+#if NCBI_SSE >= 20
+    const __m128i kQuote = _mm_set1_epi8('"');
+    for ( ;  end - p >= 16;  p += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*) p);
+        unsigned mask = (unsigned)
+            _mm_movemask_epi8(_mm_cmpeq_epi8(block, kQuote));
+        if ( mask ) {
+#  if defined(__GNUC__)
+            count += __builtin_popcount(mask);
+#  else
+            for ( ;  mask;  mask &= mask - 1)
+                ++count;
+#  endif
+        }
+    }
+#endif
+    for ( ;  p < end;  ++p) {
+        if (*p == '"')
+            ++count;
+    }
+    return count;
+}
+
+
+// Split the chunk into rows and fields.
+// The chunk must start at a row boundary; the rows are split at line
+// feeds (a preceding CR is not included into the row data), the fields
+// are split at separators, both unless they are within double quotes.
+template <bool kQuotes>
+class CRR_Tokenizer
+{
+public:
+    CRR_Tokenizer(CMappedRowReader::SChunk& chunk, char separator,
+                  bool ncbi_tsv)
+        : m_Chunk(chunk), m_End(chunk.m_End), m_Separator(separator),
+          m_NCBI_TSV(ncbi_tsv), m_Line(0)
+    {}
+
+    // Return false in case of an error, see m_Chunk.m_Error
+    bool Run(void);
+
+private:
+    void x_StartRow(const char* pos);
+    void x_AddField(const char* end)
+    {
+        SRR_FieldRec field;
+        field.m_Data = m_FieldBegin;
+        field.m_Size = Uint4(end - m_FieldBegin);
+        field.m_Flags = m_FieldFlags;
+        m_Chunk.m_Fields.push_back(field);
+    }
+    void x_AddRow(const char* end, ERR_RowType type);
+    bool x_Error(const string& message)
+    {
+        m_Chunk.m_Error = message;
+        m_Chunk.m_ErrorLine = m_RowLine;
+        m_Chunk.m_ErrorPos = m_RowBegin;
+        return false;
+    }
+
+    CMappedRowReader::SChunk& m_Chunk;
+    const char*               m_End;
+    char                      m_Separator;
+    bool                      m_NCBI_TSV;
+
+    Uint4                     m_Line;
+    const char*               m_RowBegin;
+    Uint4                     m_RowLine;
+    size_t                    m_RowFirstField;
+    const char*               m_FieldBegin;
+    Uint4                     m_FieldFlags;
+    // Characters before m_Resume have been processed
+    const char*               m_Resume;
+};
+
+
+template <bool kQuotes>
+void CRR_Tokenizer<kQuotes>::x_StartRow(const char* pos)
+{
+    // NCBI TSV comments and metadata are not tokenized
+    while (m_NCBI_TSV  &&  pos < m_End  &&  *pos == '#') {
+        const char* eol = (const char*) memchr(pos, '\n', m_End - pos);
+        m_RowBegin = pos;
+        m_RowLine = m_Line;
+        m_RowFirstField = m_Chunk.m_Fields.size();
+        ERR_RowType type = (pos + 1 < m_End  &&  pos[1] == '#')
+            ? eRR_Metadata : eRR_Comment;
+        if (eol == nullptr) {
+            x_AddRow(m_End, type);
+            pos = m_End;
+        } else {
+            x_AddRow(eol, type);
+            ++m_Line;
+            pos = eol + 1;
+        }
+    }
+    m_RowBegin = pos;
+    m_RowLine = m_Line;
+    m_RowFirstField = m_Chunk.m_Fields.size();
+    m_FieldBegin = pos;
+    m_FieldFlags = 0;
+    m_Resume = pos;
+}
+
+
+template <bool kQuotes>
+void CRR_Tokenizer<kQuotes>::x_AddRow(const char* end, ERR_RowType type)
+{
+    if (end > m_RowBegin  &&  end[-1] == '\r')
+        --end;
+    if (type == eRR_Data) {
+        if (end == m_RowBegin  &&  m_Chunk.m_Fields.size() == m_RowFirstField)
+            return;  // empty rows are skipped
+        x_AddField(max(end, m_FieldBegin));
+    }
+    SRR_RowRec row;
+    row.m_Begin = m_RowBegin;
+    row.m_End = end;
+    row.m_FirstField = Uint4(m_RowFirstField);
+    row.m_Fields = Uint4(m_Chunk.m_Fields.size() - m_RowFirstField);
+    row.m_Line = m_RowLine;
+    row.m_Type = type;
+    m_Chunk.m_Rows.push_back(row);
+}
+
+
+template <bool kQuotes>
+bool CRR_Tokenizer<kQuotes>::Run(void)
+{
+    CRR_CharMask<kQuotes> char_mask(m_Separator);
+    bool in_quotes = false;
+
+    x_StartRow(m_Chunk.m_Begin);
+    const char* p = m_Resume;
+    while (p < m_End) {
+        unsigned mask;
+        if (size_t(m_End - p) >= kBlockSize)
+            mask = char_mask.Get(p);
+        else
+            mask = char_mask.GetTail(p, m_End - p);
+        if (m_Resume > p)
+            mask &= ~0u << (m_Resume - p);
+
+        while ( mask ) {
+            const char* q = p + s_LowestBit(mask);
+            mask &= mask - 1;
+            if (q < m_Resume)
+                continue;
+            m_Resume = q + 1;
+
+            if (kQuotes  &&  in_quotes) {
+                if (*q == '"') {
+                    if (q + 1 < m_End  &&  q[1] == '"') {
+                        m_FieldFlags |= fField_Escaped;
+                        m_Resume = q + 2;
+                    } else {
+                        if (q + 1 < m_End  &&  q[1] != m_Separator  &&
+                            q[1] != '\n'  &&  q[1] != '\r') {
+                            return x_Error("Unexpected double quote. "
+                                           "Closing double quote must be "
+                                           "the last in a line or be "
+                                           "followed by a separator");
+                        }
+                        in_quotes = false;
+                    }
+                } else if (*q == '\n') {
+                    ++m_Line;
+                }
+            } else if (*q == m_Separator) {
+                x_AddField(q);
+                m_FieldBegin = q + 1;
+                m_FieldFlags = 0;
+            } else if (*q == '\n') {
+                x_AddRow(q, eRR_Data);
+                ++m_Line;
+                x_StartRow(q + 1);
+                if (m_Resume >= p + kBlockSize)
+                    break;
+            } else if (kQuotes) {
+                if (q != m_FieldBegin) {
+                    return x_Error("Unexpected double quote. "
+                                   "If a field is not quoted then a double "
+                                   "quote may not appear in the middle");
+                }
+                m_FieldFlags |= fField_Quoted;
+                in_quotes = true;
+            }
+        }
+        p = max(p + kBlockSize, m_Resume);
+    }
+
+    if (in_quotes)
+        return x_Error("Unbalanced double quote detected");
+    if (m_RowBegin < m_End)
+        x_AddRow(m_End, eRR_Data);
+    m_Chunk.m_Lines = m_Line;
+    return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CRR_MappedField
+//
+
+bool CRR_MappedField::IsNull(void) const
+{
+    return (m_Flags & fField_NCBI_TSV)  &&  m_Size == 2  &&
+        m_Data[0] == 'n'  &&  m_Data[1] == 'a';
+}
+
+
+CTempString CRR_MappedField::GetValue(void) const
+{
+    if ( IsNull() )
+        NCBI_THROW2(CRowReaderException, eNullField,
+                    "The field value is translated to NULL", nullptr);
+    if (m_Flags & fField_Quoted) {
+        if ( !(m_Flags & fField_Escaped) )
+            return CTempString(m_Data + 1, m_Size - 2);
+        if ( !m_Unescaped ) {
+            m_Value.assign(m_Data + 1, m_Size - 2);
+            NStr::ReplaceInPlace(m_Value, "\"\"", "\"");
+            m_Unescaped = true;
+        }
+        return m_Value;
+    }
+    if ((m_Flags & fField_NCBI_TSV)  &&  m_Size == 1  &&  m_Data[0] == '-')
+        return CTempString();
+    return CTempString(m_Data, m_Size);
+}
+
+
+CTime CRR_MappedField::Get(const CTimeFormat& fmt) const
+{
+    try {
+        return CTime(GetValue(), fmt);
+    } catch (const CRowReaderException&) {
+        throw;
+    } catch (const CException& exc) {
+        NCBI_RETHROW2(exc, CRowReaderException, eFieldConvert,
+                      "Cannot convert field value to CTime using "
+                      "format " + fmt.GetString(), nullptr);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CRR_MappedRow
+//
+
+const CRR_MappedField& CRR_MappedRow::operator[](TFieldNo field) const
+{
+    if (field >= GetNumberOfFields()) {
+        CRR_Context* ctxt = nullptr;
+        if (m_Reader != nullptr)
+            ctxt = m_Reader->GetBasicContext().Clone();
+        NCBI_THROW2(CRowReaderException, eFieldNoOutOfRange,
+                    "Field index " + NStr::NumericToString(field) +
+                    " is out of range for the current row", ctxt);
+    }
+    return m_Fields[field];
+}
+
+
+const CRR_MappedField& CRR_MappedRow::operator[](CTempString field) const
+{
+    _ASSERT(m_Reader != nullptr);
+    TFieldNo index = m_Reader->GetFieldNo(field);
+    if (index >= GetNumberOfFields()) {
+        NCBI_THROW2(CRowReaderException, eFieldNoOutOfRange,
+                    "Field index " + NStr::NumericToString(index) +
+                    " provided for the field name '" + field +
+                    "' is out of range for the current row",
+                    m_Reader->GetBasicContext().Clone());
+    }
+    return m_Fields[index];
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  CMappedRowReader
+//
+
+class CMappedRowReader::CWorker : public CThread
+{
+public:
+    CWorker(CMappedRowReader& reader) : m_Reader(reader) {}
+
+protected:
+    virtual void* Main(void)
+    {
+        m_Reader.x_Work();
+        return 0;
+    }
+
+private:
+    CMappedRowReader& m_Reader;
+};
+
+
+CMappedRowReader::CMappedRowReader(const string&           filename,
+                                   const SRR_MappedFormat& format)
+    : m_SourceName(filename),
+      m_Format(format)
+{
+    x_Init();
+    CRR_Util::CheckExistanceAndPermissions(filename);
+    // Empty files cannot be mapped
+    if (CFile(filename).GetLength() > 0) {
+        m_File.reset(new CMemoryFile(filename));
+        m_File->MemMapAdvise(CMemoryFile::eMMA_Sequential);
+        m_Begin = (const char*) m_File->GetPtr();
+        m_End = m_Begin + m_File->GetSize();
+        m_Pos = m_Begin;
+    }
+}
+
+
+CMappedRowReader::CMappedRowReader(const char*             data,
+                                   size_t                  size,
+                                   const SRR_MappedFormat& format)
+    : m_SourceName("memory buffer"),
+      m_Format(format)
+{
+    x_Init();
+    m_Begin = data;
+    m_End = data + size;
+    m_Pos = data;
+}
+
+
+void CMappedRowReader::x_Init(void)
+{
+    m_Begin = m_End = m_Pos = nullptr;
+    m_Threads = 1;
+    m_ChunkSize = 4 * 1024 * 1024;
+    m_Started = false;
+    m_AtEnd = false;
+    m_Current = nullptr;
+    m_CurrentIndex = 0;
+    m_ChunkLineNo = 0;
+    m_NextLineNo = 0;
+    m_Stop = false;
+    m_CurrentRow.m_Reader = this;
+}
+
+
+CMappedRowReader::~CMappedRowReader()
+{
+    if ( !m_Workers.empty() ) {
+        {{
+            CFastMutexGuard guard(m_Mutex);
+            m_Stop = true;
+            m_QueueCond.SignalAll();
+        }}
+        NON_CONST_ITERATE(vector< CRef<CThread> >, it, m_Workers) {
+            (*it)->Join();
+        }
+    }
+}
+
+
+void CMappedRowReader::SetThreads(unsigned int threads)
+{
+    m_Threads = threads;
+}
+
+
+void CMappedRowReader::SetChunkSize(size_t chunk_size)
+{
+    m_ChunkSize = max(chunk_size, size_t(1));
+}
+
+
+const vector<string>& CMappedRowReader::GetFieldNames(void)
+{
+    if ( !m_Started )
+        x_Start();
+    return m_FieldNames;
+}
+
+
+TFieldNo CMappedRowReader::GetFieldNo(CTempString name) const
+{
+    auto it = m_FieldNamesIndex.find(string(name));
+    if (it == m_FieldNamesIndex.end())
+        NCBI_THROW2(CRowReaderException, eFieldNameNotFound,
+                    "Field name '" + name + "' is not found",
+                    GetBasicContext().Clone());
+    return it->second;
+}
+
+
+CRR_Context CMappedRowReader::GetBasicContext(void) const
+{
+    bool have_row = m_Current != nullptr  &&  !m_AtEnd;
+    return CRR_Context(m_SourceName, have_row,
+                       m_CurrentRow.GetLineNo(), m_CurrentRow.GetRowPos(),
+                       have_row, m_CurrentRow.GetOriginalData(), m_AtEnd);
+}
+
+
+bool CMappedRowReader::Next(void)
+{
+    if ( !m_Started )
+        x_Start();
+    if ( m_AtEnd )
+        return false;
+
+    for (;;) {
+        if (m_Current != nullptr) {
+            if (m_CurrentIndex < m_Current->m_Rows.size()) {
+                x_SetRow();
+                ++m_CurrentIndex;
+                return true;
+            }
+            if ( !m_Current->m_Error.empty() ) {
+                const char* pos = m_Current->m_ErrorPos;
+                const char* eol = (const char*)
+                    memchr(pos, '\n', m_Current->m_End - pos);
+                string line(pos, eol ? eol : m_Current->m_End);
+                m_AtEnd = true;
+                NCBI_THROW2(CRowReaderException, eLineProcessing,
+                            m_Current->m_Error,
+                            new CRR_Context(m_SourceName, true,
+                                            m_ChunkLineNo +
+                                            m_Current->m_ErrorLine,
+                                            pos - m_Begin, true, line,
+                                            false));
+            }
+        }
+        if ( !x_NextChunk() ) {
+            m_AtEnd = true;
+            m_CurrentRow.m_RawData.clear();
+            m_CurrentRow.m_RowType = eRR_Invalid;
+            m_CurrentRow.m_FieldsSize = 0;
+            return false;
+        }
+    }
+}
+
+
+void CMappedRowReader::x_Start(void)
+{
+    m_Started = true;
+    x_ReadHeader();
+
+#if defined(NCBI_THREADS)
+    for (unsigned int i = 0;  m_Threads > 1  &&  i < m_Threads;  ++i) {
+        try {
+            CRef<CThread> worker(new CWorker(*this));
+            worker->Run();
+            m_Workers.push_back(worker);
+        }
+        catch (CThreadException& e) {
+            ERR_POST_X(1, Info << "CMappedRowReader: using "
+                       << m_Workers.size() << " worker threads"
+                       " due to exception: " << e.what());
+            break;
+        }
+    }
+#endif
+}
+
+
+void CMappedRowReader::x_ReadHeader(void)
+{
+    if ( !(m_Format.m_Flags &
+           (SRR_MappedFormat::fHeader | SRR_MappedFormat::fNCBI_TSV)) )
+        return;
+
+    // The header is the first non empty line
+    while (m_Pos < m_End) {
+        if (*m_Pos == '\n') {
+            ++m_Pos;
+        } else if (*m_Pos == '\r'  &&  m_Pos + 1 < m_End  &&
+                   m_Pos[1] == '\n') {
+            m_Pos += 2;
+        } else {
+            break;
+        }
+        ++m_NextLineNo;
+    }
+    if (m_Pos == m_End)
+        return;
+
+    SChunk      header;
+    TLineNo     header_lines;
+    if (m_Format.m_Flags & SRR_MappedFormat::fNCBI_TSV) {
+        // '#' followed by the names; '##' is metadata
+        if (*m_Pos != '#'  ||  (m_Pos + 1 < m_End  &&  m_Pos[1] == '#'))
+            return;
+        const char* eol = (const char*) memchr(m_Pos, '\n', m_End - m_Pos);
+        header.Reset(m_Pos + 1, eol ? eol : m_End);
+    } else if (m_Format.m_Flags & SRR_MappedFormat::fQuotes) {
+        // The first line feed outside of double quotes
+        const char* eol = m_Pos;
+        bool        in_quotes = false;
+        for ( ;  eol < m_End;  ++eol) {
+            if (*eol == '"') {
+                in_quotes = !in_quotes;
+            } else if (*eol == '\n'  &&  !in_quotes) {
+                break;
+            }
+        }
+        header.Reset(m_Pos, eol);
+    } else {
+        const char* eol = (const char*) memchr(m_Pos, '\n', m_End - m_Pos);
+        header.Reset(m_Pos, eol ? eol : m_End);
+    }
+    header_lines = header.m_End < m_End ? 1 : 0;
+    m_Pos = header.m_End < m_End ? header.m_End + 1 : m_End;
+
+    // The names are tokenized as a regular row, without NCBI TSV rules
+    if ( !x_Tokenize(header, false) ) {
+        m_AtEnd = true;
+        NCBI_THROW2(CRowReaderException, eLineProcessing, header.m_Error,
+                    new CRR_Context(m_SourceName, true, m_NextLineNo,
+                                    header.m_ErrorPos - m_Begin, true,
+                                    string(header.m_Begin, header.m_End),
+                                    false));
+    }
+    m_NextLineNo += header.m_Lines + header_lines;
+
+    if ( header.m_Rows.empty() )
+        return;
+    const SRR_RowRec& row = header.m_Rows.front();
+    for (Uint4 i = 0;  i < row.m_Fields;  ++i) {
+        const SRR_FieldRec& rec = header.m_Fields[row.m_FirstField + i];
+        CRR_MappedField     field;
+        field.m_Data = rec.m_Data;
+        field.m_Size = rec.m_Size;
+        field.m_Flags = rec.m_Flags;
+        string name = field.GetValue();
+        m_FieldNamesIndex[name] = i;
+        m_FieldNames.push_back(name);
+    }
+}
+
+
+const char* CMappedRowReader::x_FindChunkEnd(const char* begin)
+{
+    if (size_t(m_End - begin) <= m_ChunkSize)
+        return m_End;
+
+    const char* p = begin + m_ChunkSize;
+    if ( !(m_Format.m_Flags & SRR_MappedFormat::fQuotes) ) {
+        const char* eol = (const char*) memchr(p, '\n', m_End - p);
+        return eol ? eol + 1 : m_End;
+    }
+
+    // A line feed is a row boundary only if it is preceded by an even
+    // number of double quotes (doubled quotes inside a quoted field do not
+    // change the parity). Malformed rows are reported by the tokenizer.
+    bool in_quotes = (s_CountQuotes(begin, p) & 1) != 0;
+    for ( ;  p < m_End;  ++p) {
+        if (*p == '"') {
+            in_quotes = !in_quotes;
+        } else if (*p == '\n'  &&  !in_quotes) {
+            return p + 1;
+        }
+    }
+    return m_End;
+}
+
+
+bool CMappedRowReader::x_Tokenize(SChunk& chunk, bool ncbi_tsv) const
+{
+    try {
+        if (m_Format.m_Flags & SRR_MappedFormat::fQuotes) {
+            CRR_Tokenizer<true> tokenizer(chunk, m_Format.m_Separator,
+                                          ncbi_tsv);
+            return tokenizer.Run();
+        }
+        CRR_Tokenizer<false> tokenizer(chunk, m_Format.m_Separator,
+                                       ncbi_tsv);
+        return tokenizer.Run();
+    } catch (const exception& exc) {
+        chunk.m_Error = exc.what();
+    } catch (...) {
+        chunk.m_Error = "Unknown error while splitting rows";
+    }
+    return false;
+}
+
+
+void CMappedRowReader::x_Dispatch(void)
+{
+    size_t max_pending = m_Workers.empty() ? 1 : 2 * m_Workers.size();
+    while (m_Pending.size() < max_pending  &&  m_Pos < m_End) {
+        SChunk* chunk;
+        if ( m_Free.empty() ) {
+            m_Chunks.emplace_back(new SChunk);
+            chunk = m_Chunks.back().get();
+        } else {
+            chunk = m_Free.back();
+            m_Free.pop_back();
+        }
+        const char* end = x_FindChunkEnd(m_Pos);
+        chunk->Reset(m_Pos, end);
+        m_Pos = end;
+        m_Pending.push_back(chunk);
+        if ( !m_Workers.empty() ) {
+            CFastMutexGuard guard(m_Mutex);
+            m_Queue.push_back(chunk);
+            m_QueueCond.SignalSome();
+        }
+    }
+}
+
+
+bool CMappedRowReader::x_NextChunk(void)
+{
+    if (m_Current != nullptr) {
+        m_Free.push_back(m_Current);
+        m_Current = nullptr;
+    }
+    x_Dispatch();
+    if ( m_Pending.empty() )
+        return false;
+
+    SChunk* chunk = m_Pending.front();
+    m_Pending.pop_front();
+    if ( m_Workers.empty() ) {
+        x_Tokenize(*chunk, (m_Format.m_Flags &
+                            SRR_MappedFormat::fNCBI_TSV) != 0);
+    } else {
+        // Keep the workers busy while waiting
+        x_Dispatch();
+        CFastMutexGuard guard(m_Mutex);
+        while ( !chunk->m_Done )
+            m_DoneCond.WaitForSignal(m_Mutex);
+    }
+    m_Current = chunk;
+    m_CurrentIndex = 0;
+    m_ChunkLineNo = m_NextLineNo;
+    m_NextLineNo += chunk->m_Lines;
+    return true;
+}
+
+
+void CMappedRowReader::x_SetRow(void)
+{
+    const SRR_RowRec& rec = m_Current->m_Rows[m_CurrentIndex];
+    m_CurrentRow.m_RawData.assign(rec.m_Begin, rec.m_End - rec.m_Begin);
+    m_CurrentRow.m_RowType = rec.m_Type;
+    m_CurrentRow.m_LineNo = m_ChunkLineNo + rec.m_Line;
+    m_CurrentRow.m_RowPos = rec.m_Begin - m_Begin;
+    m_CurrentRow.m_FieldsSize = rec.m_Fields;
+    if (m_CurrentRow.m_Fields.size() < rec.m_Fields)
+        m_CurrentRow.m_Fields.resize(rec.m_Fields);
+
+    int extra_flags = (m_Format.m_Flags & SRR_MappedFormat::fNCBI_TSV)
+        ? fField_NCBI_TSV : 0;
+    const SRR_FieldRec* from = m_Current->m_Fields.data() + rec.m_FirstField;
+    for (Uint4 i = 0;  i < rec.m_Fields;  ++i) {
+        CRR_MappedField& field = m_CurrentRow.m_Fields[i];
+        field.m_Data = from[i].m_Data;
+        field.m_Size = from[i].m_Size;
+        field.m_Flags = from[i].m_Flags | extra_flags;
+        field.m_Unescaped = false;
+    }
+}
+
+
+void CMappedRowReader::x_Work(void)
+{
+    CFastMutexGuard guard(m_Mutex);
+    for (;;) {
+        while (m_Queue.empty()  &&  !m_Stop)
+            m_QueueCond.WaitForSignal(m_Mutex);
+        if ( m_Stop )
+            return;
+        SChunk* chunk = m_Queue.front();
+        m_Queue.pop_front();
+        guard.Release();
+        x_Tokenize(*chunk, (m_Format.m_Flags &
+                            SRR_MappedFormat::fNCBI_TSV) != 0);
+        guard.Guard(m_Mutex);
+        chunk->m_Done = true;
+        m_DoneCond.SignalSome();
+    }
+}
+
+
+END_NCBI_SCOPE
@@ -36,6 +36,12 @@
 #include <util/bytesrc.hpp>
 #include <util/error_codes.hpp>
 #include <algorithm>
+#if defined(NCBI_OS_UNIX)
+#  include <sys/uio.h>
+#  include <unistd.h>
+#  include <errno.h>
+#  include <limits.h>
+#endif
 
 
 #define NCBI_USE_ERRCODE_X   Util_Stream
@@ -776,9 +782,198 @@ Uint8 CIStreamBuffer::GetUint8(void)
 }
 
 
+CScatterGatherBuffer::CScatterGatherBuffer(size_t chunk_size)
+    : m_Size(0), m_ChunkSize(chunk_size), m_ChunkIndex(0),
+      m_ChunkPos(0), m_ChunkEnd(0), m_LastInChunk(false),
+      m_ExternalThreshold(4096)
+{
+    _ASSERT(chunk_size > 0);
+}
+
+
+CScatterGatherBuffer::~CScatterGatherBuffer(void)
+{
+    ITERATE ( vector<char*>, it, m_Chunks ) {
+        delete[] *it;
+    }
+}
+
+
+void CScatterGatherBuffer::Append(const char* data, size_t size)
+{
+    while ( size > 0 ) {
+        if ( m_ChunkPos == m_ChunkEnd ) {
+            // take next chunk from the pool
+            if ( m_ChunkIndex == m_Chunks.size() ) {
+                m_Chunks.push_back(new char[m_ChunkSize]);
+            }
+            m_ChunkPos = m_Chunks[m_ChunkIndex++];
+            m_ChunkEnd = m_ChunkPos + m_ChunkSize;
+            m_LastInChunk = false;
+        }
+        size_t count = min(size, size_t(m_ChunkEnd - m_ChunkPos));
+        memcpy(m_ChunkPos, data, count);
+        if ( m_LastInChunk ) {
+            m_Segments.back().size += count;
+        }
+        else {
+            SSegment segment = { m_ChunkPos, count };
+            m_Segments.push_back(segment);
+            m_LastInChunk = true;
+        }
+        m_ChunkPos += count;
+        m_Size += count;
+        data += count;
+        size -= count;
+    }
+}
+
+
+void CScatterGatherBuffer::AppendExternal(const char* data, size_t size)
+{
+    if ( size == 0 ) {
+        return;
+    }
+    SSegment segment = { data, size };
+    m_Segments.push_back(segment);
+    m_Size += size;
+    m_LastInChunk = false;
+}
+
+
+void CScatterGatherBuffer::Clear(void)
+{
+    m_Segments.clear();
+    m_Size = 0;
+    m_ChunkIndex = 0;
+    m_ChunkPos = m_ChunkEnd = 0;
+    m_LastInChunk = false;
+}
+
+
+void CScatterGatherBuffer::x_Consume(size_t segments, size_t offset,
+                                     size_t count)
+{
+    m_Segments.erase(m_Segments.begin(), m_Segments.begin() + segments);
+    if ( offset != 0 ) {
+        m_Segments.front().data += offset;
+        m_Segments.front().size -= offset;
+    }
+    m_Size -= count;
+    if ( m_Segments.empty() ) {
+        m_LastInChunk = false;
+    }
+}
+
+
+// Move (segment, offset) position 'count' bytes forward
+static
+void s_Advance(const CScatterGatherBuffer::TSegments& segments,
+               size_t& segment, size_t& offset, size_t count)
+{
+    while ( count > 0 ) {
+        size_t left = segments[segment].size - offset;
+        if ( count < left ) {
+            offset += count;
+            return;
+        }
+        count -= left;
+        ++segment;
+        offset = 0;
+    }
+}
+
+
+ERW_Result CScatterGatherBuffer::WriteTo(IWriter& writer)
+{
+    size_t segment = 0, offset = 0, total = 0;
+    while ( segment < m_Segments.size() ) {
+        const SSegment& seg = m_Segments[segment];
+        size_t written = 0;
+        ERW_Result result = writer.Write(seg.data + offset,
+                                         seg.size - offset, &written);
+        s_Advance(m_Segments, segment, offset, written);
+        total += written;
+        if ( result != eRW_Success ) {
+            x_Consume(segment, offset, total);
+            return result;
+        }
+    }
+    Clear();
+    return eRW_Success;
+}
+
+
+void CScatterGatherBuffer::WriteTo(CNcbiOstream& out)
+    THROWS1((CIOException))
+{
+    ITERATE ( TSegments, it, m_Segments ) {
+        if ( !out.write(it->data, it->size) ) {
+            NCBI_THROW(CIOException, eWrite, "write fault");
+        }
+    }
+    Clear();
+}
+
+
+#if defined(NCBI_OS_UNIX)
+void CScatterGatherBuffer::WriteTo(int fd)
+    THROWS1((CIOException))
+{
+#  if defined(IOV_MAX)
+    const size_t kMaxVectors = IOV_MAX;
+#  else
+    const size_t kMaxVectors = 16;
+#  endif
+    vector<struct iovec> iov;
+    size_t segment = 0, offset = 0, total = 0;
+    while ( segment < m_Segments.size() ) {
+        iov.clear();
+        for ( size_t i = segment;
+              i < m_Segments.size()  &&  iov.size() < kMaxVectors;  ++i ) {
+            size_t skip = i == segment ? offset : 0;
+            struct iovec v;
+            v.iov_base = const_cast<char*>(m_Segments[i].data + skip);
+            v.iov_len = m_Segments[i].size - skip;
+            iov.push_back(v);
+        }
+        ssize_t written = writev(fd, &iov[0], int(iov.size()));
+        if ( written < 0 ) {
+            int error = errno;
+            if ( error == EINTR ) {
+                continue;
+            }
+            x_Consume(segment, offset, total);
+            NCBI_THROW(CIOException, eWrite,
+                       string("writev() failed: ") + strerror(error));
+        }
+        s_Advance(m_Segments, segment, offset, size_t(written));
+        total += size_t(written);
+    }
+    Clear();
+}
+#endif
+
+
 COStreamBuffer::COStreamBuffer(CNcbiOstream& out, bool deleteOut)
     THROWS1((bad_alloc))
-    : m_Output(out), m_DeleteOutput(deleteOut), m_Closed(false), m_Error(0),
+    : m_Output(&out), m_Segments(0),
+      m_DeleteOutput(deleteOut), m_Closed(false), m_Error(0),
+      m_IndentLevel(0), m_BufferPos(0),
+      m_Buffer(new char[KInitialBufferSize]),
+      m_CurrentPos(m_Buffer),
+      m_BufferEnd(m_Buffer + KInitialBufferSize),
+      m_Line(1), m_LineLength(0),
+      m_BackLimit(0), m_UseIndentation(true), m_UseEol(true),
+      m_CanceledCallback(0)
+{
+}
+
+
+COStreamBuffer::COStreamBuffer(CScatterGatherBuffer& out)
+    THROWS1((bad_alloc))
+    : m_Output(0), m_Segments(&out),
+      m_DeleteOutput(false), m_Closed(false), m_Error(0),
       m_IndentLevel(0), m_BufferPos(0),
       m_Buffer(new char[KInitialBufferSize]),
       m_CurrentPos(m_Buffer),
@@ -798,7 +993,7 @@ COStreamBuffer::~COStreamBuffer(void)
     NCBI_CATCH_X(2, "~COStreamBuffer: exception while closing");
     if ( m_DeleteOutput ) {
         try {
-            delete &m_Output;
+            delete m_Output;
         }
         NCBI_CATCH_X(2, "~COStreamBuffer: exception deleting output stream");
         m_DeleteOutput = false;
@@ -838,15 +1033,18 @@ END_LOCAL_NAMESPACE;
 
 void COStreamBuffer::Close(void)
 {
-    if ( !m_Closed && m_Output ) {
+    if ( !m_Closed && (m_Segments || *m_Output) ) {
         m_Closed = true;
-        if ( m_DeleteOutput ) {
+        if ( m_Segments ) {
+            FlushBuffer();
+        }
+        else if ( m_DeleteOutput ) {
             Flush();
-            delete &m_Output;
+            delete m_Output;
             m_DeleteOutput = false;
         }
         else {
-            STemporarilyClearStreamState state(m_Output);
+            STemporarilyClearStreamState state(*m_Output);
             FlushBuffer();
         }
     }
@@ -887,7 +1085,10 @@ void COStreamBuffer::FlushBuffer(bool fullBuffer)
         count = used - leave;
     }
     if ( count != 0 ) {
-        if ( !m_Output.write(m_Buffer, count) ) {
+        if ( m_Segments ) {
+            m_Segments->Append(m_Buffer, count);
+        }
+        else if ( !m_Output->write(m_Buffer, count) ) {
             m_Error = "write fault";
             NCBI_THROW(CIOException,eWrite,m_Error);
         }
@@ -906,9 +1107,13 @@ void COStreamBuffer::FlushBuffer(bool fullBuffer)
 void COStreamBuffer::Flush(void)
     THROWS1((CIOException))
 {
-    STemporarilyClearStreamState state(m_Output);
+    if ( m_Segments ) {
+        FlushBuffer();
+        return;
+    }
+    STemporarilyClearStreamState state(*m_Output);
     FlushBuffer();
-    if ( !m_Output.flush() ) {
+    if ( !m_Output->flush() ) {
         NCBI_THROW(CIOException,eFlush,"COStreamBuffer::Flush: failed");
     }
 }
@@ -1157,6 +1362,21 @@ void COStreamBuffer::Write(const char* data, size_t dataLength)
 }
 
 
+void COStreamBuffer::WriteExternal(const char* data, size_t dataLength)
+    THROWS1((CIOException, bad_alloc))
+{
+    // referenced data cannot be backed over, see SetBackLimit()
+    if ( !m_Segments  ||  m_BackLimit != 0  ||
+         dataLength < m_Segments->GetExternalThreshold() ) {
+        PutString(data, dataLength);
+        return;
+    }
+    FlushBuffer();
+    m_Segments->AppendExternal(data, dataLength);
+    m_BufferPos += CT_OFF_TYPE(dataLength);
+}
+
+
 void COStreamBuffer::Write(CByteSourceReader& reader)
     THROWS1((CIOException, bad_alloc))
 {
@@ -438,6 +438,10 @@ static const char kData_Lzo[] =
     "\x7a\x69\x70\x20\x74\x65\x73\x74\x00\x73\x6f\x75\x72\x63\x65\x20"
     "\x73\x74\x72\x3a\x11\x00\x00\x00\x00\x00\x00\x00";
 
+static const char kData_Zstd[] = 
+    "\x28\xb5\x2f\xfd\x00\x58\xa1\x00\x00\x7a\x73\x74\x64\x20\x74\x65"
+    "\x73\x74\x20\x73\x6f\x75\x72\x63\x65\x20\x73\x74\x72";
+
 static const char kData_Sra_BigEndian[] = 
     "NCBI.sra\x05\x03\x19\x88\x00\x00\x00\x01";
 static const char kData_Sra_LittleEndian[] = 
@@ -768,6 +772,13 @@ BOOST_AUTO_TEST_CASE(TestLzo)
     BOOST_CHECK_EQUAL(guess.GuessFormat(), CFormatGuess::eLzo);
 }
 
+BOOST_AUTO_TEST_CASE(TestZstd)
+{
+    CNcbiIstrstream str(kData_Zstd, sizeof(kData_Zstd) - 1);
+    CFormatGuess guess(str);
+    BOOST_CHECK_EQUAL(guess.GuessFormat(), CFormatGuess::eZstd);
+}
+
 BOOST_AUTO_TEST_CASE(TestSra)
 {
     {{
@@ -95,6 +95,8 @@ public:
     bool SelfTest_Adler32();
     // Big data test
     bool SelfTest_Big();
+    // CChecksum::AddCharsBatch() test
+    bool SelfTest_Batch();
 
     // Speed tests
 
@@ -102,6 +104,8 @@ public:
     void SpeedTests(const CFileData& file_data);
     // Run a specific speed test on a file data (for both CHash and CChecksum where available)
     void SpeedTest(CChecksumBase::EMethodDef method, const CFileData& file_data);
+    // Compare speed of CChecksum::AddCharsBatch() with separate AddChars() calls
+    void SpeedTestBatch(CChecksumBase::EMethodDef method, const CFileData& file_data);
 };
 
 
@@ -137,6 +141,8 @@ string CChecksumTestApp::GetMethodName(EMethodDef method)
     case eMurmurHash2_32: return "MurmurHash2_32";
     case eMurmurHash2_64: return "MurmurHash2_64";
     case eMurmurHash3_32: return "MurmurHash3_32";
+    case eXXH3_64:        return "XXH3_64";
+    case eXXH3_128:       return "XXH3_128";
     case eNone:
         ;
     }
@@ -160,6 +166,8 @@ bool CChecksumTestApp::IsHashMethod(EMethodDef method)
     case eMurmurHash2_32:
     case eMurmurHash2_64:
     case eMurmurHash3_32:
+    case eXXH3_64:
+    case eXXH3_128:
         return true;
     case eMD5:
         return false;
@@ -180,6 +188,8 @@ bool CChecksumTestApp::IsChecksumhMethod(EMethodDef method)
     case eCRC32C: 
     case eAdler32:
     case eMD5:
+    case eXXH3_64:
+    case eXXH3_128:
         return true;
     case eCityHash32:
     case eCityHash64:
@@ -201,7 +211,7 @@ bool CChecksumTestApp::VerifySum(const string& data_origin, CChecksumBase& sum,
     EMethodDef m = sum.x_GetMethod();
     string method = GetMethodName(m);
 
-    if ( m == eMD5 ) {
+    if ( m == eMD5  ||  m == eXXH3_128 ) {
         if ( sum.GetResultHex() != expected.md5 ) {
             cerr << "FAILED "<< method << " for " << data_origin  << endl;
             cerr << "    Expected: " << hex << expected.md5       << endl;
@@ -258,6 +268,8 @@ bool CChecksumTestApp::SelfTest_Str()
             { eMurmurHash2_32, { 0x71b7ebf6 },  "" },
             { eMurmurHash2_64, { NCBI_CONST_UINT8(0x1a14f106cd88c604) }, "" },
             { eMurmurHash3_32, { 0x3c46c9dc },  "" },
+            { eXXH3_64,        { NCBI_CONST_UINT8(0x2d06800538d394c2) }, "" },
+            { eXXH3_128,       { 0 }, "99aa06d3014798d86001c324468d497f" },
             { eMD5,            { 0 }, "d41d8cd98f00b204e9800998ecf8427e" }}
         },
         { "a", {
@@ -272,6 +284,8 @@ bool CChecksumTestApp::SelfTest_Str()
             { eMurmurHash2_32, { 0xdd6eaa72 },  "" },
             { eMurmurHash2_64, { NCBI_CONST_UINT8(0xe78727fd27938759) }, "" },
             { eMurmurHash3_32, { 0x95352c35 },  "" },
+            { eXXH3_64,        { NCBI_CONST_UINT8(0xe6c632b61e964e1f) }, "" },
+            { eXXH3_128,       { 0 }, "a96faf705af16834e6c632b61e964e1f" },
             { eMD5,            { 0 }, "0cc175b9c0f1b6a831c399e269772661" }}
         },
         { "abc", {
@@ -286,6 +300,8 @@ bool CChecksumTestApp::SelfTest_Str()
             { eMurmurHash2_32, { 0xe64e1d8a },  "" },
             { eMurmurHash2_64, { NCBI_CONST_UINT8(0x9d373123f31f4b40) }, "" },
             { eMurmurHash3_32, { 0xcdb7804f },  "" },
+            { eXXH3_64,        { NCBI_CONST_UINT8(0x78af5f94892f3950) }, "" },
+            { eXXH3_128,       { 0 }, "06b05ab6733a618578af5f94892f3950" },
             { eMD5,            { 0 }, "900150983cd24fb0d6963f7d28e17f72" }}
         },
         { "message digest", {
@@ -300,6 +316,8 @@ bool CChecksumTestApp::SelfTest_Str()
             { eMurmurHash2_32, { 0x00e65523 },  "" },
             { eMurmurHash2_64, { NCBI_CONST_UINT8(0x9ccccdc1590b7884) }, "" },
             { eMurmurHash3_32, { 0x46558202 },  "" },
+            { eXXH3_64,        { NCBI_CONST_UINT8(0x160d8e9329be94f9) }, "" },
+            { eXXH3_128,       { 0 }, "34ab715d95e3b6490abfabecb8e3a424" },
             { eMD5,            { 0 }, "f96b697d7cb7938d525a2f31aaf161d0" }}
         },
         { "abcdefghijklmnopqrstuvwxyz", {
@@ -314,6 +332,8 @@ bool CChecksumTestApp::SelfTest_Str()
             { eMurmurHash2_32, { 0xb24869d9 },  "" },
             { eMurmurHash2_64, { NCBI_CONST_UINT8(0x31a588f6a77a8210) }, "" },
             { eMurmurHash3_32, { 0x98aa3c36 },  "" },
+            { eXXH3_64,        { NCBI_CONST_UINT8(0x810f9ca067fbb90c) }, "" },
+            { eXXH3_128,       { 0 }, "db7ca44e84843d67ebe162220154e1e6" },
             { eMD5,            { 0 }, "c3fcd3d76192e4007dfb496cca67e13b" }}
         },
         { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", {
@@ -328,6 +348,8 @@ bool CChecksumTestApp::SelfTest_Str()
             { eMurmurHash2_32, { 0x648c1aef },  "" },
             { eMurmurHash2_64, { NCBI_CONST_UINT8(0x8c72371817be471b) }, "" },
             { eMurmurHash3_32, { 0x2566f7c8 },  "" },
+            { eXXH3_64,        { NCBI_CONST_UINT8(0x643542bb51639cb2) }, "" },
+            { eXXH3_128,       { 0 }, "5bcb80b619500686a3c0560bd47a4ffb" },
             { eMD5,            { 0 }, "d174ab98d277d9f5a5611c2c9f419d9f" }}
         },
         { "12345678901234567890123456789012345678901234567890123456789012345678901234567890", {
@@ -342,6 +364,8 @@ bool CChecksumTestApp::SelfTest_Str()
             { eMurmurHash2_32, { 0xf334c676 },  "" },
             { eMurmurHash2_64, { NCBI_CONST_UINT8(0x48cfebd7cd2eac2f) }, "" },
             { eMurmurHash3_32, { 0x6029055e },  "" },
+            { eXXH3_64,        { NCBI_CONST_UINT8(0x7f58aa2520c681f9) }, "" },
+            { eXXH3_128,       { 0 }, "08dd22c3ddc34ce640cb8d6ac672dcb8" },
             { eMD5,            { 0 }, "57edf4a22be3c955ac49da2e2107b67a" }}
         },
         { string("\1\xc0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\1\xfe\x60\xac\0\0\0"
@@ -357,6 +381,8 @@ bool CChecksumTestApp::SelfTest_Str()
             { eMurmurHash2_32, { 0x38abf1aa },  "" },
             { eMurmurHash2_64, { NCBI_CONST_UINT8(0xf47f0a3ee8e9fa45) }, "" },
             { eMurmurHash3_32, { 0x084d2e6b },  "" },
+            { eXXH3_64,        { NCBI_CONST_UINT8(0x3f262af5177e7b0e) }, "" },
+            { eXXH3_128,       { 0 }, "e6546157d5cd22dd3cf8fdc9071186f8" },
             { eMD5,            { 0 }, "f16de75fd4137d2b5b12f35f247a6214" }}
         }
     };
@@ -538,6 +564,8 @@ bool CChecksumTestApp::SelfTest_Big()
         { eMurmurHash2_32, { 0x65547016 },  "" },
         { eMurmurHash2_64, { NCBI_CONST_UINT8(0x971d5ff461a89662) },  "" },
         { eMurmurHash3_32, { 0xa7e2d7ae },  "" },
+        { eXXH3_64,        { NCBI_CONST_UINT8(0xc717e6a86d89e10d) }, "" },
+        { eXXH3_128,       { 0 }, "1c26a57461305a0ec717e6a86d89e10d" },
         { eMD5,            { 0 }, "a1ed665e33b6feb5a645738b4384ca25" }
     };
     const char*  kFileName = "test_data/checksum.dat";
@@ -593,6 +621,50 @@ void CChecksumTestApp::ComputeBigSum(CRandom& random, const CFileData& file_data
 }
 
 
+bool CChecksumTestApp::SelfTest_Batch()
+{
+    const EMethodDef kMethods[] = { eCRC32, eCRC32C, eAdler32, eMD5, eXXH3_64 };
+    bool ok = true;
+    CRandom random(1);
+    vector<char> buf(20000);
+    for (size_t i = 0; i < buf.size(); ++i) {
+        buf[i] = char(random.GetRand());
+    }
+    for (int test = 0; test < 100; ++test) {
+        size_t count = random.GetRand(1, 20);
+        vector<CChecksum> expected, batch;
+        vector<CTempString> data;
+        for (size_t i = 0; i < count; ++i) {
+            CChecksum::EMethod method = (CChecksum::EMethod)kMethods[random.GetRand(0, ArraySize(kMethods) - 1)];
+            expected.push_back(CChecksum(method));
+            // Start with some data to have a partial block
+            size_t head = random.GetRand(0, 100);
+            expected.back().AddChars(buf.data(), head);
+            batch.push_back(expected.back());
+            size_t size = random.GetRand(0, 5000);
+            data.push_back(CTempString(buf.data() + random.GetRand(0, 1000), size));
+            expected.back().AddChars(data.back().data(), size);
+        }
+        vector<CChecksum*> sums;
+        for (auto& sum : batch) {
+            sums.push_back(&sum);
+        }
+        CChecksum::AddCharsBatch(sums.data(), data.data(), count);
+        for (size_t i = 0; i < count; ++i) {
+            if ( batch[i].GetResultHex() != expected[i].GetResultHex() ) {
+                cerr << "FAILED batch " << GetMethodName(batch[i].x_GetMethod())
+                     << " for size " << data[i].size() << endl;
+                cerr << "    Expected: " << expected[i].GetResultHex() << endl;
+                cerr << "    Computed: " << batch[i].GetResultHex() << endl;
+                ok = false;
+            }
+        }
+    }
+    cout << "Batch: " << (ok ? "passed" : "failed") << endl;
+    return ok;
+}
+
+
 void CChecksumTestApp::SpeedTests(const CFileData& data)
 {
     SpeedTest( eCRC32,          data );
@@ -607,7 +679,11 @@ void CChecksumTestApp::SpeedTests(const CFileData& data)
     SpeedTest( eMurmurHash2_32, data );
     SpeedTest( eMurmurHash2_64, data );
     SpeedTest( eMurmurHash3_32, data );
+    SpeedTest( eXXH3_64,        data );
+    SpeedTest( eXXH3_128,       data );
     SpeedTest( eMD5,            data );
+    SpeedTestBatch( eCRC32C,    data );
+    SpeedTestBatch( eMD5,       data );
 }
 
 
@@ -636,6 +712,35 @@ void CChecksumTestApp::SpeedTest(CChecksumBase::EMethodDef method,  const CFileD
 }
 
 
+void CChecksumTestApp::SpeedTestBatch(CChecksumBase::EMethodDef method, const CFileData& file_data)
+{
+    // Split the data into pieces of typical blob size
+    const size_t kPieceSize = 4096;
+    vector<CTempString> data;
+    for (size_t pos = 0; pos < file_data.size(); pos += kPieceSize) {
+        data.push_back(CTempString(file_data.data() + pos, min(kPieceSize, file_data.size() - pos)));
+    }
+    vector<CChecksum> sums(data.size(), CChecksum((CChecksum::EMethod)method));
+    CStopWatch timer(CStopWatch::eStart);
+    for (size_t i = 0; i < data.size(); ++i) {
+        sums[i].AddChars(data[i].data(), data[i].size());
+    }
+    string time = timer.AsString();
+
+    vector<CChecksum> batch(data.size(), CChecksum((CChecksum::EMethod)method));
+    vector<CChecksum*> ptrs;
+    for (auto& sum : batch) {
+        ptrs.push_back(&sum);
+    }
+    timer.Restart();
+    CChecksum::AddCharsBatch(ptrs.data(), data.data(), data.size());
+    string batch_time = timer.AsString();
+    cout << "Processed " << data.size() << " pieces of " << kPieceSize << " bytes: "
+         << GetMethodName(method) << " separately in " << time
+         << ", in batch in " << batch_time << endl;
+}
+
+
 int CChecksumTestApp::Run(void)
 {
     const CArgs& args = GetArgs();
@@ -648,6 +753,7 @@ int CChecksumTestApp::Run(void)
         ok &= SelfTest_Str();
         ok &= SelfTest_Adler32();
         ok &= SelfTest_Big();
+        ok &= SelfTest_Batch();
         cout << (ok ? "All tests passed" : "Errors detected") << endl;
         return ok ? 0 : 1;
     }
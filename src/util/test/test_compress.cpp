@@ -89,6 +89,10 @@ public:
     // Additional tests
     void TestEmptyInputData(CCompressStream::EMethod);
     void TestTransparentCopy(const char* src_buf, size_t src_len, size_t buf_len);
+    void TestZipMT(const char* src_buf, size_t src_len);
+#if defined(HAVE_LIBZSTD)
+    void TestZstdDictionary(void);
+#endif
 
 private:
     // Auxiliary methods
@@ -125,7 +129,7 @@ void CTest::Init(void)
     arg_desc->AddDefaultPositional
         ("lib", "Compression library to test", CArgDescriptions::eString, "all");
     arg_desc->SetConstraint
-        ("lib", &(*new CArgAllow_Strings, "all", "z", "bz2", "lzo"));
+        ("lib", &(*new CArgAllow_Strings, "all", "z", "bz2", "lzo", "zstd"));
     arg_desc->AddDefaultKey
         ("size", "SIZE",
          "Test data size. If not specified, default set of tests will be used. "
@@ -175,6 +179,13 @@ int CTest::Run(void)
         lzo = false;
     }
 #endif
+    bool zstd = (test == "all" || test == "zstd");
+#if !defined(HAVE_LIBZSTD)
+    if (zstd) {
+        ERR_POST(Warning << "Zstandard is not available on this platform, ignored.");
+        zstd = false;
+    }
+#endif
 
     // Set a random starting point
     unsigned int seed = (unsigned int)time(0);
@@ -257,7 +268,18 @@ int CTest::Run(void)
                        CZipCompressionFile,
                        CZipStreamCompressor,
                        CZipStreamDecompressor> (src_buf, len, kBufLen);
+            ERR_POST(Trace << "-------------- Zlib MT / BGZF ------");
+            TestZipMT(src_buf, len);
         }
+#if defined(HAVE_LIBZSTD)
+        if ( zstd ) {
+            ERR_POST(Trace << "-------------- Zstd ----------------");
+            TestMethod<CZstdCompression,
+                       CZstdCompressionFile,
+                       CZstdStreamCompressor,
+                       CZstdStreamDecompressor> (src_buf, len, kBufLen);
+        }
+#endif
 
         // Test for (de)compressor's transparent copy
         TestTransparentCopy(src_buf, len, kBufLen);
@@ -279,7 +301,18 @@ int CTest::Run(void)
         if (z) {
             TestEmptyInputData(CCompressStream::eZip);
         }
+        if (zstd) {
+            TestEmptyInputData(CCompressStream::eZstd);
+        }
     }
+#if defined(HAVE_LIBZSTD)
+    // Dictionary and multi-threaded compression tests
+    if ( zstd  &&  !custom_size ) {
+        ERR_POST(Trace << "====================================");
+        ERR_POST(Trace << "Zstandard dictionary");
+        TestZstdDictionary();
+    }
+#endif
 
     ERR_POST(Info << "TEST execution completed successfully!");
     return 0;
@@ -371,7 +404,11 @@ static const SEmptyInputDataTest s_EmptyInputDataTests[] =
     { CCompressStream::eZip,   CZipCompression::fGZip,             false,  0,  0 },
     { CCompressStream::eZip,   CZipCompression::fAllowEmptyData,   true,   8,  8 },
     { CCompressStream::eZip,   CZipCompression::fAllowEmptyData |
-                               CZipCompression::fGZip,             true,  20, 20 }
+                               CZipCompression::fGZip,             true,  20, 20 },
+#if defined(HAVE_LIBZSTD)
+    { CCompressStream::eZstd,  0 /* default flags */,              false,  0,  0 },
+    { CCompressStream::eZstd,  CZstdCompression::fAllowEmptyData,  true,   9,  9 },
+#endif
 };
 
 void CTest::TestEmptyInputData(CCompressStream::EMethod method)
@@ -417,6 +454,14 @@ void CTest::TestEmptyInputData(CCompressStream::EMethod method)
             stream_compressor.reset(new CZipStreamCompressor(test.flags));
             stream_decompressor.reset(new CZipStreamDecompressor(test.flags));
         } else
+#if defined(HAVE_LIBZSTD)
+        if (method == CCompressStream::eZstd) {
+            compression.reset(new CZstdCompression());
+            compression->SetFlags(test.flags);
+            stream_compressor.reset(new CZstdStreamCompressor(test.flags));
+            stream_decompressor.reset(new CZstdStreamDecompressor(test.flags));
+        } else
+#endif
         {
             _TROUBLE;
         }
@@ -601,6 +646,295 @@ void CTest::TestTransparentCopy(const char* src_buf, size_t src_len, size_t buf_
 
 
 
+#if defined(HAVE_LIBZSTD)
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Tests for Zstandard dictionaries and multi-threaded compression
+//
+
+void CTest::TestZstdDictionary(void)
+{
+    // Create a set of small similar records, that compress badly
+    // without a dictionary
+    vector<string> samples;
+    for (int i = 0;  i < 2000;  ++i) {
+        samples.push_back(
+            "Seq-entry ::= seq { id { gi " + NStr::IntToString(rand()) +
+            " }, descr { title \"sample record " + NStr::IntToString(i) +
+            "\", molinfo { biomol genomic } }, inst { repr raw, mol dna, "
+            "length " + NStr::IntToString(rand() % 10000) + " } }");
+    }
+    CRef<CZstdDictionary> dict = CZstdDictionary::Train(samples, 4 KB);
+    assert(dict->GetData().size() > 0);
+    assert(dict->GetData().size() <= 4 KB);
+    assert(dict->GetID() != 0);
+
+    const string& src = samples[0];
+    char   dst_buf[1024];
+    char   cmp_buf[1024];
+    size_t dst_len, out_len, len_nodict;
+
+    // Buffer compression with and without dictionary
+    {{
+        CZstdCompression c;
+        assert(c.CompressBuffer(src.data(), src.size(), dst_buf, sizeof(dst_buf), &len_nodict));
+        c.SetDictionary(dict);
+        assert(c.CompressBuffer(src.data(), src.size(), dst_buf, sizeof(dst_buf), &dst_len));
+        PrintResult(eCompress, c.GetErrorCode(), src.size(), sizeof(dst_buf), dst_len);
+        assert(dst_len < len_nodict);
+        assert(c.DecompressBuffer(dst_buf, dst_len, cmp_buf, sizeof(cmp_buf), &out_len));
+        assert(out_len == src.size());
+        assert(memcmp(src.data(), cmp_buf, out_len) == 0);
+
+        // Cannot decompress without dictionary
+        CZstdCompression d;
+        assert(!d.DecompressBuffer(dst_buf, dst_len, cmp_buf, sizeof(cmp_buf), &out_len));
+        OK_MSG("buffer");
+    }}
+
+    // Stream compression with dictionary, reusing the same dictionary
+    // (created from its content) for decompression
+    {{
+        CRef<CZstdDictionary> dict2(new CZstdDictionary(dict->GetData()));
+        CNcbiOstrstream os_str;
+        {{
+            CCompressionOStream os(os_str,
+                new CZstdStreamCompressor(CCompression::eLevel_Default,
+                                          kCompressionDefaultBufSize,
+                                          kCompressionDefaultBufSize,
+                                          0, dict),
+                CCompressionStream::fOwnWriter);
+            for (size_t i = 0;  i < 100;  ++i) {
+                os << samples[i];
+            }
+            os.Finalize();
+            assert(os.good());
+        }}
+        string str = CNcbiOstrstreamToString(os_str);
+        CNcbiIstrstream is_str(str.data(), str.size());
+        CCompressionIStream is(is_str,
+            new CZstdStreamDecompressor(kCompressionDefaultBufSize,
+                                        kCompressionDefaultBufSize,
+                                        0, dict2),
+            CCompressionStream::fOwnReader);
+        for (size_t i = 0;  i < 100;  ++i) {
+            string s(samples[i].size(), '\0');
+            is.read(&s[0], s.size());
+            assert(is.good());
+            assert(s == samples[i]);
+        }
+        OK_MSG("stream");
+    }}
+
+    // Multi-threaded compression of large data produce the same
+    // (standard) frames, that can be decompressed as usual
+    {{
+        string data;
+        while (data.size() < 8 MB) {
+            data += samples[rand() % samples.size()];
+        }
+        CNcbiOstrstream os_str;
+        {{
+            CCompressionOStream os(os_str,
+                new CZstdStreamCompressor(CCompression::eLevel_Default,
+                                          kCompressionDefaultBufSize,
+                                          kCompressionDefaultBufSize,
+                                          CZstdCompression::fChecksum,
+                                          NULL, 2 /* workers */),
+                CCompressionStream::fOwnWriter);
+            os.write(data.data(), data.size());
+            os.Finalize();
+            assert(os.good());
+        }}
+        string str = CNcbiOstrstreamToString(os_str);
+        PrintResult(eCompress, kUnknownErr, data.size(), kUnknown, str.size());
+
+        // Concatenate two frames, both should be decompressed
+        str += str;
+        CZstdCompression c;
+        AutoArray<char> buf(data.size() * 2 + 1);
+        assert(c.DecompressBuffer(str.data(), str.size(), buf.get(), data.size() * 2 + 1, &out_len));
+        assert(out_len == data.size() * 2);
+        assert(memcmp(buf.get(), data.data(), data.size()) == 0);
+        assert(memcmp(buf.get() + data.size(), data.data(), data.size()) == 0);
+
+        CNcbiIstrstream is_str(str.data(), str.size());
+        CNcbiOstrstream os_cmp;
+        is_str >> MDecompress_Zstd >> os_cmp;
+        assert(CNcbiOstrstreamToString(os_cmp) == data + data);
+        OK_MSG("multi-threaded");
+    }}
+}
+
+#endif  /* HAVE_LIBZSTD */
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Tests for multi-threaded gzip and BGZF
+//
+
+// Decompress gzip file and compare with the source data.
+static void s_CompareGZipFile(const string& filename, const char* src_buf, size_t src_len)
+{
+    CNcbiIfstream is(filename.c_str(), ios::in | ios::binary);
+    assert(is.good());
+    CDecompressIStream zis(is, CCompressStream::eGZipFile);
+    AutoArray<char> buf(src_len + 1);
+    zis.read(buf.get(), src_len + 1 /* more than exists to get EOF */);
+    assert(zis.eof());
+    assert((size_t)zis.gcount() == src_len);
+    assert(memcmp(src_buf, buf.get(), src_len) == 0);
+}
+
+// Read up to 'len' bytes from BGZF reader.
+static size_t s_ReadBGZF(CBGZFReader& reader, char* buf, size_t len)
+{
+    size_t n = 0;
+    while (n < len) {
+        size_t k = 0;
+        ERW_Result res = reader.Read(buf + n, len - n, &k);
+        n += k;
+        if (res != eRW_Success) {
+            assert(res == eRW_Eof);
+            break;
+        }
+    }
+    return n;
+}
+
+
+void CTest::TestZipMT(const char* src_buf, size_t src_len)
+{
+    const string kFileName  = CFile::ConcatPath(m_Dir, "test_compress.mt.file");
+    const string kIndexName = kFileName + ".gzi";
+    CFileDeleteAtExit::Add(kFileName);
+    CFileDeleteAtExit::Add(kIndexName);
+
+    // Multi-threaded gzip, should be readable by regular decompressor.
+    // Use minimal block size to get several blocks on small data,
+    // flush in the middle to get a partial block.
+    {{
+        const unsigned int kThreads[] = { 1, 4 };
+        for (size_t i = 0;  i < ArraySize(kThreads);  ++i) {
+            {{
+                CNcbiOfstream os(kFileName.c_str(), ios::out | ios::binary);
+                CCompressionOStream zos(os,
+                    new CZipMTStreamCompressor(CZipCompression::eLevel_Default,
+                                               kThreads[i], 32 KB,
+                                               kCompressionDefaultBufSize,
+                                               kCompressionDefaultBufSize),
+                    CCompressionStream::fOwnProcessor);
+                size_t half = src_len / 2;
+                zos.write(src_buf, half);
+                zos.flush();
+                zos.write(src_buf + half, src_len - half);
+                zos.Finalize();
+                assert(zos.good());
+                assert(zos.GetProcessedSize() == src_len);
+            }}
+            s_CompareGZipFile(kFileName, src_buf, src_len);
+        }
+        // Using stream method
+        {{
+            CNcbiOfstream os(kFileName.c_str(), ios::out | ios::binary);
+            CCompressOStream zos(os, CCompressStream::eGZipFileMT);
+            zos.write(src_buf, src_len);
+            zos.Finalize();
+            assert(zos.good());
+        }}
+        s_CompareGZipFile(kFileName, src_buf, src_len);
+
+        // Empty data
+        {{
+            CNcbiOstrstream os_str;
+            {{
+                CCompressionOStream zos(os_str,
+                    new CZipMTStreamCompressor(CZipCompression::fAllowEmptyData),
+                    CCompressionStream::fOwnProcessor);
+                zos.Finalize();
+                assert(zos.good());
+            }}
+            string str = CNcbiOstrstreamToString(os_str);
+            assert(str.size() == 20);
+            CZipCompression c;
+            c.SetFlags(CZipCompression::fGZip | CZipCompression::fAllowEmptyData);
+            char buf[16];
+            size_t n = 1;
+            assert(c.DecompressBuffer(str.data(), str.size(), buf, sizeof(buf), &n));
+            assert(n == 0);
+        }}
+        OK_MSG("multi-threaded gzip");
+    }}
+
+    // BGZF
+    {{
+        CBGZFIndex index;
+        {{
+            CNcbiOfstream os(kFileName.c_str(), ios::out | ios::binary);
+            CCompressionOStream zos(os,
+                new CBGZFStreamCompressor(CZipCompression::eLevel_Default, 4,
+                                          0, &index),
+                CCompressionStream::fOwnProcessor);
+            zos.write(src_buf, src_len);
+            zos.Finalize();
+            assert(zos.good());
+        }}
+        // Should be readable as concatenated gzip file
+        s_CompareGZipFile(kFileName, src_buf, src_len);
+
+        // Index collected on compression, built from file and
+        // saved/loaded from .gzi file should be the same
+        assert(index.GetBlocks().size() == (src_len + 0xFF00 - 1) / 0xFF00);
+        CBGZFIndex index_built, index_read;
+        index_built.Build(kFileName);
+        index.Write(kIndexName);
+        index_read.Read(kIndexName);
+        assert(index_built.GetBlocks().size() == index.GetBlocks().size());
+        assert(index_read.GetBlocks().size()  == index.GetBlocks().size());
+        for (size_t i = 0;  i < index.GetBlocks().size();  ++i) {
+            const CBGZFIndex::SBlock& b = index.GetBlocks()[i];
+            assert(index_built.GetBlocks()[i].compressed   == b.compressed);
+            assert(index_built.GetBlocks()[i].uncompressed == b.uncompressed);
+            assert(index_read.GetBlocks()[i].compressed    == b.compressed);
+            assert(index_read.GetBlocks()[i].uncompressed  == b.uncompressed);
+        }
+
+        AutoArray<char> buf(src_len + 1);
+        const unsigned int kThreads[] = { 1, 4 };
+        for (size_t i = 0;  i < ArraySize(kThreads);  ++i) {
+            CBGZFReader reader(kFileName, kThreads[i]);
+            // Sequential reading
+            size_t n = s_ReadBGZF(reader, buf.get(), src_len + 1);
+            assert(n == src_len);
+            assert(memcmp(src_buf, buf.get(), src_len) == 0);
+            // Random access
+            reader.SetIndex(index);
+            for (int k = 0;  k < 20;  ++k) {
+                size_t pos = (size_t)rand() % (src_len + 1);
+                size_t len = min(src_len - pos, (size_t)(100 KB));
+                reader.SeekUncompressed(pos);
+                CBGZFReader::TVirtualOffset voffset = reader.Tell();
+                n = s_ReadBGZF(reader, buf.get(), len);
+                assert(n == len);
+                assert(memcmp(src_buf + pos, buf.get(), len) == 0);
+                // Virtual offset should point to the same data
+                reader.Seek(voffset);
+                n = s_ReadBGZF(reader, buf.get(), len);
+                assert(n == len);
+                assert(memcmp(src_buf + pos, buf.get(), len) == 0);
+            }
+        }
+        OK_MSG("BGZF");
+    }}
+    CFile(kFileName).Remove();
+    CFile(kIndexName).Remove();
+}
+
+
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // MAIN
@@ -108,7 +108,7 @@ bool CTest::TestApp_Args(CArgDescriptions& args)
     args.AddDefaultPositional
         ("lib", "Compression library to test", CArgDescriptions::eString, "all");
     args.SetConstraint
-        ("lib", &(*new CArgAllow_Strings, "all", "z", "bz2", "lzo"));
+        ("lib", &(*new CArgAllow_Strings, "all", "z", "bz2", "lzo", "zstd"));
     return true;
 }
 
@@ -144,6 +144,13 @@ bool CTest::Thread_Run(int idx)
         lzo = false;
     }
 #endif
+    bool zstd = (test == "all" || test == "zstd");
+#if !defined(HAVE_LIBZSTD)
+    if (zstd) {
+        ERR_POST(Warning << "Zstandard is not available on this platform, ignored.");
+        zstd = false;
+    }
+#endif
 
     // Set a random starting point
     unsigned int seed = (unsigned int)time(0);
@@ -202,6 +209,15 @@ bool CTest::Thread_Run(int idx)
                        CZipStreamCompressor,
                        CZipStreamDecompressor> (idx, src_buf, len, kBufLen);
         }
+#if defined(HAVE_LIBZSTD)
+        if ( zstd ) {
+            ERR_POST(Trace << "-------------- Zstd ----------------");
+            TestMethod<CZstdCompression,
+                       CZstdCompressionFile,
+                       CZstdStreamCompressor,
+                       CZstdStreamDecompressor> (idx, src_buf, len, kBufLen);
+        }
+#endif
 
         // Restore saved character
         src_buf[len] = saved;
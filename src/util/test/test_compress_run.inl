@@ -25,6 +25,10 @@
     _VERIFY((unsigned int)CZipCompression::fAllowTransparentRead == 
             (unsigned int)CLZOCompression::fAllowTransparentRead);
 #endif
+#if defined(HAVE_LIBZSTD)
+    _VERIFY((unsigned int)CZipCompression::fAllowTransparentRead == 
+            (unsigned int)CZstdCompression::fAllowTransparentRead);
+#endif
 
     //------------------------------------------------------------------------
     // Version info
@@ -816,6 +820,11 @@
             // method to decompress data compressed using streams/manipulators.
             c.SetFlags(c.GetFlags() | CLZOCompression::fStreamFormat);
         } else 
+#endif
+#if defined(HAVE_LIBZSTD)
+        if (test_name == "zstd") {
+            os_str << MCompress_Zstd << src_buf;
+        } else 
 #endif
         if (test_name == "zlib") {
             os_str << MCompress_Zip << src_buf;
@@ -842,6 +851,11 @@
         if (test_name == "lzo") {
             is_cmp >> MDecompress_LZO >> str_cmp;
         } else 
+#endif
+#if defined(HAVE_LIBZSTD)
+        if (test_name == "zstd") {
+            is_cmp >> MDecompress_Zstd >> str_cmp;
+        } else 
 #endif
         if (test_name == "zlib") {
             is_cmp >> MDecompress_Zip >> str_cmp;
@@ -890,6 +904,11 @@
             if (test_name == "lzo") {
                 os_str << MCompress_LZO << is_str;
             } else 
+    #endif
+    #if defined(HAVE_LIBZSTD)
+            if (test_name == "zstd") {
+                os_str << MCompress_Zstd << is_str;
+            } else 
     #endif
             if (test_name == "zlib") {
                 os_str << MCompress_Zip << is_str;
@@ -917,6 +936,11 @@
             if (test_name == "lzo") {
                 os_cmp << MDecompress_LZO << is_cmp;
             } else 
+    #endif
+    #if defined(HAVE_LIBZSTD)
+            if (test_name == "zstd") {
+                os_cmp << MDecompress_Zstd << is_cmp;
+            } else 
     #endif
             if (test_name == "zlib") {
                 os_cmp << MDecompress_Zip << is_cmp;
@@ -943,6 +967,11 @@
             if (test_name == "lzo") {
                 is_str >> MCompress_LZO >> os_str;
             } else 
+    #endif
+    #if defined(HAVE_LIBZSTD)
+            if (test_name == "zstd") {
+                is_str >> MCompress_Zstd >> os_str;
+            } else 
     #endif
             if (test_name == "zlib") {
                 is_str >> MCompress_Zip >> os_str;
@@ -970,6 +999,11 @@
             if (test_name == "lzo") {
                 is_cmp >> MDecompress_LZO >> os_cmp;
             } else 
+    #endif
+    #if defined(HAVE_LIBZSTD)
+            if (test_name == "zstd") {
+                is_cmp >> MDecompress_Zstd >> os_cmp;
+            } else 
     #endif
             if (test_name == "zlib") {
                 is_cmp >> MDecompress_Zip >> os_cmp;
@@ -1023,6 +1057,11 @@
         if (test_name == "lzo") {
             os << MCompress_LZO << is_str;
         } else 
+#endif
+#if defined(HAVE_LIBZSTD)
+        if (test_name == "zstd") {
+            os << MCompress_Zstd << is_str;
+        } else 
 #endif
         if (test_name == "zlib") {
             os << MCompress_GZipFile << is_str;
@@ -1045,6 +1084,11 @@
         if (test_name == "lzo") {
             is >> MDecompress_LZO >> os_cmp;
         } else 
+#endif
+#if defined(HAVE_LIBZSTD)
+        if (test_name == "zstd") {
+            is >> MDecompress_Zstd >> os_cmp;
+        } else 
 #endif
         if (test_name == "zlib") {
             is >> MDecompress_GZipFile >> os_cmp;
@@ -0,0 +1,207 @@
+/*  $Id$
+* ===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+* Author:  agent
+*
+* File Description:
+*   Unit test for CFlatIntervalIndex class
+*
+* ===========================================================================
+*/
+
+#include <ncbi_pch.hpp>
+
+#include <corelib/ncbifile.hpp>
+#include <util/flat_interval_index.hpp>
+#include <util/random_gen.hpp>
+
+// This header must be included before all Boost.Test headers if there are any
+#include <corelib/test_boost.hpp>
+
+
+USING_NCBI_SCOPE;
+
+
+typedef CFlatIntervalIndex<Uint4> TIndex;
+
+
+static void s_MakeIndex(TIndex&                   index,
+                        vector<TSeqRange>&        ranges,
+                        size_t                    count,
+                        TSeqPos                   length,
+                        TSeqPos                   max_interval,
+                        CRandom&                  rnd)
+{
+    ranges.clear();
+    for (size_t i = 0;  i < count;  ++i) {
+        TSeqPos from = rnd.GetRand(0, length - 1);
+        TSeqPos len = rnd.GetRand(0, max_interval);
+        ranges.push_back(TSeqRange(from, from + len));
+        index.Add(ranges.back(), Uint4(i));
+    }
+    index.Build();
+}
+
+
+// Compare index results with brute force search
+static void s_CheckQueries(const TIndex&            index,
+                           const vector<TSeqRange>& ranges,
+                           TSeqPos                  length,
+                           CRandom&                 rnd)
+{
+    for (int q = 0;  q < 200;  ++q) {
+        TSeqPos from = rnd.GetRand(0, length - 1);
+        TSeqRange query(from, from + rnd.GetRand(0, 1000));
+        vector<Uint4> expected;
+        for (size_t i = 0;  i < ranges.size();  ++i) {
+            if ( ranges[i].IntersectingWith(query) ) {
+                expected.push_back(Uint4(i));
+            }
+        }
+        vector<size_t> hits;
+        index.FindOverlaps(query, hits);
+        vector<Uint4> found;
+        ITERATE(vector<size_t>, it, hits) {
+            BOOST_CHECK(index.GetRange(*it).IntersectingWith(query));
+            found.push_back(index.GetValue(*it));
+        }
+        sort(found.begin(), found.end());
+        BOOST_REQUIRE(found == expected);
+        BOOST_CHECK_EQUAL(index.CountOverlaps(query), expected.size());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestEmpty)
+{
+    TIndex index;
+    index.Build();
+    BOOST_CHECK(index.empty());
+    BOOST_CHECK_EQUAL(index.CountOverlaps(TSeqRange(0, 100)), 0U);
+}
+
+
+BOOST_AUTO_TEST_CASE(TestOverlaps)
+{
+    CRandom rnd(1);
+    // Sizes around powers of 2 exercise incomplete implicit trees
+    size_t sizes[] = { 1, 2, 3, 7, 8, 9, 15, 16, 17, 100, 1023, 1025, 20000 };
+    for (size_t s = 0;  s < ArraySize(sizes);  ++s) {
+        TIndex index;
+        vector<TSeqRange> ranges;
+        s_MakeIndex(index, ranges, sizes[s], 100000, 5000, rnd);
+        BOOST_CHECK_EQUAL(index.size(), sizes[s]);
+        s_CheckQueries(index, ranges, 100000, rnd);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestNested)
+{
+    // Long intervals containing many short ones
+    TIndex index;
+    vector<TSeqRange> ranges;
+    for (TSeqPos i = 0;  i < 1000;  ++i) {
+        ranges.push_back(TSeqRange(i, 100000 - i));
+        ranges.push_back(TSeqRange(i * 100, i * 100 + 10));
+    }
+    for (size_t i = 0;  i < ranges.size();  ++i) {
+        index.Add(ranges[i], Uint4(i));
+    }
+    index.Build();
+    CRandom rnd(2);
+    s_CheckQueries(index, ranges, 100000, rnd);
+}
+
+
+BOOST_AUTO_TEST_CASE(TestBatch)
+{
+    CRandom rnd(3);
+    TIndex index;
+    vector<TSeqRange> ranges;
+    s_MakeIndex(index, ranges, 5000, 100000, 2000, rnd);
+
+    vector<TSeqRange> queries;
+    for (int q = 0;  q < 100;  ++q) {
+        TSeqPos from = rnd.GetRand(0, 99999);
+        queries.push_back(TSeqRange(from, from + 500));
+    }
+    vector<size_t> offsets, hits;
+    index.FindOverlaps(queries, offsets, hits);
+    BOOST_REQUIRE_EQUAL(offsets.size(), queries.size() + 1);
+    BOOST_CHECK_EQUAL(offsets.back(), hits.size());
+    for (size_t q = 0;  q < queries.size();  ++q) {
+        BOOST_CHECK_EQUAL(offsets[q + 1] - offsets[q],
+                          index.CountOverlaps(queries[q]));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestSerialization)
+{
+    CRandom rnd(4);
+    TIndex index;
+    vector<TSeqRange> ranges;
+    s_MakeIndex(index, ranges, 3000, 100000, 3000, rnd);
+
+    // In-memory copy
+    CNcbiOstrstream out;
+    index.Write(out);
+    string data = CNcbiOstrstreamToString(out);
+    TIndex attached;
+    attached.Attach(data.data(), data.size());
+    BOOST_CHECK_EQUAL(attached.size(), index.size());
+    s_CheckQueries(attached, ranges, 100000, rnd);
+
+    // Memory-mapped file
+    string filename = CFile::GetTmpName();
+    {{
+        CNcbiOfstream file(filename.c_str(), IOS_BASE::binary);
+        index.Write(file);
+    }}
+    {{
+        TIndex mapped;
+        mapped.Map(filename);
+        s_CheckQueries(mapped, ranges, 100000, rnd);
+    }}
+    CFile(filename).Remove();
+
+    // Corrupted data
+    TIndex bad;
+    BOOST_CHECK_THROW(bad.Attach(data.data(), 16), CUtilException);
+    BOOST_CHECK_THROW(bad.Attach(data.data(), data.size() - 8),
+                      CUtilException);
+    CFlatIntervalIndex<Uint8> other;
+    BOOST_CHECK_THROW(other.Attach(data.data(), data.size()), CUtilException);
+    // Tree level must match the number of intervals
+    const size_t kMaxLevelOffset = 20;
+    Int4 levels[] = { -1, 10, 12, 63, 64, 1000 };
+    for (size_t i = 0;  i < ArraySize(levels);  ++i) {
+        string bad_level = data;
+        memcpy(&bad_level[kMaxLevelOffset], &levels[i], sizeof(levels[i]));
+        BOOST_CHECK_THROW(bad.Attach(bad_level.data(), bad_level.size()),
+                          CUtilException);
+    }
+}
@@ -248,7 +248,8 @@ static string s_CreateTestFile(vector<string>& lines,
 /** Get one of ILineReader implementations:
  *  1. CMemoryLineReader
  *  2. CStreamLineReader
- *  3. CBufferedLineReader */
+ *  3. CBufferedLineReader
+ *  4. CReadAheadLineReader */
 static CRef<ILineReader> s_GetLineReader(string filename, int type)
 {
     CRef<ILineReader> rdr;
@@ -269,6 +270,11 @@ static CRef<ILineReader> s_GetLineReader(string filename, int type)
         LOG_POST(Error << "CBufferedLineReader");
         rdr = CBufferedLineReader::New(filename);
         break;
+    case 3:
+        LOG_POST(Error << "CReadAheadLineReader");
+        // small buffers to have many lines span buffer boundaries
+        rdr = new CReadAheadLineReader(filename, 4096);
+        break;
     }
     return rdr;
 }
@@ -281,7 +287,7 @@ BOOST_AUTO_TEST_CASE( RunSelfTest )
     vector<string> lines;
     string filename = s_CreateTestFile(lines,
                                        positions);
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
         /* Test itself. For each reader the following behavior is tested:
@@ -325,7 +331,7 @@ BOOST_AUTO_TEST_CASE( PeekCharAfterUnget__ReturnFirstSymbolCurrentLine )
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -371,7 +377,7 @@ BOOST_AUTO_TEST_CASE(PeekCharAfterPlusPlus__FirstCharNextString)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -403,7 +409,7 @@ BOOST_AUTO_TEST_CASE(PeekCharAfterTwicePlusPlus__FirstCharNextNextString)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -440,7 +446,7 @@ BOOST_AUTO_TEST_CASE(PeekCharAfterConstructor__FirstCharFirstString)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -464,7 +470,7 @@ BOOST_AUTO_TEST_CASE(PeekCharEmptyString__ReturnsZero)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
         /* 1. PeekChar
@@ -498,7 +504,7 @@ BOOST_AUTO_TEST_CASE(GetCurrentLineAfterConstructor__NULL)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -522,7 +528,7 @@ BOOST_AUTO_TEST_CASE(GetCurrentLineAfterPlusPlus__FirstLine)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -564,7 +570,7 @@ BOOST_AUTO_TEST_CASE(GetCurrentLineAfterTwicePlusPlus__SecondLine)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -591,7 +597,7 @@ BOOST_AUTO_TEST_CASE(GetCurrentLineAtEOF__NULL)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -620,7 +626,7 @@ BOOST_AUTO_TEST_CASE(GetCurrentLineAfterPlusPlusAtEOF__NULL)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -651,7 +657,7 @@ BOOST_AUTO_TEST_CASE(GetLineNumberAfterConstructor__0)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -674,7 +680,7 @@ BOOST_AUTO_TEST_CASE(GetLineNumberAfterPlusPlus__1)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -711,7 +717,7 @@ BOOST_AUTO_TEST_CASE(GetLineNumberAfterTwicePlusPlus__2)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -737,7 +743,7 @@ BOOST_AUTO_TEST_CASE(GetLineNumberAtEOF__LastNumber)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
@@ -765,7 +771,7 @@ BOOST_AUTO_TEST_CASE(GetLineNumberAfterPlusPlusAtEOF__LastNumber)
     string filename = s_CreateTestFile(lines,
                                        positions);
 
-    for ( int type = 0; type < 3; ++type ) {
+    for ( int type = 0; type < 4; ++type ) {
         CRef<ILineReader> rdr;
         rdr = s_GetLineReader(filename, type);
 
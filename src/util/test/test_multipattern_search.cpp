@@ -0,0 +1,300 @@
+/*  $Id$
+* ===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+* Author:  agent
+*
+* File Description:
+*   Unit test for CMultipatternSearch: the prefilter, multithreaded
+*   and saved FSM searches are compared with the plain FSM scan
+*
+* ===========================================================================
+*/
+
+#include <ncbi_pch.hpp>
+
+#include <corelib/ncbifile.hpp>
+#include <util/multipattern_search.hpp>
+#include <util/random_gen.hpp>
+
+// This header must be included before all Boost.Test headers if there are any
+#include <corelib/test_boost.hpp>
+
+
+USING_NCBI_SCOPE;
+
+
+typedef vector<pair<size_t, size_t>> TFound;
+
+
+static string s_RandomString(CRandom& rnd, const string& alphabet, size_t length)
+{
+    string str;
+    for (size_t i = 0;  i < length;  ++i) {
+        str += alphabet[rnd.GetRand(0, CRandom::TValue(alphabet.size() - 1))];
+    }
+    return str;
+}
+
+
+static TFound s_Search(CMultipatternSearch& fsm, const string& input,
+                       CMultipatternSearch::EPrefilter mode)
+{
+    TFound found;
+    fsm.SetPrefilter(mode);
+    fsm.Search(input, [&found](size_t p, size_t pos) { found.push_back(make_pair(p, pos)); });
+    fsm.SetPrefilter(CMultipatternSearch::ePrefilter_Auto);
+    return found;
+}
+
+
+static TFound s_SearchBuffer(const CMultipatternSearch& fsm, const string& input,
+                             unsigned int threads)
+{
+    TFound found;
+    fsm.SearchBuffer(input.data(), input.size(), [&found](size_t p, size_t pos) { found.push_back(make_pair(p, pos)); }, threads);
+    return found;
+}
+
+
+// Plain FSM scan is the reference for all other search modes
+static void s_CheckPrefilter(CMultipatternSearch& fsm, const string& input)
+{
+    TFound expected = s_Search(fsm, input, CMultipatternSearch::ePrefilter_Off);
+    BOOST_REQUIRE(s_Search(fsm, input, CMultipatternSearch::ePrefilter_Scalar) == expected);
+    BOOST_REQUIRE(s_Search(fsm, input, CMultipatternSearch::ePrefilter_Auto) == expected);
+}
+
+
+// Brute force search of the plain case-sensitive strings;
+// the position reported is that of the last matching character
+static TFound s_BruteForce(const vector<string>& patterns, const string& input)
+{
+    TFound found;
+    for (size_t i = 0;  i < patterns.size();  ++i) {
+        for (size_t pos = input.find(patterns[i]);  pos != NPOS;  pos = input.find(patterns[i], pos + 1)) {
+            found.push_back(make_pair(i, pos + patterns[i].size() - 1));
+        }
+    }
+    sort(found.begin(), found.end(), [](const pair<size_t, size_t>& a, const pair<size_t, size_t>& b) {
+        return a.second < b.second || (a.second == b.second && a.first < b.first); });
+    return found;
+}
+
+
+static TFound s_Sorted(TFound found)
+{
+    stable_sort(found.begin(), found.end(), [](const pair<size_t, size_t>& a, const pair<size_t, size_t>& b) {
+        return a.second < b.second || (a.second == b.second && a.first < b.first); });
+    return found;
+}
+
+
+BOOST_AUTO_TEST_CASE(TestPlainStrings)
+{
+    CRandom rnd(1);
+    // Small alphabet: frequent candidates, the prefilter gives up;
+    // large alphabet: rare candidates, long skips
+    const string alphabets[] = { "acgt", "abcdefghijklmnopqrstuvwxyz .,ACGT" };
+    // Lengths around the SIMD block size exercise the scalar tail
+    size_t lengths[] = { 0, 1, 2, 3, 15, 16, 17, 18, 19, 20, 31, 32, 33, 35, 40, 100, 1000, 100000 };
+    for (int set = 0;  set < 20;  ++set) {
+        vector<string> patterns;
+        size_t count = rnd.GetRand(1, 30);
+        for (size_t i = 0;  i < count;  ++i) {
+            patterns.push_back(s_RandomString(rnd, "acgt", rnd.GetRand(1, 8)));
+        }
+        CMultipatternSearch fsm;
+        fsm.AddPatterns(patterns);
+        for (const string& alphabet : alphabets) {
+            for (size_t length : lengths) {
+                string input = s_RandomString(rnd, alphabet, length);
+                s_CheckPrefilter(fsm, input);
+                BOOST_REQUIRE(s_Sorted(s_Search(fsm, input, CMultipatternSearch::ePrefilter_Auto)) == s_BruteForce(patterns, input));
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFlags)
+{
+    CRandom rnd(2);
+    vector<pair<string, CMultipatternSearch::TFlags>> patterns = {
+        { "tga", 0 },
+        { "CAT", CMultipatternSearch::fNoCase },
+        { "gattaca", CMultipatternSearch::fNoCase },
+        { "acg", CMultipatternSearch::fWholeWord },
+        { "tt", CMultipatternSearch::fBeginString },
+        { "aa", CMultipatternSearch::fEndString }
+    };
+    CMultipatternSearch fsm;
+    fsm.AddPatterns(patterns);
+    for (int i = 0;  i < 2000;  ++i) {
+        s_CheckPrefilter(fsm, s_RandomString(rnd, "acgtACGT  ", rnd.GetRand(0, 200)));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestRegEx)
+{
+    CRandom rnd(3);
+    vector<string> patterns = { "/a[cg]+t/", "/^ac/", "/t{2,3}$/", "/\\bcat\\b/i", "/g.t/" };
+    CMultipatternSearch fsm;
+    fsm.AddPatterns(patterns);
+    for (int i = 0;  i < 2000;  ++i) {
+        s_CheckPrefilter(fsm, s_RandomString(rnd, "acgt ", rnd.GetRand(0, 200)));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestSearchBuffer)
+{
+    CRandom rnd(4);
+    // Large enough to be split between the threads
+    string input = s_RandomString(rnd, "acgtn ", 4 * 1024 * 1024 + 17);
+    {{
+        CMultipatternSearch fsm;
+        fsm.AddPatterns(vector<string>{ "acgtac", "ttt", "gattaca", "/n[ac]{2,5}g/", "/^acg/", "/cat$/" });
+        TFound expected = s_Search(fsm, input, CMultipatternSearch::ePrefilter_Off);
+        BOOST_CHECK(!expected.empty());
+        BOOST_REQUIRE(s_SearchBuffer(fsm, input, 1) == expected);
+        BOOST_REQUIRE(s_SearchBuffer(fsm, input, 3) == expected);
+        BOOST_REQUIRE(s_SearchBuffer(fsm, input, 4) == expected);
+        BOOST_REQUIRE(s_SearchBuffer(fsm, input, 0) == expected);
+        // The end of the buffer is the end of string
+        string tail = input.substr(input.size() - 100);
+        BOOST_REQUIRE(s_SearchBuffer(fsm, tail, 4) == s_Search(fsm, tail, CMultipatternSearch::ePrefilter_Off));
+    }}
+    {{
+        // Unlimited match length: single-threaded fallback
+        CMultipatternSearch fsm;
+        fsm.AddPatterns(vector<string>{ "/ac+g/", "tt" });
+        BOOST_REQUIRE(s_SearchBuffer(fsm, input, 4) == s_Search(fsm, input, CMultipatternSearch::ePrefilter_Off));
+    }}
+}
+
+
+BOOST_AUTO_TEST_CASE(TestSaveLoad)
+{
+    CRandom rnd(5);
+    vector<string> patterns = { "acgt", "gattaca", "cat", "/t[ag]+c/" };
+    CMultipatternSearch fsm;
+    fsm.AddPatterns(patterns);
+    CNcbiOstrstream out;
+    fsm.Save(out);
+    string data = CNcbiOstrstreamToString(out);
+
+    CMultipatternSearch loaded;
+    loaded.Load(data.data(), data.size());
+    string filename = CFile::GetTmpName();
+    {{
+        CNcbiOfstream file(filename.c_str(), IOS_BASE::binary);
+        file.write(data.data(), data.size());
+    }}
+    {{
+        CMultipatternSearch mapped;
+        mapped.Load(filename);
+        for (int i = 0;  i < 200;  ++i) {
+            string input = s_RandomString(rnd, "acgt ", rnd.GetRand(0, 1000));
+            TFound expected = s_Search(fsm, input, CMultipatternSearch::ePrefilter_Off);
+            BOOST_REQUIRE(s_Search(loaded, input, CMultipatternSearch::ePrefilter_Off) == expected);
+            BOOST_REQUIRE(s_Search(loaded, input, CMultipatternSearch::ePrefilter_Auto) == expected);
+            BOOST_REQUIRE(s_Search(mapped, input, CMultipatternSearch::ePrefilter_Scalar) == expected);
+            BOOST_REQUIRE(s_SearchBuffer(mapped, input, 2) == expected);
+        }
+        // Saving the loaded FSM gives the same data
+        CNcbiOstrstream out2;
+        mapped.Save(out2);
+        BOOST_CHECK(CNcbiOstrstreamToString(out2) == data);
+    }}
+    CFile(filename).Remove();
+
+    // The patterns are not available after Load()
+    BOOST_CHECK_THROW(loaded.AddPattern("tt"), string);
+    BOOST_CHECK_THROW(loaded.AddPatterns(patterns), string);
+    CNcbiOstrstream graph;
+    BOOST_CHECK_THROW(loaded.GenerateDotGraph(graph), string);
+    BOOST_CHECK_THROW(loaded.GenerateSourceCode(graph), string);
+}
+
+
+BOOST_AUTO_TEST_CASE(TestLoadCorrupted)
+{
+    CMultipatternSearch fsm;
+    fsm.AddPatterns(vector<string>{ "acgt", "gattaca", "cat" });
+    CNcbiOstrstream out;
+    fsm.Save(out);
+    string data = CNcbiOstrstreamToString(out);
+
+    CMultipatternSearch bad;
+    BOOST_CHECK_THROW(bad.Load(data.data(), 0), string);
+    BOOST_CHECK_THROW(bad.Load(data.data(), 16), string);
+    BOOST_CHECK_THROW(bad.Load(data.data(), data.size() - 1), string);
+
+    // Header: magic[8], byte order, number of states, number of emits,
+    // prefix length, max length; followed by the transition table
+    // and the emit index
+    const size_t kHeaderSize = 32;
+    const size_t kNumStatesOffset = 12;
+    Uint4 num_states;
+    memcpy(&num_states, &data[kNumStatesOffset], sizeof(num_states));
+    const size_t trans_offset = kHeaderSize;
+    const size_t idx_offset = trans_offset + ((num_states * 256 * sizeof(Uint4) + 7) & ~size_t(7));
+
+    Uint4 huge = 0xffffffff;
+    string bad_data = data;
+    memcpy(&bad_data[kNumStatesOffset], &huge, sizeof(huge));
+    BOOST_CHECK_THROW(bad.Load(bad_data.data(), bad_data.size()), string);
+
+    bad_data = data;
+    memcpy(&bad_data[trans_offset + 300 * sizeof(Uint4)], &num_states, sizeof(num_states));
+    BOOST_CHECK_THROW(bad.Load(bad_data.data(), bad_data.size()), string);
+
+    bad_data = data;
+    memcpy(&bad_data[trans_offset + (num_states * 256 - 1) * sizeof(Uint4)], &huge, sizeof(huge));
+    BOOST_CHECK_THROW(bad.Load(bad_data.data(), bad_data.size()), string);
+
+    // Emit index beyond the emit table
+    bad_data = data;
+    memcpy(&bad_data[idx_offset + sizeof(Uint4)], &huge, sizeof(huge));
+    BOOST_CHECK_THROW(bad.Load(bad_data.data(), bad_data.size()), string);
+
+    bad_data = data;
+    Uint4 too_many;
+    memcpy(&too_many, &data[idx_offset + num_states * sizeof(Uint4)], sizeof(too_many));
+    ++too_many;
+    memcpy(&bad_data[idx_offset + num_states * sizeof(Uint4)], &too_many, sizeof(too_many));
+    BOOST_CHECK_THROW(bad.Load(bad_data.data(), bad_data.size()), string);
+
+    // The failed Load() leaves the FSM intact
+    TFound found;
+    bad.AddPattern("cat");
+    bad.Search("concatenate", [&found](size_t p, size_t pos) { found.push_back(make_pair(p, pos)); });
+    BOOST_REQUIRE_EQUAL(found.size(), 1U);
+    BOOST_CHECK_EQUAL(found[0].second, 5U);
+
+    // The original data still loads
+    bad.Load(data.data(), data.size());
+}
@@ -0,0 +1,265 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Authors: agent
+ *
+ * File Description:
+ *   CMappedRowReader unit test. The results are compared with the
+ *   CRowReader<> results for the same data.
+ *
+ * ===========================================================================
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/test_boost.hpp>
+#include <corelib/ncbifile.hpp>
+
+#include <util/row_reader_mapped.hpp>
+#include <util/row_reader_ncbi_tsv.hpp>
+#include <util/row_reader_iana_csv.hpp>
+#include <util/random_gen.hpp>
+#include <common/test_assert.h>  /* This header must go last */
+
+BEGIN_NCBI_SCOPE
+BOOST_AUTO_TEST_SUITE(CMappedRowReader_Unit_Test)
+
+
+// Read the data with both readers and compare the rows
+template <typename TTraits>
+static size_t s_Compare(const string&           data,
+                        const SRR_MappedFormat& format,
+                        unsigned int            threads = 1,
+                        size_t                  chunk_size = 1024 * 1024)
+{
+    CNcbiIstrstream       data_stream(data.c_str());
+    CRowReader<TTraits>   stream(&data_stream, "");
+    CMappedRowReader      mapped(data.data(), data.size(), format);
+    mapped.SetThreads(threads);
+    mapped.SetChunkSize(chunk_size);
+
+    size_t  rows = 0;
+    for (auto &  row : stream) {
+        BOOST_REQUIRE(mapped.Next());
+        const CRR_MappedRow& mapped_row = mapped.GetRow();
+        BOOST_CHECK_EQUAL(mapped_row.GetType(), row.GetType());
+        BOOST_CHECK_EQUAL(mapped_row.GetOriginalData(),
+                          row.GetOriginalData());
+        BOOST_CHECK_EQUAL(mapped_row.GetLineNo(),
+                          stream.GetCurrentLineNo());
+        BOOST_REQUIRE_EQUAL(mapped_row.GetNumberOfFields(),
+                            row.GetNumberOfFields());
+        for (TFieldNo i = 0;  i < row.GetNumberOfFields();  ++i) {
+            BOOST_CHECK_EQUAL(mapped_row[i].IsNull(), row[i].IsNull());
+            if ( !row[i].IsNull() ) {
+                BOOST_CHECK_EQUAL(mapped_row[i].Get<string>(),
+                                  row[i].template Get<string>());
+            }
+        }
+        ++rows;
+    }
+    BOOST_CHECK( !mapped.Next() );
+
+    auto field_info = stream.GetFieldsMetaInfo();
+    const vector<string>& names = mapped.GetFieldNames();
+    BOOST_REQUIRE_EQUAL(names.size(), field_info.size());
+    for (size_t i = 0;  i < names.size();  ++i) {
+        BOOST_CHECK_EQUAL(names[i], field_info[i].name);
+    }
+    return rows;
+}
+
+
+BOOST_AUTO_TEST_CASE(MAPPED_EMPTY)
+{
+    CMappedRowReader    reader(nullptr, 0);
+    for (auto &  row : reader) {
+        BOOST_FAIL("The source is empty. Row data: " +
+                   row.GetOriginalData());
+    }
+    BOOST_CHECK(reader.GetFieldNames().empty());
+}
+
+
+BOOST_AUTO_TEST_CASE(MAPPED_NCBI_TSV)
+{
+    string  data = "\n\n#Name\tAge\tAddress\n"
+                   "Paul\t23\t1115 W Franklin\r\n"
+                   "## metadata\n"
+                   "\n"
+                   "Bessy the Cow\tna\t-\n"
+                   "# comment\n"
+                   "\t\t\n"
+                   "Zeke\t45\tW Main St";
+    BOOST_CHECK_EQUAL(
+        s_Compare<CRowReaderStream_NCBI_TSV>(data,
+                                             SRR_MappedFormat::NCBI_TSV()),
+        6U);
+
+    CMappedRowReader    reader(data.data(), data.size());
+    BOOST_REQUIRE(reader.Next());
+    BOOST_CHECK_EQUAL(reader.GetRow()["Age"].Get<int>(), 23);
+    BOOST_REQUIRE(reader.Next());
+    BOOST_CHECK_EQUAL(reader.GetRow().GetType(), eRR_Metadata);
+    BOOST_REQUIRE(reader.Next());
+    const CRR_MappedRow& row = reader.GetRow();
+    BOOST_CHECK_EQUAL(row.GetLineNo(), 6U);
+    BOOST_CHECK(row["Age"].IsNull());
+    BOOST_CHECK_EQUAL(row["Age"].GetWithDefault<int>(-1), -1);
+    BOOST_CHECK_THROW(row["Age"].Get<int>(), CRowReaderException);
+    BOOST_CHECK(row["Address"].GetValue().empty());
+    BOOST_CHECK_EQUAL(row["Address"].GetOriginalData(), "-");
+    BOOST_CHECK_THROW(row[3], CRowReaderException);
+    BOOST_CHECK_THROW(row["Phone"], CRowReaderException);
+    BOOST_CHECK_THROW(row[0].Get<int>(), CRowReaderException);
+}
+
+
+BOOST_AUTO_TEST_CASE(MAPPED_IANA_CSV)
+{
+    string  data = "Name,\"Age\",Address\r\n"
+                   "Paul,23,\"1115 W Franklin, \"\"Apt\"\" 1\"\r\n"
+                   "\"Bessy\nthe Cow\",5,\"\"\n"
+                   "\n"
+                   "Zeke,,\"W\r\nMain\"\"\"";
+    BOOST_CHECK_EQUAL(
+        s_Compare<CRowReaderStream_IANA_CSV>(data,
+                                             SRR_MappedFormat::IANA_CSV()),
+        3U);
+
+    CMappedRowReader    reader(data.data(), data.size(),
+                               SRR_MappedFormat::IANA_CSV());
+    BOOST_REQUIRE(reader.Next());
+    BOOST_CHECK_EQUAL(reader.GetRow()["Address"].GetValue(),
+                      "1115 W Franklin, \"Apt\" 1");
+    BOOST_REQUIRE(reader.Next());
+    BOOST_CHECK_EQUAL(reader.GetRow().GetLineNo(), 2U);
+    BOOST_CHECK_EQUAL(reader.GetRow()["Name"].GetValue(), "Bessy\nthe Cow");
+    BOOST_REQUIRE(reader.Next());
+    BOOST_CHECK_EQUAL(reader.GetRow().GetLineNo(), 5U);
+    BOOST_CHECK_EQUAL(reader.GetRow().GetRowPos(), data.find("Zeke"));
+    BOOST_CHECK( !reader.Next() );
+}
+
+
+BOOST_AUTO_TEST_CASE(MAPPED_IANA_CSV_ERRORS)
+{
+    const char* bad[] = {
+        "a,b\n1,2\n3,\"4\n",
+        "a,b\n1,2\n3,4\"5\"\n",
+        "a,b\n1,2\n3,\"4\"5\n"
+    };
+    for (size_t i = 0;  i < ArraySize(bad);  ++i) {
+        CMappedRowReader    reader(bad[i], strlen(bad[i]),
+                                   SRR_MappedFormat::IANA_CSV());
+        // The rows before the error are delivered
+        BOOST_REQUIRE(reader.Next());
+        BOOST_CHECK_EQUAL(reader.GetRow().GetOriginalData(), "1,2");
+        BOOST_CHECK_THROW(reader.Next(), CRowReaderException);
+        BOOST_CHECK( !reader.Next() );
+    }
+}
+
+
+// Random CSV with quoted fields, separators and line breaks in the fields
+static string s_MakeCSV(CRandom& rnd, size_t rows)
+{
+    static const char* kValues[] = {
+        "", "1", "-17", "3.14", "abc", "\"x,y\"", "\"line\nbreak\"",
+        "\"q\"\"uote\"", "\"\"", "\"\r\n\"", "\"tail\"\"\"", "word word"
+    };
+    string data = "id,a,b,c\n";
+    for (size_t row = 0;  row < rows;  ++row) {
+        data += NStr::NumericToString(row);
+        size_t fields = rnd.GetRand(0, 4);
+        for (size_t field = 0;  field < fields;  ++field) {
+            data += ',';
+            data += kValues[rnd.GetRand(0, ArraySize(kValues) - 1)];
+        }
+        data += rnd.GetRand(0, 3) == 0 ? "\r\n" : "\n";
+        if (rnd.GetRand(0, 20) == 0)
+            data += "\n";
+    }
+    return data;
+}
+
+
+BOOST_AUTO_TEST_CASE(MAPPED_PARALLEL)
+{
+    CRandom     rnd(1);
+    string      data = s_MakeCSV(rnd, 20000);
+    size_t      rows = s_Compare<CRowReaderStream_IANA_CSV>(
+                            data, SRR_MappedFormat::IANA_CSV());
+    BOOST_CHECK_EQUAL(rows, 20000U);
+
+    // Small chunks so that the boundaries fall into quoted fields
+    size_t      chunk_sizes[] = { 1, 7, 100, 4096 };
+    for (size_t i = 0;  i < ArraySize(chunk_sizes);  ++i) {
+        BOOST_CHECK_EQUAL(s_Compare<CRowReaderStream_IANA_CSV>(
+                              data, SRR_MappedFormat::IANA_CSV(),
+                              1, chunk_sizes[i]), rows);
+        BOOST_CHECK_EQUAL(s_Compare<CRowReaderStream_IANA_CSV>(
+                              data, SRR_MappedFormat::IANA_CSV(),
+                              4, chunk_sizes[i]), rows);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(MAPPED_FILE)
+{
+    string      filename = CFile::GetTmpName();
+    string      data = "#id\tvalue\n";
+    for (int i = 0;  i < 100000;  ++i) {
+        data += NStr::IntToString(i) + "\t" +
+                (i % 10 == 0 ? string("na") : NStr::IntToString(i * 2)) +
+                "\n";
+    }
+    {{
+        CNcbiOfstream   file(filename.c_str(), IOS_BASE::binary);
+        file << data;
+    }}
+
+    {{
+        CMappedRowReader    reader(filename);
+        reader.SetThreads(3);
+        reader.SetChunkSize(10000);
+        int     count = 0;
+        for (auto &  row : reader) {
+            BOOST_REQUIRE_EQUAL(row["id"].Get<int>(), count);
+            BOOST_REQUIRE_EQUAL(row["value"].GetWithDefault<int>(-1),
+                                count % 10 == 0 ? -1 : count * 2);
+            BOOST_REQUIRE_EQUAL(row.GetLineNo(), TLineNo(count + 1));
+            ++count;
+        }
+        BOOST_CHECK_EQUAL(count, 100000);
+    }}
+    CFile(filename).Remove();
+
+    BOOST_CHECK_THROW(CMappedRowReader("/nonexistent/file.tsv"),
+                      CRowReaderException);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+END_NCBI_SCOPE
@@ -34,6 +34,7 @@
 #include <corelib/ncbiapp.hpp>
 #include <corelib/ncbiargs.hpp>
 #include <util/row_reader_char_delimited.hpp>
+#include <util/row_reader_mapped.hpp>
 #include <stdio.h>
 
 #include <common/test_assert.h>  /* This header must go last */
@@ -48,6 +49,7 @@ public:
     void Init(void);
     int Run(void);
     void Read(const string& fname);
+    void ReadMapped(const string& fname, unsigned int threads);
 };
 
 
@@ -67,6 +69,9 @@ void CRowReaderPerfTest::Init(void)
     d->AddDefaultKey("i", "items",
                      "data items in each row",
                      CArgDescriptions::eInteger, "20");
+    d->AddDefaultKey("threads", "threads",
+                     "number of CMappedRowReader threads",
+                     CArgDescriptions::eInteger, "4");
     SetupArgDescriptions(d.release());
 }
 
@@ -101,7 +106,21 @@ int CRowReaderPerfTest::Run(void)
     }
     fclose(f);
 
+    CStopWatch  sw(CStopWatch::eStart);
     Read(fname);
+    NcbiCout << "CRowReader time (sec): " << sw.Elapsed() << NcbiEndl;
+
+    sw.Restart();
+    ReadMapped(fname, 1);
+    NcbiCout << "CMappedRowReader time (sec): " << sw.Elapsed() << NcbiEndl;
+
+    unsigned int threads = args["threads"].AsInteger();
+    if (threads > 1) {
+        sw.Restart();
+        ReadMapped(fname, threads);
+        NcbiCout << "CMappedRowReader time with " << threads
+                 << " threads (sec): " << sw.Elapsed() << NcbiEndl;
+    }
 
     remove(fname.c_str());
     return 0;
@@ -135,6 +154,33 @@ void CRowReaderPerfTest::Read(const string& fname)
 }
 
 
+void CRowReaderPerfTest::ReadMapped(const string& fname, unsigned int threads)
+{
+    Int8    read_row_count = 0;
+    Int8    read_field_count = 0;
+    CMappedRowReader    src_stream(fname, SRR_MappedFormat(' '));
+    src_stream.SetThreads(threads);
+    for (auto &  row : src_stream) {
+        ++read_row_count;
+
+        auto field_count = row.GetNumberOfFields();
+        for (TFieldNo  fno = 0; fno < field_count; ++fno) {
+            ++read_field_count;
+
+            if (row[fno].Get<int>() != static_cast<int>(fno))
+                NcbiCerr << "Error reading integer field number " << fno
+                         << " Read value: " << row[fno].Get<int>() << NcbiEndl;
+            if (row[fno].Get<CTempString>().length() > 1000000)
+                NcbiCerr << "Error reading field number " << fno
+                         << " as CTempString." << NcbiEndl;
+        }
+    }
+
+    NcbiCout << "Number of rows read: " << read_row_count << NcbiEndl
+             << "Number of fields read: " << read_field_count << NcbiEndl;
+}
+
+
 int main(int argc, const char* argv[])
 {
     CRowReaderPerfTest app;
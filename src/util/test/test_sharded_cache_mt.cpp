@@ -0,0 +1,294 @@
+/*  $Id$
+ * ===========================================================================
+ *
+ *                            PUBLIC DOMAIN NOTICE
+ *               National Center for Biotechnology Information
+ *
+ *  This software/database is a "United States Government Work" under the
+ *  terms of the United States Copyright Act.  It was written as part of
+ *  the author's official duties as a United States Government employee and
+ *  thus cannot be copyrighted.  This software/database is freely available
+ *  to the public for use. The National Library of Medicine and the U.S.
+ *  Government have not placed any restriction on its use or reproduction.
+ *
+ *  Although all reasonable efforts have been taken to ensure the accuracy
+ *  and reliability of the software and data, the NLM and the U.S.
+ *  Government do not and cannot warrant the performance or results that
+ *  may be obtained by using this software or data. The NLM and the U.S.
+ *  Government disclaim all warranties, express or implied, including
+ *  warranties of performance, merchantability or fitness for any particular
+ *  purpose.
+ *
+ *  Please cite the author in any work or product based on this material.
+ *
+ * ===========================================================================
+ *
+ * Author: agent
+ *
+ * File Description:
+ *   Test and benchmark for CShardedCache<>, compared to CCache<>
+ *
+ */
+
+#include <ncbi_pch.hpp>
+#include <corelib/test_mt.hpp>
+#include <util/ncbi_sharded_cache.hpp>
+#include <util/random_gen.hpp>
+
+#include <common/test_assert.h>  /* This header must go last */
+
+USING_NCBI_SCOPE;
+
+
+typedef CShardedCache<Uint8, Uint8> TShardedCache;
+typedef CCache<Uint8, Uint8>        TCache;
+
+
+// Value stored for a key, to verify lookups
+static inline Uint8 s_Value(Uint8 key)
+{
+    return key * 7 + 1;
+}
+
+
+// Weight of an element with the given key
+static inline Uint8 s_Weight(Uint8 key)
+{
+    return key % 4 + 1;
+}
+
+
+static void s_TestSingleThread(ECacheEviction eviction)
+{
+    // One shard to make the eviction order predictable
+    TShardedCache cache(10, eviction, 1);
+    Uint8 value = 0;
+    assert( !cache.Get(1, value) );
+    for (Uint8 i = 1;  i <= 10;  ++i) {
+        assert(cache.Add(i, s_Value(i)));
+    }
+    assert(cache.GetSize() == 10);
+    assert(cache.GetWeight() == 10);
+    for (Uint8 i = 1;  i <= 10;  ++i) {
+        assert(cache.Get(i, value)  &&  value == s_Value(i));
+    }
+    // Element heavier than the cache is never stored
+    assert( !cache.Add(100, 0, 11) );
+    assert( !cache.Get(100, value) );
+
+    // Weight-based capacity
+    for (Uint8 i = 1;  i <= 5;  ++i) {
+        cache.Get(1, value);
+        cache.Get(2, value);
+    }
+    cache.Add(11, s_Value(11), 5);
+    cache.Add(11, s_Value(11), 5);
+    assert(cache.GetWeight() <= 10);
+    assert(cache.Get(1, value)  &&  value == s_Value(1));
+    assert(cache.Get(2, value)  &&  value == s_Value(2));
+    if (eviction == eCacheEvict_LRU) {
+        assert( !cache.Get(3, value) );
+    }
+
+    // Replacement and removal
+    assert(cache.Add(1, 12345));
+    assert(cache.Get(1, value)  &&  value == 12345);
+    assert(cache.Remove(1));
+    assert( !cache.Remove(1) );
+    assert( !cache.Get(1, value) );
+
+    SCacheStats stats = cache.GetStats(true);
+    assert(stats.m_Rejections >= 1);
+    assert(stats.m_Weight <= 10);
+    assert(cache.GetStats().m_Hits == 0);
+
+    // Expiration
+    TShardedCache ttl_cache(10, eviction, 1);
+    assert(ttl_cache.Add(20, s_Value(20), 1, CTimeSpan(0.001)));
+    assert(ttl_cache.Get(20, value));
+    SleepMilliSec(50);
+    assert( !ttl_cache.Get(20, value) );
+    ttl_cache.Add(21, s_Value(21), 1, CTimeSpan(0.001));
+    ttl_cache.Add(22, s_Value(22));
+    SleepMilliSec(50);
+    ttl_cache.PurgeExpired();
+    stats = ttl_cache.GetStats();
+    assert(stats.m_Expirations == 2);
+    assert(stats.m_Count == 1);
+
+    cache.SetCapacity(4);
+    assert(cache.GetWeight() <= 4);
+    cache.Clear();
+    assert(cache.GetSize() == 0);
+}
+
+
+class CTestShardedCacheApp : public CThreadedApp
+{
+public:
+    virtual bool Thread_Run(int idx);
+protected:
+    virtual bool TestApp_Init(void);
+    virtual bool TestApp_Exit(void);
+    virtual bool TestApp_Args(CArgDescriptions& args);
+private:
+    Uint8  m_Keys;
+    Uint8  m_Operations;
+    bool   m_Bench;
+
+    unique_ptr<TShardedCache> m_ShardedCache;
+    unique_ptr<TCache>        m_Cache;
+    CAtomicCounter            m_ShardedTime;  // microseconds
+    CAtomicCounter            m_CacheTime;
+};
+
+
+// Skewed key distribution: most lookups go to a small set of hot keys
+static inline Uint8 s_GetKey(CRandom& rnd, Uint8 keys)
+{
+    Uint8 range = keys;
+    while (range > 16  &&  rnd.GetRand(0, 3) != 0) {
+        range /= 4;
+    }
+    return rnd.GetRand(0, CRandom::TValue(range - 1));
+}
+
+
+template<class TCacheType>
+static void s_GetOrAdd(TCacheType& cache, Uint8 key);
+
+template<>
+void s_GetOrAdd(TShardedCache& cache, Uint8 key)
+{
+    Uint8 value = 0;
+    if ( cache.Get(key, value) ) {
+        assert(value == s_Value(key));
+    }
+    else {
+        cache.Add(key, s_Value(key), s_Weight(key));
+    }
+}
+
+template<>
+void s_GetOrAdd(TCache& cache, Uint8 key)
+{
+    TCache::EGetResult result;
+    Uint8 value = cache.Get(key, TCache::fGet_NoInsert, &result);
+    if (result == TCache::eGet_Found) {
+        assert(value == s_Value(key));
+    }
+    else {
+        cache.Add(key, s_Value(key), TCache::TWeight(s_Weight(key)));
+    }
+}
+
+
+bool CTestShardedCacheApp::Thread_Run(int idx)
+{
+    CRandom rnd(idx + 1);
+    CStopWatch sw(CStopWatch::eStart);
+    for (Uint8 i = 0;  i < m_Operations;  ++i) {
+        s_GetOrAdd(*m_ShardedCache, s_GetKey(rnd, m_Keys));
+    }
+    m_ShardedTime.Add(CAtomicCounter::TValue(sw.Elapsed() * 1e6));
+    if ( m_Cache ) {
+        rnd.SetSeed(idx + 1);
+        sw.Restart();
+        for (Uint8 i = 0;  i < m_Operations;  ++i) {
+            s_GetOrAdd(*m_Cache, s_GetKey(rnd, m_Keys));
+        }
+        m_CacheTime.Add(CAtomicCounter::TValue(sw.Elapsed() * 1e6));
+    }
+    return true;
+}
+
+
+bool CTestShardedCacheApp::TestApp_Init(void)
+{
+    NcbiCout << NcbiEndl
+             << "Testing sharded cache with "
+             << NStr::IntToString(s_NumThreads)
+             << " threads..."
+             << NcbiEndl;
+
+    s_TestSingleThread(eCacheEvict_LRU);
+    s_TestSingleThread(eCacheEvict_ARC);
+    s_TestSingleThread(eCacheEvict_TinyLFU);
+
+    const CArgs& args = GetArgs();
+    m_Keys = args["keys"].AsInt8();
+    m_Operations = args["operations"].AsInt8();
+    m_Bench = args["bench"];
+    Uint8 capacity = args["capacity"].AsInt8();
+    ECacheEviction eviction = eCacheEvict_LRU;
+    if (args["eviction"].AsString() == "arc") {
+        eviction = eCacheEvict_ARC;
+    }
+    else if (args["eviction"].AsString() == "tinylfu") {
+        eviction = eCacheEvict_TinyLFU;
+    }
+    m_ShardedCache.reset(new TShardedCache(capacity, eviction));
+    if ( m_Bench ) {
+        // CCache counts elements, convert capacity using average weight
+        m_Cache.reset(new TCache(TCache::TSizeType(capacity * 2 / 5)));
+    }
+    m_ShardedTime.Set(0);
+    m_CacheTime.Set(0);
+    return true;
+}
+
+
+bool CTestShardedCacheApp::TestApp_Args(CArgDescriptions& args)
+{
+    args.AddDefaultKey("keys", "Keys",
+        "Number of distinct keys",
+        CArgDescriptions::eInt8, "100000");
+    args.AddDefaultKey("operations", "Operations",
+        "Number of lookups per thread",
+        CArgDescriptions::eInt8, "200000");
+    args.AddDefaultKey("capacity", "Capacity",
+        "Total weight of cached elements",
+        CArgDescriptions::eInt8, "50000");
+    args.AddDefaultKey("eviction", "Eviction",
+        "Eviction policy",
+        CArgDescriptions::eString, "lru");
+    args.SetConstraint("eviction",
+        &(*new CArgAllow_Strings, "lru", "arc", "tinylfu"));
+    args.AddFlag("bench",
+        "Run the same workload against CCache<> and compare timing");
+    return true;
+}
+
+
+bool CTestShardedCacheApp::TestApp_Exit(void)
+{
+    SCacheStats stats = m_ShardedCache->GetStats();
+    assert(stats.m_Weight <= m_ShardedCache->GetCapacity());
+    assert(stats.m_Hits + stats.m_Misses == m_Operations * s_NumThreads);
+    NcbiCout << "CShardedCache: " << m_ShardedCache->GetShardCount()
+             << " shards, hits: " << stats.m_Hits
+             << ", misses: " << stats.m_Misses
+             << ", evictions: " << stats.m_Evictions
+             << ", rejections: " << stats.m_Rejections
+             << NcbiEndl;
+    if ( m_Bench ) {
+        NcbiCout << "Thread time (sec) CShardedCache: "
+                 << m_ShardedTime.Get() / 1e6
+                 << ", CCache: " << m_CacheTime.Get() / 1e6
+                 << NcbiEndl;
+    }
+    NcbiCout << "Test completed successfully!"
+             << NcbiEndl << NcbiEndl;
+    return true;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    CTestShardedCacheApp app;
+    return app.AppMain(argc, argv);
+}
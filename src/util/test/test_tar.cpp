@@ -240,6 +240,15 @@ void CTarTest::Init(void)
                   " [non-standard]");
     args->AddFlag("Z", "No NCBI signature in headers"
                   " [non-standard]");
+    args->AddDefaultKey ("j", "threads",
+                         "Number of threads to write out extracted files"
+                         " (0 = number of CPUs)",
+                         CArgDescriptions::eInteger, "1");
+    args->SetConstraint ("j", new CArgAllow_Integers(0, 256));
+    args->AddOptionalKey("N", "index_file",
+                         "Member index file to save with -t,"
+                         " or to use with -x for random access"
+                         " [non-standard]", CArgDescriptions::eString);
     args->AddFlag("v", "Turn on debugging information");
     args->AddFlag("lfs","Large File Support check; ignore all other parameters"
                   " [non-standard]");
@@ -718,7 +727,20 @@ int CTarTest::Run(void)
                 }
                 tar->SetMask(mask.release(), eTakeOwnership);
             }
-            if (action == eList) {
+            if (action == eList  &&  args["N"].HasValue()) {
+                unique_ptr<CTar::TIndex> index = tar->BuildIndex();
+                CNcbiOfstream of(args["N"].AsString().c_str(),
+                                 IOS_BASE::trunc | IOS_BASE::out);
+                CTar::WriteIndex(*index, of);
+                if (m_Flags & fVerbose) {
+                    ITERATE(CTar::TIndex, it, *index.get()) {
+                        NcbiCerr << it->first << " at block "
+                                 << NStr::UInt8ToString(it->second >> 9,
+                                                        NStr::fWithCommas)
+                                 << NcbiEndl;
+                    }
+                }
+            } else if (action == eList) {
                 if (stream) {
                     const CTarEntryInfo* info;
                     while ((info = tar->GetNextEntryInfo()) != 0) {
@@ -765,7 +787,31 @@ int CTarTest::Run(void)
                         NCBI_THROW(CTarException, eWrite, errmsg);
                     }
                 }
+            } else if (args["N"].HasValue()) {
+                if (!n) {
+                    NCBI_THROW(CArgException, eInvalidArg,
+                               "Must specify entries to extract by index");
+                }
+                CNcbiIfstream inf(args["N"].AsString().c_str());
+                if (!inf.good()) {
+                    NCBI_THROW(CTarException, eOpen, "Index not found");
+                }
+                unique_ptr<CTar::TIndex> index = CTar::ReadIndex(inf);
+                for (size_t i = 1;  i <= n;  ++i) {
+                    unique_ptr<CTar::TEntries> entries
+                        = tar->Extract(*index, args[i].AsString());
+                    if (entries->empty()) {
+                        NCBI_THROW(CTarException, eBadName,
+                                   "Entry \"" + args[i].AsString()
+                                   + "\" not extracted");
+                    }
+                    if (m_Flags & fVerbose) {
+                        NcbiCerr << "x " << entries->front().GetName()
+                            + x_Pos(entries->front()) << NcbiEndl;
+                    }
+                }
             } else {
+                tar->SetThreads((unsigned int) args["j"].AsInteger());
                 unique_ptr<CTar::TEntries> entries = tar->Extract();
                 if (m_Flags & fVerbose) {
                     ITERATE(CTar::TEntries, it, *entries.get()) {
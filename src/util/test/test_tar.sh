@@ -164,6 +164,24 @@ dd if=$test_base.tar bs=4567 | $test_tar -C $test_base.2 -v -x -f -
 rm -f $test_base.1/.testfifo $test_base.2/.testfifo
 diff -r $test_base.1 $test_base.2 2>/dev/null                                            ||  exit 1
 
+echo
+echo "`date` *** Checking multi-threaded extraction"
+echo
+
+mkdir $test_base.3                                                                       ||  exit 1
+$test_tar -C $test_base.3 -j 4 -v -x -f $test_base.tar                                   ||  exit 1
+rm -f $test_base.3/.testfifo
+diff -r $test_base.1 $test_base.3 2>/dev/null                                            ||  exit 1
+
+echo
+echo "`date` *** Checking indexed extraction"
+echo
+
+$test_tar -t -N $test_base.idx -f $test_base.tar                                         ||  exit 1
+mkdir $test_base.4                                                                       ||  exit 1
+$test_tar -C $test_base.4 -x -v -N $test_base.idx -f $test_base.tar newdir/datefile      ||  exit 1
+cmp $test_base.1/newdir/datefile $test_base.4/newdir/datefile                            ||  exit 1
+
 echo
 echo "`date` *** Checking piping out and compatibility with native tar utility"
 echo
@@ -85,6 +85,7 @@ static bool                              s_ZeroSleep = false;
 class CThreadPoolTester : public CThreadedApp
 {
 protected:
+    virtual bool TestApp_Args(CArgDescriptions& args);
     virtual bool TestApp_Init(void);
     virtual bool TestApp_Exit(void);
     virtual bool Thread_Run(int idx);
@@ -152,6 +153,13 @@ private:
     unsigned m_SleepTime;
 };
 
+// Both scheduling modes must pass all the tests
+static CThreadPool::EScheduling s_GetScheduling(const string& name)
+{
+    return name == "stealing" ? CThreadPool::eWorkStealing
+                              : CThreadPool::eGlobalQueue;
+}
+
 inline
 void CThreadPoolTester::GetMinMaxThreads
 (unsigned* min_threads, unsigned* max_threads)
@@ -166,6 +174,17 @@ void CThreadPoolTester::GetMinMaxThreads
 }
 
 
+bool CThreadPoolTester::TestApp_Args(CArgDescriptions& args)
+{
+    args.AddDefaultKey("scheduling", "Scheduling",
+        "Scheduling mode of the pool in the main test",
+        CArgDescriptions::eString, "global");
+    args.SetConstraint("scheduling",
+        &(*new CArgAllow_Strings, "global", "stealing"));
+    return true;
+}
+
+
 bool CThreadPoolTester::TestApp_Init(void)
 {
     s_Timer.Start();
@@ -182,9 +201,14 @@ bool CThreadPoolTester::TestApp_Init(void)
     for (unsigned j = 0; j < 300; j++) {
         unsigned min_threads, max_threads;
         GetMinMaxThreads(&min_threads, &max_threads);
+        // Rounds alternate between the scheduling modes
+        CThreadPool::EScheduling scheduling = (j % 2)
+            ? CThreadPool::eWorkStealing : CThreadPool::eGlobalQueue;
         MSG_POST("Terminator task test. Round: " << j <<
-                 ", min/max threads: " << min_threads << "/" << max_threads);
-        CThreadPool tp(100, max_threads, min_threads);
+                 ", min/max threads: " << min_threads << "/" << max_threads <<
+                 ", scheduling: " << scheduling);
+        CThreadPool tp(100, max_threads, min_threads, CThread::fRunDefault,
+                       scheduling);
         _ASSERT(s_TaskCounter.Get() == 0);
         for (unsigned i = 0;  i < 98;  i++) {
             tp.AddTask(new CSentinelThreadPool_Task(i));
@@ -230,7 +254,11 @@ bool CThreadPoolTester::TestApp_Init(void)
 
 
     //
-    s_Pool = new CThreadPool(kQueueSize, kMaxThreads);
+    CThreadPool::EScheduling scheduling
+        = s_GetScheduling(GetArgs()["scheduling"].AsString());
+    MSG_POST("Main test scheduling: " << scheduling);
+    s_Pool = new CThreadPool(kQueueSize, kMaxThreads, 2, CThread::fRunDefault,
+                             scheduling);
 
     if (s_NumThreads > kQueueSize) {
         s_NumThreads = kQueueSize;
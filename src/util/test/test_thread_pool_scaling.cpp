@@ -0,0 +1,366 @@
+/*  $Id$
+* ===========================================================================
+*
+*                            PUBLIC DOMAIN NOTICE
+*               National Center for Biotechnology Information
+*
+*  This software/database is a "United States Government Work" under the
+*  terms of the United States Copyright Act.  It was written as part of
+*  the author's official duties as a United States Government employee and
+*  thus cannot be copyrighted.  This software/database is freely available
+*  to the public for use. The National Library of Medicine and the U.S.
+*  Government have not placed any restriction on its use or reproduction.
+*
+*  Although all reasonable efforts have been taken to ensure the accuracy
+*  and reliability of the software and data, the NLM and the U.S.
+*  Government do not and cannot warrant the performance or results that
+*  may be obtained by using this software or data. The NLM and the U.S.
+*  Government disclaim all warranties, express or implied, including
+*  warranties of performance, merchantability or fitness for any particular
+*  purpose.
+*
+*  Please cite the author in any work or product based on this material.
+*
+* ===========================================================================
+*
+* Author:  agent
+*
+* File Description:
+*   Test of CThreadPool scheduling modes and benchmark of their scaling
+*   with many small tasks.
+*
+* ===========================================================================
+*/
+
+#include <ncbi_pch.hpp>
+#include <util/thread_pool.hpp>
+#include <util/sync_queue.hpp>
+
+#include <corelib/ncbi_system.hpp>
+#include <corelib/ncbiapp.hpp>
+#include <corelib/ncbiargs.hpp>
+#include <corelib/ncbitime.hpp>
+
+#include <common/test_assert.h>  // This header must go last
+
+
+USING_NCBI_SCOPE;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Tasks
+
+// Counts executed tasks and signals when all of them are done
+class CTaskCounter
+{
+public:
+    CTaskCounter(void) : m_Done(0, 1) { m_Count.Set(0); m_Total = 0; }
+
+    void Reset(int total) { m_Count.Set(0); m_Total = total; }
+    void TaskDone(void)
+    {
+        if (m_Count.Add(1) == m_Total) {
+            m_Done.Post();
+        }
+    }
+    void Wait(void) { m_Done.Wait(); }
+    int  GetCount(void) const { return (int) m_Count.Get(); }
+
+private:
+    CAtomicCounter m_Count;
+    CAtomicCounter::TValue m_Total;
+    CSemaphore     m_Done;
+};
+
+
+// Small amount of work
+static volatile unsigned int s_Sink;
+
+static void s_Work(int iterations)
+{
+    unsigned int x = 1;
+    for (int i = 0;  i < iterations;  ++i) {
+        x = x * 1103515245 + 12345;
+    }
+    s_Sink = x;
+}
+
+
+class CSmallTask : public CThreadPool_Task
+{
+public:
+    CSmallTask(CTaskCounter& counter, int work, int children = 0,
+               unsigned int priority = 0)
+        : CThreadPool_Task(priority),
+          m_Counter(counter), m_Work(work), m_Children(children)
+    {}
+
+    virtual EStatus Execute(void)
+    {
+        // Spawn subtasks, like splitting a job into work units
+        for (int i = 0;  i < m_Children;  ++i) {
+            GetPool()->AddTask(new CSmallTask(m_Counter, m_Work));
+        }
+        s_Work(m_Work);
+        m_Counter.TaskDone();
+        return eCompleted;
+    }
+
+private:
+    CTaskCounter& m_Counter;
+    int           m_Work;
+    int           m_Children;
+};
+
+
+// Records the order of execution
+class COrderTask : public CThreadPool_Task
+{
+public:
+    COrderTask(vector<unsigned int>& order, CFastMutex& mutex,
+               unsigned int priority)
+        : CThreadPool_Task(priority), m_Order(order), m_Mutex(mutex)
+    {}
+
+    virtual EStatus Execute(void)
+    {
+        CFastMutexGuard guard(m_Mutex);
+        m_Order.push_back(GetPriority());
+        return eCompleted;
+    }
+
+private:
+    vector<unsigned int>& m_Order;
+    CFastMutex&           m_Mutex;
+};
+
+
+// Blocks the thread until released
+class CBlockingTask : public CThreadPool_Task
+{
+public:
+    CBlockingTask(void) : m_Started(0, 1), m_Release(0, 1) {}
+
+    virtual EStatus Execute(void)
+    {
+        m_Started.Post();
+        m_Release.Wait();
+        return eCompleted;
+    }
+
+    CSemaphore m_Started;
+    CSemaphore m_Release;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  Test application
+
+class CThreadPoolScalingApp : public CNcbiApplication
+{
+public:
+    void Init(void);
+    int  Run(void);
+
+private:
+    void x_TestScheduling(CThreadPool::EScheduling scheduling);
+
+    // Run 'tasks' small tasks (with 'children' subtasks each) in the pool,
+    // return thousands of tasks per second.
+    double x_Benchmark(CThreadPool::EScheduling scheduling,
+                       unsigned int threads, int tasks, int children);
+
+    int m_Work;
+};
+
+
+void CThreadPoolScalingApp::Init(void)
+{
+    unique_ptr<CArgDescriptions> d(new CArgDescriptions);
+    d->SetUsageContext(GetArguments().GetProgramBasename(),
+                       "CThreadPool scheduling test and benchmark");
+    d->AddDefaultKey("threads", "Threads", "Max number of threads",
+                     CArgDescriptions::eInteger, "16");
+    d->AddDefaultKey("tasks", "Tasks", "Number of tasks in each run",
+                     CArgDescriptions::eInteger, "20000");
+    d->AddDefaultKey("work", "Work", "Amount of work in each task",
+                     CArgDescriptions::eInteger, "200");
+    SetupArgDescriptions(d.release());
+}
+
+
+void CThreadPoolScalingApp::x_TestScheduling(
+    CThreadPool::EScheduling scheduling)
+{
+    // Priorities: with one thread tasks run in the order of priorities
+    {{
+        CThreadPool pool(100, 1, 1, CThread::fRunDefault, scheduling);
+        assert(pool.GetScheduling() == scheduling);
+        CRef<CBlockingTask> blocker(new CBlockingTask);
+        pool.AddTask(blocker);
+        blocker->m_Started.Wait();
+
+        vector<unsigned int> order;
+        CFastMutex mutex;
+        unsigned int priorities[] = { 5, 3, 9, 0, 3, 7, 1 };
+        for (size_t i = 0;  i < ArraySize(priorities);  ++i) {
+            pool.AddTask(new COrderTask(order, mutex, priorities[i]));
+        }
+        assert(pool.GetQueuedTasksCount() == ArraySize(priorities));
+
+        // Cancel a queued task
+        CRef<COrderTask> canceled(new COrderTask(order, mutex, 4));
+        pool.AddTask(canceled);
+        pool.CancelTask(canceled);
+        assert(canceled->GetStatus() == CThreadPool_Task::eCanceled);
+        assert(pool.GetQueuedTasksCount() == ArraySize(priorities));
+
+        blocker->m_Release.Post();
+        for (;;) {
+            {{
+                CFastMutexGuard guard(mutex);
+                if (order.size() == ArraySize(priorities)) {
+                    break;
+                }
+            }}
+            SleepMilliSec(1);
+        }
+        for (size_t i = 1;  i < order.size();  ++i) {
+            assert(order[i - 1] <= order[i]);
+        }
+    }}
+
+    // Queue size limit and cancellation of all queued tasks
+    {{
+        CThreadPool pool(4, 1, 1, CThread::fRunDefault, scheduling);
+        CRef<CBlockingTask> blocker(new CBlockingTask);
+        pool.AddTask(blocker);
+        blocker->m_Started.Wait();
+
+        CTaskCounter counter;
+        vector< CRef<CThreadPool_Task> > tasks;
+        for (int i = 0;  i < 4;  ++i) {
+            tasks.push_back(Ref<CThreadPool_Task>(new CSmallTask(counter, 1)));
+            pool.AddTask(tasks.back());
+        }
+        CTimeSpan timeout(0, 10 * 1000 * 1000);
+        try {
+            pool.AddTask(new CSmallTask(counter, 1), &timeout);
+            assert(false);
+        }
+        catch (CSyncQueueException& ex) {
+            assert(ex.GetErrCode() == CSyncQueueException::eNoRoom);
+        }
+        pool.CancelTasks(CThreadPool::fCancelQueuedTasks);
+        assert(pool.GetQueuedTasksCount() == 0);
+        ITERATE(vector< CRef<CThreadPool_Task> >, it, tasks) {
+            assert((*it)->GetStatus() == CThreadPool_Task::eCanceled);
+        }
+        // The queue has room again
+        pool.AddTask(new CSmallTask(counter, 1), &timeout);
+        blocker->m_Release.Post();
+    }}
+
+    // All tasks, including ones added from pooled threads, are executed
+    // exactly once; the controller starts more threads as needed.
+    {{
+        CThreadPool pool(100000, 8, 1, CThread::fRunDefault, scheduling);
+        CTaskCounter counter;
+        counter.Reset(100 + 100 * 50);
+        for (int i = 0;  i < 100;  ++i) {
+            pool.AddTask(new CSmallTask(counter, 100, 50));
+        }
+        counter.Wait();
+        assert(counter.GetCount() == 100 + 100 * 50);
+    }}
+
+    // Exclusive task waits for all queued tasks
+    {{
+        CThreadPool pool(1000, 4, 2, CThread::fRunDefault, scheduling);
+        CTaskCounter counter;
+        counter.Reset(500);
+        for (int i = 0;  i < 500;  ++i) {
+            pool.AddTask(new CSmallTask(counter, 1000));
+        }
+        CRef<CBlockingTask> exclusive(new CBlockingTask);
+        pool.RequestExclusiveExecution(exclusive,
+                                       CThreadPool::fExecuteQueuedTasks);
+        exclusive->m_Started.Wait();
+        assert(counter.GetCount() == 500);
+        exclusive->m_Release.Post();
+    }}
+}
+
+
+double CThreadPoolScalingApp::x_Benchmark(CThreadPool::EScheduling scheduling,
+                                          unsigned int threads,
+                                          int tasks, int children)
+{
+    CThreadPool pool(tasks + 1, threads, threads, CThread::fRunDefault,
+                     scheduling);
+    CTaskCounter counter;
+    int roots = tasks / (children + 1);
+    counter.Reset(roots * (children + 1));
+
+    CStopWatch sw(CStopWatch::eStart);
+    for (int i = 0;  i < roots;  ++i) {
+        pool.AddTask(new CSmallTask(counter, m_Work, children));
+    }
+    counter.Wait();
+    double elapsed = sw.Elapsed();
+    return elapsed > 0 ? roots * (children + 1) / elapsed / 1000 : 0;
+}
+
+
+int CThreadPoolScalingApp::Run(void)
+{
+    const CArgs& args = GetArgs();
+    unsigned int max_threads = (unsigned int) args["threads"].AsInteger();
+    int tasks = args["tasks"].AsInteger();
+    m_Work = args["work"].AsInteger();
+
+    x_TestScheduling(CThreadPool::eGlobalQueue);
+    x_TestScheduling(CThreadPool::eWorkStealing);
+
+    struct {
+        const char* name;
+        int         children;
+    } workloads[] = {
+        { "tasks added by one thread", 0 },
+        { "tasks spawning 99 subtasks each", 99 }
+    };
+    for (size_t w = 0;  w < ArraySize(workloads);  ++w) {
+        NcbiCout << NcbiEndl << "Thousands of " << workloads[w].name
+                 << " per second" << NcbiEndl
+                 << setw(16) << left << "threads:";
+        for (unsigned int t = 1;  t <= max_threads;  t *= 2) {
+            NcbiCout << setw(9) << right << t;
+        }
+        NcbiCout << NcbiEndl;
+        for (int mode = 0;  mode < 2;  ++mode) {
+            CThreadPool::EScheduling scheduling = mode == 0
+                ? CThreadPool::eGlobalQueue : CThreadPool::eWorkStealing;
+            NcbiCout << setw(16) << left
+                     << (mode == 0 ? "global queue" : "work stealing");
+            for (unsigned int t = 1;  t <= max_threads;  t *= 2) {
+                NcbiCout << setw(9) << right
+                         << (Uint8) x_Benchmark(scheduling, t, tasks,
+                                                workloads[w].children)
+                         << flush;
+            }
+            NcbiCout << NcbiEndl;
+        }
+    }
+
+    NcbiCout << "Test completed successfully!" << NcbiEndl;
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//  MAIN
+
+int main(int argc, const char* argv[])
+{
+    return CThreadPoolScalingApp().AppMain(argc, argv);
+}
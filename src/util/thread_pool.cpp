@@ -54,6 +54,91 @@ struct SThreadPool_TaskCompare {
 };
 
 
+/// Queue of tasks for the work-stealing mode of the pool.
+/// It consists of several priority queues (one per thread, or shared by
+/// several threads if there are more threads than queues), each protected
+/// by its own mutex. Threads take tasks from their own queue and steal
+/// them from other queues only when their own one is empty.
+class CThreadPool_StealingQueue
+{
+public:
+    /// Constructor
+    /// @param queues_count
+    ///   Number of per-thread queues
+    /// @param max_size
+    ///   Maximum total number of tasks in all queues
+    CThreadPool_StealingQueue(unsigned int queues_count,
+                              unsigned int max_size);
+
+    /// Get index of the queue for the new thread
+    unsigned int GetQueueForThread(void);
+
+    /// Get index of the queue for the task added by non-pooled thread
+    unsigned int GetQueueForTask(void);
+
+    /// Add task to the given queue waiting for available space if
+    /// necessary.
+    /// @param timeout
+    ///   Maximum time to wait for available space. If NULL then wait
+    ///   indefinitely.
+    void Push(const CRef<CThreadPool_Task>& task,
+              unsigned int                  queue_index,
+              const CTimeSpan*              timeout);
+
+    /// Get next task from the given queue or steal it from another one.
+    /// If all queues are empty then return NULL.
+    CRef<CThreadPool_Task> TryPop(unsigned int queue_index);
+
+    /// Delete task from the queue
+    /// If task does not exist in queue then does nothing.
+    void Remove(const CThreadPool_Task* task);
+
+    /// Request cancellation of all queued tasks and remove them
+    void CancelAll(void);
+
+    /// Get total number of tasks in all queues
+    unsigned int GetSize(void) const;
+
+private:
+    /// Type of the per-thread queue
+    typedef multiset< CRef<CThreadPool_Task>,
+                      SThreadPool_TaskCompare >  TTasks;
+
+    /// Per-thread queue
+    struct SQueue {
+        /// Mutex guarding the queue
+        CFastMutex      mutex;
+        /// Tasks ordered by priority
+        TTasks          tasks;
+        /// Number of tasks, checked without locking the mutex
+        CAtomicCounter  size;
+    };
+
+    /// Take the task from the queue which is already locked.
+    CRef<CThreadPool_Task> x_Pop(SQueue& queue);
+
+    /// Prohibit copying and assigning
+    CThreadPool_StealingQueue(const CThreadPool_StealingQueue&);
+    CThreadPool_StealingQueue& operator= (const CThreadPool_StealingQueue&);
+
+    /// Per-thread queues
+    vector< unique_ptr<SQueue> >  m_Queues;
+    /// Maximum total number of tasks
+    unsigned int                  m_MaxSize;
+    /// Total number of tasks
+    CAtomicCounter                m_Size;
+    /// Counter for distributing threads between queues
+    CAtomicCounter                m_NextThreadQueue;
+    /// Counter for distributing tasks between queues
+    CAtomicCounter                m_NextTaskQueue;
+    /// Number of threads waiting for available space
+    CAtomicCounter                m_RoomWaiters;
+    /// Semaphore for waiting for available space
+    CSemaphore                    m_RoomWait;
+};
+
+
+
 /// Real implementation of all ThreadPool functions
 class CThreadPool_Impl : public CObject
 {
@@ -90,7 +175,9 @@ public:
                      unsigned int      queue_size,
                      unsigned int      max_threads,
                      unsigned int      min_threads,
-                     CThread::TRunMode threads_mode = CThread::fRunDefault);
+                     CThread::TRunMode threads_mode = CThread::fRunDefault,
+                     CThreadPool::EScheduling scheduling
+                                                   = CThreadPool::eGlobalQueue);
 
     /// Constructor with explicitly given controller
     /// @param pool_intf
@@ -100,7 +187,9 @@ public:
     CThreadPool_Impl(CThreadPool*        pool_intf,
                      unsigned int        queue_size,
                      CThreadPool_Controller* controller,
-                     CThread::TRunMode   threads_mode = CThread::fRunDefault);
+                     CThread::TRunMode   threads_mode = CThread::fRunDefault,
+                     CThreadPool::EScheduling scheduling
+                                                   = CThreadPool::eGlobalQueue);
 
     /// Get pointer to ThreadPool interface object
     CThreadPool* GetPoolInterface(void) const;
@@ -178,7 +267,15 @@ public:
 
     /// Get next task from queue if there is one
     /// If the queue is empty then return NULL.
-    CRef<CThreadPool_Task> TryGetNextTask(void);
+    /// @param thread
+    ///   Thread asking for the task
+    CRef<CThreadPool_Task> TryGetNextTask(CThreadPool_ThreadImpl* thread);
+
+    /// Get index of the queue for the new thread in work-stealing mode
+    unsigned int GetThreadQueueIndex(void);
+
+    /// Get the scheduling mode of the pool
+    CThreadPool::EScheduling GetScheduling(void) const;
 
     /// Callback from thread when it is starting to execute task
     void TaskStarting(void);
@@ -276,9 +373,10 @@ private:
     ///   ThreadPool interface object attached to this implementation
     /// @param controller
     ///   Controller for the pool
-    void x_Init(CThreadPool*            pool_intf,
-                CThreadPool_Controller* controller,
-                CThread::TRunMode       threads_mode);
+    void x_Init(CThreadPool*             pool_intf,
+                CThreadPool_Controller*  controller,
+                CThread::TRunMode        threads_mode,
+                CThreadPool::EScheduling scheduling);
 
     /// Destructor. Will be called from CRef
     ~CThreadPool_Impl(void);
@@ -338,6 +436,9 @@ private:
     CTimeSpan                        m_DestroyTimeout;
     /// Queue for storing tasks
     TQueue                           m_Queue;
+    /// Queues for storing tasks in work-stealing mode (m_Queue is not used
+    /// in this mode)
+    unique_ptr<CThreadPool_StealingQueue> m_StealingQueue;
     /// Mutex for guarding all changes in the pool, its threads and controller
     CMutex                           m_MainPoolMutex;
     /// Semaphore for waiting for available threads to process task when
@@ -349,6 +450,8 @@ private:
     TThreadsList                     m_IdleThreads;
     /// List of all threads currently executing some tasks
     TThreadsList                     m_WorkingThreads;
+    /// Number of idle threads, can be checked without locking main mutex
+    CAtomicCounter                   m_IdleThreadsCount;
     /// Running mode of all threads
     CThread::TRunMode                m_ThreadsMode;
     /// Total number of threads
@@ -462,6 +565,16 @@ public:
     /// @sa CThreadPool_Thread::OnExit()
     void OnExit(void);
 
+    /// Get pool implementation running the thread
+    CThreadPool_Impl* GetPoolImpl(void) const;
+
+    /// Get index of the thread's own queue in work-stealing mode
+    unsigned int GetQueueIndex(void) const;
+
+    /// Get the pooled thread running the code, NULL if the current thread
+    /// does not belong to any pool.
+    static CThreadPool_ThreadImpl* GetCurrent(void);
+
 private:
     /// Prohibit copying and assigning
     CThreadPool_ThreadImpl(const CThreadPool_ThreadImpl&);
@@ -493,6 +606,8 @@ private:
     bool                         m_IsIdle;
     /// Task currently executing in the thread
     CRef<CThreadPool_Task>       m_CurrentTask;
+    /// Index of the thread's own queue in work-stealing mode
+    unsigned int                 m_QueueIndex;
     /// Semaphore for waking up from idle waiting
     CSemaphore                   m_IdleTrigger;
     /// General-use mutex for very (very!) trivial ops
@@ -698,6 +813,160 @@ CThreadPool_Impl::sx_RequestToCancel(CThreadPool_Task* task)
     task->x_RequestToCancel();
 }
 
+
+
+CThreadPool_StealingQueue::CThreadPool_StealingQueue(unsigned int queues_count,
+                                                     unsigned int max_size)
+    : m_MaxSize(max_size),
+      m_RoomWait(0, kMax_Int)
+{
+    _ASSERT(queues_count > 0);
+
+    m_Queues.resize(queues_count);
+    NON_CONST_ITERATE(vector< unique_ptr<SQueue> >, it, m_Queues) {
+        it->reset(new SQueue);
+        (*it)->size.Set(0);
+    }
+    m_Size.Set(0);
+    m_NextThreadQueue.Set(0);
+    m_NextTaskQueue.Set(0);
+    m_RoomWaiters.Set(0);
+}
+
+inline unsigned int
+CThreadPool_StealingQueue::GetQueueForThread(void)
+{
+    return (unsigned int)
+        ((m_NextThreadQueue.Add(1) - 1) % m_Queues.size());
+}
+
+inline unsigned int
+CThreadPool_StealingQueue::GetQueueForTask(void)
+{
+    return (unsigned int)
+        ((m_NextTaskQueue.Add(1) - 1) % m_Queues.size());
+}
+
+inline unsigned int
+CThreadPool_StealingQueue::GetSize(void) const
+{
+    return (unsigned int) m_Size.Get();
+}
+
+void
+CThreadPool_StealingQueue::Push(const CRef<CThreadPool_Task>& task,
+                                unsigned int                  queue_index,
+                                const CTimeSpan*              timeout)
+{
+    // Reserve the place first, then wait for it if the limit is exceeded
+    CStopWatch timer;
+    while ((unsigned int) m_Size.Add(1) > m_MaxSize) {
+        m_Size.Add(-1);
+        m_RoomWaiters.Add(1);
+        bool has_room = GetSize() < m_MaxSize;
+        if ( !has_room ) {
+            if (timeout) {
+                if ( !timer.IsRunning() ) {
+                    timer.Start();
+                }
+                CTimeSpan next_tm(timeout->GetAsDouble() - timer.Elapsed());
+                has_room = next_tm.GetSign() != eNegative
+                           &&  m_RoomWait.TryWait(CTimeout(next_tm));
+            }
+            else {
+                m_RoomWait.Wait();
+                has_room = true;
+            }
+        }
+        m_RoomWaiters.Add(-1);
+        if ( !has_room ) {
+            ThrowSyncQueueNoRoom();
+        }
+    }
+
+    SQueue& queue = *m_Queues[queue_index % m_Queues.size()];
+    CFastMutexGuard guard(queue.mutex);
+    queue.tasks.insert(task);
+    queue.size.Add(1);
+}
+
+inline CRef<CThreadPool_Task>
+CThreadPool_StealingQueue::x_Pop(SQueue& queue)
+{
+    TTasks::iterator it = queue.tasks.begin();
+    CRef<CThreadPool_Task> task = *it;
+    queue.tasks.erase(it);
+    queue.size.Add(-1);
+    m_Size.Add(-1);
+    if (m_RoomWaiters.Get() != 0) {
+        m_RoomWait.Post();
+    }
+    return task;
+}
+
+CRef<CThreadPool_Task>
+CThreadPool_StealingQueue::TryPop(unsigned int queue_index)
+{
+    size_t count = m_Queues.size();
+    for (size_t i = 0;  i < count;  ++i) {
+        SQueue& queue = *m_Queues[(queue_index + i) % count];
+        if (queue.size.Get() == 0) {
+            continue;
+        }
+        CFastMutexGuard guard(queue.mutex);
+        if ( !queue.tasks.empty() ) {
+            return x_Pop(queue);
+        }
+    }
+    return CRef<CThreadPool_Task>();
+}
+
+void
+CThreadPool_StealingQueue::Remove(const CThreadPool_Task* task)
+{
+    NON_CONST_ITERATE(vector< unique_ptr<SQueue> >, q_it, m_Queues) {
+        SQueue& queue = **q_it;
+        if (queue.size.Get() == 0) {
+            continue;
+        }
+        CFastMutexGuard guard(queue.mutex);
+        NON_CONST_ITERATE(TTasks, it, queue.tasks) {
+            if (*it == task) {
+                queue.tasks.erase(it);
+                queue.size.Add(-1);
+                m_Size.Add(-1);
+                if (m_RoomWaiters.Get() != 0) {
+                    m_RoomWait.Post();
+                }
+                return;
+            }
+        }
+    }
+}
+
+void
+CThreadPool_StealingQueue::CancelAll(void)
+{
+    NON_CONST_ITERATE(vector< unique_ptr<SQueue> >, q_it, m_Queues) {
+        SQueue& queue = **q_it;
+        CFastMutexGuard guard(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        NON_CONST_ITERATE(TTasks, it, queue.tasks) {
+            CThreadPool_Impl::sx_RequestToCancel(it->GetNCPointer());
+        }
+        CAtomicCounter::TValue n = (CAtomicCounter::TValue) queue.tasks.size();
+        queue.tasks.clear();
+        queue.size.Add(-n);
+        m_Size.Add(-n);
+        if (m_RoomWaiters.Get() != 0) {
+            m_RoomWait.Post();
+        }
+    }
+}
+
+
 inline CThreadPool*
 CThreadPool_Impl::GetPoolInterface(void) const
 {
@@ -731,9 +1000,28 @@ CThreadPool_Impl::GetThreadsCount(void) const
 inline unsigned int
 CThreadPool_Impl::GetQueuedTasksCount(void) const
 {
+    if (m_StealingQueue.get()) {
+        return m_StealingQueue->GetSize();
+    }
     return (unsigned int)m_Queue.GetSize();
 }
 
+inline CThreadPool::EScheduling
+CThreadPool_Impl::GetScheduling(void) const
+{
+    return m_StealingQueue.get() ? CThreadPool::eWorkStealing
+                                 : CThreadPool::eGlobalQueue;
+}
+
+inline unsigned int
+CThreadPool_Impl::GetThreadQueueIndex(void)
+{
+    if (m_StealingQueue.get()) {
+        return m_StealingQueue->GetQueueForThread();
+    }
+    return 0;
+}
+
 inline unsigned int
 CThreadPool_Impl::GetExecutingTasksCount(void) const
 {
@@ -822,6 +1110,7 @@ CThreadPool_Impl::ThreadStopped(CThreadPool_ThreadImpl* thread)
 
     m_IdleThreads.erase(thread);
     m_WorkingThreads.erase(thread);
+    m_IdleThreadsCount.Set((CAtomicCounter::TValue) m_IdleThreads.size());
 
     CallControllerOther();
 
@@ -829,8 +1118,11 @@ CThreadPool_Impl::ThreadStopped(CThreadPool_ThreadImpl* thread)
 }
 
 inline CRef<CThreadPool_Task>
-CThreadPool_Impl::TryGetNextTask(void)
+CThreadPool_Impl::TryGetNextTask(CThreadPool_ThreadImpl* thread)
 {
+    if ( !m_Suspended  &&  m_StealingQueue.get() ) {
+        return m_StealingQueue->TryPop(thread->GetQueueIndex());
+    }
     if ( !m_Suspended ) {
         TQueue::TAccessGuard guard(m_Queue);
 
@@ -1207,6 +1499,7 @@ CThreadPool_ThreadImpl::CThreadPool_ThreadImpl
     m_Finishing(false),
     m_CancelRequested(false),
     m_IsIdle(true),
+    m_QueueIndex(pool->GetThreadQueueIndex()),
     m_IdleTrigger(0, kMax_Int)
 {}
 
@@ -1226,6 +1519,18 @@ CThreadPool_ThreadImpl::IsFinishing(void) const
     return m_Finishing;
 }
 
+inline CThreadPool_Impl*
+CThreadPool_ThreadImpl::GetPoolImpl(void) const
+{
+    return m_Pool.GetNCPointer();
+}
+
+inline unsigned int
+CThreadPool_ThreadImpl::GetQueueIndex(void) const
+{
+    return m_QueueIndex;
+}
+
 inline CRef<CThreadPool_Task>
 CThreadPool_ThreadImpl::GetCurrentTask(void) const
 {
@@ -1292,9 +1597,19 @@ CThreadPool_ThreadImpl::CancelCurrentTask(void)
     }
 }
 
+/// Pooled thread running the code
+static DECLARE_TLS_VAR(CThreadPool_ThreadImpl*, s_CurrentPoolThread);
+
+inline CThreadPool_ThreadImpl*
+CThreadPool_ThreadImpl::GetCurrent(void)
+{
+    return s_CurrentPoolThread;
+}
+
 inline void
 CThreadPool_ThreadImpl::Main(void)
 {
+    s_CurrentPoolThread = this;
     m_Interface->Initialize();
 
     while (!m_Finishing) {
@@ -1307,7 +1622,7 @@ CThreadPool_ThreadImpl::Main(void)
         m_CancelRequested = false;
 
         {{
-            CRef<CThreadPool_Task> task = m_Pool->TryGetNextTask();
+            CRef<CThreadPool_Task> task = m_Pool->TryGetNextTask(this);
             CFastMutexGuard fast_guard(m_FastMutex);
             m_CurrentTask = task;
         }}
@@ -1374,6 +1689,7 @@ CThreadPool_ThreadImpl::OnExit(void)
         m_Interface->Finalize();
     } STD_CATCH_ALL_X(8, "Finalize")
 
+    s_CurrentPoolThread = NULL;
     m_Pool->ThreadStopped(this);
 }
 
@@ -1406,37 +1722,41 @@ CThreadPool_Impl::CThreadPool_Impl(CThreadPool*      pool_intf,
                                    unsigned int      queue_size,
                                    unsigned int      max_threads,
                                    unsigned int      min_threads,
-                                   CThread::TRunMode threads_mode)
+                                   CThread::TRunMode threads_mode,
+                                   CThreadPool::EScheduling scheduling)
     : m_Queue(x_GetQueueSize(queue_size)),
       m_RoomWait(0, kMax_Int),
       m_AbortWait(0, kMax_Int)
 {
     x_Init(pool_intf,
            new CThreadPool_Controller_PID(max_threads, min_threads),
-           threads_mode);
+           threads_mode, scheduling);
 }
 
 inline
 CThreadPool_Impl::CThreadPool_Impl(CThreadPool*            pool_intf,
                                    unsigned int            queue_size,
                                    CThreadPool_Controller* controller,
-                                   CThread::TRunMode       threads_mode)
+                                   CThread::TRunMode       threads_mode,
+                                   CThreadPool::EScheduling scheduling)
     : m_Queue(x_GetQueueSize(queue_size)),
       m_RoomWait(0, kMax_Int),
       m_AbortWait(0, kMax_Int)
 {
-    x_Init(pool_intf, controller, threads_mode);
+    x_Init(pool_intf, controller, threads_mode, scheduling);
 }
 
 void
 CThreadPool_Impl::x_Init(CThreadPool*             pool_intf,
                          CThreadPool_Controller*  controller,
-                         CThread::TRunMode        threads_mode)
+                         CThread::TRunMode        threads_mode,
+                         CThreadPool::EScheduling scheduling)
 {
     m_Interface = pool_intf;
     m_SelfRef = this;
     m_DestroyTimeout = CTimeSpan(10, 0);
     m_ThreadsCount.Set(0);
+    m_IdleThreadsCount.Set(0);
     m_ExecutingTasks.Set(0);
     m_TotalTasks.Set(0);
     m_Aborted = false;
@@ -1445,6 +1765,14 @@ CThreadPool_Impl::x_Init(CThreadPool*             pool_intf,
     m_ThreadsMode = (threads_mode | CThread::fRunDetached)
                      & ~CThread::fRunAllowST;
 
+    if (scheduling == CThreadPool::eWorkStealing) {
+        // One queue per thread; if the controller allows more threads
+        // later, some queues will be shared.
+        unsigned int queues = min(max(controller->GetMaxThreads(), 1u), 256u);
+        m_StealingQueue.reset(new CThreadPool_StealingQueue(
+                                  queues, (unsigned int) m_Queue.GetMaxSize()));
+    }
+
     controller->x_AttachToPool(this);
     m_Controller = controller;
 
@@ -1490,6 +1818,7 @@ CThreadPool_Impl::LaunchThreads(unsigned int count)
         CRef<CThreadPool_Thread> thread(m_Interface->CreateThread());
         m_IdleThreads.insert(
                         CThreadPool_ThreadImpl::s_GetImplPointer(thread));
+        m_IdleThreadsCount.Set((CAtomicCounter::TValue) m_IdleThreads.size());
         thread->Run(m_ThreadsMode);
     }
 
@@ -1539,9 +1868,15 @@ CThreadPool_Impl::SetThreadIdle(CThreadPool_ThreadImpl* thread, bool is_idle)
 {
     CThreadPool_Guard guard(this);
 
-    if (is_idle  &&  !m_Suspended  &&  m_Queue.GetSize() != 0) {
-        thread->WakeUp();
-        return false;
+    if (is_idle) {
+        // Count the thread as idle before checking the queue, so that
+        // AddTask() either sees it idle or the thread sees the new task.
+        m_IdleThreadsCount.Add(1);
+        if ( !m_Suspended  &&  GetQueuedTasksCount() != 0) {
+            m_IdleThreadsCount.Add(-1);
+            thread->WakeUp();
+            return false;
+        }
     }
 
     TThreadsList* to_del;
@@ -1560,6 +1895,7 @@ CThreadPool_Impl::SetThreadIdle(CThreadPool_ThreadImpl* thread, bool is_idle)
         to_del->erase(it);
     }
     to_ins->insert(thread);
+    m_IdleThreadsCount.Set((CAtomicCounter::TValue) m_IdleThreads.size());
 
     if (is_idle  &&  m_Suspended
         &&  (m_SuspendFlags & CThreadPool::fFlushThreads))
@@ -1691,7 +2027,19 @@ CThreadPool_Impl::AddTask(CThreadPool_Task* task, const CTimeSpan* timeout)
     try {
         // Pushing to queue must be out of mutex to be able to wait
         // for available space.
-        m_Queue.Push(Ref(task), timeout);
+        if (m_StealingQueue.get()) {
+            // Tasks added by pooled threads go to their own queues
+            CThreadPool_ThreadImpl* thread =
+                                        CThreadPool_ThreadImpl::GetCurrent();
+            unsigned int queue_index =
+                thread  &&  thread->GetPoolImpl() == this
+                ? thread->GetQueueIndex()
+                : m_StealingQueue->GetQueueForTask();
+            m_StealingQueue->Push(task_ref, queue_index, timeout);
+        }
+        else {
+            m_Queue.Push(Ref(task), timeout);
+        }
     }
     catch (...) {
         task->x_SetStatus(CThreadPool_Task::eIdle);
@@ -1699,6 +2047,16 @@ CThreadPool_Impl::AddTask(CThreadPool_Task* task, const CTimeSpan* timeout)
         throw;
     }
 
+    if (m_StealingQueue.get()  &&  m_IsQueueAllowed
+        &&  m_IdleThreadsCount.Get() == 0  &&  !m_Aborted  &&  !m_Suspended)
+    {
+        // All threads are busy and will pick up the task when they finish
+        // their current ones -- there is no need to lock the main mutex.
+        m_TotalTasks.Add(1);
+        CallControllerOther();
+        return;
+    }
+
     if (m_IsQueueAllowed) {
         guard.Guard();
     }
@@ -1711,7 +2069,7 @@ CThreadPool_Impl::AddTask(CThreadPool_Task* task, const CTimeSpan* timeout)
     if (m_Aborted  ||  (m_Suspended
                         &&  (m_SuspendFlags & check_flags)  == check_flags))
     {
-        if (m_Queue.GetSize() != 0) {
+        if (GetQueuedTasksCount() != 0) {
             x_CancelQueuedTasks();
         }
         return;
@@ -1741,6 +2099,11 @@ CThreadPool_Impl::AddTask(CThreadPool_Task* task, const CTimeSpan* timeout)
 inline void
 CThreadPool_Impl::x_RemoveTaskFromQueue(const CThreadPool_Task* task)
 {
+    if (m_StealingQueue.get()) {
+        m_StealingQueue->Remove(task);
+        return;
+    }
+
     TQueue::TAccessGuard q_guard(m_Queue);
 
     TQueue::TAccessGuard::TIterator it = q_guard.Begin();
@@ -1848,6 +2211,11 @@ CThreadPool_Impl::x_CancelExecutingTasks(void)
 void
 CThreadPool_Impl::x_CancelQueuedTasks(void)
 {
+    if (m_StealingQueue.get()) {
+        m_StealingQueue->CancelAll();
+        return;
+    }
+
     TQueue::TAccessGuard q_guard(m_Queue);
 
     for (TQueue::TAccessGuard::TIterator it = q_guard.Begin();
@@ -2160,18 +2528,21 @@ CThreadPool_Thread::OnExit(void)
 CThreadPool::CThreadPool(unsigned int      queue_size,
                          unsigned int      max_threads,
                          unsigned int      min_threads,
-                         CThread::TRunMode threads_mode)
+                         CThread::TRunMode threads_mode,
+                         EScheduling       scheduling)
 {
     m_Impl = new CThreadPool_Impl(this, queue_size, max_threads, min_threads,
-                                  threads_mode);
+                                  threads_mode, scheduling);
     m_Impl->SetInterfaceStarted();
 }
 
 CThreadPool::CThreadPool(unsigned int            queue_size,
                          CThreadPool_Controller* controller,
-                         CThread::TRunMode       threads_mode)
+                         CThread::TRunMode       threads_mode,
+                         EScheduling             scheduling)
 {
-    m_Impl = new CThreadPool_Impl(this, queue_size, controller, threads_mode);
+    m_Impl = new CThreadPool_Impl(this, queue_size, controller, threads_mode,
+                                  scheduling);
     m_Impl->SetInterfaceStarted();
 }
 
@@ -2265,6 +2636,12 @@ CThreadPool::GetExecutingTasksCount(void) const
     return m_Impl->GetExecutingTasksCount();
 }
 
+CThreadPool::EScheduling
+CThreadPool::GetScheduling(void) const
+{
+    return m_Impl->GetScheduling();
+}
+
 
 
 END_NCBI_SCOPE